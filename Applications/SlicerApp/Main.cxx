@@ -170,6 +170,7 @@ int SlicerAppMain(int argc, char* argv[])
              << moduleFactoryManager->registeredModuleNames().count();
     }
   splashMessage(splashScreen, "Instantiating modules...");
+  qSlicerApplicationHelper::loadCLIModuleDescriptions(moduleFactoryManager);
   moduleFactoryManager->instantiateModules();
   if (app.commandOptions()->verbose())
     {
@@ -0,0 +1,248 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkSlicerTask.h"
+
+// MRML includes
+#include <vtkMRMLAbstractLogic.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+// ITK includes
+#include <itkMutexLock.h>
+
+// ITKSYS includes
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct SleepingTask
+{
+  unsigned int Milliseconds;
+  int Index;
+};
+
+//----------------------------------------------------------------------------
+class vtkSlicerSleepingLogic : public vtkMRMLAbstractLogic
+{
+public:
+  static vtkSlicerSleepingLogic *New();
+  vtkTypeMacro(vtkSlicerSleepingLogic, vtkMRMLAbstractLogic);
+
+  void Sleep(void* clientData)
+  {
+    SleepingTask* task = reinterpret_cast<SleepingTask*>(clientData);
+    this->Lock.Lock();
+    this->StartedTasks.push_back(task->Index);
+    this->Lock.Unlock();
+    itksys::SystemTools::Delay(task->Milliseconds);
+  }
+
+  /// Index of the tasks in the order they started
+  std::vector<int> GetStartedTasks()
+  {
+    this->Lock.Lock();
+    std::vector<int> startedTasks = this->StartedTasks;
+    this->Lock.Unlock();
+    return startedTasks;
+  }
+
+protected:
+  vtkSlicerSleepingLogic() {}
+
+  itk::SimpleMutexLock Lock;
+  std::vector<int> StartedTasks;
+};
+vtkStandardNewMacro(vtkSlicerSleepingLogic);
+
+//----------------------------------------------------------------------------
+std::vector<SleepingTask> MakeTasks(int numberOfTasks, unsigned int milliseconds)
+{
+  std::vector<SleepingTask> tasks(numberOfTasks);
+  for (int i = 0; i < numberOfTasks; ++i)
+    {
+    tasks[i].Milliseconds = milliseconds;
+    tasks[i].Index = i;
+    }
+  return tasks;
+}
+
+//----------------------------------------------------------------------------
+bool ScheduleTasks(vtkSlicerApplicationLogic* appLogic,
+                   vtkSlicerSleepingLogic* logic,
+                   std::vector<SleepingTask>& tasks, int first, int numberOfTasks)
+{
+  for (int i = first; i < first + numberOfTasks; ++i)
+    {
+    vtkNew<vtkSlicerTask> task;
+    task->SetTypeToProcessing();
+    task->SetTaskFunction(logic, (vtkSlicerTask::TaskFunctionPointer)
+                          &vtkSlicerSleepingLogic::Sleep, &tasks[i]);
+    if (!appLogic->ScheduleTask(task.GetPointer()))
+      {
+      std::cerr << "Line " << __LINE__ << ": failed to schedule task" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool WaitForTasks(vtkSlicerApplicationLogic* appLogic, unsigned int numberOfTasks)
+{
+  // the timeout only prevents the test from hanging, it is not a measure
+  for (int i = 0; i < 6000 && appLogic->GetNumberOfCompletedTasks() < numberOfTasks; ++i)
+    {
+    itksys::SystemTools::Delay(10);
+    }
+  if (appLogic->GetNumberOfCompletedTasks() != numberOfTasks)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << appLogic->GetNumberOfCompletedTasks()
+              << " tasks completed instead of " << numberOfTasks << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool CheckStartedTasks(vtkSlicerSleepingLogic* logic, int numberOfTasks, bool inOrder)
+{
+  std::vector<int> startedTasks = logic->GetStartedTasks();
+  std::vector<int> sortedTasks = startedTasks;
+  std::sort(sortedTasks.begin(), sortedTasks.end());
+  bool ranOnce = static_cast<int>(sortedTasks.size()) == numberOfTasks;
+  for (int i = 0; ranOnce && i < numberOfTasks; ++i)
+    {
+    ranOnce = (sortedTasks[i] == i);
+    }
+  if (!ranOnce || (inOrder && startedTasks != sortedTasks))
+    {
+    std::cerr << "Line " << __LINE__ << ": tasks started in the wrong order:";
+    for (size_t i = 0; i < startedTasks.size(); ++i)
+      {
+      std::cerr << " " << startedTasks[i];
+      }
+    std::cerr << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//-----------------------------------------------------------------------------
+int vtkSlicerApplicationLogicTest2(int , char * [])
+{
+  const int numberOfTasks = 9;
+
+  // A single thread runs the tasks in the order they are scheduled
+  {
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  vtkNew<vtkSlicerSleepingLogic> logic;
+  std::vector<SleepingTask> tasks = MakeTasks(numberOfTasks, 10);
+  appLogic->SetNumberOfProcessingThreads(1);
+  appLogic->CreateProcessingThread();
+  if (!ScheduleTasks(appLogic.GetPointer(), logic.GetPointer(), tasks, 0, numberOfTasks) ||
+      !WaitForTasks(appLogic.GetPointer(), numberOfTasks) ||
+      !CheckStartedTasks(logic.GetPointer(), numberOfTasks, true))
+    {
+    return EXIT_FAILURE;
+    }
+  appLogic->TerminateProcessingThread();
+  }
+
+  std::vector<SleepingTask> tasks = MakeTasks(numberOfTasks, 200);
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  vtkNew<vtkSlicerSleepingLogic> logic;
+
+  // Tasks can't be scheduled before the threads are created
+  vtkNew<vtkSlicerTask> task;
+  task->SetTypeToProcessing();
+  task->SetTaskFunction(logic.GetPointer(), (vtkSlicerTask::TaskFunctionPointer)
+                        &vtkSlicerSleepingLogic::Sleep, &tasks[0]);
+  if (appLogic->ScheduleTask(task.GetPointer()))
+    {
+    std::cerr << "Line " << __LINE__ << ": task scheduled without thread" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  appLogic->SetNumberOfProcessingThreads(4);
+  appLogic->CreateProcessingThread();
+  if (appLogic->GetNumberOfProcessingThreads() != 4)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of threads: "
+              << appLogic->GetNumberOfProcessingThreads() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The times depend on the load of the machine, they are reported but not
+  // checked.
+  if (!ScheduleTasks(appLogic.GetPointer(), logic.GetPointer(), tasks, 0, 1) ||
+      !WaitForTasks(appLogic.GetPointer(), 1))
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "<DartMeasurement name=\"TaskWaitTime\" type=\"numeric/double\">"
+            << appLogic->GetTotalTaskWaitTime() << "</DartMeasurement>" << std::endl;
+
+  // 8 tasks run by 4 threads take about 2 task durations
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  if (!ScheduleTasks(appLogic.GetPointer(), logic.GetPointer(), tasks, 1, numberOfTasks - 1) ||
+      !WaitForTasks(appLogic.GetPointer(), numberOfTasks))
+    {
+    return EXIT_FAILURE;
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"MaximumTaskWaitTime\" type=\"numeric/double\">"
+            << appLogic->GetMaximumTaskWaitTime() << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"ConcurrentTasksTime\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"TotalTaskRunTime\" type=\"numeric/double\">"
+            << appLogic->GetTotalTaskRunTime() << "</DartMeasurement>" << std::endl;
+  // the threads dequeue the tasks in order but may start them in any order
+  if (!CheckStartedTasks(logic.GetPointer(), numberOfTasks, false))
+    {
+    return EXIT_FAILURE;
+    }
+  if (appLogic->GetTaskQueueSize() != 0 ||
+      appLogic->GetNumberOfRunningTasks() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong task metrics:\n"
+              << " queue size: " << appLogic->GetTaskQueueSize() << "\n"
+              << " running: " << appLogic->GetNumberOfRunningTasks() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Terminating must not wait for a task to be scheduled
+  timer->StartTimer();
+  appLogic->TerminateProcessingThread();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"TerminateTime\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -47,6 +47,7 @@
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
+#include <vtkTimerLog.h>
 
 // ITKSYS includes
 #include <itksys/SystemTools.hxx>
@@ -63,7 +64,18 @@
 #include <queue>
 
 //----------------------------------------------------------------------------
-class ProcessingTaskQueue : public std::queue<vtkSmartPointer<vtkSlicerTask> > {};
+class ScheduledTask
+{
+public:
+  ScheduledTask(vtkSlicerTask* task, double scheduledTime)
+    : Task(task), ScheduledTime(scheduledTime)
+  {
+  }
+  vtkSmartPointer<vtkSlicerTask> Task;
+  /// Universal time when the task was put in the queue
+  double ScheduledTime;
+};
+class ProcessingTaskQueue : public std::queue<ScheduledTask> {};
 class ModifiedQueue : public std::queue<vtkSmartPointer<vtkObject> > {};
 
 //----------------------------------------------------------------------------
@@ -213,10 +225,16 @@ vtkStandardNewMacro(vtkSlicerApplicationLogic);
 vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 {
   this->ProcessingThreader = itk::MultiThreader::New();
-  this->ProcessingThreadId = -1;
+  this->NumberOfProcessingThreads = 1;
   this->ProcessingThreadActive = false;
   this->ProcessingThreadActiveLock = itk::MutexLock::New();
-  this->ProcessingTaskQueueLock = itk::MutexLock::New();
+  this->ProcessingTaskQueueCondition = itk::ConditionVariable::New();
+  this->NetworkingTaskQueueCondition = itk::ConditionVariable::New();
+  this->NumberOfRunningTasks = 0;
+  this->NumberOfCompletedTasks = 0;
+  this->TotalTaskWaitTime = 0.;
+  this->MaximumTaskWaitTime = 0.;
+  this->TotalTaskRunTime = 0.;
 
   this->ModifiedQueueActive = false;
   this->ModifiedQueueActiveLock = itk::MutexLock::New();
@@ -231,6 +249,7 @@ vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
   this->WriteDataQueueLock = itk::MutexLock::New();
 
   this->InternalTaskQueue = new ProcessingTaskQueue;
+  this->InternalNetworkingTaskQueue = new ProcessingTaskQueue;
   this->InternalModifiedQueue = new ModifiedQueue;
 
   this->InternalReadDataQueue = new ReadDataQueue;
@@ -240,23 +259,12 @@ vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 //----------------------------------------------------------------------------
 vtkSlicerApplicationLogic::~vtkSlicerApplicationLogic()
 {
-  // Note that TerminateThread does not kill a thread, it only waits
-  // for the thread to finish.  We need to signal the thread that we
-  // want to terminate
-  if (this->ProcessingThreadId != -1 && this->ProcessingThreader)
-    {
-    // Signal the processingThread that we are terminating.
-    this->ProcessingThreadActiveLock->Lock();
-    this->ProcessingThreadActive = false;
-    this->ProcessingThreadActiveLock->Unlock();
-
-    // Wait for the thread to finish and clean up the state of the threader
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-
-    this->ProcessingThreadId = -1;
-    }
+  // Signal the processing threads that we are terminating and wait for
+  // them to finish.
+  this->TerminateProcessingThread();
 
   delete this->InternalTaskQueue;
+  delete this->InternalNetworkingTaskQueue;
 
   this->ModifiedQueueLock->Lock();
   while (!(*this->InternalModifiedQueue).empty())
@@ -298,19 +306,44 @@ void vtkSlicerApplicationLogic::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "SlicerApplicationLogic:             " << this->GetClassName() << "\n";
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::SetNumberOfProcessingThreads(int numberOfThreads)
+{
+  if (!this->ProcessingThreadIDs.empty())
+    {
+    vtkWarningMacro("SetNumberOfProcessingThreads: processing threads are "
+                    "already created, the number of threads is unchanged");
+    return;
+    }
+  numberOfThreads = std::max(1, std::min(numberOfThreads, ITK_MAX_THREADS - 1));
+  if (this->NumberOfProcessingThreads != numberOfThreads)
+    {
+    this->NumberOfProcessingThreads = numberOfThreads;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetNumberOfProcessingThreads()const
+{
+  return this->NumberOfProcessingThreads;
+}
+
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::CreateProcessingThread()
 {
-  if (this->ProcessingThreadId == -1)
+  if (this->ProcessingThreadIDs.empty())
     {
     this->ProcessingThreadActiveLock->Lock();
     this->ProcessingThreadActive = true;
     this->ProcessingThreadActiveLock->Unlock();
 
-    this->ProcessingThreadId
-      = this->ProcessingThreader
-      ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
-                    this);
+    for (int i = 0; i < this->NumberOfProcessingThreads; ++i)
+      {
+      this->ProcessingThreadIDs.push_back( this->ProcessingThreader
+        ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
+                      this) );
+      }
 
     // Start four network threads (TODO: make the number of threads a setting)
     this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
@@ -353,7 +386,7 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::TerminateProcessingThread()
 {
-  if (this->ProcessingThreadId != -1)
+  if (!this->ProcessingThreadIDs.empty())
     {
     std::cout << "vtkSlicerApplicationLogic::TerminateProcessingThread()" << std::endl;
     this->ModifiedQueueActiveLock->Lock();
@@ -372,10 +405,23 @@ void vtkSlicerApplicationLogic::TerminateProcessingThread()
     this->ProcessingThreadActive = false;
     this->ProcessingThreadActiveLock->Unlock();
 
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-    this->ProcessingThreadId = -1;
+    // Wake up the threads waiting for a task so that they can exit.
+    // Note that TerminateThread does not kill a thread, it only waits
+    // for the thread to finish.
+    this->ProcessingTaskQueueLock.Lock();
+    this->ProcessingTaskQueueCondition->Broadcast();
+    this->NetworkingTaskQueueCondition->Broadcast();
+    this->ProcessingTaskQueueLock.Unlock();
 
     std::vector<int>::const_iterator idIterator;
+    idIterator = this->ProcessingThreadIDs.begin();
+    while (idIterator != this->ProcessingThreadIDs.end())
+      {
+      this->ProcessingThreader->TerminateThread( *idIterator );
+      ++idIterator;
+      }
+    this->ProcessingThreadIDs.clear();
+
     idIterator = this->NetworkingThreadIDs.begin();
     while (idIterator != this->NetworkingThreadIDs.end())
       {
@@ -426,48 +472,8 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessProcessingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = 0;
-
-  while (active)
-    {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock->Lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock->Unlock();
-
-    if (active)
-      {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock->Lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-
-        // only handle processing tasks in this thread
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Processing )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = NULL;
-          }
-        }
-      this->ProcessingTaskQueueLock->Unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = 0;
-        }
-      }
-
-    // busy wait
-    itksys::SystemTools::Delay(100);
-    }
+  this->ProcessTasks(this->InternalTaskQueue,
+                     this->ProcessingTaskQueueCondition);
 }
 
 ITK_THREAD_RETURN_TYPE
@@ -508,46 +514,53 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessNetworkingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = 0;
+  this->ProcessTasks(this->InternalNetworkingTaskQueue,
+                     this->NetworkingTaskQueueCondition);
+}
 
-  while (active)
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::ProcessTasks(ProcessingTaskQueue* queue,
+                                             itk::ConditionVariable* condition)
+{
+  this->ProcessingTaskQueueLock.Lock();
+  while (true)
     {
     // Check to see if we should be shutting down
     this->ProcessingThreadActiveLock->Lock();
-    active = this->ProcessingThreadActive;
+    int active = this->ProcessingThreadActive;
     this->ProcessingThreadActiveLock->Unlock();
-
-    if (active)
+    if (!active)
       {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock->Lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Networking )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = NULL;
-          }
-        }
-      this->ProcessingTaskQueueLock->Unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = 0;
-        }
+      break;
+      }
+    if (queue->empty())
+      {
+      // sleep until a task is scheduled or the threads are terminated
+      condition->Wait(&this->ProcessingTaskQueueLock);
+      continue;
       }
 
-    // busy wait
-    itksys::SystemTools::Delay(100);
+    // pull a task off the queue
+    ScheduledTask scheduledTask = queue->front();
+    queue->pop();
+    ++this->NumberOfRunningTasks;
+    double startTime = vtkTimerLog::GetUniversalTime();
+    double waitTime = startTime - scheduledTask.ScheduledTime;
+    this->ProcessingTaskQueueLock.Unlock();
+
+    scheduledTask.Task->Execute();
+    double runTime = vtkTimerLog::GetUniversalTime() - startTime;
+    // release the task outside of the lock
+    scheduledTask.Task = 0;
+
+    this->ProcessingTaskQueueLock.Lock();
+    --this->NumberOfRunningTasks;
+    ++this->NumberOfCompletedTasks;
+    this->TotalTaskWaitTime += waitTime;
+    this->MaximumTaskWaitTime = std::max(this->MaximumTaskWaitTime, waitTime);
+    this->TotalTaskRunTime += runTime;
     }
+  this->ProcessingTaskQueueLock.Unlock();
 }
 
 //----------------------------------------------------------------------------
@@ -564,10 +577,20 @@ int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
 
   if (active)
     {
-    this->ProcessingTaskQueueLock->Lock();
-    (*this->InternalTaskQueue).push( task );
-    //std::cout << (*this->InternalTaskQueue).size() << std::endl;
-    this->ProcessingTaskQueueLock->Unlock();
+    ScheduledTask scheduledTask(task, vtkTimerLog::GetUniversalTime());
+    this->ProcessingTaskQueueLock.Lock();
+    // wake up one of the threads waiting for this type of task
+    if (task->GetType() == vtkSlicerTask::Networking)
+      {
+      (*this->InternalNetworkingTaskQueue).push( scheduledTask );
+      this->NetworkingTaskQueueCondition->Signal();
+      }
+    else
+      {
+      (*this->InternalTaskQueue).push( scheduledTask );
+      this->ProcessingTaskQueueCondition->Signal();
+      }
+    this->ProcessingTaskQueueLock.Unlock();
 
     return true;
     }
@@ -576,6 +599,61 @@ int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
   return false;
 }
 
+//----------------------------------------------------------------------------
+unsigned int vtkSlicerApplicationLogic::GetTaskQueueSize()
+{
+  this->ProcessingTaskQueueLock.Lock();
+  unsigned int size = static_cast<unsigned int>(
+    (*this->InternalTaskQueue).size() + (*this->InternalNetworkingTaskQueue).size());
+  this->ProcessingTaskQueueLock.Unlock();
+  return size;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkSlicerApplicationLogic::GetNumberOfRunningTasks()
+{
+  this->ProcessingTaskQueueLock.Lock();
+  unsigned int numberOfTasks = this->NumberOfRunningTasks;
+  this->ProcessingTaskQueueLock.Unlock();
+  return numberOfTasks;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkSlicerApplicationLogic::GetNumberOfCompletedTasks()
+{
+  this->ProcessingTaskQueueLock.Lock();
+  unsigned int numberOfTasks = this->NumberOfCompletedTasks;
+  this->ProcessingTaskQueueLock.Unlock();
+  return numberOfTasks;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerApplicationLogic::GetTotalTaskWaitTime()
+{
+  this->ProcessingTaskQueueLock.Lock();
+  double time = this->TotalTaskWaitTime;
+  this->ProcessingTaskQueueLock.Unlock();
+  return time;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerApplicationLogic::GetMaximumTaskWaitTime()
+{
+  this->ProcessingTaskQueueLock.Lock();
+  double time = this->MaximumTaskWaitTime;
+  this->ProcessingTaskQueueLock.Unlock();
+  return time;
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerApplicationLogic::GetTotalTaskRunTime()
+{
+  this->ProcessingTaskQueueLock.Lock();
+  double time = this->TotalTaskRunTime;
+  this->ProcessingTaskQueueLock.Unlock();
+  return time;
+}
+
 //----------------------------------------------------------------------------
 int vtkSlicerApplicationLogic::RequestModified( vtkObject *obj )
 {
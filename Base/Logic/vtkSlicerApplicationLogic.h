@@ -29,6 +29,7 @@
 #include <vtkSmartPointer.h>
 
 // ITK includes
+#include <itkConditionVariable.h>
 #include <itkMultiThreader.h>
 #include <itkMutexLock.h>
 
@@ -56,11 +57,19 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// (display it in the Fiducials GUI)
   void PropagateFiducialListSelection();
 
-  /// Create a thread for processing
+  /// Create the threads for processing
+  /// \sa SetNumberOfProcessingThreads()
   void CreateProcessingThread();
 
-  /// Shutdown the processing thread
+  /// Shutdown the processing threads
   void TerminateProcessingThread();
+
+  /// Number of threads running the processing tasks (e.g. CLIs), i.e. the
+  /// number of processing tasks that can run concurrently.
+  /// Must be set before CreateProcessingThread() is called.
+  /// 1 by default.
+  void SetNumberOfProcessingThreads(int numberOfThreads);
+  int GetNumberOfProcessingThreads()const;
   /// List of events potentially fired by the application logic
   enum RequestEvents
     {
@@ -79,6 +88,23 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// main thread to run something in the processing thread.
   int ScheduleTask( vtkSlicerTask* );
 
+  /// Return the number of scheduled tasks waiting for a thread.
+  unsigned int GetTaskQueueSize();
+
+  /// Return the number of tasks being executed.
+  unsigned int GetNumberOfRunningTasks();
+
+  /// Return the number of tasks that have been executed.
+  unsigned int GetNumberOfCompletedTasks();
+
+  /// Return the time (in seconds) the completed tasks spent in the queue
+  /// before a thread started to execute them. Total and maximum.
+  double GetTotalTaskWaitTime();
+  double GetMaximumTaskWaitTime();
+
+  /// Return the time (in seconds) spent executing the completed tasks.
+  double GetTotalTaskRunTime();
+
   /// Request a Modified call on an object.  This method allows a
   /// processing thread to request a Modified call on an object to be
   /// performed in the main thread.  This allows the call to Modified
@@ -194,6 +220,10 @@ protected:
   /// Networking Task processing loop that is run in a networking thread
   void ProcessNetworkingTasks();
 
+  /// Execute the tasks of \a queue until the threads are terminated.
+  /// The calling thread sleeps on \a condition while the queue is empty.
+  void ProcessTasks(ProcessingTaskQueue* queue, itk::ConditionVariable* condition);
+
   /// Process a request to read data into a node.  This method is
   /// called by ProcessReadData() in the application main thread
   /// because calls to load data will cause a Modified() on a node
@@ -214,7 +244,10 @@ private:
 
   itk::MultiThreader::Pointer ProcessingThreader;
   itk::MutexLock::Pointer ProcessingThreadActiveLock;
-  itk::MutexLock::Pointer ProcessingTaskQueueLock;
+  /// Lock protecting the task queues and the task metrics
+  itk::SimpleMutexLock ProcessingTaskQueueLock;
+  itk::ConditionVariable::Pointer ProcessingTaskQueueCondition;
+  itk::ConditionVariable::Pointer NetworkingTaskQueueCondition;
   itk::MutexLock::Pointer ModifiedQueueActiveLock;
   itk::MutexLock::Pointer ModifiedQueueLock;
   itk::MutexLock::Pointer ReadDataQueueActiveLock;
@@ -222,7 +255,8 @@ private:
   itk::MutexLock::Pointer WriteDataQueueActiveLock;
   itk::MutexLock::Pointer WriteDataQueueLock;
   vtkTimeStamp RequestTimeStamp;
-  int ProcessingThreadId;
+  int NumberOfProcessingThreads;
+  std::vector<int> ProcessingThreadIDs;
   std::vector<int> NetworkingThreadIDs;
   int ProcessingThreadActive;
   int ModifiedQueueActive;
@@ -230,6 +264,12 @@ private:
   int WriteDataQueueActive;
 
   ProcessingTaskQueue* InternalTaskQueue;
+  ProcessingTaskQueue* InternalNetworkingTaskQueue;
+  unsigned int NumberOfRunningTasks;
+  unsigned int NumberOfCompletedTasks;
+  double TotalTaskWaitTime;
+  double MaximumTaskWaitTime;
+  double TotalTaskRunTime;
   ModifiedQueue*       InternalModifiedQueue;
   ReadDataQueue*       InternalReadDataQueue;
   WriteDataQueue*      InternalWriteDataQueue;
@@ -21,6 +21,7 @@
 #include "qSlicerApplicationHelper.h"
 
 // Qt includes
+#include <QFileInfo>
 #include <QSettings>
 
 // Slicer includes
@@ -130,6 +131,11 @@ void qSlicerApplicationHelper::setupModuleFactoryManager(qSlicerModuleFactoryMan
 
     qSlicerCLIExecutableModuleFactory* cliExecutableFactory = new qSlicerCLIExecutableModuleFactory();
     cliExecutableFactory->setTempDirectory(tempDirectory);
+    // Cache the XML descriptions next to the revision specific settings so
+    // that executables are only run when they change.
+    cliExecutableFactory->setModuleDescriptionCacheFilePath(
+      QFileInfo(app->revisionUserSettings()->fileName()).absolutePath()
+      + "/CLIModuleDescriptionCache.ini");
     moduleFactoryManager->registerFactory(cliExecutableFactory, preferExecutableCLIs ? 1 : 0);
 
     if (!options->disableBuiltInModules() &&
@@ -156,6 +162,25 @@ void qSlicerApplicationHelper::setupModuleFactoryManager(qSlicerModuleFactoryMan
   moduleFactoryManager->setVerboseModuleDiscovery(app->commandOptions()->verboseModuleDiscovery());
 }
 
+//----------------------------------------------------------------------------
+void qSlicerApplicationHelper::loadCLIModuleDescriptions(qSlicerModuleFactoryManager * moduleFactoryManager)
+{
+#ifdef Slicer_BUILD_CLI_SUPPORT
+  foreach(qSlicerModuleFactoryManager::qSlicerModuleFactory* factory,
+          moduleFactoryManager->registeredFactories())
+    {
+    qSlicerCLIExecutableModuleFactory* cliExecutableFactory =
+      dynamic_cast<qSlicerCLIExecutableModuleFactory*>(factory);
+    if (cliExecutableFactory)
+      {
+      cliExecutableFactory->loadXmlModuleDescriptions();
+      }
+    }
+#else
+  Q_UNUSED(moduleFactoryManager);
+#endif
+}
+
 //----------------------------------------------------------------------------
 void qSlicerApplicationHelper::showMRMLEventLoggerWidget()
 {
@@ -41,6 +41,11 @@ public:
 
   static void setupModuleFactoryManager(qSlicerModuleFactoryManager * moduleFactoryManager);
 
+  /// Retrieve at once the XML descriptions of the registered CLI executables.
+  /// To be called between registerModules() and instantiateModules() so that
+  /// the time is not charged to the first instantiated CLI module.
+  static void loadCLIModuleDescriptions(qSlicerModuleFactoryManager * moduleFactoryManager);
+
   static void showMRMLEventLoggerWidget();
 
   static void initializePythonConsole(ctkPythonConsole* pythonConsole);
@@ -19,16 +19,72 @@
 ==============================================================================*/
 
 // QT includes
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
 
 // SlicerQt includes
+#include <qSlicerApplication.h>
 #include <qSlicerCLIExecutableModuleFactory.h>
+#include <qSlicerUtils.h>
 
 // STD includes
 
 #include "vtkMRMLCoreTestingMacros.h"
 
-int qSlicerCLIExecutableModuleFactoryTest1(int, char * [] )
+namespace
 {
+
+//-----------------------------------------------------------------------------
+// Title of the module instantiated by a new factory sharing the cache
+QString instantiatedModuleTitle(const QString& executablePath, const QString& cacheFilePath)
+{
+  qSlicerCLIExecutableModuleFactory factory;
+  factory.setModuleDescriptionCacheFilePath(cacheFilePath);
+  QString moduleName = factory.registerFileItem(QFileInfo(executablePath));
+  factory.loadXmlModuleDescriptions();
+  qSlicerAbstractCoreModule* module = factory.instantiate(moduleName);
+  QString title = module ? module->title() : QString();
+  if (module)
+    {
+    factory.uninstantiate(moduleName);
+    }
+  return title;
+}
+
+//-----------------------------------------------------------------------------
+// Set the value of the cache entry of an executable
+bool setCachedValue(const QString& cacheFilePath, const QString& executablePath,
+                    const QString& key, const QVariant& value)
+{
+  QSettings cache(cacheFilePath, QSettings::IniFormat);
+  foreach(const QString& group, cache.childGroups())
+    {
+    cache.beginGroup(group);
+    bool found = (cache.value("Path").toString() ==
+                  QFileInfo(executablePath).absoluteFilePath());
+    if (found)
+      {
+      cache.setValue(key, value);
+      }
+    cache.endGroup();
+    if (found)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+} // end of anonymous namespace
+
+int qSlicerCLIExecutableModuleFactoryTest1(int argc, char * argv [] )
+{
+  qSlicerApplication::setAttribute(qSlicerApplication::AA_DisablePython);
+  qSlicerApplication app(argc, argv);
+
   QStringList executableNames;
   executableNames << "Threshold.exe"
                   << "Threshold";
@@ -48,5 +104,81 @@ int qSlicerCLIExecutableModuleFactoryTest1(int, char * [] )
       }
     }
 
+  if (!factory.moduleDescriptionCacheFilePath().isEmpty())
+    {
+    std::cerr << __LINE__ << " - Error: cache should be disabled by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+  QString cacheFilePath = QDir::tempPath() + "/qSlicerCLIExecutableModuleFactoryTest1.ini";
+  factory.setModuleDescriptionCacheFilePath(cacheFilePath);
+  if (factory.moduleDescriptionCacheFilePath() != cacheFilePath)
+    {
+    std::cerr << __LINE__ << " - Error in setModuleDescriptionCacheFilePath()" << std::endl
+                          << "cacheFilePath = "
+                          << qPrintable(factory.moduleDescriptionCacheFilePath()) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The CLIModule4Test executable is built with the tests
+  QString executablePath = app.slicerHome() + "/" + Slicer_CLIMODULES_BIN_DIR + "/";
+  if (!app.intDir().isEmpty())
+    {
+    executablePath += app.intDir() + "/";
+    }
+  executablePath += "CLIModule4Test" + qSlicerUtils::executableExtension();
+  QString expectedTitle = "Command Line Module Test";
+  QFile::remove(cacheFilePath);
+
+  // The first instantiation runs the executable and fills the cache
+  QString title = instantiatedModuleTitle(executablePath, cacheFilePath);
+  if (title != expectedTitle)
+    {
+    std::cerr << __LINE__ << " - Error in instantiate()" << std::endl
+                          << "title = " << qPrintable(title) << std::endl
+                          << "expectedTitle = " << qPrintable(expectedTitle) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Cache hit: the description comes from the cache, as shown by a title
+  // changed in the cache only
+  QString cachedTitle = "Cached Command Line Module Test";
+  QString xmlModuleDescription;
+  {
+  QSettings cache(cacheFilePath, QSettings::IniFormat);
+  foreach(const QString& group, cache.childGroups())
+    {
+    xmlModuleDescription = cache.value(group + "/XmlModuleDescription").toString();
+    }
+  }
+  xmlModuleDescription.replace(expectedTitle, cachedTitle);
+  if (xmlModuleDescription.isEmpty() ||
+      !setCachedValue(cacheFilePath, executablePath, "XmlModuleDescription", xmlModuleDescription))
+    {
+    std::cerr << __LINE__ << " - Error: no cache entry for "
+              << qPrintable(executablePath) << std::endl;
+    return EXIT_FAILURE;
+    }
+  title = instantiatedModuleTitle(executablePath, cacheFilePath);
+  if (title != cachedTitle)
+    {
+    std::cerr << __LINE__ << " - Error: description not read from the cache" << std::endl
+                          << "title = " << qPrintable(title) << std::endl
+                          << "expectedTitle = " << qPrintable(cachedTitle) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Invalidation: the executable has been modified since it was cached
+  setCachedValue(cacheFilePath, executablePath, "LastModified",
+                 QFileInfo(executablePath).lastModified().addSecs(-60));
+  title = instantiatedModuleTitle(executablePath, cacheFilePath);
+  if (title != expectedTitle)
+    {
+    std::cerr << __LINE__ << " - Error: outdated cache entry used" << std::endl
+                          << "title = " << qPrintable(title) << std::endl
+                          << "expectedTitle = " << qPrintable(expectedTitle) << std::endl;
+    return EXIT_FAILURE;
+    }
+  QFile::remove(cacheFilePath);
+
   return EXIT_SUCCESS;
 }
@@ -19,7 +19,12 @@
 ==============================================================================*/
 
 // Qt includes
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QProcess>
+#include <QSet>
+#include <QSettings>
+#include <QThread>
 
 // SlicerQt includes
 #include "qSlicerCLIExecutableModuleFactory.h"
@@ -49,6 +54,34 @@ qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
   module->setModuleType("CommandLineModule");
   module->setEntryPoint(this->path());
 
+  if (!this->XmlModuleDescriptionError.isEmpty())
+    {
+    this->appendInstantiateErrorString(QString("CLI executable: %1").arg(this->path()));
+    this->appendInstantiateErrorString(this->XmlModuleDescriptionError);
+    return 0;
+    }
+  if (this->XmlModuleDescription.isEmpty())
+    {
+    this->XmlModuleDescription = this->runXmlModuleDescription();
+    }
+  if (this->XmlModuleDescription.isEmpty())
+    {
+    return 0;
+    }
+
+  module->setXmlModuleDescription(this->XmlModuleDescription.toLatin1());
+  module->setTempDirectory(this->TempDirectory);
+  module->setPath(this->path());
+  module->setInstalled(qSlicerCLIModuleFactoryHelper::isInstalled(this->path()));
+
+  this->CLIModule = module.data();
+
+  return module.take();
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryItem::runXmlModuleDescription()
+{
   ctkScopedCurrentDir scopedCurrentDir(QFileInfo(this->path()).path());
 
   int cliProcessTimeoutInMs = 5000;
@@ -93,7 +126,7 @@ qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
         break;
       }
     this->appendInstantiateErrorString(errorString);
-    return 0;
+    return QString();
     }
   QString errors = cli.readAllStandardError();
   if (!errors.isEmpty())
@@ -112,7 +145,7 @@ qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
     {
     this->appendInstantiateErrorString(QString("CLI executable: %1").arg(this->path()));
     this->appendInstantiateErrorString("Failed to retrieve Xml Description");
-    return 0;
+    return QString();
     }
   if (!xmlDescription.startsWith("<?xml"))
     {
@@ -122,15 +155,33 @@ qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactoryItem::instanciator()
                                            xmlDescription.mid(0, xmlDescription.indexOf("<?xml"))));
     xmlDescription.remove(0, xmlDescription.indexOf("<?xml"));
     }
+  return xmlDescription;
+}
 
-  module->setXmlModuleDescription(xmlDescription.toLatin1());
-  module->setTempDirectory(this->TempDirectory);
-  module->setPath(this->path());
-  module->setInstalled(qSlicerCLIModuleFactoryHelper::isInstalled(this->path()));
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryItem::setXmlModuleDescription(
+  const QString& xmlModuleDescription)
+{
+  this->XmlModuleDescription = xmlModuleDescription;
+}
 
-  this->CLIModule = module.data();
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryItem::xmlModuleDescription()const
+{
+  return this->XmlModuleDescription;
+}
 
-  return module.take();
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryItem::setXmlModuleDescriptionError(
+  const QString& errorString)
+{
+  this->XmlModuleDescriptionError = errorString;
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryItem::xmlModuleDescriptionError()const
+{
+  return this->XmlModuleDescriptionError;
 }
 
 //-----------------------------------------------------------------------------
@@ -153,8 +204,22 @@ public:
   typedef qSlicerCLIExecutableModuleFactoryPrivate Self;
   qSlicerCLIExecutableModuleFactoryPrivate(qSlicerCLIExecutableModuleFactory& object);
 
+  /// Set the XML description of the registered items that have not been
+  /// processed yet, from the cache or by running the executables in parallel.
+  void loadXmlModuleDescriptions();
+
+  static QString cacheGroup(const QString& path);
+  static QString cachedXmlModuleDescription(QSettings& cache, const QFileInfo& file);
+  static void cacheXmlModuleDescription(QSettings& cache, const QFileInfo& file,
+                                        const QString& xmlModuleDescription);
+
 private:
   QString TempDirectory;
+  QString CacheFilePath;
+  /// Paths of the executables already looked up in the cache or run
+  QSet<QString> ProcessedPaths;
+  /// Paths of the executables with an up-to-date entry in the cache
+  QSet<QString> CachedPaths;
 };
 
 //-----------------------------------------------------------------------------
@@ -164,6 +229,138 @@ qSlicerCLIExecutableModuleFactoryPrivate::qSlicerCLIExecutableModuleFactoryPriva
   this->TempDirectory = QDir::tempPath();
 }
 
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryPrivate::cacheGroup(const QString& path)
+{
+  return QString(QCryptographicHash::hash(
+    path.toUtf8(), QCryptographicHash::Md5).toHex());
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactoryPrivate::cachedXmlModuleDescription(
+  QSettings& cache, const QFileInfo& file)
+{
+  QString xmlModuleDescription;
+  cache.beginGroup(Self::cacheGroup(file.absoluteFilePath()));
+  if (cache.value("Path").toString() == file.absoluteFilePath() &&
+      cache.value("Size").toLongLong() == file.size() &&
+      cache.value("LastModified").toDateTime() == file.lastModified())
+    {
+    xmlModuleDescription = cache.value("XmlModuleDescription").toString();
+    }
+  cache.endGroup();
+  return xmlModuleDescription;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryPrivate::cacheXmlModuleDescription(
+  QSettings& cache, const QFileInfo& file, const QString& xmlModuleDescription)
+{
+  cache.beginGroup(Self::cacheGroup(file.absoluteFilePath()));
+  cache.setValue("Path", file.absoluteFilePath());
+  cache.setValue("Size", file.size());
+  cache.setValue("LastModified", file.lastModified());
+  cache.setValue("XmlModuleDescription", xmlModuleDescription);
+  cache.endGroup();
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactoryPrivate::loadXmlModuleDescriptions()
+{
+  Q_Q(qSlicerCLIExecutableModuleFactory);
+  QScopedPointer<QSettings> cache;
+  if (!this->CacheFilePath.isEmpty())
+    {
+    cache.reset(new QSettings(this->CacheFilePath, QSettings::IniFormat));
+    }
+
+  QList<qSlicerCLIExecutableModuleFactoryItem*> itemsToRun;
+  foreach(const QString& itemKey, q->itemKeys())
+    {
+    qSlicerCLIExecutableModuleFactoryItem* item =
+      dynamic_cast<qSlicerCLIExecutableModuleFactoryItem*>(q->item(itemKey));
+    if (!item || this->ProcessedPaths.contains(item->path()))
+      {
+      continue;
+      }
+    this->ProcessedPaths.insert(item->path());
+    if (!item->xmlModuleDescription().isEmpty() ||
+        !item->xmlModuleDescriptionError().isEmpty())
+      {
+      continue;
+      }
+    QString xmlModuleDescription;
+    if (cache)
+      {
+      xmlModuleDescription = Self::cachedXmlModuleDescription(*cache, QFileInfo(item->path()));
+      }
+    if (!xmlModuleDescription.isEmpty())
+      {
+      item->setXmlModuleDescription(xmlModuleDescription);
+      this->CachedPaths.insert(item->path());
+      continue;
+      }
+    itemsToRun << item;
+    }
+
+  // Run as many executables at once as there are cores. Only the well-formed
+  // descriptions are kept; the other executables are run again at
+  // instantiation to report the errors and warnings, except the ones that
+  // timed out: they are killed and fail at instantiation without being run
+  // again.
+  const int cliProcessTimeoutInMs = 5000;
+  const int maximumProcessCount = qMax(QThread::idealThreadCount(), 1);
+  QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+  env.insert("ITK_AUTOLOAD_PATH", "");
+  for (int first = 0; first < itemsToRun.count(); first += maximumProcessCount)
+    {
+    QList<qSlicerCLIExecutableModuleFactoryItem*> items =
+      itemsToRun.mid(first, maximumProcessCount);
+    QList<QProcess*> processes;
+    foreach(qSlicerCLIExecutableModuleFactoryItem* item, items)
+      {
+      QProcess* process = new QProcess;
+      process->setProcessEnvironment(env);
+      process->setWorkingDirectory(QFileInfo(item->path()).path());
+      process->start(item->path(), QStringList(QString("--xml")));
+      processes << process;
+      }
+    for (int i = 0; i < processes.count(); ++i)
+      {
+      QProcess* process = processes[i];
+      if (!process->waitForFinished(cliProcessTimeoutInMs))
+        {
+        if (process->state() != QProcess::NotRunning)
+          {
+          process->kill();
+          process->waitForFinished();
+          }
+        items[i]->setXmlModuleDescriptionError(QString(
+          "The process timed out after %1 msecs.").arg(cliProcessTimeoutInMs));
+        continue;
+        }
+      if (process->exitStatus() != QProcess::NormalExit)
+        {
+        continue;
+        }
+      QString errors = process->readAllStandardError();
+      QString xmlModuleDescription = process->readAllStandardOutput();
+      if (!errors.isEmpty() || !xmlModuleDescription.startsWith("<?xml"))
+        {
+        continue;
+        }
+      items[i]->setXmlModuleDescription(xmlModuleDescription);
+      if (cache)
+        {
+        Self::cacheXmlModuleDescription(*cache, QFileInfo(items[i]->path()),
+                                        xmlModuleDescription);
+        this->CachedPaths.insert(items[i]->path());
+        }
+      }
+    qDeleteAll(processes);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // qSlicerCLIExecutableModuleFactory
 
@@ -219,3 +416,49 @@ void qSlicerCLIExecutableModuleFactory::setTempDirectory(const QString& newTempD
   Q_D(qSlicerCLIExecutableModuleFactory);
   d->TempDirectory = newTempDirectory;
 }
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactory::setModuleDescriptionCacheFilePath(const QString& filePath)
+{
+  Q_D(qSlicerCLIExecutableModuleFactory);
+  d->CacheFilePath = filePath;
+  d->CachedPaths.clear();
+}
+
+//-----------------------------------------------------------------------------
+QString qSlicerCLIExecutableModuleFactory::moduleDescriptionCacheFilePath()const
+{
+  Q_D(const qSlicerCLIExecutableModuleFactory);
+  return d->CacheFilePath;
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCLIExecutableModuleFactory::loadXmlModuleDescriptions()
+{
+  Q_D(qSlicerCLIExecutableModuleFactory);
+  d->loadXmlModuleDescriptions();
+}
+
+//-----------------------------------------------------------------------------
+qSlicerAbstractCoreModule* qSlicerCLIExecutableModuleFactory::instantiate(const QString& itemKey)
+{
+  Q_D(qSlicerCLIExecutableModuleFactory);
+  d->loadXmlModuleDescriptions();
+  qSlicerAbstractCoreModule* module = this->Superclass::instantiate(itemKey);
+
+  // Cache the descriptions that could only be retrieved at instantiation,
+  // unless the executable must be run again to report its diagnostics
+  qSlicerCLIExecutableModuleFactoryItem* item =
+    dynamic_cast<qSlicerCLIExecutableModuleFactoryItem*>(this->item(itemKey));
+  if (module && item && !d->CacheFilePath.isEmpty() &&
+      !d->CachedPaths.contains(item->path()) &&
+      item->instantiateErrorStrings().isEmpty() &&
+      item->instantiateWarningStrings().isEmpty())
+    {
+    QSettings cache(d->CacheFilePath, QSettings::IniFormat);
+    qSlicerCLIExecutableModuleFactoryPrivate::cacheXmlModuleDescription(
+      cache, QFileInfo(item->path()), item->xmlModuleDescription());
+    d->CachedPaths.insert(item->path());
+    }
+  return module;
+}
@@ -38,10 +38,24 @@ public:
   qSlicerCLIExecutableModuleFactoryItem(const QString& newTempDirectory);
   virtual bool load();
   virtual void uninstantiate();
+
+  /// XML description of the module. If not set before instantiation, it is
+  /// retrieved by running the executable with "--xml".
+  void setXmlModuleDescription(const QString& xmlModuleDescription);
+  QString xmlModuleDescription()const;
+
+  /// Record that the executable failed to give its XML description, for
+  /// example because it timed out. The executable is then not run again at
+  /// instantiation, which fails with \a errorString.
+  void setXmlModuleDescriptionError(const QString& errorString);
+  QString xmlModuleDescriptionError()const;
 protected:
   virtual qSlicerAbstractCoreModule* instanciator();
+  QString runXmlModuleDescription();
 private:
   QString TempDirectory;
+  QString XmlModuleDescription;
+  QString XmlModuleDescriptionError;
   qSlicerCLIModule* CLIModule;
 };
 
@@ -67,6 +81,27 @@ public:
 
   void setTempDirectory(const QString& newTempDirectory);
 
+  /// File where the XML descriptions of the executables are cached between
+  /// sessions. Entries are keyed by executable path and invalidated when the
+  /// size or the last modification time of the executable changes.
+  /// Empty by default: no cache.
+  void setModuleDescriptionCacheFilePath(const QString& filePath);
+  QString moduleDescriptionCacheFilePath()const;
+
+  /// Retrieve at once the XML descriptions of the registered executables
+  /// that do not have one yet: they are first looked up in the cache, then
+  /// the remaining executables are run in parallel.
+  /// Called by instantiate() if needed. Call it after the registration so
+  /// that its time is not charged to the first instantiated module.
+  void loadXmlModuleDescriptions();
+
+  /// Reimplemented to load the XML descriptions of all the registered
+  /// executables first.
+  /// Descriptions retrieved at instantiation are cached only if the
+  /// executable reported no error nor warning.
+  /// \sa loadXmlModuleDescriptions()
+  virtual qSlicerAbstractCoreModule* instantiate(const QString& itemKey);
+
 protected:
   virtual bool isValidFile(const QFileInfo& file)const;
 
@@ -109,11 +109,13 @@ vtkMRMLAbstractLogic* qSlicerCLIModule::createLogic()
   logic->SetDefaultModuleDescription(d->Desc);
 
   // In developer mode keep the CLI modules input and output files
+  // in the temporary directory
   QSettings settings;
   bool developerModeEnabled = settings.value("Developer/DeveloperMode", false).toBool();
   if (developerModeEnabled)
     {
     logic->DeleteTemporaryFilesOff();
+    logic->SharedMemoryDataExchangeOff();
     }
 
   return logic;
@@ -29,14 +29,17 @@
 #include <vtkMRMLStorageNode.h>
 #include <vtkMRMLModelStorageNode.h>
 #include <vtkMRMLTransformNode.h>
+#include <vtkMRMLVolumeNode.h>
 
 // VTK includes
 #include <vtkCallbackCommand.h>
+#include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkStringArray.h>
+#include <vtkTimerLog.h>
 #include <vtksys/SystemTools.hxx>
 
 // ITKSYS includes
@@ -55,10 +58,12 @@
 #include <algorithm>
 #include <cassert>
 #include <ctime>
+#include <map>
 #include <set>
 
 #ifdef _WIN32
 #else
+#include <sys/statvfs.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
@@ -258,6 +263,37 @@ public:
 
   int RedirectModuleStreams;
 
+  int SharedMemoryDataExchange;
+
+  /// Return a RAM backed directory with at least \a requiredKB of free
+  /// space, an empty string if there is none.
+  static std::string GetSharedMemoryDirectory(unsigned long long requiredKB)
+  {
+#ifndef _WIN32
+    const char* directory = "/dev/shm";
+    if (!vtksys::SystemTools::FileIsDirectory(directory) ||
+        access(directory, W_OK) != 0)
+      {
+      return std::string();
+      }
+    struct statvfs stats;
+    if (statvfs(directory, &stats) != 0)
+      {
+      return std::string();
+      }
+    unsigned long long availableKB =
+      static_cast<unsigned long long>(stats.f_bavail) * stats.f_frsize / 1024;
+    if (availableKB < requiredKB)
+      {
+      return std::string();
+      }
+    return directory;
+#else
+    (void)requiredKB;
+    return std::string();
+#endif
+  }
+
   itk::MutexLock::Pointer ProcessesKillLock;
   std::vector<itksysProcess*> Processes;
 
@@ -342,6 +378,19 @@ public:
   /// being executed with their.
   RequestType LastRequests;
 
+  /// Output files of a CLI node being read back into the scene
+  struct OutputsRead
+  {
+    std::string Title;
+    std::string Directory;
+    unsigned long Size;
+    double StartTime;
+  };
+  /// Outputs being read back, by CLI node. Filled by the processing
+  /// threads and emptied by the main thread.
+  std::map<vtkMRMLCommandLineModuleNode*, OutputsRead> OutputsReads;
+  itk::MutexLock::Pointer OutputsReadsLock;
+
   vtkSmartPointer<vtkSlicerCLIRescheduleCallback> RescheduleCallback;
   vtkSmartPointer<vtkSlicerCLIOneShotCallbackCallback>OneShotCallbackCallback;
 };
@@ -355,8 +404,10 @@ vtkSlicerCLIModuleLogic::vtkSlicerCLIModuleLogic()
   this->Internal = new vtkInternal();
 
   this->Internal->ProcessesKillLock = itk::MutexLock::New();
+  this->Internal->OutputsReadsLock = itk::MutexLock::New();
   this->Internal->DeleteTemporaryFiles = 1;
   this->Internal->RedirectModuleStreams = 1;
+  this->Internal->SharedMemoryDataExchange = 1;
   this->Internal->RescheduleCallback =
     vtkSmartPointer<vtkSlicerCLIRescheduleCallback>::New();
   this->Internal->RescheduleCallback->SetCLIModuleLogic(this);
@@ -472,6 +523,35 @@ int vtkSlicerCLIModuleLogic::GetRedirectModuleStreams() const
   return this->Internal->RedirectModuleStreams;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SharedMemoryDataExchangeOn()
+{
+  this->SetSharedMemoryDataExchange(static_cast<int>(1));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SharedMemoryDataExchangeOff()
+{
+  this->SetSharedMemoryDataExchange(static_cast<int>(0));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetSharedMemoryDataExchange(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting SharedMemoryDataExchange to " << value);
+  if (this->Internal->SharedMemoryDataExchange != value)
+    {
+    this->Internal->SharedMemoryDataExchange = value;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetSharedMemoryDataExchange() const
+{
+  return this->Internal->SharedMemoryDataExchange;
+}
+
 //----------------------------------------------------------------------------
 std::string
 vtkSlicerCLIModuleLogic
@@ -912,6 +992,9 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   // vector of files to delete
   std::set<std::string> filesToDelete;
 
+  // MRML Ids of the volumes passed as files
+  std::set<std::string> imageNodeIDs;
+
   // iterators for parameter groups
   std::vector<ModuleParameterGroup>::iterator pgbeginit
     = node0->GetModuleDescription().GetParameterGroups().begin();
@@ -962,6 +1045,10 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
                                              commandType);
 
         filesToDelete.insert(fname);
+        if ((*pit).GetTag() == "image")
+          {
+          imageNodeIDs.insert(id);
+          }
 
         if ((*pit).GetChannel() == "input")
           {
@@ -984,9 +1071,54 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     temporaryDirectory = appLogic->GetTemporaryPath();
     }
 
+  // Executables can't access the scene, their volumes are exchanged via
+  // files. Move these files into a RAM backed directory if there is one
+  // with enough space, assuming the outputs are as large as the inputs.
+  std::string dataExchangeDirectory = temporaryDirectory;
+  if (commandType == CommandLineModule && this->GetSharedMemoryDataExchange())
+    {
+    unsigned long long inputSizeKB = 0;
+    std::set<std::string>::const_iterator idit;
+    for (idit = imageNodeIDs.begin(); idit != imageNodeIDs.end(); ++idit)
+      {
+      vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(
+        this->GetMRMLScene()->GetNodeByID(idit->c_str()));
+      if (nodesToWrite.find(*idit) != nodesToWrite.end() &&
+          volumeNode && volumeNode->GetImageData())
+        {
+        inputSizeKB += volumeNode->GetImageData()->GetActualMemorySize();
+        }
+      }
+    std::string sharedMemoryDirectory =
+      vtkInternal::GetSharedMemoryDirectory(2 * inputSizeKB);
+    if (!sharedMemoryDirectory.empty())
+      {
+      dataExchangeDirectory = sharedMemoryDirectory;
+      for (idit = imageNodeIDs.begin(); idit != imageNodeIDs.end(); ++idit)
+        {
+        MRMLIDToFileNameMap* fileNames[2] = {&nodesToWrite, &nodesToReload};
+        for (int i = 0; i < 2; ++i)
+          {
+          MRMLIDToFileNameMap::iterator id2fn = fileNames[i]->find(*idit);
+          if (id2fn == fileNames[i]->end())
+            {
+            continue;
+            }
+          filesToDelete.erase(id2fn->second);
+          id2fn->second = sharedMemoryDirectory + "/"
+            + vtksys::SystemTools::GetFilenameName(id2fn->second);
+          filesToDelete.insert(id2fn->second);
+          }
+        }
+      }
+    }
+
   // write out the input datasets
   //
   //
+  vtkNew<vtkTimerLog> dataExchangeTimer;
+  dataExchangeTimer->StartTimer();
+  unsigned long dataExchangeSize = 0;
 
   std::set<std::string> MemoryTransferPossible;
   MemoryTransferPossible.insert("vtkMRMLScalarVolumeNode");
@@ -1085,9 +1217,24 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
         {
         vtkErrorMacro("ERROR writing file " << out->GetFileName());
         }
+      else
+        {
+        dataExchangeSize +=
+          vtksys::SystemTools::FileLength((*id2fn0).second.c_str());
+        }
       out = 0;
       }
     }
+  dataExchangeTimer->StopTimer();
+  if (dataExchangeSize > 0)
+    {
+    std::stringstream information;
+    information << node0->GetModuleDescription().GetTitle()
+                << " input data: " << dataExchangeSize / (1024. * 1024.)
+                << " MB written to " << dataExchangeDirectory << " in "
+                << dataExchangeTimer->GetElapsedTime() << "s";
+    qDebug() << information.str().c_str();
+    }
 
   // Also need to run through any output nodes that will be
   // communicated through the miniscene and add them to the miniscene
@@ -2271,8 +2418,31 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
   // import the results if the plugin was allowed to complete
   //
   //
+  vtkInternal::OutputsRead outputsRead;
+  outputsRead.Title = node0->GetModuleDescription().GetTitle();
+  outputsRead.Directory = dataExchangeDirectory;
+  outputsRead.Size = 0;
+  outputsRead.StartTime = vtkTimerLog::GetUniversalTime();
   if (node0->GetStatus() == vtkMRMLCommandLineModuleNode::Completing)
     {
+    // The time to read the outputs back is reported once the application
+    // logic has processed the last request. The read is recorded before the
+    // requests are queued: the main thread may process them right away.
+    for (id2fn0 = nodesToReload.begin(); id2fn0 != nodesToReload.end(); ++id2fn0)
+      {
+      if (sceneToMiniSceneMap.find((*id2fn0).first) == sceneToMiniSceneMap.end())
+        {
+        outputsRead.Size +=
+          vtksys::SystemTools::FileLength((*id2fn0).second.c_str());
+        }
+      }
+    if (outputsRead.Size > 0)
+      {
+      this->Internal->OutputsReadsLock->Lock();
+      this->Internal->OutputsReads[node0] = outputsRead;
+      this->Internal->OutputsReadsLock->Unlock();
+      }
+
     // reload nodes
     for (id2fn0 = nodesToReload.begin(); id2fn0 != nodesToReload.end(); ++id2fn0)
       {
@@ -2637,6 +2807,20 @@ void vtkSlicerCLIModuleLogic::ProcessMRMLLogicsEvents(vtkObject* caller,
       // If the status is not Completing, then there should be no request made
       // on the application logic.
       assert(node->GetStatus() == vtkMRMLCommandLineModuleNode::Completing);
+      this->Internal->OutputsReadsLock->Lock();
+      std::map<vtkMRMLCommandLineModuleNode*, vtkInternal::OutputsRead>::iterator
+        readIt = this->Internal->OutputsReads.find(node);
+      if (readIt != this->Internal->OutputsReads.end())
+        {
+        std::stringstream information;
+        information << readIt->second.Title
+                    << " output data: " << readIt->second.Size / (1024. * 1024.)
+                    << " MB read from " << readIt->second.Directory << " in "
+                    << vtkTimerLog::GetUniversalTime() - readIt->second.StartTime << "s";
+        qDebug() << information.str().c_str();
+        this->Internal->OutputsReads.erase(readIt);
+        }
+      this->Internal->OutputsReadsLock->Unlock();
       node->SetStatus(vtkMRMLCommandLineModuleNode::Completed);
       this->Internal->LastRequests.erase(it);
       // we are not interested in any request anymore because the cli node is
@@ -82,6 +82,15 @@ public:
   void SetRedirectModuleStreams(int value);
   int GetRedirectModuleStreams() const;
 
+  /// Exchange the volumes of executable CLIs through a RAM backed directory
+  /// (e.g. /dev/shm) instead of the temporary directory when there is one
+  /// with enough free space. The volume files then never hit the disk.
+  /// On by default.
+  virtual void SharedMemoryDataExchangeOn();
+  virtual void SharedMemoryDataExchangeOff();
+  void SetSharedMemoryDataExchange(int value);
+  int GetSharedMemoryDataExchange() const;
+
   /// Schedules the command line module to run.
   /// The CLI is scheduled to be run in a separate thread. This methods
   /// is non blocking and returns immediately.
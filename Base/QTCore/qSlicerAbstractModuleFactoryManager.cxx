@@ -20,6 +20,7 @@
 
 // Qt includes
 #include <QDir>
+#include <QTime>
 
 // SlicerQt includes
 #include "qSlicerAbstractModuleFactoryManager.h"
@@ -54,6 +55,7 @@ public:
   QMap<qSlicerModuleFactory*, int> Factories;
   QMap<QString, qSlicerModuleFactory*> RegisteredModules;
   QMap<QString, QStringList> ModuleDependees;
+  QMap<QString, int> ModuleInstantiationTimes;
 
   bool Verbose;
 };
@@ -167,6 +169,14 @@ void qSlicerAbstractModuleFactoryManager::unregisterFactories()
     }
 }
 
+//-----------------------------------------------------------------------------
+QList<qSlicerAbstractModuleFactoryManager::qSlicerModuleFactory*>
+qSlicerAbstractModuleFactoryManager::registeredFactories()const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->Factories.keys();
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerAbstractModuleFactoryManager::setSearchPaths(const QStringList& paths)
 {
@@ -378,7 +388,15 @@ qSlicerAbstractCoreModule* qSlicerAbstractModuleFactoryManager
   Q_D(qSlicerAbstractModuleFactoryManager);
   Q_ASSERT(d->RegisteredModules.contains(moduleName));
   qSlicerModuleFactory* factory = d->RegisteredModules[moduleName];
+  QTime time;
+  time.start();
   qSlicerAbstractCoreModule* module = factory->instantiate(moduleName);
+  int elapsed = time.elapsed();
+  d->ModuleInstantiationTimes[moduleName] = elapsed;
+  if (d->Verbose)
+    {
+    qDebug("ModuleInstantiationTime,%s,%d", qPrintable(moduleName), elapsed);
+    }
   if (module)
     {
     module->setName(moduleName);
@@ -400,6 +418,13 @@ qSlicerAbstractCoreModule* qSlicerAbstractModuleFactoryManager
   return module;
 }
 
+//-----------------------------------------------------------------------------
+int qSlicerAbstractModuleFactoryManager::moduleInstantiationTime(const QString& moduleName)const
+{
+  Q_D(const qSlicerAbstractModuleFactoryManager);
+  return d->ModuleInstantiationTimes.value(moduleName, -1);
+}
+
 //-----------------------------------------------------------------------------
 QStringList qSlicerAbstractModuleFactoryManager::registeredModuleNames() const
 {
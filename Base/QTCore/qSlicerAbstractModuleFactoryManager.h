@@ -110,6 +110,8 @@ public:
   void registerFactory(qSlicerModuleFactory* factory, int priority = 0);
   void unregisterFactory(qSlicerModuleFactory* factory);
   void unregisterFactories();
+  /// Return the registered factories
+  QList<qSlicerModuleFactory*> registeredFactories()const;
 
   void setSearchPaths(const QStringList& searchPaths);
   QStringList searchPaths()const;
@@ -167,6 +169,13 @@ public:
   /// Return the instance of a module if already instantiated, 0 otherwise
   Q_INVOKABLE qSlicerAbstractCoreModule* moduleInstance(const QString& moduleName)const;
 
+  /// Return the time in msecs spent instantiating the module, -1 if it has
+  /// not been instantiated.
+  /// When verbose, each instantiation also prints a machine-readable line:
+  /// "ModuleInstantiationTime,<moduleName>,<msecs>"
+  /// \sa setIsVerbose()
+  Q_INVOKABLE int moduleInstantiationTime(const QString& moduleName)const;
+
   /// Uninstantiate all instantiated modules
   void uninstantiateModules();
 
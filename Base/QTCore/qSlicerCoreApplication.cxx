@@ -90,6 +90,9 @@
 #endif
 #include <vtkMRMLScene.h>
 
+// vtkITK includes
+#include <vtkITKArchetypeImageSeriesReader.h>
+
 // VTK includes
 #include <vtkNew.h>
 #include <vtksys/SystemTools.hxx>
@@ -252,11 +255,21 @@ void qSlicerCoreApplicationPrivate::init()
   // in MRMLApplicationLogic.
   //this->AppLogic->ProcessMRMLEvents(scene, vtkCommand::ModifiedEvent, NULL);
   //this->AppLogic->SetAndObserveMRMLScene(scene);
+  // Number of processing tasks (e.g. CLIs) that can run concurrently
+  this->AppLogic->SetNumberOfProcessingThreads(
+    q->userSettings()->value("Modules/NumberOfProcessingThreads", 1).toInt());
   this->AppLogic->CreateProcessingThread();
 
   // Set up Slicer to use the system proxy
   QNetworkProxyFactory::setUseSystemConfiguration(true);
 
+  // Index of the DICOM headers read by the volume readers, so that reloading
+  // a DICOM directory only reads the headers of the files that changed.
+  // An empty path disables the index.
+  vtkITKArchetypeImageSeriesReader::SetGlobalDICOMHeaderIndexDirectory(
+    q->userSettings()->value("Volumes/DICOMHeaderIndexDirectory",
+      QFileInfo(q->temporaryPath(), "DICOMHeaderIndex").absoluteFilePath()).toString().toLatin1());
+
   // Create MRMLRemoteIOLogic
   this->MRMLRemoteIOLogic = vtkSmartPointer<vtkMRMLRemoteIOLogic>::New();
   // Default cache location, can be changed in settings.
@@ -271,6 +284,11 @@ void qSlicerCoreApplicationPrivate::init()
 
   // Create MRML scene
   vtkNew<vtkMRMLScene> scene;
+  // Number of threads reading the data files of the imported scenes.
+  // Not all the readers are known to be thread-safe, the files are read in
+  // the main thread unless the setting is changed.
+  scene->SetNumberOfImportThreads(
+    q->userSettings()->value("Modules/NumberOfImportThreads", 1).toInt());
   q->setMRMLScene(scene.GetPointer());
 
   // Instantiate moduleManager
@@ -0,0 +1,154 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2013 Brigham and Women's Hospital (BWH)
+  All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+struct CallbackData
+{
+  std::vector<vtkObject*> Callers;
+  double Duration;
+};
+
+//----------------------------------------------------------------------------
+void RecordCallback(vtkObject *caller, unsigned long vtkNotUsed(eid),
+                    void *clientData, void *vtkNotUsed(callData))
+{
+  CallbackData* data = reinterpret_cast<CallbackData*>(clientData);
+  data->Callers.push_back(caller);
+  // Simulate an expensive observer
+  double start = vtkTimerLog::GetUniversalTime();
+  while (vtkTimerLog::GetUniversalTime() - start < data->Duration)
+    {
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerAsynchronousTest(int , char * [] )
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  broker->SetEventModeToAsynchronous();
+  broker->SetNumberOfCoalescedEvents(0);
+
+  vtkNew<vtkObject> observer;
+  CallbackData data;
+  data.Duration = 0.;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(RecordCallback);
+  callback->SetClientData(&data);
+
+  // Repeated modifications of a subject are merged into a single call and
+  // the observations are invoked by decreasing priority
+  vtkNew<vtkObject> lowPrioritySubject;
+  vtkNew<vtkObject> highPrioritySubject;
+  vtkObservation* lowPriorityObservation = broker->AddObservation(
+    lowPrioritySubject.GetPointer(), vtkCommand::ModifiedEvent,
+    observer.GetPointer(), callback.GetPointer(), 0.f);
+  broker->AddObservation(
+    highPrioritySubject.GetPointer(), vtkCommand::ModifiedEvent,
+    observer.GetPointer(), callback.GetPointer(), 1.f);
+  for (int i = 0; i < 100; ++i)
+    {
+    lowPrioritySubject->Modified();
+    highPrioritySubject->Modified();
+    }
+  if (broker->GetNumberOfQueuedObservations() != 2 ||
+      broker->GetNumberOfCoalescedEvents() != 198)
+    {
+    std::cerr << "Line " << __LINE__ << ": events not coalesced: "
+              << broker->GetNumberOfQueuedObservations() << " queued observations, "
+              << broker->GetNumberOfCoalescedEvents() << " coalesced events" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (broker->GetNthQueuedObservation(0)->GetSubject() != highPrioritySubject.GetPointer())
+    {
+    std::cerr << "Line " << __LINE__ << ": queue not ordered by priority" << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->ProcessEventQueue();
+  if (data.Callers.size() != 2 ||
+      data.Callers[0] != highPrioritySubject.GetPointer() ||
+      data.Callers[1] != lowPrioritySubject.GetPointer() ||
+      broker->GetNumberOfQueuedObservations() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong invocations: "
+              << data.Callers.size() << " calls" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Removing a queued observation removes it from the queue
+  lowPrioritySubject->Modified();
+  highPrioritySubject->Modified();
+  broker->RemoveObservation(lowPriorityObservation);
+  if (broker->GetNumberOfQueuedObservations() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": removed observation still queued" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (broker->DequeueObservation() == 0 ||
+      broker->DequeueObservation() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": DequeueObservation failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A time slice leaves the remaining observations in the queue
+  const int numberOfSubjects = 5;
+  std::vector<vtkSmartPointer<vtkObject> > subjects;
+  for (int i = 0; i < numberOfSubjects; ++i)
+    {
+    subjects.push_back(vtkSmartPointer<vtkObject>::New());
+    broker->AddObservation(
+      subjects[i].GetPointer(), vtkCommand::ModifiedEvent,
+      observer.GetPointer(), callback.GetPointer());
+    subjects[i]->Modified();
+    }
+  data.Callers.clear();
+  data.Duration = 0.01;
+  int remaining = broker->ProcessEventQueue(0.015);
+  if (remaining <= 0 || remaining >= numberOfSubjects ||
+      remaining != broker->GetNumberOfQueuedObservations() ||
+      static_cast<int>(data.Callers.size()) != numberOfSubjects - remaining)
+    {
+    std::cerr << "Line " << __LINE__ << ": time slice not honored: "
+              << remaining << " observations remaining" << std::endl;
+    return EXIT_FAILURE;
+    }
+  broker->ProcessEventQueue();
+  if (static_cast<int>(data.Callers.size()) != numberOfSubjects ||
+      data.Callers[numberOfSubjects - 1] != subjects[numberOfSubjects - 1].GetPointer())
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong invocations after time slice" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  broker->RemoveObservations(observer.GetPointer());
+  broker->SetEventModeToSynchronous();
+  return EXIT_SUCCESS;
+}
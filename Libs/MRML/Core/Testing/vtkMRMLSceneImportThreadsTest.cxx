@@ -0,0 +1,235 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLModelStorageNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const int NumberOfModels = 12;
+
+//---------------------------------------------------------------------------
+// Model storage node counting the files prefetched by the worker threads
+class vtkMRMLCountingModelStorageNode : public vtkMRMLModelStorageNode
+{
+public:
+  static vtkMRMLCountingModelStorageNode *New();
+  vtkTypeMacro(vtkMRMLCountingModelStorageNode, vtkMRMLModelStorageNode);
+  virtual vtkMRMLNode* CreateNodeInstance();
+  virtual const char* GetNodeTagName() {return "CountingModelStorage";};
+
+  static vtkMultiThreaderIDType MainThreadID;
+  static vtkSimpleMutexLock Lock;
+  static int NumberOfWorkerThreadReads;
+
+protected:
+  vtkMRMLCountingModelStorageNode() {}
+  virtual vtkSmartPointer<vtkObject> PrefetchDataInternal(vtkMRMLNode* refNode)
+  {
+    vtkSmartPointer<vtkObject> data = this->Superclass::PrefetchDataInternal(refNode);
+    if (data.GetPointer() != NULL &&
+        !vtkMultiThreader::ThreadsEqual(vtkMultiThreader::GetCurrentThreadID(),
+                                        MainThreadID))
+      {
+      Lock.Lock();
+      ++NumberOfWorkerThreadReads;
+      Lock.Unlock();
+      }
+    return data;
+  }
+};
+vtkMRMLNodeNewMacro(vtkMRMLCountingModelStorageNode);
+vtkMultiThreaderIDType vtkMRMLCountingModelStorageNode::MainThreadID =
+  vtkMultiThreader::GetCurrentThreadID();
+vtkSimpleMutexLock vtkMRMLCountingModelStorageNode::Lock;
+int vtkMRMLCountingModelStorageNode::NumberOfWorkerThreadReads = 0;
+
+//---------------------------------------------------------------------------
+int ImportEventCount = 0;
+void ImportCallback(vtkObject*, unsigned long, void*, void*)
+{
+  ++ImportEventCount;
+}
+
+//---------------------------------------------------------------------------
+// Save a scene of models with a different number of points each.
+bool CreateScene(const std::string& sceneFileName, const std::string& tempDir)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLCountingModelStorageNode> countingStorageNode;
+  scene->RegisterNodeClass(countingStorageNode.GetPointer());
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkNew<vtkSphereSource> sphere;
+    sphere->SetThetaResolution(100 + i);
+    sphere->SetPhiResolution(100);
+    sphere->Update();
+
+    vtkNew<vtkMRMLModelNode> modelNode;
+    modelNode->SetAndObservePolyData(sphere->GetOutput());
+    scene->AddNode(modelNode.GetPointer());
+
+    std::stringstream fileName;
+    fileName << tempDir << "/vtkMRMLSceneImportThreadsTest" << i
+             << (i % 2 ? ".vtk" : ".vtp");
+    vtkNew<vtkMRMLCountingModelStorageNode> storageNode;
+    storageNode->SetFileName(fileName.str().c_str());
+    scene->AddNode(storageNode.GetPointer());
+    modelNode->SetAndObserveStorageNodeID(storageNode->GetID());
+    if (!storageNode->WriteData(modelNode.GetPointer()))
+      {
+      std::cerr << "Line " << __LINE__ << ": failed to write "
+                << fileName.str() << std::endl;
+      return false;
+      }
+    }
+  scene->SetURL(sceneFileName.c_str());
+  if (!scene->Commit())
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to save "
+              << sceneFileName << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool TestImport(const std::string& sceneFileName, int numberOfThreads)
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLCountingModelStorageNode> countingStorageNode;
+  scene->RegisterNodeClass(countingStorageNode.GetPointer());
+  scene->SetURL(sceneFileName.c_str());
+  scene->SetNumberOfImportThreads(numberOfThreads);
+  vtkMRMLCountingModelStorageNode::MainThreadID = vtkMultiThreader::GetCurrentThreadID();
+  vtkMRMLCountingModelStorageNode::NumberOfWorkerThreadReads = 0;
+
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(ImportCallback);
+  scene->AddObserver(vtkMRMLScene::StartImportEvent, callback.GetPointer());
+  scene->AddObserver(vtkMRMLScene::EndImportEvent, callback.GetPointer());
+  ImportEventCount = 0;
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  int res = scene->Import();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"Import" << numberOfThreads
+            << "Threads\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  if (!res || ImportEventCount != 2 || scene->IsImporting())
+    {
+    std::cerr << "Line " << __LINE__ << ": import failed with "
+              << numberOfThreads << " threads" << std::endl;
+    return false;
+    }
+  // every file is read by a worker thread if there is more than one thread
+  int expectedWorkerThreadReads = numberOfThreads > 1 ? NumberOfModels : 0;
+  if (vtkMRMLCountingModelStorageNode::NumberOfWorkerThreadReads != expectedWorkerThreadReads)
+    {
+    std::cerr << "Line " << __LINE__ << ": "
+              << vtkMRMLCountingModelStorageNode::NumberOfWorkerThreadReads
+              << " files read by the worker threads instead of "
+              << expectedWorkerThreadReads << " with "
+              << numberOfThreads << " threads" << std::endl;
+    return false;
+    }
+  std::cout << "<DartMeasurement name=\"ImportRead" << numberOfThreads
+            << "Threads\" type=\"numeric/double\">"
+            << scene->GetLastImportReadTime() << "</DartMeasurement>" << std::endl;
+  if (scene->GetLastImportTime() <= 0. ||
+      scene->GetLastImportTime() > timer->GetElapsedTime() ||
+      scene->GetLastImportReadTime() > scene->GetLastImportTime() ||
+      (numberOfThreads == 1 && scene->GetLastImportReadTime() != 0.))
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong import times with "
+              << numberOfThreads << " threads: "
+              << scene->GetLastImportTime() << " "
+              << scene->GetLastImportReadTime() << std::endl;
+    return false;
+    }
+
+  std::vector<vtkMRMLNode*> modelNodes;
+  scene->GetNodesByClass("vtkMRMLModelNode", modelNodes);
+  if (static_cast<int>(modelNodes.size()) != NumberOfModels)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << modelNodes.size()
+              << " models instead of " << NumberOfModels << std::endl;
+    return false;
+    }
+  double readTime = 0.;
+  for (int i = 0; i < NumberOfModels; ++i)
+    {
+    vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(modelNodes[i]);
+    vtkMRMLStorageNode* storageNode = modelNode->GetStorageNode();
+    vtkIdType expectedNumberOfPoints = (100 + i) * 98 + 2;
+    if (!storageNode || !modelNode->GetPolyData() ||
+        modelNode->GetPolyData()->GetNumberOfPoints() != expectedNumberOfPoints)
+      {
+      std::cerr << "Line " << __LINE__ << ": model " << i << " not read with "
+                << numberOfThreads << " threads" << std::endl;
+      return false;
+      }
+    readTime += storageNode->GetLastReadTime();
+    }
+  std::cout << "<DartMeasurement name=\"ReadTime" << numberOfThreads
+            << "Threads\" type=\"numeric/double\">"
+            << readTime << "</DartMeasurement>" << std::endl;
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneImportThreadsTest(int argc, char * argv [] )
+{
+  if (argc != 2)
+    {
+    std::cerr << "Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+  std::string sceneFileName = tempDir + "/vtkMRMLSceneImportThreadsTest.mrml";
+  if (!CreateScene(sceneFileName, tempDir))
+    {
+    return EXIT_FAILURE;
+    }
+
+  bool res = true;
+  res = TestImport(sceneFileName, 1) && res;
+  res = TestImport(sceneFileName, 4) && res;
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
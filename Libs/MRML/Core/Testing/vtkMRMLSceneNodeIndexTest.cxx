@@ -0,0 +1,280 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLModelDisplayNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+// Reference implementation: traverse the whole scene
+std::vector<vtkMRMLNode*> BruteForceNodesByClass(vtkMRMLScene* scene,
+                                                 const char* className,
+                                                 const char* name = 0)
+{
+  std::vector<vtkMRMLNode*> nodes;
+  for (int i = 0; i < scene->GetNumberOfNodes(); ++i)
+    {
+    vtkMRMLNode* node = scene->GetNthNode(i);
+    if ((className == 0 || node->IsA(className)) &&
+        (name == 0 || (node->GetName() && strcmp(node->GetName(), name) == 0)))
+      {
+      nodes.push_back(node);
+      }
+    }
+  return nodes;
+}
+
+//---------------------------------------------------------------------------
+bool CheckNodes(vtkCollection* collection,
+                const std::vector<vtkMRMLNode*>& expected, int line)
+{
+  bool res = (collection->GetNumberOfItems() == static_cast<int>(expected.size()));
+  for (int i = 0; res && i < collection->GetNumberOfItems(); ++i)
+    {
+    res = (collection->GetItemAsObject(i) == expected[i]);
+    }
+  collection->Delete();
+  if (!res)
+    {
+    std::cerr << "Line " << line << ": wrong nodes: "
+              << expected.size() << " nodes expected" << std::endl;
+    }
+  return res;
+}
+
+//---------------------------------------------------------------------------
+bool CheckClass(vtkMRMLScene* scene, const char* className, int line)
+{
+  std::vector<vtkMRMLNode*> expected = BruteForceNodesByClass(scene, className);
+  std::vector<vtkMRMLNode*> nodes;
+  scene->GetNodesByClass(className, nodes);
+  if (nodes != expected ||
+      scene->GetNumberOfNodesByClass(className) != static_cast<int>(expected.size()))
+    {
+    std::cerr << "Line " << line << ": wrong nodes for class " << className
+              << ": " << nodes.size() << " nodes instead of " << expected.size()
+              << std::endl;
+    return false;
+    }
+  for (size_t i = 0; i < expected.size(); ++i)
+    {
+    if (scene->GetNthNodeByClass(static_cast<int>(i), className) != expected[i])
+      {
+      std::cerr << "Line " << line << ": wrong " << i << "th node for class "
+                << className << std::endl;
+      return false;
+      }
+    }
+  if (scene->GetNthNodeByClass(static_cast<int>(expected.size()), className) != 0 ||
+      scene->GetFirstNode(0, className) != (expected.size() ? expected[0] : 0))
+    {
+    std::cerr << "Line " << line << ": wrong first/last node for class "
+              << className << std::endl;
+    return false;
+    }
+  return CheckNodes(scene->GetNodesByClass(className), expected, line);
+}
+
+//---------------------------------------------------------------------------
+bool CheckName(vtkMRMLScene* scene, const char* className, const char* name, int line)
+{
+  std::vector<vtkMRMLNode*> expected = BruteForceNodesByClass(scene, 0, name);
+  if (scene->GetFirstNodeByName(name) != (expected.size() ? expected[0] : 0) ||
+      !CheckNodes(scene->GetNodesByName(name), expected, line))
+    {
+    std::cerr << "Line " << line << ": wrong nodes for name " << name << std::endl;
+    return false;
+    }
+  expected = BruteForceNodesByClass(scene, className, name);
+  if (scene->GetFirstNode(name, className) != (expected.size() ? expected[0] : 0) ||
+      !CheckNodes(scene->GetNodesByClassByName(className, name), expected, line))
+    {
+    std::cerr << "Line " << line << ": wrong nodes for class " << className
+              << " and name " << name << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void PopulateScene(vtkMRMLScene* scene, int numberOfNodes)
+{
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkSmartPointer<vtkMRMLNode> node;
+    switch (i % 4)
+      {
+      case 0: node = vtkSmartPointer<vtkMRMLModelNode>::New(); break;
+      case 1: node = vtkSmartPointer<vtkMRMLScalarVolumeNode>::New(); break;
+      default: node = vtkSmartPointer<vtkMRMLModelDisplayNode>::New(); break;
+      }
+    std::stringstream name;
+    name << "Node" << (i % 10);
+    node->SetName(name.str().c_str());
+    scene->AddNode(node);
+    }
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+}
+
+//---------------------------------------------------------------------------
+bool TestIndexes()
+{
+  vtkNew<vtkMRMLScene> scene;
+  PopulateScene(scene.GetPointer(), 100);
+
+  const char* classNames[] = {"vtkMRMLModelNode", "vtkMRMLScalarVolumeNode",
+                              "vtkMRMLDisplayableNode", "vtkMRMLDisplayNode",
+                              "vtkMRMLNode", "vtkMRMLCameraNode"};
+  const int numberOfClassNames = sizeof(classNames) / sizeof(classNames[0]);
+  bool res = true;
+  for (int i = 0; i < numberOfClassNames; ++i)
+    {
+    res = CheckClass(scene.GetPointer(), classNames[i], __LINE__) && res;
+    }
+  res = CheckName(scene.GetPointer(), "vtkMRMLDisplayableNode", "Node4", __LINE__) && res;
+  res = CheckName(scene.GetPointer(), "vtkMRMLNode", "Unknown", __LINE__) && res;
+
+  // Interleaved queries on different classes keep their results
+  std::vector<vtkMRMLNode*> models = BruteForceNodesByClass(scene.GetPointer(), "vtkMRMLModelNode");
+  std::vector<vtkMRMLNode*> displayNodes = BruteForceNodesByClass(scene.GetPointer(), "vtkMRMLDisplayNode");
+  for (size_t i = 0; i < models.size() && i < displayNodes.size(); ++i)
+    {
+    if (scene->GetNthNodeByClass(static_cast<int>(i), "vtkMRMLModelNode") != models[i] ||
+        scene->GetNthNodeByClass(static_cast<int>(i), "vtkMRMLDisplayNode") != displayNodes[i] ||
+        scene->GetFirstNode(0, "vtkMRMLNode") != scene->GetNthNode(0))
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong interleaved query " << i << std::endl;
+      res = false;
+      break;
+      }
+    }
+
+  // Rename
+  vtkMRMLNode* renamedNode = scene->GetNthNodeByClass(3, "vtkMRMLModelNode");
+  renamedNode->SetName("Renamed");
+  res = CheckName(scene.GetPointer(), "vtkMRMLModelNode", "Renamed", __LINE__) && res;
+  res = CheckName(scene.GetPointer(), "vtkMRMLNode", "Node2", __LINE__) && res;
+  renamedNode->SetName("Node7");
+  res = CheckName(scene.GetPointer(), "vtkMRMLNode", "Node7", __LINE__) && res;
+
+  // Remove
+  scene->RemoveNode(scene->GetNthNodeByClass(10, "vtkMRMLDisplayableNode"));
+  scene->RemoveNode(scene->GetFirstNodeByName("Node7"));
+  for (int i = 0; i < numberOfClassNames; ++i)
+    {
+    res = CheckClass(scene.GetPointer(), classNames[i], __LINE__) && res;
+    }
+  res = CheckName(scene.GetPointer(), "vtkMRMLNode", "Node7", __LINE__) && res;
+
+  // Insert (modifies the collection order)
+  vtkNew<vtkMRMLModelNode> insertedNode;
+  insertedNode->SetName("Node7");
+  scene->InsertBeforeNode(scene->GetNthNode(0), insertedNode.GetPointer());
+  for (int i = 0; i < numberOfClassNames; ++i)
+    {
+    res = CheckClass(scene.GetPointer(), classNames[i], __LINE__) && res;
+    }
+  res = CheckName(scene.GetPointer(), "vtkMRMLModelNode", "Node7", __LINE__) && res;
+  if (scene->GetFirstNodeByName("Node7") != insertedNode.GetPointer())
+    {
+    std::cerr << "Line " << __LINE__ << ": inserted node not found first" << std::endl;
+    res = false;
+    }
+
+  // Clear
+  scene->Clear(1);
+  res = CheckClass(scene.GetPointer(), "vtkMRMLNode", __LINE__) && res;
+  res = CheckName(scene.GetPointer(), "vtkMRMLNode", "Node7", __LINE__) && res;
+  return res;
+}
+
+//---------------------------------------------------------------------------
+bool TestPerformance(int numberOfNodes)
+{
+  vtkNew<vtkMRMLScene> scene;
+  PopulateScene(scene.GetPointer(), numberOfNodes);
+
+  const int numberOfQueries = 1000;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  int numberOfFoundNodes = 0;
+  for (int i = 0; i < numberOfQueries; ++i)
+    {
+    numberOfFoundNodes += scene->GetNumberOfNodesByClass("vtkMRMLScalarVolumeNode");
+    numberOfFoundNodes +=
+      (scene->GetNthNodeByClass(i % 10, "vtkMRMLDisplayableNode") != 0);
+    numberOfFoundNodes += (scene->GetFirstNodeByName("Node5") != 0);
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"ClassQueries" << numberOfNodes
+            << "Nodes\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // Interleave queries and scene modifications: the indexes must be kept up
+  // to date without being recomputed.
+  timer->StartTimer();
+  for (int i = 0; i < numberOfQueries; ++i)
+    {
+    vtkNew<vtkMRMLScalarVolumeNode> node;
+    scene->AddNode(node.GetPointer());
+    numberOfFoundNodes += (scene->GetNthNodeByClass(0, "vtkMRMLScalarVolumeNode") != 0);
+    scene->RemoveNode(node.GetPointer());
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"AddQueryRemove" << numberOfNodes
+            << "Nodes\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  int expectedNumberOfFoundNodes =
+    numberOfQueries * (numberOfNodes / 4 + ((numberOfNodes % 4) > 1 ? 1 : 0) + 3);
+  if (numberOfFoundNodes != expectedNumberOfFoundNodes)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << numberOfFoundNodes
+              << " nodes found instead of " << expectedNumberOfFoundNodes << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodeIndexTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  bool res = true;
+  res = TestIndexes() && res;
+  res = TestPerformance(1000) && res;
+  res = TestPerformance(5000) && res;
+  res = TestPerformance(20000) && res;
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,233 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScalarVolumeNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkVersion.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+bool CheckName(vtkMRMLNode* node, const char* expectedName, int line)
+{
+  if (!node->GetName() || strcmp(node->GetName(), expectedName) != 0)
+    {
+    std::cerr << "Line " << line << ": wrong name: "
+              << (node->GetName() ? node->GetName() : "(null)")
+              << " instead of " << expectedName << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool CheckPresent(vtkMRMLScene* scene, vtkMRMLNode* node, bool expected, int line)
+{
+  bool present = (scene->IsNodePresent(node) != 0);
+  if (present != expected)
+    {
+    std::cerr << "Line " << line << ": node " << node->GetID()
+              << (expected ? " not in" : " in") << " the scene" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+bool TestModifyAddRemove()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  vtkNew<vtkMRMLModelNode> modelNode;
+  modelNode->SetName("Before");
+  scene->AddNode(modelNode.GetPointer());
+
+  // Modify
+  scene->SaveStateForUndo(modelNode.GetPointer());
+  modelNode->SetName("After");
+  scene->Undo();
+  if (!CheckName(modelNode.GetPointer(), "Before", __LINE__) ||
+      scene->GetNumberOfUndoLevels() != 0 || scene->GetNumberOfRedoLevels() != 1)
+    {
+    return false;
+    }
+  scene->Redo();
+  if (!CheckName(modelNode.GetPointer(), "After", __LINE__) ||
+      scene->GetNumberOfUndoLevels() != 1 || scene->GetNumberOfRedoLevels() != 0)
+    {
+    return false;
+    }
+
+  // Add
+  scene->SaveStateForUndo();
+  vtkNew<vtkMRMLModelNode> addedNode;
+  scene->AddNode(addedNode.GetPointer());
+  scene->Undo();
+  if (!CheckPresent(scene.GetPointer(), addedNode.GetPointer(), false, __LINE__))
+    {
+    return false;
+    }
+  scene->Redo();
+  if (!CheckPresent(scene.GetPointer(), addedNode.GetPointer(), true, __LINE__))
+    {
+    return false;
+    }
+
+  // Remove
+  std::string modelNodeID = modelNode->GetID();
+  scene->SaveStateForUndo();
+  scene->RemoveNode(modelNode.GetPointer());
+  scene->Undo();
+  if (!CheckPresent(scene.GetPointer(), modelNode.GetPointer(), true, __LINE__) ||
+      modelNodeID != modelNode->GetID())
+    {
+    return false;
+    }
+  scene->Redo();
+  if (!CheckPresent(scene.GetPointer(), modelNode.GetPointer(), false, __LINE__))
+    {
+    return false;
+    }
+
+  // Added then removed: nothing to undo
+  scene->Undo();
+  scene->SaveStateForUndo();
+  vtkNew<vtkMRMLModelNode> temporaryNode;
+  scene->AddNode(temporaryNode.GetPointer());
+  scene->RemoveNode(temporaryNode.GetPointer());
+  scene->Undo();
+  if (!CheckPresent(scene.GetPointer(), temporaryNode.GetPointer(), false, __LINE__) ||
+      !CheckPresent(scene.GetPointer(), modelNode.GetPointer(), true, __LINE__) ||
+      !CheckPresent(scene.GetPointer(), addedNode.GetPointer(), true, __LINE__))
+    {
+    return false;
+    }
+  return true;
+}
+
+//---------------------------------------------------------------------------
+void SetNewImageData(vtkMRMLScalarVolumeNode* volumeNode, int size)
+{
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  imageData->SetScalarTypeToShort();
+  imageData->SetNumberOfScalarComponents(1);
+  imageData->AllocateScalars();
+#else
+  imageData->AllocateScalars(VTK_SHORT, 1);
+#endif
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+}
+
+//---------------------------------------------------------------------------
+bool TestMemoryBudget()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  SetNewImageData(volumeNode.GetPointer(), 64);
+  scene->AddNode(volumeNode.GetPointer());
+  for (int i = 0; i < 20; ++i)
+    {
+    vtkNew<vtkMRMLModelNode> modelNode;
+    scene->AddNode(modelNode.GetPointer());
+    }
+
+  // Unmodified nodes and image data shared with the scene don't cost
+  // anything: saving the whole scene twice only costs the node copies.
+  scene->SaveStateForUndo();
+  vtkTypeUInt64 firstStateSize = scene->GetUndoStackMemorySize();
+  scene->SaveStateForUndo();
+  if (scene->GetUndoStackMemorySize() != firstStateSize ||
+      firstStateSize >= 64 * 64 * 64 * sizeof(short))
+    {
+    std::cerr << "Line " << __LINE__ << ": unexpected undo memory size: "
+              << scene->GetUndoStackMemorySize() << " (first state: "
+              << firstStateSize << ")" << std::endl;
+    return false;
+    }
+
+  // Each replaced image data is only referenced by the undo stack
+  const vtkTypeUInt64 budget = 2 * 1024 * 1024;
+  scene->SetUndoMemoryBudget(budget);
+  for (int i = 0; i < 10; ++i)
+    {
+    scene->SaveStateForUndo(volumeNode.GetPointer());
+    SetNewImageData(volumeNode.GetPointer(), 64);
+    }
+  std::cout << "<DartMeasurement name=\"UndoStackMemorySize\" type=\"numeric/double\">"
+            << scene->GetUndoStackMemorySize() << "</DartMeasurement>" << std::endl;
+  if (scene->GetUndoStackMemorySize() > budget ||
+      scene->GetNumberOfUndoLevels() < 2 || scene->GetNumberOfUndoLevels() >= 10)
+    {
+    std::cerr << "Line " << __LINE__ << ": budget not honored: "
+              << scene->GetUndoStackMemorySize() << " bytes for "
+              << scene->GetNumberOfUndoLevels() << " levels" << std::endl;
+    return false;
+    }
+
+  // The most recent states are kept
+  vtkImageData* lastImageData = volumeNode->GetImageData();
+  scene->SaveStateForUndo(volumeNode.GetPointer());
+  SetNewImageData(volumeNode.GetPointer(), 64);
+  scene->SaveStateForUndo(volumeNode.GetPointer());
+  SetNewImageData(volumeNode.GetPointer(), 64);
+  scene->Undo();
+  scene->Undo();
+  if (volumeNode->GetImageData() != lastImageData)
+    {
+    std::cerr << "Line " << __LINE__ << ": image data not restored" << std::endl;
+    return false;
+    }
+
+  scene->SetUndoMemoryBudget(0);
+  scene->SetUndoStackSize(3);
+  for (int i = 0; i < 10; ++i)
+    {
+    scene->SaveStateForUndo(volumeNode.GetPointer());
+    }
+  if (scene->GetNumberOfUndoLevels() != 3)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << scene->GetNumberOfUndoLevels()
+              << " undo levels instead of 3" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneUndoTest(int vtkNotUsed(argc), char * vtkNotUsed(argv) [] )
+{
+  bool res = true;
+  res = TestModifyAddRemove() && res;
+  res = TestMemoryBudget() && res;
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -99,6 +99,8 @@ vtkEventBroker::vtkEventBroker()
   this->LogFileName = NULL;
   this->ScriptHandler = NULL;
   this->ScriptHandlerClientData = NULL;
+  this->EventQueueSequence = 0;
+  this->NumberOfCoalescedEvents = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -141,6 +143,8 @@ void vtkEventBroker::DetachObservations()
       }
     }
   this->SubjectMap.clear();
+  this->EventQueue.clear();
+  this->EventQueuePositions.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -304,26 +308,11 @@ void vtkEventBroker::RemoveObservations (ObservationVector observations)
     observerObservations.erase(observerObservations.find(inObs));
     }
 
-  // remove from event queue
-  std::deque< vtkObservation *>::iterator queueIter;
-  for(queueIter=this->EventQueue.begin(); queueIter != this->EventQueue.end();)
-    {
-    // foreach of the broker's observations see if it is in the list of items to be removed
-    if (observations.find(*queueIter)!=observations.end())
-      {
-      // these event is related to the observations to be deleted
-      queueIter=this->EventQueue.erase(queueIter);
-      }
-    else
-      {
-      ++queueIter;
-      }
-    }
-
   // detach and delete each of the observations
   for(ObservationVector::iterator removeIter=observations.begin(); removeIter != observations.end(); removeIter++)
     {
-    (*removeIter)->SetInEventQueue( 0 );
+    // remove from event queue
+    this->RemoveQueuedObservation( *removeIter );
     this->DetachObservation( *removeIter );
     (*removeIter)->Delete();
     }
@@ -751,37 +740,47 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
   // can be invoked.
   // If the event is not currently in the queue, add it and keep a flag.
   //
-  vtkObservation::CallType call(eid, callData);
   if ( this->GetCompressCallData() &&
        observation->GetEvent() != vtkCommand::AnyEvent)
     {
-    observation->GetCallDataList()->clear();
-    observation->GetCallDataList()->push_back( call );
-    }
-  else
-    {
-    std::deque< vtkObservation::CallType >::const_iterator dataIter;
-    for(dataIter=observation->GetCallDataList()->begin();dataIter != observation->GetCallDataList()->end(); dataIter++)
+    if ( !observation->GetCallDataList()->empty() )
       {
-      if ( call.EventID == dataIter->EventID &&
-           call.CallData == dataIter->CallData)
-        {
-        break;
-        }
-      }
-    if ( dataIter == observation->GetCallDataList()->end() )
-      {
-      observation->GetCallDataList()->push_back( call );
+      this->NumberOfCoalescedEvents++;
       }
+    observation->ClearCallData();
+    observation->AddCallData( eid, callData );
+    }
+  else if ( !observation->AddCallData( eid, callData ) )
+    {
+    this->NumberOfCoalescedEvents++;
     }
 
   if ( !observation->GetInEventQueue() )
     {
-    this->EventQueue.push_back( observation );
+    QueuedObservation queuedObservation;
+    queuedObservation.Priority = observation->GetPriority();
+    queuedObservation.Sequence = this->EventQueueSequence++;
+    queuedObservation.Observation = observation;
+    this->EventQueuePositions[observation] =
+      this->EventQueue.insert( queuedObservation ).first;
     observation->SetInEventQueue(1);
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::RemoveQueuedObservation ( vtkObservation *observation )
+{
+  std::map< vtkObservation *, EventQueueType::iterator >::iterator position =
+    this->EventQueuePositions.find( observation );
+  if ( position != this->EventQueuePositions.end() )
+    {
+    this->EventQueue.erase( position->second );
+    this->EventQueuePositions.erase( position );
+    }
+  observation->ClearCallData();
+  observation->SetInEventQueue(0);
+}
+
 //----------------------------------------------------------------------------
 int vtkEventBroker::GetNumberOfQueuedObservations ()
 {
@@ -795,15 +794,20 @@ vtkObservation *vtkEventBroker::GetNthQueuedObservation ( int n )
     {
     return NULL;
     }
-  return (this->EventQueue[n]);
+  EventQueueType::const_iterator queueIter = this->EventQueue.begin();
+  std::advance( queueIter, n );
+  return queueIter->Observation;
 }
 
 //----------------------------------------------------------------------------
 vtkObservation *vtkEventBroker::DequeueObservation ()
 {
-  vtkObservation *observation = this->EventQueue.front();
-  this->EventQueue.pop_front();
-  observation->SetInEventQueue(0);
+  if ( this->EventQueue.empty() )
+    {
+    return NULL;
+    }
+  vtkObservation *observation = this->EventQueue.begin()->Observation;
+  this->RemoveQueuedObservation( observation );
   return( observation );
 }
 
@@ -851,36 +855,54 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
 
 //----------------------------------------------------------------------------
 void vtkEventBroker::ProcessEventQueue ()
+{
+  this->ProcessEventQueue( 0.0 );
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::ProcessEventQueue (double timeSlice)
 {
   //
-  // for each observation on the event queue,
+  // for each observation on the event queue (highest priority first),
   // invoke it with each of the stored callData pointers
   // - register your pointer to the observation in case it
   //   gets deleted during handling of the event
-  // - if the observation is no longer in the queue, stop processing events
-  // - unregister before after dequeing in case the observation should go away
+  // - calls queued while the observation is being invoked are
+  //   appended to its list and invoked in the same pass
+  // - if the observation is no longer in the queue (it was removed by a
+  //   callback), stop processing its events
+  // - if a time slice is given, stop when it is exhausted and leave the
+  //   remaining calls in the queue
   //
-  while ( this->GetNumberOfQueuedObservations() > 0 )
+  double startTime = this->TimerLog->GetUniversalTime();
+  while ( !this->EventQueue.empty() )
     {
-    vtkObservation *observation = this->EventQueue.front();
+    vtkObservation *observation = this->EventQueue.begin()->Observation;
     observation->Register( this );
-    int finished = 0;
-    while ( !finished )
+    while ( observation->GetInEventQueue() &&
+            !observation->GetCallDataList()->empty() )
       {
-      vtkObservation::CallType call = observation->GetCallDataList()->front();
-      observation->GetCallDataList()->pop_front();
-      finished = (observation->GetCallDataList()->size() == 0);
+      vtkObservation::CallType call = observation->PopCallData();
       this->InvokeObservation( observation, call.EventID, call.CallData );
-      if ( !observation->GetInEventQueue() )
+      if ( timeSlice > 0. &&
+           this->TimerLog->GetUniversalTime() - startTime >= timeSlice )
         {
-        observation->GetCallDataList()->clear();
-        finished = 1;
         break;
         }
       }
-    this->DequeueObservation();
+    if ( observation->GetInEventQueue() &&
+         observation->GetCallDataList()->empty() )
+      {
+      this->RemoveQueuedObservation( observation );
+      }
     observation->Delete();
+    if ( timeSlice > 0. &&
+         this->TimerLog->GetUniversalTime() - startTime >= timeSlice )
+      {
+      break;
+      }
     }
+  return this->GetNumberOfQueuedObservations();
 }
 
 //----------------------------------------------------------------------------
@@ -890,6 +912,7 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
 
   os << indent << "NumberOfObservations: " << this->GetNumberOfObservations() << "\n";
   os << indent << "NumberOfQueueObservations: " << this->GetNumberOfQueuedObservations() << "\n";
+  os << indent << "NumberOfCoalescedEvents: " << this->NumberOfCoalescedEvents << "\n";
   os << indent << "EventMode: " << this->GetEventModeAsString() << "\n";
   os << indent << "EventLogging: " << this->EventLogging << "\n";
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
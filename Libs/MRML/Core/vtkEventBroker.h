@@ -23,7 +23,6 @@
 class vtkTimerLog;
 
 // STD includes
-#include <deque>
 #include <vector>
 #include <set>
 #include <map>
@@ -208,19 +207,42 @@ public:
   ///
   /// Event queue handling routines
   /// Note:
-  /// - assume here that the information in a vtkObservation contains enough
-  /// information for the observer to handle the event (that is, we don't pass
-  /// the callData field of the event back)
-  /// TODO: if the callData is needed, we will need another class/struct to
-  /// go into the event queue that saves them
+  /// - the observations are queued by decreasing priority, then in the
+  /// order they were triggered.
+  /// - an observation is in the queue at most once, with the list of call
+  /// data it was triggered with (see CompressCallData).
+  /// - queueing and dequeueing an observation are O(log n) in the number of
+  /// queued observations (std::set and std::map). Merging an event with the
+  /// pending calls of its observation is O(1) if it repeats the last call,
+  /// O(log m) in the number m of pending calls otherwise. A hash table
+  /// keyed by (subject, event) would make all merges O(1), but neither C++98
+  /// nor the MRML libraries provide one, so ordered containers are used.
   void QueueObservation (vtkObservation *observation, unsigned long eid,
                          void *callData);
   int GetNumberOfQueuedObservations ();
+  /// Return the observation at position n in the queue, NULL if out of range.
+  /// O(n): the queue is walked from its head, use DequeueObservation() to
+  /// consume it.
   vtkObservation *GetNthQueuedObservation (int n);
+  /// Remove the next observation from the queue and discard its pending
+  /// calls. Return NULL if the queue is empty.
   vtkObservation *DequeueObservation ();
   void InvokeObservation (vtkObservation *observation, unsigned long eid,
                           void *callData);
+  /// Invoke all the queued observations.
   void ProcessEventQueue ();
+  /// Invoke the queued observations until the queue is empty or until
+  /// timeSlice seconds have elapsed, whichever comes first. At least one
+  /// call is invoked per slice. Return the number of observations still in
+  /// the queue, so that the application can process them later (e.g. in an
+  /// idle timer) and remain responsive.
+  int ProcessEventQueue (double timeSlice);
+
+  ///
+  /// Number of events that were merged with an event already in the queue
+  /// since the last reset.
+  vtkGetMacro (NumberOfCoalescedEvents, unsigned long);
+  vtkSetMacro (NumberOfCoalescedEvents, unsigned long);
 
   ///
   /// two modes -
@@ -272,8 +294,30 @@ protected:
   ObjectToObservationVectorMap SubjectMap;
   ObjectToObservationVectorMap ObserverMap;
 
-  /// The event queue of triggered but not-yet-invoked observations
-  std::deque< vtkObservation * > EventQueue;
+  /// The event queue of triggered but not-yet-invoked observations,
+  /// ordered by decreasing priority then by increasing sequence number.
+  /// Insertions and removals are O(log n).
+  struct QueuedObservation
+  {
+    float Priority;
+    unsigned long Sequence;
+    vtkObservation *Observation;
+    bool operator<(const QueuedObservation& other) const
+    {
+      return this->Priority > other.Priority ||
+        (this->Priority == other.Priority && this->Sequence < other.Sequence);
+    }
+  };
+  typedef std::set< QueuedObservation > EventQueueType;
+  EventQueueType EventQueue;
+  /// Position of each queued observation in the event queue, found in
+  /// O(log n) to remove an observation from the middle of the queue
+  std::map< vtkObservation *, EventQueueType::iterator > EventQueuePositions;
+  unsigned long EventQueueSequence;
+  unsigned long NumberOfCoalescedEvents;
+
+  /// Remove an observation from the event queue if it is queued.
+  void RemoveQueuedObservation (vtkObservation *observation);
 
   void (*ScriptHandler) (const char* script, void* clientData);
   void *ScriptHandlerClientData;
@@ -26,8 +26,10 @@
 #include <vtkOBJReader.h>
 #include <vtkPLYReader.h>
 #include <vtkPLYWriter.h>
+#include <vtkPolyData.h>
 #include <vtkPolyDataReader.h>
 #include <vtkPolyDataWriter.h>
+#include <vtkSmartPointer.h>
 #include <vtkSTLReader.h>
 #include <vtkSTLWriter.h>
 #include <vtkStringArray.h>
@@ -98,6 +100,70 @@ bool vtkMRMLModelStorageNode::CanReadInReferenceNode(vtkMRMLNode *refNode)
   return refNode->IsA("vtkMRMLModelNode");
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+
+//----------------------------------------------------------------------------
+template <class ReaderType>
+vtkSmartPointer<vtkObject> ReadPolyData(ReaderType* reader, const std::string& fileName)
+{
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  if (reader->GetOutput() == NULL || reader->GetOutput()->GetNumberOfPoints() == 0)
+    {
+    return NULL;
+    }
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->ShallowCopy(reader->GetOutput());
+  return polyData.GetPointer();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLModelStorageNode::PrefetchDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !vtksys::SystemTools::FileExists(fullName.c_str()))
+    {
+    return NULL;
+    }
+  // Other formats are read by ReadDataInternal()
+  std::string extension = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  if (extension == std::string(".vtk"))
+    {
+    vtkNew<vtkPolyDataReader> reader;
+    reader->SetFileName(fullName.c_str());
+    if (!reader->IsFilePolyData())
+      {
+      return NULL;
+      }
+    return ReadPolyData(reader.GetPointer(), fullName);
+    }
+  else if (extension == std::string(".vtp"))
+    {
+    vtkNew<vtkXMLPolyDataReader> reader;
+    return ReadPolyData(reader.GetPointer(), fullName);
+    }
+  else if (extension == std::string(".stl"))
+    {
+    vtkNew<vtkSTLReader> reader;
+    return ReadPolyData(reader.GetPointer(), fullName);
+    }
+  else if (extension == std::string(".ply"))
+    {
+    vtkNew<vtkPLYReader> reader;
+    return ReadPolyData(reader.GetPointer(), fullName);
+    }
+  else if (extension == std::string(".obj"))
+    {
+    vtkNew<vtkOBJReader> reader;
+    return ReadPolyData(reader.GetPointer(), fullName);
+    }
+  return NULL;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -127,10 +193,16 @@ int vtkMRMLModelStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   vtkDebugMacro("ReadDataInternal: extension = " << extension.c_str());
 
+  vtkPolyData* prefetchedPolyData = vtkPolyData::SafeDownCast(this->PrefetchedData);
+
   int result = 1;
   try
     {
-    if ( extension == std::string(".g") || extension == std::string(".byu") )
+    if (prefetchedPolyData)
+      {
+      modelNode->SetAndObservePolyData(prefetchedPolyData);
+      }
+    else if ( extension == std::string(".g") || extension == std::string(".byu") )
       {
       vtkNew<vtkBYUReader> reader;
       reader->SetGeometryFileName(fullName.c_str());
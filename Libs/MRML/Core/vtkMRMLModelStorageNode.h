@@ -54,6 +54,9 @@ protected:
   /// Read data and set it in the referenced node
   virtual int ReadDataInternal(vtkMRMLNode *refNode);
 
+  /// Read the VTK, STL, PLY and OBJ model files into a vtkPolyData
+  virtual vtkSmartPointer<vtkObject> PrefetchDataInternal(vtkMRMLNode *refNode);
+
   /// Write data from a  referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
@@ -39,6 +39,7 @@ vtkMRMLNodeNewMacro(vtkMRMLNRRDStorageNode);
 vtkMRMLNRRDStorageNode::vtkMRMLNRRDStorageNode()
 {
   this->CenterImage = 0;
+  this->CompressionLevel = -1;
 }
 
 //----------------------------------------------------------------------------
@@ -55,6 +56,7 @@ void vtkMRMLNRRDStorageNode::WriteXML(ostream& of, int nIndent)
   std::stringstream ss;
   ss << this->CenterImage;
   of << indent << " centerImage=\"" << ss.str() << "\"";
+  of << indent << " compressionLevel=\"" << this->CompressionLevel << "\"";
 
 }
 
@@ -77,6 +79,14 @@ void vtkMRMLNRRDStorageNode::ReadXMLAttributes(const char** atts)
       ss << attValue;
       ss >> this->CenterImage;
       }
+    else if (!strcmp(attName, "compressionLevel"))
+      {
+      std::stringstream ss;
+      ss << attValue;
+      int compressionLevel = -1;
+      ss >> compressionLevel;
+      this->SetCompressionLevel(compressionLevel);
+      }
     }
 
   this->EndModify(disabledModify);
@@ -94,6 +104,7 @@ void vtkMRMLNRRDStorageNode::Copy(vtkMRMLNode *anode)
   vtkMRMLNRRDStorageNode *node = (vtkMRMLNRRDStorageNode *) anode;
 
   this->SetCenterImage(node->CenterImage);
+  this->SetCompressionLevel(node->CompressionLevel);
 
   this->EndModify(disabledModify);
 
@@ -104,6 +115,7 @@ void vtkMRMLNRRDStorageNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   vtkMRMLStorageNode::PrintSelf(os,indent);
   os << indent << "CenterImage:   " << this->CenterImage << "\n";
+  os << indent << "CompressionLevel:   " << this->CompressionLevel << "\n";
 }
 
 //----------------------------------------------------------------------------
@@ -379,6 +391,7 @@ int vtkMRMLNRRDStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   writer->SetInputConnection(volNode->GetImageDataConnection());
 #endif
   writer->SetUseCompression(this->GetUseCompression());
+  writer->SetCompressionLevel(this->GetCompressionLevel());
 
   // set volume attributes
   writer->SetIJKToRASMatrix(ijkToRas.GetPointer());
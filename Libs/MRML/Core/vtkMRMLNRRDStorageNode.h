@@ -53,6 +53,14 @@ class VTK_MRML_EXPORT vtkMRMLNRRDStorageNode : public vtkMRMLStorageNode
   vtkGetMacro(CenterImage, int);
   vtkSetMacro(CenterImage, int);
 
+  ///
+  /// zlib compression level used on write when UseCompression is on,
+  /// from 1 (fastest) to 9 (smallest file). -1 (default) uses the zlib
+  /// default level. The data is compressed by multiple threads.
+  /// \sa vtkNRRDWriter::SetCompressionLevel()
+  vtkGetMacro(CompressionLevel, int);
+  vtkSetClampMacro(CompressionLevel, int, -1, 9);
+
   ///
   /// Access the nrrd header fields to create a diffusion gradient table
   int ParseDiffusionInformation(vtkNRRDReader *reader,vtkDoubleArray *grad,vtkDoubleArray *bvalues);
@@ -89,6 +97,7 @@ protected:
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
   int CenterImage;
+  int CompressionLevel;
 
 };
 
@@ -863,6 +863,34 @@ void vtkMRMLNode::SetAddToSceneNoModify(int value)
    this->AddToScene = value;
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLNode::SetName(const char* name)
+{
+  // Mostly copied from vtkSetStringMacro() in vtkSetGet.cxx
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting Name to " << (name?name:"(null)") );
+  if ( this->Name == NULL && name == NULL) { return;}
+  if ( this->Name && name && (!strcmp(this->Name,name))) { return;}
+  char* oldName = this->Name;
+  if (name)
+    {
+    size_t n = strlen(name) + 1;
+    char *cp1 =  new char[n];
+    const char *cp2 = (name);
+    this->Name = cp1;
+    do { *cp1++ = *cp2++; } while ( --n );
+    }
+   else
+    {
+    this->Name = NULL;
+    }
+  if (this->Scene)
+    {
+    this->Scene->NodeNameChanged(this, oldName);
+    }
+  if (oldName) { delete [] oldName; }
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLNode::SetID (const char* _arg)
 {
@@ -321,7 +321,8 @@ public:
   vtkGetStringMacro(SceneRootDir);
 
   /// Name of this node, to be set by the user.
-  vtkSetStringMacro(Name);
+  /// The scene name index is updated when the name changes.
+  virtual void SetName(const char* name);
   vtkGetStringMacro(Name);
 
 
@@ -48,6 +48,7 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLSliceCompositeNode.h"
 #include "vtkMRMLSliceNode.h"
 #include "vtkMRMLSnapshotClipNode.h"
+#include "vtkMRMLStorableNode.h"
 #include "vtkMRMLTransformDisplayNode.h"
 #include "vtkMRMLTransformStorageNode.h"
 #include "vtkMRMLUnstructuredGridDisplayNode.h"
@@ -56,6 +57,7 @@ Version:   $Revision: 1.18 $
 #include "vtkMRMLVectorVolumeDisplayNode.h"
 #include "vtkMRMLViewNode.h"
 #include "vtkMRMLVolumeArchetypeStorageNode.h"
+#include "vtkMRMLVolumeNode.h"
 #include "vtkURIHandler.h"
 #include "vtkMRMLLayoutNode.h"
 
@@ -77,8 +79,14 @@ Version:   $Revision: 1.18 $
 #include <vtkCollection.h>
 #include <vtkDebugLeaks.h>
 #include <vtkErrorCode.h>
+#include <vtkImageData.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
 
 // VTKSYS includes
 #include <vtksys/RegularExpression.hxx>
@@ -91,10 +99,6 @@ Version:   $Revision: 1.18 $
 
 //#define MRMLSCENE_VERBOSE
 
-#ifdef MRMLSCENE_VERBOSE
-# include <vtkTimerLog.h>
-#endif
-
 vtkCxxSetObjectMacro(vtkMRMLScene, CacheManager, vtkCacheManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, DataIOManager, vtkDataIOManager)
 vtkCxxSetObjectMacro(vtkMRMLScene, UserTagTable, vtkTagTable)
@@ -104,6 +108,8 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 vtkMRMLScene::vtkMRMLScene()
 {
   this->NodeIDsMTime = 0;
+  this->NextIndexedNodePosition = 0;
+  this->NodeIndexesMTime = 0;
   this->SceneModifiedTime = 0;
 
   this->RegisteredNodeClasses.clear();
@@ -112,6 +118,7 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->Nodes =  vtkCollection::New();
   this->UndoStackSize = 100;
+  this->UndoMemoryBudget = 0;
   this->UndoFlag = false;
   this->InUndo = false;
 
@@ -130,6 +137,9 @@ vtkMRMLScene::vtkMRMLScene()
   this->SaveToXMLString = 0;
 
   this->ReadDataOnLoad = 1;
+  this->NumberOfImportThreads = 1;
+  this->LastImportTime = 0.;
+  this->LastImportReadTime = 0.;
 
   this->LastLoadedVersion = NULL;
   this->Version = NULL;
@@ -658,6 +668,8 @@ int vtkMRMLScene::Import()
   vtkTimerLog* timer = vtkTimerLog::New();
   timer->StartTimer();
 #endif
+  const double importStartTime = vtkTimerLog::GetUniversalTime();
+  this->LastImportReadTime = 0.;
   this->SetErrorCode(0);
   this->SetErrorMessage(std::string(""));
 
@@ -705,6 +717,13 @@ int vtkMRMLScene::Import()
 
     this->InvokeEvent(vtkMRMLScene::NewSceneEvent, NULL);
 
+    if (this->NumberOfImportThreads > 1)
+      {
+      const double readStartTime = vtkTimerLog::GetUniversalTime();
+      this->PrefetchStorableNodesData(loadedNodes);
+      this->LastImportReadTime = vtkTimerLog::GetUniversalTime() - readStartTime;
+      }
+
     // Notify the imported nodes about that all nodes are created
     // (so the observers can be attached to referenced nodes, etc.)
     // by calling UpdateScene on each node
@@ -770,10 +789,94 @@ int vtkMRMLScene::Import()
   importingTimer->Delete();
   timer->Delete();
 #endif
+  this->LastImportTime = vtkTimerLog::GetUniversalTime() - importStartTime;
   this->StoredTime.Modified();
   return returnCode;
 }
 
+//------------------------------------------------------------------------------
+namespace
+{
+
+//------------------------------------------------------------------------------
+struct PrefetchJobsType
+{
+  std::vector<vtkMRMLStorageNode*> StorageNodes;
+  std::vector<vtkMRMLNode*> Nodes;
+  size_t NextJob;
+  vtkMutexLock* Lock;
+};
+
+//------------------------------------------------------------------------------
+// Threads take the next file to read until there is none left: file sizes
+// vary too much for a static split.
+VTK_THREAD_RETURN_TYPE vtkMRMLScenePrefetchData(void *arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  PrefetchJobsType* jobs = static_cast<PrefetchJobsType*>(info->UserData);
+  while (true)
+    {
+    jobs->Lock->Lock();
+    size_t job = jobs->NextJob++;
+    jobs->Lock->Unlock();
+    if (job >= jobs->StorageNodes.size())
+      {
+      break;
+      }
+    jobs->StorageNodes[job]->PrefetchData(jobs->Nodes[job]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::PrefetchStorableNodesData(vtkCollection* nodes)
+{
+  if (!this->GetReadDataOnLoad())
+    {
+    return;
+    }
+  PrefetchJobsType jobs;
+  // A storage node can't be read concurrently
+  std::set<vtkMRMLStorageNode*> storageNodes;
+  vtkMRMLNode *node = NULL;
+  vtkCollectionSimpleIterator it;
+  for (nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)nodes->GetNextItemAsObject(it)) ;)
+    {
+    vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(node);
+    if (!storableNode || !storableNode->GetAddToScene())
+      {
+      continue;
+      }
+    for (int i = 0; i < storableNode->GetNumberOfStorageNodes(); ++i)
+      {
+      vtkMRMLStorageNode* storageNode = storableNode->GetNthStorageNode(i);
+      if (storageNode && storageNode->CanPrefetchData(storableNode) &&
+          storageNodes.insert(storageNode).second)
+        {
+        jobs.StorageNodes.push_back(storageNode);
+        jobs.Nodes.push_back(storableNode);
+        }
+      }
+    }
+  if (jobs.StorageNodes.size() < 2)
+    {
+    return;
+    }
+  vtkNew<vtkMutexLock> lock;
+  jobs.NextJob = 0;
+  jobs.Lock = lock.GetPointer();
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(
+    std::min(this->NumberOfImportThreads, static_cast<int>(jobs.StorageNodes.size())));
+  threader->SetSingleMethod(vtkMRMLScenePrefetchData, &jobs);
+  threader->SingleMethodExecute();
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLScene::LoadIntoScene(vtkCollection* nodeCollection)
 {
@@ -1098,10 +1201,14 @@ vtkMRMLNode*  vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
     n->SetName(this->GenerateUniqueName(n).c_str());
     }
   n->SetScene( this );
+  this->UpdateNodeIndexes();
   this->Nodes->vtkCollection::AddItem((vtkObject *)n);
 
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->RecordNodeAddedForUndo(n);
+  this->AddNodeToIndexes(n);
+  this->NodeIndexesMTime = this->Nodes->GetMTime();
 
   //n->OnNodeAddedToScene();
 
@@ -1228,10 +1335,14 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     {
     n->SetScene(0);
     }
+  this->UpdateNodeIndexes();
   this->Nodes->vtkCollection::RemoveItem((vtkObject *)n);
 
   std::string nid=n->GetID();
   this->RemoveNodeID(n->GetID());
+  this->RemoveNodeFromIndexes(n);
+  this->NodeIndexesMTime = this->Nodes->GetMTime();
+  this->RecordNodeRemovedForUndo(n);
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
@@ -1408,18 +1519,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetIndexedNodesByClass(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1430,16 +1530,8 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
-    }
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(className);
+  nodes.insert(nodes.end(), classNodes.begin(), classNodes.end());
   return static_cast<int>(nodes.size());
 }
 
@@ -1452,15 +1544,11 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return 0;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator it = classNodes.begin();
+       it != classNodes.end(); ++it)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(*it);
     }
   return nodes;
 }
@@ -1516,13 +1604,12 @@ vtkMRMLNode* vtkMRMLScene::GetSingletonNode(const char* singletonTag, const char
   assert(singletonTag);
   assert(className);
 
-  vtkCollectionSimpleIterator it;
-  vtkMRMLNode* node = NULL;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator it = classNodes.begin();
+       it != classNodes.end(); ++it)
     {
-    if (node->IsA(className) &&
-        node->GetSingletonTag() != NULL &&
+    vtkMRMLNode* node = *it;
+    if (node->GetSingletonTag() != NULL &&
         strcmp(node->GetSingletonTag(), singletonTag) == 0)
       {
       return node;
@@ -1590,22 +1677,12 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return NULL;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(className);
+  if (n >= static_cast<int>(classNodes.size()))
     {
-    if (node->IsA(className))
-      {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
-      }
+    return NULL;
     }
-  return NULL;
+  return classNodes[n];
 }
 
 //------------------------------------------------------------------------------
@@ -1619,50 +1696,74 @@ vtkCollection* vtkMRMLScene::GetNodesByName(const char* name)
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  this->UpdateNodeIndexes();
+  std::map< std::string, OrderedNodesType >::iterator nameIt =
+    this->NodesByName.find(name);
+  if (nameIt != this->NodesByName.end())
     {
-    if (!strcmp(node->GetName(), name))
+    for (OrderedNodesType::iterator it = nameIt->second.begin();
+         it != nameIt->second.end(); ++it)
       {
-      nodes->AddItem(node);
+      nodes->AddItem(it->second);
       }
     }
   return nodes;
 }
 
+//-----------------------------------------------------------------------------
+namespace
+{
+bool IsNodeMatching(vtkMRMLNode* node, const char* byName,
+                    const int* byHideFromEditors, bool exactNameMatch)
+{
+  if (exactNameMatch && byName &&
+      node->GetName() != 0 && strcmp(node->GetName(), byName) != 0)
+    {
+    return false;
+    }
+  if (!exactNameMatch && byName &&
+      node->GetName() != 0 && !vtksys::RegularExpression(byName).find(node->GetName()))
+    {
+    return false;
+    }
+  if (byHideFromEditors && node->GetHideFromEditors() != *byHideFromEditors)
+    {
+    return false;
+    }
+  return true;
+}
+}
+
 //-----------------------------------------------------------------------------
 vtkMRMLNode* vtkMRMLScene::GetFirstNode(const char* byName,
                                         const char* byClass,
                                         const int* byHideFromEditors,
                                         bool exactNameMatch)
 {
+  if (byClass)
+    {
+    // Only visit the nodes of the requested class
+    const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(byClass);
+    for (std::vector<vtkMRMLNode*>::const_iterator it = classNodes.begin();
+         it != classNodes.end(); ++it)
+      {
+      if (IsNodeMatching(*it, byName, byHideFromEditors, exactNameMatch))
+        {
+        return *it;
+        }
+      }
+    return 0;
+    }
   vtkCollectionSimpleIterator it;
   vtkMRMLNode* node;
   for (this->Nodes->InitTraversal(it);
        (node= vtkMRMLNode::SafeDownCast(
           this->Nodes->GetNextItemAsObject(it))) ;)
     {
-    if (exactNameMatch && byName &&
-        node->GetName() != 0 && strcmp(node->GetName(), byName) != 0)
-      {
-      continue;
-      }
-    if (!exactNameMatch && byName &&
-        node->GetName() != 0 && !vtksys::RegularExpression(byName).find(node->GetName()))
-      {
-      continue;
-      }
-    if (byClass && !node->IsA(byClass))
+    if (IsNodeMatching(node, byName, byHideFromEditors, exactNameMatch))
       {
-      continue;
-      }
-    if (byHideFromEditors && node->GetHideFromEditors() != *byHideFromEditors)
-      {
-      continue;
+      return node;
       }
-    return node;
     }
   return 0;
 }
@@ -1677,16 +1778,14 @@ vtkMRMLNode* vtkMRMLScene::GetFirstNodeByName(const char* name)
     return node;
     }
 
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  this->UpdateNodeIndexes();
+  std::map< std::string, OrderedNodesType >::iterator nameIt =
+    this->NodesByName.find(name);
+  if (nameIt == this->NodesByName.end() || nameIt->second.empty())
     {
-    if (node->GetName() != 0 && !strcmp(node->GetName(), name))
-      {
-      return node;
-      }
+    return 0;
     }
-  return 0;
+  return nameIt->second.begin()->second;
 }
 
 //------------------------------------------------------------------------------
@@ -1751,13 +1850,18 @@ vtkCollection* vtkMRMLScene::GetNodesByClassByName(const char* className, const
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  for (int n=0; n < this->Nodes->GetNumberOfItems(); n++)
+  this->UpdateNodeIndexes();
+  std::map< std::string, OrderedNodesType >::iterator nameIt =
+    this->NodesByName.find(name);
+  if (nameIt != this->NodesByName.end())
     {
-    node = (vtkMRMLNode*)this->Nodes->GetItemAsObject(n);
-    if (!strcmp(node->GetName(), name) && node->IsA(className))
+    for (OrderedNodesType::iterator it = nameIt->second.begin();
+         it != nameIt->second.end(); ++it)
       {
-      nodes->AddItem(node);
+      if (it->second->IsA(className))
+        {
+        nodes->AddItem(it->second);
+        }
       }
     }
 
@@ -1847,6 +1951,7 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->RecordNodeAddedForUndo(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -1933,6 +2038,7 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  this->RecordNodeAddedForUndo(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -1953,6 +2059,9 @@ void vtkMRMLScene::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "ErrorCode = " << this->ErrorCode << "\n";
   os << indent << "URL = " << this->GetURL() << "\n";
   os << indent << "Root Directory = " << this->GetRootDirectory() << "\n";
+  os << indent << "NumberOfImportThreads = " << this->NumberOfImportThreads << "\n";
+  os << indent << "LastImportTime = " << this->LastImportTime << "\n";
+  os << indent << "LastImportReadTime = " << this->LastImportReadTime << "\n";
 
   this->Nodes->vtkCollection::PrintSelf(os,indent);
   std::list<std::string> classes = this->GetNodeClassesList();
@@ -2166,7 +2275,7 @@ void vtkMRMLScene::RemoveReservedIDs()
 }
 
 //------------------------------------------------------------------------------
-// Pushes the current scene onto the undo stack, and makes a backup copy of the
+// Pushes a new state onto the undo stack, and makes a backup copy of the
 // passed node so that changes to the node are undoable; several signatures to handle
 // individual nodes or a vtkCollection of nodes, or a vector of nodes
 //
@@ -2194,6 +2303,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
     {
     this->CopyNodeInUndoStack(node);
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2225,6 +2335,7 @@ void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2264,6 +2375,7 @@ void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
       this->CopyNodeInUndoStack(node);
       }
     }
+  this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
@@ -2285,63 +2397,22 @@ void vtkMRMLScene::SaveStateForUndo ()
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to all the nodes in the current scene
+// Push an empty state: the nodes to restore are copied with
+// CopyNodeInUndoStack() and the nodes added or removed afterward are recorded
+// with RecordNodeAddedForUndo() and RecordNodeRemovedForUndo().
 void vtkMRMLScene::PushIntoUndoStack()
 {
-  if (this->Nodes == NULL)
-    {
-    return;
-    }
-
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
-
-  int nnodes = currentScene->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
-      {
-      newScene->AddItem(node);
-      }
-    }
-
-  //TODO check max stack size
-  this->UndoStack.push_back(newScene);
+  this->UndoStack.push_back(new UndoStateType);
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to the current scene nodes
 void vtkMRMLScene::PushIntoRedoStack()
 {
-  if (this->Nodes == NULL)
-    {
-    return;
-    }
-
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
-
-  int nnodes = currentScene->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
-      {
-      newScene->AddItem(node);
-      }
-    }
-
-  //TODO check max stack size
-  this->RedoStack.push_back(newScene);
+  this->RedoStack.push_back(new UndoStateType);
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the undoable copy of the scene so that the node
+// Put a copy of the node into the last undo state so that the node
 // can be edited
 void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
 {
@@ -2350,28 +2421,20 @@ void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
     vtkErrorMacro("CopyNodeInUndoStack: node is null");
     return;
     }
-
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
+  if (this->UndoStack.empty())
     {
-    snode->CopyWithScene(copyNode);
+    return;
     }
-  vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  UndoStateType* previousState = 0;
+  if (this->UndoStack.size() > 1)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
-      {
-      undoScene->ReplaceItem (n, snode);
-      break;
-      }
+    previousState = *(++this->UndoStack.rbegin());
     }
-  snode->Delete();
+  this->CopyNodeInUndoState(copyNode, this->UndoStack.back(), previousState);
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the redoable copy of the scene so that the node
+// Put a copy of the node into the last redo state so that the node
 // can be replaced by the Undo version
 void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
 {
@@ -2380,150 +2443,171 @@ void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
     vtkErrorMacro("CopyNodeInRedoStack: node is null");
     return;
     }
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != NULL)
+  if (this->RedoStack.empty())
     {
-    snode->CopyWithSceneWithSingleModifiedEvent(copyNode);
+    return;
     }
-  vtkCollection* undoScene = dynamic_cast < vtkCollection *>( this->RedoStack.back() );
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  this->CopyNodeInUndoState(copyNode, this->RedoStack.back());
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::CopyNodeInUndoState(vtkMRMLNode *node,
+                                       UndoStateType* state,
+                                       UndoStateType* previousState)
+{
+  if (!node || !node->GetID() || !state)
+    {
+    return;
+    }
+  std::string id(node->GetID());
+  if (state->NodeCopies.find(id) != state->NodeCopies.end())
+    {
+    // the node has already been saved in this state
+    return;
+    }
+  if (previousState && node->GetModifiedEventPending() == 0)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
+    std::map< std::string, UndoStateNodeCopyType >::iterator previousCopyIt =
+      previousState->NodeCopies.find(id);
+    if (previousCopyIt != previousState->NodeCopies.end() &&
+        previousCopyIt->second.NodeMTime == node->GetMTime() &&
+        strcmp(previousCopyIt->second.Copy->GetClassName(), node->GetClassName()) == 0)
       {
-      undoScene->ReplaceItem (n, snode);
-      break;
+      // The node has not been modified since the previous state was saved,
+      // the copy can be shared.
+      state->NodeCopies[id] = previousCopyIt->second;
+      return;
       }
     }
-  snode->Delete();
+  UndoStateNodeCopyType nodeCopy;
+  nodeCopy.Copy = vtkSmartPointer<vtkMRMLNode>::Take(node->CreateNodeInstance());
+  if (nodeCopy.Copy.GetPointer() == 0)
+    {
+    vtkErrorMacro("CopyNodeInUndoState: failed to instantiate a "
+                  << node->GetClassName());
+    return;
+    }
+  // Bulk data (image data, poly data...) is shared by reference.
+  nodeCopy.Copy->CopyWithScene(node);
+  nodeCopy.NodeMTime = node->GetMTime();
+  state->NodeCopies[id] = nodeCopy;
 }
 
 //------------------------------------------------------------------------------
-// Replace the current scene by the top of the undo stack
-// -- move the current scene on the redo stack
-void vtkMRMLScene::Undo()
+void vtkMRMLScene::RecordNodeAddedForUndo(vtkMRMLNode *node)
 {
-  if (!this->UndoFlag)
+  if (this->InUndo || this->IsClosing() || this->UndoStack.empty() ||
+      !node || node->IsA("vtkMRMLSceneViewNode"))
     {
     return;
     }
+  this->UndoStack.back()->AddedNodes.push_back(node);
+}
 
-  if (this->UndoStack.size() == 0)
+//------------------------------------------------------------------------------
+void vtkMRMLScene::RecordNodeRemovedForUndo(vtkMRMLNode *node)
+{
+  if (this->InUndo || this->IsClosing() || this->UndoStack.empty() ||
+      !node || node->IsA("vtkMRMLSceneViewNode"))
     {
     return;
     }
-
-  this->RemoveUnusedNodeReferences();
-
-  this->InUndo = true;
-
-  int nnodes;
-  int n;
-  unsigned int nn;
-
-  PushIntoRedoStack();
-
-  vtkCollection* currentScene = this->Nodes;
-  // We use 2 vectors instead of a map in order to keep the ordering of the
-  // nodes.
-  std::vector<std::string> currentIDs;
-  std::vector<vtkMRMLNode*> currentNodes;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
+  UndoStateType* state = this->UndoStack.back();
+  for (std::vector< vtkSmartPointer<vtkMRMLNode> >::iterator it =
+         state->AddedNodes.begin(); it != state->AddedNodes.end(); ++it)
     {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
+    if (it->GetPointer() == node)
       {
-      currentIDs.push_back(node->GetID());
-      currentNodes.push_back(node);
+      // The node didn't exist when the state was saved, there is nothing
+      // to restore.
+      state->AddedNodes.erase(it);
+      return;
       }
     }
+  state->RemovedNodes.push_back(node);
+}
 
-  vtkCollection* undoScene = NULL;
-  std::vector<std::string> undoIDs;
-  std::vector<vtkMRMLNode*> undoNodes;
-
-  if (!this->UndoStack.empty())
+//------------------------------------------------------------------------------
+void vtkMRMLScene::ApplyUndoState(UndoStateType* state, UndoStateType* inverseState)
+{
+  std::vector< vtkSmartPointer<vtkMRMLNode> >::iterator it;
+  // remove the nodes added after the state was saved
+  for (it = state->AddedNodes.begin(); it != state->AddedNodes.end(); ++it)
     {
-    undoScene = dynamic_cast < vtkCollection *>( this->UndoStack.back() );
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
+    vtkMRMLNode* nodeToRemove = *it;
+    // Maybe the node has been removed already by a side effect of a previous
+    // node removal.
+    if (nodeToRemove->GetID() == 0 ||
+        this->GetNodeByID(nodeToRemove->GetID()) != nodeToRemove)
       {
-      vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-      if (node && !node->IsA("vtkMRMLSceneViewNode"))
-        {
-        undoIDs.push_back(node->GetID());
-        undoNodes.push_back(node);
-        }
+      continue;
+      }
+    this->RemoveNode(nodeToRemove);
+    if (inverseState)
+      {
+      inverseState->RemovedNodes.push_back(nodeToRemove);
       }
     }
-
-  std::vector<std::string>::iterator iterID;
-  std::vector<vtkMRMLNode*>::iterator iterNode;
-  std::vector<std::string>::iterator curIterID;
-  std::vector<vtkMRMLNode*>::iterator curIterNode;
-
-  // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkMRMLNode*> addNodes;
-
-  for(iterID=undoIDs.begin(), iterNode = undoNodes.begin(); iterID != undoIDs.end(); iterID++, iterNode++)
+  // add back the nodes removed after the state was saved
+  for (it = state->RemovedNodes.begin(); it != state->RemovedNodes.end(); ++it)
     {
-    curIterID = std::find(currentIDs.begin(), currentIDs.end(), *iterID);
-    curIterNode = currentNodes.begin() + std::distance(currentIDs.begin(), curIterID);
-    if ( curIterID == currentIDs.end() )
+    vtkMRMLNode* nodeToAdd = *it;
+    if (nodeToAdd->GetID() != 0 &&
+        this->GetNodeByID(nodeToAdd->GetID()) == nodeToAdd)
       {
-      // the node was deleted, add Node back to the curreent scene
-      addNodes.push_back(*iterNode);
+      continue;
       }
-    else if (*iterNode != *curIterNode)
+    if (this->AddNode(nodeToAdd) == nodeToAdd && inverseState)
       {
-      // nodes differ, copy from undo to current scene
-      // but before create a copy in redo stack from current
-      this->CopyNodeInRedoStack(*curIterNode);
-      (*curIterNode)->CopyWithSceneWithSingleModifiedEvent(*iterNode);
+      inverseState->AddedNodes.push_back(nodeToAdd);
       }
     }
-
-  // remove new nodes created before Undo
-  std::vector<vtkMRMLNode*> removeNodes;
-  for(curIterID=currentIDs.begin(), curIterNode = currentNodes.begin(); curIterID != currentIDs.end(); curIterID++, curIterNode++)
+  // copy back the nodes modified after the state was saved
+  for (std::map< std::string, UndoStateNodeCopyType >::iterator copyIt =
+         state->NodeCopies.begin(); copyIt != state->NodeCopies.end(); ++copyIt)
     {
-    iterID = std::find(undoIDs.begin(),undoIDs.end(), *curIterID);
-    // Remove only if the node is not present in the previous state.
-    if ( iterID == undoIDs.end() )
+    vtkMRMLNode* nodeCopy = copyIt->second.Copy;
+    vtkMRMLNode* node = this->GetNodeByID(copyIt->first);
+    if (node == 0 || node == nodeCopy)
+      {
+      continue;
+      }
+    if (inverseState)
       {
-      removeNodes.push_back(*curIterNode);
+      this->CopyNodeInUndoState(node, inverseState);
       }
+    node->CopyWithSceneWithSingleModifiedEvent(nodeCopy);
     }
+}
 
-  for (nn=0; nn<addNodes.size(); nn++)
-    {
-    this->AddNode(addNodes[nn]);
-    }
-  for (nn=0; nn<removeNodes.size(); nn++)
+//------------------------------------------------------------------------------
+// Replace the current scene by the top of the undo stack
+// -- move the current scene on the redo stack
+void vtkMRMLScene::Undo()
+{
+  if (!this->UndoFlag)
     {
-    vtkMRMLNode* nodeToRemove = removeNodes[nn];
-    // Maybe the node has been removed already by a side effect of a previous
-    // node removal.
-    if (this->IsNodePresent(nodeToRemove))
-      {
-      this->RemoveNode(nodeToRemove);
-      }
+    return;
     }
 
-  if (undoScene)
+  if (this->UndoStack.size() == 0)
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    return;
     }
 
   this->RemoveUnusedNodeReferences();
 
-  if (!this->UndoStack.empty())
-   {
-   UndoStack.pop_back();
-   }
+  this->InUndo = true;
+
+  UndoStateType* undoState = this->UndoStack.back();
+  this->UndoStack.pop_back();
+
+  this->PushIntoRedoStack();
+  this->ApplyUndoState(undoState, this->RedoStack.back());
+  delete undoState;
+
+  this->RemoveUnusedNodeReferences();
+
   this->Modified();
 
   this->InUndo = false;
@@ -2542,124 +2626,180 @@ void vtkMRMLScene::Redo()
     return;
     }
 
-  int nnodes;
-  int n;
-  unsigned int nn;
-
   this->RemoveUnusedNodeReferences();
 
-  PushIntoUndoStack();
+  this->InUndo = true;
 
-  vtkCollection* currentScene = this->Nodes;
-  //std::hash_map<std::string, vtkMRMLNode*> currentMap;
-  std::map<std::string, vtkMRMLNode*> currentMap;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(currentScene->GetItemAsObject(n));
-    if (node && !node->IsA("vtkMRMLSceneViewNode"))
-      {
-      currentMap[node->GetID()] = node;
-      }
-    }
+  UndoStateType* redoState = this->RedoStack.back();
+  this->RedoStack.pop_back();
+
+  this->PushIntoUndoStack();
+  this->ApplyUndoState(redoState, this->UndoStack.back());
+  delete redoState;
 
-  //std::hash_map<std::string, vtkMRMLNode*> undoMap;
-  std::map<std::string, vtkMRMLNode*> undoMap;
+  this->Modified();
 
-  vtkCollection* undoScene = NULL;
+  this->InUndo = false;
+}
 
-  if (!this->RedoStack.empty())
+//------------------------------------------------------------------------------
+void vtkMRMLScene::ClearUndoStack()
+{
+  std::list< UndoStateType* >::iterator iter;
+  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
     {
-    undoScene = dynamic_cast < vtkCollection *>( this->RedoStack.back() );;
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
-      {
-      vtkMRMLNode *node  = dynamic_cast < vtkMRMLNode *>(undoScene->GetItemAsObject(n));
-      if (node && !node->IsA("vtkMRMLSceneViewNode"))
-        {
-        undoMap[node->GetID()] = node;
-        }
-      }
+    delete *iter;
     }
+  this->UndoStack.clear();
+}
 
-  //std::hash_map<std::string, vtkMRMLNode*>::iterator iter;
-  //std::hash_map<std::string, vtkMRMLNode*>::iterator curIter;
-  std::map<std::string, vtkMRMLNode*>::iterator iter;
-  std::map<std::string, vtkMRMLNode*>::iterator curIter;
+//------------------------------------------------------------------------------
+void vtkMRMLScene::ClearRedoStack()
+{
+  std::list< UndoStateType* >::iterator iter;
+  for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
+    {
+    delete *iter;
+    }
+  this->RedoStack.clear();
+}
 
-  // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkMRMLNode*> addNodes;
+//------------------------------------------------------------------------------
+namespace
+{
+// Rough estimate of the memory used by the attributes of a node copy
+const vtkTypeUInt64 UndoNodeMemorySize = 1024;
 
-  for(iter=undoMap.begin(); iter != undoMap.end(); iter++)
+//------------------------------------------------------------------------------
+vtkDataObject* GetNodeBulkData(vtkMRMLNode* node)
+{
+  vtkMRMLVolumeNode* volumeNode = vtkMRMLVolumeNode::SafeDownCast(node);
+  if (volumeNode)
     {
-    curIter = currentMap.find(iter->first);
-    if ( curIter == currentMap.end() )
-      {
-      // the node was deleted, add Node back to the curreent scene
-      addNodes.push_back(iter->second);
-      }
-    else if (iter->second != curIter->second)
-      {
-      // nodes differ, copy from redo to current scene
-      // but before create a copy in undo stack from current
-      this->CopyNodeInUndoStack(curIter->second);
-      curIter->second->CopyWithSceneWithSingleModifiedEvent(iter->second);
-      }
+    return volumeNode->GetImageData();
     }
-
-  // remove new nodes created before Undo
-  std::vector<vtkMRMLNode*> removeNodes;
-  for(curIter=currentMap.begin(); curIter != currentMap.end(); curIter++)
+  vtkMRMLModelNode* modelNode = vtkMRMLModelNode::SafeDownCast(node);
+  if (modelNode)
     {
-    iter = undoMap.find(curIter->first);
-    if ( iter == undoMap.end() )
-      {
-      removeNodes.push_back(curIter->second);
-      }
+    return modelNode->GetPolyData();
     }
+  return 0;
+}
 
-  for (nn=0; nn<addNodes.size(); nn++)
+//------------------------------------------------------------------------------
+// Return the memory used by the node and its bulk data unless they have
+// already been visited.
+vtkTypeUInt64 GetUndoNodeMemorySize(vtkMRMLNode* node,
+                                    std::set<vtkObject*>& visitedObjects)
+{
+  vtkTypeUInt64 size = 0;
+  if (!node || !visitedObjects.insert(node).second)
     {
-    this->AddNode(addNodes[nn]);
+    return size;
     }
-  for (nn=0; nn<removeNodes.size(); nn++)
+  size += UndoNodeMemorySize;
+  vtkDataObject* bulkData = GetNodeBulkData(node);
+  if (bulkData && visitedObjects.insert(bulkData).second)
     {
-    this->RemoveNode(removeNodes[nn]);
+    // GetActualMemorySize() is in kibibytes
+    size += static_cast<vtkTypeUInt64>(bulkData->GetActualMemorySize()) * 1024;
     }
+  return size;
+}
 
-  if (undoScene)
+//------------------------------------------------------------------------------
+template <class NodeCopiesType>
+vtkTypeUInt64 GetUndoNodeCopiesMemorySize(const NodeCopiesType& nodeCopies,
+                                          std::set<vtkObject*>& visitedObjects)
+{
+  vtkTypeUInt64 size = 0;
+  for (typename NodeCopiesType::const_iterator it = nodeCopies.begin();
+       it != nodeCopies.end(); ++it)
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    size += GetUndoNodeMemorySize(it->second.Copy, visitedObjects);
     }
+  return size;
+}
 
-  RedoStack.pop_back();
-
-  this->Modified();
+//------------------------------------------------------------------------------
+template <class StateType>
+vtkTypeUInt64 GetUndoStateMemorySize(StateType* state,
+                                     std::set<vtkObject*>& visitedObjects)
+{
+  vtkTypeUInt64 size = GetUndoNodeCopiesMemorySize(state->NodeCopies, visitedObjects);
+  for (size_t i = 0; i < state->AddedNodes.size(); ++i)
+    {
+    size += GetUndoNodeMemorySize(state->AddedNodes[i], visitedObjects);
+    }
+  for (size_t i = 0; i < state->RemovedNodes.size(); ++i)
+    {
+    size += GetUndoNodeMemorySize(state->RemovedNodes[i], visitedObjects);
+    }
+  return size;
+}
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::ClearUndoStack()
+vtkTypeUInt64 vtkMRMLScene::ComputeUndoStackMemorySizes(std::vector<vtkTypeUInt64>& sizes)
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
+  // Objects used by the scene or the redo stack are not freed when undo
+  // states are discarded.
+  std::set<vtkObject*> visitedObjects;
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    GetUndoNodeMemorySize(node, visitedObjects);
     }
-  this->UndoStack.clear();
+  for (std::list< UndoStateType* >::iterator redoIt = this->RedoStack.begin();
+       redoIt != this->RedoStack.end(); ++redoIt)
+    {
+    GetUndoStateMemorySize(*redoIt, visitedObjects);
+    }
+
+  vtkTypeUInt64 memorySize = 0;
+  sizes.assign(this->UndoStack.size(), 0);
+  size_t stateIndex = this->UndoStack.size();
+  for (std::list< UndoStateType* >::reverse_iterator undoIt = this->UndoStack.rbegin();
+       undoIt != this->UndoStack.rend(); ++undoIt)
+    {
+    sizes[--stateIndex] = GetUndoStateMemorySize(*undoIt, visitedObjects);
+    memorySize += sizes[stateIndex];
+    }
+  return memorySize;
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::ClearRedoStack()
+vtkTypeUInt64 vtkMRMLScene::GetUndoStackMemorySize()
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
+  std::vector<vtkTypeUInt64> sizes;
+  return this->ComputeUndoStackMemorySizes(sizes);
+}
+
+//------------------------------------------------------------------------------
+void vtkMRMLScene::TrimUndoStack()
+{
+  std::vector<vtkTypeUInt64> sizes;
+  vtkTypeUInt64 memorySize = 0;
+  if (this->UndoMemoryBudget > 0)
     {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
+    memorySize = this->ComputeUndoStackMemorySizes(sizes);
+    }
+  size_t stateIndex = 0;
+  // the last saved state is always kept
+  while (this->UndoStack.size() > 1 &&
+         (static_cast<int>(this->UndoStack.size()) > this->UndoStackSize ||
+          (this->UndoMemoryBudget > 0 && memorySize > this->UndoMemoryBudget)))
+    {
+    if (this->UndoMemoryBudget > 0)
+      {
+      memorySize -= sizes[stateIndex];
+      }
+    ++stateIndex;
+    delete this->UndoStack.front();
+    this->UndoStack.pop_front();
     }
-  this->RedoStack.clear();
 }
 
 //------------------------------------------------------------------------------
@@ -2982,6 +3122,185 @@ void vtkMRMLScene::ClearNodeIDs()
   }
 }
 
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::UpdateNodeIndexes()
+{
+  if (!this->Nodes || this->Nodes->GetMTime() <= this->NodeIndexesMTime)
+    {
+    return;
+    }
+  // The collection has been modified directly (e.g. InsertBeforeNode(),
+  // Undo(), Clear()), the indexes must be recomputed from scratch.
+#ifdef MRMLSCENE_VERBOSE
+  std::cerr << "Recompute node class and name indexes..." << std::endl;
+#endif
+  this->ClearNodeIndexes();
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    this->AddNodeToIndexes(node);
+    }
+  this->NodeIndexesMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToIndexes(vtkMRMLNode *node)
+{
+  if (!node || this->IndexedNodes.find(node) != this->IndexedNodes.end())
+    {
+    return;
+    }
+  IndexedNodeType& indexedNode = this->IndexedNodes[node];
+  indexedNode.Position = this->NextIndexedNodePosition++;
+  indexedNode.HasName = (node->GetName() != 0);
+  this->NodesByClassName[node->GetClassName()][indexedNode.Position] = node;
+  if (indexedNode.HasName)
+    {
+    indexedNode.Name = node->GetName();
+    this->NodesByName[indexedNode.Name][indexedNode.Position] = node;
+    }
+  this->ClassQueryCache.clear();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromIndexes(vtkMRMLNode *node)
+{
+  std::map< vtkMRMLNode*, IndexedNodeType >::iterator indexedNodeIt =
+    this->IndexedNodes.find(node);
+  if (indexedNodeIt == this->IndexedNodes.end())
+    {
+    return;
+    }
+  const IndexedNodeType& indexedNode = indexedNodeIt->second;
+  std::map< std::string, OrderedNodesType >::iterator classIt =
+    this->NodesByClassName.find(node->GetClassName());
+  if (classIt != this->NodesByClassName.end())
+    {
+    classIt->second.erase(indexedNode.Position);
+    if (classIt->second.empty())
+      {
+      this->NodesByClassName.erase(classIt);
+      }
+    }
+  if (indexedNode.HasName)
+    {
+    std::map< std::string, OrderedNodesType >::iterator nameIt =
+      this->NodesByName.find(indexedNode.Name);
+    if (nameIt != this->NodesByName.end())
+      {
+      nameIt->second.erase(indexedNode.Position);
+      if (nameIt->second.empty())
+        {
+        this->NodesByName.erase(nameIt);
+        }
+      }
+    }
+  this->IndexedNodes.erase(indexedNodeIt);
+  this->ClassQueryCache.clear();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearNodeIndexes()
+{
+  this->IndexedNodes.clear();
+  this->NodesByClassName.clear();
+  this->NodesByName.clear();
+  this->ClassQueryCache.clear();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::NodeNameChanged(vtkMRMLNode *node, const char* vtkNotUsed(oldName))
+{
+  if (!this->Nodes || this->Nodes->GetMTime() > this->NodeIndexesMTime)
+    {
+    // The indexes will be recomputed anyway
+    return;
+    }
+  std::map< vtkMRMLNode*, IndexedNodeType >::iterator indexedNodeIt =
+    this->IndexedNodes.find(node);
+  if (indexedNodeIt == this->IndexedNodes.end())
+    {
+    // the node is not (yet) in the scene
+    return;
+    }
+  IndexedNodeType& indexedNode = indexedNodeIt->second;
+  if (indexedNode.HasName)
+    {
+    std::map< std::string, OrderedNodesType >::iterator nameIt =
+      this->NodesByName.find(indexedNode.Name);
+    if (nameIt != this->NodesByName.end())
+      {
+      nameIt->second.erase(indexedNode.Position);
+      if (nameIt->second.empty())
+        {
+        this->NodesByName.erase(nameIt);
+        }
+      }
+    }
+  indexedNode.HasName = (node->GetName() != 0);
+  indexedNode.Name = indexedNode.HasName ? node->GetName() : "";
+  if (indexedNode.HasName)
+    {
+    this->NodesByName[indexedNode.Name][indexedNode.Position] = node;
+    }
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<vtkMRMLNode*>& vtkMRMLScene::GetIndexedNodesByClass(const char* className)
+{
+  this->UpdateNodeIndexes();
+  std::map< std::string, std::vector< vtkMRMLNode* > >::iterator cacheIt =
+    this->ClassQueryCache.find(className);
+  if (cacheIt != this->ClassQueryCache.end())
+    {
+    return cacheIt->second;
+    }
+  // Inserting a class in the map does not invalidate the vectors of the
+  // other classes, which may be traversed by the callers.
+  std::vector< vtkMRMLNode* >& classNodes = this->ClassQueryCache[className];
+  // Only the exact classes are indexed. All the nodes of a given class share
+  // the same superclasses, testing the first node of each class is enough.
+  std::vector< OrderedNodesType* > matchingClasses;
+  size_t numberOfNodes = 0;
+  for (std::map< std::string, OrderedNodesType >::iterator classIt =
+         this->NodesByClassName.begin();
+       classIt != this->NodesByClassName.end(); ++classIt)
+    {
+    if (!classIt->second.empty() &&
+        classIt->second.begin()->second->IsA(className))
+      {
+      matchingClasses.push_back(&classIt->second);
+      numberOfNodes += classIt->second.size();
+      }
+    }
+  classNodes.reserve(numberOfNodes);
+  if (matchingClasses.size() == 1)
+    {
+    for (OrderedNodesType::iterator nodeIt = matchingClasses[0]->begin();
+         nodeIt != matchingClasses[0]->end(); ++nodeIt)
+      {
+      classNodes.push_back(nodeIt->second);
+      }
+    }
+  else if (matchingClasses.size() > 1)
+    {
+    // Merge the classes in the scene order
+    OrderedNodesType mergedNodes;
+    for (size_t i = 0; i < matchingClasses.size(); ++i)
+      {
+      mergedNodes.insert(matchingClasses[i]->begin(), matchingClasses[i]->end());
+      }
+    for (OrderedNodesType::iterator nodeIt = mergedNodes.begin();
+         nodeIt != mergedNodes.end(); ++nodeIt)
+      {
+      classNodes.push_back(nodeIt->second);
+      }
+    }
+  return classNodes;
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
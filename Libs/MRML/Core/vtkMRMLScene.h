@@ -59,6 +59,10 @@ class VTK_MRML_EXPORT vtkMRMLScene : public vtkObject
   /// but that's the only class that is allowed to do so
   friend class vtkMRMLSceneViewNode;
 
+  /// make the vtkMRMLNode a friend so that SetName() can keep the name index
+  /// up to date with NodeNameChanged()
+  friend class vtkMRMLNode;
+
 public:
   static vtkMRMLScene *New();
   vtkTypeMacro(vtkMRMLScene, vtkObject);
@@ -286,7 +290,33 @@ public:
   /// returns number of redo steps in the history buffer
   int GetNumberOfRedoLevels() { return (int)this->RedoStack.size();};
 
-  /// Save current state in the undo buffer
+  /// Maximum number of undo steps in the history buffer. When a new state
+  /// is saved, the oldest steps are discarded first.
+  /// 100 by default.
+  vtkSetMacro(UndoStackSize, int);
+  vtkGetMacro(UndoStackSize, int);
+
+  /// Maximum memory (in bytes) used by the undo history buffer, 0 for no
+  /// limit. When a new state is saved, the oldest steps are discarded until
+  /// the estimated memory size of the buffer fits into the budget. The last
+  /// saved state is always kept.
+  /// 0 by default.
+  /// \sa GetUndoStackMemorySize()
+  vtkSetMacro(UndoMemoryBudget, vtkTypeUInt64);
+  vtkGetMacro(UndoMemoryBudget, vtkTypeUInt64);
+
+  /// Estimate of the memory (in bytes) used by the undo history buffer.
+  /// Bulk data (image data, poly data) shared with the nodes of the scene or
+  /// with the redo buffer is not counted.
+  vtkTypeUInt64 GetUndoStackMemorySize();
+
+  /// \brief Save current state in the undo buffer
+  ///
+  /// Only the differences with the current scene are recorded: a copy of
+  /// the given nodes and the list of nodes that are added to or removed from
+  /// the scene after the state is saved. A node copy is shared with the
+  /// previous state if the node has not been modified since it was saved.
+  /// Bulk data is shared by reference with the node copies.
   void SaveStateForUndo();
 
   /// Save current state of the node in the undo buffer
@@ -398,6 +428,30 @@ public:
   vtkSetMacro(ReadDataOnLoad,int);
   vtkGetMacro(ReadDataOnLoad,int);
 
+  /// \brief Number of threads used by Import() to read the data files.
+  ///
+  /// The files of the imported storable nodes are read into memory by
+  /// worker threads, then the nodes are updated one after another in the
+  /// main thread. Everything happens within the
+  /// \link vtkMRMLScene::ImportState ImportState \endlink, no event is
+  /// invoked from the worker threads.
+  /// 1 (default) reads the files in the main thread. Prefetching is opt-in:
+  /// the VTK and ITK readers used by the storage nodes are not all known to
+  /// be thread-safe.
+  /// \sa vtkMRMLStorageNode::PrefetchData(), vtkMRMLStorageNode::GetLastReadTime()
+  vtkSetClampMacro(NumberOfImportThreads, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfImportThreads, int);
+
+  /// Wall clock time in seconds taken by the last Import(), reading of the
+  /// data files included.
+  vtkGetMacro(LastImportTime, double);
+  /// Wall clock time in seconds taken by the worker threads of the last
+  /// Import() to read the data files.
+  /// 0 if NumberOfImportThreads is 1: the files are then read while the
+  /// nodes are updated.
+  /// \sa NumberOfImportThreads
+  vtkGetMacro(LastImportReadTime, double);
+
   void SetErrorMessage(const std::string &error);
   std::string GetErrorMessage();
 
@@ -631,12 +685,53 @@ protected:
   vtkMRMLScene();
   virtual ~vtkMRMLScene();
 
+  /// State of the scene saved in the undo/redo stacks.
+  /// \sa SaveStateForUndo()
+  struct UndoStateNodeCopyType
+  {
+    vtkSmartPointer<vtkMRMLNode> Copy;
+    /// MTime of the node when it was copied
+    unsigned long NodeMTime;
+  };
+  struct UndoStateType
+  {
+    /// Copies of the nodes when the state was saved, indexed by node ID
+    std::map< std::string, UndoStateNodeCopyType > NodeCopies;
+    /// Nodes added to the scene after the state was saved
+    std::vector< vtkSmartPointer<vtkMRMLNode> > AddedNodes;
+    /// Nodes removed from the scene after the state was saved
+    std::vector< vtkSmartPointer<vtkMRMLNode> > RemovedNodes;
+  };
+
   void PushIntoUndoStack();
   void PushIntoRedoStack();
 
   void CopyNodeInUndoStack(vtkMRMLNode *node);
   void CopyNodeInRedoStack(vtkMRMLNode *node);
 
+  /// Copy \a node into \a state unless it is already there. The copy of
+  /// \a previousState is reused if the node has not been modified since.
+  void CopyNodeInUndoState(vtkMRMLNode *node, UndoStateType* state,
+                           UndoStateType* previousState = 0);
+
+  /// Record in the last undo state the nodes added to or removed from the
+  /// scene.
+  void RecordNodeAddedForUndo(vtkMRMLNode *node);
+  void RecordNodeRemovedForUndo(vtkMRMLNode *node);
+
+  /// Restore the scene to \a state and record into \a inverseState the
+  /// changes needed to revert it.
+  void ApplyUndoState(UndoStateType* state, UndoStateType* inverseState);
+
+  /// Discard the oldest undo states to honor UndoStackSize and
+  /// UndoMemoryBudget.
+  void TrimUndoStack();
+
+  /// Compute the memory size attributed to each state of the undo stack.
+  /// An object shared by several states is attributed to the most recent
+  /// one: it is freed when that state is discarded.
+  vtkTypeUInt64 ComputeUndoStackMemorySizes(std::vector<vtkTypeUInt64>& sizes);
+
   /// Add a node to the scene without invoking a vtkMRMLScene::NodeAddedEvent event.
   ///
   /// \warning Use with extreme caution as it might unsynchronize observer.
@@ -679,6 +774,31 @@ protected:
   /// Clear NodeIDs map used to speedup GetByID() method.
   void ClearNodeIDs();
 
+  /// \brief Synchronize the class and name indexes with the \a Nodes
+  /// collection.
+  ///
+  /// The indexes are rebuilt only if the collection has been modified
+  /// without going through AddNodeNoNotify() or RemoveNode().
+  /// \sa GetNodesByClass(), GetNodesByName()
+  void UpdateNodeIndexes();
+
+  /// Add/remove a node to/from the class and name indexes.
+  void AddNodeToIndexes(vtkMRMLNode *node);
+  void RemoveNodeFromIndexes(vtkMRMLNode *node);
+
+  /// Clear the class and name indexes.
+  void ClearNodeIndexes();
+
+  /// Called by vtkMRMLNode::SetName() to update the name index.
+  void NodeNameChanged(vtkMRMLNode *node, const char* oldName);
+
+  /// Return the nodes of the \a className class (or a subclass), sorted
+  /// in the scene order.
+  /// The result is cached per class until the scene nodes are added or
+  /// removed: the returned vector is not modified by queries on other
+  /// classes, but it must not be used after nodes are added or removed.
+  const std::vector<vtkMRMLNode*>& GetIndexedNodesByClass(const char* className);
+
   /// Get a NodeReferences iterator for a node reference.
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
@@ -694,11 +814,12 @@ protected:
   std::vector<unsigned long> States;
 
   int  UndoStackSize;
+  vtkTypeUInt64 UndoMemoryBudget;
   bool UndoFlag;
   bool InUndo;
 
-  std::list< vtkCollection* >  UndoStack;
-  std::list< vtkCollection* >  RedoStack;
+  std::list< UndoStateType* >  UndoStack;
+  std::list< UndoStateType* >  RedoStack;
 
   std::string                 URL;
   std::string                 RootDirectory;
@@ -714,6 +835,25 @@ protected:
   std::map< std::string, std::string > ReferencedIDChanges;
   std::map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDs;
 
+  /// Nodes of the class and name indexes, sorted by the position
+  /// (monotonically increasing) they had when added in the scene.
+  typedef std::map< unsigned long, vtkMRMLNode* > OrderedNodesType;
+  struct IndexedNodeType
+  {
+    unsigned long Position;
+    bool HasName;
+    std::string Name;
+  };
+  std::map< vtkMRMLNode*, IndexedNodeType > IndexedNodes;
+  /// Index of the nodes by class name (exact class, not superclasses)
+  std::map< std::string, OrderedNodesType > NodesByClassName;
+  /// Index of the nodes by name
+  std::map< std::string, OrderedNodesType > NodesByName;
+  unsigned long NextIndexedNodePosition;
+  unsigned long NodeIndexesMTime;
+  /// GetIndexedNodesByClass() results, by queried class name
+  std::map< std::string, std::vector< vtkMRMLNode* > > ClassQueryCache;
+
   std::string ErrorMessage;
 
   std::string SceneXMLString;
@@ -724,6 +864,10 @@ protected:
 
   int ReadDataOnLoad;
 
+  int NumberOfImportThreads;
+  double LastImportTime;
+  double LastImportReadTime;
+
   unsigned long NodeIDsMTime;
 
   void RemoveAllNodes(bool removeSingletons);
@@ -741,6 +885,10 @@ private:
   /// Returns nonzero on success
   int LoadIntoScene(vtkCollection* scene);
 
+  /// Read the data files of the storable nodes in \a nodes with
+  /// NumberOfImportThreads threads before the nodes are updated.
+  void PrefetchStorableNodesData(vtkCollection* nodes);
+
   unsigned long ErrorCode;
 
   /// Time when the scene was last read or written.
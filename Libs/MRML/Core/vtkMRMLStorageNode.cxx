@@ -23,6 +23,7 @@ Version:   $Revision: 1.1.1.1 $
 // VTK includes
 #include <vtkCommand.h>
 #include <vtkStringArray.h>
+#include <vtkTimerLog.h>
 #include <vtkURIHandler.h>
 
 // VTKSYS includes
@@ -54,6 +55,8 @@ vtkMRMLStorageNode::vtkMRMLStorageNode()
   this->SupportedWriteFileTypes = vtkStringArray::New();
   this->WriteFileFormat = NULL;
   this->StoredTime = vtkTimeStamp::New();
+  this->PrefetchTime = 0.;
+  this->LastReadTime = 0.;
 }
 
 //----------------------------------------------------------------------------
@@ -1064,7 +1067,21 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
   vtkDebugMacro("ReadData: read state is ready, "
     <<  "URI = " << (this->GetURI() == NULL ? "null" : this->GetURI()) << ", "
     << "filename = " << (this->GetFileName() == NULL ? "null" : this->GetFileName()));
+  // The file name may have changed since the data was prefetched
+  if (this->PrefetchedData.GetPointer() != NULL &&
+      this->PrefetchedFileName != this->GetFullNameFromFileName())
+    {
+    this->PrefetchedData = NULL;
+    this->PrefetchTime = 0.;
+    }
+  double startTime = vtkTimerLog::GetUniversalTime();
   int res = this->ReadDataInternal(refNode);
+  this->LastReadTime =
+    this->PrefetchTime + vtkTimerLog::GetUniversalTime() - startTime;
+  this->PrefetchedData = NULL;
+  this->PrefetchedFileName.clear();
+  this->PrefetchTime = 0.;
+  vtkDebugMacro("ReadData: read in " << this->LastReadTime << "s");
   if (res)
     {
     vtkMRMLStorableNode* storableNode = vtkMRMLStorableNode::SafeDownCast(refNode);
@@ -1081,6 +1098,34 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
   return res;
 }
 
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::CanPrefetchData(vtkMRMLNode* refNode)
+{
+  if (refNode == NULL ||
+      !this->CanReadInReferenceNode(refNode) ||
+      !refNode->GetAddToScene() ||
+      (this->GetScene() && this->GetScene()->GetReadDataOnLoad() == 0))
+    {
+    return false;
+    }
+  // Remote files are downloaded by ReadData()
+  if (this->GetURI() != NULL && strcmp(this->GetURI(), "") != 0)
+    {
+    return false;
+    }
+  return this->GetFileName() != NULL;
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLStorageNode::PrefetchData(vtkMRMLNode* refNode)
+{
+  double startTime = vtkTimerLog::GetUniversalTime();
+  this->PrefetchedFileName = this->GetFullNameFromFileName();
+  this->PrefetchedData = this->PrefetchDataInternal(refNode);
+  this->PrefetchTime = vtkTimerLog::GetUniversalTime() - startTime;
+  return this->PrefetchedData.GetPointer() != NULL;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
 {
@@ -1113,6 +1158,12 @@ int vtkMRMLStorageNode::ReadDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
   return 0;
 }
 
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLStorageNode::PrefetchDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return NULL;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
 {
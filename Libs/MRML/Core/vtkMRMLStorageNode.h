@@ -20,6 +20,7 @@
 class vtkURIHandler;
 
 // VTK includes
+#include <vtkSmartPointer.h>
 class vtkStringArray;
 
 // STD includes
@@ -51,6 +52,27 @@ public:
   /// \sa SetFileName(), ReadDataInternal(), GetStoredTime()
   virtual int ReadData(vtkMRMLNode *refNode, bool temporaryFile = false);
 
+  /// Return true if the files of \a refNode are local and PrefetchData()
+  /// can read them before ReadData() is called.
+  /// Must be called from the main thread.
+  /// \sa PrefetchData()
+  bool CanPrefetchData(vtkMRMLNode* refNode);
+
+  /// Read the files of \a refNode into memory without modifying
+  /// \a refNode or invoking any event. The next ReadData(refNode) only sets
+  /// the prefetched data into \a refNode. It is safe to call the method from
+  /// a worker thread, concurrently with other storage nodes, as long as
+  /// \a refNode and the storage node are not modified meanwhile.
+  /// Return true if the data has been prefetched, false if the storage node
+  /// doesn't support prefetching or if the files could not be read, in which
+  /// case ReadData() reads (and reports errors) as usual.
+  /// \sa CanPrefetchData(), PrefetchDataInternal(), vtkMRMLScene::SetNumberOfImportThreads()
+  bool PrefetchData(vtkMRMLNode* refNode);
+
+  /// Time (in seconds) spent by the last ReadData() call, including the
+  /// time spent in PrefetchData() if the data was prefetched.
+  vtkGetMacro(LastReadTime, double);
+
   ///
   /// Write data from a  referenced node
   /// Return 1 on success, 0 on failure.
@@ -286,6 +308,14 @@ protected:
   /// To be reimplemented in subclass.
   virtual int ReadDataInternal(vtkMRMLNode* refNode);
 
+  /// Read the files into an object that ReadDataInternal() finds in
+  /// PrefetchedData. Must not modify the storage node nor \a refNode, or
+  /// report errors: it is called from worker threads.
+  /// Returns NULL by default (prefetch not supported).
+  /// To be reimplemented in subclass.
+  /// \sa PrefetchData()
+  virtual vtkSmartPointer<vtkObject> PrefetchDataInternal(vtkMRMLNode* refNode);
+
   /// Does the actual writing. Returns 1 on success, 0 otherwise.
   /// Returns 0 by default (write not supported).
   /// To be reimplemented in subclass.
@@ -335,6 +365,14 @@ protected:
   /// Can be reset with InvalidateFile.
   /// \sa InvalidateFile
   vtkTimeStamp* StoredTime;
+
+  /// Data read by PrefetchData() for the next ReadDataInternal() call, NULL
+  /// if nothing was prefetched.
+  vtkSmartPointer<vtkObject> PrefetchedData;
+  /// Full name of the file PrefetchedData was read from
+  std::string PrefetchedFileName;
+  double PrefetchTime;
+  double LastReadTime;
 };
 
 #endif
@@ -258,6 +258,87 @@ void ApplyImageSeriesReaderWorkaround(vtkMRMLVolumeArchetypeStorageNode * storag
 }
 } // end of anonymous namespace
 
+//----------------------------------------------------------------------------
+vtkITKArchetypeImageSeriesReader* vtkMRMLVolumeArchetypeStorageNode
+::InstantiateReader(vtkMRMLNode* refNode, const std::string& fullName)
+{
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+
+  if (refNode->IsA("vtkMRMLVectorVolumeNode"))
+    {
+    reader.TakeReference(this->InstantiateVectorVolumeReader(fullName));
+    }
+  else if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeDiffusionTensorImageReaderFile>::New();
+    reader->SetSingleFile( this->GetSingleFile() );
+    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    }
+  else
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
+    reader->SetSingleFile( this->GetSingleFile() );
+    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    }
+
+  if (reader.GetPointer() == NULL)
+    {
+    return NULL;
+    }
+
+  // Set the list of file names on the reader
+  reader->ResetFileNames();
+  reader->SetArchetype(fullName.c_str());
+
+  // Workaround
+  ApplyImageSeriesReaderWorkaround(this, reader, fullName);
+
+  // Center image
+  reader->SetOutputScalarTypeToNative();
+  reader->SetDesiredCoordinateOrientationToNative();
+  if (this->CenterImage)
+    {
+    reader->SetUseNativeOriginOff();
+    }
+  else
+    {
+    reader->SetUseNativeOriginOn();
+    }
+
+  reader->Register(0);
+  return reader;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkObject> vtkMRMLVolumeArchetypeStorageNode
+::PrefetchDataInternal(vtkMRMLNode* refNode)
+{
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !refNode->IsA("vtkMRMLScalarVolumeNode"))
+    {
+    return NULL;
+    }
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+  reader.TakeReference(this->InstantiateReader(refNode, fullName));
+  if (reader.GetPointer() == NULL)
+    {
+    return NULL;
+    }
+  try
+    {
+    reader->Update();
+    }
+  catch (...)
+    {
+    return NULL;
+    }
+  if (reader->GetOutput() == NULL || reader->GetOutput()->GetPointData() == NULL)
+    {
+    return NULL;
+    }
+  return reader.GetPointer();
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -293,23 +374,13 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
-  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
-
-  if (refNode->IsA("vtkMRMLVectorVolumeNode"))
-    {
-    reader.TakeReference(this->InstantiateVectorVolumeReader(fullName));
-    }
-  else if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
-    {
-    reader = vtkSmartPointer<vtkITKArchetypeDiffusionTensorImageReaderFile>::New();
-    reader->SetSingleFile( this->GetSingleFile() );
-    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
-    }
-  else
+  // The reader has already been updated if the data was prefetched
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader =
+    vtkITKArchetypeImageSeriesReader::SafeDownCast(this->PrefetchedData);
+  bool prefetched = (reader.GetPointer() != NULL);
+  if (!prefetched)
     {
-    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
-    reader->SetSingleFile( this->GetSingleFile() );
-    reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+    reader.TakeReference(this->InstantiateReader(refNode, fullName));
     }
 
   if (reader.GetPointer() == NULL)
@@ -325,29 +396,13 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
     volNode->SetAndObserveImageData(NULL);
     }
 
-  // Set the list of file names on the reader
-  reader->ResetFileNames();
-  reader->SetArchetype(fullName.c_str());
-
-  // Workaround
-  ApplyImageSeriesReaderWorkaround(this, reader, fullName);
-
-  // Center image
-  reader->SetOutputScalarTypeToNative();
-  reader->SetDesiredCoordinateOrientationToNative();
-  if (this->CenterImage)
-    {
-    reader->SetUseNativeOriginOff();
-    }
-  else
-    {
-    reader->SetUseNativeOriginOn();
-    }
-
   try
     {
     vtkDebugMacro("ReadData: right before reader update, reader num files = " << reader->GetNumberOfFileNames());
-    reader->Update();
+    if (!prefetched)
+      {
+      reader->Update();
+      }
     }
   catch (itk::ExceptionObject& e)
     {
@@ -97,9 +97,17 @@ protected:
 
   vtkITKArchetypeImageSeriesReader* InstantiateVectorVolumeReader(const std::string &fullName);
 
+  /// Create and configure the reader of \a fullName for \a refNode.
+  /// Returns a new reference, NULL on failure.
+  vtkITKArchetypeImageSeriesReader* InstantiateReader(vtkMRMLNode* refNode,
+                                                      const std::string &fullName);
+
   /// Read data and set it in the referenced node
   virtual int ReadDataInternal(vtkMRMLNode *refNode);
 
+  /// Read the volume files into an updated reader
+  virtual vtkSmartPointer<vtkObject> PrefetchDataInternal(vtkMRMLNode *refNode);
+
   /// Write data from a referenced node
   virtual int WriteDataInternal(vtkMRMLNode *refNode);
 
@@ -101,3 +101,37 @@ void vtkObservation::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "LastElapsedTime: " << this->LastElapsedTime << "\n";
   os << indent << "TotalElapsedTime: " << this->TotalElapsedTime << "\n";
 }
+
+//----------------------------------------------------------------------------
+bool vtkObservation::AddCallData(unsigned long eventID, void* callData)
+{
+  // Repeated events (e.g. ModifiedEvent) are merged without any lookup
+  if (!this->CallDataList.empty() &&
+      this->CallDataList.back().EventID == eventID &&
+      this->CallDataList.back().CallData == callData)
+    {
+    return false;
+    }
+  if (!this->CallDataSet.insert(std::make_pair(eventID, callData)).second)
+    {
+    return false;
+    }
+  this->CallDataList.push_back(CallType(eventID, callData));
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkObservation::CallType vtkObservation::PopCallData()
+{
+  CallType call = this->CallDataList.front();
+  this->CallDataList.pop_front();
+  this->CallDataSet.erase(std::make_pair(call.EventID, call.CallData));
+  return call;
+}
+
+//----------------------------------------------------------------------------
+void vtkObservation::ClearCallData()
+{
+  this->CallDataList.clear();
+  this->CallDataSet.clear();
+}
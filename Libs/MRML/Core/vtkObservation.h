@@ -25,6 +25,7 @@ class vtkCallbackCommand;
 
 // STD includes
 #include <deque>
+#include <set>
 
 /// \brief Stores information about the relationship between a Subject and an Observer.
 ///
@@ -98,6 +99,18 @@ class VTK_MRML_EXPORT vtkObservation : public vtkObject
   };
   std::deque<CallType> *GetCallDataList() {return &(this->CallDataList);};
 
+  /// Add a call to the list of pending calls, unless the same event with
+  /// the same call data is already pending. Return false if the call was
+  /// merged with a pending one.
+  /// O(1) if the call repeats the last pending call, O(log n) in the number
+  /// of pending calls otherwise.
+  bool AddCallData(unsigned long eventID, void* callData);
+  /// Remove the oldest pending call and return it.
+  /// The list of pending calls must not be empty.
+  CallType PopCallData();
+  /// Remove all the pending calls.
+  void ClearCallData();
+
 protected:
   vtkObservation();
   virtual ~vtkObservation();
@@ -138,6 +151,9 @@ protected:
   ///
   /// data passed to the observation by the subject
   std::deque<CallType> CallDataList;
+  /// the (event, call data) pairs of CallDataList, to find a pending call
+  /// in O(log n) instead of scanning the list
+  std::set< std::pair<unsigned long, void*> > CallDataSet;
 
   ///
   /// Holder for script as an alternative to the callback command
@@ -0,0 +1,174 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLDisplayableManagerGroup.h>
+#include <vtkMRMLModelDisplayableManager.h>
+
+// MRMLLogic includes
+#include <vtkMRMLApplicationLogic.h>
+
+// MRML includes
+#include <vtkMRMLModelDisplayNode.h>
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScene.h>
+#include <vtkMRMLViewNode.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// Time to pick in a scene of many large models
+int vtkMRMLModelDisplayableManagerPickTest1(int , char* [])
+{
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  vtkNew<vtkRenderWindowInteractor> renderWindowInteractor;
+  renderWindow->SetSize(600, 600);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+  renderWindow->SetInteractor(renderWindowInteractor.GetPointer());
+
+  vtkMRMLScene* scene = vtkMRMLScene::New();
+  vtkMRMLApplicationLogic* applicationLogic = vtkMRMLApplicationLogic::New();
+  applicationLogic->SetMRMLScene(scene);
+
+  vtkNew<vtkMRMLViewNode> viewNode;
+  scene->AddNode(viewNode.GetPointer());
+
+  vtkNew<vtkMRMLDisplayableManagerGroup> displayableManagerGroup;
+  displayableManagerGroup->SetRenderer(renderer.GetPointer());
+  displayableManagerGroup->SetMRMLDisplayableNode(viewNode.GetPointer());
+
+  vtkNew<vtkMRMLModelDisplayableManager> modelDisplayableManager;
+  modelDisplayableManager->SetMRMLApplicationLogic(applicationLogic);
+  displayableManagerGroup->AddDisplayableManager(modelDisplayableManager.GetPointer());
+  displayableManagerGroup->GetInteractor()->Initialize();
+
+  // 10x10 spheres of ~20k triangles
+  const int gridSize = 10;
+  std::vector<std::string> displayNodeIDs;
+  std::vector<double> centers;
+  for (int j = 0; j < gridSize; ++j)
+    {
+    for (int i = 0; i < gridSize; ++i)
+      {
+      vtkNew<vtkSphereSource> sphereSource;
+      sphereSource->SetRadius(10.);
+      sphereSource->SetCenter(30. * i, 30. * j, 0.);
+      sphereSource->SetThetaResolution(100);
+      sphereSource->SetPhiResolution(100);
+      sphereSource->Update();
+
+      vtkNew<vtkMRMLModelNode> modelNode;
+#if (VTK_MAJOR_VERSION <= 5)
+      modelNode->SetAndObservePolyData(sphereSource->GetOutput());
+#else
+      modelNode->SetPolyDataConnection(sphereSource->GetOutputPort());
+#endif
+      scene->AddNode(modelNode.GetPointer());
+      vtkNew<vtkMRMLModelDisplayNode> modelDisplayNode;
+      scene->AddNode(modelDisplayNode.GetPointer());
+      modelNode->AddAndObserveDisplayNodeID(modelDisplayNode->GetID());
+
+      displayNodeIDs.push_back(modelDisplayNode->GetID());
+      centers.push_back(30. * i);
+      centers.push_back(30. * j);
+      }
+    }
+
+  renderer->ResetCamera();
+  renderWindow->Render();
+  int* size = renderer->GetSize();
+
+  vtkNew<vtkTimerLog> timer;
+  bool success = true;
+  // The first pick builds the locators
+  for (int pass = 0; pass < 2; ++pass)
+    {
+    const int numberOfPicks = static_cast<int>(displayNodeIDs.size());
+    timer->StartTimer();
+    for (int m = 0; m < numberOfPicks; ++m)
+      {
+      renderer->SetWorldPoint(centers[2 * m], centers[2 * m + 1], 0., 1.);
+      renderer->WorldToDisplay();
+      double* displayPoint = renderer->GetDisplayPoint();
+      modelDisplayableManager->Pick(static_cast<int>(displayPoint[0]),
+                                    size[1] - static_cast<int>(displayPoint[1]));
+      if (displayNodeIDs[m] != modelDisplayableManager->GetPickedNodeID() ||
+          modelDisplayableManager->GetPickedCellID() < 0)
+        {
+        std::cerr << "Line " << __LINE__ << ": picked "
+                  << modelDisplayableManager->GetPickedNodeID()
+                  << " instead of " << displayNodeIDs[m] << std::endl;
+        success = false;
+        }
+      }
+    timer->StopTimer();
+    std::cout << "<DartMeasurement name=\"" << (pass == 0 ? "FirstPickTime" : "PickTime")
+              << "\" type=\"numeric/double\">"
+              << timer->GetElapsedTime() / numberOfPicks
+              << "</DartMeasurement>" << std::endl;
+    }
+
+  // Nothing is picked between the models
+  renderer->SetWorldPoint(15., 15., 0., 1.);
+  renderer->WorldToDisplay();
+  double* displayPoint = renderer->GetDisplayPoint();
+  modelDisplayableManager->Pick(static_cast<int>(displayPoint[0]),
+                                size[1] - static_cast<int>(displayPoint[1]));
+  if (std::string(modelDisplayableManager->GetPickedNodeID()) != "")
+    {
+    std::cerr << "Line " << __LINE__ << ": picked "
+              << modelDisplayableManager->GetPickedNodeID()
+              << " in empty space" << std::endl;
+    success = false;
+    }
+
+  // A removed model is not picked anymore
+  vtkMRMLDisplayNode* removedDisplayNode = vtkMRMLDisplayNode::SafeDownCast(
+    scene->GetNodeByID(displayNodeIDs[0].c_str()));
+  scene->RemoveNode(removedDisplayNode->GetDisplayableNode());
+  renderWindow->Render();
+  renderer->SetWorldPoint(centers[0], centers[1], 0., 1.);
+  renderer->WorldToDisplay();
+  displayPoint = renderer->GetDisplayPoint();
+  modelDisplayableManager->Pick(static_cast<int>(displayPoint[0]),
+                                size[1] - static_cast<int>(displayPoint[1]));
+  if (std::string(modelDisplayableManager->GetPickedNodeID()) != "")
+    {
+    std::cerr << "Line " << __LINE__ << ": picked "
+              << modelDisplayableManager->GetPickedNodeID()
+              << " after its removal" << std::endl;
+    success = false;
+    }
+
+  modelDisplayableManager->SetMRMLApplicationLogic(0);
+  applicationLogic->Delete();
+  scene->Delete();
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
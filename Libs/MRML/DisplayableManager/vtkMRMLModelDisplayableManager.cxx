@@ -38,6 +38,7 @@
 // VTK includes
 #include <vtkAlgorithmOutput.h>
 #include <vtkAssignAttribute.h>
+#include <vtkBox.h>
 #include <vtkCellArray.h>
 #include <vtkClipPolyData.h>
 #include <vtkColorTransferFunction.h>
@@ -63,6 +64,7 @@
 
 // for picking
 #include <vtkCellPicker.h>
+#include <vtkOBBTree.h>
 #include <vtkPointPicker.h>
 #include <vtkPropPicker.h>
 #include <vtkRendererCollection.h>
@@ -86,6 +88,23 @@ public:
   /// Reset all the pick vars
   void ResetPick();
 
+  /// Return true if the model of the display node renders the output
+  /// polydata of the node, i.e. is neither clipped nor transformed. Only
+  /// those models are reported as picked.
+  bool IsModelPickable(const std::string& displayNodeID);
+  /// Return the ID of the pickable display node whose locator was built on
+  /// dataSet, an empty string if none.
+  std::string GetPickedDisplayNodeID(vtkDataSet* dataSet);
+  /// Forget the locator of a display node.
+  void RemovePickLocator(const std::string& displayNodeID);
+  void ClearPickLocators();
+
+  /// Give the cell picker an OBB tree for each visible model whose bounds
+  /// are crossed by the pick ray through the display point (x, y).
+  /// The trees are built on first use and rebuilt only when the rendered
+  /// polydata is modified.
+  void UpdatePickLocators(vtkRenderer* renderer, double x, double y);
+
   std::map<std::string, vtkProp3D *>               DisplayedActors;
   std::map<std::string, vtkMRMLDisplayNode *>      DisplayedNodes;
   std::map<std::string, int>                       DisplayedClipState;
@@ -118,6 +137,12 @@ public:
   vtkSmartPointer<vtkCellPicker>       CellPicker;
   vtkSmartPointer<vtkPointPicker>      PointPicker;
 
+  /// Cell locators of the displayed models, by display node ID. The
+  /// locators keep a reference to their polydata, the picked polydata is
+  /// looked up in them rather than in a map keyed by polydata pointers that
+  /// would go stale when a model gets new polydata.
+  std::map<std::string, vtkSmartPointer<vtkOBBTree> > PickLocators;
+
   /// Information about a pick event
   std::string  PickedNodeID;
   double       PickedRAS[3];
@@ -188,6 +213,134 @@ void vtkMRMLModelDisplayableManager::vtkInternal::ResetPick()
   this->PickedPointID = -1;
 }
 
+//---------------------------------------------------------------------------
+bool vtkMRMLModelDisplayableManager::vtkInternal
+::IsModelPickable(const std::string& displayNodeID)
+{
+  std::map<std::string, vtkProp3D *>::iterator actorIt =
+    this->DisplayedActors.find(displayNodeID);
+  std::map<std::string, vtkMRMLDisplayNode *>::iterator nodeIt =
+    this->DisplayedNodes.find(displayNodeID);
+  if (actorIt == this->DisplayedActors.end() ||
+      nodeIt == this->DisplayedNodes.end())
+    {
+    return false;
+    }
+  vtkActor* actor = vtkActor::SafeDownCast(actorIt->second);
+  vtkMRMLModelDisplayNode* modelDisplayNode =
+    vtkMRMLModelDisplayNode::SafeDownCast(nodeIt->second);
+  if (!actor || !actor->GetMapper() || !modelDisplayNode ||
+      !modelDisplayNode->GetOutputPolyData())
+    {
+    return false;
+    }
+  // only the unclipped and untransformed models are reported as picked
+#if (VTK_MAJOR_VERSION <= 5)
+  return actor->GetMapper()->GetInput() == modelDisplayNode->GetOutputPolyData();
+#else
+  return modelDisplayNode->GetOutputPolyDataConnection() &&
+    actor->GetMapper()->GetInputConnection(0, 0) ==
+      modelDisplayNode->GetOutputPolyDataConnection();
+#endif
+}
+
+//---------------------------------------------------------------------------
+std::string vtkMRMLModelDisplayableManager::vtkInternal
+::GetPickedDisplayNodeID(vtkDataSet* dataSet)
+{
+  std::map<std::string, vtkSmartPointer<vtkOBBTree> >::iterator locatorIt;
+  for (locatorIt = this->PickLocators.begin();
+       locatorIt != this->PickLocators.end(); ++locatorIt)
+    {
+    if (dataSet && locatorIt->second->GetDataSet() == dataSet &&
+        this->IsModelPickable(locatorIt->first))
+      {
+      return locatorIt->first;
+      }
+    }
+  return std::string();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLModelDisplayableManager::vtkInternal
+::RemovePickLocator(const std::string& displayNodeID)
+{
+  this->PickLocators.erase(displayNodeID);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLModelDisplayableManager::vtkInternal::ClearPickLocators()
+{
+  this->PickLocators.clear();
+  this->CellPicker->RemoveAllLocators();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLModelDisplayableManager::vtkInternal
+::UpdatePickLocators(vtkRenderer* renderer, double x, double y)
+{
+  this->CellPicker->RemoveAllLocators();
+
+  // pick ray from the near to the far clipping plane
+  double rayStart[4];
+  double rayEnd[4];
+  renderer->SetDisplayPoint(x, y, 0.0);
+  renderer->DisplayToWorld();
+  renderer->GetWorldPoint(rayStart);
+  renderer->SetDisplayPoint(x, y, 1.0);
+  renderer->DisplayToWorld();
+  renderer->GetWorldPoint(rayEnd);
+  if (rayStart[3] == 0.0 || rayEnd[3] == 0.0)
+    {
+    return;
+    }
+  double rayDirection[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    rayStart[i] /= rayStart[3];
+    rayDirection[i] = rayEnd[i] / rayEnd[3] - rayStart[i];
+    }
+
+  std::map<std::string, vtkProp3D *>::iterator actorIt;
+  for (actorIt = this->DisplayedActors.begin();
+       actorIt != this->DisplayedActors.end(); ++actorIt)
+    {
+    vtkActor* actor = vtkActor::SafeDownCast(actorIt->second);
+    if (!actor || !actor->GetVisibility() || !actor->GetPickable() ||
+        !actor->GetMapper())
+      {
+      continue;
+      }
+    // the models missed by the ray are rejected by the picker on their
+    // bounds, they do not need a locator
+    double* bounds = actor->GetBounds();
+    double hitPosition[3];
+    double hitParameter;
+    if (!bounds ||
+        !vtkBox::IntersectBox(bounds, rayStart, rayDirection, hitPosition, hitParameter))
+      {
+      continue;
+      }
+    vtkPolyData* polyData = vtkPolyData::SafeDownCast(actor->GetMapper()->GetInput());
+    if (!polyData || polyData->GetNumberOfCells() == 0)
+      {
+      continue;
+      }
+    vtkSmartPointer<vtkOBBTree>& locator = this->PickLocators[actorIt->first];
+    if (!locator)
+      {
+      locator = vtkSmartPointer<vtkOBBTree>::New();
+      }
+    if (locator->GetDataSet() != polyData)
+      {
+      locator->SetDataSet(polyData);
+      }
+    // rebuilt only if the polydata has been modified
+    locator->Update();
+    this->CellPicker->AddLocator(locator);
+    }
+}
+
 //---------------------------------------------------------------------------
 // vtkMRMLModelDisplayableManager methods
 
@@ -832,6 +985,7 @@ void vtkMRMLModelDisplayableManager::UpdateModelsFromMRML()
     this->Internal->DisplayedClipState.clear();
     this->Internal->DisplayedVisibility.clear();
     this->Internal->DisplayNodeTransformPolyDataFilters.clear();
+    this->Internal->ClearPickLocators();
     this->UpdateModelHierarchies();
     }
 
@@ -1406,6 +1560,7 @@ void vtkMRMLModelDisplayableManager::RemoveDispalyedID(std::string &id)
 {
   std::map<std::string, vtkMRMLDisplayNode *>::iterator modelIter;
   this->Internal->DisplayedActors.erase(id);
+  this->Internal->RemovePickLocator(id);
   this->Internal->DisplayedClipState.erase(id);
   this->Internal->DisplayedVisibility.erase(id);
   modelIter = this->Internal->DisplayedNodes.find(id);
@@ -1458,6 +1613,7 @@ void vtkMRMLModelDisplayableManager::RemoveModelObservers(int clearCache)
     this->Internal->DisplayedNodes.clear();
     this->Internal->DisplayedClipState.clear();
     this->Internal->DisplayedVisibility.clear();
+    this->Internal->ClearPickLocators();
     }
 }
 
@@ -2043,6 +2199,7 @@ int vtkMRMLModelDisplayableManager::Pick(int x, int y)
   displayPoint[1] = renSize[1] - y;
   displayPoint[2] = 0.0;
 
+  this->Internal->UpdatePickLocators(ren, displayPoint[0], displayPoint[1]);
   if (this->Internal->CellPicker->Pick(displayPoint[0], displayPoint[1], displayPoint[2], ren))
     {
     this->Internal->CellPicker->GetPickPosition(pickPoint);
@@ -2052,50 +2209,39 @@ int vtkMRMLModelDisplayableManager::Pick(int x, int y)
     if (polyData != 0)
       {
       // now find the model this poly data belongs to
-      std::map<std::string, vtkMRMLDisplayNode *>::iterator modelIter;
-      for (modelIter = this->Internal->DisplayedNodes.begin();
-           modelIter != this->Internal->DisplayedNodes.end();
-           modelIter++)
+      std::string pickedNodeID = this->Internal->GetPickedDisplayNodeID(polyData);
+      if (!pickedNodeID.empty())
         {
-        vtkDebugMacro("Checking model " << modelIter->first.c_str() << "'s polydata");
-        if (modelIter->second != 0)
+        vtkDebugMacro("Found matching poly data, pick was on model " << pickedNodeID.c_str());
+        this->Internal->PickedNodeID = pickedNodeID;
+
+        // figure out the closest vertex in the picked cell to the picked RAS
+        // point. Only doing this on model nodes for now.
+        vtkCell *cell = polyData->GetCell(this->GetPickedCellID());
+        if (cell != 0)
           {
-          if (vtkMRMLModelDisplayNode::SafeDownCast(modelIter->second) &&
-              vtkMRMLModelDisplayNode::SafeDownCast(modelIter->second)->GetOutputPolyData() == polyData)
+          int numPoints = cell->GetNumberOfPoints();
+          int closestPointId = -1;
+          double closestDistance = 0.0l;
+          for (int p = 0; p < numPoints; p++)
             {
-            vtkDebugMacro("Found matching poly data, pick was on model " << modelIter->first.c_str());
-            this->Internal->PickedNodeID = modelIter->first;
-
-            // figure out the closest vertex in the picked cell to the picked RAS
-            // point. Only doing this on model nodes for now.
-            vtkCell *cell = polyData->GetCell(this->GetPickedCellID());
-            if (cell != 0)
+            int pointId = cell->GetPointId(p);
+            double *pointCoords = polyData->GetPoint(pointId);
+            if (pointCoords != 0)
               {
-              int numPoints = cell->GetNumberOfPoints();
-              int closestPointId = -1;
-              double closestDistance = 0.0l;
-              for (int p = 0; p < numPoints; p++)
+              double distance = sqrt(pow(pointCoords[0]-pickPoint[0], 2) +
+                                     pow(pointCoords[1]-pickPoint[1], 2) +
+                                     pow(pointCoords[2]-pickPoint[2], 2));
+              if (p == 0 ||
+                  distance < closestDistance)
                 {
-                int pointId = cell->GetPointId(p);
-                double *pointCoords = polyData->GetPoint(pointId);
-                if (pointCoords != 0)
-                  {
-                  double distance = sqrt(pow(pointCoords[0]-pickPoint[0], 2) +
-                                         pow(pointCoords[1]-pickPoint[1], 2) +
-                                         pow(pointCoords[2]-pickPoint[2], 2));
-                  if (p == 0 ||
-                      distance < closestDistance)
-                    {
-                    closestDistance = distance;
-                    closestPointId = pointId;
-                    }
-                  }
+                closestDistance = distance;
+                closestPointId = pointId;
                 }
-              vtkDebugMacro("Pick: found closest point id = " << closestPointId << ", distance = " << closestDistance);
-              this->SetPickedPointID(closestPointId);
               }
-            continue;
             }
+          vtkDebugMacro("Pick: found closest point id = " << closestPointId << ", distance = " << closestDistance);
+          this->SetPickedPointID(closestPointId);
           }
         }
       }
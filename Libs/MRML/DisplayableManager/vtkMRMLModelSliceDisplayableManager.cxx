@@ -34,6 +34,7 @@
 #include <vtkActor2D.h>
 #include <vtkAlgorithmOutput.h>
 #include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
 #include <vtkEventBroker.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -47,11 +48,10 @@
 #include <vtkGeneralTransform.h>
 #include <vtkTransformPolyDataFilter.h>
 #include <vtkWeakPointer.h>
-#include <vtkPointLocator.h>
 #include <vtkVersion.h>
 
-// VTK includes: customization
-#include <vtkCutter.h>
+// vtkAddon includes
+#include <vtkIndexedPlaneCutter.h>
 
 // STD includes
 #include <algorithm>
@@ -73,7 +73,7 @@ public:
     vtkSmartPointer<vtkTransformPolyDataFilter> Transformer;
     vtkSmartPointer<vtkTransformPolyDataFilter> ModelWarper;
     vtkSmartPointer<vtkPlane> Plane;
-    vtkSmartPointer<vtkCutter> Cutter;
+    vtkSmartPointer<vtkIndexedPlaneCutter> Cutter;
     vtkSmartPointer<vtkProp> Actor;
     };
 
@@ -194,11 +194,19 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   //   then update the DisplayNode pipelines to account for plane location
 
   this->SliceXYToRAS->DeepCopy( this->SliceNode->GetXYToRAS() );
+  vtkNew<vtkCollection> visibleCutters;
   PipelinesCacheType::iterator it;
   for (it = this->DisplayPipelines.begin(); it != this->DisplayPipelines.end(); ++it)
     {
     this->UpdateDisplayNodePipeline(it->first, it->second);
+    if (it->second->Actor->GetVisibility() &&
+        it->second->ModelWarper->GetNumberOfInputConnections(0) > 0)
+      {
+      visibleCutters->AddItem(it->second->Cutter);
+      }
     }
+  // Cut the models in parallel, the mappers only copy the results
+  vtkIndexedPlaneCutter::CutInParallel(visibleCutters.GetPointer());
 }
 
 //---------------------------------------------------------------------------
@@ -302,7 +310,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   // Create pipeline
   Pipeline* pipeline = new Pipeline();
   pipeline->Actor = actor.GetPointer();
-  pipeline->Cutter = vtkSmartPointer<vtkCutter>::New();
+  pipeline->Cutter = vtkSmartPointer<vtkIndexedPlaneCutter>::New();
   pipeline->TransformToSlice = vtkSmartPointer<vtkTransform>::New();
   pipeline->NodeToWorld = vtkSmartPointer<vtkGeneralTransform>::New();
   pipeline->Transformer = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
@@ -312,8 +320,7 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
   // Set up pipeline
   pipeline->Transformer->SetTransform(pipeline->TransformToSlice);
   pipeline->Transformer->SetInputConnection(pipeline->Cutter->GetOutputPort());
-  pipeline->Cutter->SetCutFunction(pipeline->Plane);
-  pipeline->Cutter->SetGenerateCutScalars(0);
+  pipeline->Cutter->SetPlane(pipeline->Plane);
   pipeline->Cutter->SetInputConnection(pipeline->ModelWarper->GetOutputPort());
   pipeline->Actor->SetVisibility(0);
 
@@ -373,13 +380,12 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
       {
       return;
       }
+    // The polydata is not marked as modified here: the cutter would
+    // re-index the model at each slice move.
 #if (VTK_MAJOR_VERSION <= 5)
     pipeline->ModelWarper->SetInput(polyData);
-    // need this to update bounds of the locator, to avoid crash in the cutter
-    polyData->Modified();
 #else
     pipeline->ModelWarper->SetInputData(polyData);
-    // need this to update bounds of the locator, to avoid crash in the cutter
     modelDisplayNode->GetOutputPolyDataConnection()->GetProducer()->Update();
 #endif
 
@@ -394,17 +400,6 @@ void vtkMRMLModelSliceDisplayableManager::vtkInternal
     vtkMatrix4x4::Invert(this->SliceXYToRAS, rasToSliceXY.GetPointer());
     pipeline->TransformToSlice->SetMatrix(rasToSliceXY.GetPointer());
 
-    // optimization for slice to slice intersections which are 1 quad polydatas
-    // no need for 50^3 default locator divisons
-    if (polyData->GetPoints() != NULL && polyData->GetNumberOfPoints() <= 4)
-    {
-      vtkNew<vtkPointLocator> locator;
-      double *bounds = polyData->GetBounds();
-      locator->SetDivisions(2,2,2);
-      locator->InitPointInsertion(polyData->GetPoints(), bounds);
-      pipeline->Cutter->SetLocator(locator.GetPointer());
-    }
-
     // Update pipeline actor
     vtkActor2D* actor = vtkActor2D::SafeDownCast(pipeline->Actor);
     vtkPolyDataMapper2D* mapper = vtkPolyDataMapper2D::SafeDownCast(
@@ -0,0 +1,303 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkImageLabelStatistics.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkIdTypeArray.h>
+#include <vtkImageAccumulate.h>
+#include <vtkImageData.h>
+#include <vtkImageThreshold.h>
+#include <vtkImageToImageStencil.h>
+#include <vtkImageStencilData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+#include <vtkVersion.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateImages(int size, int numberOfLabels,
+                  vtkImageData* labelImage, vtkImageData* grayscaleImage)
+{
+  labelImage->SetDimensions(size, size, size);
+  grayscaleImage->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  labelImage->SetScalarTypeToShort();
+  labelImage->SetNumberOfScalarComponents(1);
+  labelImage->AllocateScalars();
+  grayscaleImage->SetScalarTypeToShort();
+  grayscaleImage->SetNumberOfScalarComponents(1);
+  grayscaleImage->AllocateScalars();
+#else
+  labelImage->AllocateScalars(VTK_SHORT, 1);
+  grayscaleImage->AllocateScalars(VTK_SHORT, 1);
+#endif
+  short* labelPtr = static_cast<short*>(labelImage->GetScalarPointer());
+  short* grayPtr = static_cast<short*>(grayscaleImage->GetScalarPointer());
+  // Labels are slabs along X with a few voxels of background in between,
+  // grayscale values are a ramp plus a label dependent offset.
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        int label = (i * numberOfLabels) / size;
+        *labelPtr++ = static_cast<short>(((i + j) % 7 == 0) ? 0 : label);
+        *grayPtr++ = static_cast<short>((i * 3 + j * 5 + k * 7) % 1000 - 200 + label);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+struct ReferenceStatistics
+{
+  ReferenceStatistics() : Count(0), Min(VTK_DOUBLE_MAX), Max(VTK_DOUBLE_MIN), Sum(0.) {}
+  vtkIdType Count;
+  double Min;
+  double Max;
+  double Sum;
+  std::vector<double> Values;
+};
+
+//----------------------------------------------------------------------------
+void ComputeReference(vtkImageData* labelImage, vtkImageData* grayscaleImage,
+                      std::map<double, ReferenceStatistics>& reference)
+{
+  short* labelPtr = static_cast<short*>(labelImage->GetScalarPointer());
+  short* grayPtr = static_cast<short*>(grayscaleImage->GetScalarPointer());
+  vtkIdType numberOfPoints = labelImage->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    ReferenceStatistics& stats = reference[labelPtr[i]];
+    double value = grayPtr[i];
+    ++stats.Count;
+    stats.Min = std::min(stats.Min, value);
+    stats.Max = std::max(stats.Max, value);
+    stats.Sum += value;
+    stats.Values.push_back(value);
+    }
+}
+
+//----------------------------------------------------------------------------
+bool IsClose(double a, double b, double tolerance = 1e-6)
+{
+  return std::fabs(a - b) <= tolerance * std::max(1., std::fabs(a));
+}
+
+//----------------------------------------------------------------------------
+bool TestStatistics(vtkImageData* labelImage, vtkImageData* grayscaleImage,
+                    int numberOfThreads)
+{
+  std::map<double, ReferenceStatistics> reference;
+  ComputeReference(labelImage, grayscaleImage, reference);
+
+  vtkNew<vtkImageLabelStatistics> statistics;
+  statistics->SetLabelImage(labelImage);
+  statistics->SetGrayscaleImage(grayscaleImage);
+  statistics->SetNumberOfThreads(numberOfThreads);
+  statistics->ComputeHistogramOn();
+  statistics->SetNumberOfBins(4096);
+  statistics->Update();
+
+  if (statistics->GetNumberOfLabels() != static_cast<int>(reference.size()))
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of labels: "
+              << statistics->GetNumberOfLabels() << " instead of "
+              << reference.size() << std::endl;
+    return false;
+    }
+  // Grayscale range is smaller than the number of bins: bin width is 1
+  if (statistics->GetHistogramBinWidth() != 1.)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong bin width: "
+              << statistics->GetHistogramBinWidth() << std::endl;
+    return false;
+    }
+
+  int n = 0;
+  for (std::map<double, ReferenceStatistics>::iterator it = reference.begin();
+       it != reference.end(); ++it, ++n)
+    {
+    ReferenceStatistics& expected = it->second;
+    double mean = expected.Sum / expected.Count;
+    double sumOfSquaredDifferences = 0.;
+    for (size_t i = 0; i < expected.Values.size(); ++i)
+      {
+      sumOfSquaredDifferences += (expected.Values[i] - mean) * (expected.Values[i] - mean);
+      }
+    double stdDev = expected.Count > 1 ?
+      sqrt(sumOfSquaredDifferences / (expected.Count - 1)) : 0.;
+    std::nth_element(expected.Values.begin(),
+                     expected.Values.begin() + (expected.Count - 1) / 2,
+                     expected.Values.end());
+    double median = expected.Values[(expected.Count - 1) / 2];
+
+    if (statistics->GetNthLabel(n) != it->first ||
+        statistics->GetNthCount(n) != expected.Count ||
+        statistics->GetNthMin(n) != expected.Min ||
+        statistics->GetNthMax(n) != expected.Max ||
+        !IsClose(statistics->GetNthMean(n), mean) ||
+        !IsClose(statistics->GetNthStandardDeviation(n), stdDev) ||
+        statistics->GetNthMedian(n) != median)
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong statistics for label "
+                << it->first << " with " << numberOfThreads << " threads:\n"
+                << " label: " << statistics->GetNthLabel(n) << "\n"
+                << " count: " << statistics->GetNthCount(n) << " vs " << expected.Count << "\n"
+                << " min: " << statistics->GetNthMin(n) << " vs " << expected.Min << "\n"
+                << " max: " << statistics->GetNthMax(n) << " vs " << expected.Max << "\n"
+                << " mean: " << statistics->GetNthMean(n) << " vs " << mean << "\n"
+                << " stddev: " << statistics->GetNthStandardDeviation(n) << " vs " << stdDev << "\n"
+                << " median: " << statistics->GetNthMedian(n) << " vs " << median << std::endl;
+      return false;
+      }
+
+    vtkNew<vtkIdTypeArray> histogram;
+    statistics->GetNthHistogram(n, histogram.GetPointer());
+    vtkIdType histogramCount = 0;
+    for (vtkIdType i = 0; i < histogram->GetNumberOfTuples(); ++i)
+      {
+      histogramCount += histogram->GetValue(i);
+      }
+    if (histogramCount != expected.Count)
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong histogram for label "
+                << it->first << ": " << histogramCount << " voxels instead of "
+                << expected.Count << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Statistics computed the way the LabelStatistics module used to: one
+// threshold + stencil + accumulate pipeline per label.
+bool TestPerformance(vtkImageData* labelImage, vtkImageData* grayscaleImage)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+
+  vtkNew<vtkImageLabelStatistics> statistics;
+  statistics->SetLabelImage(labelImage);
+  statistics->SetGrayscaleImage(grayscaleImage);
+  statistics->Update();
+
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkImageLabelStatistics\" "
+            << "type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  timer->StartTimer();
+
+  double range[2];
+  labelImage->GetScalarRange(range);
+  int n = 0;
+  for (int label = static_cast<int>(range[0]); label <= static_cast<int>(range[1]); ++label)
+    {
+    vtkNew<vtkImageThreshold> thresholder;
+    vtkNew<vtkImageToImageStencil> stencil;
+    vtkNew<vtkImageAccumulate> accumulate;
+#if (VTK_MAJOR_VERSION <= 5)
+    thresholder->SetInput(labelImage);
+#else
+    thresholder->SetInputData(labelImage);
+#endif
+    thresholder->SetInValue(1);
+    thresholder->SetOutValue(0);
+    thresholder->ReplaceOutOn();
+    thresholder->ThresholdBetween(label, label);
+    thresholder->SetOutputScalarType(grayscaleImage->GetScalarType());
+    stencil->SetInputConnection(thresholder->GetOutputPort());
+    stencil->ThresholdBetween(1, 1);
+#if (VTK_MAJOR_VERSION <= 5)
+    accumulate->SetInput(grayscaleImage);
+    accumulate->SetStencil(stencil->GetOutput());
+#else
+    accumulate->SetInputData(grayscaleImage);
+    stencil->Update();
+    accumulate->SetStencilData(stencil->GetOutput());
+#endif
+    accumulate->Update();
+    if (accumulate->GetVoxelCount() == 0)
+      {
+      continue;
+      }
+    if (statistics->GetNthLabel(n) != label ||
+        statistics->GetNthCount(n) != accumulate->GetVoxelCount() ||
+        statistics->GetNthMin(n) != accumulate->GetMin()[0] ||
+        statistics->GetNthMax(n) != accumulate->GetMax()[0] ||
+        !IsClose(statistics->GetNthMean(n), accumulate->GetMean()[0]))
+      {
+      std::cerr << "Line " << __LINE__ << ": statistics of label " << label
+                << " differ from vtkImageAccumulate" << std::endl;
+      return false;
+      }
+    ++n;
+    }
+
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"PerLabelImageAccumulate\" "
+            << "type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  if (n != statistics->GetNumberOfLabels())
+    {
+    std::cerr << "Line " << __LINE__ << ": " << n << " labels found by "
+              << "vtkImageAccumulate instead of "
+              << statistics->GetNumberOfLabels() << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatisticsTest1(int , char * [] )
+{
+  vtkNew<vtkImageLabelStatistics> statistics;
+  EXERCISE_BASIC_OBJECT_METHODS(statistics.GetPointer());
+
+  vtkNew<vtkImageData> labelImage;
+  vtkNew<vtkImageData> grayscaleImage;
+  CreateImages(48, 20, labelImage.GetPointer(), grayscaleImage.GetPointer());
+
+  bool res = true;
+  res = TestStatistics(labelImage.GetPointer(), grayscaleImage.GetPointer(), 1) && res;
+  res = TestStatistics(labelImage.GetPointer(), grayscaleImage.GetPointer(), 3) && res;
+  res = TestStatistics(labelImage.GetPointer(), grayscaleImage.GetPointer(), 8) && res;
+
+  vtkNew<vtkImageData> largeLabelImage;
+  vtkNew<vtkImageData> largeGrayscaleImage;
+  CreateImages(128, 100, largeLabelImage.GetPointer(), largeGrayscaleImage.GetPointer());
+  res = TestPerformance(largeLabelImage.GetPointer(), largeGrayscaleImage.GetPointer()) && res;
+
+  return res ? EXIT_SUCCESS : EXIT_FAILURE;
+}
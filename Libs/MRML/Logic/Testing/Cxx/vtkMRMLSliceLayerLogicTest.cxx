@@ -24,21 +24,29 @@
 // MRML includes
 #include "vtkMRMLCoreTestingMacros.h"
 #include "vtkMRMLScene.h"
+#include "vtkMRMLTransformNode.h"
 
 // VTK includes
 #include <vtkAssignAttribute.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkFloatArray.h>
+#include <vtkGridTransform.h>
 #include <vtkImageData.h>
 #include <vtkImageInterpolator.h>
 #include <vtkImageReslice.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkTimerLog.h>
 #include <vtkTrivialProducer.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+
 namespace
 {
 bool testDTIPipeline();
+bool testNonLinearTransform();
 }
 
 //----------------------------------------------------------------------------
@@ -73,6 +81,7 @@ int vtkMRMLSliceLayerLogicTest(int , char * [] )
 
   bool res = true;
   res = res && testDTIPipeline();
+  res = res && testNonLinearTransform();
   return res ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -140,4 +149,155 @@ bool testDTIPipeline()
   return true;
 }
 
+//----------------------------------------------------------------------------
+vtkImageData* resliceOutput(vtkMRMLSliceLayerLogic* logic, const char* name)
+{
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  logic->GetReslice()->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"" << name << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  return logic->GetReslice()->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+bool testNonLinearTransform()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  // Ramp volume centered on the origin
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(64, 64, 64);
+#if (VTK_MAJOR_VERSION <= 5)
+  imageData->SetScalarTypeToFloat();
+  imageData->SetNumberOfScalarComponents(1);
+  imageData->AllocateScalars();
+#else
+  imageData->AllocateScalars(VTK_FLOAT, 1);
+#endif
+  float* voxel = static_cast<float*>(imageData->GetScalarPointer());
+  for (int k = 0; k < 64; ++k)
+    {
+    for (int j = 0; j < 64; ++j)
+      {
+      for (int i = 0; i < 64; ++i)
+        {
+        *voxel++ = static_cast<float>(i + 2 * j + 3 * k);
+        }
+      }
+    }
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetOrigin(-32., -32., -32.);
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+
+  // Smooth warp. The transform from world is its inverse, which is computed
+  // iteratively for each point.
+  vtkNew<vtkImageData> displacementGrid;
+  displacementGrid->SetDimensions(9, 9, 9);
+  displacementGrid->SetOrigin(-40., -40., -40.);
+  displacementGrid->SetSpacing(10., 10., 10.);
+#if (VTK_MAJOR_VERSION <= 5)
+  displacementGrid->SetScalarTypeToDouble();
+  displacementGrid->SetNumberOfScalarComponents(3);
+  displacementGrid->AllocateScalars();
+#else
+  displacementGrid->AllocateScalars(VTK_DOUBLE, 3);
+#endif
+  double* displacement = static_cast<double*>(displacementGrid->GetScalarPointer());
+  for (int k = 0; k < 9; ++k)
+    {
+    for (int j = 0; j < 9; ++j)
+      {
+      for (int i = 0; i < 9; ++i)
+        {
+        *displacement++ = 2. * sin(j * 0.4);
+        *displacement++ = 2. * cos(i * 0.3);
+        *displacement++ = 0.5 * sin((i + k) * 0.2);
+        }
+      }
+    }
+  vtkNew<vtkGridTransform> warp;
+  warp->SetInterpolationModeToCubic();
+#if (VTK_MAJOR_VERSION <= 5)
+  warp->SetDisplacementGrid(displacementGrid.GetPointer());
+#else
+  warp->SetDisplacementGridData(displacementGrid.GetPointer());
+#endif
+  vtkNew<vtkMRMLTransformNode> transformNode;
+  transformNode->SetAndObserveTransformToParent(warp.GetPointer());
+  scene->AddNode(transformNode.GetPointer());
+  volumeNode->SetAndObserveTransformNodeID(transformNode->GetID());
+
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetLayoutName("Red");
+  sliceNode->SetDimensions(256, 256, 1);
+  sliceNode->SetFieldOfView(40., 40., 1.);
+  scene->AddNode(sliceNode.GetPointer());
+
+  vtkNew<vtkMRMLSliceLayerLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+  logic->SetSliceNode(sliceNode.GetPointer());
+  logic->SetVolumeNode(volumeNode.GetPointer());
+
+  // Transform evaluated for each pixel
+  logic->SetNonLinearTransformGridSpacing(0);
+  if (logic->GetReslice()->GetResliceTransform() != logic->GetXYToIJKTransform())
+    {
+    std::cerr << "Line " << __LINE__ << ": transform is sampled" << std::endl;
+    return false;
+    }
+  vtkNew<vtkImageData> expected;
+  expected->DeepCopy(resliceOutput(logic.GetPointer(), "ResliceNonLinearTransform"));
+
+  logic->SetNonLinearTransformGridSpacing(8);
+  vtkAbstractTransform* gridTransform = logic->GetReslice()->GetResliceTransform();
+  if (!vtkGridTransform::SafeDownCast(gridTransform))
+    {
+    std::cerr << "Line " << __LINE__ << ": transform is not sampled" << std::endl;
+    return false;
+    }
+  vtkImageData* output = resliceOutput(logic.GetPointer(), "ResliceDisplacementGrid");
+  float* outputPtr = static_cast<float*>(output->GetScalarPointer());
+  float* expectedPtr = static_cast<float*>(expected->GetScalarPointer());
+  double maxDifference = 0.;
+  for (vtkIdType i = 0; i < expected->GetNumberOfPoints(); ++i)
+    {
+    maxDifference = std::max(maxDifference,
+                             static_cast<double>(fabs(outputPtr[i] - expectedPtr[i])));
+    }
+  // about a fifth of a voxel
+  if (output->GetNumberOfPoints() != expected->GetNumberOfPoints() ||
+      maxDifference > 0.6)
+    {
+    std::cerr << "Line " << __LINE__ << ": sampled transform differs by "
+              << maxDifference << std::endl;
+    return false;
+    }
+
+  // Cached until the slice or the transform is modified
+  logic->UpdateTransforms();
+  if (logic->GetReslice()->GetResliceTransform() != gridTransform)
+    {
+    std::cerr << "Line " << __LINE__ << ": grid recomputed" << std::endl;
+    return false;
+    }
+  sliceNode->SetSliceOffset(1.);
+  vtkAbstractTransform* offsetGridTransform = logic->GetReslice()->GetResliceTransform();
+  if (offsetGridTransform == gridTransform)
+    {
+    std::cerr << "Line " << __LINE__ << ": grid not recomputed" << std::endl;
+    return false;
+    }
+  warp->Modified();
+  logic->UpdateTransforms();
+  if (logic->GetReslice()->GetResliceTransform() == offsetGridTransform)
+    {
+    std::cerr << "Line " << __LINE__ << ": grid not recomputed" << std::endl;
+    return false;
+    }
+  return true;
+}
+
 }
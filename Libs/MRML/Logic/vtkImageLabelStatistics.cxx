@@ -0,0 +1,644 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+  Module:    $RCSfile: vtkImageLabelStatistics.cxx,v $
+  Date:      $Date$
+  Version:   $Revision$
+
+=========================================================================auto=*/
+#include "vtkImageLabelStatistics.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMultiThreader.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelStatistics);
+
+namespace
+{
+
+// Label maps spanning less than that many values are accumulated into a
+// vector indexed by label value instead of a map.
+const vtkIdType DenseLabelSpanMaximum = 65536;
+
+//----------------------------------------------------------------------------
+struct LabelAccumulator
+{
+  LabelAccumulator()
+    : Label(0.)
+    , Count(0)
+    , Min(VTK_DOUBLE_MAX)
+    , Max(VTK_DOUBLE_MIN)
+    , Sum(0.)
+    , SumOfSquares(0.)
+  {}
+
+  void Merge(const LabelAccumulator& other)
+  {
+    this->Label = other.Label;
+    this->Count += other.Count;
+    this->Min = std::min(this->Min, other.Min);
+    this->Max = std::max(this->Max, other.Max);
+    this->Sum += other.Sum;
+    this->SumOfSquares += other.SumOfSquares;
+    if (this->Histogram.size() < other.Histogram.size())
+      {
+      this->Histogram.resize(other.Histogram.size(), 0);
+      }
+    for (size_t i = 0; i < other.Histogram.size(); ++i)
+      {
+      this->Histogram[i] += other.Histogram[i];
+      }
+  }
+
+  double Label;
+  vtkIdType Count;
+  double Min;
+  double Max;
+  double Sum;
+  double SumOfSquares;
+  std::vector<vtkIdType> Histogram;
+};
+
+//----------------------------------------------------------------------------
+/// Per-thread set of accumulators. Consecutive voxels usually share the same
+/// label, the last accumulator is cached to skip the lookup.
+class LabelAccumulatorTable
+{
+public:
+  LabelAccumulatorTable()
+    : LabelMin(0.)
+    , NumberOfBins(0)
+    , LastLabel(0.)
+    , Last(0)
+  {}
+
+  void Initialize(double labelMin, vtkIdType denseSpan, int numberOfBins)
+  {
+    this->LabelMin = labelMin;
+    this->NumberOfBins = numberOfBins;
+    this->Dense.clear();
+    this->Dense.resize(denseSpan);
+    this->Sparse.clear();
+    this->Last = 0;
+  }
+
+  LabelAccumulator& Get(double label)
+  {
+    if (this->Last && label == this->LastLabel)
+      {
+      return *this->Last;
+      }
+    LabelAccumulator* accumulator = this->Dense.empty() ?
+      &this->Sparse[label] :
+      &this->Dense[static_cast<vtkIdType>(label - this->LabelMin)];
+    if (accumulator->Count == 0)
+      {
+      accumulator->Label = label;
+      accumulator->Histogram.resize(this->NumberOfBins, 0);
+      }
+    this->LastLabel = label;
+    this->Last = accumulator;
+    return *accumulator;
+  }
+
+  void MergeInto(std::map<double, LabelAccumulator>& statistics)const
+  {
+    for (std::vector<LabelAccumulator>::const_iterator it = this->Dense.begin();
+         it != this->Dense.end(); ++it)
+      {
+      if (it->Count > 0)
+        {
+        statistics[it->Label].Merge(*it);
+        }
+      }
+    for (std::map<double, LabelAccumulator>::const_iterator it = this->Sparse.begin();
+         it != this->Sparse.end(); ++it)
+      {
+      statistics[it->first].Merge(it->second);
+      }
+  }
+
+protected:
+  double LabelMin;
+  int NumberOfBins;
+  std::vector<LabelAccumulator> Dense;
+  std::map<double, LabelAccumulator> Sparse;
+  double LastLabel;
+  LabelAccumulator* Last;
+};
+
+//----------------------------------------------------------------------------
+struct ThreadStruct
+{
+  vtkImageLabelStatistics* Filter;
+  vtkImageData* LabelImage;
+  vtkImageData* GrayscaleImage;
+  int Extent[6];
+  int NumberOfBins;
+  double HistogramMin;
+  double HistogramBinWidth;
+  std::vector<LabelAccumulatorTable> Tables;
+};
+
+//----------------------------------------------------------------------------
+// Split the extent along the slowest varying axis that can be split.
+// Return the number of pieces actually used.
+int SplitExtent(int splitExt[6], const int startExt[6], int num, int total)
+{
+  for (int i = 0; i < 6; ++i)
+    {
+    splitExt[i] = startExt[i];
+    }
+  int splitAxis = 2;
+  int min = startExt[4];
+  int max = startExt[5];
+  while (min >= max)
+    {
+    --splitAxis;
+    if (splitAxis < 0)
+      {
+      return 1;
+      }
+    min = startExt[splitAxis * 2];
+    max = startExt[splitAxis * 2 + 1];
+    }
+  int range = max - min + 1;
+  int valuesPerThread = (range + total - 1) / total;
+  int maxThreadIdUsed = (range + valuesPerThread - 1) / valuesPerThread - 1;
+  if (num < maxThreadIdUsed)
+    {
+    splitExt[splitAxis * 2] = min + num * valuesPerThread;
+    splitExt[splitAxis * 2 + 1] = splitExt[splitAxis * 2] + valuesPerThread - 1;
+    }
+  if (num == maxThreadIdUsed)
+    {
+    splitExt[splitAxis * 2] = min + num * valuesPerThread;
+    }
+  return maxThreadIdUsed + 1;
+}
+
+//----------------------------------------------------------------------------
+template <class TLabel, class TGray>
+void vtkImageLabelStatisticsExecute(ThreadStruct* str,
+                                    TLabel* labelPtr, TGray* grayPtr,
+                                    int extent[6], int threadId)
+{
+  vtkImageLabelStatistics* self = str->Filter;
+  LabelAccumulatorTable& table = str->Tables[threadId];
+
+  vtkIdType labelIncX, labelIncY, labelIncZ;
+  vtkIdType grayIncX, grayIncY, grayIncZ;
+  str->LabelImage->GetContinuousIncrements(extent, labelIncX, labelIncY, labelIncZ);
+  str->GrayscaleImage->GetContinuousIncrements(extent, grayIncX, grayIncY, grayIncZ);
+  const int labelComponents = str->LabelImage->GetNumberOfScalarComponents();
+  const int grayComponents = str->GrayscaleImage->GetNumberOfScalarComponents();
+
+  const int rowLength = extent[1] - extent[0] + 1;
+  const int maxY = extent[3] - extent[2];
+  const int maxZ = extent[5] - extent[4];
+  unsigned long count = 0;
+  unsigned long target = static_cast<unsigned long>((maxZ+1)*(maxY+1)/50.0) + 1;
+
+  const bool computeHistogram = str->NumberOfBins > 0;
+  const int lastBin = str->NumberOfBins - 1;
+  const double histogramMin = str->HistogramMin;
+  const double binScale = 1. / str->HistogramBinWidth;
+
+  for (int idxZ = 0; idxZ <= maxZ; ++idxZ)
+    {
+    for (int idxY = 0; !self->AbortExecute && idxY <= maxY; ++idxY)
+      {
+      if (!threadId)
+        {
+        if (!(count%target))
+          {
+          self->UpdateProgress(count/(50.0*target));
+          }
+        count++;
+        }
+      for (int idxX = 0; idxX < rowLength; ++idxX)
+        {
+        const double value = static_cast<double>(*grayPtr);
+        LabelAccumulator& accumulator =
+          table.Get(static_cast<double>(*labelPtr));
+        ++accumulator.Count;
+        accumulator.Sum += value;
+        accumulator.SumOfSquares += value * value;
+        if (value < accumulator.Min)
+          {
+          accumulator.Min = value;
+          }
+        if (value > accumulator.Max)
+          {
+          accumulator.Max = value;
+          }
+        if (computeHistogram)
+          {
+          int bin = static_cast<int>((value - histogramMin) * binScale);
+          bin = bin < 0 ? 0 : (bin > lastBin ? lastBin : bin);
+          ++accumulator.Histogram[bin];
+          }
+        labelPtr += labelComponents;
+        grayPtr += grayComponents;
+        }
+      labelPtr += labelIncY;
+      grayPtr += grayIncY;
+      }
+    labelPtr += labelIncZ;
+    grayPtr += grayIncZ;
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class TLabel>
+void vtkImageLabelStatisticsExecuteGray(ThreadStruct* str,
+                                        TLabel* labelPtr,
+                                        int extent[6], int threadId)
+{
+  void* grayPtr = str->GrayscaleImage->GetScalarPointerForExtent(extent);
+  switch (str->GrayscaleImage->GetScalarType())
+    {
+    vtkTemplateMacro(
+      vtkImageLabelStatisticsExecute(str, labelPtr, static_cast<VTK_TT*>(grayPtr),
+                                     extent, threadId));
+    default:
+      vtkErrorWithObjectMacro(str->Filter, << "Execute: Unknown grayscale ScalarType");
+      return;
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkImageLabelStatisticsThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ThreadStruct* str = static_cast<ThreadStruct*>(info->UserData);
+  int threadId = info->ThreadID;
+
+  int splitExt[6];
+  int total = SplitExtent(splitExt, str->Extent, threadId, info->NumberOfThreads);
+  if (threadId >= total)
+    {
+    return VTK_THREAD_RETURN_VALUE;
+    }
+
+  void* labelPtr = str->LabelImage->GetScalarPointerForExtent(splitExt);
+  switch (str->LabelImage->GetScalarType())
+    {
+    vtkTemplateMacro(
+      vtkImageLabelStatisticsExecuteGray(str, static_cast<VTK_TT*>(labelPtr),
+                                         splitExt, threadId));
+    default:
+      vtkErrorWithObjectMacro(str->Filter, << "Execute: Unknown label ScalarType");
+      break;
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageLabelStatistics::vtkInternal
+{
+public:
+  const LabelAccumulator* GetNth(int n)const;
+
+  std::vector<LabelAccumulator> Statistics;
+};
+
+//----------------------------------------------------------------------------
+const LabelAccumulator* vtkImageLabelStatistics::vtkInternal::GetNth(int n)const
+{
+  if (n < 0 || n >= static_cast<int>(this->Statistics.size()))
+    {
+    return 0;
+    }
+  return &this->Statistics[n];
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::vtkImageLabelStatistics()
+{
+  this->SetNumberOfInputPorts(2);
+  this->ComputeHistogram = 0;
+  this->NumberOfBins = 256;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  this->HistogramMin = 0.;
+  this->HistogramBinWidth = 1.;
+  this->Threader = vtkMultiThreader::New();
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelStatistics::~vtkImageLabelStatistics()
+{
+  this->Threader->Delete();
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetLabelImage(vtkImageData* image)
+{
+#if (VTK_MAJOR_VERSION <= 5)
+  this->SetInput(0, image);
+#else
+  this->SetInputData(0, image);
+#endif
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetLabelImageConnection(vtkAlgorithmOutput* port)
+{
+  this->SetInputConnection(0, port);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetGrayscaleImage(vtkImageData* image)
+{
+#if (VTK_MAJOR_VERSION <= 5)
+  this->SetInput(1, image);
+#else
+  this->SetInputData(1, image);
+#endif
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::SetGrayscaleImageConnection(vtkAlgorithmOutput* port)
+{
+  this->SetInputConnection(1, port);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::FillInputPortInformation(int port, vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  return this->Superclass::FillInputPortInformation(port, info);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::RequestUpdateExtent(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* vtkNotUsed(outputVector))
+{
+  // Statistics are computed on the whole volumes
+  for (int port = 0; port < 2; ++port)
+    {
+    vtkInformation* inInfo = inputVector[port]->GetInformationObject(0);
+    if (!inInfo)
+      {
+      continue;
+      }
+    int wholeExtent[6];
+    inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExtent);
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), wholeExtent, 6);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::RequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  this->Internal->Statistics.clear();
+
+  vtkImageData* labelImage = vtkImageData::GetData(inputVector[0]);
+  vtkImageData* grayscaleImage = vtkImageData::GetData(inputVector[1]);
+  vtkImageData* output = vtkImageData::GetData(outputVector);
+  if (!labelImage || !grayscaleImage)
+    {
+    vtkErrorMacro(<< "Both a label map and a grayscale input are required.");
+    return 1;
+    }
+  output->ShallowCopy(labelImage);
+
+  ThreadStruct str;
+  str.Filter = this;
+  str.LabelImage = labelImage;
+  str.GrayscaleImage = grayscaleImage;
+  labelImage->GetExtent(str.Extent);
+
+  int grayscaleExtent[6];
+  grayscaleImage->GetExtent(grayscaleExtent);
+  for (int i = 0; i < 6; ++i)
+    {
+    if (grayscaleExtent[i] != str.Extent[i])
+      {
+      vtkErrorMacro(<< "Label map and grayscale extents must match.");
+      return 1;
+      }
+    }
+  if (str.Extent[0] > str.Extent[1] ||
+      str.Extent[2] > str.Extent[3] ||
+      str.Extent[4] > str.Extent[5] ||
+      !labelImage->GetPointData()->GetScalars() ||
+      !grayscaleImage->GetPointData()->GetScalars())
+    {
+    return 1;
+    }
+
+  // Histogram bins
+  str.NumberOfBins = 0;
+  str.HistogramMin = 0.;
+  str.HistogramBinWidth = 1.;
+  if (this->ComputeHistogram)
+    {
+    double range[2];
+    grayscaleImage->GetScalarRange(range);
+    const int grayscaleType = grayscaleImage->GetScalarType();
+    const bool integral = grayscaleType != VTK_FLOAT && grayscaleType != VTK_DOUBLE;
+    str.HistogramMin = range[0];
+    if (integral)
+      {
+      const double span = range[1] - range[0] + 1.;
+      str.HistogramBinWidth = std::ceil(span / this->NumberOfBins);
+      str.NumberOfBins = static_cast<int>(std::ceil(span / str.HistogramBinWidth));
+      }
+    else
+      {
+      str.NumberOfBins = this->NumberOfBins;
+      str.HistogramBinWidth = range[1] > range[0] ?
+        (range[1] - range[0]) / this->NumberOfBins : 1.;
+      }
+    }
+  this->HistogramMin = str.HistogramMin;
+  this->HistogramBinWidth = str.HistogramBinWidth;
+
+  // Accumulators
+  double labelRange[2];
+  labelImage->GetScalarRange(labelRange);
+  const int labelType = labelImage->GetScalarType();
+  vtkIdType denseSpan = 0;
+  if (labelType != VTK_FLOAT && labelType != VTK_DOUBLE &&
+      labelRange[1] - labelRange[0] < DenseLabelSpanMaximum)
+    {
+    denseSpan = static_cast<vtkIdType>(labelRange[1] - labelRange[0]) + 1;
+    }
+  int numberOfThreads = this->NumberOfThreads;
+  str.Tables.resize(numberOfThreads);
+  for (int i = 0; i < numberOfThreads; ++i)
+    {
+    str.Tables[i].Initialize(labelRange[0], denseSpan, str.NumberOfBins);
+    }
+
+  this->Threader->SetNumberOfThreads(numberOfThreads);
+  this->Threader->SetSingleMethod(vtkImageLabelStatisticsThreadedExecute, &str);
+  this->Threader->SingleMethodExecute();
+
+  // Merge the per-thread accumulators, the map sorts the labels.
+  std::map<double, LabelAccumulator> statistics;
+  for (int i = 0; i < numberOfThreads; ++i)
+    {
+    str.Tables[i].MergeInto(statistics);
+    }
+  this->Internal->Statistics.reserve(statistics.size());
+  for (std::map<double, LabelAccumulator>::const_iterator it = statistics.begin();
+       it != statistics.end(); ++it)
+    {
+    this->Internal->Statistics.push_back(it->second);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelStatistics::GetNumberOfLabels()const
+{
+  return static_cast<int>(this->Internal->Statistics.size());
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetNthLabel(int n)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  return accumulator ? accumulator->Label : 0.;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageLabelStatistics::GetNthCount(int n)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  return accumulator ? accumulator->Count : 0;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetNthMin(int n)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  return accumulator ? accumulator->Min : 0.;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetNthMax(int n)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  return accumulator ? accumulator->Max : 0.;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetNthMean(int n)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  if (!accumulator || accumulator->Count == 0)
+    {
+    return 0.;
+    }
+  return accumulator->Sum / accumulator->Count;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetNthStandardDeviation(int n)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  if (!accumulator || accumulator->Count < 2)
+    {
+    return 0.;
+    }
+  double count = static_cast<double>(accumulator->Count);
+  double variance = (accumulator->SumOfSquares -
+                     accumulator->Sum * accumulator->Sum / count) / (count - 1.);
+  return variance > 0. ? sqrt(variance) : 0.;
+}
+
+//----------------------------------------------------------------------------
+double vtkImageLabelStatistics::GetNthMedian(int n)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  if (!accumulator || accumulator->Histogram.empty())
+    {
+    return 0.;
+    }
+  // lower median: value of the ((count+1)/2)th voxel
+  vtkIdType half = (accumulator->Count + 1) / 2;
+  vtkIdType cumulated = 0;
+  size_t bin = 0;
+  for (; bin < accumulator->Histogram.size(); ++bin)
+    {
+    cumulated += accumulator->Histogram[bin];
+    if (cumulated >= half)
+      {
+      break;
+      }
+    }
+  double median = this->HistogramMin + bin * this->HistogramBinWidth;
+  // Integral bins of width 1 contain a single value
+  if (this->HistogramBinWidth != 1.)
+    {
+    median += this->HistogramBinWidth / 2.;
+    }
+  return std::max(accumulator->Min, std::min(accumulator->Max, median));
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::GetNthHistogram(int n, vtkIdTypeArray* histogram)const
+{
+  const LabelAccumulator* accumulator = this->Internal->GetNth(n);
+  if (!histogram)
+    {
+    return;
+    }
+  histogram->SetNumberOfComponents(1);
+  histogram->SetNumberOfTuples(accumulator ? accumulator->Histogram.size() : 0);
+  if (!accumulator)
+    {
+    return;
+    }
+  for (size_t i = 0; i < accumulator->Histogram.size(); ++i)
+    {
+    histogram->SetValue(i, accumulator->Histogram[i]);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "ComputeHistogram: " << this->ComputeHistogram << "\n";
+  os << indent << "NumberOfBins: " << this->NumberOfBins << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "HistogramMin: " << this->HistogramMin << "\n";
+  os << indent << "HistogramBinWidth: " << this->HistogramBinWidth << "\n";
+  os << indent << "NumberOfLabels: " << this->GetNumberOfLabels() << "\n";
+}
@@ -0,0 +1,136 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+  Module:    $RCSfile: vtkImageLabelStatistics.h,v $
+  Date:      $Date$
+  Version:   $Revision$
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageLabelStatistics_h
+#define __vtkImageLabelStatistics_h
+
+#include "vtkMRMLLogicWin32Header.h"
+
+// VTK includes
+#include <vtkImageAlgorithm.h>
+#include <vtkMultiThreader.h>
+#include <vtkVersion.h>
+
+class vtkAlgorithmOutput;
+class vtkIdTypeArray;
+class vtkImageData;
+
+/// \brief Compute grayscale statistics for every label of a label map.
+///
+/// The label map (input 0) and the grayscale volume (input 1) are traversed
+/// once: each thread accumulates count, min, max, sum and sum of squares for
+/// all the labels found in its piece of the volume and the per-thread
+/// accumulators are merged when all the threads are done.
+/// This replaces the "one vtkImageThreshold + vtkImageToImageStencil +
+/// vtkImageAccumulate pipeline per label" approach that required a full
+/// pass over the volume for each label.
+///
+/// If ComputeHistogram is enabled, a histogram of the grayscale values is
+/// also accumulated per label and used to estimate the median. When the
+/// grayscale type is integral and its range fits into NumberOfBins, the bin
+/// width is 1 and the median is exact.
+///
+/// The output is a shallow copy of the label map.
+/// Grayscale and label map must have the same extent.
+class VTK_MRML_LOGIC_EXPORT vtkImageLabelStatistics : public vtkImageAlgorithm
+{
+public:
+  static vtkImageLabelStatistics *New();
+  vtkTypeMacro(vtkImageLabelStatistics,vtkImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// Set the label map input (port 0)
+  void SetLabelImage(vtkImageData* image);
+  void SetLabelImageConnection(vtkAlgorithmOutput* port);
+
+  ///
+  /// Set the grayscale input (port 1)
+  void SetGrayscaleImage(vtkImageData* image);
+  void SetGrayscaleImageConnection(vtkAlgorithmOutput* port);
+
+  ///
+  /// Accumulate a per label histogram of the grayscale values.
+  /// It is required to compute the median.
+  /// Off by default.
+  vtkSetMacro(ComputeHistogram, int);
+  vtkGetMacro(ComputeHistogram, int);
+  vtkBooleanMacro(ComputeHistogram, int);
+
+  ///
+  /// Maximum number of histogram bins. The histogram spans the whole
+  /// grayscale scalar range.
+  /// 256 by default.
+  vtkSetClampMacro(NumberOfBins, int, 1, VTK_INT_MAX);
+  vtkGetMacro(NumberOfBins, int);
+
+  ///
+  /// Number of threads used to traverse the volume.
+  /// By default, vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  ///
+  /// Number of labels found in the label map after Update()
+  int GetNumberOfLabels()const;
+
+  ///
+  /// Statistics of the nth label (sorted by increasing label value).
+  /// The standard deviation is the sample standard deviation (N-1).
+  double GetNthLabel(int n)const;
+  vtkIdType GetNthCount(int n)const;
+  double GetNthMin(int n)const;
+  double GetNthMax(int n)const;
+  double GetNthMean(int n)const;
+  double GetNthStandardDeviation(int n)const;
+  /// Only valid if ComputeHistogram is on, 0. otherwise.
+  double GetNthMedian(int n)const;
+  /// Copy the histogram of the nth label into \a histogram.
+  /// Only valid if ComputeHistogram is on.
+  void GetNthHistogram(int n, vtkIdTypeArray* histogram)const;
+
+  ///
+  /// Lower bound and width of the histogram bins after Update().
+  vtkGetMacro(HistogramMin, double);
+  vtkGetMacro(HistogramBinWidth, double);
+
+protected:
+  vtkImageLabelStatistics();
+  ~vtkImageLabelStatistics();
+
+  virtual int FillInputPortInformation(int port, vtkInformation* info);
+  virtual int RequestUpdateExtent(vtkInformation*,
+                                  vtkInformationVector**,
+                                  vtkInformationVector*);
+  virtual int RequestData(vtkInformation*,
+                          vtkInformationVector**,
+                          vtkInformationVector*);
+
+  int ComputeHistogram;
+  int NumberOfBins;
+  int NumberOfThreads;
+  double HistogramMin;
+  double HistogramBinWidth;
+
+  vtkMultiThreader* Threader;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkImageLabelStatistics(const vtkImageLabelStatistics&);  /// Not implemented.
+  void operator=(const vtkImageLabelStatistics&);  /// Not implemented.
+};
+
+#endif
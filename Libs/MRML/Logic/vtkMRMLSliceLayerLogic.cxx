@@ -32,6 +32,7 @@
 #include <vtkDiffusionTensorMathematics.h>
 #include <vtkFloatArray.h>
 #include <vtkGeneralTransform.h>
+#include <vtkGridTransform.h>
 #include <vtkImageData.h>
 #include <vtkImageReslice.h>
 #include <vtkInformation.h>
@@ -39,6 +40,7 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 #include <vtkTrivialProducer.h>
 #include <vtkTransform.h>
 #include <vtkVersion.h>
@@ -47,6 +49,10 @@
 #include <vtkImageStencilData.h>
 #endif
 
+// STD includes
+#include <algorithm>
+#include <vector>
+
 //
 #include "vtkImageLabelOutline.h"
 
@@ -114,9 +120,87 @@ void SnapToPermuteMatrix(vtkTransform* transform)
   }
 }
 
+//----------------------------------------------------------------------------
+class vtkMRMLSliceLayerLogic::vtkInternal
+{
+public:
+  /// Return a grid transform that samples xyToIJK every spacing pixels over
+  /// the output extent of the reslice. The previous grid is returned as is
+  /// if key didn't change.
+  vtkAbstractTransform* GetXYToIJKGridTransform(vtkAbstractTransform* xyToIJK,
+                                                const int dimensions[3],
+                                                int spacing,
+                                                const std::vector<double>& key);
+
+  vtkSmartPointer<vtkGridTransform> XYToIJKGridTransform;
+  std::vector<double> XYToIJKGridKey;
+};
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkMRMLSliceLayerLogic::vtkInternal
+::GetXYToIJKGridTransform(vtkAbstractTransform* xyToIJK, const int dimensions[3],
+                          int spacing, const std::vector<double>& key)
+{
+  if (this->XYToIJKGridTransform.GetPointer() != 0 && key == this->XYToIJKGridKey)
+    {
+    return this->XYToIJKGridTransform;
+    }
+
+  // At least 2 samples per axis, the last one is at or past the last pixel
+  int gridDimensions[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    gridDimensions[i] = std::max(dimensions[i] - 1, 0) / spacing + 2;
+    }
+  vtkNew<vtkImageData> displacementGrid;
+  displacementGrid->SetDimensions(gridDimensions);
+  displacementGrid->SetOrigin(0., 0., 0.);
+  displacementGrid->SetSpacing(spacing, spacing, spacing);
+#if (VTK_MAJOR_VERSION <= 5)
+  displacementGrid->SetScalarTypeToFloat();
+  displacementGrid->SetNumberOfScalarComponents(3);
+  displacementGrid->AllocateScalars();
+#else
+  displacementGrid->AllocateScalars(VTK_FLOAT, 3);
+#endif
+  float* displacement = static_cast<float*>(displacementGrid->GetScalarPointer());
+  double point[3];
+  double transformedPoint[3];
+  for (int k = 0; k < gridDimensions[2]; ++k)
+    {
+    point[2] = k * spacing;
+    for (int j = 0; j < gridDimensions[1]; ++j)
+      {
+      point[1] = j * spacing;
+      for (int i = 0; i < gridDimensions[0]; ++i)
+        {
+        point[0] = i * spacing;
+        xyToIJK->TransformPoint(point, transformedPoint);
+        *displacement++ = static_cast<float>(transformedPoint[0] - point[0]);
+        *displacement++ = static_cast<float>(transformedPoint[1] - point[1]);
+        *displacement++ = static_cast<float>(transformedPoint[2] - point[2]);
+        }
+      }
+    }
+
+  // A new transform (instead of a modified one) so that the reslice doesn't
+  // keep any state computed with the previous grid.
+  this->XYToIJKGridTransform = vtkSmartPointer<vtkGridTransform>::New();
+  this->XYToIJKGridTransform->SetInterpolationModeToLinear();
+#if (VTK_MAJOR_VERSION <= 5)
+  this->XYToIJKGridTransform->SetDisplacementGrid(displacementGrid.GetPointer());
+#else
+  this->XYToIJKGridTransform->SetDisplacementGridData(displacementGrid.GetPointer());
+#endif
+  this->XYToIJKGridKey = key;
+  return this->XYToIJKGridTransform;
+}
+
 //----------------------------------------------------------------------------
 vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
 {
+  this->Internal = new vtkInternal;
+
   this->VolumeNode = 0;
   this->VolumeDisplayNode = 0;
   this->VolumeDisplayNodeUVW = 0;
@@ -161,6 +245,7 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->ResliceUVW->GenerateStencilOutputOn();
 
   this->UpdatingTransforms = 0;
+  this->NonLinearTransformGridSpacing = 8;
 }
 
 //----------------------------------------------------------------------------
@@ -183,6 +268,7 @@ vtkMRMLSliceLayerLogic::~vtkMRMLSliceLayerLogic()
   this->SetVolumeNode(0);
   this->XYToIJKTransform->Delete();
   this->UVWToIJKTransform->Delete();
+  delete this->Internal;
 
 #if (VTK_MAJOR_VERSION <= 5)
   this->Reslice->SetInput( 0 );
@@ -562,10 +648,27 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
       {
       SnapToPermuteMatrix(linearXYToIJKTransform);
       this->Reslice->SetResliceTransform(linearXYToIJKTransform);
+      this->Internal->XYToIJKGridTransform = 0;
+      }
+    else if (this->NonLinearTransformGridSpacing > 0)
+      {
+      // Non-linear transforms (e.g. inverse of a grid or bspline transform)
+      // are expensive to evaluate for every pixel: sample them on a coarse
+      // grid that is only recomputed when the slice, the volume or the
+      // transforms change.
+      std::vector<double> key(xyToIJK->Element[0], xyToIJK->Element[0] + 16);
+      key.insert(key.end(), rasToIJK->Element[0], rasToIJK->Element[0] + 16);
+      key.insert(key.end(), dimensions, dimensions + 3);
+      key.push_back(this->NonLinearTransformGridSpacing);
+      key.push_back(this->VolumeNode->GetMTime());
+      key.push_back(transformNode ? transformNode->GetTransformToWorldMTime() : 0);
+      this->Reslice->SetResliceTransform(this->Internal->GetXYToIJKGridTransform(
+        this->XYToIJKTransform, dimensions, this->NonLinearTransformGridSpacing, key));
       }
     else
       {
       this->Reslice->SetResliceTransform(this->XYToIJKTransform);
+      this->Internal->XYToIJKGridTransform = 0;
       }
     vtkSmartPointer<vtkTransform> linearUVWToIJKTransform = vtkSmartPointer<vtkTransform>::New();
     if (vtkMRMLTransformNode::IsGeneralTransformLinear(this->UVWToIJKTransform, linearUVWToIJKTransform))
@@ -614,6 +717,18 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::SetNonLinearTransformGridSpacing(int spacing)
+{
+  spacing = std::max(spacing, 0);
+  if (spacing == this->NonLinearTransformGridSpacing)
+    {
+    return;
+    }
+  this->NonLinearTransformGridSpacing = spacing;
+  this->UpdateTransforms();
+}
+
 //----------------------------------------------------------------------------
 vtkImageData* vtkMRMLSliceLayerLogic::GetImageData()
 {
@@ -1172,6 +1287,8 @@ void vtkMRMLSliceLayerLogic::PrintSelf(ostream& os, vtkIndent indent)
     }
 
   os << indent << "IsLabelLayer: " << this->GetIsLabelLayer() << "\n";
+  os << indent << "NonLinearTransformGridSpacing: "
+     << this->NonLinearTransformGridSpacing << "\n";
   os << indent << "LabelOutline:\n";
   if (this->LabelOutline)
     {
@@ -133,6 +133,18 @@ public:
   /// The current reslice transform XYToIJK
   vtkGetObjectMacro (XYToIJKTransform, vtkGeneralTransform);
 
+  ///
+  /// Spacing (in pixels) of the displacement grid used to reslice volumes
+  /// under a non-linear transform. Instead of evaluating XYToIJKTransform
+  /// for every pixel, the transform is sampled on a grid of that spacing
+  /// that is then trilinearly interpolated by the reslice.
+  /// The grid is only resampled when the slice node, the volume geometry
+  /// or the transform to world (see vtkMRMLTransformNode::GetTransformToWorldMTime())
+  /// are modified.
+  /// 0 evaluates the transform for every pixel. 8 by default.
+  vtkGetMacro (NonLinearTransformGridSpacing, int);
+  void SetNonLinearTransformGridSpacing (int spacing);
+
 
 protected:
   vtkMRMLSliceLayerLogic();
@@ -191,6 +203,11 @@ protected:
   int IsLabelLayer;
 
   int UpdatingTransforms;
+
+  int NonLinearTransformGridSpacing;
+
+  class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
@@ -0,0 +1,199 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Qt includes
+#include <QApplication>
+#include <QTime>
+
+// CTK includes
+#include "ctkTest.h"
+
+// MRML includes
+#include "qMRMLSceneModel.h"
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <iostream>
+
+// ----------------------------------------------------------------------------
+class qMRMLSceneModelBenchmarkTester: public QObject
+{
+  Q_OBJECT
+  void populateScene(vtkMRMLScene* scene, int nodeCount);
+  void printEventsPerSecond(const char* name, int eventCount, int msecs);
+private slots:
+  void testAddNodes();
+  void testAddNodes_data();
+  void testModifyNodes();
+  void testModifyNodes_data();
+  void testRemoveNodes();
+  void testRemoveNodes_data();
+  void testLazyUpdate();
+};
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::populateScene(vtkMRMLScene* scene, int nodeCount)
+{
+  for (int i = 0; i < nodeCount; ++i)
+    {
+    vtkNew<vtkMRMLModelNode> node;
+    scene->AddNode(node.GetPointer());
+    }
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::printEventsPerSecond(
+  const char* name, int eventCount, int msecs)
+{
+  std::cout << "<DartMeasurement name=\"" << name << "\" type=\"numeric/double\">"
+            << 1000. * eventCount / qMax(msecs, 1)
+            << "</DartMeasurement>" << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::testAddNodes()
+{
+  QFETCH(int, nodeCount);
+  qMRMLSceneModel sceneModel;
+  vtkNew<vtkMRMLScene> scene;
+  sceneModel.setMRMLScene(scene.GetPointer());
+
+  QTime time;
+  time.start();
+  this->populateScene(scene.GetPointer(), nodeCount);
+  this->printEventsPerSecond(
+    qPrintable(QString("NodeAddedPerSecond%1").arg(nodeCount)), nodeCount, time.elapsed());
+
+  QCOMPARE(sceneModel.rowCount(sceneModel.mrmlSceneIndex()), scene->GetNumberOfNodes());
+  vtkMRMLNode* lastNode = scene->GetNthNode(scene->GetNumberOfNodes() - 1);
+  QCOMPARE(sceneModel.indexFromNode(lastNode).row(), scene->GetNumberOfNodes() - 1);
+  QCOMPARE(sceneModel.mrmlNodeFromIndex(sceneModel.indexFromNode(lastNode)), lastNode);
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::testAddNodes_data()
+{
+  QTest::addColumn<int>("nodeCount");
+  QTest::newRow("1000") << 1000;
+  QTest::newRow("20000") << 20000;
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::testModifyNodes()
+{
+  QFETCH(int, nodeCount);
+  qMRMLSceneModel sceneModel;
+  sceneModel.setListenNodeModifiedEvent(qMRMLSceneModel::AllNodes);
+  vtkNew<vtkMRMLScene> scene;
+  sceneModel.setMRMLScene(scene.GetPointer());
+  this->populateScene(scene.GetPointer(), nodeCount);
+
+  // Modify the nodes at the end of the scene, the worst case for a search
+  const int eventCount = 1000;
+  QTime time;
+  time.start();
+  for (int i = 0; i < eventCount; ++i)
+    {
+    vtkMRMLNode* node = scene->GetNthNode(scene->GetNumberOfNodes() - 1 - (i % 100));
+    node->SetName(qPrintable(QString("Modified%1").arg(i)));
+    }
+  this->printEventsPerSecond(
+    qPrintable(QString("NodeModifiedPerSecond%1").arg(nodeCount)), eventCount, time.elapsed());
+
+  vtkMRMLNode* lastNode = scene->GetNthNode(scene->GetNumberOfNodes() - 1);
+  QCOMPARE(sceneModel.itemFromNode(lastNode)->text(), QString(lastNode->GetName()));
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::testModifyNodes_data()
+{
+  this->testAddNodes_data();
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::testRemoveNodes()
+{
+  QFETCH(int, nodeCount);
+  qMRMLSceneModel sceneModel;
+  vtkNew<vtkMRMLScene> scene;
+  sceneModel.setMRMLScene(scene.GetPointer());
+  this->populateScene(scene.GetPointer(), nodeCount);
+
+  const int eventCount = 1000;
+  QTime time;
+  time.start();
+  for (int i = 0; i < eventCount; ++i)
+    {
+    scene->RemoveNode(scene->GetNthNode(scene->GetNumberOfNodes() - 1));
+    }
+  this->printEventsPerSecond(
+    qPrintable(QString("NodeRemovedPerSecond%1").arg(nodeCount)), eventCount, time.elapsed());
+
+  QCOMPARE(sceneModel.rowCount(sceneModel.mrmlSceneIndex()), scene->GetNumberOfNodes());
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::testRemoveNodes_data()
+{
+  this->testAddNodes_data();
+}
+
+// ----------------------------------------------------------------------------
+void qMRMLSceneModelBenchmarkTester::testLazyUpdate()
+{
+  qMRMLSceneModel sceneModel;
+  sceneModel.setListenNodeModifiedEvent(qMRMLSceneModel::AllNodes);
+  sceneModel.setLazyUpdate(true);
+  vtkNew<vtkMRMLScene> scene;
+  sceneModel.setMRMLScene(scene.GetPointer());
+  this->populateScene(scene.GetPointer(), 100);
+
+  vtkSmartPointer<vtkMRMLNode> removedNode = scene->GetNthNode(10);
+  vtkMRMLNode* modifiedNode = scene->GetNthNode(20);
+  QStandardItem* modifiedItem = sceneModel.itemFromNode(modifiedNode);
+
+  scene->StartState(vtkMRMLScene::BatchProcessState);
+  scene->RemoveNode(removedNode);
+  modifiedNode->SetName("Modified");
+  vtkNew<vtkMRMLModelNode> addedNode;
+  scene->AddNode(addedNode.GetPointer());
+  // Nothing changes until the end of the batch processing
+  QVERIFY(sceneModel.indexFromNode(removedNode).isValid());
+  QVERIFY(!sceneModel.indexFromNode(addedNode.GetPointer()).isValid());
+  scene->EndState(vtkMRMLScene::BatchProcessState);
+
+  QCOMPARE(sceneModel.rowCount(sceneModel.mrmlSceneIndex()), scene->GetNumberOfNodes());
+  QVERIFY(!sceneModel.indexFromNode(removedNode).isValid());
+  QCOMPARE(sceneModel.mrmlNodeFromIndex(sceneModel.indexFromNode(addedNode.GetPointer())),
+           static_cast<vtkMRMLNode*>(addedNode.GetPointer()));
+  // The model is updated, not rebuilt
+  QCOMPARE(sceneModel.itemFromNode(modifiedNode), modifiedItem);
+  QCOMPARE(modifiedItem->text(), QString("Modified"));
+
+  // The node removed during the batch processing is not observed anymore
+  QVERIFY(!removedNode->HasObserver(vtkCommand::ModifiedEvent));
+}
+
+// ----------------------------------------------------------------------------
+CTK_TEST_MAIN(qMRMLSceneModelBenchmarkTest)
+#include "moc_qMRMLSceneModelBenchmarkTest.cxx"
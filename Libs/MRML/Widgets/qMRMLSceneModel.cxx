@@ -83,6 +83,16 @@ void qMRMLSceneModelPrivate::init()
 
   QObject::connect(q, SIGNAL(itemChanged(QStandardItem*)),
                    q, SLOT(onItemChanged(QStandardItem*)));
+  // Connected first to have the node items indexed before any other slot
+  // is notified of the change.
+  QObject::connect(q, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                   q, SLOT(onRowsInserted(QModelIndex,int,int)));
+  QObject::connect(q, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                   q, SLOT(onRowsAboutToBeRemoved(QModelIndex,int,int)));
+  QObject::connect(q, SIGNAL(columnsAboutToBeRemoved(QModelIndex,int,int)),
+                   q, SLOT(onColumnsAboutToBeRemoved(QModelIndex,int,int)));
+  QObject::connect(q, SIGNAL(modelAboutToBeReset()),
+                   q, SLOT(onModelAboutToBeReset()));
 
   q->setNameColumn(0);
   q->setListenNodeModifiedEvent(qMRMLSceneModel::OnlyVisibleNodes);
@@ -92,21 +102,13 @@ void qMRMLSceneModelPrivate::init()
 QModelIndexList qMRMLSceneModelPrivate::indexes(const QString& nodeID)const
 {
   Q_Q(const qMRMLSceneModel);
-  QModelIndex scene = q->mrmlSceneIndex();
-  if (scene == QModelIndex())
-    {
-    return QModelIndexList();
-    }
-  // QAbstractItemModel::match doesn't browse through columns
-  // we need to do it manually
-  QModelIndexList nodeIndexes = q->match(
-    scene, qMRMLSceneModel::UIDRole, nodeID,
-    1, Qt::MatchExactly | Qt::MatchRecursive);
-  Q_ASSERT(nodeIndexes.size() <= 1); // we know for sure it won't be more than 1
-  if (nodeIndexes.size() == 0)
+  QModelIndexList nodeIndexes;
+  QStandardItem* nodeItem = this->NodeItems.value(nodeID, 0);
+  if (nodeItem == 0)
     {
     return nodeIndexes;
     }
+  nodeIndexes << nodeItem->index();
   // Add the QModelIndexes from the other columns
   const int row = nodeIndexes[0].row();
   QModelIndex nodeParentIndex = nodeIndexes[0].parent();
@@ -253,6 +255,180 @@ void qMRMLSceneModelPrivate::reparentItems(
   newParentItem->insertRow(pos, children);
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::addNodeItems(QStandardItem* item)
+{
+  if (item == 0)
+    {
+    return;
+    }
+  QString uid = item->data(qMRMLSceneModel::UIDRole).toString();
+  // Only node items have a pointer (the scene item has one as well)
+  if (uid != "scene" && item->data(qMRMLSceneModel::PointerRole).isValid())
+    {
+    this->NodeItems[uid] = item;
+    }
+  for (int i = 0; i < item->rowCount(); ++i)
+    {
+    this->addNodeItems(item->child(i, 0));
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::removeNodeItems(QStandardItem* item)
+{
+  if (item == 0)
+    {
+    return;
+    }
+  QHash<QString, QStandardItem*>::iterator it =
+    this->NodeItems.find(item->data(qMRMLSceneModel::UIDRole).toString());
+  // The item may have already been replaced by a copy (drag&drop)
+  if (it != this->NodeItems.end() && it.value() == item)
+    {
+    this->NodeItems.erase(it);
+    }
+  for (int i = 0; i < item->rowCount(); ++i)
+    {
+    this->removeNodeItems(item->child(i, 0));
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::removeNodeItem(QStandardItem* item)
+{
+  Q_Q(qMRMLSceneModel);
+  // The children may be lost if not reparented, we ensure they got reparented.
+  while (item->rowCount())
+    {
+    // we need to remove the children from the node to remove because they
+    // would be automatically deleted in QStandardItemModel::removeRow()
+    this->Orphans.push_back(item->takeRow(0));
+    }
+  // Remove the item from any orphan list if it exist as we don't want to
+  // add it back later in reparentOrphans()
+  foreach(QList<QStandardItem*> orphans, this->Orphans)
+    {
+    if (orphans.contains(item))
+      {
+      this->Orphans.removeAll(orphans);
+      }
+    }
+  if (item->parent())
+    {
+    item->parent()->removeRow(item->row());
+    }
+  else
+    {
+    q->removeRow(item->row());
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::reparentOrphans()
+{
+  Q_Q(qMRMLSceneModel);
+  // The list may grow while browsing it
+  for (int i = 0; i < this->Orphans.count(); ++i)
+    {
+    QList<QStandardItem*> orphans = this->Orphans[i];
+    QStandardItem* orphan = orphans[0];
+    // Make sure that the orphans have not already been reparented.
+    if (orphan->parent())
+      {
+      // Not sure how it is possible, but if it is, then we might want to
+      // review the logic behind.
+      Q_ASSERT(orphan->parent() == 0);
+      continue;
+      }
+    vtkMRMLNode* node = q->mrmlNodeFromItem(orphan);
+    if (node == 0)
+      {
+      // The node has been removed during the same batch processing, its
+      // children are orphans too.
+      while (orphan->rowCount())
+        {
+        this->Orphans.push_back(orphan->takeRow(0));
+        }
+      qDeleteAll(orphans);
+      continue;
+      }
+    int newIndex = q->nodeIndex(node);
+    QStandardItem* newParentItem = q->itemFromNode(q->parentNode(node));
+    if (newParentItem == 0)
+      {
+      newParentItem = q->mrmlSceneItem();
+      }
+    Q_ASSERT(newParentItem);
+    this->reparentItems(orphans, newIndex, newParentItem);
+    }
+  this->Orphans.clear();
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModelPrivate::applyPendingChanges()
+{
+  Q_Q(qMRMLSceneModel);
+  QStringList removedNodes = this->PendingRemovedNodes;
+  QStringList addedNodes = this->PendingAddedNodes;
+  QSet<QString> modifiedNodes = this->PendingModifiedNodes;
+  this->PendingRemovedNodes.clear();
+  this->PendingAddedNodes.clear();
+  this->PendingModifiedNodes.clear();
+  if (!this->MRMLScene || !q->mrmlSceneItem())
+    {
+    return;
+    }
+
+  foreach(const QString& nodeID, removedNodes)
+    {
+    QStandardItem* nodeItem = this->NodeItems.value(nodeID, 0);
+    if (nodeItem)
+      {
+      this->removeNodeItem(nodeItem);
+      this->reparentOrphans();
+      }
+    }
+
+  this->MisplacedNodes.clear();
+  foreach(const QString& nodeID, addedNodes)
+    {
+    vtkMRMLNode* node = this->MRMLScene->GetNodeByID(nodeID.toLatin1());
+    // The node may have been removed meanwhile
+    if (node)
+      {
+      q->insertNode(node);
+      }
+    }
+  foreach(vtkMRMLNode* misplacedNode, this->MisplacedNodes)
+    {
+    q->onMRMLNodeModified(misplacedNode);
+    }
+
+  bool outOfSync = false;
+  foreach(const QString& nodeID, modifiedNodes)
+    {
+    vtkMRMLNode* node = this->MRMLScene->GetNodeByID(nodeID.toLatin1());
+    if (!node)
+      {
+      // The ID of the node changed
+      outOfSync = outOfSync || this->NodeItems.contains(nodeID);
+      continue;
+      }
+    if (this->NodeItems.contains(nodeID))
+      {
+      q->updateNodeItems(node, nodeID);
+      }
+    }
+
+  // Nodes added without notification are only found by rebuilding the model
+  if (outOfSync ||
+      this->NodeItems.count() != this->MRMLScene->GetNumberOfNodes())
+    {
+    q->updateScene();
+    }
+}
+
 //------------------------------------------------------------------------------
 // qMRMLSceneModel
 //------------------------------------------------------------------------------
@@ -440,53 +616,17 @@ QModelIndex qMRMLSceneModel::indexFromNode(vtkMRMLNode* node, int column)const
     return QModelIndex();
     }
 
-  QModelIndex nodeIndex;
-
-  // Try to find the nodeIndex in the cache first
-  QMap<vtkMRMLNode*,QPersistentModelIndex>::iterator rowCacheIt=d->RowCache.find(node);
-  if (rowCacheIt==d->RowCache.end())
-    {
-    // not found in cache, therefore it cannot be in the model
-    return nodeIndex;
-    }
-  if (rowCacheIt.value().isValid())
+  QStandardItem* nodeItem = d->NodeItems.value(QString(node->GetID()), 0);
+  if (nodeItem == 0)
     {
-    // An entry found in the cache. If the item at the cached index matches the requested node ID
-    // then we use it.
-    QStandardItem* nodeItem = this->itemFromIndex(rowCacheIt.value());
-    if (nodeItem!=NULL)
-      {
-      if (nodeItem->data(qMRMLSceneModel::UIDRole).toString().compare(QLatin1String(node->GetID()))==0)
-        {
-        // id matched
-        nodeIndex=rowCacheIt.value();
-        }
-      }
-    }
-
-  // The cache was not up-to-date. Do a slow linear search.
-  if (!nodeIndex.isValid())
-    {
-    // QAbstractItemModel::match doesn't browse through columns
-    // we need to do it manually
-    QModelIndexList nodeIndexes = this->match(
-      this->mrmlSceneIndex(), qMRMLSceneModel::UIDRole, QString(node->GetID()),
-      1, Qt::MatchExactly | Qt::MatchRecursive);
-    Q_ASSERT(nodeIndexes.size() <= 1); // we know for sure it won't be more than 1
-    if (nodeIndexes.size() == 0)
-      {
-      // maybe the node hasn't been added to the scene yet...
-      // (if it's called from populateScene/inserteNode)
-      d->RowCache.remove(node);
-      return QModelIndex();
-      }
-    nodeIndex=nodeIndexes[0];
-    d->RowCache[node]=nodeIndex;
+    // maybe the node hasn't been added to the scene yet...
+    // (if it's called from populateScene/inserteNode)
+    return QModelIndex();
     }
+  QModelIndex nodeIndex = nodeItem->index();
   if (column == 0)
     {
-    // QAbstractItemModel::match only search through the first column
-    // (because scene is in the first column)
+    // Only the items of the first column are indexed
     Q_ASSERT(nodeIndex.isValid());
     return nodeIndex;
     }
@@ -698,7 +838,10 @@ void qMRMLSceneModel::updateScene()
   qvtkDisconnect(0, vtkMRMLNode::IDChangedEvent,
                  this, SLOT(onMRMLNodeIDChanged(vtkObject*,void*)));
 
-  d->RowCache.clear();
+  d->NodeItems.clear();
+  d->PendingAddedNodes.clear();
+  d->PendingRemovedNodes.clear();
+  d->PendingModifiedNodes.clear();
 
   // Enabled so it can be interacted with
   this->invisibleRootItem()->setFlags(Qt::ItemIsEnabled);
@@ -830,13 +973,8 @@ QStandardItem* qMRMLSceneModel::insertNode(vtkMRMLNode* node, QStandardItem* par
     items.append(newNodeItem);
     }
 
-  // Insert an invalid item in the cache to indicate that the node is in the model
-  // but we don't know its index yet. This is needed because a custom widget may be notified
-  // abot row insertion before insertRow() returns (and the RowCache entry is added).
-  // For example, qSlicerPresetComboBox::setIconToPreset() is called at the end of insertRow,
-  // before the RowCache entry is added.
-  d->RowCache[node]=QModelIndex();
-
+  // The item is indexed in onRowsInserted(), before a custom widget is
+  // notified about the row insertion (e.g. qSlicerPresetComboBox).
   if (parent)
     {
     parent->insertRow(row, items);
@@ -846,7 +984,6 @@ QStandardItem* qMRMLSceneModel::insertNode(vtkMRMLNode* node, QStandardItem* par
     {
     this->insertRow(row,items);
     }
-  d->RowCache[node]=items[0]->index();
   // TODO: don't listen to nodes that are hidden from editors ?
   if (d->ListenNodeModifiedEvent == AllNodes)
     {
@@ -874,7 +1011,15 @@ void qMRMLSceneModel::updateItemFromNode(QStandardItem* item, vtkMRMLNode* node,
   item->setFlags(this->nodeFlags(node, column));
   // set UIDRole and set PointerRole need to be atomic
   bool blocked  = this->blockSignals(true);
-  item->setData(QString(node->GetID()), qMRMLSceneModel::UIDRole);
+  const QString nodeID(node->GetID());
+  const QString oldNodeID = item->data(qMRMLSceneModel::UIDRole).toString();
+  if (oldNodeID != nodeID && d->NodeItems.value(oldNodeID, 0) == item)
+    {
+    // the ID of the node changed
+    d->NodeItems.remove(oldNodeID);
+    d->NodeItems[nodeID] = item;
+    }
+  item->setData(nodeID, qMRMLSceneModel::UIDRole);
   item->setData(QVariant::fromValue(reinterpret_cast<long long>(node)), qMRMLSceneModel::PointerRole);
   this->blockSignals(blocked);
   this->updateItemDataFromNode(item, node, column);
@@ -1219,6 +1364,7 @@ void qMRMLSceneModel::onMRMLSceneNodeAdded(vtkMRMLScene* scene, vtkMRMLNode* nod
 
   if (d->LazyUpdate && d->MRMLScene->IsBatchProcessing())
     {
+    d->PendingAddedNodes << QString(node->GetID());
     return;
     }
   this->insertNode(node);
@@ -1232,11 +1378,10 @@ void qMRMLSceneModel::onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMR
   Q_UNUSED(scene);
   Q_ASSERT(scene == d->MRMLScene);
 
-  if (d->MRMLScene->IsClosing() || (d->LazyUpdate && d->MRMLScene->IsBatchProcessing()))
+  if (d->MRMLScene->IsClosing())
     {
     return;
     }
-
   int connectionsRemoved =
     qvtkDisconnect(node, vtkCommand::ModifiedEvent,
                    this, SLOT(onMRMLNodeModified(vtkObject*)));
@@ -1252,30 +1397,18 @@ void qMRMLSceneModel::onMRMLSceneNodeAboutToBeRemoved(vtkMRMLScene* scene, vtkMR
   // Remove all the observations on the node
   qvtkDisconnect(node, vtkCommand::NoEvent, this, 0);
 
-  // TODO: can be fasten by browsing the tree only once
-  QModelIndexList indexes = this->match(this->mrmlSceneIndex(), qMRMLSceneModel::UIDRole,
-                                        QString(node->GetID()), 1,
-                                        Qt::MatchExactly | Qt::MatchRecursive);
-  if (indexes.count())
+  // The node may not exist anymore at the end of the batch processing, only
+  // its item removal can be delayed.
+  if (d->LazyUpdate && d->MRMLScene->IsBatchProcessing())
     {
-    QStandardItem* item = this->itemFromIndex(indexes[0].sibling(indexes[0].row(),0));
-    // The children may be lost if not reparented, we ensure they got reparented.
-    while (item->rowCount())
-      {
-      // we need to remove the children from the node to remove because they
-      // would be automatically deleted in QStandardItemModel::removeRow()
-      d->Orphans.push_back(item->takeRow(0));
-      }
-    // Remove the item from any orphan list if it exist as we don't want to
-    // add it back later in onMRMLSceneNodeRemoved
-    foreach(QList<QStandardItem*> orphans, d->Orphans)
-      {
-      if (orphans.contains(item))
-        {
-        d->Orphans.removeAll(orphans);
-        }
-      }
-    this->removeRow(indexes[0].row(), indexes[0].parent());
+    d->PendingRemovedNodes << QString(node->GetID());
+    return;
+    }
+
+  QStandardItem* item = d->NodeItems.value(QString(node->GetID()), 0);
+  if (item)
+    {
+    d->removeNodeItem(item);
     }
 }
 
@@ -1292,28 +1425,7 @@ void qMRMLSceneModel::onMRMLSceneNodeRemoved(vtkMRMLScene* scene, vtkMRMLNode* n
   // The removed node may had children, if they haven't been updated, they
   // are likely to be lost (not reachable when browsing the model), we need
   // to reparent them.
-  foreach(QList<QStandardItem*> orphans, d->Orphans)
-    {
-    QStandardItem* orphan = orphans[0];
-    // Make sure that the orphans have not already been reparented.
-    if (orphan->parent())
-      {
-      // Not sure how it is possible, but if it is, then we might want to
-      // review the logic behind.
-      Q_ASSERT(orphan->parent() == 0);
-      continue;
-      }
-    vtkMRMLNode* node = this->mrmlNodeFromItem(orphan);
-    int newIndex = this->nodeIndex(node);
-    QStandardItem* newParentItem = this->itemFromNode(this->parentNode(node));
-    if (newParentItem == 0)
-      {
-      newParentItem = this->mrmlSceneItem();
-      }
-    Q_ASSERT(newParentItem);
-    d->reparentItems(orphans, newIndex, newParentItem);
-    }
-  d->Orphans.clear();
+  d->reparentOrphans();
 }
 
 //------------------------------------------------------------------------------
@@ -1384,8 +1496,13 @@ void qMRMLSceneModel::updateNodeItems(vtkMRMLNode* node, const QString& nodeUID)
 {
   Q_D(qMRMLSceneModel);
 
-  if (d->MRMLScene->IsClosing() || (d->LazyUpdate && d->MRMLScene->IsBatchProcessing()))
+  if (d->MRMLScene->IsClosing())
+    {
+    return;
+    }
+  if (d->LazyUpdate && d->MRMLScene->IsBatchProcessing())
     {
+    d->PendingModifiedNodes.insert(nodeUID);
     return;
     }
 
@@ -1510,7 +1627,7 @@ void qMRMLSceneModel::onMRMLSceneImported(vtkMRMLScene* scene)
   Q_UNUSED(scene);
   if (d->LazyUpdate)
     {
-    this->updateScene();
+    d->applyPendingChanges();
     }
   //this->endResetModel();
 }
@@ -1547,7 +1664,7 @@ void qMRMLSceneModel::onMRMLSceneEndBatchProcess(vtkMRMLScene* scene)
   Q_UNUSED(scene);
   if (d->LazyUpdate)
     {
-    this->updateScene();
+    d->applyPendingChanges();
     emit sceneUpdated();
     }
 }
@@ -1664,6 +1781,50 @@ void qMRMLSceneModel::updateColumnCount()
     }
 }
 
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::onRowsInserted(const QModelIndex& parent, int start, int end)
+{
+  Q_D(qMRMLSceneModel);
+  for (int row = start; row <= end; ++row)
+    {
+    d->addNodeItems(this->itemFromIndex(this->index(row, 0, parent)));
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::onRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end)
+{
+  Q_D(qMRMLSceneModel);
+  for (int row = start; row <= end; ++row)
+    {
+    d->removeNodeItems(this->itemFromIndex(this->index(row, 0, parent)));
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::onColumnsAboutToBeRemoved(const QModelIndex& parent, int start, int end)
+{
+  Q_D(qMRMLSceneModel);
+  Q_UNUSED(end);
+  // Only the items of the first column are indexed
+  if (start != 0)
+    {
+    return;
+    }
+  const int rowCount = this->rowCount(parent);
+  for (int row = 0; row < rowCount; ++row)
+    {
+    d->removeNodeItems(this->itemFromIndex(this->index(row, 0, parent)));
+    }
+}
+
+//------------------------------------------------------------------------------
+void qMRMLSceneModel::onModelAboutToBeReset()
+{
+  Q_D(qMRMLSceneModel);
+  d->NodeItems.clear();
+}
+
 //------------------------------------------------------------------------------
 int qMRMLSceneModel::maxColumnId()const
 {
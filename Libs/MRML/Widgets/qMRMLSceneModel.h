@@ -70,9 +70,9 @@ class QMRML_WIDGETS_EXPORT qMRMLSceneModel : public QStandardItemModel
   Q_PROPERTY (NodeTypes listenNodeModifiedEvent READ listenNodeModifiedEvent WRITE setListenNodeModifiedEvent)
 
   /// Control wether the model actively listens to the scene.
-  /// If LazyUpdate is true, the model ignores added node events when the
-  /// scene is importing/restoring, but synchronize with the scene once its
-  /// imported/restored.
+  /// If LazyUpdate is true, the model postpones the added, removed and
+  /// modified node events when the scene is importing/restoring, and applies
+  /// them once the scene is imported/restored.
   Q_PROPERTY (bool lazyUpdate READ lazyUpdate WRITE setLazyUpdate)
 
   /// Control in which column vtkMRMLNode names are displayed (Qt::DisplayRole).
@@ -247,6 +247,12 @@ protected slots:
   /// Needs maxColumnId() to be reimplemented in subclasses
   void updateColumnCount();
 
+  /// Keep the node items indexed by node ID when rows are added or removed.
+  void onRowsInserted(const QModelIndex& parent, int start, int end);
+  void onRowsAboutToBeRemoved(const QModelIndex& parent, int start, int end);
+  void onColumnsAboutToBeRemoved(const QModelIndex& parent, int start, int end);
+  void onModelAboutToBeReset();
+
 signals :
   /// This signal is sent when a user is about to reparent a Node by
   /// a drag and drop
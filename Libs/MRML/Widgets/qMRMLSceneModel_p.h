@@ -35,7 +35,10 @@
 // Qt includes
 class QStandardItemModel;
 #include <QFlags>
+#include <QHash>
 #include <QMap>
+#include <QSet>
+#include <QStringList>
 
 // qMRML includes
 #include "qMRMLSceneModel.h"
@@ -71,6 +74,16 @@ public:
   void listenNodeModifiedEvent();
   void reparentItems(QList<QStandardItem*>& children, int newIndex, QStandardItem* newParent);
 
+  /// Add/remove the node items of the subtree of \a item in NodeItems
+  void addNodeItems(QStandardItem* item);
+  void removeNodeItems(QStandardItem* item);
+  /// Remove the row of the node item, its children are moved into Orphans
+  void removeNodeItem(QStandardItem* item);
+  /// Reinsert the Orphans under their new parent items
+  void reparentOrphans();
+  /// Apply the scene changes received during batch processing
+  void applyPendingChanges();
+
   vtkSmartPointer<vtkCallbackCommand> CallBack;
   qMRMLSceneModel::NodeTypes ListenNodeModifiedEvent;
   bool LazyUpdate;
@@ -95,12 +108,16 @@ public:
   // likely to be unreachable when browsing the model
   QList<QList<QStandardItem*> > Orphans;
 
-  // Map from MRML node to row.
-  // It just stores the result of the latest lookup by indexFromNode,
-  // not guaranteed to contain up-to-date information, should be just used
-  // as a search hint. If the node cannot be found at the given index then
-  // we need to browse through all model items.
-  mutable QMap<vtkMRMLNode*,QPersistentModelIndex> RowCache;
+  // Map from MRML node ID to the item of the node in the first column.
+  // Kept up-to-date when rows are inserted or removed (reparenting takes and
+  // inserts rows) and when node IDs change.
+  QHash<QString, QStandardItem*> NodeItems;
+
+  // Scene changes received in LazyUpdate mode while the scene is batch
+  // processing, applied at the end of the batch processing.
+  QStringList PendingAddedNodes;
+  QStringList PendingRemovedNodes;
+  QSet<QString> PendingModifiedNodes;
 };
 
 #endif
@@ -0,0 +1,191 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkAddon includes
+#include <vtkIndexedPlaneCutter.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkCollection.h>
+#include <vtkCutter.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPlane.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkStripper.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Sum of the lengths of the lines
+double LinesLength(vtkPolyData* polyData)
+{
+  double length = 0.;
+  vtkCellArray* lines = polyData->GetLines();
+  vtkIdType npts = 0;
+  vtkIdType* pts = 0;
+  for (lines->InitTraversal(); lines->GetNextCell(npts, pts);)
+    {
+    for (vtkIdType i = 0; i + 1 < npts; ++i)
+      {
+      double point0[3];
+      double point1[3];
+      polyData->GetPoint(pts[i], point0);
+      polyData->GetPoint(pts[i + 1], point1);
+      length += std::sqrt(vtkMath::Distance2BetweenPoints(point0, point1));
+      }
+    }
+  return length;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int vtkIndexedPlaneCutterTest1(int , char * [] )
+{
+  // ~320k triangles
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(50.);
+  sphere->SetThetaResolution(400);
+  sphere->SetPhiResolution(400);
+  sphere->Update();
+
+  vtkNew<vtkPlane> plane;
+  plane->SetNormal(0.2, 0.3, 1.);
+
+  vtkNew<vtkCutter> cutter;
+  cutter->SetCutFunction(plane.GetPointer());
+  cutter->SetGenerateCutScalars(0);
+  cutter->SetInputConnection(sphere->GetOutputPort());
+
+  vtkNew<vtkIndexedPlaneCutter> indexedCutter;
+  indexedCutter->SetPlane(plane.GetPointer());
+  indexedCutter->SetInputConnection(sphere->GetOutputPort());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  plane->SetOrigin(0., 0., 0.);
+  indexedCutter->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"IndexedCutterFirstCut\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // Same lines as vtkCutter, the plane moving along its normal
+  const int numberOfSlices = 50;
+  double cutterTime = 0.;
+  double indexedCutterTime = 0.;
+  for (int i = 0; i < numberOfSlices; ++i)
+    {
+    plane->SetOrigin(0., 0., -49. + 98.3 * i / numberOfSlices);
+
+    timer->StartTimer();
+    cutter->Update();
+    timer->StopTimer();
+    cutterTime += timer->GetElapsedTime();
+
+    timer->StartTimer();
+    indexedCutter->Update();
+    timer->StopTimer();
+    indexedCutterTime += timer->GetElapsedTime();
+
+    const double expectedLength = LinesLength(cutter->GetOutput());
+    const double length = LinesLength(indexedCutter->GetOutput());
+    if (expectedLength <= 0. ||
+        std::fabs(length - expectedLength) > 1e-6 * expectedLength)
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong cut at slice " << i
+                << ": length " << length << " instead of " << expectedLength
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::cout << "<DartMeasurement name=\"CutterSliceTime\" type=\"numeric/double\">"
+            << cutterTime / numberOfSlices << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"IndexedCutterSliceTime\" type=\"numeric/double\">"
+            << indexedCutterTime / numberOfSlices << "</DartMeasurement>" << std::endl;
+
+  // Triangle strips
+  vtkNew<vtkStripper> stripper;
+  stripper->SetInputConnection(sphere->GetOutputPort());
+  indexedCutter->SetInputConnection(stripper->GetOutputPort());
+  plane->SetOrigin(1., 2., 3.);
+  cutter->Update();
+  indexedCutter->Update();
+  const double expectedLength = LinesLength(cutter->GetOutput());
+  if (std::fabs(LinesLength(indexedCutter->GetOutput()) - expectedLength) >
+      1e-6 * expectedLength)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong cut of triangle strips: "
+              << LinesLength(indexedCutter->GetOutput()) << " instead of "
+              << expectedLength << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Nothing outside of the surface
+  plane->SetOrigin(0., 0., 60.);
+  indexedCutter->Update();
+  if (indexedCutter->GetOutput()->GetNumberOfLines() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": cut outside of the surface" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Cutters processed in parallel give the same lines
+  const int numberOfCutters = 4;
+  vtkNew<vtkCollection> cutters;
+  std::vector<vtkSmartPointer<vtkPlane> > planes;
+  for (int i = 0; i < numberOfCutters; ++i)
+    {
+    vtkNew<vtkIndexedPlaneCutter> parallelCutter;
+    planes.push_back(vtkSmartPointer<vtkPlane>::New());
+    planes[i]->SetNormal(i, 1., 0.5);
+    planes[i]->SetOrigin(0., 10. * i, 0.);
+    parallelCutter->SetPlane(planes[i]);
+    parallelCutter->SetInputConnection(sphere->GetOutputPort());
+    cutters->AddItem(parallelCutter.GetPointer());
+    }
+  vtkIndexedPlaneCutter::CutInParallel(cutters.GetPointer());
+  indexedCutter->SetInputConnection(sphere->GetOutputPort());
+  for (int i = 0; i < numberOfCutters; ++i)
+    {
+    vtkIndexedPlaneCutter* parallelCutter =
+      vtkIndexedPlaneCutter::SafeDownCast(cutters->GetItemAsObject(i));
+    parallelCutter->Update();
+    plane->SetNormal(planes[i]->GetNormal());
+    plane->SetOrigin(planes[i]->GetOrigin());
+    indexedCutter->Update();
+    if (parallelCutter->GetOutput()->GetNumberOfLines() == 0 ||
+        parallelCutter->GetOutput()->GetNumberOfLines() !=
+        indexedCutter->GetOutput()->GetNumberOfLines())
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong parallel cut " << i << ": "
+                << parallelCutter->GetOutput()->GetNumberOfLines() << " lines instead of "
+                << indexedCutter->GetOutput()->GetNumberOfLines() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
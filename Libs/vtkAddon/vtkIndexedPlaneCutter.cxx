@@ -0,0 +1,532 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkIndexedPlaneCutter.h"
+
+#include "vtkAlgorithmOutput.h"
+#include "vtkCellArray.h"
+#include "vtkCellData.h"
+#include "vtkCollection.h"
+#include "vtkInformation.h"
+#include "vtkInformationVector.h"
+#include "vtkMath.h"
+#include "vtkNew.h"
+#include "vtkObjectFactory.h"
+#include "vtkPlane.h"
+#include "vtkPointData.h"
+#include "vtkPoints.h"
+#include "vtkPolyData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+vtkStandardNewMacro(vtkIndexedPlaneCutter);
+
+vtkCxxSetObjectMacro(vtkIndexedPlaneCutter,Plane,vtkPlane);
+
+//----------------------------------------------------------------------------
+class vtkIndexedPlaneCutter::vtkInternal
+{
+public:
+  vtkInternal();
+
+  void BuildIndex(vtkPolyData* input, const double normal[3]);
+  void Cut(double offset);
+  void CutPolygon(const vtkIdType* pts, vtkIdType npts, vtkIdType cellId);
+  vtkIdType GetEdge(vtkIdType point0, vtkIdType point1);
+
+  // Index
+  vtkPolyData* Input;
+  vtkTimeStamp IndexTime;
+  double Normal[3];
+  // Cell id of the first polygon, the strips follow the polygons.
+  vtkIdType FirstCellId;
+  vtkIdType NumberOfPolys;
+  const vtkIdType* Polys;
+  const vtkIdType* Strips;
+  // Location of the indexed cells in Polys then in Strips.
+  std::vector<vtkIdType> CellLocations;
+  // Signed distance of the points along the normal.
+  std::vector<double> PointDistances;
+  // Min and max distances of the indexed cells.
+  std::vector<double> CellRanges;
+  // The distance range is split in buckets listing the cells overlapping them.
+  double RangeMin;
+  double RangeMax;
+  double BucketWidth;
+  int NumberOfBuckets;
+  std::vector<vtkIdType> BucketOffsets;
+  std::vector<vtkIdType> BucketCells;
+
+  // Intersection
+  struct Edge
+    {
+    vtkIdType Point0;
+    vtkIdType Point1;
+    double T;
+    };
+  bool IntersectionValid;
+  double IntersectionOffset;
+  std::vector<Edge> Edges;
+  std::map<std::pair<vtkIdType, vtkIdType>, vtkIdType> EdgeIds;
+  // Pairs of edge ids
+  std::vector<vtkIdType> Segments;
+  std::vector<vtkIdType> SegmentCells;
+  std::vector<vtkIdType> Crossings;
+};
+
+//----------------------------------------------------------------------------
+vtkIndexedPlaneCutter::vtkInternal::vtkInternal()
+{
+  this->Input = 0;
+  this->Normal[0] = this->Normal[1] = this->Normal[2] = 0.;
+  this->FirstCellId = 0;
+  this->NumberOfPolys = 0;
+  this->Polys = 0;
+  this->Strips = 0;
+  this->RangeMin = 0.;
+  this->RangeMax = 0.;
+  this->BucketWidth = 1.;
+  this->NumberOfBuckets = 0;
+  this->IntersectionValid = false;
+  this->IntersectionOffset = 0.;
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::vtkInternal
+::BuildIndex(vtkPolyData* input, const double normal[3])
+{
+  this->Input = input;
+  this->Normal[0] = normal[0];
+  this->Normal[1] = normal[1];
+  this->Normal[2] = normal[2];
+  this->IntersectionValid = false;
+  this->IndexTime.Modified();
+
+  this->CellLocations.clear();
+  this->CellRanges.clear();
+  this->BucketOffsets.clear();
+  this->BucketCells.clear();
+  this->NumberOfBuckets = 0;
+
+  vtkPoints* points = input->GetPoints();
+  const vtkIdType numberOfPoints = points ? points->GetNumberOfPoints() : 0;
+  this->PointDistances.resize(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    double point[3];
+    points->GetPoint(i, point);
+    this->PointDistances[i] = vtkMath::Dot(point, normal);
+    }
+
+  this->FirstCellId =
+    input->GetNumberOfVerts() + input->GetNumberOfLines();
+  this->NumberOfPolys = input->GetNumberOfPolys();
+  vtkCellArray* cellArrays[2] = {input->GetPolys(), input->GetStrips()};
+  const vtkIdType* connectivities[2] = {0, 0};
+  for (int c = 0; c < 2; ++c)
+    {
+    if (!cellArrays[c] || cellArrays[c]->GetNumberOfCells() == 0)
+      {
+      continue;
+      }
+    const vtkIdType* connectivity = cellArrays[c]->GetPointer();
+    connectivities[c] = connectivity;
+    const vtkIdType size = cellArrays[c]->GetNumberOfConnectivityEntries();
+    for (vtkIdType location = 0; location < size;
+         location += connectivity[location] + 1)
+      {
+      double min = VTK_DOUBLE_MAX;
+      double max = VTK_DOUBLE_MIN;
+      for (vtkIdType i = 1; i <= connectivity[location]; ++i)
+        {
+        const double distance = this->PointDistances[connectivity[location + i]];
+        min = std::min(min, distance);
+        max = std::max(max, distance);
+        }
+      this->CellLocations.push_back(location);
+      this->CellRanges.push_back(min);
+      this->CellRanges.push_back(max);
+      }
+    }
+  this->Polys = connectivities[0];
+  this->Strips = connectivities[1];
+
+  const vtkIdType numberOfCells =
+    static_cast<vtkIdType>(this->CellLocations.size());
+  if (numberOfCells == 0)
+    {
+    return;
+    }
+
+  // Buckets as wide as the average cell extent: a cell is listed in about
+  // 2 buckets.
+  this->RangeMin = VTK_DOUBLE_MAX;
+  this->RangeMax = VTK_DOUBLE_MIN;
+  double extentSum = 0.;
+  for (vtkIdType c = 0; c < numberOfCells; ++c)
+    {
+    this->RangeMin = std::min(this->RangeMin, this->CellRanges[2 * c]);
+    this->RangeMax = std::max(this->RangeMax, this->CellRanges[2 * c + 1]);
+    extentSum += this->CellRanges[2 * c + 1] - this->CellRanges[2 * c];
+    }
+  const double range = this->RangeMax - this->RangeMin;
+  const double averageExtent = extentSum / numberOfCells;
+  double numberOfBuckets = 1.;
+  if (range > 0. && averageExtent > 0.)
+    {
+    numberOfBuckets = std::min(std::ceil(range / averageExtent),
+                               static_cast<double>(numberOfCells));
+    }
+  else if (range > 0.)
+    {
+    numberOfBuckets = std::min(1024., static_cast<double>(numberOfCells));
+    }
+  this->NumberOfBuckets = static_cast<int>(numberOfBuckets);
+  this->BucketWidth = range > 0. ? range / this->NumberOfBuckets : 1.;
+
+  // Counting sort of the cells in the buckets
+  const int lastBucket = this->NumberOfBuckets - 1;
+  this->BucketOffsets.assign(this->NumberOfBuckets + 1, 0);
+  for (vtkIdType c = 0; c < numberOfCells; ++c)
+    {
+    const int first = std::min(lastBucket, static_cast<int>(
+      (this->CellRanges[2 * c] - this->RangeMin) / this->BucketWidth));
+    const int last = std::min(lastBucket, static_cast<int>(
+      (this->CellRanges[2 * c + 1] - this->RangeMin) / this->BucketWidth));
+    for (int b = first; b <= last; ++b)
+      {
+      ++this->BucketOffsets[b + 1];
+      }
+    }
+  for (int b = 0; b < this->NumberOfBuckets; ++b)
+    {
+    this->BucketOffsets[b + 1] += this->BucketOffsets[b];
+    }
+  this->BucketCells.resize(this->BucketOffsets[this->NumberOfBuckets]);
+  std::vector<vtkIdType> fill(this->BucketOffsets.begin(),
+                              this->BucketOffsets.end() - 1);
+  for (vtkIdType c = 0; c < numberOfCells; ++c)
+    {
+    const int first = std::min(lastBucket, static_cast<int>(
+      (this->CellRanges[2 * c] - this->RangeMin) / this->BucketWidth));
+    const int last = std::min(lastBucket, static_cast<int>(
+      (this->CellRanges[2 * c + 1] - this->RangeMin) / this->BucketWidth));
+    for (int b = first; b <= last; ++b)
+      {
+      this->BucketCells[fill[b]++] = c;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkIndexedPlaneCutter::vtkInternal
+::GetEdge(vtkIdType point0, vtkIdType point1)
+{
+  // Shared edges are cut once, always from their smallest point id.
+  if (point1 < point0)
+    {
+    std::swap(point0, point1);
+    }
+  std::pair<std::map<std::pair<vtkIdType, vtkIdType>, vtkIdType>::iterator, bool> inserted =
+    this->EdgeIds.insert(std::make_pair(std::make_pair(point0, point1),
+                                        static_cast<vtkIdType>(this->Edges.size())));
+  if (inserted.second)
+    {
+    const double distance0 = this->PointDistances[point0];
+    const double distance1 = this->PointDistances[point1];
+    Edge edge;
+    edge.Point0 = point0;
+    edge.Point1 = point1;
+    edge.T = (this->IntersectionOffset - distance0) / (distance1 - distance0);
+    this->Edges.push_back(edge);
+    }
+  return inserted.first->second;
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::vtkInternal
+::CutPolygon(const vtkIdType* pts, vtkIdType npts, vtkIdType cellId)
+{
+  // A point exactly on the plane is on the positive side, the segment ends
+  // are therefore always on edges with a positive and a negative point.
+  this->Crossings.clear();
+  for (vtkIdType i = 0; i < npts; ++i)
+    {
+    const vtkIdType j = (i + 1) % npts;
+    const bool above0 = this->PointDistances[pts[i]] >= this->IntersectionOffset;
+    const bool above1 = this->PointDistances[pts[j]] >= this->IntersectionOffset;
+    if (above0 != above1)
+      {
+      this->Crossings.push_back(this->GetEdge(pts[i], pts[j]));
+      }
+    }
+  for (size_t c = 0; c + 1 < this->Crossings.size(); c += 2)
+    {
+    this->Segments.push_back(this->Crossings[c]);
+    this->Segments.push_back(this->Crossings[c + 1]);
+    this->SegmentCells.push_back(cellId);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::vtkInternal::Cut(double offset)
+{
+  this->IntersectionOffset = offset;
+  this->IntersectionValid = true;
+  this->Edges.clear();
+  this->EdgeIds.clear();
+  this->Segments.clear();
+  this->SegmentCells.clear();
+  if (this->NumberOfBuckets == 0 ||
+      offset <= this->RangeMin || offset > this->RangeMax)
+    {
+    return;
+    }
+
+  const int bucket = std::min(this->NumberOfBuckets - 1, static_cast<int>(
+    (offset - this->RangeMin) / this->BucketWidth));
+  for (vtkIdType b = this->BucketOffsets[bucket];
+       b < this->BucketOffsets[bucket + 1]; ++b)
+    {
+    const vtkIdType c = this->BucketCells[b];
+    if (this->CellRanges[2 * c] >= offset || this->CellRanges[2 * c + 1] < offset)
+      {
+      continue;
+      }
+    const vtkIdType cellId = this->FirstCellId + c;
+    if (c < this->NumberOfPolys)
+      {
+      const vtkIdType* cell = this->Polys + this->CellLocations[c];
+      this->CutPolygon(cell + 1, cell[0], cellId);
+      }
+    else
+      {
+      const vtkIdType* cell = this->Strips + this->CellLocations[c];
+      for (vtkIdType i = 1; i + 2 <= cell[0]; ++i)
+        {
+        this->CutPolygon(cell + i, 3, cellId);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIndexedPlaneCutter::vtkIndexedPlaneCutter()
+{
+  this->Plane = 0;
+  this->Internal = new vtkInternal;
+}
+
+//----------------------------------------------------------------------------
+vtkIndexedPlaneCutter::~vtkIndexedPlaneCutter()
+{
+  this->SetPlane(0);
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Plane: " << this->Plane << "\n";
+  os << indent << "NumberOfBuckets: " << this->Internal->NumberOfBuckets << "\n";
+}
+
+//----------------------------------------------------------------------------
+unsigned long vtkIndexedPlaneCutter::GetMTime()
+{
+  unsigned long mTime = this->Superclass::GetMTime();
+  if (this->Plane)
+    {
+    mTime = std::max(mTime, this->Plane->GetMTime());
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::UpdateIndex(vtkPolyData* input)
+{
+  double normal[3] = {0., 0., 1.};
+  if (this->Plane)
+    {
+    this->Plane->GetNormal(normal);
+    vtkMath::Normalize(normal);
+    }
+  if (input == this->Internal->Input &&
+      input->GetMTime() < this->Internal->IndexTime.GetMTime() &&
+      normal[0] == this->Internal->Normal[0] &&
+      normal[1] == this->Internal->Normal[1] &&
+      normal[2] == this->Internal->Normal[2])
+    {
+    return;
+    }
+  this->Internal->BuildIndex(input, normal);
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::ComputeIntersection()
+{
+  double origin[3] = {0., 0., 0.};
+  if (this->Plane)
+    {
+    this->Plane->GetOrigin(origin);
+    }
+  const double offset = vtkMath::Dot(origin, this->Internal->Normal);
+  if (this->Internal->IntersectionValid &&
+      offset == this->Internal->IntersectionOffset)
+    {
+    return;
+    }
+  this->Internal->Cut(offset);
+}
+
+//----------------------------------------------------------------------------
+int vtkIndexedPlaneCutter::RequestData(vtkInformation* vtkNotUsed(request),
+                                       vtkInformationVector** inputVector,
+                                       vtkInformationVector* outputVector)
+{
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkPolyData* input = vtkPolyData::SafeDownCast(
+    inInfo->Get(vtkDataObject::DATA_OBJECT()));
+  vtkPolyData* output = vtkPolyData::SafeDownCast(
+    outInfo->Get(vtkDataObject::DATA_OBJECT()));
+  if (!input || !output)
+    {
+    return 0;
+    }
+
+  this->UpdateIndex(input);
+  this->ComputeIntersection();
+
+  const std::vector<vtkInternal::Edge>& edges = this->Internal->Edges;
+  const vtkIdType numberOfPoints = static_cast<vtkIdType>(edges.size());
+  const vtkIdType numberOfSegments =
+    static_cast<vtkIdType>(this->Internal->SegmentCells.size());
+
+  vtkPoints* inPoints = input->GetPoints();
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkPointData* inPD = input->GetPointData();
+  vtkPointData* outPD = output->GetPointData();
+  outPD->InterpolateAllocate(inPD, numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+    {
+    const vtkInternal::Edge& edge = edges[i];
+    double point0[3];
+    double point1[3];
+    inPoints->GetPoint(edge.Point0, point0);
+    inPoints->GetPoint(edge.Point1, point1);
+    double point[3];
+    for (int j = 0; j < 3; ++j)
+      {
+      point[j] = point0[j] + edge.T * (point1[j] - point0[j]);
+      }
+    points->SetPoint(i, point);
+    outPD->InterpolateEdge(inPD, i, edge.Point0, edge.Point1, edge.T);
+    }
+
+  vtkNew<vtkCellArray> lines;
+  lines->Allocate(lines->EstimateSize(numberOfSegments, 2));
+  vtkCellData* inCD = input->GetCellData();
+  vtkCellData* outCD = output->GetCellData();
+  outCD->CopyAllocate(inCD, numberOfSegments);
+  for (vtkIdType i = 0; i < numberOfSegments; ++i)
+    {
+    lines->InsertNextCell(2, &this->Internal->Segments[2 * i]);
+    outCD->CopyData(inCD, this->Internal->SegmentCells[i], i);
+    }
+
+  output->SetPoints(points.GetPointer());
+  output->SetLines(lines.GetPointer());
+  output->Squeeze();
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+namespace
+{
+struct CutInParallelStruct
+{
+  std::vector<vtkIndexedPlaneCutter*> Cutters;
+};
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkIndexedPlaneCutter::CutInParallelThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  CutInParallelStruct* str = static_cast<CutInParallelStruct*>(info->UserData);
+  for (size_t i = info->ThreadID; i < str->Cutters.size();
+       i += info->NumberOfThreads)
+    {
+    str->Cutters[i]->ComputeIntersection();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void vtkIndexedPlaneCutter::CutInParallel(vtkCollection* cutters)
+{
+  if (!cutters)
+    {
+    return;
+    }
+  // The pipeline updates and the index builds are not thread safe.
+  CutInParallelStruct str;
+  vtkObject* object = 0;
+  vtkCollectionSimpleIterator it;
+  for (cutters->InitTraversal(it); (object = cutters->GetNextItemAsObject(it));)
+    {
+    vtkIndexedPlaneCutter* cutter = vtkIndexedPlaneCutter::SafeDownCast(object);
+    if (!cutter || cutter->GetNumberOfInputConnections(0) == 0)
+      {
+      continue;
+      }
+    vtkAlgorithmOutput* connection = cutter->GetInputConnection(0, 0);
+    vtkAlgorithm* producer = connection->GetProducer();
+    producer->Update();
+    vtkPolyData* input = vtkPolyData::SafeDownCast(
+      producer->GetOutputDataObject(connection->GetIndex()));
+    if (!input)
+      {
+      continue;
+      }
+    cutter->UpdateIndex(input);
+    str.Cutters.push_back(cutter);
+    }
+  if (str.Cutters.size() < 2)
+    {
+    if (str.Cutters.size() == 1)
+      {
+      str.Cutters[0]->ComputeIntersection();
+      }
+    return;
+    }
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(std::min(
+    vtkMultiThreader::GetGlobalDefaultNumberOfThreads(),
+    static_cast<int>(str.Cutters.size())));
+  threader->SetSingleMethod(vtkIndexedPlaneCutter::CutInParallelThread, &str);
+  threader->SingleMethodExecute();
+}
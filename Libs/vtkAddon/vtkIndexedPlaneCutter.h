@@ -0,0 +1,96 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+/// \brief vtkIndexedPlaneCutter - cut a surface with a moving plane.
+///
+/// Produces the line segments where the polygons and triangle strips of the
+/// input cross the plane, as vtkCutter does with a vtkPlane cut function
+/// (point data is interpolated, cell data is copied), without merging the
+/// segments into polylines. Vertices and lines of the input are ignored.
+///
+/// The cells are indexed by their extent along the plane normal. The index
+/// is only rebuilt when the input or the plane normal changes, moving the
+/// plane along its normal only visits the cells that are close to it.
+///
+
+#ifndef __vtkIndexedPlaneCutter_h
+#define __vtkIndexedPlaneCutter_h
+
+#include "vtkAddon.h"
+
+#include "vtkMultiThreader.h"
+#include "vtkPolyDataAlgorithm.h"
+
+class vtkCollection;
+class vtkPlane;
+
+class VTK_ADDON_EXPORT vtkIndexedPlaneCutter : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkIndexedPlaneCutter *New();
+  vtkTypeMacro(vtkIndexedPlaneCutter,vtkPolyDataAlgorithm);
+  virtual void PrintSelf(ostream& os, vtkIndent indent);
+
+  // Description:
+  // Plane to cut the input with.
+  virtual void SetPlane(vtkPlane*);
+  vtkGetObjectMacro(Plane,vtkPlane);
+
+  // Description:
+  // Take the plane modification time into account.
+  unsigned long GetMTime();
+
+  // Description:
+  // Update the inputs of the cutters and cut each of them with its plane,
+  // the cutters being processed in parallel. The next update of a cutter
+  // then only fills its output. Null or input-less items are skipped.
+  static void CutInParallel(vtkCollection* cutters);
+
+protected:
+  vtkIndexedPlaneCutter();
+  ~vtkIndexedPlaneCutter();
+
+  virtual int RequestData(vtkInformation* request,
+                          vtkInformationVector** inputVector,
+                          vtkInformationVector* outputVector);
+
+  // Description:
+  // Index the cells of the input along the plane normal if the input or
+  // the normal changed since the index was built.
+  void UpdateIndex(vtkPolyData* input);
+
+  // Description:
+  // Find the edges and segments of the cut with the current plane, unless
+  // they are already known. Only reads the input and the index, so that
+  // different cutters can be run in parallel.
+  void ComputeIntersection();
+
+  // Description:
+  // vtkMultiThreader method of CutInParallel().
+  static VTK_THREAD_RETURN_TYPE CutInParallelThread(void* arg);
+
+  vtkPlane* Plane;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkIndexedPlaneCutter(const vtkIndexedPlaneCutter&);  // Not implemented.
+  void operator=(const vtkIndexedPlaneCutter&);  // Not implemented.
+};
+
+#endif
@@ -0,0 +1,243 @@
+#include <vtkITKArchetypeImageSeriesScalarReader.h>
+
+// VTK includes
+#include <vtkNew.h>
+
+// ITK includes
+#include <itkFactoryRegistration.h>
+#include <itkMultiThreader.h>
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+const char* const ModifiedSeriesInstanceUID = "1.2.3.4.5";
+const int NumberOfConcurrentReaders = 4;
+
+//----------------------------------------------------------------------------
+// What the reader found in the directory of the archetype
+struct DICOMHeaders
+{
+  std::vector<std::string> FileNames;
+  std::vector<std::string> SeriesInstanceUIDs;
+  unsigned int NumberOfSliceLocations;
+  unsigned int NumberOfImagePositions;
+};
+
+//----------------------------------------------------------------------------
+DICOMHeaders readHeaders(const char* archetype, int numberOfThreads)
+{
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  reader->SetArchetype(archetype);
+  reader->SetSingleFile(0);
+  reader->SetNumberOfThreads(numberOfThreads);
+  reader->UpdateInformation();
+  DICOMHeaders headers;
+  for (unsigned int n = 0; n < reader->GetNumberOfFileNames(); ++n)
+    {
+    headers.FileNames.push_back(reader->GetFileName(n));
+    }
+  for (unsigned int n = 0; n < reader->GetNumberOfSeriesInstanceUIDs(); ++n)
+    {
+    headers.SeriesInstanceUIDs.push_back(reader->GetNthSeriesInstanceUID(n));
+    }
+  headers.NumberOfSliceLocations = reader->GetNumberOfSliceLocation();
+  headers.NumberOfImagePositions = reader->GetNumberOfImagePositionPatient();
+  return headers;
+}
+
+//----------------------------------------------------------------------------
+bool sameGrouping(const DICOMHeaders& headers, const DICOMHeaders& reference)
+{
+  return headers.FileNames == reference.FileNames &&
+         headers.NumberOfSliceLocations == reference.NumberOfSliceLocations &&
+         headers.NumberOfImagePositions == reference.NumberOfImagePositions;
+}
+
+//----------------------------------------------------------------------------
+// Index files in the index directory, and whether temporary files are left
+std::vector<std::string> indexFiles(const std::string& indexDirectory, bool& temporaryFiles)
+{
+  std::vector<std::string> files;
+  temporaryFiles = false;
+  itksys::Directory directory;
+  directory.Load(indexDirectory.c_str());
+  for (unsigned long n = 0; n < directory.GetNumberOfFiles(); ++n)
+    {
+    std::string file = directory.GetFile(n);
+    if (file == "." || file == "..")
+      {
+      continue;
+      }
+    if (itksys::SystemTools::GetFilenameLastExtension(file) == ".tmp")
+      {
+      temporaryFiles = true;
+      continue;
+      }
+    files.push_back(indexDirectory + "/" + file);
+    }
+  return files;
+}
+
+//----------------------------------------------------------------------------
+// Replace the series instance UID of all the entries of an index file
+bool modifySeriesInstanceUIDs(const std::string& indexFileName)
+{
+  std::ifstream input(indexFileName.c_str());
+  std::vector<std::string> lines;
+  std::string line;
+  while (std::getline(input, line))
+    {
+    lines.push_back(line);
+    }
+  input.close();
+  if (lines.size() < 2)
+    {
+    return false;
+    }
+  std::ofstream output(indexFileName.c_str());
+  output << lines[0] << "\n";
+  for (size_t l = 1; l < lines.size(); ++l)
+    {
+    // path, modification time, size, series instance UID, ...
+    std::string::size_type start = 0;
+    for (int field = 0; field < 3 && start != std::string::npos; ++field)
+      {
+      start = lines[l].find('\t', start);
+      start = start == std::string::npos ? start : start + 1;
+      }
+    if (start == std::string::npos)
+      {
+      return false;
+      }
+    std::string::size_type end = lines[l].find('\t', start);
+    output << lines[l].substr(0, start) << ModifiedSeriesInstanceUID
+           << lines[l].substr(end) << "\n";
+    }
+  return static_cast<bool>(output);
+}
+
+//----------------------------------------------------------------------------
+struct ConcurrentReadData
+{
+  const char* Archetype;
+  DICOMHeaders Headers[NumberOfConcurrentReaders];
+};
+
+//----------------------------------------------------------------------------
+ITK_THREAD_RETURN_TYPE concurrentRead(void* arg)
+{
+  itk::MultiThreader::ThreadInfoStruct* info =
+    static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  ConcurrentReadData* data = static_cast<ConcurrentReadData*>(info->UserData);
+  data->Headers[info->ThreadID] = readHeaders(data->Archetype, 2);
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  itk::itkFactoryRegistration();
+
+  if (argc < 3)
+    {
+    std::cout << "Usage: " << argv[0] << " DICOMFile TemporaryDirectory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const char* archetype = argv[1];
+  std::string indexDirectory = std::string(argv[2]) + "/vtkITKDICOMHeaderIndexTest";
+  itksys::SystemTools::RemoveADirectory(indexDirectory.c_str());
+
+  // Serial scan, without index
+  vtkITKArchetypeImageSeriesReader::SetGlobalDICOMHeaderIndexDirectory("");
+  DICOMHeaders reference = readHeaders(archetype, 1);
+  if (reference.FileNames.size() < 2 || reference.SeriesInstanceUIDs.size() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << archetype << " is not in a DICOM series" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Parallel scan: same result
+  DICOMHeaders headers = readHeaders(archetype, 4);
+  if (!sameGrouping(headers, reference) ||
+      headers.SeriesInstanceUIDs != reference.SeriesInstanceUIDs)
+    {
+    std::cerr << "Line " << __LINE__ << ": parallel scan differs from serial scan" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The first scan writes the index
+  vtkITKArchetypeImageSeriesReader::SetGlobalDICOMHeaderIndexDirectory(indexDirectory.c_str());
+  if (vtkITKArchetypeImageSeriesReader::GetGlobalDICOMHeaderIndexDirectory() != indexDirectory)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong index directory" << std::endl;
+    return EXIT_FAILURE;
+    }
+  headers = readHeaders(archetype, 4);
+  bool temporaryFiles = false;
+  std::vector<std::string> files = indexFiles(indexDirectory, temporaryFiles);
+  if (!sameGrouping(headers, reference) || files.size() != 1 || temporaryFiles)
+    {
+    std::cerr << "Line " << __LINE__ << ": index not written: " << files.size()
+              << " index files" << (temporaryFiles ? ", temporary files left" : "") << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The next scan reads the headers back from the index, as shown by a value
+  // changed in the index only
+  if (!modifySeriesInstanceUIDs(files[0]))
+    {
+    std::cerr << "Line " << __LINE__ << ": cannot modify " << files[0] << std::endl;
+    return EXIT_FAILURE;
+    }
+  headers = readHeaders(archetype, 4);
+  if (!sameGrouping(headers, reference) ||
+      headers.SeriesInstanceUIDs.size() != 1 ||
+      headers.SeriesInstanceUIDs[0] != ModifiedSeriesInstanceUID)
+    {
+    std::cerr << "Line " << __LINE__ << ": headers not read from the index" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Readers writing the same index at once do not clobber each other
+  itksys::SystemTools::RemoveADirectory(indexDirectory.c_str());
+  ConcurrentReadData data;
+  data.Archetype = archetype;
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(NumberOfConcurrentReaders);
+  threader->SetSingleMethod(concurrentRead, &data);
+  threader->SingleMethodExecute();
+  for (int n = 0; n < NumberOfConcurrentReaders; ++n)
+    {
+    if (!sameGrouping(data.Headers[n], reference))
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong grouping in reader " << n << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  files = indexFiles(indexDirectory, temporaryFiles);
+  if (files.size() != 1 || temporaryFiles)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << files.size() << " index files"
+              << (temporaryFiles ? ", temporary files left" : "") << std::endl;
+    return EXIT_FAILURE;
+    }
+  headers = readHeaders(archetype, 1);
+  if (!sameGrouping(headers, reference) ||
+      headers.SeriesInstanceUIDs != reference.SeriesInstanceUIDs)
+    {
+    std::cerr << "Line " << __LINE__ << ": index written concurrently is wrong" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkITKArchetypeImageSeriesReader::SetGlobalDICOMHeaderIndexDirectory("");
+  return EXIT_SUCCESS;
+}
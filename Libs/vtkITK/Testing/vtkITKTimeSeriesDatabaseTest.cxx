@@ -0,0 +1,231 @@
+#include <vtkITKTimeSeriesDatabase.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+#include <itkImageFileWriter.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkMultiThreader.h>
+#include <itkTimeSeriesDatabase.h>
+
+// STD includes
+#include <cmath>
+#include <sstream>
+
+namespace
+{
+typedef itk::TimeSeriesDatabase<short> DatabaseType;
+typedef DatabaseType::OutputImageType ImageType;
+
+const int NumberOfImages = 5;
+
+//----------------------------------------------------------------------------
+short expectedValue(const ImageType::IndexType& index, int image)
+{
+  return static_cast<short>(index[0] + 2 * index[1] + 3 * index[2] + 100 * image);
+}
+
+//----------------------------------------------------------------------------
+bool checkVoxelTimeSeries(DatabaseType* database, const ImageType::IndexType& index)
+{
+  DatabaseType::ArrayType timeSeries;
+  database->GetVoxelTimeSeries(index, timeSeries);
+  if (timeSeries.GetSize() != static_cast<unsigned int>(NumberOfImages))
+    {
+    return false;
+    }
+  for (int image = 0; image < NumberOfImages; ++image)
+    {
+    if (timeSeries[image] != expectedValue(index, image))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+struct ThreadData
+{
+  DatabaseType* Database;
+  bool Success[4];
+};
+
+//----------------------------------------------------------------------------
+ITK_THREAD_RETURN_TYPE extractTimeSeries(void* arg)
+{
+  itk::MultiThreader::ThreadInfoStruct* info =
+    static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  ThreadData* data = static_cast<ThreadData*>(info->UserData);
+  ImageType::SizeType size = data->Database->GetOutputRegion().GetSize();
+  bool success = true;
+  ImageType::IndexType index;
+  for (index[2] = info->ThreadID; index[2] < static_cast<long>(size[2]); index[2] += 4)
+    {
+    for (index[1] = 0; index[1] < static_cast<long>(size[1]); index[1] += 3)
+      {
+      for (index[0] = 0; index[0] < static_cast<long>(size[0]); index[0] += 3)
+        {
+        success = success && checkVoxelTimeSeries(data->Database, index);
+        }
+      }
+    }
+  data->Success[info->ThreadID] = success;
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+bool testDatabase(const std::string& databaseFileName, bool useMemoryMapping)
+{
+  DatabaseType::Pointer database = DatabaseType::New();
+  database->SetUseMemoryMapping(useMemoryMapping);
+  database->Connect(databaseFileName.c_str());
+  if (database->GetNumberOfVolumes() != NumberOfImages)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of volumes "
+              << database->GetNumberOfVolumes() << std::endl;
+    return false;
+    }
+
+  // Whole image
+  database->SetCurrentImage(3);
+  database->Update();
+  itk::ImageRegionIteratorWithIndex<ImageType> it(
+    database->GetOutput(), database->GetOutput()->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    if (it.Get() != expectedValue(it.GetIndex(), 3))
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong value " << it.Get()
+                << " at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+
+  // Voxel time series, from several threads at once
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  ThreadData data;
+  data.Database = database;
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(4);
+  threader->SetSingleMethod(extractTimeSeries, &data);
+  threader->SingleMethodExecute();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"VoxelTimeSeriesTime"
+            << (useMemoryMapping ? "Mapped" : "Cached") << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  for (int i = 0; i < 4; ++i)
+    {
+    if (!data.Success[i])
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong voxel time series in thread "
+                << i << std::endl;
+      return false;
+      }
+    }
+
+  // Region time series
+  ImageType::RegionType region;
+  region.SetIndex(0, 5);
+  region.SetIndex(1, 3);
+  region.SetIndex(2, 2);
+  region.SetSize(0, 26);
+  region.SetSize(1, 18);
+  region.SetSize(2, 17);
+  itk::Array<double> mean;
+  database->GetRegionTimeSeries(region, mean);
+  for (int image = 0; image < NumberOfImages; ++image)
+    {
+    double expectedMean = (5 + 30) / 2. + 2 * (3 + 20) / 2. + 3 * (2 + 18) / 2. + 100 * image;
+    if (std::fabs(mean[image] - expectedMean) > 1e-6)
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong mean " << mean[image]
+                << " instead of " << expectedMean << " in image " << image << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  itk::itkFactoryRegistration();
+
+  if (argc < 2)
+    {
+    std::cout << "ERROR: need to specify a temporary directory on the command line." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string baseName = std::string(argv[1]) + "/vtkITKTimeSeriesDatabaseTest";
+
+  // Images not aligned on blocks
+  ImageType::RegionType region;
+  region.SetSize(0, 40);
+  region.SetSize(1, 35);
+  region.SetSize(2, 20);
+  std::string archetype;
+  for (int image = 0; image < NumberOfImages; ++image)
+    {
+    ImageType::Pointer volume = ImageType::New();
+    volume->SetRegions(region);
+    volume->Allocate();
+    itk::ImageRegionIteratorWithIndex<ImageType> it(volume, region);
+    for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+      {
+      it.Set(expectedValue(it.GetIndex(), image));
+      }
+    std::ostringstream fileName;
+    fileName << baseName << "_00" << image + 1 << ".nrrd";
+    typedef itk::ImageFileWriter<ImageType> WriterType;
+    WriterType::Pointer writer = WriterType::New();
+    writer->SetFileName(fileName.str());
+    writer->SetInput(volume);
+    writer->Update();
+    if (image == 0)
+      {
+      archetype = fileName.str();
+      }
+    }
+
+  // Spread the blocks over several files
+  std::string databaseFileName = baseName + ".tsd";
+  DatabaseType::CreateFromFileArchetype(databaseFileName.c_str(), archetype.c_str(),
+                                        20 * TimeSeriesVolumeBlockSize * sizeof(short));
+
+  if (!testDatabase(databaseFileName, true) ||
+      !testDatabase(databaseFileName, false))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // VTK interface
+  vtkNew<vtkITKTimeSeriesDatabase> vtkDatabase;
+  vtkDatabase->Connect(databaseFileName.c_str());
+  vtkNew<vtkDoubleArray> values;
+  if (!vtkDatabase->GetVoxelTimeSeries(39, 34, 19, values.GetPointer()) ||
+      values->GetNumberOfTuples() != NumberOfImages ||
+      values->GetValue(4) != 39 + 2 * 34 + 3 * 19 + 400)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong voxel time series" << std::endl;
+    return EXIT_FAILURE;
+    }
+  int extent[6] = {0, 39, 0, 34, 0, 19};
+  if (!vtkDatabase->GetRegionTimeSeries(extent, values.GetPointer()) ||
+      std::fabs(values->GetValue(1) - (39 / 2. + 34 + 3 * 19 / 2. + 100)) > 1e-6)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong region time series" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkDatabase->Disconnect();
+
+  return EXIT_SUCCESS;
+}
@@ -59,6 +59,29 @@ public:
    */
   void Disconnect();
 
+  /** Map the database files in memory when connecting instead of
+   * reading the blocks through the LRU cache. The blocks are then read
+   * directly from the operating system page cache, without copy nor lock.
+   * Falls back to reading the files if the mapping fails or is not
+   * supported (Windows). On by default, must be set before Connect.
+   */
+  itkSetMacro ( UseMemoryMapping, bool );
+  itkGetMacro ( UseMemoryMapping, bool );
+  itkBooleanMacro ( UseMemoryMapping );
+
+  /** Number of images following the current image to read ahead
+   * asynchronously when the output is generated, so that playing the
+   * series does not wait on the disk. Wraps around the last image.
+   * Only effective when the files are memory mapped. Default is 1.
+   */
+  itkSetMacro ( PrefetchCount, unsigned int );
+  itkGetMacro ( PrefetchCount, unsigned int );
+
+  /** Ask the operating system to read the blocks of image \a image in
+   * the background. Returns immediately.
+   */
+  void PrefetchImage ( unsigned int image );
+
   /** Create a new TimeSeriesDatabase from an Archetype filename
    * Find all the volumes matching the archetype pattern, loading
    * and checking that they are all the same size.  Write the data
@@ -86,14 +109,20 @@ public:
 
   /** Standard method for a ImageSource object */
   virtual void GenerateOutputInformation(void);
-  virtual void GenerateData(void);
 
   /** A convience method for reading a voxel's time course
    * Subsequent calls to voxels in the immediate region of this will be
-   * cached for quick access
+   * cached for quick access. Only the block containing the voxel is read
+   * for each image. Can be called from several threads at once.
    */
   void GetVoxelTimeSeries ( typename OutputImageType::IndexType idx, ArrayType& array );
 
+  /** Compute the mean value of the voxels of \a region for each image.
+   * Only the blocks intersecting the region are read.
+   * Can be called from several threads at once.
+   */
+  void GetRegionTimeSeries ( typename OutputImageType::RegionType region, Array<double>& array );
+
   /** Set the size of the cache in MiB (1 MiB = 2^20 bytes)
    */
   void SetCacheSizeInMiB ( float sz );
@@ -106,6 +135,10 @@ protected:
   TimeSeriesDatabase();
   ~TimeSeriesDatabase();
   virtual void PrintSelf(std::ostream& os, Indent indent) const;
+
+  virtual void BeforeThreadedGenerateData();
+  virtual void ThreadedGenerateData ( const typename OutputImageType::RegionType& Region,
+                                      ThreadIdType threadId );
   Array<unsigned int> m_Dimensions;
   Array<unsigned int> m_BlocksPerImage;
 
@@ -114,6 +147,8 @@ protected:
   typename OutputImageType::PointType m_OutputOrigin;
   typename OutputImageType::DirectionType m_OutputDirection;
   typedef itk::TimeSeriesDatabaseHelper::counted_ptr<std::fstream> StreamPtr;
+  typedef itk::TimeSeriesDatabaseHelper::counted_ptr<
+    itk::TimeSeriesDatabaseHelper::MappedFile> MappedFilePtr;
 
   static std::streampos CalculatePosition ( unsigned long index, unsigned long BlocksPerFile );
 
@@ -137,13 +172,23 @@ protected:
   std::vector<std::string> m_DatabaseFileNames;
   unsigned long m_BlocksPerFile;
 
+  /// Memory mapped database files, empty if not mapped
+  std::vector<MappedFilePtr> m_MappedFiles;
+  bool m_UseMemoryMapping;
+  unsigned int m_PrefetchCount;
+  /// Serializes the reads of m_DatabaseFiles
+  SimpleFastMutexLock m_FileLock;
+
   /// our cache
   struct CacheBlock
   {
     TPixel data[TimeSeriesBlockSize*TimeSeriesBlockSize*TimeSeriesBlockSize];
   };
-  TimeSeriesDatabaseHelper::LRUCache<unsigned long, CacheBlock> m_Cache;
-  CacheBlock* GetCacheBlock ( unsigned long index );
+  TimeSeriesDatabaseHelper::StripedLRUCache<unsigned long, CacheBlock> m_Cache;
+  /// Return the pixels of the block at \a index, either directly from the
+  /// memory mapped file or copied into \a buffer from the cache or the file.
+  /// Thread safe.
+  const TPixel* GetCacheBlock ( unsigned long index, CacheBlock& buffer );
 };
 
 } // end namespace itk
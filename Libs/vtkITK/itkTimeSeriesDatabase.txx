@@ -9,6 +9,7 @@
 #include <itkImageFileReader.h>
 #include <itksys/SystemTools.hxx>
 #include "itkArchetypeSeriesFileNames.h"
+#include <algorithm>
 #include <fstream>
 #include <vector>
 
@@ -66,6 +67,9 @@ void TimeSeriesDatabase<TPixel>::Disconnect ()
     }
   this->m_DatabaseFiles.clear();
   this->m_DatabaseFileNames.clear();
+  this->m_MappedFiles.clear();
+  // The blocks of another database would have the same indices
+  this->m_Cache.clear();
 }
 
 template <class TPixel>
@@ -130,6 +134,18 @@ void TimeSeriesDatabase<TPixel>::Connect ( const char* filename )
     // std::cout << "Reading file " << idx << " " << Filename << std::endl;
     this->m_DatabaseFileNames.push_back ( Filename );
     this->m_DatabaseFiles.push_back ( StreamPtr ( new std::fstream ( Filename.c_str(), ::std::ios::in | ::std::ios::binary ) ) );
+    if ( this->m_UseMemoryMapping )
+      {
+      this->m_MappedFiles.push_back ( MappedFilePtr ( new TimeSeriesDatabaseHelper::MappedFile ) );
+      }
+    }
+  // Read through the cache if any file can't be mapped
+  for ( ::size_t idx = 0; idx < this->m_MappedFiles.size(); idx++ )
+    {
+    if ( !this->m_MappedFiles[idx]->open ( this->m_DatabaseFileNames[idx].c_str() ) )
+      {
+      this->m_MappedFiles.clear();
+      }
     }
   /*
   std::cout << "ImageSize: " << m_OutputRegion.GetSize() << endl;
@@ -184,20 +200,57 @@ template <class TPixel>
 
 
 template <class TPixel>
-typename TimeSeriesDatabase<TPixel>::CacheBlock* TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index )
+const TPixel* TimeSeriesDatabase<TPixel>::GetCacheBlock ( unsigned long index, CacheBlock& Buffer )
 {
-  CacheBlock* Buffer = this->m_Cache.find ( index );
-  if ( Buffer == 0 ) {
+  int FileIdx = this->CalculateFileIndex ( index );
+  ::size_t Position = static_cast<std::streamoff> ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
+  const ::size_t BlockBytes = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  if ( !this->m_MappedFiles.empty() ) {
+    const TimeSeriesDatabaseHelper::MappedFile* File = this->m_MappedFiles[FileIdx].get();
+    if ( Position + BlockBytes <= File->size() ) {
+      return reinterpret_cast<const TPixel*> ( File->get_data() + Position );
+    }
+    // Truncated file
+    std::fill ( Buffer.data, Buffer.data + TimeSeriesVolumeBlockSize, TPixel() );
+    return Buffer.data;
+  }
+  if ( !this->m_Cache.find ( index, Buffer ) ) {
     // Fill it in
-    CacheBlock B;
-    int FileIdx = this->CalculateFileIndex ( index );
-
-    this->m_DatabaseFiles[FileIdx]->seekg ( this->CalculatePosition ( index, this->m_BlocksPerFile ) );
-    this->m_DatabaseFiles[FileIdx]->read ( reinterpret_cast<char*> ( B.data ), TimeSeriesVolumeBlockSize * sizeof ( TPixel ) );
-    this->m_Cache.insert ( index, B );
-    Buffer = this->m_Cache.find ( index );
+    this->m_FileLock.Lock();
+    this->m_DatabaseFiles[FileIdx]->seekg ( Position );
+    this->m_DatabaseFiles[FileIdx]->read ( reinterpret_cast<char*> ( Buffer.data ), BlockBytes );
+    this->m_FileLock.Unlock();
+    this->m_Cache.insert ( index, Buffer );
   }
-  return Buffer;
+  return Buffer.data;
+}
+
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::PrefetchImage ( unsigned int image )
+{
+  if ( this->m_MappedFiles.empty() || image >= this->m_Dimensions[3] )
+    {
+    return;
+    }
+  // The blocks of an image are contiguous, possibly spread over two files
+  Size<3> FirstBlock = {{ 0, 0, 0 }};
+  unsigned long First = this->CalculateIndex ( FirstBlock, image );
+  unsigned long Last = First + this->m_BlocksPerImage[0] * this->m_BlocksPerImage[1] * this->m_BlocksPerImage[2] - 1;
+  const ::size_t BlockBytes = TimeSeriesVolumeBlockSize * sizeof ( TPixel );
+  while ( First <= Last )
+    {
+    unsigned int FileIdx = this->CalculateFileIndex ( First );
+    unsigned long FileLast = TSD_MIN<unsigned long> ( Last, ( FileIdx + 1 ) * this->m_BlocksPerFile - 1 );
+    if ( FileIdx >= this->m_MappedFiles.size() )
+      {
+      return;
+      }
+    this->m_MappedFiles[FileIdx]->will_need (
+      static_cast<std::streamoff> ( this->CalculatePosition ( First, this->m_BlocksPerFile ) ),
+      ( FileLast - First + 1 ) * BlockBytes );
+    First = FileLast + 1;
+    }
 }
 
 
@@ -206,20 +259,59 @@ void TimeSeriesDatabase<TPixel>::GetVoxelTimeSeries ( typename OutputImageType::
 {
   // See if the index is inside the volume
   // and figure out which cache block we need
+  if ( !this->m_OutputRegion.IsInside ( idx ) ) {
+    itkExceptionMacro ( "TimeSeriesDatabase::GetVoxelTimeSeries: index " << idx << " is outside of the image" );
+  }
   Size<3> CurrentBlock;
   Size<3> Offset;
   for ( int i = 0; i < 3; i++ ) {
-    if ( idx[i] < 0 || idx[i] > this->m_OutputRegion.Size[i] ) {
-      throw 1;
-    }
-    CurrentBlock[i] = reinterpret_cast<unsigned long> ( idx[i] / (double)TimeSeriesBlockSize );
+    CurrentBlock[i] = idx[i] / TimeSeriesBlockSize;
     Offset[i] = idx[i] % TimeSeriesBlockSize;
   }
   unsigned long offset = Offset[0] + Offset[1] * TimeSeriesBlockSize + Offset[2] * TimeSeriesBlockSizeP2;
-  array = ArrayType ( this->m_Dimensions[3] );
-  for ( int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
-    CacheBlock* cache = this->GetCacheBlock ( CurrentBlock, volume );
-    array[volume] = cache->data[offset];
+  array.SetSize ( this->m_Dimensions[3] );
+  CacheBlock Buffer;
+  for ( unsigned int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
+    const TPixel* data = this->GetCacheBlock ( this->CalculateIndex ( CurrentBlock, volume ), Buffer );
+    array[volume] = data[offset];
+  }
+}
+
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::GetRegionTimeSeries ( typename OutputImageType::RegionType region, Array<double>& array )
+{
+  if ( !region.Crop ( this->m_OutputRegion ) || region.GetNumberOfPixels() == 0 ) {
+    itkExceptionMacro ( "TimeSeriesDatabase::GetRegionTimeSeries: region " << region << " is outside of the image" );
+  }
+  Size<3> BlockStart, BlockEnd;
+  for ( unsigned int i = 0; i < 3; i++ ) {
+    BlockStart[i] = region.GetIndex(i) / TimeSeriesBlockSize;
+    BlockEnd[i] = ( region.GetIndex(i) + region.GetSize(i) - 1 ) / TimeSeriesBlockSize;
+  }
+  array.SetSize ( this->m_Dimensions[3] );
+  CacheBlock Buffer;
+  for ( unsigned int volume = 0; volume < this->m_Dimensions[3]; volume++ ) {
+    double sum = 0.;
+    Size<3> CurrentBlock;
+    for ( CurrentBlock[2] = BlockStart[2]; CurrentBlock[2] <= BlockEnd[2]; CurrentBlock[2]++ ) {
+      for ( CurrentBlock[1] = BlockStart[1]; CurrentBlock[1] <= BlockEnd[1]; CurrentBlock[1]++ ) {
+        for ( CurrentBlock[0] = BlockStart[0]; CurrentBlock[0] <= BlockEnd[0]; CurrentBlock[0]++ ) {
+          typename OutputImageType::RegionType BR, IR;
+          this->CalculateIntersection ( CurrentBlock, region, BR, IR );
+          const TPixel* data = this->GetCacheBlock ( this->CalculateIndex ( CurrentBlock, volume ), Buffer );
+          for ( IndexValueType z = BR.GetIndex(2); z < BR.GetIndex(2) + static_cast<IndexValueType>( BR.GetSize(2) ); z++ ) {
+            for ( IndexValueType y = BR.GetIndex(1); y < BR.GetIndex(1) + static_cast<IndexValueType>( BR.GetSize(1) ); y++ ) {
+              const TPixel* ptr = data + BR.GetIndex(0) + TimeSeriesBlockSize * y + TimeSeriesBlockSizeP2 * z;
+              for ( SizeValueType x = 0; x < BR.GetSize(0); x++ ) {
+                sum += ptr[x];
+              }
+            }
+          }
+        }
+      }
+    }
+    array[volume] = sum / region.GetNumberOfPixels();
   }
 }
 
@@ -235,19 +327,24 @@ void TimeSeriesDatabase<TPixel>::GenerateOutputInformation ( )
 }
 
 template <class TPixel>
-void TimeSeriesDatabase<TPixel>::GenerateData()
+void TimeSeriesDatabase<TPixel>::BeforeThreadedGenerateData()
 {
-  typename OutputImageType::Pointer output = this->GetOutput();
-  typename OutputImageType::RegionType Region;
-  itkDebugMacro ( << "TimeSeriesDatabase::GenerateData()  Allocating" );
-  Region = output->GetRequestedRegion();
-  output->SetBufferedRegion ( Region );
-  output->Allocate();
-
   if ( !this->IsOpen() )
   {
     itkGenericExceptionMacro ( "TimeSeriesDatabase::GenerateOutputInformation: not open for reading" );
   }
+  // Read ahead the next images while this one is generated
+  for ( unsigned int i = 1; i <= this->m_PrefetchCount && i < this->m_Dimensions[3]; i++ )
+  {
+    this->PrefetchImage ( ( this->m_CurrentImage + i ) % this->m_Dimensions[3] );
+  }
+}
+
+template <class TPixel>
+void TimeSeriesDatabase<TPixel>::ThreadedGenerateData ( const typename OutputImageType::RegionType& Region,
+                                                        ThreadIdType itkNotUsed(threadId) )
+{
+  typename OutputImageType::Pointer output = this->GetOutput();
 
   Size<3> BlockStart, BlockCount;
   for ( unsigned int i = 0; i < 3; i++ ) {
@@ -264,7 +361,8 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
     }
 
   Size<3> CurrentBlock;
-  // Now, read our data, caching as we go, in future, make this thread safe
+  CacheBlock Block;
+  // Now, read our data, caching as we go
   Size<3> BlockSize = { {TimeSeriesBlockSize, TimeSeriesBlockSize, TimeSeriesBlockSize }};
   ImageRegion<3> BlockRegion;
   BlockRegion.SetSize ( BlockSize );
@@ -275,7 +373,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
         typename OutputImageType::RegionType BR, IR;
         if ( print ) {  std::cout << "For Block Index: " << CurrentBlock << std::endl; }
         unsigned long index = this->CalculateIndex ( CurrentBlock, this->m_CurrentImage );
-        CacheBlock* Buffer = this->GetCacheBlock ( index );
+        const TPixel* Buffer = this->GetCacheBlock ( index, Block );
         if ( this->CalculateIntersection ( CurrentBlock, Region, BR, IR ) ) {
           // Just iterate over whole block
           // Good we can use an iterator!
@@ -290,7 +388,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
           BlockRegion.SetIndex ( BlockIndex );
           ImageRegionIterator<OutputImageType> it ( output, IR );
           it.GoToBegin();
-          TPixel* ptr = Buffer->data;
+          const TPixel* ptr = Buffer;
           while ( !it.IsAtEnd() ) {
             it.Set ( *ptr );
             ++it;
@@ -305,7 +403,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
             std::cout << "Count: " << Count << std::endl;
             std::cout << "Block Region: " << BR;
             std::cout << "Image Region: " << IR;
-            std::cout << "First voxel: " << Buffer->data[0] << std::endl;
+            std::cout << "First voxel: " << Buffer[0] << std::endl;
           }
           unsigned int bx, by, bz, x, y, z;
           for ( z = 0; z < Count[2]; z++ ) {
@@ -325,7 +423,7 @@ void TimeSeriesDatabase<TPixel>::GenerateData()
                 }
                 */
 
-                output->SetPixel ( ImageIndex, Buffer->data[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
+                output->SetPixel ( ImageIndex, Buffer[bx + TimeSeriesBlockSize*by + TimeSeriesBlockSize*TimeSeriesBlockSize*bz] );
                 }
               }
             }
@@ -569,7 +667,7 @@ void TimeSeriesDatabase<TPixel>::SetCacheSizeInMiB ( float sz )
 {
   // How many blocks is this?
   double BlockSizeInMiB = sizeof ( TPixel ) * TimeSeriesVolumeBlockSize / ( 1024*1024.);
-  unsigned long int blocks = (unsigned long int) ceil ( sz * BlockSizeInMiB );
+  unsigned long int blocks = (unsigned long int) ceil ( sz / BlockSizeInMiB );
   this->m_Cache.set_maxsize ( blocks );
 }
 
@@ -579,6 +677,8 @@ template <class TPixel>
 TimeSeriesDatabase<TPixel>::TimeSeriesDatabase () : m_Cache ( 1024 ){
   this->m_Dimensions.SetSize ( 4 );
   this->m_BlocksPerImage.SetSize ( 4 );
+  this->m_UseMemoryMapping = true;
+  this->m_PrefetchCount = 1;
 }
 
 template <class TPixel>
@@ -604,6 +704,7 @@ TimeSeriesDatabase<TPixel>
   if ( this->IsOpen() ) {
     os << indent << "Database is open." << "\n";
     os << indent << "Blocks per file: " << this->m_BlocksPerFile << "\n";
+    os << indent << "Memory mapped: " << ( this->m_MappedFiles.empty() ? "No" : "Yes" ) << "\n";
     os << indent << "File names: " << "\n";
     for ( ::size_t idx = 0; idx < this->m_DatabaseFileNames.size(); idx++ )
       {
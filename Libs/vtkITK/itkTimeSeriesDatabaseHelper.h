@@ -7,6 +7,16 @@
 #include <cstdarg>
 #include <cassert>
 
+#include <itkSimpleFastMutexLock.h>
+
+#ifndef _WIN32
+# define ITK_TIME_SERIES_DATABASE_USE_MMAP
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
 namespace itk {
   namespace TimeSeriesDatabaseHelper {
     /// Some useful classes
@@ -356,6 +366,197 @@ namespace itk {
       } stats;
 #endif
     };
+
+    /// A thread-safe cache.
+    ///
+    /// The keys are distributed over several LRU caches ("stripes"), each
+    /// protected by its own lock, so that threads looking up keys of
+    /// different stripes do not wait for each other. key_type must be
+    /// convertible to an unsigned integer.
+    ///
+    /// Unlike LRUCache::find(), find() copies the value because another
+    /// thread may evict it as soon as the lock is released.
+    ///
+    template <typename key_type, typename value_type, unsigned stripes = 16>
+      class StripedLRUCache
+    {
+    public:
+      StripedLRUCache(unsigned maxsize_ = 100)
+      {
+        set_maxsize(maxsize_);
+      }
+
+      /// The maximal size is shared evenly between the stripes.
+      ///
+      void set_maxsize ( unsigned maxsize_ ) {
+        maxsize = maxsize_;
+        unsigned stripe_maxsize = (maxsize_ + stripes - 1) / stripes;
+        for (unsigned i = 0; i < stripes; ++i)
+          {
+            locks[i].Lock();
+            caches[i].set_maxsize(stripe_maxsize > 0 ? stripe_maxsize : 1);
+            locks[i].Unlock();
+          }
+      }
+
+      unsigned get_maxsize () {
+        return maxsize;
+      }
+
+      /// Clear the cache.
+      ///
+      void clear()
+      {
+        for (unsigned i = 0; i < stripes; ++i)
+          {
+            locks[i].Lock();
+            caches[i].clear();
+            locks[i].Unlock();
+          }
+      }
+
+      /// Inserts a key/value pair to the cache.
+      ///
+      void insert(const key_type& key, const value_type& value)
+      {
+        unsigned i = stripe(key);
+        locks[i].Lock();
+        caches[i].insert(key, value);
+        locks[i].Unlock();
+      }
+
+      /// Looks for a key in the cache and copies its value into \a value.
+      ///
+      /// Returns true if found, false otherwise.
+      ///
+      bool find(const key_type& key, value_type& value)
+      {
+        unsigned i = stripe(key);
+        locks[i].Lock();
+        value_type* valptr = caches[i].find(key);
+        if (valptr)
+          {
+            value = *valptr;
+          }
+        locks[i].Unlock();
+        return valptr != 0;
+      }
+
+      /// Prints the statistics of each stripe.
+      ///
+      void statistics(ostream& ostr = cerr) const
+      {
+        for (unsigned i = 0; i < stripes; ++i)
+          {
+            locks[i].Lock();
+            caches[i].statistics(ostr);
+            locks[i].Unlock();
+          }
+      }
+
+    private:
+      static unsigned stripe(const key_type& key)
+      {
+        return static_cast<unsigned>(key % stripes);
+      }
+
+      unsigned maxsize;
+      LRUCache<key_type, value_type> caches[stripes];
+      mutable itk::SimpleFastMutexLock locks[stripes];
+    };
+
+    /// A read-only memory mapping of a whole file.
+    ///
+    /// The operating system pages the file in and out on demand, and the
+    /// mapped data can be read by any number of threads without locking.
+    /// Memory mapping is only available on POSIX systems: open() always
+    /// fails elsewhere and the caller is expected to read the file instead.
+    ///
+    class MappedFile
+    {
+    public:
+      MappedFile()
+        : data(0), length(0)
+      {
+      }
+
+      ~MappedFile()
+        {
+          close();
+        }
+
+      /// Maps \a filename in memory. Returns false on failure.
+      ///
+      bool open(const char* filename)
+      {
+        close();
+#ifdef ITK_TIME_SERIES_DATABASE_USE_MMAP
+        int fd = ::open(filename, O_RDONLY);
+        if (fd < 0)
+          {
+            return false;
+          }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+          {
+            void* address = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (address != MAP_FAILED)
+              {
+                data = static_cast<const char*>(address);
+                length = st.st_size;
+              }
+          }
+        /// The mapping remains valid after closing the descriptor
+        ::close(fd);
+#else
+        (void)filename;
+#endif
+        return data != 0;
+      }
+
+      void close()
+      {
+#ifdef ITK_TIME_SERIES_DATABASE_USE_MMAP
+        if (data)
+          {
+            munmap(const_cast<char*>(data), length);
+          }
+#endif
+        data = 0;
+        length = 0;
+      }
+
+      const char* get_data() const { return data; }
+      size_t size() const { return length; }
+
+      /// Hints the operating system that the bytes in
+      /// [offset, offset + size) will be accessed soon. The pages are
+      /// read asynchronously: the call does not block on I/O.
+      ///
+      void will_need(size_t offset, size_t size_)
+      {
+#ifdef ITK_TIME_SERIES_DATABASE_USE_MMAP
+        if (!data || offset >= length)
+          {
+            return;
+          }
+        size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        size_t start = offset - offset % page_size;
+        size_t end = offset + size_ < length ? offset + size_ : length;
+        madvise(const_cast<char*>(data + start), end - start, MADV_WILLNEED);
+#else
+        (void)offset;
+        (void)size_;
+#endif
+      }
+
+    private:
+      MappedFile(const MappedFile&);
+      MappedFile& operator=(const MappedFile&);
+
+      const char* data;
+      size_t length;
+    };
   }
 }
 #endif
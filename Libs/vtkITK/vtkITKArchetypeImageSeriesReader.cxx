@@ -28,9 +28,23 @@
 #include <itkMetaDataDictionary.h>
 #include <itkMetaDataObjectBase.h>
 #include <itkMetaDataObject.h>
+#include <itkSimpleFastMutexLock.h>
 #include <itkTimeProbe.h>
+#ifdef _WIN32
+# include <itkWindows.h>
+# include <process.h>
+#else
+# include <unistd.h>
+#endif
 
 // STD includes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
 #include <vector>
 
 #include "itkArchetypeSeriesFileNames.h"
@@ -39,6 +53,10 @@
 #include "itkGDCMSeriesFileNames.h"
 #include "itkGDCMImageIO.h"
 
+// GDCM includes
+#include "gdcmReader.h"
+#include "gdcmStringFilter.h"
+
 vtkStandardNewMacro(vtkITKArchetypeImageSeriesReader);
 
 //----------------------------------------------------------------------------
@@ -48,6 +66,7 @@ vtkITKArchetypeImageSeriesReader::vtkITKArchetypeImageSeriesReader()
   this->IndexArchetype = 0;
   this->SingleFile = 1;
   this->UseOrientationFromFile = 1;
+  this->NumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
   this->RasToIjkMatrix = NULL;
   this->MeasurementFrameMatrix = vtkMatrix4x4::New();
   this->MeasurementFrameMatrix->Identity();
@@ -134,6 +153,8 @@ void vtkITKArchetypeImageSeriesReader::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Archetype: " <<
     (this->Archetype ? this->Archetype : "(none)") << "\n";
 
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+
   os << indent << "FileNameSliceOffset: "
      << this->FileNameSliceOffset << "\n";
   os << indent << "FileNameSliceSpacing: "
@@ -935,6 +956,255 @@ void vtkITKArchetypeImageSeriesReader::GroupFiles ( int idxSeriesInstanceUID,
   return;
 }
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Tags read by AnalyzeDicomHeaders(), in the order of vtkITKDICOMHeader::Values
+const char* const DICOMHeaderTags[] = {
+  "0020|000e", // series instance UID
+  "0008|0033", // content time
+  "0018|1060", // trigger time
+  "0018|0086", // echo numbers
+  "0010|9089", // diffusion gradient orientation
+  "0020|1041", // slice location
+  "0020|0037", // image orientation patient
+  "0020|0032"  // image position patient
+  };
+const int NumberOfDICOMHeaderTags = 8;
+
+const char* const DICOMHeaderIndexSignature = "vtkITKDICOMHeaderIndex 1";
+
+//----------------------------------------------------------------------------
+struct vtkITKDICOMHeader
+{
+  vtkITKDICOMHeader() : ModifiedTime(0), FileSize(0) {}
+  long int ModifiedTime;
+  unsigned long FileSize;
+  std::string Values[NumberOfDICOMHeaderTags];
+};
+
+/// Headers by file path
+typedef std::map<std::string, vtkITKDICOMHeader> vtkITKDICOMHeaderIndex;
+
+//----------------------------------------------------------------------------
+// Shared by all the readers, that may run in different threads. Initialized
+// with the library so that the first readers do not race to construct them.
+std::string               GlobalDICOMHeaderIndexDirectory;
+itk::SimpleFastMutexLock  GlobalDICOMHeaderIndexLock;
+unsigned long             DICOMHeaderIndexWriteCount = 0;
+
+//----------------------------------------------------------------------------
+// Index file of the files in directory, empty if there is no index directory.
+std::string GetDICOMHeaderIndexFileName(const std::string& directory)
+{
+  GlobalDICOMHeaderIndexLock.Lock();
+  const std::string indexDirectory = GlobalDICOMHeaderIndexDirectory;
+  GlobalDICOMHeaderIndexLock.Unlock();
+  if (indexDirectory.empty())
+    {
+    return std::string();
+    }
+  // FNV-1a hash of the directory
+  vtkTypeUInt64 hash = 14695981039346656037ULL;
+  for (std::string::const_iterator it = directory.begin(); it != directory.end(); ++it)
+    {
+    hash ^= static_cast<unsigned char>(*it);
+    hash *= 1099511628211ULL;
+    }
+  std::ostringstream fileName;
+  fileName << indexDirectory << "/" << std::hex << hash << ".txt";
+  return fileName.str();
+}
+
+//----------------------------------------------------------------------------
+void ReadDICOMHeaderIndex(const std::string& fileName, vtkITKDICOMHeaderIndex& index)
+{
+  std::ifstream file(fileName.c_str());
+  std::string line;
+  if (!file || !std::getline(file, line) || line != DICOMHeaderIndexSignature)
+    {
+    return;
+    }
+  std::vector<std::string> fields;
+  while (std::getline(file, line))
+    {
+    // path, modification time, size and tag values separated by tabs
+    fields.resize(0);
+    std::string::size_type start = 0;
+    std::string::size_type end;
+    while ((end = line.find('\t', start)) != std::string::npos)
+      {
+      fields.push_back(line.substr(start, end - start));
+      start = end + 1;
+      }
+    fields.push_back(line.substr(start));
+    if (fields.size() != 3 + NumberOfDICOMHeaderTags)
+      {
+      continue;
+      }
+    vtkITKDICOMHeader& header = index[fields[0]];
+    header.ModifiedTime = atol(fields[1].c_str());
+    header.FileSize = strtoul(fields[2].c_str(), NULL, 10);
+    for (int k = 0; k < NumberOfDICOMHeaderTags; ++k)
+      {
+      header.Values[k] = fields[3 + k];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Move sourceFileName to destinationFileName, replacing destinationFileName
+// if it exists, in a single step: readers see either the old or the new
+// destination file.
+bool ReplaceFile(const std::string& sourceFileName,
+                 const std::string& destinationFileName)
+{
+#ifdef _WIN32
+  return MoveFileExA(sourceFileName.c_str(), destinationFileName.c_str(),
+                     MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  return std::rename(sourceFileName.c_str(), destinationFileName.c_str()) == 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Temporary file next to fileName, unique to this process and this call so
+// that concurrent writers, in this process or in others, never share it.
+std::string GetDICOMHeaderIndexTemporaryFileName(const std::string& fileName)
+{
+  GlobalDICOMHeaderIndexLock.Lock();
+  const unsigned long count = ++DICOMHeaderIndexWriteCount;
+  GlobalDICOMHeaderIndexLock.Unlock();
+#ifdef _WIN32
+  const long processId = _getpid();
+#else
+  const long processId = getpid();
+#endif
+  std::ostringstream temporaryFileName;
+  temporaryFileName << fileName << "." << processId << "." << count << ".tmp";
+  return temporaryFileName.str();
+}
+
+//----------------------------------------------------------------------------
+void WriteDICOMHeaderIndex(const std::string& fileName, const vtkITKDICOMHeaderIndex& index)
+{
+  itksys::SystemTools::MakeDirectory(
+    itksys::SystemTools::GetFilenamePath(fileName).c_str());
+  // Write to a temporary file first so that a concurrent reader never sees
+  // a partial index.
+  std::string temporaryFileName = GetDICOMHeaderIndexTemporaryFileName(fileName);
+  std::ofstream file(temporaryFileName.c_str());
+  if (!file)
+    {
+    return;
+    }
+  file << DICOMHeaderIndexSignature << "\n";
+  for (vtkITKDICOMHeaderIndex::const_iterator it = index.begin(); it != index.end(); ++it)
+    {
+    const vtkITKDICOMHeader& header = it->second;
+    // Values that would break the format are not indexed
+    bool valid = it->first.find_first_of("\t\n\r") == std::string::npos;
+    for (int k = 0; k < NumberOfDICOMHeaderTags; ++k)
+      {
+      valid = valid && header.Values[k].find_first_of("\t\n\r") == std::string::npos;
+      }
+    if (!valid)
+      {
+      continue;
+      }
+    file << it->first << "\t" << header.ModifiedTime << "\t" << header.FileSize;
+    for (int k = 0; k < NumberOfDICOMHeaderTags; ++k)
+      {
+      file << "\t" << header.Values[k];
+      }
+    file << "\n";
+    }
+  file.close();
+  if (file.fail())
+    {
+    itksys::SystemTools::RemoveFile(temporaryFileName.c_str());
+    return;
+    }
+  if (!ReplaceFile(temporaryFileName, fileName))
+    {
+    itksys::SystemTools::RemoveFile(temporaryFileName.c_str());
+    }
+}
+
+//----------------------------------------------------------------------------
+// Read only the tags of DICOMHeaderTags, the file is not parsed any further
+// than the last of them.
+void ReadDICOMHeader(const std::string& fileName, vtkITKDICOMHeader& header)
+{
+  std::set<gdcm::Tag> tags;
+  gdcm::Tag tagList[NumberOfDICOMHeaderTags];
+  for (int k = 0; k < NumberOfDICOMHeaderTags; ++k)
+    {
+    tagList[k].ReadFromPipeSeparatedString(DICOMHeaderTags[k]);
+    tags.insert(tagList[k]);
+    }
+  gdcm::Reader reader;
+  reader.SetFileName(fileName.c_str());
+  if (!reader.ReadSelectedTags(tags))
+    {
+    return;
+    }
+  // Same conversion as the meta data dictionary of itk::GDCMImageIO
+  gdcm::StringFilter filter;
+  filter.SetFile(reader.GetFile());
+  const gdcm::DataSet& dataSet = reader.GetFile().GetDataSet();
+  for (int k = 0; k < NumberOfDICOMHeaderTags; ++k)
+    {
+    if (dataSet.FindDataElement(tagList[k]))
+      {
+      header.Values[k] = filter.ToString(tagList[k]);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+struct vtkITKDICOMHeaderScanStruct
+{
+  const std::vector<std::string>* FileNames;
+  std::vector<vtkITKDICOMHeader>* Headers;
+  std::vector<int> FilesToScan;
+};
+
+//----------------------------------------------------------------------------
+ITK_THREAD_RETURN_TYPE vtkITKScanDICOMHeadersThread(void* arg)
+{
+  itk::MultiThreader::ThreadInfoStruct* info =
+    static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  vtkITKDICOMHeaderScanStruct* str =
+    static_cast<vtkITKDICOMHeaderScanStruct*>(info->UserData);
+  for (size_t i = info->ThreadID; i < str->FilesToScan.size(); i += info->NumberOfThreads)
+    {
+    int f = str->FilesToScan[i];
+    ReadDICOMHeader((*str->FileNames)[f], (*str->Headers)[f]);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkITKArchetypeImageSeriesReader::SetGlobalDICOMHeaderIndexDirectory(const char* directory)
+{
+  GlobalDICOMHeaderIndexLock.Lock();
+  GlobalDICOMHeaderIndexDirectory = directory ? directory : "";
+  GlobalDICOMHeaderIndexLock.Unlock();
+}
+
+//----------------------------------------------------------------------------
+std::string vtkITKArchetypeImageSeriesReader::GetGlobalDICOMHeaderIndexDirectory()
+{
+  GlobalDICOMHeaderIndexLock.Lock();
+  const std::string directory = GlobalDICOMHeaderIndexDirectory;
+  GlobalDICOMHeaderIndexLock.Unlock();
+  return directory;
+}
+
 //----------------------------------------------------------------------------
 void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
 {
@@ -1040,17 +1310,66 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     return;
     }
 
-  // if Archetype is a Dicom File
-  gdcmIO->SetFileName( this->Archetype );
+  // if Archetype is a Dicom File, read the needed tags of all the files.
+  // Headers of the files that did not change since they were indexed are
+  // not read again.
+  std::vector<vtkITKDICOMHeader> headers( nFiles );
+  std::string indexFileName = GetDICOMHeaderIndexFileName(
+    itksys::SystemTools::GetFilenamePath(
+      itksys::SystemTools::CollapseFullPath( this->Archetype ) ) );
+  vtkITKDICOMHeaderIndex index;
+  if ( !indexFileName.empty() )
+    {
+    ReadDICOMHeaderIndex( indexFileName, index );
+    }
+
+  vtkITKDICOMHeaderScanStruct str;
+  str.FileNames = &this->AllFileNames;
+  str.Headers = &headers;
+  for (int f = 0; f < nFiles; f++)
+    {
+    const std::string& fileName = this->AllFileNames[f];
+    headers[f].ModifiedTime = itksys::SystemTools::ModifiedTime( fileName.c_str() );
+    headers[f].FileSize = itksys::SystemTools::FileLength( fileName.c_str() );
+    vtkITKDICOMHeaderIndex::const_iterator it = index.find( fileName );
+    if ( it != index.end() &&
+         it->second.ModifiedTime == headers[f].ModifiedTime &&
+         it->second.FileSize == headers[f].FileSize )
+      {
+      headers[f] = it->second;
+      }
+    else
+      {
+      str.FilesToScan.push_back( f );
+      }
+    }
+
+  if ( !str.FilesToScan.empty() )
+    {
+    itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+    threader->SetNumberOfThreads(
+      std::min( this->NumberOfThreads, static_cast<int>( str.FilesToScan.size() ) ) );
+    threader->SetSingleMethod( vtkITKScanDICOMHeadersThread, &str );
+    threader->SingleMethodExecute();
+
+    if ( !indexFileName.empty() )
+      {
+      for (size_t i = 0; i < str.FilesToScan.size(); i++)
+        {
+        int f = str.FilesToScan[i];
+        index[this->AllFileNames[f]] = headers[f];
+        }
+      WriteDICOMHeaderIndex( indexFileName, index );
+      }
+    }
+
   for (int f = 0; f < nFiles; f++)
   {
-    gdcmIO->SetFileName( this->AllFileNames[f] );
-    gdcmIO->ReadImageInformation();
-    itk::MetaDataDictionary &dict = gdcmIO->GetMetaDataDictionary();
+    const vtkITKDICOMHeader& header = headers[f];
     std::string tagValue;
 
     // series instance UID
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|000e", tagValue );
+    tagValue = header.Values[0];
     if ( tagValue.length() > 0 )
     {
       int idx = InsertSeriesInstanceUIDs( tagValue.c_str() );
@@ -1062,7 +1381,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // content time
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0008|0033", tagValue );
+    tagValue = header.Values[1];
     if ( tagValue.length() > 0 )
     {
       int idx = InsertContentTime( tagValue.c_str() );
@@ -1074,7 +1393,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // trigger time
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0018|1060", tagValue );
+    tagValue = header.Values[2];
     if ( tagValue.length() > 0 )
     {
       int idx = InsertTriggerTime( tagValue.c_str() );
@@ -1086,7 +1405,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // echo numbers
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0018|0086", tagValue );
+    tagValue = header.Values[3];
     if ( tagValue.length() > 0 )
     {
       int idx = InsertEchoNumbers( tagValue.c_str() );
@@ -1098,7 +1417,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // diffision gradient orientation
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0010|9089", tagValue );
+    tagValue = header.Values[4];
     if ( tagValue.length() > 0 )
     {
       float a[3];
@@ -1112,7 +1431,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // slice location
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|1041", tagValue );
+    tagValue = header.Values[5];
     if ( tagValue.length() > 0 )
     {
       float a;
@@ -1126,7 +1445,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     }
 
     // image orientation patient
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|0037", tagValue );
+    tagValue = header.Values[6];
     if ( tagValue.length() > 0 )
     {
       float a[6];
@@ -1139,7 +1458,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       this->IndexImageOrientationPatient[f] = -1;
     }
     // image position patient
-    tagValue.clear(); itk::ExposeMetaData<std::string>( dict, "0020|0032", tagValue );
+    tagValue = header.Values[7];
     if( tagValue.length() > 0 )
     {
         float a[3];
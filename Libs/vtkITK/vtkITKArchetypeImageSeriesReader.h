@@ -24,6 +24,7 @@ class vtkMatrix4x4;
 
 // ITK includes
 #include "itkMetaDataDictionary.h"
+#include "itkMultiThreader.h"
 #include "itkSpatialOrientation.h"
 
 // STD includes
@@ -233,6 +234,22 @@ public:
   vtkSetMacro(UseOrientationFromFile, int);
   vtkGetMacro(UseOrientationFromFile, int);
 
+  ///
+  /// Number of threads used to read the DICOM headers of the candidate files.
+  /// By default, itk::MultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads, int, 1, ITK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads, int);
+
+  ///
+  /// Directory where the DICOM headers read by the readers are indexed,
+  /// one index file per scanned directory. Entries are keyed by file path,
+  /// modification time and size: files that did not change are not read
+  /// again when the same directory is loaded or regrouped.
+  /// Shared by all the readers, empty (no index) by default.
+  /// Can be changed while readers run in other threads.
+  static void SetGlobalDICOMHeaderIndexDirectory(const char* directory);
+  static std::string GetGlobalDICOMHeaderIndexDirectory();
+
   ///
   /// Returns an IJK to RAS transformation matrix
   vtkMatrix4x4* GetRasToIjkMatrix();
@@ -788,6 +805,7 @@ protected:
   char *Archetype;
   int SingleFile;
   int UseOrientationFromFile;
+  int NumberOfThreads;
   int DataExtent[6];
 
   int          OutputScalarType;
@@ -13,12 +13,81 @@
 ==========================================================================*/
 #include "vtkITKTimeSeriesDatabase.h"
 
+#include <vtkDoubleArray.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkUnsignedLongArray.h>
 
 vtkStandardNewMacro(vtkITKTimeSeriesDatabase);
+
+//----------------------------------------------------------------------------
+bool vtkITKTimeSeriesDatabase::GetVoxelTimeSeries(int i, int j, int k, vtkDoubleArray* values)
+{
+  if (!values)
+    {
+    return false;
+    }
+  SourceType::OutputImageType::IndexType index;
+  index[0] = i;
+  index[1] = j;
+  index[2] = k;
+  SourceType::ArrayType timeSeries;
+  try
+    {
+    this->m_Filter->GetVoxelTimeSeries(index, timeSeries);
+    }
+  catch (itk::ExceptionObject& e)
+    {
+    vtkErrorMacro(<< "GetVoxelTimeSeries: " << e.GetDescription());
+    return false;
+    }
+  values->SetNumberOfComponents(1);
+  values->SetNumberOfTuples(timeSeries.GetSize());
+  for (unsigned int n = 0; n < timeSeries.GetSize(); ++n)
+    {
+    values->SetValue(n, timeSeries[n]);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkITKTimeSeriesDatabase::GetRegionTimeSeries(int extent[6], vtkDoubleArray* values)
+{
+  if (!values)
+    {
+    return false;
+    }
+  SourceType::OutputImageType::RegionType region;
+  for (int n = 0; n < 3; ++n)
+    {
+    if (extent[2*n+1] < extent[2*n])
+      {
+      return false;
+      }
+    region.SetIndex(n, extent[2*n]);
+    region.SetSize(n, extent[2*n+1] - extent[2*n] + 1);
+    }
+  itk::Array<double> timeSeries;
+  try
+    {
+    this->m_Filter->GetRegionTimeSeries(region, timeSeries);
+    }
+  catch (itk::ExceptionObject& e)
+    {
+    vtkErrorMacro(<< "GetRegionTimeSeries: " << e.GetDescription());
+    return false;
+    }
+  values->SetNumberOfComponents(1);
+  values->SetNumberOfTuples(timeSeries.GetSize());
+  for (unsigned int n = 0; n < timeSeries.GetSize(); ++n)
+    {
+    values->SetValue(n, timeSeries[n]);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
 int vtkITKTimeSeriesDatabase::RequestInformation(
   vtkInformation * vtkNotUsed(request),
   vtkInformationVector ** vtkNotUsed(inputVector),
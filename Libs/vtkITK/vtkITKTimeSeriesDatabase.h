@@ -28,6 +28,8 @@
 #include "vtkITK.h"
 #include "vtkITKUtility.h"
 
+class vtkDoubleArray;
+
 /// \brief Effeciently process large datasets in small memory.
 ///
 /// TimeSeriesDatabase creates a database on disk from a series of volumes
@@ -54,8 +56,24 @@ public:
   };
 
   /// Connect/Disconnect to a database
-  /// void Connect ( const char* filename ) { this->m_Filter->Connect ( filename ); this->Modified(); };
-  /// void Disconnect() { this->m_Filter->Disconnect(); }
+  void Connect ( const char* filename ) { this->m_Filter->Connect ( filename ); this->Modified(); };
+  void Disconnect() { this->m_Filter->Disconnect(); this->Modified(); };
+
+  /// Number of images following the current image to read ahead in the
+  /// background when the output is updated.
+  /// \sa itk::TimeSeriesDatabase::SetPrefetchCount()
+  void SetPrefetchCount ( unsigned int value )
+  { DelegateITKInputMacro ( SetPrefetchCount, value ); };
+
+  /// Fill \a values with the value of the voxel (\a i, \a j, \a k) in each
+  /// image, without reading the whole images.
+  /// Return false if the voxel is outside of the images.
+  bool GetVoxelTimeSeries ( int i, int j, int k, vtkDoubleArray* values );
+
+  /// Fill \a values with the mean value of the voxels in \a extent in each
+  /// image, without reading the whole images.
+  /// Return false if the extent does not intersect the images.
+  bool GetRegionTimeSeries ( int extent[6], vtkDoubleArray* values );
 
   /// Get/Set the current time stamp to read
   void SetCurrentImage ( unsigned int value )
@@ -0,0 +1,229 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkDiffusionTensorGlyph.h>
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+#include <vtkVersion.h>
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Count the progress events, abort once the glyphs are being generated if
+// requested
+struct ProgressData
+{
+  int NumberOfEvents;
+  bool Abort;
+};
+
+//----------------------------------------------------------------------------
+void onProgress(vtkObject* caller, unsigned long, void* clientData, void* callData)
+{
+  ProgressData* data = static_cast<ProgressData*>(clientData);
+  ++data->NumberOfEvents;
+  if (data->Abort && *static_cast<double*>(callData) >= 0.5)
+    {
+    vtkDiffusionTensorGlyph::SafeDownCast(caller)->AbortExecuteOn();
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkDiffusionTensorGlyphTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  // Generate a 256x256 slice with the same anisotropic tensor at each voxel,
+  // the major eigenvector along X.
+  vtkNew<vtkImageData> tensorImage;
+  int dimensions[3] = {256, 256, 1};
+  tensorImage->SetDimensions(dimensions);
+  tensorImage->SetSpacing(2., 2., 2.);
+
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetName("tensors");
+  tensors->SetNumberOfTuples(dimensions[0]*dimensions[1]*dimensions[2]);
+  tensorImage->GetPointData()->SetTensors(tensors.GetPointer());
+
+  float* ptr = tensors->GetPointer(0);
+  for (vtkIdType i = 0; i < tensors->GetNumberOfTuples(); ++i)
+    {
+    ptr[1] = ptr[2] = ptr[3] = ptr[5] = ptr[6] = ptr[7] = 0.f;
+    ptr[0] = 4e-6f;
+    ptr[4] = ptr[8] = 1e-6f;
+    ptr += 9;
+    }
+
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(0.5);
+  sphere->SetThetaResolution(8);
+  sphere->SetPhiResolution(8);
+  sphere->Update();
+  const vtkIdType numberOfSourcePoints = sphere->GetOutput()->GetNumberOfPoints();
+
+  vtkNew<vtkDiffusionTensorGlyph> glyph;
+#if (VTK_MAJOR_VERSION <= 5)
+  glyph->SetInput(tensorImage.GetPointer());
+  glyph->SetSource(sphere->GetOutput());
+#else
+  glyph->SetInputData(tensorImage.GetPointer());
+  glyph->SetSourceConnection(sphere->GetOutputPort());
+#endif
+  glyph->SetDimensionResolution(1, 1);
+  glyph->ColorGlyphsByFractionalAnisotropy();
+
+  ProgressData progressData = {0, false};
+  vtkNew<vtkCallbackCommand> progressCallback;
+  progressCallback->SetCallback(onProgress);
+  progressCallback->SetClientData(&progressData);
+  glyph->AddObserver(vtkCommand::ProgressEvent, progressCallback.GetPointer());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  glyph->Update();
+  timer->StopTimer();
+  if (progressData.NumberOfEvents < 10)
+    {
+    std::cerr << "Line " << __LINE__ << ": only " << progressData.NumberOfEvents
+              << " progress events" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "<DartMeasurement name=\"GlyphTime\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // One sphere per voxel, scaled by the square roots of the eigenvalues
+  // times the scale factor: (2, 1, 1)
+  vtkPolyData* output = glyph->GetOutput();
+  const vtkIdType numberOfGlyphs = dimensions[0] * dimensions[1];
+  if (output->GetNumberOfPoints() != numberOfGlyphs * numberOfSourcePoints ||
+      output->GetNumberOfPolys() !=
+        numberOfGlyphs * sphere->GetOutput()->GetNumberOfPolys())
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of points "
+              << output->GetNumberOfPoints() << " or polygons "
+              << output->GetNumberOfPolys() << std::endl;
+    return EXIT_FAILURE;
+    }
+  double bounds[6];
+  output->GetBounds(bounds);
+  const double expectedBounds[6] = {-1., 2. * (dimensions[0] - 1) + 1.,
+                                    -0.5, 2. * (dimensions[1] - 1) + 0.5,
+                                    -0.5, 0.5};
+  for (int i = 0; i < 6; ++i)
+    {
+    if (std::fabs(bounds[i] - expectedBounds[i]) > 1e-4)
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong bound " << i << ": "
+                << bounds[i] << " instead of " << expectedBounds[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  vtkDataArray* scalars = output->GetPointData()->GetScalars();
+  if (!scalars ||
+      std::fabs(scalars->GetTuple1(0) - std::sqrt(0.5)) > 1e-4 ||
+      scalars->GetTuple1(scalars->GetNumberOfTuples() - 1) != scalars->GetTuple1(0))
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong fractional anisotropy "
+              << (scalars ? scalars->GetTuple1(0) : 0.) << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Changing the scale reuses the eigensystems
+  glyph->SetScaleFactor(500.);
+  timer->StartTimer();
+  glyph->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"GlyphScaleTime\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  output->GetBounds(bounds);
+  if (std::fabs(bounds[0] + 0.5) > 1e-4 || std::fabs(bounds[2] + 0.25) > 1e-4)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong bounds after scaling: "
+              << bounds[0] << ", " << bounds[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Modifying the tensors recomputes them
+  ptr = tensors->GetPointer(0);
+  for (vtkIdType i = 0; i < tensors->GetNumberOfTuples(); ++i)
+    {
+    ptr[0] = 1e-6f;
+    ptr[4] = 4e-6f;
+    ptr += 9;
+    }
+  tensors->Modified();
+  glyph->Update();
+  output->GetBounds(bounds);
+  if (std::fabs(bounds[0] + 0.25) > 1e-4 || std::fabs(bounds[2] + 0.5) > 1e-4)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong bounds after modifying the tensors: "
+              << bounds[0] << ", " << bounds[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Going back to the first tensors, as when going back to a slice, reuses
+  // their eigensystems
+  ptr = tensors->GetPointer(0);
+  for (vtkIdType i = 0; i < tensors->GetNumberOfTuples(); ++i)
+    {
+    ptr[0] = 4e-6f;
+    ptr[4] = 1e-6f;
+    ptr += 9;
+    }
+  tensors->Modified();
+  timer->StartTimer();
+  glyph->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"GlyphSliceChangeTime\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  output->GetBounds(bounds);
+  if (std::fabs(bounds[0] + 0.5) > 1e-4 || std::fabs(bounds[2] + 0.25) > 1e-4)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong bounds after going back to the first tensors: "
+              << bounds[0] << ", " << bounds[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Aborting while generating the glyphs outputs no glyph
+  progressData.Abort = true;
+  glyph->SetScaleFactor(1000.);
+  glyph->Update();
+  if (output->GetNumberOfPoints() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << output->GetNumberOfPoints()
+              << " points after aborting" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,194 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkNRRDReader.h>
+#include <vtkNRRDWriter.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+#include <vtkVersion.h>
+
+// ZLIB includes
+#include <zlib.h>
+
+// STD includes
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Smooth pattern with some noise, compresses like a medical image.
+void CreateImage(int size, vtkImageData* imageData)
+{
+  imageData->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  imageData->SetScalarTypeToShort();
+  imageData->SetNumberOfScalarComponents(1);
+  imageData->AllocateScalars();
+#else
+  imageData->AllocateScalars(VTK_SHORT, 1);
+#endif
+  short* ptr = static_cast<short*>(imageData->GetScalarPointer());
+  srand(0);
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        *ptr++ = static_cast<short>((i * j / 16 + k * 37) % 4096 + rand() % 16);
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Decompress the data of an attached header nrrd file with zlib only.
+bool InflateData(const std::string& fileName, std::vector<char>& data)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(file)),
+                      std::istreambuf_iterator<char>());
+  std::string::size_type dataStart = content.find("\n\n");
+  if (dataStart == std::string::npos)
+    {
+    return false;
+    }
+  dataStart += 2;
+
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  // gzip header
+  if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK)
+    {
+    return false;
+    }
+  stream.next_in = reinterpret_cast<Bytef*>(&content[dataStart]);
+  stream.avail_in = static_cast<uInt>(content.size() - dataStart);
+  stream.next_out = reinterpret_cast<Bytef*>(&data[0]);
+  stream.avail_out = static_cast<uInt>(data.size());
+  int res = inflate(&stream, Z_FINISH);
+  bool success = (res == Z_STREAM_END && stream.avail_out == 0 && stream.avail_in == 0);
+  inflateEnd(&stream);
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool TestWrite(vtkImageData* imageData, const std::string& fileName,
+               int numberOfThreads, int compressionLevel)
+{
+  vtkNew<vtkNRRDWriter> writer;
+#if (VTK_MAJOR_VERSION <= 5)
+  writer->SetInput(imageData);
+#else
+  writer->SetInputData(imageData);
+#endif
+  writer->SetFileName(fileName.c_str());
+  writer->SetNumberOfThreads(numberOfThreads);
+  writer->SetCompressionLevel(compressionLevel);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  writer->Write();
+  timer->StopTimer();
+  if (writer->GetWriteError())
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to write " << fileName << std::endl;
+    return false;
+    }
+  size_t dataSize = static_cast<size_t>(imageData->GetNumberOfPoints()) * sizeof(short);
+  std::cout << "<DartMeasurement name=\"WriteMBPerSecond" << numberOfThreads
+            << "ThreadsLevel" << compressionLevel << "\" type=\"numeric/double\">"
+            << dataSize / (1024. * 1024.) / timer->GetElapsedTime()
+            << "</DartMeasurement>" << std::endl;
+
+  // Read back with Teem
+  vtkNew<vtkNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  vtkImageData* readImageData = reader->GetOutput();
+  if (readImageData->GetNumberOfPoints() != imageData->GetNumberOfPoints() ||
+      readImageData->GetScalarType() != VTK_SHORT ||
+      memcmp(readImageData->GetScalarPointer(), imageData->GetScalarPointer(), dataSize) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong data read from " << fileName
+              << " written with " << numberOfThreads << " threads" << std::endl;
+    return false;
+    }
+
+  // Read back with zlib
+  std::vector<char> data(dataSize);
+  if (!InflateData(fileName, data) ||
+      memcmp(&data[0], imageData->GetScalarPointer(), dataSize) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << fileName << " written with "
+              << numberOfThreads << " threads is not a valid gzip stream" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkNRRDWriterTest1(int argc, char* argv[])
+{
+  if (argc != 2)
+    {
+    std::cerr << "Missing parameters !\n"
+              << "Usage: " << argv[0] << " /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string fileName = std::string(argv[1]) + "/vtkNRRDWriterTest1.nrrd";
+
+  // Smaller than a block
+  vtkNew<vtkImageData> smallImageData;
+  CreateImage(16, smallImageData.GetPointer());
+  if (!TestWrite(smallImageData.GetPointer(), fileName, 4, -1))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // 32MB
+  vtkNew<vtkImageData> imageData;
+  CreateImage(256, imageData.GetPointer());
+  int numberOfThreads[2] = {1, 8};
+  int compressionLevels[2] = {1, -1};
+  for (int i = 0; i < 2; ++i)
+    {
+    for (int j = 0; j < 2; ++j)
+      {
+      if (!TestWrite(imageData.GetPointer(), fileName,
+                     numberOfThreads[i], compressionLevels[j]))
+        {
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,227 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkHyperStreamlineDTMRI.h>
+#include <vtkSeedTracts.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+#include <vtkTrivialProducer.h>
+#include <vtkVersion.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Linear tensors whose principal direction rotates in the XY plane
+// along Z, so that the fibers are curved.
+void CreateTensorField(int size, vtkImageData* tensorImage)
+{
+  tensorImage->SetDimensions(size, size, size);
+  vtkNew<vtkFloatArray> tensors;
+  tensors->SetNumberOfComponents(9);
+  tensors->SetNumberOfTuples(size * size * size);
+  tensorImage->GetPointData()->SetTensors(tensors.GetPointer());
+  float* ptr = tensors->GetPointer(0);
+  for (int z = 0; z < size; ++z)
+    {
+    double angle = 0.4 * sin(z * 0.3);
+    double e1[3] = {cos(angle), sin(angle), 0.};
+    for (int i = 0; i < size * size; ++i)
+      {
+      for (int row = 0; row < 3; ++row)
+        {
+        for (int col = 0; col < 3; ++col)
+          {
+          *ptr++ = static_cast<float>(0.9 * e1[row] * e1[col] + (row == col ? 0.1 : 0.));
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void CreateROI(int size, int begin, int end, vtkImageData* roiImage)
+{
+  roiImage->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  roiImage->SetScalarTypeToShort();
+  roiImage->SetNumberOfScalarComponents(1);
+  roiImage->AllocateScalars();
+#else
+  roiImage->AllocateScalars(VTK_SHORT, 1);
+#endif
+  short* ptr = static_cast<short*>(roiImage->GetScalarPointer());
+  for (int z = 0; z < size; ++z)
+    {
+    for (int y = 0; y < size; ++y)
+      {
+      for (int x = 0; x < size; ++x)
+        {
+        *ptr++ = (x >= begin && x < end && y >= begin && y < end &&
+                  z >= begin && z < end) ? 1 : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool CompareFibers(vtkPolyData* fibers, vtkPolyData* expected,
+                   double tolerance, int line)
+{
+  if (fibers->GetNumberOfLines() != expected->GetNumberOfLines() ||
+      fibers->GetNumberOfPoints() != expected->GetNumberOfPoints() ||
+      fibers->GetPointData()->GetTensors() == 0)
+    {
+    std::cerr << "Line " << line << ": " << fibers->GetNumberOfLines()
+              << " fibers and " << fibers->GetNumberOfPoints()
+              << " points instead of " << expected->GetNumberOfLines()
+              << " fibers and " << expected->GetNumberOfPoints()
+              << " points" << std::endl;
+    return false;
+    }
+  vtkIdTypeArray* cells = fibers->GetLines()->GetData();
+  vtkIdTypeArray* expectedCells = expected->GetLines()->GetData();
+  for (vtkIdType i = 0; i < cells->GetNumberOfTuples(); ++i)
+    {
+    if (cells->GetValue(i) != expectedCells->GetValue(i))
+      {
+      std::cerr << "Line " << line << ": different lines" << std::endl;
+      return false;
+      }
+    }
+  vtkDataArray* tensors = fibers->GetPointData()->GetTensors();
+  vtkDataArray* expectedTensors = expected->GetPointData()->GetTensors();
+  for (vtkIdType i = 0; i < fibers->GetNumberOfPoints(); ++i)
+    {
+    double point[3], expectedPoint[3];
+    double tensor[9], expectedTensor[9];
+    fibers->GetPoint(i, point);
+    expected->GetPoint(i, expectedPoint);
+    tensors->GetTuple(i, tensor);
+    expectedTensors->GetTuple(i, expectedTensor);
+    double difference = 0.;
+    for (int c = 0; c < 3; ++c)
+      {
+      difference = std::max(difference, fabs(point[c] - expectedPoint[c]));
+      }
+    for (int c = 0; c < 9; ++c)
+      {
+      difference = std::max(difference, fabs(tensor[c] - expectedTensor[c]));
+      }
+    if (difference > tolerance)
+      {
+      std::cerr << "Line " << line << ": point " << i << " differs by "
+                << difference << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSeedTractsTest1(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
+{
+  const int size = 32;
+  vtkNew<vtkImageData> tensorImage;
+  CreateTensorField(size, tensorImage.GetPointer());
+  vtkNew<vtkImageData> roiImage;
+  CreateROI(size, 12, 20, roiImage.GetPointer());
+
+  vtkNew<vtkSeedTracts> seed;
+#if (VTK_MAJOR_VERSION <= 5)
+  seed->SetInputTensorField(tensorImage.GetPointer());
+  seed->SetInputROI(roiImage.GetPointer());
+#else
+  vtkNew<vtkTrivialProducer> tensorProducer;
+  tensorProducer->SetOutput(tensorImage.GetPointer());
+  seed->SetInputTensorFieldConnection(tensorProducer->GetOutputPort());
+  vtkNew<vtkTrivialProducer> roiProducer;
+  roiProducer->SetOutput(roiImage.GetPointer());
+  seed->SetInputROIConnection(roiProducer->GetOutputPort());
+#endif
+  seed->SetInputROIValue(1);
+  seed->SetMinimumPathLength(2.);
+  seed->UseVtkHyperStreamlinePoints();
+  vtkNew<vtkHyperStreamlineDTMRI> streamer;
+  streamer->SetIntegrationStepLength(0.5);
+  // Fibers stay inside the tensor field
+  streamer->SetMaximumPropagationDistance(6.2);
+  streamer->SetStoppingModeToLinearMeasure();
+  streamer->SetStoppingThreshold(0.1);
+  seed->SetVtkHyperStreamlinePointsSettings(streamer.GetPointer());
+
+  // One vtkHyperStreamlineDTMRI per seed
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  seed->SeedStreamlinesInROI();
+  vtkNew<vtkPolyData> expectedFibers;
+  seed->TransformStreamlinesToRASAndAppendToPolyData(expectedFibers.GetPointer());
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"SeedStreamlinesInROI\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  if (expectedFibers->GetNumberOfLines() == 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": no fiber" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Batched tracking
+  vtkNew<vtkPolyData> singleThreadFibers;
+  int numberOfThreads[3] = {1, 3, 8};
+  for (int i = 0; i < 3; ++i)
+    {
+    vtkNew<vtkPolyData> fibers;
+    seed->SetNumberOfThreads(numberOfThreads[i]);
+    timer->StartTimer();
+    seed->SeedStreamlinesInROIToPolyData(fibers.GetPointer());
+    timer->StopTimer();
+    std::cout << "<DartMeasurement name=\"SeedStreamlinesInROIToPolyData"
+              << numberOfThreads[i] << "Threads\" type=\"numeric/double\">"
+              << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+    if (!CompareFibers(fibers.GetPointer(), expectedFibers.GetPointer(), 1e-2, __LINE__))
+      {
+      return EXIT_FAILURE;
+      }
+    // The output doesn't depend on the number of threads
+    if (i == 0)
+      {
+      singleThreadFibers->DeepCopy(fibers.GetPointer());
+      }
+    else if (!CompareFibers(fibers.GetPointer(), singleThreadFibers.GetPointer(), 0., __LINE__))
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
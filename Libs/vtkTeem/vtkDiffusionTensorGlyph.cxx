@@ -15,19 +15,25 @@
 
 #include "vtkCellArray.h"
 #include "vtkFloatArray.h"
+#include "vtkIdTypeArray.h"
 #include "vtkMath.h"
+#include "vtkMatrix4x4.h"
 #include "vtkInformation.h"
 #include "vtkInformationVector.h"
+#include "vtkMultiThreader.h"
 #include <vtkNew.h>
 #include "vtkObjectFactory.h"
 #include "vtkPointData.h"
+#include <vtkSmartPointer.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
-#include "vtkTransform.h"
 
 #include "vtkImageData.h"
 #include "vtkDiffusionTensorMathematics.h"
 
+#include <algorithm>
 #include <ctime>
+#include <list>
+#include <vector>
 
 vtkCxxSetObjectMacro(vtkDiffusionTensorGlyph,Mask,vtkImageData);
 vtkCxxSetObjectMacro(vtkDiffusionTensorGlyph,VolumePositionMatrix,vtkMatrix4x4);
@@ -35,6 +41,95 @@ vtkCxxSetObjectMacro(vtkDiffusionTensorGlyph,TensorRotationMatrix,vtkMatrix4x4);
 
 vtkStandardNewMacro(vtkDiffusionTensorGlyph);
 
+//----------------------------------------------------------------------------
+class vtkDiffusionTensorGlyph::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Eigensystems of the tensors glyphed in one slice. Per glyphed tensor:
+  /// tensor, eigenvalues (unsorted if ExtractEigenvalues is off) and
+  /// eigenvectors as the columns of a row-major 3x3 matrix.
+  struct SliceEigenSystems
+  {
+    int Selection[6];
+    std::vector<double> TensorValues;
+    std::vector<double> Eigenvalues;
+    std::vector<double> Eigenvectors;
+  };
+
+  /// Return true if the input and the glyph selection did not change since
+  /// the glyphed tensors were last selected.
+  bool IsInputUnchanged(vtkDataSet* input, vtkDataArray* tensors, vtkImageData* mask,
+                        const int selection[6]);
+
+  /// Move the eigensystems of the slice with these glyphed tensors to the
+  /// front of the cache. Return false if the slice is not cached.
+  bool FindSlice(const int selection[6], const std::vector<double>& tensorValues);
+
+  vtkDataSet* Input;
+  vtkDataArray* Tensors;
+  vtkImageData* Mask;
+  int Selection[6];
+  vtkTimeStamp CacheTime;
+
+  /// Per glyphed tensor of the current input: input point and input scalar
+  std::vector<double> Points;
+  std::vector<double> Scalars;
+
+  /// The glyph input is a reslice of the tensor volume, it changes with the
+  /// slice. The eigensystems of the last slices are kept, most recently used
+  /// first, so that going back to a slice does not compute them again. The
+  /// front one is the current input.
+  std::list<SliceEigenSystems> Slices;
+  static const size_t MaximumNumberOfSlices = 8;
+};
+
+//----------------------------------------------------------------------------
+vtkDiffusionTensorGlyph::vtkInternal::vtkInternal()
+{
+  this->Input = 0;
+  this->Tensors = 0;
+  this->Mask = 0;
+  for (int i = 0; i < 6; ++i)
+    {
+    this->Selection[i] = -1;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkDiffusionTensorGlyph::vtkInternal
+::IsInputUnchanged(vtkDataSet* input, vtkDataArray* tensors, vtkImageData* mask,
+                   const int selection[6])
+{
+  if (this->Slices.empty() ||
+      input != this->Input || tensors != this->Tensors || mask != this->Mask ||
+      input->GetMTime() > this->CacheTime.GetMTime() ||
+      tensors->GetMTime() > this->CacheTime.GetMTime() ||
+      (mask && mask->GetMTime() > this->CacheTime.GetMTime()))
+    {
+    return false;
+    }
+  return std::equal(selection, selection + 6, this->Selection);
+}
+
+//----------------------------------------------------------------------------
+bool vtkDiffusionTensorGlyph::vtkInternal
+::FindSlice(const int selection[6], const std::vector<double>& tensorValues)
+{
+  for (std::list<SliceEigenSystems>::iterator it = this->Slices.begin();
+       it != this->Slices.end(); ++it)
+    {
+    if (std::equal(selection, selection + 6, it->Selection) &&
+        it->TensorValues == tensorValues)
+      {
+      this->Slices.splice(this->Slices.begin(), this->Slices, it);
+      return true;
+      }
+    }
+  return false;
+}
+
 // Construct object with default values for diffusion tensor data.
 vtkDiffusionTensorGlyph::vtkDiffusionTensorGlyph()
 {
@@ -61,6 +156,8 @@ vtkDiffusionTensorGlyph::vtkDiffusionTensorGlyph()
   this->ScaleFactor = 1000;
 
   // TO DO: Use correct scaling by sqrt of eigenvalues for DTI!
+
+  this->Internal = new vtkInternal;
 }
 
 vtkDiffusionTensorGlyph::~vtkDiffusionTensorGlyph()
@@ -80,6 +177,8 @@ vtkDiffusionTensorGlyph::~vtkDiffusionTensorGlyph()
     {
     this->Mask->Delete( );
     }
+
+  delete this->Internal;
 }
 
 void vtkDiffusionTensorGlyph::ColorGlyphsByLinearMeasure() {
@@ -138,8 +237,465 @@ void vtkDiffusionTensorGlyph::ColorGlyphsBy(int invariant) {
     }
 }
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// c = a * b, row-major 4x4 matrices
+void Multiply4x4(const double a[16], const double b[16], double c[16])
+{
+  double tmp[16];
+  for (int i = 0; i < 4; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      tmp[4 * i + j] = a[4 * i] * b[j] + a[4 * i + 1] * b[4 + j] +
+        a[4 * i + 2] * b[8 + j] + a[4 * i + 3] * b[12 + j];
+      }
+    }
+  std::copy(tmp, tmp + 16, c);
+}
+
+//----------------------------------------------------------------------------
+// matrix = matrix * scale
+void Scale4x4(double matrix[16], double x, double y, double z)
+{
+  for (int i = 0; i < 4; ++i)
+    {
+    matrix[4 * i] *= x;
+    matrix[4 * i + 1] *= y;
+    matrix[4 * i + 2] *= z;
+    }
+}
+
+//----------------------------------------------------------------------------
+struct GlyphThreadStruct
+{
+  enum StageType
+  {
+    EigenSystems,
+    Glyphs
+  };
+  int Stage;
+  /// Range of glyphs processed by the threads
+  vtkIdType FirstGlyph;
+  vtkIdType NumberOfGlyphs;
+
+  // eigen systems stage
+  int ExtractEigenvalues;
+  const double* Tensors;
+  double* Eigenvalues;
+  double* Eigenvectors;
+
+  // glyphs stage
+  const double* Points;
+  const double* Scalars;
+  const double* VolumePosition;
+  const double* TensorRotation;
+  int FlipNormals;
+  int NumberOfDirections;
+  int ThreeGlyphs;
+  int ColorMode;
+  int ScalarInvariant;
+  int ClampScaling;
+  double ScaleFactor;
+  double MaxScaleFactor;
+  double Length;
+
+  vtkIdType NumberOfSourcePoints;
+  const double* SourcePoints;
+  const double* SourceNormals;
+  const vtkIdType* SourceCells[4];
+  vtkIdType SourceCellsSize[4];
+
+  float* OutPoints;
+  float* OutNormals;
+  float* OutScalars;
+  vtkIdType* OutCells[4];
+};
+
+//----------------------------------------------------------------------------
+void ComputeEigenSystem(const GlyphThreadStruct* str, vtkIdType glyph)
+{
+  const double* tensor = str->Tensors + 9 * glyph;
+  double* w = str->Eigenvalues + 3 * glyph;
+  double* vectors = str->Eigenvectors + 9 * glyph;
+  if (str->ExtractEigenvalues)
+    {
+    double m0[3], m1[3], m2[3];
+    double v0[3], v1[3], v2[3];
+    double *m[3] = {m0, m1, m2};
+    double *v[3] = {v0, v1, v2};
+    for (int j = 0; j < 3; j++)
+      {
+      for (int i = 0; i < 3; i++)
+        {
+        m[i][j] = tensor[3 * j + i];
+        }
+      }
+    // Use superior eigensolve from teem.
+    vtkDiffusionTensorMathematics::TeemEigenSolver(m, w, v);
+    for (int i = 0; i < 3; i++)
+      {
+      for (int j = 0; j < 3; j++)
+        {
+        vectors[3 * i + j] = v[i][j];
+        }
+      }
+    }
+  else // use tensor columns as eigenvectors
+    {
+    double xv[3], yv[3], zv[3];
+    for (int i = 0; i < 3; i++)
+      {
+      xv[i] = tensor[i];
+      yv[i] = tensor[3 + i];
+      zv[i] = tensor[6 + i];
+      }
+    w[0] = vtkMath::Normalize(xv);
+    w[1] = vtkMath::Normalize(yv);
+    w[2] = vtkMath::Normalize(zv);
+    for (int i = 0; i < 3; i++)
+      {
+      vectors[3 * i] = xv[i];
+      vectors[3 * i + 1] = yv[i];
+      vectors[3 * i + 2] = zv[i];
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+double ComputeScalar(const GlyphThreadStruct* str, vtkIdType glyph, double w[3])
+{
+  const double* vectors = str->Eigenvectors + 9 * glyph;
+  if (str->Scalars && str->ColorMode == vtkTensorGlyph::COLOR_BY_SCALARS)
+    {
+    return str->Scalars[glyph];
+    }
+  if (str->ColorMode != vtkTensorGlyph::COLOR_BY_EIGENVALUES)
+    {
+    return 0.;
+    }
+  // Correct for negative eigenvalues: use logic coded in vtkDiffusionTensorMathematics
+  vtkDiffusionTensorMathematics::FixNegativeEigenvaluesMethod(w);
+
+  double s = 0.;
+  switch (str->ScalarInvariant)
+    {
+    case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
+      s = vtkDiffusionTensorMathematics::LinearMeasure(w);
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
+      s = vtkDiffusionTensorMathematics::PlanarMeasure(w);
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
+      s = vtkDiffusionTensorMathematics::SphericalMeasure(w);
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE:
+      s = w[0];
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_MID_EIGENVALUE:
+      s = w[1];
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE:
+      s = w[2];
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_PARALLEL_DIFFUSIVITY:
+      s = w[0];
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
+      s = 0.5*(w[1]+w[2]);
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_COLOR_ORIENTATION:
+      {
+      double v_maj[4] = {vectors[0], vectors[3], vectors[6], 1.};
+      if (str->TensorRotation)
+        {
+        vtkMatrix4x4::MultiplyPoint(str->TensorRotation, v_maj, v_maj);
+        }
+      // TO DO: here output as RGB. Need to allocate 3-component scalars first.
+      vtkDiffusionTensorMathematics::RGBToIndex(fabs(v_maj[0]),fabs(v_maj[1]),fabs(v_maj[2]),s);
+      break;
+      }
+    case vtkDiffusionTensorMathematics::VTK_TENS_RELATIVE_ANISOTROPY:
+      s = vtkDiffusionTensorMathematics::RelativeAnisotropy(w);
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
+      s = vtkDiffusionTensorMathematics::FractionalAnisotropy(w);
+      break;
+    case vtkDiffusionTensorMathematics::VTK_TENS_TRACE:
+      s = vtkDiffusionTensorMathematics::Trace(w);
+      break;
+    default:
+      break;
+    }
+  return s;
+}
+
+//----------------------------------------------------------------------------
+// Write the points, normals, scalars and cells of the glyphs of one tensor.
+void GenerateGlyphs(const GlyphThreadStruct* str, vtkIdType glyph)
+{
+  const vtkIdType numSourcePts = str->NumberOfSourcePoints;
+  const int numDirs = str->NumberOfDirections;
+  const vtkIdType ptOffset = glyph * numDirs * numSourcePts;
+  const double* vectors = str->Eigenvectors + 9 * glyph;
+
+  double w[3];
+  std::copy(str->Eigenvalues + 3 * glyph, str->Eigenvalues + 3 * glyph + 3, w);
+
+  // Calculate output scalars before computing glyph scale factors from eigenvalues.
+  const double s = ComputeScalar(str, glyph, w);
+
+  // Use the square root of the eigenvalues for scaling for DTI
+  // and compute scale factors
+  for (int i = 0; i < 3; i++)
+    {
+    w[i] = sqrt(w[i]) * str->ScaleFactor;
+    }
+  double maxScale;
+  if (str->ClampScaling)
+    {
+    maxScale = 0.0;
+    for (int i = 0; i < 3; i++)
+      {
+      maxScale = std::max(maxScale, fabs(w[i]));
+      }
+    if (maxScale > str->MaxScaleFactor)
+      {
+      maxScale = str->MaxScaleFactor / maxScale;
+      for (int i = 0; i < 3; i++)
+        {
+        w[i] *= maxScale; //preserve overall shape of glyph
+        }
+      }
+    }
+  // make sure scale is okay (non-zero)
+  maxScale = 0.0;
+  for (int i = 0; i < 3; i++)
+    {
+    if (w[i] > maxScale)
+      {
+      maxScale = w[i];
+      }
+    }
+  if (maxScale == 0.0)
+    {
+    maxScale = 1.0;
+    }
+  for (int i = 0; i < 3; i++)
+    {
+    if (w[i] == 0.0)
+      {
+      w[i] = maxScale * 1.0e-06;
+      }
+    }
+
+  // translate Source to Input point, optionally moved by the user matrix
+  double x[4] = {str->Points[3 * glyph], str->Points[3 * glyph + 1],
+                 str->Points[3 * glyph + 2], 1.};
+  if (str->VolumePosition)
+    {
+    vtkMatrix4x4::MultiplyPoint(str->VolumePosition, x, x);
+    }
+  double base[16] = {1., 0., 0., x[0],
+                     0., 1., 0., x[1],
+                     0., 0., 1., x[2],
+                     0., 0., 0., 1.};
+  if (str->TensorRotation)
+    {
+    Multiply4x4(base, str->TensorRotation, base);
+    }
+  // normalized eigenvectors rotate object for eigen direction 0
+  const double eigenvectors[16] = {vectors[0], vectors[1], vectors[2], 0.,
+                                   vectors[3], vectors[4], vectors[5], 0.,
+                                   vectors[6], vectors[7], vectors[8], 0.,
+                                   0., 0., 0., 1.};
+  Multiply4x4(base, eigenvectors, base);
+
+  for (int dir = 0; dir < numDirs; dir++)
+    {
+    const int eigen_dir = dir % (str->ThreeGlyphs ? 3 : 1);
+    const int symmetric_dir = dir / (str->ThreeGlyphs ? 3 : 1);
+    const vtkIdType dirOffset = ptOffset + dir * numSourcePts;
+
+    if (str->OutScalars)
+      {
+      std::fill(str->OutScalars + dirOffset,
+                str->OutScalars + dirOffset + numSourcePts, static_cast<float>(s));
+      }
+
+    double matrix[16];
+    std::copy(base, base + 16, matrix);
+    if (eigen_dir == 1)
+      {
+      // RotateZ(90)
+      const double rotation[16] = {0., -1., 0., 0.,
+                                   1., 0., 0., 0.,
+                                   0., 0., 1., 0.,
+                                   0., 0., 0., 1.};
+      Multiply4x4(matrix, rotation, matrix);
+      }
+    if (eigen_dir == 2)
+      {
+      // RotateY(-90)
+      const double rotation[16] = {0., 0., -1., 0.,
+                                   0., 1., 0., 0.,
+                                   1., 0., 0., 0.,
+                                   0., 0., 0., 1.};
+      Multiply4x4(matrix, rotation, matrix);
+      }
+    if (str->ThreeGlyphs)
+      {
+      Scale4x4(matrix, w[eigen_dir], str->ScaleFactor, str->ScaleFactor);
+      }
+    else
+      {
+      Scale4x4(matrix, w[0], w[1], w[2]);
+      }
+    // Mirror second set to the symmetric position
+    if (symmetric_dir == 1)
+      {
+      Scale4x4(matrix, -1., 1., 1.);
+      }
+    // if the eigenvalue is negative, shift to reverse direction.
+    if (w[eigen_dir] < 0 && numDirs > 1)
+      {
+      for (int i = 0; i < 3; i++)
+        {
+        matrix[4 * i + 3] -= matrix[4 * i] * str->Length;
+        }
+      }
+
+    // transform the source points
+    float* outPoint = str->OutPoints + 3 * dirOffset;
+    for (vtkIdType p = 0; p < numSourcePts; ++p)
+      {
+      const double* point = str->SourcePoints + 3 * p;
+      for (int i = 0; i < 3; i++)
+        {
+        *outPoint++ = static_cast<float>(
+          matrix[4 * i] * point[0] + matrix[4 * i + 1] * point[1] +
+          matrix[4 * i + 2] * point[2] + matrix[4 * i + 3]);
+        }
+      }
+
+    // and the normals with the inverse transpose matrix
+    if (str->OutNormals)
+      {
+      double linear[3][3];
+      double inverse[3][3];
+      for (int i = 0; i < 3; i++)
+        {
+        for (int j = 0; j < 3; j++)
+          {
+          linear[i][j] = matrix[4 * i + j];
+          }
+        }
+      vtkMath::Invert3x3(linear, inverse);
+      const double sign = str->FlipNormals ? -1. : 1.;
+      float* outNormal = str->OutNormals + 3 * dirOffset;
+      for (vtkIdType p = 0; p < numSourcePts; ++p)
+        {
+        const double* normal = str->SourceNormals + 3 * p;
+        double n[3];
+        for (int i = 0; i < 3; i++)
+          {
+          n[i] = sign * (inverse[0][i] * normal[0] + inverse[1][i] * normal[1] +
+                         inverse[2][i] * normal[2]);
+          }
+        vtkMath::Normalize(n);
+        *outNormal++ = static_cast<float>(n[0]);
+        *outNormal++ = static_cast<float>(n[1]);
+        *outNormal++ = static_cast<float>(n[2]);
+        }
+      }
+    }
+
+  // copy topology of output glyph for this point
+  for (int c = 0; c < 4; ++c)
+    {
+    if (!str->OutCells[c])
+      {
+      continue;
+      }
+    const vtkIdType* sourceCells = str->SourceCells[c];
+    const vtkIdType size = str->SourceCellsSize[c];
+    vtkIdType* outCell = str->OutCells[c] + glyph * numDirs * size;
+    for (vtkIdType location = 0; location < size;
+         location += sourceCells[location] + 1)
+      {
+      const vtkIdType npts = sourceCells[location];
+      for (int dir = 0; dir < numDirs; dir++)
+        {
+        const vtkIdType subIncr = ptOffset + dir * numSourcePts;
+        *outCell++ = npts;
+        for (vtkIdType i = 1; i <= npts; i++)
+          {
+          *outCell++ = sourceCells[location + i] + subIncr;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkDiffusionTensorGlyphThreadedExecute(void *arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  const GlyphThreadStruct* str = static_cast<GlyphThreadStruct*>(info->UserData);
+  const vtkIdType begin = str->FirstGlyph +
+    str->NumberOfGlyphs * info->ThreadID / info->NumberOfThreads;
+  const vtkIdType end = str->FirstGlyph +
+    str->NumberOfGlyphs * (info->ThreadID + 1) / info->NumberOfThreads;
+  for (vtkIdType glyph = begin; glyph < end; ++glyph)
+    {
+    if (str->Stage == GlyphThreadStruct::EigenSystems)
+      {
+      ComputeEigenSystem(str, glyph);
+      }
+    else
+      {
+      GenerateGlyphs(str, glyph);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Run a stage on numberOfGlyphs glyphs in parallel. The glyphs are split in
+// chunks so that the progress is reported and the abort flag checked from
+// this thread between chunks. Return the number of glyphs processed.
+vtkIdType ExecuteStage(vtkDiffusionTensorGlyph* self, vtkMultiThreader* threader,
+                       GlyphThreadStruct* str, vtkIdType numberOfGlyphs,
+                       double progressStart, double progressEnd)
+{
+  const int numberOfChunks = 10;
+  vtkIdType processed = 0;
+  threader->SetSingleMethod(vtkDiffusionTensorGlyphThreadedExecute, str);
+  for (int chunk = 0; chunk < numberOfChunks && processed < numberOfGlyphs; ++chunk)
+    {
+    if (self->GetAbortExecute())
+      {
+      break;
+      }
+    const vtkIdType end = numberOfGlyphs * (chunk + 1) / numberOfChunks;
+    str->FirstGlyph = processed;
+    str->NumberOfGlyphs = end - processed;
+    threader->SingleMethodExecute();
+    processed = end;
+    self->UpdateProgress(progressStart + (progressEnd - progressStart) *
+                         processed / numberOfGlyphs);
+    }
+  return processed;
+}
+
+} // end of anonymous namespace
+
 // TO DO: make input mask a point data object or scalars
 
+//----------------------------------------------------------------------------
 int vtkDiffusionTensorGlyph::RequestData(
                                          vtkInformation *vtkNotUsed(request),
                                          vtkInformationVector **inputVector,
@@ -158,83 +714,28 @@ int vtkDiffusionTensorGlyph::RequestData(
   vtkPolyData *output = vtkPolyData::SafeDownCast(
                                                   outInfo->Get(vtkDataObject::DATA_OBJECT()));
 
-  vtkDataArray *inTensors;
-  vtkDataArray *inScalars;
-  vtkIdType numPts, numSourcePts, numSourceCells, inPtId, i;
-  int j;
-  vtkPoints *sourcePts;
-  vtkDataArray *sourceNormals;
-  vtkCellArray *sourceCells, *cells;
-  vtkPoints *newPts;
-  vtkFloatArray *newScalars=NULL;
-  vtkFloatArray *newNormals=NULL;
-  double x[3], x2[3], s;
-  vtkTransform *trans;
-  vtkCell *cell;
-  vtkIdList *cellPts;
-  int npts;
-  vtkIdType *pts;
-  vtkIdType cellId;
-  vtkIdType subIncr;
-  int numDirs, dir, eigen_dir, symmetric_dir;
-  vtkMatrix4x4 *matrix;
-  double *m[3], w[3], *v[3];
-  double m0[3], m1[3], m2[3];
-  double v0[3], v1[3], v2[3];
-  double xv[3], yv[3], zv[3];
-  double maxScale;
-  vtkPointData *pd, *outPD;
-
-  // Keeps track of the number of points added to the output polydata so far.
-  // this replaces variable ptIncr in superclass vtkTensorGlyph.
-  vtkIdType ptOffset = 0;
-
-  // coordinate systems for DTI
-  vtkTransform *userVolumeTransform = NULL;
-  // masking of glyphs
-  vtkDataArray *inMask;
   // glyph timing
 #ifndef NDEBUG
   clock_t tStart = clock();
 #endif
 
-  // use simpler 3x3 array, not 9D as in vtkTensorGlyph class
-  double tensor[3][3];
-
-  // the number of eigenvectors to glyph * if there are two glyphs per vector
-  numDirs = (this->ThreeGlyphs?3:1)*(this->Symmetric+1);
-
-  pts = new vtkIdType[source->GetMaxCellSize()];
-  trans = vtkTransform::New();
-  matrix = vtkMatrix4x4::New();
-
-  // set up working matrices
-  m[0] = m0; m[1] = m1; m[2] = m2;
-  v[0] = v0; v[1] = v1; v[2] = v2;
-
   vtkDebugMacro(<<"Generating tensor glyphs");
 
-  pd = input->GetPointData();
-  outPD = output->GetPointData();
-  inTensors = pd->GetTensors();
-  inScalars = pd->GetScalars();
-  numPts = input->GetNumberOfPoints();
+  vtkPointData *pd = input->GetPointData();
+  vtkPointData *outPD = output->GetPointData();
+  vtkDataArray *inTensors = pd->GetTensors();
+  vtkDataArray *inScalars = pd->GetScalars();
+  const vtkIdType numPts = input->GetNumberOfPoints();
   if ( !inTensors || numPts < 1 )
     {
     vtkErrorMacro(<<"No data to glyph!");
-    trans->Delete();
-    matrix->Delete();
     return 1;
     }
 
   // Compute steps along dimensions
-  // and real number of input points
-  int numInputPts = numPts;
   int skipRows = 0;
   int skipCols = this->Resolution;
   int rowLength = numPts;
-  int row = 0;
-  int col = 0;
   // TODO: use UpdateExtent not WholeExtent
   int inWholeExtent[6];
 #if (VTK_MAJOR_VERSION <= 5)
@@ -251,91 +752,10 @@ int vtkDiffusionTensorGlyph::RequestData(
     skipRows = DimensionResolution[1];
     skipCols = DimensionResolution[0];
     rowLength = dimensions[0];
-    if (skipCols)
-      {
-      numInputPts = (numInputPts+1)/skipCols;
-      }
-    if (skipRows)
-      {
-      numInputPts = (numInputPts+1)/skipRows;
-      }
-    }
-
-  //
-  // Allocate storage for output PolyData
-  //
-  sourcePts = source->GetPoints();
-  numSourcePts = sourcePts->GetNumberOfPoints();
-  numSourceCells = source->GetNumberOfCells();
-
-  newPts = vtkPoints::New();
-  // Allocate as if we will glyph every point
-  // If some are masked/skipped for Resolution this will be fixed later with Squeeze
-  // TO DO allocate less for lower resolution
-  newPts->Allocate(numDirs*numInputPts*numSourcePts);
-
-  // Setting up for calls to PolyData::InsertNextCell()
-  if ( (sourceCells=source->GetVerts())->GetNumberOfCells() > 0 )
-    {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetVerts(cells);
-    cells->Delete();
-    }
-  if ( (sourceCells=this->GetSource()->GetLines())->GetNumberOfCells() > 0 )
-    {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetLines(cells);
-    cells->Delete();
-    }
-  if ( (sourceCells=this->GetSource()->GetPolys())->GetNumberOfCells() > 0 )
-    {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetPolys(cells);
-    cells->Delete();
-    }
-  if ( (sourceCells=this->GetSource()->GetStrips())->GetNumberOfCells() > 0 )
-    {
-    cells = vtkCellArray::New();
-    cells->Allocate(numDirs*numInputPts*sourceCells->GetSize());
-    output->SetStrips(cells);
-    cells->Delete();
-    }
-
-  // Get point data, decide how to allocate scalars
-  pd = this->GetSource()->GetPointData();
-
-  // generate scalars if eigenvalues are chosen or if scalars exist.
-  if (this->ColorGlyphs &&
-      ((this->ColorMode == COLOR_BY_EIGENVALUES) ||
-       (inScalars && (this->ColorMode == COLOR_BY_SCALARS)) ) )
-    {
-    newScalars = vtkFloatArray::New();
-    newScalars->Allocate(numDirs*numInputPts*numSourcePts);
-    }
-  else
-    {
-    // only copy scalar data through
-    // (superclass does this but why? if user has not asked for ColorGlyphs)
-    outPD->CopyAllOff();
-    outPD->CopyScalarsOn();
-    outPD->CopyAllocate(pd,numDirs*numInputPts*numSourcePts);
-    }
-  if ( (sourceNormals = pd->GetNormals()) )
-    {
-    newNormals = vtkFloatArray::New();
-    newNormals->SetNumberOfComponents(3);
-    newNormals->Allocate(numDirs*3*numInputPts*numSourcePts);
     }
 
-  // Don't copy all topology here as in superclass because
-  // we are not necessarily outputting a glyph for every point.
-
   // Figure out if we are masking some of the glyphs
-  inMask = NULL;
-
+  vtkDataArray *inMask = NULL;
   if (this->MaskGlyphs)
     {
     if (this->Mask != NULL)
@@ -348,410 +768,262 @@ int vtkDiffusionTensorGlyph::RequestData(
       }
     }
 
-  // Figure out if we are transforming output point locations
-  if (this->VolumePositionMatrix)
-    {
-    // user transform to move points
-    userVolumeTransform = vtkTransform::New();
-
-    userVolumeTransform->SetMatrix(this->VolumePositionMatrix);
-    userVolumeTransform->PreMultiply();
-    }
-
-  vtkDebugMacro(<<"Generating tensor glyphs: TRAVERSE POINTS");
-
-  vtkDebugMacro("Scalar coloring (" <<  this->ColorMode << ")  ["<< vtkTensorGlyph::COLOR_BY_EIGENVALUES << "] is evals. Scalar Invariant (" << this->ScalarInvariant << ")") ;
+  vtkNew<vtkMultiThreader> threader;
+  GlyphThreadStruct str;
+  str.ExtractEigenvalues = this->ExtractEigenvalues;
 
   //
-  // Traverse all Input points, transforming glyph in this->Source by tensor,
-  // and outputting it at each point.  (Input points are not all used, only
-  // those not masked and included by this->Resolution.)
+  // Traverse all Input points, keeping the tensors that will be glyphed.
+  // (Input points are not all used, only those not masked and included by
+  // this->Resolution.) They are only selected again when the input or the
+  // selection changes, not when only the glyph scale or color changes. The
+  // eigensystems of the last slices are reused when the selected tensors
+  // are the same.
   //
-  trans->PreMultiply();
-
-  for (inPtId=0; inPtId < numPts; inPtId += skipCols)
+  vtkInternal* internal = this->Internal;
+  const int selection[6] = {skipRows, skipCols, rowLength, this->MaskGlyphs,
+                            inMask != NULL, this->ExtractEigenvalues};
+  if (!internal->IsInputUnchanged(input, inTensors, this->MaskGlyphs ? this->Mask : 0,
+                                  selection))
     {
-    if (col >= rowLength)
-      {
-      row += skipRows;
-      inPtId = row * rowLength;
-      col = 0;
-      if (inPtId >= numPts)
-        {
-        break;
-        }
-      }
-    col += skipCols;
-    // progress notification
-    if ( ! (inPtId % 10000) )
-      {
-      this->UpdateProgress ((double)inPtId/numPts);
-
-      vtkDebugMacro(<<"Generating diffusion tensor glyphs: PROGRESS" << (double)inPtId/numPts);
-      if (this->GetAbortExecute())
-        {
-        break;
-        }
-      }
-
-    inTensors->GetTuple(inPtId, (double *)tensor);
-
-    // Decide whether this tensor will be glyphed:
-    // Threshold by trace ( must be > 0)
-    double trace = vtkDiffusionTensorMathematics::Trace(tensor);
-
-    // Only display this glyph if either:
-    // a) we are masking and the mask is 1 at this location.
-    // b) the trace is positive and we are not masking (default).
-    if (( ( inMask != NULL ) && inMask->GetTuple1( inPtId ) ) || ( !this->MaskGlyphs && trace > 0 ))
+    // the glyphed tensors are selected again before the eigensystems are
+    // looked up, the input may be the same slice
+    internal->Input = 0;
+    internal->Points.clear();
+    internal->Scalars.clear();
+    std::vector<double> tensorValues;
+    int row = 0;
+    int col = 0;
+    for (vtkIdType inPtId=0; inPtId < numPts; inPtId += skipCols)
       {
-      // copy topology of output glyph for this point
-      for (cellId=0; cellId < numSourceCells; cellId++)
-        {
-        cell = this->GetSource()->GetCell(cellId);
-        cellPts = cell->GetPointIds();
-        npts = cellPts->GetNumberOfIds();
-        for (dir=0; dir < numDirs; dir++)
-          {
-          // This variable may be removed, but that
-          // will not improve readability
-          //subIncr = ptIncr + dir*numSourcePts;
-
-          // Add offset calculated from all non-masked points added to output so far
-          subIncr = ptOffset + dir*numSourcePts;
-
-          for (i=0; i < npts; i++)
-            {
-            pts[i] = cellPts->GetId(i) + subIncr;
-            }
-          output->InsertNextCell(cell->GetCellType(),npts,pts);
-          }
-        }
-
-      // compute orientation vectors and scale factors from tensor
-      if ( this->ExtractEigenvalues ) // extract appropriate eigenfunctions
-        {
-        for (j=0; j<3; j++)
-          {
-          for (i=0; i<3; i++)
-            {
-            // this line from vtkTensorGlyph actually transposes
-            //m[i][j] = tensor[i+3*j];
-            // simpler code with 3x3 array:
-            m[i][j] = tensor[j][i];
-            }
-          }
-
-        //vtkMath::Jacobi(m, w, v);
-        // Use superior eigensolve from teem.
-        vtkDiffusionTensorMathematics::TeemEigenSolver(m,w,v);
-
-        //copy eigenvectors
-        xv[0] = v[0][0]; xv[1] = v[1][0]; xv[2] = v[2][0];
-        yv[0] = v[0][1]; yv[1] = v[1][1]; yv[2] = v[2][1];
-        zv[0] = v[0][2]; zv[1] = v[1][2]; zv[2] = v[2][2];
-        }
-      else //use tensor columns as eigenvectors
+      if (col >= rowLength)
         {
-        for (i=0; i<3; i++)
+        row += skipRows;
+        inPtId = row * rowLength;
+        col = 0;
+        if (inPtId >= numPts)
           {
-          //xv[i] = tensor[i]; // from vtkTensorGlyph
-          //yv[i] = tensor[i+3];
-          //zv[i] = tensor[i+6];
-          xv[i] = tensor[0][i]; // with 3x3 matrix
-          yv[i] = tensor[1][i];
-          zv[i] = tensor[2][i];
+          break;
           }
-        w[0] = vtkMath::Normalize(xv);
-        w[1] = vtkMath::Normalize(yv);
-        w[2] = vtkMath::Normalize(zv);
-        }
-
-      // Calculate output scalars before computing glyph scale factors from eigenvalues.
-      // First, pass through input scalars if requested.
-      if ( inScalars && this->ColorGlyphs && ( this->ColorMode == vtkTensorGlyph::COLOR_BY_SCALARS ) )
-        {
-        // Copy point data from source
-        s = inScalars->GetComponent(inPtId, 0);
         }
+      col += skipCols;
 
-      // Output scalar invariants if requested
-      else if ( this->ColorGlyphs && ( this->ColorMode == vtkTensorGlyph::COLOR_BY_EIGENVALUES ) )
+      // progress notification
+      if ( ! (inPtId % 10000) )
         {
-        // Correct for negative eigenvalues: use logic coded in vtkDiffusionTensorMathematics
-        vtkDiffusionTensorMathematics::FixNegativeEigenvaluesMethod(w);
-
-        switch (this->ScalarInvariant)
+        this->UpdateProgress (0.1 * inPtId / numPts);
+        if (this->GetAbortExecute())
           {
-          case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
-            s = vtkDiffusionTensorMathematics::LinearMeasure(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
-            s = vtkDiffusionTensorMathematics::PlanarMeasure(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
-            s = vtkDiffusionTensorMathematics::SphericalMeasure(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_MAX_EIGENVALUE:
-            s = w[0];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_MID_EIGENVALUE:
-            s = w[1];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_MIN_EIGENVALUE:
-            s = w[2];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_PARALLEL_DIFFUSIVITY:
-            s = w[0];
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_PERPENDICULAR_DIFFUSIVITY:
-            s = 0.5*(w[1]+w[2]);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_COLOR_ORIENTATION:
-            double v_maj[3];
-            v_maj[0]=v[0][0];
-            v_maj[1]=v[1][0];
-            v_maj[2]=v[2][0];
-            if (this->TensorRotationMatrix)
-              {
-              vtkNew<vtkTransform> rotate;
-              rotate->SetMatrix(this->TensorRotationMatrix);
-              rotate->TransformPoint(v_maj,v_maj);
-              }
-            // TO DO: here output as RGB. Need to allocate 3-component scalars first.
-            s = 0;
-            vtkDiffusionTensorMathematics::RGBToIndex(fabs(v_maj[0]),fabs(v_maj[1]),fabs(v_maj[2]),s);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_RELATIVE_ANISOTROPY:
-            s = vtkDiffusionTensorMathematics::RelativeAnisotropy(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
-            s = vtkDiffusionTensorMathematics::FractionalAnisotropy(w);
-            break;
-          case vtkDiffusionTensorMathematics::VTK_TENS_TRACE:
-            s = vtkDiffusionTensorMathematics::Trace(w);
-            break;
-          default:
-            s = 0;
-            break;
+          return 1;
           }
         }
 
-      // Use the square root of the eigenvalues for scaling
-      // for DTI
-      w[0] = sqrt( w[0] );
-      w[1] = sqrt( w[1] );
-      w[2] = sqrt( w[2] );
+      // use simpler 3x3 array, not 9D as in vtkTensorGlyph class
+      double tensor[3][3];
+      inTensors->GetTuple(inPtId, (double *)tensor);
 
-      // compute scale factors (this modifies eigenvalues so
-      // scalar invariants were computed already above)
-      w[0] *= this->ScaleFactor;
-      w[1] *= this->ScaleFactor;
-      w[2] *= this->ScaleFactor;
+      // Decide whether this tensor will be glyphed:
+      // Threshold by trace ( must be > 0)
+      double trace = vtkDiffusionTensorMathematics::Trace(tensor);
 
-      if ( this->ClampScaling )
+      // Only display this glyph if either:
+      // a) we are masking and the mask is 1 at this location.
+      // b) the trace is positive and we are not masking (default).
+      if (( ( inMask != NULL ) && inMask->GetTuple1( inPtId ) ) || ( !this->MaskGlyphs && trace > 0 ))
         {
-        for (maxScale=0.0, i=0; i<3; i++)
-          {
-          if ( maxScale < fabs(w[i]) )
-            {
-            maxScale = fabs(w[i]);
-            }
-          }
-        if ( maxScale > this->MaxScaleFactor )
-          {
-          maxScale = this->MaxScaleFactor / maxScale;
-          for (i=0; i<3; i++)
-            {
-            w[i] *= maxScale; //preserve overall shape of glyph
-            }
-          }
+        double x[3];
+        input->GetPoint(inPtId, x);
+        internal->Points.insert(internal->Points.end(), x, x + 3);
+        tensorValues.insert(tensorValues.end(), &tensor[0][0], &tensor[0][0] + 9);
+        internal->Scalars.push_back(inScalars ? inScalars->GetComponent(inPtId, 0) : 0.);
         }
+      }
 
-      // normalization is postponed
-
-      // make sure scale is okay (non-zero) and scale data
-      // this scale checking is from superclass code
-      for (maxScale=0.0, i=0; i<3; i++)
-        {
-        if ( w[i] > maxScale )
-          {
-          maxScale = w[i];
-          }
-        }
-      if ( maxScale == 0.0 )
-        {
-        maxScale = 1.0;
-        }
-      for (i=0; i<3; i++)
+    if (!internal->FindSlice(selection, tensorValues))
+      {
+      // compute orientation vectors and scale factors from tensors
+      internal->Slices.push_front(vtkInternal::SliceEigenSystems());
+      vtkInternal::SliceEigenSystems& slice = internal->Slices.front();
+      std::copy(selection, selection + 6, slice.Selection);
+      slice.TensorValues.swap(tensorValues);
+      const vtkIdType numberOfGlyphs = static_cast<vtkIdType>(internal->Scalars.size());
+      slice.Eigenvalues.resize(3 * numberOfGlyphs);
+      slice.Eigenvectors.resize(9 * numberOfGlyphs);
+      if (numberOfGlyphs > 0)
         {
-        if ( w[i] == 0.0 )
+        str.Stage = GlyphThreadStruct::EigenSystems;
+        str.Tensors = &slice.TensorValues[0];
+        str.Eigenvalues = &slice.Eigenvalues[0];
+        str.Eigenvectors = &slice.Eigenvectors[0];
+        if (ExecuteStage(this, threader.GetPointer(), &str, numberOfGlyphs, 0.1, 0.5)
+            < numberOfGlyphs)
           {
-          w[i] = maxScale * 1.0e-06;
+          internal->Slices.pop_front();
+          return 1;
           }
         }
-
-      // Now do the real work for each "direction"
-      // This is a loop over each eigenvector allowing
-      // a separate glyph for each (or two loops per eigenvector
-      // allowing two symmetric glyphs for each)
-
-      int flipNormals = 0;
-      if ( this->TensorRotationMatrix && this->TensorRotationMatrix->Determinant() < 0 )
+      if (internal->Slices.size() > vtkInternal::MaximumNumberOfSlices)
         {
-        flipNormals = 1;
+        internal->Slices.pop_back();
         }
+      }
 
-      for (dir=0; dir < numDirs; dir++)
-        {
-        eigen_dir = dir%(this->ThreeGlyphs?3:1);
-        symmetric_dir = dir/(this->ThreeGlyphs?3:1);
-
-        // Remove previous scales ...
-        trans->Identity();
-
-        // Actually output the scalar invariant calculated above
-        if ( newScalars != NULL )
-          {
-          for (i=0; i < numSourcePts; i++)
-            {
-            newScalars->InsertTuple(ptOffset+i, &s);
-            }
-          }
-        else
-          {
-          for (i=0; i < numSourcePts; i++)
-            {
-            // TO DO: why does superclass have this if no scalar output?
-            // in this case it appears copy scalars is on (above in
-            // scalar allocation section).
-            outPD->CopyData(pd,i,ptOffset+i);
-            }
-          }
-
-        // translate Source to Input point
-        input->GetPoint(inPtId, x);
+    internal->Input = input;
+    internal->Tensors = inTensors;
+    internal->Mask = this->MaskGlyphs ? this->Mask : 0;
+    std::copy(selection, selection + 6, internal->Selection);
+    internal->CacheTime.Modified();
+    }
+  this->UpdateProgress(0.5);
+  vtkInternal::SliceEigenSystems& slice = internal->Slices.front();
 
-        // If we have a user-specified matrix modifying the output point locations
-        if ( userVolumeTransform != NULL )
-          {
-          userVolumeTransform->TransformPoint(x,x2);
-          trans->Translate(x2[0], x2[1], x2[2]);
-          }
-        else
-          {
-          trans->Translate(x[0], x[1], x[2]);
-          }
+  const vtkIdType numGlyphs = static_cast<vtkIdType>(internal->Scalars.size());
 
-        // If we have a user-specified matrix rotating each tensor
-        if (this->TensorRotationMatrix)
-          {
-          trans->Concatenate(this->TensorRotationMatrix);
-          }
+  // the number of eigenvectors to glyph * if there are two glyphs per vector
+  const int numDirs = (this->ThreeGlyphs?3:1)*(this->Symmetric+1);
 
-        // normalized eigenvectors rotate object for eigen direction 0
-        matrix->Element[0][0] = xv[0];
-        matrix->Element[0][1] = yv[0];
-        matrix->Element[0][2] = zv[0];
-        matrix->Element[1][0] = xv[1];
-        matrix->Element[1][1] = yv[1];
-        matrix->Element[1][2] = zv[1];
-        matrix->Element[2][0] = xv[2];
-        matrix->Element[2][1] = yv[2];
-        matrix->Element[2][2] = zv[2];
-        trans->Concatenate(matrix);
-
-        if (eigen_dir == 1)
-          {
-          trans->RotateZ(90.0);
-          }
+  //
+  // Allocate storage for output PolyData, exactly as many glyphs as needed
+  //
+  vtkPoints *sourcePts = source->GetPoints();
+  const vtkIdType numSourcePts = sourcePts->GetNumberOfPoints();
+  const vtkIdType numOutPts = numGlyphs * numDirs * numSourcePts;
 
-        if (eigen_dir == 2)
-          {
-          trans->RotateY(-90.0);
-          }
+  vtkNew<vtkPoints> newPts;
+  newPts->SetDataTypeToFloat();
+  newPts->SetNumberOfPoints(numOutPts);
 
-        if (this->ThreeGlyphs)
-          {
-          trans->Scale(w[eigen_dir], this->ScaleFactor, this->ScaleFactor);
-          }
-        else
-          {
-          trans->Scale(w[0], w[1], w[2]);
-          }
+  std::vector<double> sourcePoints(3 * numSourcePts);
+  for (vtkIdType i = 0; i < numSourcePts; ++i)
+    {
+    sourcePts->GetPoint(i, &sourcePoints[3 * i]);
+    }
 
-        // Mirror second set to the symmetric position
-        if (symmetric_dir == 1)
-          {
-          trans->Scale(-1.,1.,1.);
-          }
+  vtkCellArray* sourceCells[4] = {source->GetVerts(), source->GetLines(),
+                                  source->GetPolys(), source->GetStrips()};
+  for (int c = 0; c < 4; ++c)
+    {
+    str.SourceCells[c] = 0;
+    str.SourceCellsSize[c] = 0;
+    str.OutCells[c] = 0;
+    if (sourceCells[c]->GetNumberOfCells() == 0)
+      {
+      continue;
+      }
+    str.SourceCells[c] = sourceCells[c]->GetPointer();
+    str.SourceCellsSize[c] = sourceCells[c]->GetNumberOfConnectivityEntries();
+    vtkNew<vtkIdTypeArray> connectivity;
+    connectivity->SetNumberOfValues(numGlyphs * numDirs * str.SourceCellsSize[c]);
+    str.OutCells[c] = connectivity->GetPointer(0);
+    vtkNew<vtkCellArray> cells;
+    cells->SetCells(numGlyphs * numDirs * sourceCells[c]->GetNumberOfCells(),
+                    connectivity.GetPointer());
+    switch (c)
+      {
+      case 0: output->SetVerts(cells.GetPointer()); break;
+      case 1: output->SetLines(cells.GetPointer()); break;
+      case 2: output->SetPolys(cells.GetPointer()); break;
+      default: output->SetStrips(cells.GetPointer()); break;
+      }
+    }
 
-        // if the eigenvalue is negative, shift to reverse direction.
-        // The && is there to ensure that we do not change the
-        // old behaviour of vtkTensorGlyphs (which only used one dir),
-        // in case there is an oriented glyph, e.g. an arrow.
-        if (w[eigen_dir] < 0 && numDirs > 1)
-          {
-          trans->Translate(-this->Length, 0., 0.);
-          }
+  // Get point data, decide how to allocate scalars
+  pd = source->GetPointData();
 
-        // multiply points (and normals if available) by resulting
-        // matrix.
-        // This also appends them to the output "new" data.
-        trans->TransformPoints(sourcePts,newPts);
+  // generate scalars if eigenvalues are chosen or if scalars exist.
+  vtkSmartPointer<vtkFloatArray> newScalars;
+  if (this->ColorGlyphs &&
+      ((this->ColorMode == COLOR_BY_EIGENVALUES) ||
+       (inScalars && (this->ColorMode == COLOR_BY_SCALARS)) ) )
+    {
+    newScalars = vtkSmartPointer<vtkFloatArray>::New();
+    newScalars->SetNumberOfTuples(numOutPts);
+    }
+  else
+    {
+    // only copy scalar data through
+    // (superclass does this but why? if user has not asked for ColorGlyphs)
+    outPD->CopyAllOff();
+    outPD->CopyScalarsOn();
+    outPD->CopyAllocate(pd,numOutPts);
+    for (vtkIdType ptOffset = 0; ptOffset < numOutPts; ptOffset += numSourcePts)
+      {
+      for (vtkIdType i=0; i < numSourcePts; i++)
+        {
+        outPD->CopyData(pd,i,ptOffset+i);
+        }
+      }
+    }
+  vtkDataArray *sourceNormals = pd->GetNormals();
+  vtkSmartPointer<vtkFloatArray> newNormals;
+  std::vector<double> normals;
+  if (sourceNormals)
+    {
+    newNormals = vtkSmartPointer<vtkFloatArray>::New();
+    newNormals->SetNumberOfComponents(3);
+    newNormals->SetNumberOfTuples(numOutPts);
+    normals.resize(3 * numSourcePts);
+    for (vtkIdType i = 0; i < numSourcePts; ++i)
+      {
+      sourceNormals->GetTuple(i, &normals[3 * i]);
+      }
+    }
 
-        // Apply the transformation to a series of points,
-        // and append the results to outPts.
-        if ( newNormals )
-          {
-          if ( flipNormals )
-            {
-            trans->Scale(-1.,-1.,-1.);
-            trans->TransformNormals(sourceNormals,newNormals);
-            trans->Scale(-1.,-1.,-1.);
-            }
-          else
-            {
-            trans->TransformNormals(sourceNormals,newNormals);
-            }
-          }
+  vtkDebugMacro("Scalar coloring (" <<  this->ColorMode << ")  ["<< vtkTensorGlyph::COLOR_BY_EIGENVALUES << "] is evals. Scalar Invariant (" << this->ScalarInvariant << ")") ;
 
-        // Keep track of the number of points output so far.
-        ptOffset += numSourcePts;
-        } // end for number of dirs
-      } // end if mask is 1 OR trace is ok (so tensor was glyphed)
-    } // end loop over input points
+  //
+  // Transform the glyph in this->Source by each tensor, in parallel: every
+  // tensor writes at its own place in the preallocated arrays.
+  //
+  str.Stage = GlyphThreadStruct::Glyphs;
+  str.Points = numGlyphs ? &internal->Points[0] : 0;
+  str.Scalars = (numGlyphs && inScalars) ? &internal->Scalars[0] : 0;
+  str.Eigenvalues = numGlyphs ? &slice.Eigenvalues[0] : 0;
+  str.Eigenvectors = numGlyphs ? &slice.Eigenvectors[0] : 0;
+  str.VolumePosition = this->VolumePositionMatrix ?
+    &this->VolumePositionMatrix->Element[0][0] : 0;
+  str.TensorRotation = this->TensorRotationMatrix ?
+    &this->TensorRotationMatrix->Element[0][0] : 0;
+  str.FlipNormals = this->TensorRotationMatrix &&
+    this->TensorRotationMatrix->Determinant() < 0;
+  str.NumberOfDirections = numDirs;
+  str.ThreeGlyphs = this->ThreeGlyphs;
+  str.ColorMode = this->ColorGlyphs ? this->ColorMode : -1;
+  str.ScalarInvariant = this->ScalarInvariant;
+  str.ClampScaling = this->ClampScaling;
+  str.ScaleFactor = this->ScaleFactor;
+  str.MaxScaleFactor = this->MaxScaleFactor;
+  str.Length = this->Length;
+  str.NumberOfSourcePoints = numSourcePts;
+  str.SourcePoints = numSourcePts ? &sourcePoints[0] : 0;
+  str.SourceNormals = sourceNormals ? &normals[0] : 0;
+  str.OutPoints = numOutPts ? static_cast<float*>(newPts->GetVoidPointer(0)) : 0;
+  str.OutNormals = (newNormals && numOutPts) ? newNormals->GetPointer(0) : 0;
+  str.OutScalars = (newScalars && numOutPts) ? newScalars->GetPointer(0) : 0;
+  if (numOutPts > 0 &&
+      ExecuteStage(this, threader.GetPointer(), &str, numGlyphs, 0.5, 1.) < numGlyphs)
+    {
+    // aborted, the arrays are partially filled
+    output->Initialize();
+    return 1;
+    }
 
-  vtkDebugMacro(<<"Generated " << numInputPts <<" tensor glyphs");
+  vtkDebugMacro(<<"Generated " << numGlyphs <<" tensor glyphs");
 
   //
-  // Update output and release memory
+  // Update output
   //
-  delete [] pts;
-
-  output->SetPoints(newPts);
-  newPts->Delete();
+  output->SetPoints(newPts.GetPointer());
 
   if ( newScalars )
     {
     int idx = outPD->AddArray(newScalars);
     outPD->SetActiveAttribute(idx, vtkDataSetAttributes::SCALARS);
-    newScalars->Delete();
     }
 
   if ( newNormals )
     {
     outPD->SetNormals(newNormals);
-    newNormals->Delete();
-    }
-
-  output->Squeeze();
-  trans->Delete();
-  matrix->Delete();
-
-  if ( userVolumeTransform )
-    {
-    userVolumeTransform->Delete();
     }
 
   vtkDebugMacro("glyph time: " << clock() - tStart );
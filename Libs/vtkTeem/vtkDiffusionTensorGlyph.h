@@ -65,6 +65,12 @@ class vtkMatrix4x4;
 /// functions are scalar invariants of the diffusion tensor.  They are selected
 /// by calling ColorGlyphsByFractionalAnisotropy, etc.
 ///
+/// The eigensystems of the glyphed tensors are computed in parallel. They
+/// are kept for the last 8 sets of glyphed tensors, e.g. the last slices
+/// of a volume shown in a slice view, and reused when the same tensors are
+/// glyphed again. The glyphs are then generated in parallel into
+/// preallocated arrays.
+///
 /// \sa vtkTensorGlyph
 /// \sa vtkDiffusionTensorMathematics
 /// \sa vtkSuperquadricTensorGlyph
@@ -190,6 +196,10 @@ protected:
 
   vtkImageData *Mask;  /// display glyphs at points where mask is nonzero
 
+  /// Glyphed tensors of the input and eigensystems of the last slices
+  class vtkInternal;
+  vtkInternal* Internal;
+
 private:
   vtkDiffusionTensorGlyph(const vtkDiffusionTensorGlyph&);  /// Not implemented.
   void operator=(const vtkDiffusionTensorGlyph&);  /// Not implemented.
@@ -7,10 +7,182 @@
 #include "vtkPointData.h"
 #include "vtkObjectFactory.h"
 #include "vtkInformation.h"
+#include <vtkNew.h>
 #include <vtkVersion.h>
 
+// ZLIB includes
+#include <zlib.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
 class AttributeMapType: public std::map<std::string, std::string> {};
 
+namespace
+{
+
+// Uncompressed size of the blocks compressed by each thread
+const size_t GzipBlockSize = 1 << 20;
+// Deflate window: each block is primed with the end of the previous one
+const size_t GzipDictionarySize = 1 << 15;
+
+//----------------------------------------------------------------------------
+struct vtkNRRDWriterGzipBlock
+{
+  vtkNRRDWriterGzipBlock() : CRC(0), Success(false) {}
+  std::vector<unsigned char> Output;
+  uLong CRC;
+  bool Success;
+};
+
+//----------------------------------------------------------------------------
+struct vtkNRRDWriterGzipThreadStruct
+{
+  const unsigned char* Data;
+  size_t Size;
+  int Level;
+  size_t FirstBlock;
+  std::vector<vtkNRRDWriterGzipBlock>* Blocks;
+};
+
+//----------------------------------------------------------------------------
+// Deflate [begin, end[ as a part of a raw deflate stream of data: all the
+// blocks but the last one end with a sync flush so that they can simply
+// be concatenated.
+bool DeflateBlock(const unsigned char* data, size_t size,
+                  size_t begin, size_t end, int level,
+                  vtkNRRDWriterGzipBlock& block)
+{
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+  if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8,
+                   Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return false;
+    }
+  if (begin > 0)
+    {
+    size_t dictionaryBegin = begin > GzipDictionarySize ? begin - GzipDictionarySize : 0;
+    deflateSetDictionary(&stream, data + dictionaryBegin,
+                         static_cast<uInt>(begin - dictionaryBegin));
+    }
+  bool last = (end == size);
+  // sync flush marker and margin on top of the bound
+  block.Output.resize(deflateBound(&stream, static_cast<uLong>(end - begin)) + 16);
+  stream.next_in = const_cast<Bytef*>(data + begin);
+  stream.avail_in = static_cast<uInt>(end - begin);
+  stream.next_out = &block.Output[0];
+  stream.avail_out = static_cast<uInt>(block.Output.size());
+  int res = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+  bool success = last ? res == Z_STREAM_END :
+    (res == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
+  block.Output.resize(stream.total_out);
+  deflateEnd(&stream);
+  block.CRC = crc32(0L, data + begin, static_cast<uInt>(end - begin));
+  return success;
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkNRRDWriterGzipThread(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* info = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkNRRDWriterGzipThreadStruct* str =
+    static_cast<vtkNRRDWriterGzipThreadStruct*>(info->UserData);
+  std::vector<vtkNRRDWriterGzipBlock>& blocks = *str->Blocks;
+  for (size_t b = info->ThreadID; b < blocks.size(); b += info->NumberOfThreads)
+    {
+    size_t begin = (str->FirstBlock + b) * GzipBlockSize;
+    size_t end = std::min(begin + GzipBlockSize, str->Size);
+    blocks[b].Success = DeflateBlock(str->Data, str->Size, begin, end, str->Level, blocks[b]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void WriteLittleEndian32(std::ostream& file, uLong value)
+{
+  char bytes[4];
+  for (int i = 0; i < 4; ++i)
+    {
+    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+  file.write(bytes, 4);
+}
+
+//----------------------------------------------------------------------------
+// Append data to fileName as a single gzip member. Blocks are compressed
+// by numberOfThreads threads a few at a time so that only a small part of
+// the compressed data is in memory.
+bool AppendGzipData(const char* fileName, const void* data, size_t size,
+                    int level, int numberOfThreads)
+{
+  std::ofstream file(fileName, std::ios::out | std::ios::binary | std::ios::app);
+  if (!file)
+    {
+    return false;
+    }
+  // ID1 ID2 CM FLG MTIME(4) XFL OS
+  const char header[10] = {'\x1f', '\x8b', 8, 0, 0, 0, 0, 0, 0, '\xff'};
+  file.write(header, 10);
+
+  vtkNRRDWriterGzipThreadStruct str;
+  str.Data = static_cast<const unsigned char*>(data);
+  str.Size = size;
+  str.Level = level;
+  std::vector<vtkNRRDWriterGzipBlock> blocks;
+  str.Blocks = &blocks;
+
+  const size_t numberOfBlocks = std::max<size_t>((size + GzipBlockSize - 1) / GzipBlockSize, 1);
+  const size_t blocksPerRound = 4 * numberOfThreads;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  vtkNew<vtkMultiThreader> threader;
+  for (str.FirstBlock = 0; str.FirstBlock < numberOfBlocks; str.FirstBlock += blocksPerRound)
+    {
+    blocks.assign(std::min(blocksPerRound, numberOfBlocks - str.FirstBlock),
+                  vtkNRRDWriterGzipBlock());
+    threader->SetNumberOfThreads(
+      static_cast<int>(std::min<size_t>(numberOfThreads, blocks.size())));
+    threader->SetSingleMethod(vtkNRRDWriterGzipThread, &str);
+    threader->SingleMethodExecute();
+    for (size_t b = 0; b < blocks.size(); ++b)
+      {
+      if (!blocks[b].Success)
+        {
+        return false;
+        }
+      if (!blocks[b].Output.empty())
+        {
+        file.write(reinterpret_cast<const char*>(&blocks[b].Output[0]),
+                   blocks[b].Output.size());
+        }
+      size_t begin = (str.FirstBlock + b) * GzipBlockSize;
+      size_t blockSize = std::min(begin + GzipBlockSize, size) - begin;
+      crc = crc32_combine(crc, blocks[b].CRC, static_cast<z_off_t>(blockSize));
+      }
+    }
+  WriteLittleEndian32(file, crc);
+  WriteLittleEndian32(file, static_cast<uLong>(size & 0xffffffff));
+  file.close();
+  return !file.fail();
+}
+
+//----------------------------------------------------------------------------
+// The header written by nrrdSave() without data must be followed by an
+// empty line before the data.
+bool EndsWithEmptyLine(const char* fileName)
+{
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+  char end[2] = {0, 0};
+  file.seekg(-2, std::ios::end);
+  file.read(end, 2);
+  return file && end[0] == '\n' && end[1] == '\n';
+}
+
+} // end of anonymous namespace
+
 vtkStandardNewMacro(vtkNRRDWriter);
 
 //----------------------------------------------------------------------------
@@ -22,6 +194,8 @@ vtkNRRDWriter::vtkNRRDWriter()
   this->IJKToRASMatrix = vtkMatrix4x4::New();
   this->MeasurementFrameMatrix = vtkMatrix4x4::New();
   this->UseCompression = 1;
+  this->CompressionLevel = -1;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
   this->DiffusionWeigthedData = 0;
   this->FileType = VTK_BINARY;
   this->WriteErrorOff();
@@ -348,6 +522,20 @@ void vtkNRRDWriter::WriteData()
       }
     }
 
+  nio->zlibLevel = this->CompressionLevel;
+
+  // Compress the data concurrently after Teem wrote the header. Detached
+  // headers keep the data file naming of Teem.
+  std::string fileName = this->GetFileName();
+  bool detachedHeader = fileName.size() >= 5 &&
+    fileName.compare(fileName.size() - 5, 5, ".nhdr") == 0;
+  bool parallelCompression = nio->encoding == nrrdEncodingGzip &&
+    this->NumberOfThreads > 1 && !detachedHeader;
+  if (parallelCompression)
+    {
+    nio->skipData = AIR_TRUE;
+    }
+
   // set endianness as unknown of output
   nio->endian = airEndianUnknown;
 
@@ -359,6 +547,21 @@ void vtkNRRDWriter::WriteData()
                       << this->GetFileName() << ":\n" << err);
     this->WriteErrorOn();
     }
+  else if (parallelCompression)
+    {
+    if (!EndsWithEmptyLine(this->GetFileName()))
+      {
+      std::ofstream file(this->GetFileName(), std::ios::out | std::ios::binary | std::ios::app);
+      file << "\n";
+      }
+    size_t dataSize = nrrdElementNumber(nrrd) * nrrdElementSize(nrrd);
+    if (!AppendGzipData(this->GetFileName(), buffer, dataSize,
+                        this->CompressionLevel, this->NumberOfThreads))
+      {
+      vtkErrorMacro("Write: Error compressing data of " << this->GetFileName());
+      this->WriteErrorOn();
+      }
+    }
   // Free the nrrd struct but don't touch nrrd->data
   nrrd = nrrdNix(nrrd);
   nio = nrrdIoStateNix(nio);
@@ -373,6 +576,9 @@ void vtkNRRDWriter::PrintSelf(ostream& os, vtkIndent indent)
      this->IJKToRASMatrix->PrintSelf(os,indent);
   os << indent << "Measurement frame: ";
      this->MeasurementFrameMatrix->PrintSelf(os,indent);
+  os << indent << "UseCompression: " << this->UseCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
 }
 
 void vtkNRRDWriter::SetAttribute(const std::string& name, const std::string& value)
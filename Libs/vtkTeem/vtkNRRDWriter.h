@@ -6,6 +6,7 @@
 
 #include "vtkMatrix4x4.h"
 #include "vtkDoubleArray.h"
+#include "vtkMultiThreader.h"
 #include "teem/nrrd.h"
 
 #include "vtkTeemConfigure.h"
@@ -53,6 +54,21 @@ public:
   vtkGetMacro(UseCompression,int);
   vtkBooleanMacro(UseCompression,int);
 
+  ///
+  /// zlib compression level used when UseCompression is on, from 1 (fastest)
+  /// to 9 (smallest file). -1 (default) uses the zlib default level.
+  vtkSetClampMacro(CompressionLevel,int,-1,9);
+  vtkGetMacro(CompressionLevel,int);
+
+  ///
+  /// Number of threads used to compress the data. With more than one thread,
+  /// the data is split into blocks that are compressed concurrently into a
+  /// single gzip stream that any gzip reader can decompress.
+  /// Only attached headers (.nrrd) are compressed concurrently.
+  /// By default, vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+  vtkSetClampMacro(NumberOfThreads,int,1,VTK_MAX_THREADS);
+  vtkGetMacro(NumberOfThreads,int);
+
   vtkSetClampMacro(FileType,int,VTK_ASCII,VTK_BINARY);
   vtkGetMacro(FileType,int);
   void SetFileTypeToASCII() {this->SetFileType(VTK_ASCII);};
@@ -90,6 +106,8 @@ protected:
   vtkMatrix4x4 *MeasurementFrameMatrix;
 
   int UseCompression;
+  int CompressionLevel;
+  int NumberOfThreads;
   int FileType;
 
   AttributeMapType *Attributes;
@@ -20,8 +20,11 @@
 #include <vtkAlgorithmOutput.h>
 #include <vtkCellArray.h>
 #include <vtkCommand.h>
+#include <vtkFloatArray.h>
+#include <vtkIdTypeArray.h>
 #include <vtkInformation.h>
 #include <vtkMath.h>
+#include <vtkMutexLock.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkPolyDataWriter.h>
@@ -31,7 +34,10 @@
 #include <vtkVersion.h>
 
 // STD includes
+#include <algorithm>
+#include <cmath>
 #include <sstream>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSeedTracts);
@@ -91,6 +97,7 @@ vtkSeedTracts::vtkSeedTracts()
   this->FilePrefix = NULL;
   this->UseStartingThreshold = 0;
   this->StartingThreshold = 0;
+  this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
 }
 
 //----------------------------------------------------------------------------
@@ -497,10 +504,10 @@ void vtkSeedTracts::SeedStreamlineFromPoint(double x,
   //newStreamline->Delete();
 }
 
-// Seed in an ROI using a continous grid with the resolution given by
-//this->IsotropicSeedingResolution.
+// Compute the seeds of an ROI using a continous grid with the resolution
+// given by this->IsotropicSeedingResolution.
 //----------------------------------------------------------------------------
-void vtkSeedTracts::SeedStreamlinesInROI()
+int vtkSeedTracts::ComputeSeedPointsInROI(vtkPoints *seedPoints)
 {
   double idxX, idxY, idxZ;
   double maxX, maxY, maxZ;
@@ -509,63 +516,48 @@ void vtkSeedTracts::SeedStreamlinesInROI()
   double point[3], point2[3];
 
   short *inPtr;
-  vtkHyperStreamlineDTMRI *newStreamline;
-  int idx;
-
 
   // test we have input
 #if (VTK_MAJOR_VERSION <= 5)
   if (this->InputROI == NULL)
     {
       vtkErrorMacro("No ROI input.");
-      return;
+      return 0;
     }
   if (this->InputTensorField == NULL)
     {
       vtkErrorMacro("No tensor data input.");
-      return;
+      return 0;
     }
 #else
   if (this->InputROIConnection == NULL)
     {
       vtkErrorMacro("No ROI input.");
-      return;
+      return 0;
     }
   if (this->InputTensorFieldConnection == NULL)
     {
       vtkErrorMacro("No tensor data input.");
-      return;
+      return 0;
     }
 #endif
   // check ROI's value of interest
   if (this->InputROIValue <= 0)
     {
       vtkErrorMacro("Input ROI value has not been set or is 0. (value is "  << this->InputROIValue << ".");
-      return;
+      return 0;
     }
   // make sure it is short type
 #if (VTK_MAJOR_VERSION <= 5)
   if (this->InputROI->GetScalarType() != VTK_SHORT)
     {
       vtkErrorMacro("Input ROI is not of type VTK_SHORT");
-      return;
+      return 0;
     }
 #else
   // TODO
 #endif
 
-  vtkNew<vtkTransform> transform;
-  transform->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
-  transform->Inverse();
-
-  vtkNew<vtkTransformPolyDataFilter> transformer;
-  transformer->SetTransform(transform.GetPointer());
-
-  vtkNew<vtkPolyDataWriter> writer;
-
-  // make sure we are creating objects with points
-  this->UseVtkHyperStreamlinePoints();
- 
   double spacing[3];
 
 #if (VTK_MAJOR_VERSION <= 5)
@@ -575,8 +567,6 @@ void vtkSeedTracts::SeedStreamlinesInROI()
 #endif
   inputTensorField->GetSpacing(spacing);
 
-  // currently this filter is not multithreaded, though in the future
-  // it could be (especially if it inherits from an image filter class)
 #if (VTK_MAJOR_VERSION <= 5)
   this->InputROI->GetWholeExtent(inExt);
 #else
@@ -621,20 +611,6 @@ void vtkSeedTracts::SeedStreamlinesInROI()
   m[0] = m0; m[1] = m1; m[2] = m2;
   v[0] = v0; v[1] = v1; v[2] = v2;
 
-  // filename index
-  idx=0;
-
-  int gridIncXYZ = gridIncX*gridIncY*gridIncZ;
-  int numLabelVoxels = 0;
-  if (gridIncXYZ)
-    {
-    numLabelVoxels = maxX*maxY*maxZ/gridIncXYZ;
-    }
-  int labelVoxelCount = 0;
-  int progressCount = 0;
-  int progressCountMax = 100;
-  double progress;
-
 #if (VTK_MAJOR_VERSION <= 5)
   vtkImageData* inputROI = this->InputROI;
 #else
@@ -652,7 +628,6 @@ void vtkSeedTracts::SeedStreamlinesInROI()
 
           for (idxX = 0; idxX <= maxX; idxX+=gridIncX)
             {
-              labelVoxelCount++;
               // get the pointer to the nearest voxel at this location
               int pt[3];
               pt[0]= (int) floor(idxX + 0.5);
@@ -732,99 +707,141 @@ void vtkSeedTracts::SeedStreamlinesInROI()
                         }
                       } // end if (UseStartingThreshold)
 
-                      // Report progress
-                      if (numLabelVoxels && progressCount == progressCountMax)
-                        {
-                        progressCount = 0;
-                        progress = (labelVoxelCount+0.0)/numLabelVoxels;
-                        this->InvokeEvent(vtkCommand::ProgressEvent, (void *)&progress);
-                        }
-                      else
-                        {
-                        progressCount++;
-                        }
-                      // Now create a streamline
-                      newStreamline=(vtkHyperStreamlineDTMRI *)
-                        this->CreateHyperStreamline();
+                    seedPoints->InsertNextPoint(point);
+                    }
+                }
 
-                      // Set its input information.
+            }
+
+        }
+
+    }
+  return 1;
+}
+
+// Seed in an ROI using a continous grid with the resolution given by
+//this->IsotropicSeedingResolution.
+//----------------------------------------------------------------------------
+void vtkSeedTracts::SeedStreamlinesInROI()
+{
+  vtkHyperStreamlineDTMRI *newStreamline;
+  int idx;
+
+  vtkNew<vtkPoints> seedPoints;
+  if (!this->ComputeSeedPointsInROI(seedPoints.GetPointer()))
+    {
+    return;
+    }
+
+  vtkNew<vtkTransform> transform;
+  transform->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
+  transform->Inverse();
+
+  vtkNew<vtkTransformPolyDataFilter> transformer;
+  transformer->SetTransform(transform.GetPointer());
+
+  vtkNew<vtkPolyDataWriter> writer;
+
+  // make sure we are creating objects with points
+  this->UseVtkHyperStreamlinePoints();
+
+  // filename index
+  idx=0;
+
+  vtkIdType numSeeds = seedPoints->GetNumberOfPoints();
+  int progressCount = 0;
+  int progressCountMax = 100;
+  double progress;
+  double point[3];
+
+  for (vtkIdType seedId = 0; seedId < numSeeds; ++seedId)
+    {
+    seedPoints->GetPoint(seedId, point);
+
+    // Report progress
+    if (progressCount == progressCountMax)
+      {
+      progressCount = 0;
+      progress = (seedId+0.0)/numSeeds;
+      this->InvokeEvent(vtkCommand::ProgressEvent, (void *)&progress);
+      }
+    else
+      {
+      progressCount++;
+      }
+    // Now create a streamline
+    newStreamline=(vtkHyperStreamlineDTMRI *)
+      this->CreateHyperStreamline();
+
+    // Set its input information.
 #if (VTK_MAJOR_VERSION <= 5)
-                      newStreamline->SetInput(this->InputTensorField);
+    newStreamline->SetInput(this->InputTensorField);
 #else
-                      newStreamline->SetInputConnection(this->InputTensorFieldConnection);
+    newStreamline->SetInputConnection(this->InputTensorFieldConnection);
 #endif
-                      newStreamline->SetStartPosition(point[0],point[1],point[2]);
-                      //newStreamline->DebugOn();
+    newStreamline->SetStartPosition(point[0],point[1],point[2]);
+    //newStreamline->DebugOn();
 
-                      // Ask it to output tensors and to only do one trajectory per start point
-                      newStreamline->OutputTensorsOn();
-                      newStreamline->OneTrajectoryPerSeedPointOn();
+    // Ask it to output tensors and to only do one trajectory per start point
+    newStreamline->OutputTensorsOn();
+    newStreamline->OneTrajectoryPerSeedPointOn();
 
-                      // Force it to execute
-                      newStreamline->Update();
+    // Force it to execute
+    newStreamline->Update();
 
-                      // See if we like it enough to add to the collection
-                      // This relies on the fact that the step length is in units of
-                      // length (unlike fractions of a cell in vtkHyperStreamline).
-                      double length =
-                        (newStreamline->GetOutput()->GetNumberOfPoints() - 1) *
-                        newStreamline->GetIntegrationStepLength();
+    // See if we like it enough to add to the collection
+    // This relies on the fact that the step length is in units of
+    // length (unlike fractions of a cell in vtkHyperStreamline).
+    double length =
+      (newStreamline->GetOutput()->GetNumberOfPoints() - 1) *
+      newStreamline->GetIntegrationStepLength();
 
-                      if (length > this->MinimumPathLength)
-                        {
-                        if (this->FileDirectoryName)
-                          // write streamline to disk
-                          {
-                          if (this->FilePrefix == NULL)
-                            {
-                            this->SetFilePrefix("line");
-                            }
-                          // transform model
+    if (length > this->MinimumPathLength)
+      {
+      if (this->FileDirectoryName)
+        // write streamline to disk
+        {
+        if (this->FilePrefix == NULL)
+          {
+          this->SetFilePrefix("line");
+          }
+        // transform model
 #if (VTK_MAJOR_VERSION <= 5)
-                          transformer->SetInput(newStreamline->GetOutput());
+        transformer->SetInput(newStreamline->GetOutput());
 #else
-                          transformer->SetInputConnection(newStreamline->GetOutputPort());
+        transformer->SetInputConnection(newStreamline->GetOutputPort());
 #endif
 
-                          // Save the model to disk
+        // Save the model to disk
 #if (VTK_MAJOR_VERSION <= 5)
-                          writer->SetInput(transformer->GetOutput());
+        writer->SetInput(transformer->GetOutput());
 #else
-                          writer->SetInputConnection(transformer->GetOutputPort());
+        writer->SetInputConnection(transformer->GetOutputPort());
 #endif
-                          writer->SetFileType(2);
-
-                          std::stringstream fileNameStr;
-                          fileNameStr << FileDirectoryName << "/" << FilePrefix << '_' << idx << ".vtk";
-                          writer->SetFileName(fileNameStr.str().c_str());
-                          writer->Write();
-                          newStreamline->Delete();
-                          }
-                        else
-                          {
-                          // keep the streamline in memory
-                          this->Streamlines->AddItem((vtkObject *) newStreamline);
-                          }
-                        idx++;
-                        }
-                      else
-                        {
-                        newStreamline->Delete();
-                        }
-                    }
-                }
-
-            }
+        writer->SetFileType(2);
 
+        std::stringstream fileNameStr;
+        fileNameStr << FileDirectoryName << "/" << FilePrefix << '_' << idx << ".vtk";
+        writer->SetFileName(fileNameStr.str().c_str());
+        writer->Write();
+        newStreamline->Delete();
         }
-
+      else
+        {
+        // keep the streamline in memory
+        this->Streamlines->AddItem((vtkObject *) newStreamline);
+        }
+      idx++;
+      }
+    else
+      {
+      newStreamline->Delete();
+      }
     }
-
 }
 
 
 
-
 void vtkSeedTracts::SeedStreamlinesInROIWithMultipleValues()
 {
 
@@ -1026,6 +1043,618 @@ void vtkSeedTracts::TransformStreamlinesToRASAndAppendToPolyData(vtkPolyData *ou
 }
 
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Parameters of the batched tracking, shared by all the threads.
+struct vtkSeedTractsTrackingParameters
+{
+  vtkDataArray *Tensors;
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+  double IntegrationStepLength;
+  double MaximumPropagationDistance;
+  double RadiusOfCurvature;
+  double StoppingThreshold;
+  int StoppingMode;
+  double TerminalEigenvalue;
+  int IntegrationEigenvector;
+  double MinimumPathLength;
+};
+
+//----------------------------------------------------------------------------
+struct vtkSeedTractsTrackPoint
+{
+  double X[3];
+  double W[3];
+  double V[3][3];
+  double T[3][3];
+  double D;
+  bool InField;
+};
+
+//----------------------------------------------------------------------------
+// Same as FixVectors in vtkHyperStreamlineDTMRI.cxx
+void FixTrackVectors(const double (*prev)[3], double (*current)[3],
+                     int iv, int ix, int iy)
+{
+  double p[3], v[3];
+  int vectors[3] = {iv, ix, iy};
+  if (prev == NULL) //make sure coord system is right handed
+    {
+    double v0[3], v1[3], v2[3], temp[3];
+    for (int i=0; i<3; i++)
+      {
+      v0[i] = current[i][iv];
+      v1[i] = current[i][ix];
+      v2[i] = current[i][iy];
+      }
+    vtkMath::Cross(v0,v1,temp);
+    if ( vtkMath::Dot(v2,temp) < 0.0 )
+      {
+      for (int i=0; i<3; i++)
+        {
+        current[i][iy] *= -1.0;
+        }
+      }
+    return;
+    }
+  //make sure vectors consistent from one point to the next
+  for (int n=0; n<3; n++)
+    {
+    for (int i=0; i<3; i++)
+      {
+      p[i] = prev[i][vectors[n]];
+      v[i] = current[i][vectors[n]];
+      }
+    if ( vtkMath::Dot(p,v) < 0.0 )
+      {
+      for (int i=0; i<3; i++)
+        {
+        current[i][vectors[n]] *= -1.0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void ComputeTrackEigenSystem(double m[3][3], double w[3], double v[3][3])
+{
+  double *mPtr[3] = {m[0], m[1], m[2]};
+  double *vPtr[3] = {v[0], v[1], v[2]};
+  vtkDiffusionTensorMathematics::TeemEigenSolver(mPtr, w, vPtr);
+}
+
+//----------------------------------------------------------------------------
+// Streamline integration of vtkHyperStreamlineDTMRI (RK2, both directions,
+// one trajectory per seed) specialized for image data: the tensors of the
+// current voxel are cached and interpolated trilinearly, and the streamer
+// buffers are reused from one seed to the next.
+// There is one tracker per thread, the traced fibers are appended to
+// Points and Tensors.
+class vtkSeedTractsTracker
+{
+public:
+  vtkSeedTractsTracker(const vtkSeedTractsTrackingParameters *parameters)
+    : Parameters(parameters)
+  {
+    this->CellIndex[0] = this->CellIndex[1] = this->CellIndex[2] = -1;
+  }
+
+  /// Trace the streamline started at seed (in scaled IJK of the tensor field)
+  /// and append it to Points and Tensors if it is longer than
+  /// MinimumPathLength.
+  /// Return the number of appended points.
+  vtkIdType Trace(const double seed[3]);
+
+  /// 3 coordinates per point
+  std::vector<double> Points;
+  /// 9 components per point
+  std::vector<double> Tensors;
+
+protected:
+  /// Make the voxel cell containing x the current cell and cache its
+  /// tensors. Return false if x is outside the tensor field.
+  bool FindCell(const double x[3]);
+  /// Trilinear interpolation of the tensor at x with the current cell,
+  /// x may be outside of the cell.
+  void InterpolateTensor(const double x[3], double m[3][3])const;
+  void Integrate(std::vector<vtkSeedTractsTrackPoint>& streamer, double dir);
+
+  const vtkSeedTractsTrackingParameters *Parameters;
+  int CellIndex[3];
+  double CellTensors[8][9];
+  std::vector<vtkSeedTractsTrackPoint> Streamers[2];
+};
+
+//----------------------------------------------------------------------------
+bool vtkSeedTractsTracker::FindCell(const double x[3])
+{
+  const vtkSeedTractsTrackingParameters *p = this->Parameters;
+  int cellIndex[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    double index = (x[i] - p->Origin[i]) / p->Spacing[i];
+    int maxIndex = p->Dimensions[i] - 1;
+    if (index < 0. || index > maxIndex)
+      {
+      return false;
+      }
+    cellIndex[i] = std::min(static_cast<int>(index), std::max(maxIndex - 1, 0));
+    }
+  if (cellIndex[0] == this->CellIndex[0] &&
+      cellIndex[1] == this->CellIndex[1] &&
+      cellIndex[2] == this->CellIndex[2])
+    {
+    return true;
+    }
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    // vtkVoxel point ordering
+    int pointIndex[3];
+    for (int i = 0; i < 3; ++i)
+      {
+      pointIndex[i] = std::min(cellIndex[i] + ((corner >> i) & 1), p->Dimensions[i] - 1);
+      }
+    vtkIdType pointId = pointIndex[0] +
+      p->Dimensions[0] * (pointIndex[1] + p->Dimensions[1] * pointIndex[2]);
+    p->Tensors->GetTuple(pointId, this->CellTensors[corner]);
+    }
+  this->CellIndex[0] = cellIndex[0];
+  this->CellIndex[1] = cellIndex[1];
+  this->CellIndex[2] = cellIndex[2];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkSeedTractsTracker::InterpolateTensor(const double x[3], double m[3][3])const
+{
+  const vtkSeedTractsTrackingParameters *p = this->Parameters;
+  double r[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    r[i] = (x[i] - p->Origin[i]) / p->Spacing[i] - this->CellIndex[i];
+    }
+  for (int j=0; j<3; j++)
+    {
+    for (int i=0; i<3; i++)
+      {
+      m[i][j] = 0.0;
+      }
+    }
+  for (int corner = 0; corner < 8; ++corner)
+    {
+    double weight = 1.;
+    for (int i = 0; i < 3; ++i)
+      {
+      weight *= ((corner >> i) & 1) ? r[i] : 1. - r[i];
+      }
+    const double *tensor = this->CellTensors[corner];
+    for (int j=0; j<3; j++)
+      {
+      for (int i=0; i<3; i++)
+        {
+        m[i][j] += tensor[i+3*j] * weight;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkSeedTractsTracker::Integrate(std::vector<vtkSeedTractsTrackPoint>& streamer,
+                                     double dir)
+{
+  const vtkSeedTractsTrackingParameters *p = this->Parameters;
+  const int iv = p->IntegrationEigenvector;
+  const int ix = (iv + 1) % 3;
+  const int iy = (iv + 2) % 3;
+  const double step = p->IntegrationStepLength;
+  double xNext[3], m[3][3], ev[3], v[3][3];
+  double K = 0.0;
+  bool keepIntegrating = true;
+  size_t pointCount = 0;
+
+  this->FindCell(streamer[0].X);
+  while (streamer[pointCount].InField &&
+         fabs(streamer[pointCount].W[0]) > p->TerminalEigenvalue &&
+         streamer[pointCount].D < p->MaximumPropagationDistance &&
+         keepIntegrating)
+    {
+    const vtkSeedTractsTrackPoint *sPtr = &streamer[pointCount];
+    // Test curvature, computed as in vtkHyperStreamlineDTMRI
+    if ( pointCount > 2 )
+      {
+      const double *prev = streamer[pointCount-1].X;
+      const double *prevPrev = streamer[pointCount-2].X;
+      double kv1[3], kv2[3], kl1 = 0., kl2 = 0.;
+      for (int i=0; i<3; i++)
+        {
+        kv2[i] = prevPrev[i] - prev[i];
+        kv1[i] = prev[i] - sPtr->X[i];
+        kl2 += kv2[i]*kv2[i];
+        kl1 += kv1[i]*kv1[i];
+        }
+      kl2 = sqrt(kl2);
+      kl1 = sqrt(kl1);
+      for (int i=0; i<3; i++)
+        {
+        double kn = 2*(kv2[i]/kl2 - kv1[i]/kl1)/(kl1+kl2);
+        K += kn*kn;
+        }
+      K = sqrt(K);
+      // radians per mm, compare the radius of curvature in mm
+      if (K != 0 && (1/K) < p->RadiusOfCurvature)
+        {
+        keepIntegrating = false;
+        }
+      }
+    else
+      {
+      K = 0;
+      }
+
+    // Euler step, interpolated in the current cell
+    for (int i=0; i<3; i++)
+      {
+      xNext[i] = sPtr->X[i] + dir * step * sPtr->V[i][iv];
+      }
+    this->InterpolateTensor(xNext, m);
+    ComputeTrackEigenSystem(m, ev, v);
+    FixTrackVectors(sPtr->V, v, iv, ix, iy);
+
+    // final position
+    for (int i=0; i<3; i++)
+      {
+      xNext[i] = sPtr->X[i] +
+                 dir * (step/2.0) * (sPtr->V[i][iv] + v[i][iv]);
+      }
+
+    vtkSeedTractsTrackPoint next;
+    next.InField = this->FindCell(xNext);
+    if (next.InField)
+      {
+      for (int i=0; i<3; i++)
+        {
+        next.X[i] = xNext[i];
+        }
+      this->InterpolateTensor(xNext, next.T);
+      for (int j=0; j<3; j++)
+        {
+        for (int i=0; i<3; i++)
+          {
+          m[i][j] = next.T[i][j];
+          }
+        }
+      ComputeTrackEigenSystem(m, next.W, next.V);
+      FixTrackVectors(sPtr->V, next.V, iv, ix, iy);
+
+      double stop = 0.;
+      switch (p->StoppingMode)
+        {
+        case vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY:
+          stop = vtkDiffusionTensorMathematics::FractionalAnisotropy(next.W);
+          break;
+        case vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE:
+          stop = vtkDiffusionTensorMathematics::LinearMeasure(next.W);
+          break;
+        case vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE:
+          stop = vtkDiffusionTensorMathematics::PlanarMeasure(next.W);
+          break;
+        case vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE:
+          stop = vtkDiffusionTensorMathematics::SphericalMeasure(next.W);
+          break;
+        }
+      if (stop < p->StoppingThreshold)
+        {
+        keepIntegrating = false;
+        }
+      next.D = sPtr->D + sqrt(vtkMath::Distance2BetweenPoints(sPtr->X, next.X));
+      }
+    // sPtr is invalidated
+    streamer.push_back(next);
+    ++pointCount;
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkSeedTractsTracker::Trace(const double seed[3])
+{
+  if (!this->FindCell(seed))
+    {
+    return 0;
+    }
+  const vtkSeedTractsTrackingParameters *p = this->Parameters;
+  const int iv = p->IntegrationEigenvector;
+
+  vtkSeedTractsTrackPoint start;
+  for (int i=0; i<3; i++)
+    {
+    start.X[i] = seed[i];
+    }
+  start.D = 0.;
+  start.InField = true;
+  this->InterpolateTensor(seed, start.T);
+  double m[3][3];
+  for (int j=0; j<3; j++)
+    {
+    for (int i=0; i<3; i++)
+      {
+      m[i][j] = start.T[i][j];
+      }
+    }
+  ComputeTrackEigenSystem(m, start.W, start.V);
+  FixTrackVectors(NULL, start.V, iv, (iv + 1) % 3, (iv + 2) % 3);
+
+  this->Streamers[0].clear();
+  this->Streamers[0].push_back(start);
+  this->Integrate(this->Streamers[0], 1.0);
+  this->Streamers[1].clear();
+  this->Streamers[1].push_back(start);
+  this->Integrate(this->Streamers[1], -1.0);
+
+  // Same points as vtkHyperStreamlineDTMRI::BuildLinesForSingleTrajectory:
+  // first streamer backwards without the seed, then second streamer.
+  const std::vector<vtkSeedTractsTrackPoint>& first = this->Streamers[0];
+  const std::vector<vtkSeedTractsTrackPoint>& second = this->Streamers[1];
+  vtkIdType numberOfPoints = 0;
+  for (size_t i = 1; i < first.size(); ++i)
+    {
+    numberOfPoints += first[i].InField ? 1 : 0;
+    }
+  size_t secondEnd = 0;
+  while (secondEnd < second.size() && second[secondEnd].InField)
+    {
+    ++secondEnd;
+    }
+  numberOfPoints += static_cast<vtkIdType>(secondEnd);
+
+  double length = (numberOfPoints - 1) * p->IntegrationStepLength;
+  if (length <= p->MinimumPathLength)
+    {
+    return 0;
+    }
+
+  this->Points.reserve(this->Points.size() + 3 * numberOfPoints);
+  this->Tensors.reserve(this->Tensors.size() + 9 * numberOfPoints);
+  for (size_t n = 0; n < first.size() - 1 + secondEnd; ++n)
+    {
+    const vtkSeedTractsTrackPoint& point = (n < first.size() - 1) ?
+      first[first.size() - 1 - n] : second[n - (first.size() - 1)];
+    if (!point.InField)
+      {
+      continue;
+      }
+    this->Points.insert(this->Points.end(), point.X, point.X + 3);
+    for (int row = 0; row < 3; row++)
+      {
+      this->Tensors.insert(this->Tensors.end(), point.T[row], point.T[row] + 3);
+      }
+    }
+  return numberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+struct vtkSeedTractsThreadStruct
+{
+  vtkSeedTracts *Self;
+  vtkPoints *SeedPoints;
+  std::vector<vtkSeedTractsTracker> Trackers;
+  vtkMutexLock *Lock;
+  vtkIdType NextSeed;
+  // Where the fiber of each seed is stored
+  std::vector<int> FiberTracker;
+  std::vector<vtkIdType> FiberOffset;
+  std::vector<vtkIdType> FiberNumberOfPoints;
+};
+
+//----------------------------------------------------------------------------
+// Seeds are handed out in small batches so that long fibers don't make some
+// threads wait for the others.
+const vtkIdType SEEDS_PER_BATCH = 64;
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE vtkSeedTractsThreadedTrace(void *arg)
+{
+  vtkMultiThreader::ThreadInfo* info =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vtkSeedTractsThreadStruct* str =
+    static_cast<vtkSeedTractsThreadStruct*>(info->UserData);
+  vtkSeedTractsTracker& tracker = str->Trackers[info->ThreadID];
+  const vtkIdType numberOfSeeds = str->SeedPoints->GetNumberOfPoints();
+
+  double seed[3];
+  while (true)
+    {
+    str->Lock->Lock();
+    vtkIdType begin = str->NextSeed;
+    vtkIdType end = std::min(begin + SEEDS_PER_BATCH, numberOfSeeds);
+    str->NextSeed = end;
+    str->Lock->Unlock();
+    if (begin >= end)
+      {
+      break;
+      }
+    for (vtkIdType seedId = begin; seedId < end; ++seedId)
+      {
+      str->SeedPoints->GetPoint(seedId, seed);
+      str->FiberTracker[seedId] = info->ThreadID;
+      str->FiberOffset[seedId] = static_cast<vtkIdType>(tracker.Points.size() / 3);
+      str->FiberNumberOfPoints[seedId] = tracker.Trace(seed);
+      }
+    // Only the calling thread reports progress
+    if (info->ThreadID == 0)
+      {
+      double progress = static_cast<double>(end) / numberOfSeeds;
+      str->Self->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+void vtkSeedTracts::SeedStreamlinesInROIToPolyData(vtkPolyData *outFibers)
+{
+  if (outFibers == NULL)
+    {
+    vtkErrorMacro("PolyData objects has not been allocated");
+    return;
+    }
+
+  vtkNew<vtkPoints> seedPoints;
+  if (!this->ComputeSeedPointsInROI(seedPoints.GetPointer()))
+    {
+    return;
+    }
+
+#if (VTK_MAJOR_VERSION <= 5)
+  vtkImageData* inputTensorField = this->InputTensorField;
+#else
+  this->InputTensorFieldConnection->GetProducer()->Update();
+  vtkImageData* inputTensorField = vtkImageData::SafeDownCast(this->InputTensorFieldConnection->GetProducer()->GetOutputDataObject(0));
+#endif
+  vtkDataArray *inTensors = inputTensorField->GetPointData()->GetTensors();
+  if (inTensors == NULL || inTensors->GetNumberOfComponents() != 9)
+    {
+    vtkErrorMacro("No tensor data defined!");
+    return;
+    }
+
+  // Same settings as the streamlines created by SeedStreamlinesInROI
+  vtkNew<vtkHyperStreamlineDTMRI> defaultSettings;
+  vtkHyperStreamlineDTMRI *settings = this->VtkHyperStreamlinePointsSettings ?
+    this->VtkHyperStreamlinePointsSettings : defaultSettings.GetPointer();
+
+  vtkSeedTractsTrackingParameters parameters;
+  parameters.Tensors = inTensors;
+  inputTensorField->GetDimensions(parameters.Dimensions);
+  inputTensorField->GetOrigin(parameters.Origin);
+  inputTensorField->GetSpacing(parameters.Spacing);
+  parameters.IntegrationStepLength = settings->GetIntegrationStepLength();
+  parameters.MaximumPropagationDistance = settings->GetMaximumPropagationDistance();
+  parameters.RadiusOfCurvature = settings->GetRadiusOfCurvature();
+  parameters.StoppingThreshold = settings->GetStoppingThreshold();
+  parameters.StoppingMode = settings->GetStoppingMode();
+  parameters.TerminalEigenvalue = settings->GetTerminalEigenvalue();
+  parameters.IntegrationEigenvector = settings->GetIntegrationEigenvector();
+  parameters.MinimumPathLength = this->MinimumPathLength;
+  if (parameters.StoppingMode != vtkDiffusionTensorMathematics::VTK_TENS_FRACTIONAL_ANISOTROPY &&
+      parameters.StoppingMode != vtkDiffusionTensorMathematics::VTK_TENS_LINEAR_MEASURE &&
+      parameters.StoppingMode != vtkDiffusionTensorMathematics::VTK_TENS_PLANAR_MEASURE &&
+      parameters.StoppingMode != vtkDiffusionTensorMathematics::VTK_TENS_SPHERICAL_MEASURE)
+    {
+    vtkErrorMacro("Unsupported stopping mode " << parameters.StoppingMode);
+    return;
+    }
+
+  // Trace the seeds
+  const vtkIdType numberOfSeeds = seedPoints->GetNumberOfPoints();
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(this->NumberOfThreads);
+
+  vtkNew<vtkMutexLock> lock;
+  vtkSeedTractsThreadStruct str;
+  str.Self = this;
+  str.SeedPoints = seedPoints.GetPointer();
+  str.Trackers.resize(threader->GetNumberOfThreads(),
+                      vtkSeedTractsTracker(&parameters));
+  str.Lock = lock.GetPointer();
+  str.NextSeed = 0;
+  str.FiberTracker.resize(numberOfSeeds, 0);
+  str.FiberOffset.resize(numberOfSeeds, 0);
+  str.FiberNumberOfPoints.resize(numberOfSeeds, 0);
+
+  threader->SetSingleMethod(vtkSeedTractsThreadedTrace, &str);
+  threader->SingleMethodExecute();
+
+  // Gather the fibers in seed order
+  vtkIdType numberOfPoints = 0;
+  vtkIdType numberOfFibers = 0;
+  for (vtkIdType seedId = 0; seedId < numberOfSeeds; ++seedId)
+    {
+    numberOfPoints += str.FiberNumberOfPoints[seedId];
+    numberOfFibers += str.FiberNumberOfPoints[seedId] ? 1 : 0;
+    }
+  if (numberOfFibers == 0)
+    {
+    return;
+    }
+
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkNew<vtkIdTypeArray> connectivity;
+  connectivity->SetNumberOfTuples(numberOfPoints + numberOfFibers);
+  vtkNew<vtkFloatArray> newTensors;
+  newTensors->SetNumberOfComponents(9);
+  newTensors->SetNumberOfTuples(numberOfPoints);
+
+  // Points are moved from scaled IJK to RAS and tensors are rotated
+  // (R T R') as in TransformStreamlinesToRASAndAppendToPolyData.
+  vtkNew<vtkTransform> transform;
+  transform->SetMatrix(this->WorldToTensorScaledIJK->GetMatrix());
+  transform->Inverse();
+
+  double (*matrix)[4] = this->TensorRotationMatrix->Element;
+  double matrix3x3[3][3];
+  double matrixTranspose3x3[3][3];
+  for (int row = 0; row < 3; row++)
+    {
+    for (int col = 0; col < 3; col++)
+      {
+      matrix3x3[row][col] = matrix[row][col];
+      matrixTranspose3x3[row][col] = matrix[col][row];
+      }
+    }
+
+  vtkIdType *connectivityPtr = connectivity->GetPointer(0);
+  vtkIdType ptId = 0;
+  for (vtkIdType seedId = 0; seedId < numberOfSeeds; ++seedId)
+    {
+    vtkIdType numPts = str.FiberNumberOfPoints[seedId];
+    if (numPts == 0)
+      {
+      continue;
+      }
+    const vtkSeedTractsTracker& tracker = str.Trackers[str.FiberTracker[seedId]];
+    const double *fiberPoints = &tracker.Points[3 * str.FiberOffset[seedId]];
+    const double *fiberTensors = &tracker.Tensors[9 * str.FiberOffset[seedId]];
+    *connectivityPtr++ = numPts;
+    for (vtkIdType k = 0; k < numPts; ++k, ++ptId)
+      {
+      double point[3];
+      transform->TransformPoint(fiberPoints + 3 * k, point);
+      points->SetPoint(ptId, point);
+      *connectivityPtr++ = ptId;
+
+      double tensor3x3[3][3];
+      double temp3x3[3][3];
+      for (int row = 0; row < 3; row++)
+        {
+        for (int col = 0; col < 3; col++)
+          {
+          tensor3x3[row][col] = fiberTensors[9 * k + 3 * row + col];
+          }
+        }
+      vtkMath::Multiply3x3(matrix3x3,tensor3x3,temp3x3);
+      vtkMath::Multiply3x3(temp3x3,matrixTranspose3x3,tensor3x3);
+      newTensors->SetTuple(ptId, &tensor3x3[0][0]);
+      }
+    }
+
+  vtkNew<vtkCellArray> lines;
+  lines->SetCells(numberOfFibers, connectivity.GetPointer());
+  outFibers->SetPoints(points.GetPointer());
+  outFibers->SetLines(lines.GetPointer());
+  outFibers->GetPointData()->SetTensors(newTensors.GetPointer());
+  // Remove the scalars if any, we don't need
+  // to save anything but the tensors
+  outFibers->GetPointData()->SetScalars(NULL);
+}
+
+
 // seed in each voxel in the ROI, only keep paths that intersect the
 // second ROI
 //----------------------------------------------------------------------------
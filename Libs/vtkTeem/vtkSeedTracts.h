@@ -31,6 +31,8 @@
 #include "vtkHyperStreamlineTeem.h"
 #include "vtkPreciseHyperStreamlinePoints.h"
 
+#include <vtkMultiThreader.h>
+
 #define USE_VTK_HYPERSTREAMLINE 0
 #define USE_VTK_HYPERSTREAMLINE_POINTS 1
 #define USE_VTK_PRECISE_HYPERSTREAMLINE_POINTS 2
@@ -62,6 +64,25 @@ public:
   /// that pass through ROI2.
   void SeedStreamlinesFromROIIntersectWithROI2();
 
+ /// Description
+ /// Start a streamline from each seed of SeedStreamlinesInROI and store
+ /// them directly in \a outFibers, in RAS with rotated tensors, as
+ /// TransformStreamlinesToRASAndAppendToPolyData would.
+ /// No vtkHyperStreamlineDTMRI is created: the seeds are traced in
+ /// batches by NumberOfThreads threads, each thread reusing its own tensor
+ /// interpolation cache and eigensystem buffers. Tracking parameters are
+ /// the ones of VtkHyperStreamlinePointsSettings.
+ /// Fibers are ordered by seed, the output does not depend on the number
+ /// of threads. The Streamlines collection and FileDirectoryName are not
+ /// used.
+ void SeedStreamlinesInROIToPolyData(vtkPolyData *outFibers);
+
+ /// Description
+ /// Number of threads used by SeedStreamlinesInROIToPolyData.
+ /// By default, vtkMultiThreader::GetGlobalDefaultNumberOfThreads().
+ vtkSetClampMacro(NumberOfThreads, int, 1, VTK_MAX_THREADS);
+ vtkGetMacro(NumberOfThreads, int);
+
  /// Description
  /// Store all the streamlines in one vtkPolyData and
  /// transform the points to be in RAS. It takes
@@ -310,6 +331,11 @@ protected:
 
   int PointWithinTensorData(double *point, double *pointw);
 
+  /// Compute the start points of the streamlines seeded in InputROI,
+  /// in scaled IJK coordinates of the tensor field.
+  /// Return 0 if the inputs are not valid.
+  int ComputeSeedPointsInROI(vtkPoints *seedPoints);
+
   int TypeOfHyperStreamline;
 
   char *FileDirectoryName;
@@ -320,6 +346,8 @@ protected:
 
   int UseStartingThreshold;
 
+  int NumberOfThreads;
+
   /// Here we have a representative accessible object
   /// of each type, so that the user can modify it.
   /// We copy its settings to each new created streamline.
@@ -262,6 +262,9 @@ int DoIt( int argc, char * argv[], PixelType )
     iH = 1.2;
     }
   filter->SetH( iH * sigma );
+  filter->SetUsePreSelection( iPreSelection );
+  filter->SetPreSelectionMean( iPreSelectionMean );
+  filter->SetPreSelectionVariance( iPreSelectionVariance );
   filter->Update();
 
   std::cout << "number of components per pixel" << filter->GetOutput()->GetNumberOfComponentsPerPixel() << std::endl;
@@ -0,0 +1,16 @@
+#include "itkTestMain.h"
+
+#ifdef WIN32
+#define MODULE_IMPORT __declspec(dllimport)
+#else
+#define MODULE_IMPORT
+#endif
+
+extern "C" MODULE_IMPORT int ModuleEntryPoint(int, char * []);
+int itkUNLMFilterTest(int, char * []);
+
+void RegisterTests()
+{
+  StringToTestFunctionMap["ModuleEntryPoint"] = ModuleEntryPoint;
+  StringToTestFunctionMap["itkUNLMFilterTest"] = itkUNLMFilterTest;
+}
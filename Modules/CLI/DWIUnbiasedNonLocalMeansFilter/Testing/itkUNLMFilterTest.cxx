@@ -0,0 +1,473 @@
+#include "itkUNLMFilter.h"
+
+// ITK includes
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkTimeProbe.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+
+typedef itk::VectorImage<short, 3>                     DWIImageType;
+typedef itk::VectorImage<double, 3>                    OutputImageType;
+typedef itk::UNLMFilter<DWIImageType, OutputImageType> FilterType;
+
+// Two baselines and six gradient directions, interleaved
+const unsigned int NumberOfChannels = 8;
+const unsigned int NumberOfBaselines = 2;
+const unsigned int NumberOfGradients = 6;
+const unsigned int Baselines[NumberOfBaselines] = {0, 4};
+const unsigned int DWIs[NumberOfGradients] = {1, 2, 3, 5, 6, 7};
+const double       Gradients[NumberOfGradients][3] = {
+  {1., 0., 0.}, {0., 1., 0.}, {0., 0., 1.},
+  {0.7071, 0.7071, 0.}, {0.7071, 0., 0.7071}, {0., 0.7071, 0.7071} };
+const float        Sigma = 20.f;
+const unsigned int NumberOfNeighbours = 3;
+const long         SearchRadius = 2;
+const long         ComparisonRadius = 1;
+
+//----------------------------------------------------------------------------
+// Deterministic uniform random numbers in (0, 1)
+double Uniform(unsigned long& seed)
+{
+  seed = (seed * 1103515245UL + 12345UL) & 0x7fffffffUL;
+  return (seed + 0.5) / 2147483648.;
+}
+
+//----------------------------------------------------------------------------
+// Rician corrupted DWI of two regions: diffusion along X for the low I half,
+// isotropic diffusion for the high I half
+DWIImageType::Pointer CreateDWI()
+{
+  DWIImageType::Pointer dwi = DWIImageType::New();
+  DWIImageType::SizeType size;
+  size[0] = 12;
+  size[1] = 12;
+  size[2] = 6;
+  dwi->SetRegions(size);
+  dwi->SetVectorLength(NumberOfChannels);
+  dwi->Allocate();
+
+  unsigned long seed = 12345;
+  itk::VariableLengthVector<short> value(NumberOfChannels);
+  itk::ImageRegionIteratorWithIndex<DWIImageType> it(dwi, dwi->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    DWIImageType::IndexType index = it.GetIndex();
+    const double baseline = 800. + 10. * index[2];
+    for (unsigned int c = 0; c < NumberOfChannels; ++c)
+      {
+      double signal = baseline;
+      for (unsigned int g = 0; g < NumberOfGradients; ++g)
+        {
+        if (DWIs[g] == c)
+          {
+          const double diffusion = index[0] < 6 ?
+            0.3 + 1.2 * Gradients[g][0] * Gradients[g][0] : 0.8;
+          signal = baseline * std::exp(-diffusion);
+          }
+        }
+      double noise[2];
+      for (int n = 0; n < 2; ++n)
+        {
+        const double u = Uniform(seed);
+        const double v = Uniform(seed);
+        noise[n] = Sigma * std::sqrt(-2. * std::log(u)) * std::cos(2. * 3.141592653589793 * v);
+        }
+      const double real = signal + noise[0];
+      value[c] = static_cast<short>(std::floor(std::sqrt(real * real + noise[1] * noise[1]) + 0.5));
+      }
+    it.Set(value);
+    }
+  return dwi;
+}
+
+//----------------------------------------------------------------------------
+FilterType::Pointer CreateFilter(DWIImageType* dwi, bool usePreSelection)
+{
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(dwi);
+  DWIImageType::SizeType searchRadius;
+  searchRadius.Fill(SearchRadius);
+  filter->SetRSearch(searchRadius);
+  DWIImageType::SizeType comparisonRadius;
+  comparisonRadius.Fill(ComparisonRadius);
+  filter->SetRComp(comparisonRadius);
+  FilterType::IndicatorType dwiIndicator(NumberOfGradients);
+  for (unsigned int g = 0; g < NumberOfGradients; ++g)
+    {
+    FilterType::GradientType gradient;
+    gradient[0] = Gradients[g][0];
+    gradient[1] = Gradients[g][1];
+    gradient[2] = Gradients[g][2];
+    filter->AddGradientDirection(gradient);
+    dwiIndicator[g] = DWIs[g];
+    }
+  FilterType::IndicatorType baselineIndicator(NumberOfBaselines);
+  for (unsigned int b = 0; b < NumberOfBaselines; ++b)
+    {
+    baselineIndicator[b] = Baselines[b];
+    }
+  filter->SetNDWI(NumberOfGradients);
+  filter->SetNBaselines(NumberOfBaselines);
+  filter->SetDWI(dwiIndicator);
+  filter->SetBaselines(baselineIndicator);
+  filter->SetNeighbours(NumberOfNeighbours);
+  filter->SetSigma(Sigma);
+  filter->SetH(1.2f * Sigma);
+  filter->SetUsePreSelection(usePreSelection);
+  return filter;
+}
+
+//----------------------------------------------------------------------------
+// Exact UNLM, transcribed from the channel by channel implementation of the
+// filter, with the same floating point operations in the same order.
+std::vector<double> ComputeReference(DWIImageType* dwi)
+{
+  const long size[3] = {
+    static_cast<long>(dwi->GetLargestPossibleRegion().GetSize(0)),
+    static_cast<long>(dwi->GetLargestPossibleRegion().GetSize(1)),
+    static_cast<long>(dwi->GetLargestPossibleRegion().GetSize(2)) };
+  const short* buffer = dwi->GetBufferPointer();
+
+  // Closest gradient directions to each one
+  unsigned int neighboursInd[NumberOfGradients][NumberOfNeighbours];
+  for (unsigned int g = 0; g < NumberOfGradients; ++g)
+    {
+    std::vector<itk::OrderType> distances;
+    itk::OrderType              orderElement;
+    for (unsigned int k = 0; k < NumberOfGradients; ++k)
+      {
+      orderElement[0] = (double)k;
+      orderElement[1] = 0.;
+      for (unsigned int d = 0; d < 3; ++d)
+        {
+        orderElement[1] += (Gradients[g][d] * Gradients[k][d]);
+        }
+      if (orderElement[1] < -1.0f || orderElement[1] > 1.0f)
+        {
+        orderElement[1] = 0.0f;
+        }
+      else
+        {
+        orderElement[1] = ::acos(orderElement[1]);
+        }
+      if (3.141592654f - orderElement[1] < orderElement[1])
+        {
+        orderElement[1] = 3.141592654f - orderElement[1];
+        }
+      distances.push_back(orderElement);
+      }
+    std::sort(distances.begin(), distances.end(), itk::UNLM_gradientDistance_smaller);
+    for (unsigned int k = 0; k < NumberOfNeighbours; ++k)
+      {
+      neighboursInd[g][k] = DWIs[(unsigned int)(distances[k][0])];
+      }
+    }
+
+  // Gaussian window, in neighborhood iterator order
+  const long   patchWidth = 2 * ComparisonRadius + 1;
+  const long   neighborhoodSize = patchWidth * patchWidth * patchWidth;
+  std::vector<long> patchOffsets(3 * neighborhoodSize);
+  std::vector<float> gw(neighborhoodSize);
+  float sum = 0.f;
+  for (long k = 0; k < neighborhoodSize; ++k)
+    {
+    long* offset = &patchOffsets[3 * k];
+    offset[0] = k % patchWidth - ComparisonRadius;
+    offset[1] = (k / patchWidth) % patchWidth - ComparisonRadius;
+    offset[2] = k / (patchWidth * patchWidth) - ComparisonRadius;
+    if (k != neighborhoodSize / 2)
+      {
+      gw[k] = 0.f;
+      for (unsigned int d = 0; d < 3; ++d)
+        {
+        gw[k] += static_cast<float>(offset[d] * offset[d]);
+        }
+      gw[k] = ::exp(-gw[k] / 2);
+      }
+    else
+      {
+      gw[k] = gw[k - 1];
+      }
+    sum += gw[k];
+    }
+  for (long k = 0; k < neighborhoodSize; ++k)
+    {
+    gw[k] /= sum;
+    }
+
+  // Channel c of the pixel at position + patch offset k, with Neumann
+  // boundary conditions
+  struct Sampler
+  {
+    const short* Buffer;
+    const long*  Size;
+    const long*  Offsets;
+    short operator()(const long* position, long k, unsigned int c) const
+    {
+      long index = 0;
+      for (int d = 2; d >= 0; --d)
+        {
+        const long p = std::min(std::max(position[d] + this->Offsets[3 * k + d], 0L), this->Size[d] - 1);
+        index = index * this->Size[d] + p;
+        }
+      return this->Buffer[index * NumberOfChannels + c];
+    }
+  };
+  Sampler sample;
+  sample.Buffer = buffer;
+  sample.Size = size;
+  sample.Offsets = &patchOffsets[0];
+
+  const long   searchWidth = 2 * SearchRadius + 1;
+  const long   numNeighbours = searchWidth * searchWidth * searchWidth;
+  const float  sqh = 1.0f / ((1.2f * Sigma) * (1.2f * Sigma));
+  std::vector<float> distB(numNeighbours);
+  std::vector<float> valsB(numNeighbours);
+  std::vector<float> distD(numNeighbours * NumberOfNeighbours);
+  std::vector<float> valsD(numNeighbours * NumberOfNeighbours);
+  std::vector<double> output(size[0] * size[1] * size[2] * NumberOfChannels);
+  long voxel[3];
+  for (voxel[2] = 0; voxel[2] < size[2]; ++voxel[2])
+    {
+    for (voxel[1] = 0; voxel[1] < size[1]; ++voxel[1])
+      {
+      for (voxel[0] = 0; voxel[0] < size[0]; ++voxel[0])
+        {
+        // Search region, cropped as the filter does
+        long originR[3];
+        long searchSize[3];
+        bool needToComputeCenter = false;
+        for (int d = 0; d < 3; ++d)
+          {
+          originR[d] = voxel[d] - SearchRadius;
+          searchSize[d] = searchWidth;
+          if (originR[d] < 0)
+            {
+            originR[d] = 0;
+            needToComputeCenter = true;
+            }
+          if (originR[d] + searchSize[d] >= size[d])
+            {
+            searchSize[d] = size[d] - originR[d];
+            needToComputeCenter = true;
+            }
+          }
+        unsigned int midPosition = numNeighbours / 2;
+        if (needToComputeCenter)
+          {
+          midPosition = (voxel[0] - originR[0]) + searchSize[0] *
+            ((voxel[1] - originR[1]) + searchSize[1] * (voxel[2] - originR[2]));
+          }
+        std::vector<long> candidates;
+        long candidate[3];
+        for (candidate[2] = originR[2]; candidate[2] < originR[2] + searchSize[2]; ++candidate[2])
+          {
+          for (candidate[1] = originR[1]; candidate[1] < originR[1] + searchSize[1]; ++candidate[1])
+            {
+            for (candidate[0] = originR[0]; candidate[0] < originR[0] + searchSize[0]; ++candidate[0])
+              {
+              candidates.insert(candidates.end(), candidate, candidate + 3);
+              }
+            }
+          }
+        const unsigned int numberOfCandidates = static_cast<unsigned int>(candidates.size() / 3);
+        const long centerK = neighborhoodSize / 2;
+        double* op = &output[((voxel[2] * size[1] + voxel[1]) * size[0] + voxel[0]) * NumberOfChannels];
+        for (unsigned int c = 0; c < NumberOfChannels; ++c)
+          {
+          op[c] = sample(voxel, centerK, c);
+          }
+
+        // Baselines
+        for (unsigned int j = 0; j < NumberOfBaselines; ++j)
+          {
+          const unsigned int channel = Baselines[j];
+          float norm = 0.0f;
+          float max = -100;
+          unsigned int pos;
+          for (pos = 0; pos < numberOfCandidates; ++pos)
+            {
+            const long* position = &candidates[3 * pos];
+            if (pos != midPosition)
+              {
+              distB[pos] = 0.f;
+              for (long k = 0; k < neighborhoodSize; ++k)
+                {
+                float aux = sample(voxel, k, channel) - sample(position, k, channel);
+                distB[pos] += gw[k] * aux * aux;
+                }
+              distB[pos] = exp(-distB[pos] * sqh * 0.0625);
+              norm += distB[pos];
+              if (distB[pos] > max)
+                {
+                max = distB[pos];
+                }
+              }
+            valsB[pos] = sample(position, centerK, channel) * sample(position, centerK, channel);
+            }
+          if (max > 1e-6)
+            {
+            distB[midPosition] = max;
+            norm = 1.0f / (max + norm);
+            }
+          else
+            {
+            distB[midPosition] = 1.0f;
+            norm = 1.0f / (1.0f + norm);
+            }
+          float value = 0.f;
+          for (unsigned int k = 0; k < pos; ++k)
+            {
+            value += distB[k] * valsB[k] * norm;
+            }
+          value -= 2.0f * Sigma * Sigma;
+          value = (value > 1e-10 ? ::sqrt(value) : 0.f);
+          op[channel] = static_cast<double>(value);
+          }
+
+        // Gradient images
+        for (unsigned int j = 0; j < NumberOfGradients; ++j)
+          {
+          const unsigned int channel = DWIs[j];
+          float norm = 0.0f;
+          float max = -100;
+          unsigned int pos;
+          for (pos = 0; pos < numberOfCandidates; ++pos)
+            {
+            const long* position = &candidates[3 * pos];
+            if (pos != midPosition)
+              {
+              distD[pos] = 0.f;
+              for (long k = 0; k < neighborhoodSize; ++k)
+                {
+                float aux = sample(voxel, k, channel) - sample(position, k, channel);
+                distD[pos] += gw[k] * aux * aux;
+                }
+              distD[pos] = exp(-distD[pos] * sqh);
+              norm += distD[pos];
+              if (distD[pos] > max)
+                {
+                max = distD[pos];
+                }
+              }
+            valsD[pos] = sample(position, centerK, channel) * sample(position, centerK, channel);
+            for (unsigned int g = 1; g < NumberOfNeighbours; ++g)
+              {
+              const unsigned int neighbour = neighboursInd[j][g];
+              float& d = distD[pos + g * numNeighbours];
+              d = 0.f;
+              for (long k = 0; k < neighborhoodSize; ++k)
+                {
+                float aux = sample(voxel, k, channel) - sample(position, k, neighbour);
+                d += gw[k] * aux * aux;
+                }
+              d = exp(-d * sqh);
+              norm += d;
+              if (d > max)
+                {
+                max = d;
+                }
+              valsD[pos + g * numNeighbours] =
+                sample(position, centerK, neighbour) * sample(position, centerK, neighbour);
+              }
+            }
+          if (max > 1e-6)
+            {
+            distD[midPosition] = max;
+            norm = 1.0f / (max + norm);
+            }
+          else
+            {
+            distD[midPosition] = 1;
+            norm = 1.0f / (1 + norm);
+            }
+          float value = 0.f;
+          for (unsigned int k = 0; k < pos; ++k)
+            {
+            for (unsigned int l = 0; l < NumberOfNeighbours; ++l)
+              {
+              value += distD[k + l * numNeighbours] * valsD[k + l * numNeighbours] * norm;
+              }
+            }
+          value -= 2.0f * Sigma * Sigma;
+          value = (value > 1e-10 ? ::sqrt(value) : 0.f);
+          op[channel] = static_cast<double>(value);
+          }
+        }
+      }
+    }
+  return output;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int itkUNLMFilterTest(int, char * [])
+{
+  DWIImageType::Pointer dwi = CreateDWI();
+  std::vector<double> reference = ComputeReference(dwi);
+
+  // Without pre-selection, the filter computes the exact UNLM
+  itk::TimeProbe exactProbe;
+  exactProbe.Start();
+  FilterType::Pointer exactFilter = CreateFilter(dwi, false);
+  exactFilter->Update();
+  exactProbe.Stop();
+  const double* exact = exactFilter->GetOutput()->GetBufferPointer();
+  const size_t numberOfValues = reference.size();
+  size_t numberOfDifferences = 0;
+  for (size_t i = 0; i < numberOfValues; ++i)
+    {
+    if (exact[i] != reference[i])
+      {
+      ++numberOfDifferences;
+      }
+    }
+  if (numberOfDifferences > 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << numberOfDifferences << " of "
+              << numberOfValues << " values differ from the exact UNLM" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // With pre-selection, the dissimilar patches are skipped: the output is
+  // close to the exact UNLM, much closer than the input is
+  itk::TimeProbe preSelectionProbe;
+  preSelectionProbe.Start();
+  FilterType::Pointer preSelectionFilter = CreateFilter(dwi, true);
+  preSelectionFilter->Update();
+  preSelectionProbe.Stop();
+  const double* preSelected = preSelectionFilter->GetOutput()->GetBufferPointer();
+  const short*  input = dwi->GetBufferPointer();
+  double signal = 0.;
+  double preSelectionDifference = 0.;
+  double filteringDifference = 0.;
+  for (size_t i = 0; i < numberOfValues; ++i)
+    {
+    signal += reference[i];
+    preSelectionDifference += std::fabs(preSelected[i] - reference[i]);
+    filteringDifference += std::fabs(input[i] - reference[i]);
+    }
+  if (preSelectionDifference > 0.01 * signal ||
+      preSelectionDifference > 0.25 * filteringDifference)
+    {
+    std::cerr << "Line " << __LINE__ << ": pre-selection output too far from the exact UNLM: "
+              << "mean difference " << preSelectionDifference / numberOfValues
+              << ", mean filtering change " << filteringDifference / numberOfValues
+              << ", mean signal " << signal / numberOfValues << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "<DartMeasurement name=\"ExactTime\" type=\"numeric/double\">"
+            << exactProbe.GetTotal() << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"PreSelectionTime\" type=\"numeric/double\">"
+            << preSelectionProbe.GetTotal() << "</DartMeasurement>" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -33,7 +33,7 @@ namespace itk
 // in an ascending order with respect to the angular distance
 typedef itk::FixedArray<double, 2> OrderType;
 // To use with the sort method of std::vector
-bool UNLM_gradientDistance_smaller( OrderType e1, OrderType e2 )
+inline bool UNLM_gradientDistance_smaller( OrderType e1, OrderType e2 )
 {
   return e1[1] < e2[1];
 }
@@ -78,6 +78,7 @@ public:
   typedef typename InputImageType::IndexType   InputImageIndexType;
   typedef typename OutputImageType::RegionType OutputImageRegionType;
   typedef typename OutputPixelType::ValueType  ScalarType;
+  typedef typename InputPixelType::ValueType   InputScalarType;
 
   /** Typedefs for matrix computations; we have a variable number of gradients,
     * so we do need growing arrays; but gradients are always represented by
@@ -109,6 +110,19 @@ public:
   itkSetMacro( RComp,      InputImageSizeType );
   itkGetMacro( RComp,      InputImageSizeType );
 
+  /** Patch pre-selection: the distance between two patches is computed only
+   *  if the ratios of their local means and of their local variances lie in
+   *  [PreSelectionMean, 1/PreSelectionMean] and
+   *  [PreSelectionVariance, 1/PreSelectionVariance]; otherwise the patch gets
+   *  a null weight. Off by default, the output is then the exact UNLM. */
+  itkSetMacro( UsePreSelection, bool );
+  itkGetMacro( UsePreSelection, bool );
+  itkBooleanMacro( UsePreSelection );
+  itkSetMacro( PreSelectionMean,     float );
+  itkGetMacro( PreSelectionMean,     float );
+  itkSetMacro( PreSelectionVariance, float );
+  itkGetMacro( PreSelectionVariance, float );
+
   /** Add a new gradient direction: */
   void AddGradientDirection( GradientType grad )
   {
@@ -165,8 +179,19 @@ protected:
 
   void BeforeThreadedGenerateData();
 
+  void AfterThreadedGenerateData();
+
   void GenerateInputRequestedRegion();
 
+  // Compute the mean and variance of each channel over the comparison
+  // neighbourhood of every voxel of the input buffer
+  void ComputeLocalStatistics();
+
+  // Whether the patches centered at the given buffer offsets pass the
+  // pre-selection test for the given channels
+  bool IsPreSelected( OffsetValueType center, unsigned int centerChannel,
+                      OffsetValueType candidate, unsigned int candidateChannel ) const;
+
 private:
   UNLMFilter(const Self &);        // purposely not implemented
   void operator=(const Self &);    // purposely not implemented
@@ -189,6 +214,14 @@ private:
   float              m_H;
   InputImageSizeType m_RSearch;
   InputImageSizeType m_RComp;
+  // Patch pre-selection:
+  bool  m_UsePreSelection;
+  float m_PreSelectionMean;
+  float m_PreSelectionVariance;
+  // Local statistics of the input buffer, channels contiguous for each voxel
+  unsigned int       m_Channels;
+  std::vector<float> m_LocalMean;
+  std::vector<float> m_LocalVariance;
 };
 
 } // end namespace itk
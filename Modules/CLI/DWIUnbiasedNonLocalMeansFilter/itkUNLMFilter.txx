@@ -19,10 +19,12 @@
 #include "itkUNLMFilter.h"
 
 #include "itkConstNeighborhoodIterator.h"
+#include "itkImageRegionConstIterator.h"
 #include "itkImageRegionIterator.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkZeroFluxNeumannBoundaryCondition.h"
 #include "math.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -41,6 +43,10 @@ UNLMFilter<TInputImage, TOutputImage>
   m_H             = 1.0f;
   m_RSearch.Fill(3);
   m_RComp.Fill(1);
+  m_UsePreSelection      = false;
+  m_PreSelectionMean     = 0.95f;
+  m_PreSelectionVariance = 0.5f;
+  m_Channels             = 0;
 }
 
 template <class TInputImage, class TOutputImage>
@@ -95,6 +101,16 @@ void UNLMFilter<TInputImage, TOutputImage>
       m_NeighboursInd[g][k] = m_DWI[(unsigned int)(distances[k][0])];
       }
     }
+  // Local statistics for the pre-selection of the patches
+  if( m_UsePreSelection )
+    {
+    if( m_PreSelectionMean <= 0.0f || m_PreSelectionMean > 1.0f ||
+        m_PreSelectionVariance <= 0.0f || m_PreSelectionVariance > 1.0f )
+      {
+      itkExceptionMacro( << "Pre-selection thresholds must be in (0,1]" );
+      }
+    this->ComputeLocalStatistics();
+    }
   return;
 }
 
@@ -200,14 +216,29 @@ void UNLMFilter<TInputImage, TOutputImage>
     {
     gw[k] /= sum;
     }
+  // The patch around the voxel being filtered and the patch around each
+  // candidate voxel, with the channels of a pixel stored contiguously:
+  const unsigned int           channels = input->GetNumberOfComponentsPerPixel();
+  const unsigned int           center = neighborhoodSize / 2;
+  std::vector<InputScalarType> centerPatch( neighborhoodSize * channels );
+  std::vector<InputScalarType> searchPatch( neighborhoodSize * channels );
+  // The patch distances of all the channels at once:
+  std::vector<float> dist( channels );
+  // Whether each comparison passes the pre-selection:
+  std::vector<bool> selectedB( m_NBaselines );
+  std::vector<bool> selectedD( m_NDWI * m_Neighbours );
   // Auxiliar variables:
   float  norm;
   float  max;
   float  sqh = 1.0f / (m_H * m_H);
-  float* distB = new float[numNeighbours];
-  float* distD = new float[numNeighbours * m_Neighbours];
-  float* valsB = new float[numNeighbours];
-  float* valsD = new float[numNeighbours * m_Neighbours];
+  float* distB = new float[numNeighbours * m_NBaselines];
+  float* distD = new float[numNeighbours * m_Neighbours * m_NDWI];
+  float* valsB = new float[numNeighbours * m_NBaselines];
+  float* valsD = new float[numNeighbours * m_Neighbours * m_NDWI];
+  float* normB = new float[m_NBaselines];
+  float* maxB  = new float[m_NBaselines];
+  float* normD = new float[m_NDWI];
+  float* maxD  = new float[m_NDWI];
   for( fit = faceList.begin(); fit != faceList.end(); ++fit )  // Iterate through facets
     { // Iterators:
     InputImageSizeType radius = m_RComp;
@@ -264,49 +295,181 @@ void UNLMFilter<TInputImage, TOutputImage>
       searchRegion.SetIndex( originR );
       searchRegion.SetSize( searchSize );
       search = ConstNeighborhoodIterator<InputImageType>(  radius, input, searchRegion  );
+      // ---------------------
+      // Read the patch to filter once for all the channels:
+      for( unsigned int k = 0; k < neighborhoodSize; ++k )
+        {
+        const InputPixelType & pixel = bit.GetPixel(k);
+        for( unsigned int c = 0; c < channels; ++c )
+          {
+          centerPatch[k * channels + c] = pixel[c];
+          }
+        }
+      OffsetValueType centerOffset = 0;
+      if( m_UsePreSelection )
+        {
+        centerOffset = input->ComputeOffset( bit.GetIndex() );
+        }
+      for( unsigned int j = 0; j < m_NBaselines; ++j )
+        {
+        normB[j] = 0.0f;  // To normalize the weights to sum to 1
+        maxB[j]  = -100;  // To avoid over-weighting of the central value
+        }
+      for( unsigned int j = 0; j < m_NDWI; ++j )
+        {
+        normD[j] = 0.0f;
+        maxD[j]  = -100;
+        }
       // -------------------------------------------------------------------------------------------------------------
-      // FILTER THE BASELINES
-      for( unsigned int j = 0; j < m_NBaselines; ++j )  // For each baseline
+      // COMPARE WITH EACH PIXEL IN THE SEARCH NEIGHBOURHOOD
+      unsigned int pos;
+      for( pos = 0, search.GoToBegin(); !search.IsAtEnd(); ++search, ++pos )
         {
-        norm = 0.0f;                                                           // To normalize the weights to sum to 1
-        max  = -100;                                                           // To avoid over-weighting of the central
-                                                                               // value
-        unsigned int pos;                                                      // Auxiliar variable
-        for( pos = 0, search.GoToBegin(); !search.IsAtEnd(); ++search, ++pos ) // For each pixel in the search
-                                                                               // neighbourhood
+        for( unsigned int k = 0; k < neighborhoodSize; ++k )
+          {
+          const InputPixelType & pixel = search.GetPixel(k);
+          for( unsigned int c = 0; c < channels; ++c )
+            {
+            searchPatch[k * channels + c] = pixel[c];
+            }
+          }
+        const InputScalarType* candidate = &searchPatch[center * channels];
+        OffsetValueType        candidateOffset = 0;
+        if( m_UsePreSelection )
+          {
+          candidateOffset = input->ComputeOffset( search.GetIndex() );
+          }
+        // ---------------------
+        // Pre-selection of the comparisons between the same channels:
+        bool anySelected = false;
+        if( pos != midPosition )
+          {
+          for( unsigned int j = 0; j < m_NBaselines; ++j )
+            {
+            selectedB[j] = !m_UsePreSelection
+              || this->IsPreSelected( centerOffset, m_Baselines[j], candidateOffset, m_Baselines[j] );
+            anySelected = anySelected || selectedB[j];
+            }
+          for( unsigned int j = 0; j < m_NDWI; ++j )
+            {
+            selectedD[j * m_Neighbours] = !m_UsePreSelection
+              || this->IsPreSelected( centerOffset, m_DWI[j], candidateOffset, m_DWI[j] );
+            anySelected = anySelected || selectedD[j * m_Neighbours];
+            }
+          }
+        // Patch distances of all the channels at once; for each channel the
+        // sum is accumulated in the same order as a channel by channel loop
+        if( anySelected )
+          {
+          std::fill( dist.begin(), dist.end(), itk::NumericTraits<float>::ZeroValue() );
+          for( unsigned int k = 0; k < neighborhoodSize; ++k )  // For each pixel in the comparison neighbourhood
+            {
+            const float            w = gw[k];
+            const InputScalarType* a = &centerPatch[k * channels];
+            const InputScalarType* b = &searchPatch[k * channels];
+            for( unsigned int c = 0; c < channels; ++c )
+              {
+              float aux = a[c] - b[c];
+              dist[c] += w * aux * aux;
+              }
+            }
+          }
+        // ---------------------
+        // FILTER THE BASELINES
+        for( unsigned int j = 0; j < m_NBaselines; ++j )  // For each baseline
           {
+          const unsigned int channel = m_Baselines[j];
+          float*             jDistB = distB + j * numNeighbours;
+          if( pos != midPosition )
+            {
+            if( selectedB[j] )
+              {
+              // Temporal patch:
+              jDistB[pos]  = exp( -dist[channel] * sqh * 0.0625 );
+              normB[j]    += jDistB[pos];
+              if( jDistB[pos] > maxB[j] )
+                {
+                maxB[j] = jDistB[pos];
+                }
+              }
+            else
+              {
+              jDistB[pos] = itk::NumericTraits<float>::ZeroValue();
+              }
+            }
+          valsB[j * numNeighbours + pos] = candidate[channel] * candidate[channel];
+          }
+        // ---------------------
+        // FILTER THE GRADIENT IMAGES
+        for( unsigned int j = 0; j < m_NDWI; ++j )  // For each gradient image
+          { // First, we process the gradients in the same direction as the one being processed:
+          const unsigned int channel = m_DWI[j];
+          float*             jDistD = distD + j * m_Neighbours * numNeighbours;
+          float*             jValsD = valsD + j * m_Neighbours * numNeighbours;
           if( pos != midPosition )
             {
-            distB[pos] = itk::NumericTraits<float>::ZeroValue();
-            for( unsigned int k = 0; k < neighborhoodSize; ++k )  // For each pixel in the comparison neighbourhood
+            if( selectedD[j * m_Neighbours] )
               {
-              float aux   = bit.GetPixel(k)[m_Baselines[j]] - search.GetPixel(k)[m_Baselines[j]];
-              distB[pos] += gw[k] * aux * aux;
+              jDistD[pos]  = exp( -dist[channel] * sqh );
+              normD[j]    += jDistD[pos];
+              if( jDistD[pos] > maxD[j] )
+                {
+                maxD[j] = jDistD[pos];
+                }
               }
-            // Temporal patch:
-            distB[pos]  = exp( -distB[pos] * sqh * 0.0625 );
-            norm       += distB[pos];
-            if( distB[pos] > max )
+            else
               {
-              max = distB[pos];
+              jDistD[pos] = itk::NumericTraits<float>::ZeroValue();
               }
             }
-          valsB[pos] = search.GetCenterPixel()[m_Baselines[j]] * search.GetCenterPixel()[m_Baselines[j]];
+          jValsD[pos] = candidate[channel] * candidate[channel];
+          // Now, we may process the gradient directions similar to the direction under study
+          for( unsigned int g = 1; g < m_Neighbours; ++g )
+            {
+            const unsigned int neighbour = m_NeighboursInd[j][g];
+            float &            d = jDistD[pos + g * numNeighbours];
+            d = itk::NumericTraits<float>::ZeroValue();
+            if( !m_UsePreSelection
+                || this->IsPreSelected( centerOffset, channel, candidateOffset, neighbour ) )
+              {
+              for( unsigned int k = 0; k < neighborhoodSize; ++k )  // For each pixel in the comparison neighbourhood
+                {
+                float aux = centerPatch[k * channels + channel] - searchPatch[k * channels + neighbour];
+                d += gw[k] * aux * aux;
+                }
+              d         = exp( -d * sqh );
+              normD[j] += d;
+              if( d > maxD[j] )
+                {
+                maxD[j] = d;
+                }
+              }
+            jValsD[pos + g * numNeighbours] = candidate[neighbour] * candidate[neighbour];
+            }
           }
+        }
+      // -------------------------------------------------------------------------------------------------------------
+      // WEIGHTED AVERAGES OF THE BASELINES
+      for( unsigned int j = 0; j < m_NBaselines; ++j )
+        {
+        float* jDistB = distB + j * numNeighbours;
+        float* jValsB = valsB + j * numNeighbours;
+        norm = normB[j];
+        max  = maxB[j];
         if( max > 1e-6 )
           {
-          distB[midPosition] = max;
+          jDistB[midPosition] = max;
           norm = 1.0f / (max + norm);
           }
         else
           {
-          distB[midPosition] = 1.0f;
+          jDistB[midPosition] = 1.0f;
           norm = 1.0f / (1.0f + norm);
           }
         float value = itk::NumericTraits<float>::ZeroValue();
         for( unsigned int k = 0; k < pos; ++k )
           {
-          value += distB[k] * valsB[k] * norm;
+          value += jDistB[k] * jValsB[k] * norm;
           }
         // Remove Rician bias:
         value -= 2.0f * m_Sigma * m_Sigma;
@@ -314,59 +477,21 @@ void UNLMFilter<TInputImage, TOutputImage>
         op[m_Baselines[j]] = static_cast<ScalarType>(value);
         }
       // -------------------------------------------------------------------------------------------------------------
-      // FILTER THE GRADIENT IMAGES
-      for( unsigned int j = 0; j < m_NDWI; ++j )  // For each gradient image
+      // WEIGHTED AVERAGES OF THE GRADIENT IMAGES
+      for( unsigned int j = 0; j < m_NDWI; ++j )
         {
-        norm = 0.0f;
-        max  = -100;
-        unsigned int pos;
-        for( pos = 0, search.GoToBegin(); !search.IsAtEnd(); ++search, ++pos )  // For each pixel in the search
-                                                                                // neighbourhood
-          { // First, we process the gradients in the same direction as the one being processed:
-          if( pos != midPosition )
-            {
-            distD[pos] = itk::NumericTraits<float>::ZeroValue();
-            for( unsigned int k = 0; k < neighborhoodSize; ++k )  // For each pixel in the comparison neighbourhood
-              {
-              float aux = bit.GetPixel(k)[m_DWI[j]] - search.GetPixel(k)[m_DWI[j]];
-              distD[pos] += gw[k] * aux * aux;
-              }
-            distD[pos]  = exp( -distD[pos] * sqh );
-            norm       += distD[pos];
-            if( distD[pos] > max )
-              {
-              max = distD[pos];
-              }
-            }
-          valsD[pos] = search.GetCenterPixel()[m_DWI[j]] * search.GetCenterPixel()[m_DWI[j]];
-          // Now, we may process the gradient directions similar to the direction under study
-          for( unsigned int g = 1; g < m_Neighbours; ++g )
-            {
-            distD[pos + g * numNeighbours] = itk::NumericTraits<float>::ZeroValue();
-            for( unsigned int k = 0; k < neighborhoodSize; ++k )  // For each pixel in the comparison neighbourhood
-              {
-              float aux = bit.GetPixel(k)[m_DWI[j]] - search.GetPixel(k)[m_NeighboursInd[j][g]];
-              distD[pos + g * numNeighbours] += gw[k] * aux * aux;
-              }
-            distD[pos + g * numNeighbours]  = exp( -distD[pos + g * numNeighbours] * sqh );
-            norm                       += distD[pos + g * numNeighbours];
-            if( distD[pos + g * numNeighbours] > max )
-              {
-              max = distD[pos + g * numNeighbours];
-              }
-            valsD[pos + g
-                  * numNeighbours] = search.GetCenterPixel()[m_NeighboursInd[j][g]]
-              * search.GetCenterPixel()[m_NeighboursInd[j][g]];
-            }
-          }
+        float* jDistD = distD + j * m_Neighbours * numNeighbours;
+        float* jValsD = valsD + j * m_Neighbours * numNeighbours;
+        norm = normD[j];
+        max  = maxD[j];
         if( max > 1e-6 )
           {
-          distD[midPosition] = max;
+          jDistD[midPosition] = max;
           norm = 1.0f / (max + norm);
           }
         else
           {
-          distD[midPosition] = 1;
+          jDistD[midPosition] = 1;
           norm = 1.0f / (1 + norm);
           }
         float value = itk::NumericTraits<float>::ZeroValue();
@@ -374,13 +499,13 @@ void UNLMFilter<TInputImage, TOutputImage>
           {
           for( unsigned int l = 0; l < m_Neighbours; ++l )
             {
-            value += distD[k + l * numNeighbours] * valsD[k + l * numNeighbours] * norm;
+            value += jDistD[k + l * numNeighbours] * jValsD[k + l * numNeighbours] * norm;
             }
           }
         // Remove Rician bias:
         value -= 2.0f * m_Sigma * m_Sigma;
         value = ( value > 1e-10 ? ::sqrt(value) : itk::NumericTraits<float>::ZeroValue() );
-        op[m_DWI[j]] = static_cast<ScalarType>(value);;
+        op[m_DWI[j]] = static_cast<ScalarType>(value);
         }
       // -------------------------------------------------------------------------------------------------------------
       // Set the output pixel
@@ -393,6 +518,107 @@ void UNLMFilter<TInputImage, TOutputImage>
   delete[] distD;
   delete[] valsB;
   delete[] valsD;
+  delete[] normB;
+  delete[] maxB;
+  delete[] normD;
+  delete[] maxD;
+}
+
+template <class TInputImage, class TOutputImage>
+void UNLMFilter<TInputImage, TOutputImage>
+::AfterThreadedGenerateData( void )
+{
+  // Release the local statistics
+  std::vector<float>().swap( m_LocalMean );
+  std::vector<float>().swap( m_LocalVariance );
+}
+
+template <class TInputImage, class TOutputImage>
+void UNLMFilter<TInputImage, TOutputImage>
+::ComputeLocalStatistics( void )
+{
+  InputImageConstPointer     input  = this->GetInput();
+  const InputImageRegionType region = input->GetBufferedRegion();
+  m_Channels             = input->GetNumberOfComponentsPerPixel();
+  const SizeValueType numberOfValues = region.GetNumberOfPixels() * m_Channels;
+  m_LocalMean.resize( numberOfValues );
+  m_LocalVariance.resize( numberOfValues );
+  // Values and squared values:
+  SizeValueType                            v = 0;
+  ImageRegionConstIterator<InputImageType> iit( input, region );
+  for( iit.GoToBegin(); !iit.IsAtEnd(); ++iit )
+    {
+    const InputPixelType & pixel = iit.Get();
+    for( unsigned int c = 0; c < m_Channels; ++c, ++v )
+      {
+      const float value = static_cast<float>( pixel[c] );
+      m_LocalMean[v]     = value;
+      m_LocalVariance[v] = value * value;
+      }
+    }
+  // Separable box sums over the comparison neighbourhood; the neighbourhood
+  // is clamped at the buffer boundaries, as the Neumann condition does for
+  // the patches:
+  std::vector<float>* sums[2] = { &m_LocalMean, &m_LocalVariance };
+  std::vector<float>  block;
+  SizeValueType       stride = m_Channels; // Distance between two neighbours along d
+  float               count = 1.0f;
+  for( unsigned int d = 0; d < TInputImage::ImageDimension; ++d )
+    {
+    const long          size = static_cast<long>( region.GetSize()[d] );
+    const long          radius = static_cast<long>( m_RComp[d] );
+    const SizeValueType blockSize = stride * size;
+    count *= static_cast<float>( 2 * radius + 1 );
+    if( radius > 0 )
+      {
+      block.resize( blockSize );
+      for( unsigned int s = 0; s < 2; ++s )
+        {
+        for( SizeValueType start = 0; start < numberOfValues; start += blockSize )
+          {
+          float* values = &(*sums[s])[start];
+          std::copy( values, values + blockSize, block.begin() );
+          std::fill( values, values + blockSize, itk::NumericTraits<float>::ZeroValue() );
+          for( long x = 0; x < size; ++x )
+            {
+            for( long r = -radius; r <= radius; ++r )
+              {
+              const long     xr = std::min( std::max( x + r, 0L ), size - 1 );
+              float*         out = values + x * stride;
+              const float*   in = &block[xr * stride];
+              for( SizeValueType i = 0; i < stride; ++i )
+                {
+                out[i] += in[i];
+                }
+              }
+            }
+          }
+        }
+      }
+    stride = blockSize;
+    }
+  for( SizeValueType i = 0; i < numberOfValues; ++i )
+    {
+    const float mean = m_LocalMean[i] / count;
+    m_LocalMean[i] = mean;
+    m_LocalVariance[i] = std::max( m_LocalVariance[i] / count - mean * mean, 0.0f );
+    }
+}
+
+template <class TInputImage, class TOutputImage>
+bool UNLMFilter<TInputImage, TOutputImage>
+::IsPreSelected( OffsetValueType center, unsigned int centerChannel,
+                 OffsetValueType candidate, unsigned int candidateChannel ) const
+{
+  const float meanA = m_LocalMean[center * m_Channels + centerChannel];
+  const float meanB = m_LocalMean[candidate * m_Channels + candidateChannel];
+  if( meanA < m_PreSelectionMean * meanB || meanB < m_PreSelectionMean * meanA )
+    {
+    return false;
+    }
+  const float varA = m_LocalVariance[center * m_Channels + centerChannel];
+  const float varB = m_LocalVariance[candidate * m_Channels + candidateChannel];
+  return varA >= m_PreSelectionVariance * varB && varB >= m_PreSelectionVariance * varA;
 }
 
 } // end namespace itk
@@ -30,6 +30,7 @@ Version:   $Revision$
 #include "vtkITKArchetypeImageSeriesScalarReader.h"
 
 // VTK includes
+#include <vtkAlgorithmOutput.h>
 #include <vtkDebugLeaks.h>
 #include <vtkDecimatePro.h>
 #include <vtkDiscreteMarchingCubes.h>
@@ -42,8 +43,13 @@ Version:   $Revision$
 #include <vtkImageToStructuredPoints.h>
 #include <vtkInformation.h>
 #include <vtkLookupTable.h>
+#include <vtkMarchingCubes.h>
+#include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkPolyDataAlgorithm.h>
 #include <vtkPolyDataNormals.h>
 #include <vtkPolyDataWriter.h>
 #include <vtkReverseSense.h>
@@ -61,6 +67,509 @@ Version:   $Revision$
 // VTKsys includes
 #include <vtksys/SystemTools.hxx>
 
+// STD includes
+#include <algorithm>
+#include <map>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Write the model polydata next to the scene file and add the model, its
+// storage, display and hierarchy nodes to the model scene.
+void WriteModelAndAddToScene(vtkPolyData* polyData, const std::string& labelName,
+                             int label, const std::string& rootDir,
+                             vtkMRMLScene* modelScene,
+                             vtkMRMLColorTableNode* colorNode,
+                             vtkMRMLModelHierarchyNode* topColorHierarchyNode,
+                             vtkMRMLNode* rnd, bool debug,
+                             ModuleProcessInformation* CLPProcessInformation,
+                             float numFilterSteps, float& currentFilterOffset)
+{
+  vtkSmartPointer<vtkPolyDataWriter> writer = vtkSmartPointer<vtkPolyDataWriter>::New();
+  std::string            comment4 = "Write " + labelName;
+  vtkPluginFilterWatcher watchWriter(writer,
+                                     comment4.c_str(),
+                                     CLPProcessInformation,
+                                     1.0 / numFilterSteps,
+                                     currentFilterOffset / numFilterSteps);
+  currentFilterOffset += 1.0;
+  if (debug)
+    {
+    watchWriter.QuietOn();
+    }
+#if (VTK_MAJOR_VERSION <= 5)
+  writer->SetInput(polyData);
+#else
+  writer->SetInputData(polyData);
+#endif
+  writer->SetFileType(2);
+  std::string fileName;
+  if (rootDir != "")
+    {
+    fileName = rootDir + std::string("/") + labelName + std::string(".vtk");
+    }
+  else
+    {
+    std::cout << "WARNING: output directory is an empty string..." << endl;
+    fileName = labelName + std::string(".vtk");
+    }
+  writer->SetFileName(fileName.c_str());
+
+  if (debug)
+    {
+    std::cout << "Writing model " << " " << labelName << " to file " << writer->GetFileName()  << endl;
+    }
+  if (!writer->Write())
+    {
+    std::cerr << "ERROR: Failed to write model file " << fileName.c_str() << std::endl;
+    }
+#if (VTK_MAJOR_VERSION <= 5)
+  writer->SetInput(NULL);
+#else
+  writer->SetInputData(NULL);
+#endif
+  writer = NULL;
+  if (modelScene != NULL)
+    {
+    if (debug)
+      {
+      std::cout << "Adding model " << labelName << " to the output scene, with filename " << fileName.c_str()
+                << endl;
+      }
+    // each model needs a mrml node, a storage node and a display node
+    vtkNew<vtkMRMLModelNode> mnode;
+    mnode->SetScene(modelScene);
+    mnode->SetName(labelName.c_str());
+
+    vtkNew<vtkMRMLModelStorageNode> snode;
+    snode->SetFileName(fileName.c_str());
+    if (modelScene->AddNode(snode.GetPointer()) == NULL)
+      {
+      std::cerr << "ERROR: unable to add the storage node to the model scene" << endl;
+      }
+    vtkNew<vtkMRMLModelDisplayNode> dnode;
+    dnode->SetColor(0.5, 0.5, 0.5);
+    double *rgba;
+    if (colorNode != NULL)
+      {
+      rgba = colorNode->GetLookupTable()->GetTableValue(label);
+      if (rgba != NULL)
+        {
+        if (debug)
+          {
+          std::cout << "Got colour: " << rgba[0] << " " << rgba[1] << " " << rgba[2] << " " << rgba[3] << endl;
+          }
+        dnode->SetColor(rgba[0], rgba[1], rgba[2]);
+        }
+      else
+        {
+        std::cerr << "Couldn't get look up table value for " << label << ", display node colour is not set (grey)"
+                  << endl;
+        }
+      }
+
+    dnode->SetVisibility(1);
+    modelScene->AddNode(dnode.GetPointer());
+    if (debug)
+      {
+      std::cout << "Added display node: id = " << (dnode->GetID() == NULL ? "(null)" : dnode->GetID()) << endl;
+      std::cout << "Setting model's storage node: id = "
+                << (snode->GetID() == NULL ? "(null)" : snode->GetID()) << endl;
+      }
+    mnode->SetAndObserveStorageNodeID(snode->GetID());
+    mnode->SetAndObserveDisplayNodeID(dnode->GetID());
+    modelScene->AddNode(mnode.GetPointer());
+
+    // put it in the hierarchy, either the flat one by default or
+    // try to find the matching color hierarchy node to make this an
+    // associated node
+    std::string colorName;
+    if (colorNode != NULL)
+      {
+      colorName = std::string(colorNode->GetColorNameAsFileName(label));
+      }
+    else
+      {
+      // might be in a testing case where the hierarchy nodes are
+      // numbered (made from the generic colors)
+      std::stringstream ss;
+      ss << label;
+      colorName = ss.str();
+      if (debug)
+        {
+        std::cout << "No color node, guessing at color name being same as label number " << colorName.c_str() << std::endl;
+        }
+      }
+    vtkMRMLNode *mrmlNode = NULL;
+    if (colorName.compare("") != 0)
+      {
+      mrmlNode = modelScene->GetFirstNodeByName(colorName.c_str());
+      }
+    // if there's no color hierarchy, or no color name or the mrml node
+    // named for the color isn't a model hierarchy node, use a flat hierarchy
+    if (topColorHierarchyNode == NULL ||
+        colorName.compare("") == 0 ||
+        mrmlNode == NULL ||
+        strcmp(mrmlNode->GetClassName(),"vtkMRMLModelHierarchyNode") != 0)
+      {
+      vtkNew<vtkMRMLModelHierarchyNode> mhnd;
+      mhnd->SetHideFromEditors(1);
+      modelScene->AddNode(mhnd.GetPointer());
+      mhnd->SetParentNodeID(rnd->GetID());
+      mhnd->SetModelNodeID(mnode->GetID());
+      }
+    else
+      {
+      // use the template color hierarchy
+      vtkMRMLModelHierarchyNode *colorHierarchyNode = vtkMRMLModelHierarchyNode::SafeDownCast(mrmlNode);
+      if (colorHierarchyNode)
+        {
+        colorHierarchyNode->SetAssociatedNodeID(mnode->GetID());
+        // and hide it so that it doesn't clutter up the tree
+        colorHierarchyNode->SetHideFromEditors(1);
+        if (debug)
+          {
+          std::cout << "Found a color hierarchy node with name " << colorHierarchyNode->GetName() << ", set it's associated node to this model id: " << mnode->GetID() << std::endl;
+          }
+        }
+      }
+    if (debug)
+      {
+      std::cout << "...done adding model to output scene" << endl;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Label made by a worker thread when ParallelLabels is on
+struct LabelModelJob
+{
+  LabelModelJob()
+    : Label(0)
+    , HasVoxels(false)
+  {
+  }
+  int Label;
+  std::string Name;
+  bool HasVoxels;
+  // IJK bounding box of the label voxels
+  int Extent[6];
+  vtkSmartPointer<vtkPolyData> PolyData;
+};
+
+//----------------------------------------------------------------------------
+// Parameters shared by the worker threads
+struct LabelModelThreadInfo
+{
+  vtkImageData* Image;
+  std::vector<LabelModelJob>* Jobs;
+  vtkMatrix4x4* IJKToRAS;
+  bool Pad;
+  float Decimate;
+  int Smooth;
+  bool SincFilter;
+  bool SplitNormals;
+  bool PointNormals;
+  bool SaveIntermediateModels;
+  std::string RootDir;
+  bool Debug;
+  ModuleProcessInformation* ProcessInformation;
+  double ProgressStart;
+  double ProgressFraction;
+  // protected by Lock
+  vtkMutexLock* Lock;
+  size_t NextJob;
+  size_t NumberOfJobsDone;
+};
+
+//----------------------------------------------------------------------------
+void ReportProgress(ModuleProcessInformation* processInformation,
+                    const std::string& comment, double progress)
+{
+  if (processInformation)
+    {
+    strncpy(processInformation->ProgressMessage, comment.c_str(), 1023);
+    processInformation->Progress = progress;
+    if (processInformation->ProgressCallbackFunction
+        && processInformation->ProgressCallbackClientData)
+      {
+      (*(processInformation->ProgressCallbackFunction))(processInformation->ProgressCallbackClientData);
+      }
+    }
+  else
+    {
+    std::cout << "<filter-progress>" << progress << "</filter-progress>"
+              << std::endl << std::flush;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Compute in a single pass the bounding box of all the labels in the image.
+template <class T>
+void ComputeLabelExtents(vtkImageData* image, T* ptr,
+                         std::map<int, std::vector<int> >& labelExtents)
+{
+  int extent[6];
+  image->GetExtent(extent);
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  std::vector<int>* lastLabelExtent = 0;
+  int lastLabel = 0;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i, ptr += numberOfComponents)
+        {
+        int label = static_cast<int>(*ptr);
+        if (!lastLabelExtent || label != lastLabel)
+          {
+          std::map<int, std::vector<int> >::iterator it = labelExtents.find(label);
+          if (it == labelExtents.end())
+            {
+            int emptyExtent[6] = {i, i, j, j, k, k};
+            it = labelExtents.insert(std::make_pair(label,
+              std::vector<int>(emptyExtent, emptyExtent + 6))).first;
+            }
+          lastLabel = label;
+          lastLabelExtent = &it->second;
+          }
+        std::vector<int>& labelExtent = *lastLabelExtent;
+        labelExtent[0] = std::min(labelExtent[0], i);
+        labelExtent[1] = std::max(labelExtent[1], i);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        // k is increasing
+        labelExtent[5] = k;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Fill output (allocated on the crop extent) with 200 where the image equals
+// label and 0 elsewhere, including outside of the image extent.
+template <class T>
+void ExtractLabel(vtkImageData* image, T* inPtr, int label, vtkImageData* output)
+{
+  int extent[6];
+  image->GetExtent(extent);
+  int cropExtent[6];
+  output->GetExtent(cropExtent);
+  vtkIdType increments[3];
+  image->GetIncrements(increments);
+  unsigned char* outPtr = static_cast<unsigned char*>(output->GetScalarPointer());
+  for (int k = cropExtent[4]; k <= cropExtent[5]; ++k)
+    {
+    for (int j = cropExtent[2]; j <= cropExtent[3]; ++j)
+      {
+      for (int i = cropExtent[0]; i <= cropExtent[1]; ++i)
+        {
+        bool inside = i >= extent[0] && i <= extent[1] &&
+                      j >= extent[2] && j <= extent[3] &&
+                      k >= extent[4] && k <= extent[5];
+        *outPtr++ = (inside &&
+                     static_cast<double>(inPtr[(i - extent[0]) * increments[0] +
+                                               (j - extent[2]) * increments[1] +
+                                               (k - extent[4]) * increments[2]]) == label) ? 200 : 0;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void WriteIntermediateModel(vtkAlgorithmOutput* port, const LabelModelThreadInfo* info,
+                            const std::string& labelName, const std::string& suffix)
+{
+  vtkNew<vtkPolyDataWriter> writer;
+  writer->SetInputConnection(port);
+  writer->SetFileType(2);
+  std::string fileName = labelName + suffix;
+  if (info->RootDir != "")
+    {
+    fileName = info->RootDir + std::string("/") + fileName;
+    }
+  writer->SetFileName(fileName.c_str());
+  if (!writer->Write())
+    {
+    std::cerr << "ERROR: Failed to write intermediate file " << fileName.c_str() << std::endl;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Same pipeline as the sequential non joint smoothing path, run on the label
+// bounding box instead of the whole volume. No filter watcher is used as
+// several labels are processed at the same time.
+void MakeLabelModel(LabelModelJob& job, const LabelModelThreadInfo* info)
+{
+  if (!job.HasVoxels)
+    {
+    return;
+    }
+  int extent[6];
+  info->Image->GetExtent(extent);
+  // 1 voxel margin for marching cubes to close the surface. Without padding
+  // the surface is left open where the label touches the volume boundary.
+  int cropExtent[6];
+  for (int i = 0; i < 3; ++i)
+    {
+    cropExtent[2*i] = job.Extent[2*i] - 1;
+    cropExtent[2*i+1] = job.Extent[2*i+1] + 1;
+    if (!info->Pad)
+      {
+      cropExtent[2*i] = std::max(cropExtent[2*i], extent[2*i]);
+      cropExtent[2*i+1] = std::min(cropExtent[2*i+1], extent[2*i+1]);
+      }
+    }
+
+  vtkNew<vtkImageData> labelImage;
+  labelImage->SetExtent(cropExtent);
+  labelImage->SetOrigin(info->Image->GetOrigin());
+  labelImage->SetSpacing(info->Image->GetSpacing());
+#if (VTK_MAJOR_VERSION <= 5)
+  labelImage->SetScalarTypeToUnsignedChar();
+  labelImage->SetNumberOfScalarComponents(1);
+  labelImage->AllocateScalars();
+#else
+  labelImage->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+#endif
+  void* inPtr = info->Image->GetScalarPointer();
+  switch (info->Image->GetScalarType())
+    {
+    vtkTemplateMacro(ExtractLabel(info->Image, static_cast<VTK_TT*>(inPtr),
+                                  job.Label, labelImage.GetPointer()));
+    default:
+      std::cerr << "ERROR: unknown scalar type for label " << job.Label << std::endl;
+      return;
+    }
+
+  vtkNew<vtkMarchingCubes> mcubes;
+#if (VTK_MAJOR_VERSION <= 5)
+  mcubes->SetInput(labelImage.GetPointer());
+#else
+  mcubes->SetInputData(labelImage.GetPointer());
+#endif
+  mcubes->SetValue(0, 100.5);
+  mcubes->ComputeScalarsOff();
+  mcubes->ComputeGradientsOff();
+  mcubes->ComputeNormalsOff();
+  mcubes->Update();
+  if (mcubes->GetOutput()->GetNumberOfPolys() == 0)
+    {
+    return;
+    }
+  if (info->SaveIntermediateModels)
+    {
+    WriteIntermediateModel(mcubes->GetOutputPort(), info, job.Name, "-MarchingCubes.vtk");
+    }
+
+  vtkNew<vtkDecimatePro> decimator;
+  decimator->SetInputConnection(mcubes->GetOutputPort());
+  decimator->SetFeatureAngle(60);
+  decimator->SplittingOff();
+  decimator->PreserveTopologyOn();
+  decimator->SetMaximumError(1);
+  decimator->SetTargetReduction(info->Decimate);
+  decimator->Update();
+  if (info->SaveIntermediateModels)
+    {
+    WriteIntermediateModel(decimator->GetOutputPort(), info, job.Name, "-Decimated.vtk");
+    }
+  vtkAlgorithmOutput* decimatedPort = decimator->GetOutputPort();
+
+  vtkNew<vtkReverseSense> reverser;
+  if (info->IJKToRAS->Determinant() < 0)
+    {
+    reverser->SetInputConnection(decimator->GetOutputPort());
+    reverser->ReverseNormalsOn();
+    decimatedPort = reverser->GetOutputPort();
+    }
+
+  vtkSmartPointer<vtkPolyDataAlgorithm> smoother;
+  if (info->SincFilter)
+    {
+    vtkNew<vtkWindowedSincPolyDataFilter> smootherSinc;
+    smootherSinc->SetPassBand(0.1);
+    smootherSinc->SetNumberOfIterations(info->Smooth);
+    smootherSinc->FeatureEdgeSmoothingOff();
+    smootherSinc->BoundarySmoothingOff();
+    smoother = smootherSinc.GetPointer();
+    }
+  else
+    {
+    vtkNew<vtkSmoothPolyDataFilter> smootherPoly;
+    smootherPoly->SetRelaxationFactor(0.33);
+    smootherPoly->SetFeatureAngle(60);
+    smootherPoly->SetConvergence(0);
+    smootherPoly->SetNumberOfIterations(info->Smooth);
+    smootherPoly->FeatureEdgeSmoothingOff();
+    smootherPoly->BoundarySmoothingOff();
+    smoother = smootherPoly.GetPointer();
+    }
+  smoother->SetInputConnection(decimatedPort);
+  smoother->Update();
+  if (info->SaveIntermediateModels)
+    {
+    WriteIntermediateModel(smoother->GetOutputPort(), info, job.Name, "-Smoothed.vtk");
+    }
+
+  // each thread uses its own transform, vtkTransform::Update is not thread safe
+  vtkNew<vtkTransform> transformIJKtoRAS;
+  transformIJKtoRAS->SetMatrix(info->IJKToRAS);
+  vtkNew<vtkTransformPolyDataFilter> transformer;
+  transformer->SetInputConnection(smoother->GetOutputPort());
+  transformer->SetTransform(transformIJKtoRAS.GetPointer());
+
+  vtkNew<vtkPolyDataNormals> normals;
+  normals->SetComputePointNormals(info->PointNormals);
+  normals->SetInputConnection(transformer->GetOutputPort());
+  normals->SetFeatureAngle(60);
+  normals->SetSplitting(info->SplitNormals);
+
+  vtkNew<vtkStripper> stripper;
+  stripper->SetInputConnection(normals->GetOutputPort());
+  stripper->Update();
+
+  job.PolyData = vtkSmartPointer<vtkPolyData>::New();
+  job.PolyData->ShallowCopy(stripper->GetOutput());
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE MakeLabelModelsThreadedExecute(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo =
+    static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LabelModelThreadInfo* info =
+    static_cast<LabelModelThreadInfo*>(threadInfo->UserData);
+  while (true)
+    {
+    info->Lock->Lock();
+    size_t jobIndex = info->NextJob++;
+    info->Lock->Unlock();
+    if (jobIndex >= info->Jobs->size())
+      {
+      break;
+      }
+    LabelModelJob& job = (*info->Jobs)[jobIndex];
+    MakeLabelModel(job, info);
+
+    info->Lock->Lock();
+    ++info->NumberOfJobsDone;
+    if (info->Debug)
+      {
+      std::cout << "Made model " << job.Name << " in thread " << threadInfo->ThreadID << std::endl;
+      }
+    ReportProgress(info->ProcessInformation, "Make " + job.Name,
+                   info->ProgressStart + info->ProgressFraction *
+                   info->NumberOfJobsDone / info->Jobs->size());
+    info->Lock->Unlock();
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
 int main(int argc, char * argv[])
 {
   PARSE_ARGS;
@@ -917,6 +1426,9 @@ int main(int argc, char * argv[])
       loopLabels.push_back(Labels[i]);
       }
     }
+  // when not joint smoothing, the labels can be processed independently
+  bool useParallelLabels = ParallelLabels && !JointSmoothing;
+  std::vector<LabelModelJob> labelJobs;
   for(::size_t l = 0; l < loopLabels.size(); l++)
     {
     // get the label out of the vector
@@ -1027,6 +1539,16 @@ int main(int argc, char * argv[])
       */
       }
 
+    if (useParallelLabels)
+      {
+      // the model is made after the loop by a worker thread
+      LabelModelJob job;
+      job.Label = i;
+      job.Name = labelName;
+      labelJobs.push_back(job);
+      continue;
+      }
+
     // threshold
     if (JointSmoothing == 0)
       {
@@ -1825,161 +2347,99 @@ int main(int argc, char * argv[])
         }
 
       // but for now we're just going to write it out
-      writer = vtkSmartPointer<vtkPolyDataWriter>::New();
-      std::string            comment4 = "Write " + labelName;
-      vtkPluginFilterWatcher watchWriter(writer,
-                                         comment4.c_str(),
-                                         CLPProcessInformation,
-                                         1.0 / numFilterSteps,
-                                         currentFilterOffset / numFilterSteps);
-      currentFilterOffset += 1.0;
-      if (debug)
-        {
-        watchWriter.QuietOn();
-        }
-#if (VTK_MAJOR_VERSION <= 5)
-      writer->SetInput(stripper->GetOutput());
-#else
-      writer->SetInputConnection(stripper->GetOutputPort());
-#endif
-      writer->SetFileType(2);
-      std::string fileName;
-      if (rootDir != "")
-        {
-        fileName = rootDir + std::string("/") + labelName + std::string(".vtk");
-        }
-      else
-        {
-        std::cout << "WARNING: output directory is an empty string..." << endl;
-        fileName = labelName + std::string(".vtk");
-        }
-      writer->SetFileName(fileName.c_str());
-
-      if (debug)
-        {
-        std::cout << "Writing model " << " " << labelName << " to file " << writer->GetFileName()  << endl;
-        }
-      if (!writer->Write())
-        {
-        std::cerr << "ERROR: Failed to write model file " << fileName.c_str() << std::endl;
-        }
-#if (VTK_MAJOR_VERSION <= 5)
-      writer->SetInput(NULL);
-#else
-      writer->SetInputData(NULL);
-#endif
-      writer = NULL;
-      if (modelScene.GetPointer() != NULL)
-        {
-        if (debug)
-          {
-          std::cout << "Adding model " << labelName << " to the output scene, with filename " << fileName.c_str()
-                    << endl;
-          }
-        // each model needs a mrml node, a storage node and a display node
-        vtkNew<vtkMRMLModelNode> mnode;
-        mnode->SetScene(modelScene.GetPointer());
-        mnode->SetName(labelName.c_str());
-
-        vtkNew<vtkMRMLModelStorageNode> snode;
-        snode->SetFileName(fileName.c_str());
-        if (modelScene->AddNode(snode.GetPointer()) == NULL)
-          {
-          std::cerr << "ERROR: unable to add the storage node to the model scene" << endl;
-          }
-        vtkNew<vtkMRMLModelDisplayNode> dnode;
-        dnode->SetColor(0.5, 0.5, 0.5);
-        double *rgba;
-        if (colorNode != NULL)
-          {
-          rgba = colorNode->GetLookupTable()->GetTableValue(i);
-          if (rgba != NULL)
-            {
-            if (debug)
-              {
-              std::cout << "Got colour: " << rgba[0] << " " << rgba[1] << " " << rgba[2] << " " << rgba[3] << endl;
-              }
-            dnode->SetColor(rgba[0], rgba[1], rgba[2]);
-            }
-          else
-            {
-            std::cerr << "Couldn't get look up table value for " << i << ", display node colour is not set (grey)"
-                      << endl;
-            }
-          }
-
-        dnode->SetVisibility(1);
-        modelScene->AddNode(dnode.GetPointer());
-        if (debug)
-          {
-          std::cout << "Added display node: id = " << (dnode->GetID() == NULL ? "(null)" : dnode->GetID()) << endl;
-          std::cout << "Setting model's storage node: id = "
-                    << (snode->GetID() == NULL ? "(null)" : snode->GetID()) << endl;
-          }
-        mnode->SetAndObserveStorageNodeID(snode->GetID());
-        mnode->SetAndObserveDisplayNodeID(dnode->GetID());
-        modelScene->AddNode(mnode.GetPointer());
-
-        // put it in the hierarchy, either the flat one by default or
-        // try to find the matching color hierarchy node to make this an
-        // associated node
-        std::string colorName;
-        if (colorNode != NULL)
-          {
-          colorName = std::string(colorNode->GetColorNameAsFileName(i));
-          }
-        else
-          {
-          // might be in a testing case where the hierarchy nodes are
-          // numbered (made from the generic colors)
-          std::stringstream ss;
-          ss << i;
-          colorName = ss.str();
-          if (debug)
-            {
-            std::cout << "No color node, guessing at color name being same as label number " << colorName.c_str() << std::endl;
-            }
-          }
-        vtkMRMLNode *mrmlNode = NULL;
-        if (colorName.compare("") != 0)
-          {
-          mrmlNode = modelScene->GetFirstNodeByName(colorName.c_str());
-          }
-        // if there's no color hierarchy, or no color name or the mrml node
-        // named for the color isn't a model hierarchy node, use a flat hierarchy
-        if (topColorHierarchyNode == NULL ||
-            colorName.compare("") == 0 ||
-            mrmlNode == NULL ||
-            strcmp(mrmlNode->GetClassName(),"vtkMRMLModelHierarchyNode") != 0)
-          {
-          vtkNew<vtkMRMLModelHierarchyNode> mhnd;
-          mhnd->SetHideFromEditors(1);
-          modelScene->AddNode(mhnd.GetPointer());
-          mhnd->SetParentNodeID(rnd->GetID());
-          mhnd->SetModelNodeID(mnode->GetID());
-          }
-        else
-          {
-          // use the template color hierarchy
-          vtkMRMLModelHierarchyNode *colorHierarchyNode = vtkMRMLModelHierarchyNode::SafeDownCast(mrmlNode);
-          if (colorHierarchyNode)
-            {
-            colorHierarchyNode->SetAssociatedNodeID(mnode->GetID());
-            // and hide it so that it doesn't clutter up the tree
-            colorHierarchyNode->SetHideFromEditors(1);
-            if (debug)
-              {
-              std::cout << "Found a color hierarchy node with name " << colorHierarchyNode->GetName() << ", set it's associated node to this model id: " << mnode->GetID() << std::endl;
-              }
-            }
-          }
-        if (debug)
-          {
-          std::cout << "...done adding model to output scene" << endl;
-          }
-        }
+      WriteModelAndAddToScene(stripper->GetOutput(), labelName, i, rootDir,
+                              modelScene.GetPointer(), colorNode,
+                              topColorHierarchyNode, rnd, debug,
+                              CLPProcessInformation, numFilterSteps,
+                              currentFilterOffset);
       } // end of skipping an empty label
     }   // end of loop over labels
+
+  if (labelJobs.size() > 0)
+    {
+    // single pass over the volume to get the bounding box of every label
+    std::map<int, std::vector<int> > labelExtents;
+    void* imagePtr = image->GetScalarPointer();
+    switch (image->GetScalarType())
+      {
+      vtkTemplateMacro(ComputeLabelExtents(image, static_cast<VTK_TT*>(imagePtr),
+                                           labelExtents));
+      default:
+        std::cerr << "ERROR: unknown scalar type for input volume " << InputVolume << std::endl;
+        return EXIT_FAILURE;
+      }
+    for(::size_t l = 0; l < labelJobs.size(); l++)
+      {
+      std::map<int, std::vector<int> >::const_iterator it =
+        labelExtents.find(labelJobs[l].Label);
+      if (it != labelExtents.end())
+        {
+        labelJobs[l].HasVoxels = true;
+        std::copy(it->second.begin(), it->second.end(), labelJobs[l].Extent);
+        }
+      }
+    if (strcmp(FilterType.c_str(), "Sinc") == 0 && Smooth == 1)
+      {
+      std::cerr << "Warning: Smoothing iterations of 1 not allowed for Sinc filter, using 2" << endl;
+      Smooth = 2;
+      }
+
+    vtkNew<vtkMatrix4x4> ijkToRASMatrix;
+    ijkToRASMatrix->DeepCopy(transformIJKtoRAS->GetMatrix());
+    vtkNew<vtkMutexLock> lock;
+
+    LabelModelThreadInfo info;
+    info.Image = image;
+    info.Jobs = &labelJobs;
+    info.IJKToRAS = ijkToRASMatrix.GetPointer();
+    info.Pad = Pad;
+    info.Decimate = Decimate;
+    info.Smooth = Smooth;
+    info.SincFilter = (strcmp(FilterType.c_str(), "Sinc") == 0);
+    info.SplitNormals = SplitNormals;
+    info.PointNormals = PointNormals;
+    info.SaveIntermediateModels = SaveIntermediateModels;
+    info.RootDir = rootDir;
+    info.Debug = debug;
+    info.ProcessInformation = CLPProcessInformation;
+    // the writing of each model is reported separately, see below
+    double remainingSteps = numFilterSteps - currentFilterOffset - labelJobs.size();
+    info.ProgressStart = currentFilterOffset / numFilterSteps;
+    info.ProgressFraction = remainingSteps > 0. ? remainingSteps / numFilterSteps : 0.;
+    info.Lock = lock.GetPointer();
+    info.NextJob = 0;
+    info.NumberOfJobsDone = 0;
+
+    int numberOfThreads = NumberOfThreads > 0 ?
+      NumberOfThreads : vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    numberOfThreads = std::min(numberOfThreads, static_cast<int>(labelJobs.size()));
+    std::cout << "Making " << labelJobs.size() << " models using "
+              << numberOfThreads << " threads" << std::endl;
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(numberOfThreads);
+    threader->SetSingleMethod(MakeLabelModelsThreadedExecute, &info);
+    threader->SingleMethodExecute();
+    currentFilterOffset = std::max(currentFilterOffset,
+                                   static_cast<float>(numFilterSteps - labelJobs.size()));
+
+    // models are added in label order whatever the thread that made them
+    for(::size_t l = 0; l < labelJobs.size(); l++)
+      {
+      LabelModelJob& job = labelJobs[l];
+      if (!job.PolyData)
+        {
+        std::cout << "Cannot create a model from label " << job.Label
+                  << "\nNo polygons can be created,\nthere may be no voxels with this label in the volume." << endl;
+        continue;
+        }
+      WriteModelAndAddToScene(job.PolyData, job.Name, job.Label, rootDir,
+                              modelScene.GetPointer(), colorNode,
+                              topColorHierarchyNode, rnd, debug,
+                              CLPProcessInformation, numFilterSteps,
+                              currentFilterOffset);
+      job.PolyData = NULL;
+      }
+    }
   if (debug)
     {
     std::cout << "End of looping over labels" << endl;
@@ -0,0 +1,166 @@
+// MRML includes
+#include <vtkMRMLModelNode.h>
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#define MODULE_IMPORT __declspec(dllimport)
+#else
+#define MODULE_IMPORT
+#endif
+
+extern "C" MODULE_IMPORT int ModuleEntryPoint(int, char * []);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+int RunModelMaker(const std::vector<std::string>& arguments)
+{
+  std::vector<char*> argv;
+  argv.push_back(const_cast<char*>("ModelMaker"));
+  for (size_t i = 0; i < arguments.size(); ++i)
+    {
+    argv.push_back(const_cast<char*>(arguments[i].c_str()));
+    }
+  argv.push_back(0);
+  return ModuleEntryPoint(static_cast<int>(argv.size() - 1), &argv[0]);
+}
+
+//----------------------------------------------------------------------------
+bool ReadModelScene(const char* sceneFileName, vtkMRMLScene* scene)
+{
+  scene->SetURL(sceneFileName);
+  if (!scene->Connect())
+    {
+    std::cerr << "Line " << __LINE__ << ": failed to read " << sceneFileName << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Make the models of all the labels of a label map with and without
+// --parallelLabels, in two directories, and check that the same models are
+// made.
+int ModelMakerParallelTest(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: ModelMakerParallelTest labelMap serialScene.mrml parallelScene.mrml"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string labelMap = argv[1];
+  const std::string serialSceneFileName = argv[2];
+  const std::string parallelSceneFileName = argv[3];
+
+  std::vector<std::string> serialArguments;
+  serialArguments.push_back("--generateAll");
+  serialArguments.push_back("--modelSceneFile");
+  serialArguments.push_back(serialSceneFileName + "#vtkMRMLModelHierarchyNode1");
+  serialArguments.push_back(labelMap);
+  if (RunModelMaker(serialArguments) != EXIT_SUCCESS)
+    {
+    std::cerr << "Line " << __LINE__ << ": serial run failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::vector<std::string> parallelArguments;
+  parallelArguments.push_back("--generateAll");
+  parallelArguments.push_back("--parallelLabels");
+  parallelArguments.push_back("--numberOfThreads");
+  parallelArguments.push_back("2");
+  parallelArguments.push_back("--modelSceneFile");
+  parallelArguments.push_back(parallelSceneFileName + "#vtkMRMLModelHierarchyNode1");
+  parallelArguments.push_back(labelMap);
+  if (RunModelMaker(parallelArguments) != EXIT_SUCCESS)
+    {
+    std::cerr << "Line " << __LINE__ << ": parallel run failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkNew<vtkMRMLScene> serialScene;
+  vtkNew<vtkMRMLScene> parallelScene;
+  if (!ReadModelScene(serialSceneFileName.c_str(), serialScene.GetPointer()) ||
+      !ReadModelScene(parallelSceneFileName.c_str(), parallelScene.GetPointer()))
+    {
+    return EXIT_FAILURE;
+    }
+
+  int numberOfModels = serialScene->GetNumberOfNodesByClass("vtkMRMLModelNode");
+  if (numberOfModels == 0 ||
+      numberOfModels != parallelScene->GetNumberOfNodesByClass("vtkMRMLModelNode"))
+    {
+    std::cerr << "Line " << __LINE__ << ": " << numberOfModels << " serial models but "
+              << parallelScene->GetNumberOfNodesByClass("vtkMRMLModelNode")
+              << " parallel models" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the cropped regions give the same surfaces, up to the order of the
+  // points and the float rounding of their coordinates
+  const double tolerance = 1e-3;
+  for (int i = 0; i < numberOfModels; ++i)
+    {
+    vtkMRMLModelNode* serialModel = vtkMRMLModelNode::SafeDownCast(
+      serialScene->GetNthNodeByClass(i, "vtkMRMLModelNode"));
+    vtkMRMLModelNode* parallelModel = vtkMRMLModelNode::SafeDownCast(
+      parallelScene->GetNthNodeByClass(i, "vtkMRMLModelNode"));
+    // the models are added in label order in both modes
+    if (!serialModel || !parallelModel ||
+        std::string(serialModel->GetName()) != parallelModel->GetName())
+      {
+      std::cerr << "Line " << __LINE__ << ": serial and parallel model "
+                << i << " differ" << std::endl;
+      return EXIT_FAILURE;
+      }
+    vtkPolyData* serialPolyData = serialModel->GetPolyData();
+    vtkPolyData* parallelPolyData = parallelModel->GetPolyData();
+    if (!serialPolyData || !parallelPolyData)
+      {
+      std::cerr << "Line " << __LINE__ << ": model " << serialModel->GetName()
+                << " was not read" << std::endl;
+      return EXIT_FAILURE;
+      }
+    if (serialPolyData->GetNumberOfPoints() != parallelPolyData->GetNumberOfPoints() ||
+        serialPolyData->GetNumberOfCells() != parallelPolyData->GetNumberOfCells())
+      {
+      std::cerr << "Line " << __LINE__ << ": model " << serialModel->GetName()
+                << " has " << serialPolyData->GetNumberOfPoints() << " points and "
+                << serialPolyData->GetNumberOfCells() << " cells in serial but "
+                << parallelPolyData->GetNumberOfPoints() << " points and "
+                << parallelPolyData->GetNumberOfCells() << " cells in parallel"
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    double serialBounds[6];
+    double parallelBounds[6];
+    serialPolyData->GetBounds(serialBounds);
+    parallelPolyData->GetBounds(parallelBounds);
+    for (int b = 0; b < 6; ++b)
+      {
+      if (std::fabs(serialBounds[b] - parallelBounds[b]) > tolerance)
+        {
+        std::cerr << "Line " << __LINE__ << ": model " << serialModel->GetName()
+                  << " bound " << b << " is " << serialBounds[b] << " in serial but "
+                  << parallelBounds[b] << " in parallel" << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
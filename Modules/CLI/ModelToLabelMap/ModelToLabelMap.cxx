@@ -19,77 +19,63 @@
 #include "ModelToLabelMapCLP.h"
 
 // ITK includes
-#include "itkBinaryBallStructuringElement.h"
-#include "itkBinaryErodeImageFilter.h"
-#include "itkBinaryDilateImageFilter.h"
-#include "itkBinaryThresholdImageFunction.h"
-#include "itkFloodFilledImageFunctionConditionalIterator.h"
 #include "itkImageFileWriter.h"
 #include "itkPluginUtilities.h"
 #include <itksys/SystemTools.hxx>
 
 // VTK includes
 #include <vtkDebugLeaks.h>
-#include <vtkNew.h>
 #include <vtkSmartPointer.h>
-#include <vtkPolyDataPointSampler.h>
 #include <vtkPolyDataReader.h>
 #include <vtkXMLPolyDataReader.h>
-#include <vtkVersion.h>
 
-typedef itk::Image<unsigned char, 3> LabelImageType;
+#include "ModelToLabelMapRasterizer.h"
+#include "ModelToLabelMapSampler.h"
 
-LabelImageType::Pointer BinaryErodeFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
-{
-  typedef itk::BinaryBallStructuringElement<unsigned char, 3>                     KernalType;
-  typedef itk::BinaryErodeImageFilter<LabelImageType, LabelImageType, KernalType> ErodeFilterType;
-  ErodeFilterType::Pointer erodeFilter = ErodeFilterType::New();
-  erodeFilter->SetInput( img );
+typedef ModelToLabelMap::LabelImageType LabelImageType;
 
-  KernalType           ball;
-  KernalType::SizeType ballSize;
-  for( int k = 0; k < 3; k++ )
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> ReadModel(const std::string& fileName)
+{
+  vtkSmartPointer<vtkPolyData> polyData;
+  // do we have vtk or vtp models?
+  std::string extension = itksys::SystemTools::LowerCase( itksys::SystemTools::GetFilenameLastExtension(fileName) );
+  if( extension.empty() )
     {
-    ballSize[k] = ballsize;
+    std::cerr << "Failed to find an extension for " << fileName << std::endl;
+    return polyData;
     }
-  ball.SetRadius(ballSize);
-  ball.CreateStructuringElement();
-  erodeFilter->SetKernel( ball );
-  erodeFilter->Update();
-  return erodeFilter->GetOutput();
-}
 
-LabelImageType::Pointer BinaryDilateFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
-{
-  typedef itk::BinaryBallStructuringElement<unsigned char, 3>                      KernalType;
-  typedef itk::BinaryDilateImageFilter<LabelImageType, LabelImageType, KernalType> DilateFilterType;
-  DilateFilterType::Pointer dilateFilter = DilateFilterType::New();
-  dilateFilter->SetInput( img );
-  KernalType           ball;
-  KernalType::SizeType ballSize;
-  for( int k = 0; k < 3; k++ )
+  if( extension == std::string(".vtk") )
     {
-    ballSize[k] = ballsize;
+    vtkSmartPointer<vtkPolyDataReader> pdReader = vtkSmartPointer<vtkPolyDataReader>::New();
+    pdReader->SetFileName(fileName.c_str() );
+    pdReader->Update();
+    polyData = pdReader->GetOutput();
+    }
+  else if( extension == std::string(".vtp") )
+    {
+    vtkSmartPointer<vtkXMLPolyDataReader> pdxReader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    pdxReader->SetFileName(fileName.c_str() );
+    pdxReader->Update();
+    polyData = pdxReader->GetOutput();
+    }
+  if( polyData == NULL || polyData->GetPoints() == NULL )
+    {
+    std::cerr << "Failed to read surface " << fileName << std::endl;
+    return vtkSmartPointer<vtkPolyData>();
     }
-  ball.SetRadius(ballSize);
-  ball.CreateStructuringElement();
-  dilateFilter->SetKernel( ball );
-  dilateFilter->Update();
-  return dilateFilter->GetOutput();
-}
-
-LabelImageType::Pointer BinaryOpeningFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
-{
-  LabelImageType::Pointer imgErode = BinaryErodeFilter3D( img, ballsize);
-
-  return BinaryDilateFilter3D( imgErode, ballsize );
-}
-
-LabelImageType::Pointer BinaryClosingFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
-{
-  LabelImageType::Pointer imgDilate = BinaryDilateFilter3D( img, ballsize );
 
-  return BinaryErodeFilter3D( imgDilate, ballsize );
+  // LPS vs RAS
+  vtkPoints * allPoints = polyData->GetPoints();
+  for( int k = 0; k < allPoints->GetNumberOfPoints(); k++ )
+    {
+    double* point = polyData->GetPoint( k );
+    point[0] = -point[0];
+    point[1] = -point[1];
+    allPoints->SetPoint( k, point[0], point[1], point[2] );
+    }
+  return polyData;
 }
 
 //
@@ -123,123 +109,40 @@ int DoIt( int argc, char * argv[])
   label->FillBuffer( 0 );
 
   // read the poly data
-  vtkSmartPointer<vtkPolyData> polyData;
-  vtkSmartPointer<vtkPolyDataReader> pdReader;
-  vtkSmartPointer<vtkXMLPolyDataReader> pdxReader;
-
-  // do we have vtk or vtp models?
-  std::string extension = itksys::SystemTools::LowerCase( itksys::SystemTools::GetFilenameLastExtension(surface) );
-  if( extension.empty() )
-    {
-    std::cerr << "Failed to find an extension for " << surface << std::endl;
-    return EXIT_FAILURE;
-    }
-
-  if( extension == std::string(".vtk") )
-    {
-    pdReader = vtkSmartPointer<vtkPolyDataReader>::New();
-    pdReader->SetFileName(surface.c_str() );
-    pdReader->Update();
-    polyData = pdReader->GetOutput();
-    }
-  else if( extension == std::string(".vtp") )
+  std::vector<std::string> surfaces(1, surface);
+  surfaces.insert(surfaces.end(), additionalSurfaces.begin(), additionalSurfaces.end());
+  std::vector<vtkSmartPointer<vtkPolyData> > polyDatas;
+  std::vector<vtkPolyData*> models;
+  std::vector<unsigned char> labelValues;
+  for( size_t n = 0; n < surfaces.size(); n++ )
     {
-    pdxReader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
-    pdxReader->SetFileName(surface.c_str() );
-    pdxReader->Update();
-    polyData = pdxReader->GetOutput();
-    }
-  if( polyData == NULL )
-    {
-    std::cerr << "Failed to read surface " << surface << std::endl;
-    return EXIT_FAILURE;
-    }
-
-  // LPS vs RAS
-
-  vtkPoints * allPoints = polyData->GetPoints();
-  for( int k = 0; k < allPoints->GetNumberOfPoints(); k++ )
-    {
-    double* point = polyData->GetPoint( k );
-    point[0] = -point[0];
-    point[1] = -point[1];
-    allPoints->SetPoint( k, point[0], point[1], point[2] );
-    }
-
-  // do it
-  vtkNew<vtkPolyDataPointSampler> sampler;
-
-#if (VTK_MAJOR_VERSION <= 5)
-  sampler->SetInput( polyData );
-#else
-  sampler->SetInputData( polyData );
-#endif
-  sampler->SetDistance( sampleDistance );
-  sampler->GenerateEdgePointsOn();
-  sampler->GenerateInteriorPointsOn();
-  sampler->GenerateVertexPointsOn();
-  sampler->Update();
-
-  std::cout << polyData->GetNumberOfPoints() << std::endl;
-  std::cout << sampler->GetOutput()->GetNumberOfPoints() << std::endl;
-  for( int k = 0; k < sampler->GetOutput()->GetNumberOfPoints(); k++ )
-    {
-    double *                  pt = sampler->GetOutput()->GetPoint( k );
-    LabelImageType::PointType pitk;
-    pitk[0] = pt[0];
-    pitk[1] = pt[1];
-    pitk[2] = pt[2];
-    LabelImageType::IndexType idx;
-    label->TransformPhysicalPointToIndex( pitk, idx );
-
-    if( label->GetLargestPossibleRegion().IsInside(idx) )
+    vtkSmartPointer<vtkPolyData> polyData = ReadModel(surfaces[n]);
+    if( polyData == NULL )
       {
-      label->SetPixel( idx, labelValue );
+      return EXIT_FAILURE;
       }
-    }
-
-  // do morphological closing
-  LabelImageType::Pointer                           closedLabel = BinaryClosingFilter3D( label, 2);
-  itk::ImageRegionIteratorWithIndex<LabelImageType> itLabel(closedLabel, closedLabel->GetLargestPossibleRegion() );
-
-  // do flood fill using binary threshold image function
-  typedef itk::BinaryThresholdImageFunction<LabelImageType> ImageFunctionType;
-  ImageFunctionType::Pointer func = ImageFunctionType::New();
-  func->SetInputImage( closedLabel );
-  func->ThresholdBelow(1);
-
-  LabelImageType::IndexType idx;
-  LabelImageType::PointType COG;
-
-  // set the centre of gravity
-  // double *bounds = polyData->GetBounds();
-  COG.Fill(0.0);
-  for( vtkIdType k = 0; k < polyData->GetNumberOfPoints(); k++ )
-    {
-    double *pt = polyData->GetPoint( k );
-    for( int m = 0; m < 3; m++ )
+    polyDatas.push_back(polyData);
+    models.push_back(polyData);
+    int value = labelValue;
+    if( n > 0 && n - 1 < additionalLabelValues.size() )
       {
-      COG[m] += pt[m];
+      value = additionalLabelValues[n - 1];
       }
+    labelValues.push_back( static_cast<unsigned char>(value) );
     }
-  for( int m = 0; m < 3; m++ )
-    {
-    COG[m] /= static_cast<float>( polyData->GetNumberOfPoints() );
-    }
-
-  label->TransformPhysicalPointToIndex( COG, idx );
 
-  itk::FloodFilledImageFunctionConditionalIterator<LabelImageType, ImageFunctionType> floodFill( closedLabel, func, idx );
-  for( floodFill.GoToBegin(); !floodFill.IsAtEnd(); ++floodFill )
+  // do it
+  if( surfaceSampling )
     {
-    LabelImageType::IndexType i = floodFill.GetIndex();
-    closedLabel->SetPixel( i, labelValue );
+    if( models.size() > 1 )
+      {
+      std::cerr << "Surface sampling only uses the first model" << std::endl;
+      }
+    ModelToLabelMap::SampleModel( label, models[0], labelValues[0], sampleDistance );
     }
-  LabelImageType::Pointer finalLabel = BinaryClosingFilter3D( closedLabel, 2);
-  for( itLabel.GoToBegin(); !itLabel.IsAtEnd(); ++itLabel )
+  else
     {
-    LabelImageType::IndexType i = itLabel.GetIndex();
-    label->SetPixel( i, finalLabel->GetPixel(i) );
+    ModelToLabelMap::RasterizeModels( label, models, labelValues );
     }
 
   typename WriterType::Pointer writer = WriterType::New();
@@ -0,0 +1,279 @@
+/*=========================================================================
+
+  Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================*/
+
+#ifndef __ModelToLabelMapRasterizer_h
+#define __ModelToLabelMapRasterizer_h
+
+// ITK includes
+#include <itkImage.h>
+#include <itkMultiThreader.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkTriangleFilter.h>
+#include <vtkVersion.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace ModelToLabelMap
+{
+
+typedef itk::Image<unsigned char, 3> LabelImageType;
+
+//----------------------------------------------------------------------------
+// Scanline rasterization of closed surfaces.
+//
+// A voxel is inside a surface if a ray cast from its center along the I axis
+// crosses the surface an odd number of times before the voxel. The crossings
+// are computed for each row of voxels by intersecting the row with the
+// triangles overlapping it, so that each voxel is classified exactly, however
+// thin the structure. Rays hitting an edge or a vertex are counted once
+// thanks to a consistent tie-breaking rule between adjacent triangles.
+//----------------------------------------------------------------------------
+
+struct Triangle
+{
+  /// Vertices in continuous index coordinates
+  double Points[3][3];
+  int Model;
+};
+
+struct RasterizerData
+{
+  unsigned char* Buffer;
+  long Size[3];
+  std::vector<Triangle> Triangles;
+  /// Indices of the triangles overlapping each row, rows ordered by (k, j)
+  std::vector<unsigned long> RowOffsets;
+  std::vector<unsigned int> RowTriangles;
+  std::vector<unsigned char> LabelValues;
+};
+
+//----------------------------------------------------------------------------
+// Twice the signed area of (u, v, p) in the (J, K) plane. The endpoints are
+// always used in the same order so that the two triangles sharing an edge
+// get exactly opposite values.
+inline double EdgeFunction(const double* u, const double* v, double pj, double pk)
+{
+  if (u[1] > v[1] || (u[1] == v[1] && u[2] > v[2]))
+    {
+    return -EdgeFunction(v, u, pj, pk);
+    }
+  return (v[1] - u[1]) * (pk - u[2]) - (v[2] - u[2]) * (pj - u[1]);
+}
+
+//----------------------------------------------------------------------------
+// Whether the points on the edge u->v of a counter-clockwise triangle belong
+// to the triangle. Exactly one of u->v and v->u owns the edge.
+inline bool OwnsEdge(const double* u, const double* v)
+{
+  return v[2] > u[2] || (v[2] == u[2] && v[1] < u[1]);
+}
+
+//----------------------------------------------------------------------------
+// Return true and the I coordinate of the intersection if the row (j, k)
+// crosses the triangle.
+inline bool IntersectRow(const Triangle& triangle, double j, double k, double& i)
+{
+  const double* a = triangle.Points[0];
+  const double* b = triangle.Points[1];
+  const double* c = triangle.Points[2];
+  double area = EdgeFunction(a, b, c[1], c[2]);
+  if (area == 0.)
+    {
+    // Parallel to the row, the neighbor triangles count the crossing
+    return false;
+    }
+  double w0 = EdgeFunction(b, c, j, k);
+  double w1 = EdgeFunction(c, a, j, k);
+  double w2 = EdgeFunction(a, b, j, k);
+  bool inside;
+  if (area > 0.)
+    {
+    inside = (w0 > 0. || (w0 == 0. && OwnsEdge(b, c))) &&
+             (w1 > 0. || (w1 == 0. && OwnsEdge(c, a))) &&
+             (w2 > 0. || (w2 == 0. && OwnsEdge(a, b)));
+    }
+  else
+    {
+    inside = (w0 < 0. || (w0 == 0. && OwnsEdge(c, b))) &&
+             (w1 < 0. || (w1 == 0. && OwnsEdge(a, c))) &&
+             (w2 < 0. || (w2 == 0. && OwnsEdge(b, a)));
+    }
+  if (!inside)
+    {
+    return false;
+    }
+  i = (w0 * a[0] + w1 * b[0] + w2 * c[0]) / (w0 + w1 + w2);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+inline ITK_THREAD_RETURN_TYPE RasterizeRows(void* arg)
+{
+  itk::MultiThreader::ThreadInfoStruct* info =
+    static_cast<itk::MultiThreader::ThreadInfoStruct*>(arg);
+  RasterizerData* data = static_cast<RasterizerData*>(info->UserData);
+  const unsigned long numberOfRows = data->Size[1] * data->Size[2];
+  const unsigned long firstRow = numberOfRows * info->ThreadID / info->NumberOfThreads;
+  const unsigned long lastRow = numberOfRows * (info->ThreadID + 1) / info->NumberOfThreads;
+
+  std::vector<std::vector<double> > crossings(data->LabelValues.size());
+  for (unsigned long row = firstRow; row < lastRow; ++row)
+    {
+    const double j = row % data->Size[1];
+    const double k = row / data->Size[1];
+    for (unsigned long t = data->RowOffsets[row]; t < data->RowOffsets[row + 1]; ++t)
+      {
+      const Triangle& triangle = data->Triangles[data->RowTriangles[t]];
+      double i;
+      if (IntersectRow(triangle, j, k, i))
+        {
+        crossings[triangle.Model].push_back(i);
+        }
+      }
+    unsigned char* rowBuffer = data->Buffer + row * data->Size[0];
+    // The last models are drawn over the first ones
+    for (size_t model = 0; model < crossings.size(); ++model)
+      {
+      std::vector<double>& modelCrossings = crossings[model];
+      std::sort(modelCrossings.begin(), modelCrossings.end());
+      // An unmatched crossing (open surface) is ignored
+      for (size_t n = 0; n + 1 < modelCrossings.size(); n += 2)
+        {
+        long start = std::max(0L, static_cast<long>(std::ceil(modelCrossings[n])));
+        long end = std::min(data->Size[0], static_cast<long>(std::ceil(modelCrossings[n + 1])));
+        for (long i = start; i < end; ++i)
+          {
+          rowBuffer[i] = data->LabelValues[model];
+          }
+        }
+      modelCrossings.clear();
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+/// Set the voxels of \a label whose center is inside the closed surface
+/// \a models[n] to \a labelValues[n], in a single pass over the rows of
+/// voxels split across threads. The surfaces must be in the physical space
+/// of the label map. The other voxels are left unchanged.
+inline void RasterizeModels(LabelImageType* label,
+                            const std::vector<vtkPolyData*>& models,
+                            const std::vector<unsigned char>& labelValues)
+{
+  RasterizerData data;
+  LabelImageType::RegionType region = label->GetBufferedRegion();
+  for (int n = 0; n < 3; ++n)
+    {
+    data.Size[n] = static_cast<long>(region.GetSize(n));
+    }
+  data.Buffer = label->GetBufferPointer();
+  data.LabelValues = labelValues;
+
+  // Triangles in continuous index coordinates of the buffer
+  for (size_t model = 0; model < models.size(); ++model)
+    {
+    vtkNew<vtkTriangleFilter> triangleFilter;
+#if (VTK_MAJOR_VERSION <= 5)
+    triangleFilter->SetInput(models[model]);
+#else
+    triangleFilter->SetInputData(models[model]);
+#endif
+    triangleFilter->PassVertsOff();
+    triangleFilter->PassLinesOff();
+    triangleFilter->Update();
+    vtkPolyData* triangles = triangleFilter->GetOutput();
+
+    vtkCellArray* polys = triangles->GetPolys();
+    vtkIdType npts = 0;
+    vtkIdType* pts = 0;
+    for (polys->InitTraversal(); polys->GetNextCell(npts, pts);)
+      {
+      if (npts != 3)
+        {
+        continue;
+        }
+      Triangle triangle;
+      triangle.Model = static_cast<int>(model);
+      for (int p = 0; p < 3; ++p)
+        {
+        LabelImageType::PointType point;
+        double* position = triangles->GetPoint(pts[p]);
+        point[0] = position[0];
+        point[1] = position[1];
+        point[2] = position[2];
+        itk::ContinuousIndex<double, 3> index;
+        label->TransformPhysicalPointToContinuousIndex(point, index);
+        for (int n = 0; n < 3; ++n)
+          {
+          triangle.Points[p][n] = index[n] - region.GetIndex(n);
+          }
+        }
+      data.Triangles.push_back(triangle);
+      }
+    }
+
+  // Bin the triangles by row: count, then fill
+  const unsigned long numberOfRows = data.Size[1] * data.Size[2];
+  std::vector<long> rowRanges(4 * data.Triangles.size());
+  data.RowOffsets.assign(numberOfRows + 1, 0);
+  for (size_t t = 0; t < data.Triangles.size(); ++t)
+    {
+    const Triangle& triangle = data.Triangles[t];
+    long* range = &rowRanges[4 * t];
+    for (int n = 1; n < 3; ++n)
+      {
+      double minimum = std::min(triangle.Points[0][n],
+                                std::min(triangle.Points[1][n], triangle.Points[2][n]));
+      double maximum = std::max(triangle.Points[0][n],
+                                std::max(triangle.Points[1][n], triangle.Points[2][n]));
+      range[2 * (n - 1)] = std::max(0L, static_cast<long>(std::ceil(minimum)));
+      range[2 * (n - 1) + 1] = std::min(data.Size[n] - 1, static_cast<long>(std::floor(maximum)));
+      }
+    for (long k = range[2]; k <= range[3]; ++k)
+      {
+      for (long j = range[0]; j <= range[1]; ++j)
+        {
+        ++data.RowOffsets[k * data.Size[1] + j + 1];
+        }
+      }
+    }
+  for (unsigned long row = 0; row < numberOfRows; ++row)
+    {
+    data.RowOffsets[row + 1] += data.RowOffsets[row];
+    }
+  data.RowTriangles.resize(data.RowOffsets[numberOfRows]);
+  std::vector<unsigned long> rowEnds(data.RowOffsets.begin(), data.RowOffsets.end() - 1);
+  for (size_t t = 0; t < data.Triangles.size(); ++t)
+    {
+    const long* range = &rowRanges[4 * t];
+    for (long k = range[2]; k <= range[3]; ++k)
+      {
+      for (long j = range[0]; j <= range[1]; ++j)
+        {
+        data.RowTriangles[rowEnds[k * data.Size[1] + j]++] = static_cast<unsigned int>(t);
+        }
+      }
+    }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetSingleMethod(RasterizeRows, &data);
+  threader->SingleMethodExecute();
+}
+
+} // end of ModelToLabelMap namespace
+
+#endif
@@ -0,0 +1,172 @@
+/*=========================================================================
+
+  Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================*/
+
+#ifndef __ModelToLabelMapSampler_h
+#define __ModelToLabelMapSampler_h
+
+// ITK includes
+#include <itkBinaryBallStructuringElement.h>
+#include <itkBinaryDilateImageFilter.h>
+#include <itkBinaryErodeImageFilter.h>
+#include <itkBinaryThresholdImageFunction.h>
+#include <itkFloodFilledImageFunctionConditionalIterator.h>
+#include <itkImage.h>
+#include <itkImageRegionIteratorWithIndex.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataPointSampler.h>
+#include <vtkVersion.h>
+
+namespace ModelToLabelMap
+{
+
+typedef itk::Image<unsigned char, 3> LabelImageType;
+
+//----------------------------------------------------------------------------
+// Surface sampling of earlier versions of ModelToLabelMap, kept to reproduce
+// their label maps. The voxels containing points sampled on the surface are
+// set, then closed, flood filled from the center of mass of the model and
+// closed again.
+//----------------------------------------------------------------------------
+
+//----------------------------------------------------------------------------
+inline LabelImageType::Pointer BinaryErodeFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
+{
+  typedef itk::BinaryBallStructuringElement<unsigned char, 3>                     KernalType;
+  typedef itk::BinaryErodeImageFilter<LabelImageType, LabelImageType, KernalType> ErodeFilterType;
+  ErodeFilterType::Pointer erodeFilter = ErodeFilterType::New();
+  erodeFilter->SetInput( img );
+
+  KernalType           ball;
+  KernalType::SizeType ballSize;
+  for( int k = 0; k < 3; k++ )
+    {
+    ballSize[k] = ballsize;
+    }
+  ball.SetRadius(ballSize);
+  ball.CreateStructuringElement();
+  erodeFilter->SetKernel( ball );
+  erodeFilter->Update();
+  return erodeFilter->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+inline LabelImageType::Pointer BinaryDilateFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
+{
+  typedef itk::BinaryBallStructuringElement<unsigned char, 3>                      KernalType;
+  typedef itk::BinaryDilateImageFilter<LabelImageType, LabelImageType, KernalType> DilateFilterType;
+  DilateFilterType::Pointer dilateFilter = DilateFilterType::New();
+  dilateFilter->SetInput( img );
+  KernalType           ball;
+  KernalType::SizeType ballSize;
+  for( int k = 0; k < 3; k++ )
+    {
+    ballSize[k] = ballsize;
+    }
+  ball.SetRadius(ballSize);
+  ball.CreateStructuringElement();
+  dilateFilter->SetKernel( ball );
+  dilateFilter->Update();
+  return dilateFilter->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+inline LabelImageType::Pointer BinaryClosingFilter3D( LabelImageType::Pointer & img, unsigned int ballsize )
+{
+  LabelImageType::Pointer imgDilate = BinaryDilateFilter3D( img, ballsize );
+
+  return BinaryErodeFilter3D( imgDilate, ballsize );
+}
+
+//----------------------------------------------------------------------------
+/// Set the voxels of \a label inside the surface \a polyData to
+/// \a labelValue by sampling the surface every \a sampleDistance. The
+/// surface must be in the physical space of the label map. All the voxels
+/// of \a label are overwritten.
+inline void SampleModel(LabelImageType::Pointer& label, vtkPolyData* polyData,
+                        unsigned char labelValue, double sampleDistance)
+{
+  vtkNew<vtkPolyDataPointSampler> sampler;
+
+#if (VTK_MAJOR_VERSION <= 5)
+  sampler->SetInput( polyData );
+#else
+  sampler->SetInputData( polyData );
+#endif
+  sampler->SetDistance( sampleDistance );
+  sampler->GenerateEdgePointsOn();
+  sampler->GenerateInteriorPointsOn();
+  sampler->GenerateVertexPointsOn();
+  sampler->Update();
+
+  for( int k = 0; k < sampler->GetOutput()->GetNumberOfPoints(); k++ )
+    {
+    double *                  pt = sampler->GetOutput()->GetPoint( k );
+    LabelImageType::PointType pitk;
+    pitk[0] = pt[0];
+    pitk[1] = pt[1];
+    pitk[2] = pt[2];
+    LabelImageType::IndexType idx;
+    label->TransformPhysicalPointToIndex( pitk, idx );
+
+    if( label->GetLargestPossibleRegion().IsInside(idx) )
+      {
+      label->SetPixel( idx, labelValue );
+      }
+    }
+
+  // do morphological closing
+  LabelImageType::Pointer                           closedLabel = BinaryClosingFilter3D( label, 2);
+  itk::ImageRegionIteratorWithIndex<LabelImageType> itLabel(closedLabel, closedLabel->GetLargestPossibleRegion() );
+
+  // do flood fill using binary threshold image function
+  typedef itk::BinaryThresholdImageFunction<LabelImageType> ImageFunctionType;
+  ImageFunctionType::Pointer func = ImageFunctionType::New();
+  func->SetInputImage( closedLabel );
+  func->ThresholdBelow(1);
+
+  LabelImageType::IndexType idx;
+  LabelImageType::PointType COG;
+
+  // set the centre of gravity
+  COG.Fill(0.0);
+  for( vtkIdType k = 0; k < polyData->GetNumberOfPoints(); k++ )
+    {
+    double *pt = polyData->GetPoint( k );
+    for( int m = 0; m < 3; m++ )
+      {
+      COG[m] += pt[m];
+      }
+    }
+  for( int m = 0; m < 3; m++ )
+    {
+    COG[m] /= static_cast<float>( polyData->GetNumberOfPoints() );
+    }
+
+  label->TransformPhysicalPointToIndex( COG, idx );
+
+  itk::FloodFilledImageFunctionConditionalIterator<LabelImageType, ImageFunctionType> floodFill( closedLabel, func, idx );
+  for( floodFill.GoToBegin(); !floodFill.IsAtEnd(); ++floodFill )
+    {
+    LabelImageType::IndexType i = floodFill.GetIndex();
+    closedLabel->SetPixel( i, labelValue );
+    }
+  LabelImageType::Pointer finalLabel = BinaryClosingFilter3D( closedLabel, 2);
+  for( itLabel.GoToBegin(); !itLabel.IsAtEnd(); ++itLabel )
+    {
+    LabelImageType::IndexType i = itLabel.GetIndex();
+    label->SetPixel( i, finalLabel->GetPixel(i) );
+    }
+}
+
+} // end of ModelToLabelMap namespace
+
+#endif
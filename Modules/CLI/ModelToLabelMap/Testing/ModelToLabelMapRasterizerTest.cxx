@@ -0,0 +1,162 @@
+#include "ModelToLabelMapRasterizer.h"
+#include "ModelToLabelMapSampler.h"
+
+// ITK includes
+#include <itkImageRegionConstIterator.h>
+#include <vnl/vnl_math.h>
+
+// VTK includes
+#include <vtkCubeSource.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <algorithm>
+#include <iostream>
+
+typedef ModelToLabelMap::LabelImageType LabelImageType;
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+LabelImageType::Pointer CreateLabel(long sizeI, long sizeJ, long sizeK)
+{
+  LabelImageType::RegionType region;
+  region.SetSize(0, sizeI);
+  region.SetSize(1, sizeJ);
+  region.SetSize(2, sizeK);
+  LabelImageType::Pointer label = LabelImageType::New();
+  label->SetRegions(region);
+  label->Allocate();
+  label->FillBuffer(0);
+  return label;
+}
+
+//----------------------------------------------------------------------------
+void CountLabels(LabelImageType* label, unsigned long counts[256])
+{
+  std::fill(counts, counts + 256, 0);
+  itk::ImageRegionConstIterator<LabelImageType> it(label, label->GetBufferedRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    ++counts[it.Get()];
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> CreateBox(double xmin, double xmax,
+                                       double ymin, double ymax,
+                                       double zmin, double zmax)
+{
+  vtkNew<vtkCubeSource> cube;
+  cube->SetBounds(xmin, xmax, ymin, ymax, zmin, zmax);
+  cube->Update();
+  return cube->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> CreateSphere(double x, double y, double z,
+                                          double radius, int resolution)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetCenter(x, y, z);
+  sphere->SetRadius(radius);
+  sphere->SetThetaResolution(resolution);
+  sphere->SetPhiResolution(resolution);
+  sphere->Update();
+  return sphere->GetOutput();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int ModelToLabelMapRasterizerTest(int, char * [])
+{
+  // Identity geometry: index == physical point
+  LabelImageType::Pointer label = CreateLabel(96, 64, 64);
+
+  // Box with faces on voxel centers: half-open along each axis
+  vtkSmartPointer<vtkPolyData> box = CreateBox(2., 22., 2., 12., 2., 42.);
+  // Sphere of radius 20 centered at (60, 32, 32)
+  const double radius = 20.;
+  vtkSmartPointer<vtkPolyData> sphere = CreateSphere(60., 32., 32., radius, 64);
+  // Slab thinner than a voxel, containing a single layer of voxel centers
+  vtkSmartPointer<vtkPolyData> slab = CreateBox(2., 22., 30., 60., 49.7, 50.3);
+
+  std::vector<vtkPolyData*> models;
+  models.push_back(box);
+  models.push_back(sphere);
+  models.push_back(slab);
+  std::vector<unsigned char> labelValues;
+  labelValues.push_back(1);
+  labelValues.push_back(2);
+  labelValues.push_back(3);
+  ModelToLabelMap::RasterizeModels(label, models, labelValues);
+
+  unsigned long counts[256];
+  CountLabels(label, counts);
+  if (counts[1] != 20 * 10 * 40)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of box voxels "
+              << counts[1] << std::endl;
+    return EXIT_FAILURE;
+    }
+  double sphereVolume = 4. / 3. * vnl_math::pi * radius * radius * radius;
+  if (counts[2] < 0.97 * sphereVolume || counts[2] > 1.01 * sphereVolume)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of sphere voxels "
+              << counts[2] << " for a volume of " << sphereVolume << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (counts[3] != 20 * 30)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of slab voxels "
+              << counts[3] << std::endl;
+    return EXIT_FAILURE;
+    }
+  LabelImageType::IndexType center = {{60, 32, 32}};
+  LabelImageType::IndexType outside = {{60, 32, 53}};
+  if (label->GetPixel(center) != 2 || label->GetPixel(outside) != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong sphere voxels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark: fine sphere in a large volume
+  LabelImageType::Pointer largeLabel = CreateLabel(256, 256, 256);
+  std::vector<vtkPolyData*> largeModels;
+  vtkSmartPointer<vtkPolyData> largeSphere = CreateSphere(128., 128., 128., 90., 400);
+  largeModels.push_back(largeSphere);
+  std::vector<unsigned char> largeLabelValues(1, 255);
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  ModelToLabelMap::RasterizeModels(largeLabel, largeModels, largeLabelValues);
+  timer->StopTimer();
+  const double rasterizeTime = timer->GetElapsedTime();
+  std::cout << "<DartMeasurement name=\"RasterizeTime\" type=\"numeric/double\">"
+            << rasterizeTime << "</DartMeasurement>" << std::endl;
+
+  // Same sphere with the surface sampling of earlier versions
+  LabelImageType::Pointer sampledLabel = CreateLabel(256, 256, 256);
+  timer->StartTimer();
+  ModelToLabelMap::SampleModel(sampledLabel, largeSphere, 255, 1.);
+  timer->StopTimer();
+  const double sampleTime = timer->GetElapsedTime();
+  std::cout << "<DartMeasurement name=\"SampleTime\" type=\"numeric/double\">"
+            << sampleTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"RasterizeSpeedup\" type=\"numeric/double\">"
+            << sampleTime / std::max(rasterizeTime, 1e-6) << "</DartMeasurement>" << std::endl;
+
+  CountLabels(largeLabel, counts);
+  sphereVolume = 4. / 3. * vnl_math::pi * 90. * 90. * 90.;
+  if (counts[255] < 0.99 * sphereVolume || counts[255] > 1.01 * sphereVolume)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of sphere voxels "
+              << counts[255] << " for a volume of " << sphereVolume << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
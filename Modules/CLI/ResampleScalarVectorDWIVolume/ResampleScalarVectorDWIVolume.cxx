@@ -28,6 +28,7 @@
 
 // ResampleScalarVectorDWIVolume includes
 #include "ResampleScalarVectorDWIVolumeCLP.h"
+#include "itkVectorImageResample.h"
 
 // ResampleDTIVolume includes
 #include "dtiprocessFiles/deformationfieldio.h"
@@ -1176,9 +1177,15 @@ int Rotate( parameters & list )
   typedef itk::ResampleImageFilter<ImageType, ImageType>   ResampleType;
   typedef itk::Transform<double, 3, 3>                     TransformType;
   typedef itk::VectorImage<PixelType, 3>                   VectorImageType;
-  typename ImageType::Pointer image;
+  typedef itk::VectorImageResample<PixelType>              VectorResampleType;
+  typename VectorImageType::Pointer        inputImage;
+  typename ImageType::Pointer              image;
   std::vector<typename ImageType::Pointer> vectorOfImage;
   itk::MetaDataDictionary                  dico;
+  // Linear and nearest neighbor interpolations resample all the components
+  // in a single pass, the other interpolators work on one component at a time
+  const bool singlePass = !list.interpolationType.compare( "linear" )
+    || !list.interpolationType.compare( "nn" );
   try
     {
     // open image file
@@ -1192,42 +1199,84 @@ int Rotate( parameters & list )
       }
     // Save metadata dictionary
     dico = reader->GetOutput()->GetMetaDataDictionary();
-    // Separate the vector image into a vector of images
-    SeparateImages<PixelType>( reader->GetOutput(), vectorOfImage );
+    inputImage = reader->GetOutput();
+    if( singlePass )
+      {
+      // Only the geometry of a component is needed to set up the transform
+      image = ImageType::New();
+      image->CopyInformation( inputImage );
+      }
+    else
+      {
+      // Separate the vector image into a vector of images
+      SeparateImages<PixelType>( inputImage, vectorOfImage );
+      image = vectorOfImage[0];
+      }
     }
   catch( itk::ExceptionObject exception )
     {
     std::cerr << exception << std::endl;
     return EXIT_FAILURE;
     }
-  // Set interpolator
-  typename InterpolatorType::Pointer interpol;
-  interpol = SetInterpolator<ImageType>( list );
   // Create resampler and initialize its output parameters
   typename ResampleType::Pointer resample = ResampleType::New();
-  SetOutputParameters<ImageType>( list, resample, vectorOfImage[0] );
+  SetOutputParameters<ImageType>( list, resample, image );
   TransformType::Pointer transform;
   // Load transforms and compute a merged transform
-  transform = SetAllTransform<ImageType>( list, resample, vectorOfImage[0] );
+  transform = SetAllTransform<ImageType>( list, resample, image );
   if( !transform )
     {
     return EXIT_FAILURE;
     }
-  resample->SetTransform( transform );
-  resample->SetInterpolator( interpol );
-  std::vector<typename ImageType::Pointer> vectorOutputImage;
-  // Resample all the images separately
-  for( ::size_t idx = 0; idx < vectorOfImage.size(); idx++ )
+  typename itk::VectorImage<PixelType, 3>::Pointer outputImage;
+  if( singlePass )
     {
-    resample->SetInput( vectorOfImage[idx] );
-    resample->Update();
-    vectorOutputImage.push_back( resample->GetOutput() );
-    vectorOutputImage[idx]->DisconnectPipeline();
+    typename VectorResampleType::Pointer vectorResample = VectorResampleType::New();
+    vectorResample->SetInput( inputImage );
+    vectorResample->SetTransform( transform );
+    vectorResample->SetInterpolation( !list.interpolationType.compare( "nn" ) ?
+                                      VectorResampleType::NearestNeighbor : VectorResampleType::Linear );
+    vectorResample->SetDefaultPixelValue( list.defaultPixelValue );
+    vectorResample->SetOutputOrigin( resample->GetOutputOrigin() );
+    vectorResample->SetOutputSpacing( resample->GetOutputSpacing() );
+    vectorResample->SetOutputSize( resample->GetSize() );
+    vectorResample->SetOutputDirection( resample->GetOutputDirection() );
+    if( list.numberOfThread )
+      {
+      vectorResample->SetNumberOfThreads( list.numberOfThread );
+      }
+    try
+      {
+      vectorResample->Update();
+      }
+    catch( itk::ExceptionObject exception )
+      {
+      std::cerr << exception << std::endl;
+      return EXIT_FAILURE;
+      }
+    outputImage = vectorResample->GetOutput();
+    outputImage->DisconnectPipeline();
+    }
+  else
+    {
+    // Set interpolator
+    typename InterpolatorType::Pointer interpol;
+    interpol = SetInterpolator<ImageType>( list );
+    resample->SetTransform( transform );
+    resample->SetInterpolator( interpol );
+    std::vector<typename ImageType::Pointer> vectorOutputImage;
+    // Resample all the images separately
+    for( ::size_t idx = 0; idx < vectorOfImage.size(); idx++ )
+      {
+      resample->SetInput( vectorOfImage[idx] );
+      resample->Update();
+      vectorOutputImage.push_back( resample->GetOutput() );
+      vectorOutputImage[idx]->DisconnectPipeline();
+      }
+    outputImage = itk::VectorImage<PixelType, 3>::New();
+    AddImage<PixelType>( outputImage, vectorOutputImage );
+    vectorOutputImage.clear();
     }
-  typename itk::VectorImage<PixelType, 3>::Pointer outputImage;
-  outputImage = itk::VectorImage<PixelType, 3>::New();
-  AddImage<PixelType>( outputImage, vectorOutputImage );
-  vectorOutputImage.clear();
   // If necessary, transform gradient vectors with the loaded transformations
   int dwmriProblem = CheckDWMRI( dico, transform );
   if( list.space ) // && list.transformationFile.compare( "" ) )
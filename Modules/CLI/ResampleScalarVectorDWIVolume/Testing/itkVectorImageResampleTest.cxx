@@ -0,0 +1,184 @@
+#include "itkVectorImageResample.h"
+
+// ITK includes
+#include <itkAffineTransform.h>
+#include <itkImageRegionIterator.h>
+#include <itkImageRegionIteratorWithIndex.h>
+#include <itkLinearInterpolateImageFunction.h>
+#include <itkNearestNeighborInterpolateImageFunction.h>
+#include <itkResampleImageFilter.h>
+#include <itkTimeProbe.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+template <class PixelType>
+typename itk::VectorImage<PixelType, 3>::Pointer
+CreateVectorImage(unsigned int size, unsigned int numberOfComponents)
+{
+  typedef itk::VectorImage<PixelType, 3> VectorImageType;
+  typename VectorImageType::Pointer image = VectorImageType::New();
+  typename VectorImageType::SizeType imageSize;
+  imageSize[0] = size;
+  imageSize[1] = size - 4;
+  imageSize[2] = size - 8;
+  image->SetRegions(imageSize);
+  typename VectorImageType::SpacingType spacing;
+  spacing[0] = 1.5;
+  spacing[1] = 1.;
+  spacing[2] = 2.;
+  image->SetSpacing(spacing);
+  typename VectorImageType::PointType origin;
+  origin[0] = -10.;
+  origin[1] = 5.;
+  origin[2] = 2.;
+  image->SetOrigin(origin);
+  image->SetVectorLength(numberOfComponents);
+  image->Allocate();
+
+  itk::VariableLengthVector<PixelType> value(numberOfComponents);
+  itk::ImageRegionIteratorWithIndex<VectorImageType> it(image, image->GetLargestPossibleRegion());
+  for (it.GoToBegin(); !it.IsAtEnd(); ++it)
+    {
+    typename VectorImageType::IndexType index = it.GetIndex();
+    for (unsigned int n = 0; n < numberOfComponents; ++n)
+      {
+      value[n] = static_cast<PixelType>(
+        100. * std::sin(0.1 * (n + 1) * index[0]) + 7. * index[1] - 3. * index[2] + n);
+      }
+    it.Set(value);
+    }
+  return image;
+}
+
+//----------------------------------------------------------------------------
+itk::AffineTransform<double, 3>::Pointer CreateTransform()
+{
+  itk::AffineTransform<double, 3>::Pointer transform = itk::AffineTransform<double, 3>::New();
+  itk::AffineTransform<double, 3>::OutputVectorType axis;
+  axis[0] = 0.2;
+  axis[1] = 0.3;
+  axis[2] = 1.;
+  transform->Rotate3D(axis, 0.3);
+  itk::AffineTransform<double, 3>::OutputVectorType translation;
+  translation[0] = 3.7;
+  translation[1] = -2.2;
+  translation[2] = 1.3;
+  transform->Translate(translation);
+  return transform;
+}
+
+//----------------------------------------------------------------------------
+// Compare the single pass resampling with a ResampleImageFilter run on each
+// component.
+template <class PixelType>
+bool TestResample(bool nearestNeighbor, unsigned int size, unsigned int numberOfComponents,
+                  double tolerance, const char* measurementName)
+{
+  typedef itk::VectorImage<PixelType, 3>                              VectorImageType;
+  typedef itk::Image<PixelType, 3>                                    ImageType;
+  typedef itk::VectorImageResample<PixelType>                         VectorResampleType;
+  typedef itk::ResampleImageFilter<ImageType, ImageType>              ResampleType;
+  typedef itk::LinearInterpolateImageFunction<ImageType, double>      LinearInterpolatorType;
+  typedef itk::NearestNeighborInterpolateImageFunction<ImageType, double> NearestInterpolatorType;
+
+  typename VectorImageType::Pointer input = CreateVectorImage<PixelType>(size, numberOfComponents);
+  itk::AffineTransform<double, 3>::Pointer transform = CreateTransform();
+  const double defaultPixelValue = -5.;
+
+  itk::TimeProbe singlePassProbe;
+  singlePassProbe.Start();
+  typename VectorResampleType::Pointer vectorResample = VectorResampleType::New();
+  vectorResample->SetInput(input);
+  vectorResample->SetTransform(transform);
+  vectorResample->SetInterpolation(nearestNeighbor ?
+                                   VectorResampleType::NearestNeighbor : VectorResampleType::Linear);
+  vectorResample->SetDefaultPixelValue(defaultPixelValue);
+  vectorResample->SetOutputParametersFromImage(input);
+  vectorResample->Update();
+  singlePassProbe.Stop();
+  typename VectorImageType::Pointer output = vectorResample->GetOutput();
+
+  itk::TimeProbe perComponentProbe;
+  double maximumDifference = 0.;
+  for (unsigned int n = 0; n < numberOfComponents; ++n)
+    {
+    typename ImageType::Pointer component = ImageType::New();
+    component->CopyInformation(input);
+    component->SetRegions(input->GetLargestPossibleRegion());
+    component->Allocate();
+    itk::ImageRegionConstIterator<VectorImageType> in(input, input->GetLargestPossibleRegion());
+    itk::ImageRegionIterator<ImageType> out(component, component->GetLargestPossibleRegion());
+    for (in.GoToBegin(), out.GoToBegin(); !in.IsAtEnd(); ++in, ++out)
+      {
+      out.Set(in.Get()[n]);
+      }
+
+    perComponentProbe.Start();
+    typename ResampleType::Pointer resample = ResampleType::New();
+    resample->SetInput(component);
+    resample->SetTransform(transform);
+    if (nearestNeighbor)
+      {
+      resample->SetInterpolator(NearestInterpolatorType::New());
+      }
+    else
+      {
+      resample->SetInterpolator(LinearInterpolatorType::New());
+      }
+    resample->SetDefaultPixelValue(static_cast<PixelType>(defaultPixelValue));
+    resample->SetOutputParametersFromImage(component);
+    resample->Update();
+    perComponentProbe.Stop();
+
+    itk::ImageRegionConstIterator<VectorImageType> resampled(output, output->GetLargestPossibleRegion());
+    itk::ImageRegionConstIterator<ImageType> expected(resample->GetOutput(),
+                                                      resample->GetOutput()->GetLargestPossibleRegion());
+    for (resampled.GoToBegin(), expected.GoToBegin(); !expected.IsAtEnd(); ++resampled, ++expected)
+      {
+      double difference = std::fabs(static_cast<double>(resampled.Get()[n]) - expected.Get());
+      maximumDifference = std::max(maximumDifference, difference);
+      }
+    }
+  if (maximumDifference > tolerance)
+    {
+    std::cerr << "Line " << __LINE__ << ": single pass resampling differs from "
+              << "per component resampling by " << maximumDifference << std::endl;
+    return false;
+    }
+
+  std::cout << "<DartMeasurement name=\"" << measurementName << "SinglePassTime\" type=\"numeric/double\">"
+            << singlePassProbe.GetTotal() << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"" << measurementName << "PerComponentTime\" type=\"numeric/double\">"
+            << perComponentProbe.GetTotal() << "</DartMeasurement>" << std::endl;
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int itkVectorImageResampleTest(int, char * [])
+{
+  // Nearest neighbor copies the input values: no difference allowed
+  if (!TestResample<short>(true, 32, 7, 0., "NearestNeighbor"))
+    {
+    return EXIT_FAILURE;
+    }
+  // Integer outputs are truncated, rounding errors may change them by one
+  if (!TestResample<short>(false, 32, 7, 1., "LinearShort"))
+    {
+    return EXIT_FAILURE;
+    }
+  // Benchmark on a DWI sized vector
+  if (!TestResample<float>(false, 64, 30, 1e-3, "LinearFloat"))
+    {
+    return EXIT_FAILURE;
+    }
+  return EXIT_SUCCESS;
+}
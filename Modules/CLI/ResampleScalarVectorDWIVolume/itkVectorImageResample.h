@@ -0,0 +1,115 @@
+/*=========================================================================
+
+  Program:   Slicer
+  Language:  C++
+  Module:    $HeadURL$
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See License.txt or http://www.slicer.org/copyright/copyright.txt for details.
+
+==========================================================================*/
+#ifndef __itkVectorImageResample_h
+#define __itkVectorImageResample_h
+
+#include <itkImageToImageFilter.h>
+#include <itkTransform.h>
+#include <itkVectorImage.h>
+
+namespace itk
+{
+/** \class VectorImageResample
+ *
+ * Resample all the components of a vector image at once.
+ * Each output voxel is mapped through the transform a single time and the
+ * same interpolation weights are applied to all its components, read
+ * contiguously from the input buffer. Only linear and nearest neighbor
+ * interpolations are supported; they give the same results as a
+ * ResampleImageFilter run on each component separately.
+ */
+template <class TPixel>
+class VectorImageResample
+  : public ImageToImageFilter<VectorImage<TPixel, 3>, VectorImage<TPixel, 3> >
+{
+public:
+  typedef VectorImage<TPixel, 3>                                 InputImageType;
+  typedef VectorImage<TPixel, 3>                                 OutputImageType;
+  typedef VectorImageResample                                    Self;
+  typedef ImageToImageFilter<InputImageType, OutputImageType>    Superclass;
+  typedef SmartPointer<Self>                                     Pointer;
+  typedef SmartPointer<const Self>                               ConstPointer;
+  typedef Transform<double, 3, 3>                                TransformType;
+  typedef typename OutputImageType::RegionType                   OutputImageRegionType;
+
+  enum InterpolationType
+    {
+    Linear,
+    NearestNeighbor
+    };
+
+  itkNewMacro( Self );
+  itkTypeMacro( VectorImageResample, ImageToImageFilter );
+
+// /Set the transform mapping the output points to the input points
+  itkSetConstObjectMacro( Transform, TransformType );
+  itkGetConstObjectMacro( Transform, TransformType );
+
+// /Set the interpolation, linear by default
+  itkSetMacro( Interpolation, InterpolationType );
+  itkGetMacro( Interpolation, InterpolationType );
+
+// /Set the value of all the components of the voxels mapped outside of the input image
+  itkSetMacro( DefaultPixelValue, double );
+  itkGetMacro( DefaultPixelValue, double );
+
+// /Set the output parameters (size, spacing, origin, orientation) from a reference image
+  void SetOutputParametersFromImage( const ImageBase<3> * image );
+
+  itkSetMacro( OutputOrigin, typename OutputImageType::PointType );
+  itkSetMacro( OutputSpacing, typename OutputImageType::SpacingType );
+  itkSetMacro( OutputSize, typename OutputImageType::SizeType );
+  itkSetMacro( OutputDirection, typename OutputImageType::DirectionType );
+
+  itkGetMacro( OutputOrigin, typename OutputImageType::PointType );
+  itkGetMacro( OutputSpacing, typename OutputImageType::SpacingType );
+  itkGetMacro( OutputSize, typename OutputImageType::SizeType );
+  itkGetMacro( OutputDirection, typename OutputImageType::DirectionType );
+
+// /Get the time of the last modification of the object
+  unsigned long GetMTime() const;
+
+protected:
+  VectorImageResample();
+
+  void BeforeThreadedGenerateData();
+
+  void ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
+
+  void GenerateOutputInformation();
+
+  void GenerateInputRequestedRegion();
+
+private:
+  VectorImageResample(const Self &);  // purposely not implemented
+  void operator=(const Self &);       // purposely not implemented
+
+  TPixel CastValue( double value ) const;
+
+  typename TransformType::ConstPointer m_Transform;
+  InterpolationType                    m_Interpolation;
+  double                               m_DefaultPixelValue;
+  typename OutputImageType::PointType m_OutputOrigin;
+  typename OutputImageType::SpacingType m_OutputSpacing;
+  typename OutputImageType::SizeType m_OutputSize;
+  typename OutputImageType::DirectionType m_OutputDirection;
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkVectorImageResample.txx"
+#endif
+
+#endif
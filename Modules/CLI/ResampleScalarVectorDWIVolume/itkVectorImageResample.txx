@@ -0,0 +1,262 @@
+/*=========================================================================
+
+  Program:   Slicer
+  Language:  C++
+  Module:    $HeadURL$
+  Date:      $Date$
+  Version:   $Revision$
+
+  Copyright (c) Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See License.txt or http://www.slicer.org/copyright/copyright.txt for details.
+
+==========================================================================*/
+#ifndef __itkVectorImageResample_txx
+#define __itkVectorImageResample_txx
+
+#include "itkVectorImageResample.h"
+
+#include <itkContinuousIndex.h>
+#include <itkNumericTraits.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace itk
+{
+
+template <class TPixel>
+VectorImageResample<TPixel>
+::VectorImageResample()
+{
+  this->SetNumberOfRequiredInputs( 1 );
+  m_Interpolation = Linear;
+  m_DefaultPixelValue = 0.0;
+  m_OutputSpacing.Fill( 1.0 );
+  m_OutputOrigin.Fill( 0.0 );
+  m_OutputDirection.SetIdentity();
+  m_OutputSize.Fill( 0 );
+}
+
+template <class TPixel>
+unsigned long
+VectorImageResample<TPixel>
+::GetMTime() const
+{
+  unsigned long latestTime = Superclass::GetMTime();
+
+  if( m_Transform.IsNotNull() )
+    {
+    if( latestTime < m_Transform->GetMTime() )
+      {
+      latestTime = m_Transform->GetMTime();
+      }
+    }
+  return latestTime;
+}
+
+template <class TPixel>
+void
+VectorImageResample<TPixel>
+::SetOutputParametersFromImage( const ImageBase<3> * image )
+{
+  m_OutputSize = image->GetLargestPossibleRegion().GetSize();
+  m_OutputSpacing = image->GetSpacing();
+  m_OutputDirection = image->GetDirection();
+  m_OutputOrigin = image->GetOrigin();
+  this->Modified();
+}
+
+template <class TPixel>
+void
+VectorImageResample<TPixel>
+::BeforeThreadedGenerateData()
+{
+  if( m_Transform.IsNull() )
+    {
+    itkExceptionMacro( << "Transform not set" );
+    }
+}
+
+// Same clamping as ResampleImageFilter, so that both give identical outputs
+template <class TPixel>
+TPixel
+VectorImageResample<TPixel>
+::CastValue( double value ) const
+{
+  if( value < static_cast<double>( NumericTraits<TPixel>::NonpositiveMin() ) )
+    {
+    return NumericTraits<TPixel>::NonpositiveMin();
+    }
+  if( value > static_cast<double>( NumericTraits<TPixel>::max() ) )
+    {
+    return NumericTraits<TPixel>::max();
+    }
+  return static_cast<TPixel>( value );
+}
+
+template <class TPixel>
+void
+VectorImageResample<TPixel>
+::ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread,
+                        ThreadIdType itkNotUsed(threadId) )
+{
+  const InputImageType * input = this->GetInput();
+  OutputImageType *      output = this->GetOutput();
+  const unsigned int     numberOfComponents = input->GetNumberOfComponentsPerPixel();
+
+  const typename InputImageType::RegionType inputRegion = input->GetBufferedRegion();
+  const TPixel * inputBuffer = input->GetBufferPointer();
+  long           inputSize[3];
+  long           inputStride[3];
+  for( int d = 0; d < 3; d++ )
+    {
+    inputSize[d] = static_cast<long>( inputRegion.GetSize( d ) );
+    }
+  // Strides in components, not in voxels
+  inputStride[0] = numberOfComponents;
+  inputStride[1] = inputStride[0] * inputSize[0];
+  inputStride[2] = inputStride[1] * inputSize[1];
+
+  const TPixel defaultValue = this->CastValue( m_DefaultPixelValue );
+  std::vector<double> values( numberOfComponents );
+
+  typename OutputImageType::IndexType index = outputRegionForThread.GetIndex();
+  const long startI = index[0];
+  const long endI = startI + static_cast<long>( outputRegionForThread.GetSize( 0 ) );
+  const long endJ = index[1] + static_cast<long>( outputRegionForThread.GetSize( 1 ) );
+  const long endK = index[2] + static_cast<long>( outputRegionForThread.GetSize( 2 ) );
+  Point<double, 3>          point;
+  ContinuousIndex<double, 3> continuousIndex;
+  for( index[2] = outputRegionForThread.GetIndex( 2 ); index[2] < endK; index[2]++ )
+    {
+    for( index[1] = outputRegionForThread.GetIndex( 1 ); index[1] < endJ; index[1]++ )
+      {
+      index[0] = startI;
+      TPixel * outputPixel = output->GetBufferPointer()
+        + output->ComputeOffset( index ) * numberOfComponents;
+      for( ; index[0] < endI; index[0]++, outputPixel += numberOfComponents )
+        {
+        output->TransformIndexToPhysicalPoint( index, point );
+        input->TransformPhysicalPointToContinuousIndex( m_Transform->TransformPoint( point ),
+                                                         continuousIndex );
+        // Buffer coordinates, inside if in [-0.5, size - 0.5) along each axis
+        double position[3];
+        bool   inside = true;
+        for( int d = 0; d < 3; d++ )
+          {
+          position[d] = continuousIndex[d] - inputRegion.GetIndex( d );
+          inside = inside && position[d] >= -0.5 && position[d] < inputSize[d] - 0.5;
+          }
+        if( !inside )
+          {
+          for( unsigned int n = 0; n < numberOfComponents; n++ )
+            {
+            outputPixel[n] = defaultValue;
+            }
+          continue;
+          }
+        if( m_Interpolation == NearestNeighbor )
+          {
+          const TPixel * inputPixel = inputBuffer;
+          for( int d = 0; d < 3; d++ )
+            {
+            long nearest = static_cast<long>( std::floor( position[d] + 0.5 ) );
+            nearest = std::min( std::max( nearest, 0L ), inputSize[d] - 1 );
+            inputPixel += nearest * inputStride[d];
+            }
+          for( unsigned int n = 0; n < numberOfComponents; n++ )
+            {
+            outputPixel[n] = inputPixel[n];
+            }
+          continue;
+          }
+        // Trilinear weights and neighbor offsets, clamped at the border of
+        // the buffer as in LinearInterpolateImageFunction
+        double weights[3][2];
+        long   offsets[3][2];
+        for( int d = 0; d < 3; d++ )
+          {
+          const double base = std::floor( position[d] );
+          const long   lower = static_cast<long>( base );
+          weights[d][1] = position[d] - base;
+          weights[d][0] = 1.0 - weights[d][1];
+          offsets[d][0] = std::max( lower, 0L ) * inputStride[d];
+          offsets[d][1] = std::min( lower + 1, inputSize[d] - 1 ) * inputStride[d];
+          }
+        std::fill( values.begin(), values.end(), 0.0 );
+        for( int corner = 0; corner < 8; corner++ )
+          {
+          const int    c0 = corner & 1;
+          const int    c1 = ( corner >> 1 ) & 1;
+          const int    c2 = ( corner >> 2 ) & 1;
+          const double weight = weights[0][c0] * weights[1][c1] * weights[2][c2];
+          if( weight == 0.0 )
+            {
+            continue;
+            }
+          const TPixel * inputPixel = inputBuffer + offsets[0][c0] + offsets[1][c1] + offsets[2][c2];
+          for( unsigned int n = 0; n < numberOfComponents; n++ )
+            {
+            values[n] += weight * static_cast<double>( inputPixel[n] );
+            }
+          }
+        for( unsigned int n = 0; n < numberOfComponents; n++ )
+          {
+          outputPixel[n] = this->CastValue( values[n] );
+          }
+        }
+      }
+    }
+}
+
+/**
+ * Inform pipeline of required output region
+ */
+template <class TPixel>
+void
+VectorImageResample<TPixel>
+::GenerateOutputInformation()
+{
+  // call the superclass' implementation of this method
+  Superclass::GenerateOutputInformation();
+  OutputImageType * outputPtr = this->GetOutput();
+  const InputImageType * inputPtr = this->GetInput();
+  if( !outputPtr || !inputPtr )
+    {
+    return;
+    }
+  outputPtr->SetSpacing( m_OutputSpacing );
+  outputPtr->SetOrigin( m_OutputOrigin );
+  outputPtr->SetDirection( m_OutputDirection );
+  typename OutputImageType::RegionType outputLargestPossibleRegion;
+  outputLargestPossibleRegion.SetSize( m_OutputSize );
+  outputPtr->SetLargestPossibleRegion( outputLargestPossibleRegion );
+  outputPtr->SetNumberOfComponentsPerPixel( inputPtr->GetNumberOfComponentsPerPixel() );
+}
+
+/**
+ * Inform pipeline of necessary input image region
+ *
+ * We cannot assume anything about the transform being used,
+ * so we request the entire input image.
+ */
+template <class TPixel>
+void
+VectorImageResample<TPixel>
+::GenerateInputRequestedRegion()
+{
+  // call the superclass's implementation of this method
+  Superclass::GenerateInputRequestedRegion();
+  if( !this->GetInput() )
+    {
+    return;
+    }
+  InputImageType * inputPtr = const_cast<InputImageType *>( this->GetInput() );
+  inputPtr->SetRequestedRegionToLargestPossibleRegion();
+}
+
+} // end namespace itk
+
+#endif
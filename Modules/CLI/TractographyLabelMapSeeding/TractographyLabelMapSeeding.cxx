@@ -279,14 +279,20 @@ int main( int argc, char * argv[] )
     streamer->SetIntegrationStepLength(IntegrationStepLength);
 
     // 5. Run the thing
-    seed->SeedStreamlinesInROI();
+    vtkNew<vtkPolyData> outFibers;
+    if ( WriteToFile )
+      {
+      seed->SeedStreamlinesInROI();
+      }
+    else
+      {
+      // 6. Trace the seeds in parallel directly into PolyData in RAS
+      seed->SeedStreamlinesInROIToPolyData(outFibers.GetPointer());
+      }
 
     // Save result
     if ( !WriteToFile )
       {
-      // 6. Extra5ct PolyData in RAS
-      vtkNew<vtkPolyData> outFibers;
-      seed->TransformStreamlinesToRASAndAppendToPolyData(outFibers.GetPointer());
 
       std::string fileExtension = vtksys::SystemTools::LowerCase( vtksys::SystemTools::GetFilenameLastExtension(OutputFibers.c_str()) );
       if (fileExtension == ".vtk")
@@ -22,25 +22,50 @@
 // MarkupsModule/MRMLDisplayableManager includes
 #include "vtkMRMLMarkupsDisplayableManagerHelper.h"
 
+// MarkupsModule/VTKWidgets includes
+#include <vtkMarkupsGlyphSource2D.h>
+#include <vtkMarkupsPointSet.h>
+
 // VTK includes
 #include <vtkAbstractWidget.h>
+#include <vtkActor.h>
+#include <vtkActor2D.h>
 #include <vtkCollection.h>
+#include <vtkDataObject.h>
+#include <vtkGeneralTransform.h>
+#include <vtkGlyph3D.h>
+#include <vtkGlyph3DMapper.h>
 #include <vtkHandleWidget.h>
+#include <vtkLabeledDataMapper.h>
+#include <vtkLabelPlacementMapper.h>
+#include <vtkLookupTable.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointSetToLabelHierarchy.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkPolyDataMapper2D.h>
+#include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #if (VTK_MAJOR_VERSION >= 6)
 #include <vtkPickingManager.h>
 #endif
+#include <vtkRenderer.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSeedRepresentation.h>
 #include <vtkSeedWidget.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereHandleRepresentation.h>
+#include <vtkSphereSource.h>
+#include <vtkTextProperty.h>
+#include <vtkTransform.h>
+#include <vtkTransformPolyDataFilter.h>
 
 // MRML includes
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSliceNode.h>
+#include <vtkMRMLTransformNode.h>
 
 // STD includes
 #include <algorithm>
@@ -105,6 +130,13 @@ void vtkMRMLMarkupsDisplayableManagerHelper::PrintSelf(ostream& os, vtkIndent in
     os << indent.GetNextIndent() << it->first.c_str() << " : projection is "
        << (it->second ? "not null" : "null") << std::endl;
     }
+
+  os << indent << "Point sets:" << std::endl;
+  for (PointSetsIt it = this->PointSets.begin(); it != this->PointSets.end(); ++it)
+    {
+    os << indent.GetNextIndent() << it->first->GetID() << " : "
+       << it->second.PointSet->GetNumberOfPoints() << " points" << std::endl;
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -121,6 +153,7 @@ vtkMRMLMarkupsDisplayableManagerHelper::~vtkMRMLMarkupsDisplayableManagerHelper(
     this->RemoveSeeds();
     }
   this->RemoveAllWidgetsAndNodes();
+  this->RemoveAllPointSets();
 }
 
 //---------------------------------------------------------------------------
@@ -221,7 +254,12 @@ void vtkMRMLMarkupsDisplayableManagerHelper::UpdateLocked(vtkMRMLMarkupsNode *no
     widget->ProcessEventsOn();
     // is it a seed widget that can support individually locked seeds?
     vtkSeedWidget *seedWidget = vtkSeedWidget::SafeDownCast(widget);
-    if (seedWidget)
+    // large lists drawn as point sets only have a seed for the markup under
+    // the mouse, its lock is set when the seed is created
+    vtkSeedRepresentation *seedRepresentation = seedWidget ?
+      vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation()) : 0;
+    if (seedWidget && seedRepresentation &&
+        seedRepresentation->GetNumberOfSeeds() == node->GetNumberOfMarkups())
       {
       vtkDebugMacro("UpdateLocked: have a seed widget, list unlocked, checking seeds");
       int numMarkups = node->GetNumberOfMarkups();
@@ -695,3 +733,337 @@ void vtkMRMLMarkupsDisplayableManagerHelper::PrintNodeGlyphTypes()
       }
     }
 }
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetPoints(
+  vtkMarkupsPointSet* pointSet, vtkMRMLMarkupsNode* markupsNode, unsigned long& updateTime)
+{
+  if (!pointSet || !markupsNode)
+    {
+    return;
+    }
+  // the world positions depend on the parent transforms
+  unsigned long modifiedTime = markupsNode->GetMTime();
+  for (vtkMRMLTransformNode* transformNode = markupsNode->GetParentTransformNode();
+       transformNode; transformNode = transformNode->GetParentTransformNode())
+    {
+    modifiedTime = std::max(modifiedTime, transformNode->GetMTime());
+    }
+  int numberOfMarkups = markupsNode->GetNumberOfMarkups();
+  if (modifiedTime <= updateTime && numberOfMarkups == pointSet->GetNumberOfPoints())
+    {
+    return;
+    }
+
+  // same transform as GetMarkupPointWorld(), computed once for all the markups
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformToWorld->Identity();
+  vtkMRMLTransformNode* transformNode = markupsNode->GetParentTransformNode();
+  if (transformNode && !transformNode->IsTransformToWorldLinear())
+    {
+    transformNode->GetTransformToWorld(transformToWorld.GetPointer());
+    }
+  else if (transformNode)
+    {
+    vtkNew<vtkMatrix4x4> matrixTransformToWorld;
+    transformNode->GetMatrixTransformToWorld(matrixTransformToWorld.GetPointer());
+    transformToWorld->Concatenate(matrixTransformToWorld.GetPointer());
+    }
+
+  pointSet->SetNumberOfPoints(numberOfMarkups);
+  for (int n = 0; n < numberOfMarkups; ++n)
+    {
+    double point[3];
+    double world[3];
+    markupsNode->GetMarkupPoint(n, 0, point);
+    transformToWorld->TransformPoint(point, world);
+    pointSet->SetPoint(n, world,
+                       markupsNode->GetNthMarkupVisibility(n),
+                       markupsNode->GetNthMarkupSelected(n),
+                       markupsNode->GetNthMarkupLabel(n).c_str());
+    }
+  updateTime = modifiedTime;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::UpdateNthPointSetPoint(
+  vtkMarkupsPointSet* pointSet, vtkMRMLMarkupsNode* markupsNode, int n)
+{
+  if (!pointSet || !markupsNode || n < 0 || n >= markupsNode->GetNumberOfMarkups())
+    {
+    return;
+    }
+  double world[4];
+  markupsNode->GetMarkupPointWorld(n, 0, world);
+  pointSet->SetPoint(n, world,
+                     markupsNode->GetNthMarkupVisibility(n),
+                     markupsNode->GetNthMarkupSelected(n),
+                     markupsNode->GetNthMarkupLabel(n).c_str());
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsDisplayableManagerHelper::PointSetPipeline*
+vtkMRMLMarkupsDisplayableManagerHelper::GetPointSet(vtkMRMLMarkupsNode* node)
+{
+  PointSetsIt it = this->PointSets.find(node);
+  return it != this->PointSets.end() ? &it->second : 0;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsDisplayableManagerHelper::PointSetPipeline*
+vtkMRMLMarkupsDisplayableManagerHelper::AddPointSet(
+  vtkMRMLMarkupsNode* node, vtkRenderer* renderer, bool sliceView)
+{
+  this->RemovePointSet(node);
+  PointSetPipeline& pipeline = this->PointSets[node];
+  pipeline.PointSet = vtkSmartPointer<vtkMarkupsPointSet>::New();
+  pipeline.Renderer = renderer;
+  pipeline.SliceView = sliceView;
+  pipeline.UpdateTime = 0;
+  pipeline.GlyphType = vtkMRMLMarkupsDisplayNode::GlyphMin - 1;
+  pipeline.GlyphScale = 1.;
+
+  pipeline.GlyphOrientation = vtkSmartPointer<vtkMatrix4x4>::New();
+  pipeline.GlyphTransform = vtkSmartPointer<vtkTransform>::New();
+  pipeline.GlyphSource = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
+  pipeline.GlyphSource->SetTransform(pipeline.GlyphTransform);
+
+  // the "Selected" array picks the color in the lookup table
+  pipeline.LookupTable = vtkSmartPointer<vtkLookupTable>::New();
+  pipeline.LookupTable->SetNumberOfTableValues(2);
+  pipeline.LookupTable->SetTableRange(0., 1.);
+
+  pipeline.TextProperty = vtkSmartPointer<vtkTextProperty>::New();
+  pipeline.TextProperty->SetJustificationToLeft();
+  pipeline.TextProperty->SetVerticalJustificationToBottom();
+  pipeline.LabelActor = vtkSmartPointer<vtkActor2D>::New();
+  pipeline.LabelActor->PickableOff();
+
+  if (sliceView)
+    {
+    // the glyphs and labels are made at the display position of the points
+    // that are on the slice, which are few
+    vtkPolyData* displayPolyData = pipeline.PointSet->GetDisplayPolyData();
+    vtkNew<vtkGlyph3D> glyph3D;
+#if (VTK_MAJOR_VERSION <= 5)
+    glyph3D->SetInput(displayPolyData);
+#else
+    glyph3D->SetInputData(displayPolyData);
+#endif
+    glyph3D->SetSourceConnection(pipeline.GlyphSource->GetOutputPort());
+    glyph3D->SetInputArrayToProcess(3, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "Selected");
+    glyph3D->SetScaleModeToDataScalingOff();
+    glyph3D->SetColorModeToColorByScalar();
+    glyph3D->OrientOff();
+
+    vtkNew<vtkPolyDataMapper2D> mapper;
+    mapper->SetInputConnection(glyph3D->GetOutputPort());
+    mapper->SetLookupTable(pipeline.LookupTable);
+    mapper->SetColorModeToMapScalars();
+    mapper->SetScalarRange(0., 1.);
+    mapper->UseLookupTableScalarRangeOn();
+    vtkNew<vtkActor2D> actor;
+    actor->SetMapper(mapper.GetPointer());
+    pipeline.Actor = actor.GetPointer();
+
+    vtkNew<vtkLabeledDataMapper> labelMapper;
+#if (VTK_MAJOR_VERSION <= 5)
+    labelMapper->SetInput(displayPolyData);
+#else
+    labelMapper->SetInputData(displayPolyData);
+#endif
+    labelMapper->SetCoordinateSystem(vtkLabeledDataMapper::DISPLAY);
+    labelMapper->SetLabelModeToLabelFieldData();
+    labelMapper->SetFieldDataName("Label");
+    labelMapper->SetLabelTextProperty(pipeline.TextProperty);
+    pipeline.LabelActor->SetMapper(labelMapper.GetPointer());
+    }
+  else
+    {
+    // the glyph is instanced at every point by the mapper, the "Visibility"
+    // array scales the hidden glyphs down to nothing
+    vtkPolyData* worldPolyData = pipeline.PointSet->GetWorldPolyData();
+    vtkNew<vtkGlyph3DMapper> mapper;
+#if (VTK_MAJOR_VERSION <= 5)
+    mapper->SetInputConnection(worldPolyData->GetProducerPort());
+#else
+    mapper->SetInputData(worldPolyData);
+#endif
+    mapper->SetSourceConnection(pipeline.GlyphSource->GetOutputPort());
+    mapper->SetScaleArray("Visibility");
+    mapper->SetScaleModeToScaleByMagnitude();
+    mapper->ClampingOff();
+    mapper->OrientOff();
+    mapper->SetScalarModeToUsePointFieldData();
+    mapper->SelectColorArray("Selected");
+    mapper->SetLookupTable(pipeline.LookupTable);
+    mapper->SetColorModeToMapScalars();
+    mapper->SetScalarRange(0., 1.);
+    mapper->UseLookupTableScalarRangeOn();
+    vtkNew<vtkActor> actor;
+    actor->SetMapper(mapper.GetPointer());
+    pipeline.Actor = actor.GetPointer();
+
+    // the labels are placed from a hierarchy built when the points change,
+    // only the labels that fit in the view without overlapping are drawn.
+    // The hidden points have no label and the lowest priority.
+    vtkNew<vtkPointSetToLabelHierarchy> labelHierarchy;
+#if (VTK_MAJOR_VERSION <= 5)
+    labelHierarchy->SetInput(worldPolyData);
+#else
+    labelHierarchy->SetInputData(worldPolyData);
+#endif
+    labelHierarchy->SetLabelArrayName("Label");
+    labelHierarchy->SetPriorityArrayName("Visibility");
+    labelHierarchy->SetTextProperty(pipeline.TextProperty);
+    vtkNew<vtkLabelPlacementMapper> labelMapper;
+    labelMapper->SetInputConnection(labelHierarchy->GetOutputPort());
+    pipeline.LabelActor->SetMapper(labelMapper.GetPointer());
+    }
+  pipeline.Actor->PickableOff();
+
+  if (renderer)
+    {
+    renderer->AddViewProp(pipeline.Actor);
+    renderer->AddViewProp(pipeline.LabelActor);
+    }
+  return &pipeline;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::RemovePointSet(vtkMRMLMarkupsNode* node)
+{
+  PointSetsIt it = this->PointSets.find(node);
+  if (it == this->PointSets.end())
+    {
+    return;
+    }
+  if (it->second.Renderer)
+    {
+    it->second.Renderer->RemoveViewProp(it->second.Actor);
+    it->second.Renderer->RemoveViewProp(it->second.LabelActor);
+    }
+  this->PointSets.erase(it);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::RemoveAllPointSets()
+{
+  while (!this->PointSets.empty())
+    {
+    this->RemovePointSet(this->PointSets.begin()->first);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetDisplay(
+  PointSetPipeline* pipeline, vtkMRMLMarkupsDisplayNode* displayNode,
+  double glyphScale, bool visible)
+{
+  if (!pipeline || !displayNode)
+    {
+    return;
+    }
+  vtkMRMLMarkupsDisplayableManagerHelper::SetPointSetGlyphType(
+    pipeline, displayNode->GetGlyphType());
+  if (pipeline->GlyphScale != glyphScale)
+    {
+    pipeline->GlyphScale = glyphScale;
+    vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetGlyphTransform(pipeline);
+    }
+
+  // same colors as the handles
+  double* color = displayNode->GetColor();
+  double* selectedColor = displayNode->GetSelectedColor();
+  pipeline->LookupTable->SetTableValue(0, color[0], color[1], color[2], 1.);
+  pipeline->LookupTable->SetTableValue(1, selectedColor[0], selectedColor[1], selectedColor[2], 1.);
+  if (vtkActor* actor = vtkActor::SafeDownCast(pipeline->Actor))
+    {
+    vtkProperty* prop = actor->GetProperty();
+    prop->SetOpacity(displayNode->GetOpacity());
+    prop->SetAmbient(displayNode->GetAmbient());
+    prop->SetDiffuse(displayNode->GetDiffuse());
+    prop->SetSpecular(displayNode->GetSpecular());
+    }
+  else if (vtkActor2D* actor2D = vtkActor2D::SafeDownCast(pipeline->Actor))
+    {
+    actor2D->GetProperty()->SetOpacity(displayNode->GetOpacity());
+    }
+  vtkTextProperty* textProperty = pipeline->TextProperty;
+  textProperty->SetFontSize(std::max(1, static_cast<int>(4. * displayNode->GetTextScale())));
+  textProperty->SetColor(color);
+  textProperty->SetOpacity(displayNode->GetOpacity());
+
+  pipeline->Actor->SetVisibility(visible);
+  pipeline->LabelActor->SetVisibility(visible && displayNode->GetTextScale() > 0.);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::SetPointSetGlyphOrientation(
+  PointSetPipeline* pipeline, vtkMatrix4x4* orientation)
+{
+  if (!pipeline || !orientation)
+    {
+    return;
+    }
+  pipeline->GlyphOrientation->DeepCopy(orientation);
+  vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetGlyphTransform(pipeline);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::SetPointSetGlyphType(
+  PointSetPipeline* pipeline, int glyphType)
+{
+  if (pipeline->GlyphType == glyphType)
+    {
+    return;
+    }
+  pipeline->GlyphType = glyphType;
+  vtkSmartPointer<vtkPolyDataAlgorithm> source;
+  if (glyphType == vtkMRMLMarkupsDisplayNode::Sphere3D && !pipeline->SliceView)
+    {
+    vtkNew<vtkSphereSource> sphereSource;
+    sphereSource->SetRadius(0.5);
+    sphereSource->SetPhiResolution(10);
+    sphereSource->SetThetaResolution(10);
+    source = sphereSource.GetPointer();
+    }
+  else
+    {
+    // the 3d glyphs are mapped to 2d glyphs in the slice views, and the 3d
+    // diamond isn't supported yet
+    if (glyphType == vtkMRMLMarkupsDisplayNode::Sphere3D)
+      {
+      glyphType = vtkMRMLMarkupsDisplayNode::Circle2D;
+      }
+    else if (glyphType == vtkMRMLMarkupsDisplayNode::Diamond3D)
+      {
+      glyphType = vtkMRMLMarkupsDisplayNode::Diamond2D;
+      }
+    else if (glyphType >= vtkMRMLMarkupsDisplayNode::Sphere3D)
+      {
+      glyphType = vtkMRMLMarkupsDisplayNode::StarBurst2D;
+      }
+    vtkNew<vtkMarkupsGlyphSource2D> glyphSource;
+    glyphSource->SetGlyphType(glyphType);
+    glyphSource->SetScale(1.0);
+    source = glyphSource.GetPointer();
+    }
+  source->Update();
+  vtkNew<vtkPolyData> glyph;
+  glyph->DeepCopy(source->GetOutput());
+#if (VTK_MAJOR_VERSION <= 5)
+  pipeline->GlyphSource->SetInput(glyph.GetPointer());
+#else
+  pipeline->GlyphSource->SetInputData(glyph.GetPointer());
+#endif
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetGlyphTransform(
+  PointSetPipeline* pipeline)
+{
+  // only the glyph is transformed, the points are not touched
+  pipeline->GlyphTransform->SetMatrix(pipeline->GlyphOrientation);
+  pipeline->GlyphTransform->Scale(pipeline->GlyphScale, pipeline->GlyphScale, pipeline->GlyphScale);
+}
@@ -38,12 +38,23 @@
 #include <vtkHandleWidget.h>
 #include <vtkSeedWidget.h>
 #include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
 
 // MRML includes
 #include <vtkMRMLSliceNode.h>
 #include <vtkMRMLInteractionNode.h>
 class vtkMRMLMarkupsDisplayNode;
 
+class vtkActor2D;
+class vtkLookupTable;
+class vtkMarkupsPointSet;
+class vtkMatrix4x4;
+class vtkProp;
+class vtkRenderer;
+class vtkTextProperty;
+class vtkTransform;
+class vtkTransformPolyDataFilter;
+
 /// \ingroup Slicer_QtModules_Markups
 class VTK_SLICER_MARKUPS_MODULE_MRMLDISPLAYABLEMANAGER_EXPORT vtkMRMLMarkupsDisplayableManagerHelper :
     public vtkObject
@@ -109,6 +120,34 @@ public:
   /// .. and its associated convenient typedef
   typedef std::map<std::string, vtkAbstractWidget*>::iterator WidgetPointProjectionsIt;
 
+  /// Glyphs and labels of a list drawn as a point set instead of a widget
+  struct PointSetPipeline
+  {
+    vtkSmartPointer<vtkMarkupsPointSet> PointSet;
+    /// Rotation of the glyph toward the camera in 3D views
+    vtkSmartPointer<vtkMatrix4x4> GlyphOrientation;
+    /// Rotation and scale of the glyph
+    vtkSmartPointer<vtkTransform> GlyphTransform;
+    vtkSmartPointer<vtkTransformPolyDataFilter> GlyphSource;
+    vtkSmartPointer<vtkLookupTable> LookupTable;
+    /// vtkActor with a vtkGlyph3DMapper in 3D views, vtkActor2D in slice views
+    vtkSmartPointer<vtkProp> Actor;
+    vtkSmartPointer<vtkTextProperty> TextProperty;
+    vtkSmartPointer<vtkActor2D> LabelActor;
+    vtkWeakPointer<vtkRenderer> Renderer;
+    bool SliceView;
+    /// Modification time of the node and its transforms at the last update
+    unsigned long UpdateTime;
+    int GlyphType;
+    double GlyphScale;
+  };
+
+  /// Map of point set pipelines indexed using associated node
+  std::map<vtkMRMLMarkupsNode*, PointSetPipeline> PointSets;
+
+  /// .. and its associated convenient typedef
+  typedef std::map<vtkMRMLMarkupsNode*, PointSetPipeline>::iterator PointSetsIt;
+
   //
   // End of The Lists!!
   //
@@ -135,6 +174,43 @@ public:
   /// Clear out the saved list of glyph types, called on scene close or node removed
   void ClearNodeGlyphTypes();
 
+  /// Copy the first point of every markup of a list drawn as a point set,
+  /// in world coordinates. The markups are only read again if the node or
+  /// its parent transforms were modified after updateTime, which is then
+  /// set. The point set only marks the points that changed, so appending a
+  /// markup reprojects a single point, but all the markups are compared.
+  static void UpdatePointSetPoints(vtkMarkupsPointSet* pointSet,
+                                   vtkMRMLMarkupsNode* markupsNode,
+                                   unsigned long& updateTime);
+  /// Copy the first point of the nth markup in a point set
+  static void UpdateNthPointSetPoint(vtkMarkupsPointSet* pointSet,
+                                     vtkMRMLMarkupsNode* markupsNode, int n);
+
+  /// Get the point set pipeline of a node, null if the node is drawn with a
+  /// widget
+  PointSetPipeline* GetPointSet(vtkMRMLMarkupsNode* node);
+  /// Create the point set pipeline of a node and add its actors to the
+  /// renderer. In 3D views the glyphs are instanced by a vtkGlyph3DMapper on
+  /// the world points and the labels are placed from a label hierarchy so
+  /// that overlapping labels are culled. In slice views, the glyphs and
+  /// labels are only made for the points on the slice.
+  PointSetPipeline* AddPointSet(vtkMRMLMarkupsNode* node, vtkRenderer* renderer,
+                                bool sliceView);
+  /// Remove the point set pipeline of a node and its actors
+  void RemovePointSet(vtkMRMLMarkupsNode* node);
+  /// Remove all the point set pipelines
+  void RemoveAllPointSets();
+
+  /// Copy the glyph type, glyph scale, colors and visibility of the display
+  /// node. The glyph scale is in millimeters in 3D views and in pixels in
+  /// slice views.
+  static void UpdatePointSetDisplay(PointSetPipeline* pipeline,
+                                    vtkMRMLMarkupsDisplayNode* displayNode,
+                                    double glyphScale, bool visible);
+  /// Rotate the glyphs of a point set in a 3D view
+  static void SetPointSetGlyphOrientation(PointSetPipeline* pipeline,
+                                          vtkMatrix4x4* orientation);
+
 protected:
 
   vtkMRMLMarkupsDisplayableManagerHelper();
@@ -143,6 +219,11 @@ protected:
   /// utility method to print out the current glyph types
   void PrintNodeGlyphTypes();
 
+  /// Replace the glyph of a point set, with the same shapes as the handles
+  static void SetPointSetGlyphType(PointSetPipeline* pipeline, int glyphType);
+  /// Combine the orientation and the scale of the glyph of a point set
+  static void UpdatePointSetGlyphTransform(PointSetPipeline* pipeline);
+
 private:
 
   vtkMRMLMarkupsDisplayableManagerHelper(const vtkMRMLMarkupsDisplayableManagerHelper&); /// Not implemented
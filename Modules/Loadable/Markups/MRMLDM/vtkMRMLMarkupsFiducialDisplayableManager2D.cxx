@@ -25,6 +25,7 @@
 
 // MarkupsModule/VTKWidgets includes
 #include <vtkMarkupsGlyphSource2D.h>
+#include <vtkMarkupsPointSet.h>
 
 // MRMLDisplayableManager includes
 #include <vtkSliceViewInteractorStyle.h>
@@ -33,13 +34,17 @@
 #include <vtkMRMLInteractionNode.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSelectionNode.h>
+#include <vtkMRMLSliceNode.h>
 
 // VTK includes
 #include <vtkAbstractWidget.h>
+#include <vtkActor2D.h>
+#include <vtkCallbackCommand.h>
 #include <vtkFollower.h>
 #include <vtkHandleRepresentation.h>
 #include <vtkInteractorStyle.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkOrientedPolygonalHandleRepresentation3D.h>
@@ -47,6 +52,7 @@
 #include <vtkPickingManager.h>
 #endif
 #include <vtkPointHandleRepresentation2D.h>
+#include <vtkProp.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
@@ -55,8 +61,12 @@
 #include <vtkSeedRepresentation.h>
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -92,6 +102,19 @@ public:
       }
     // sanity checks end
 
+    // the seeds don't match the markups when the list is drawn as a point set
+    int markupIndex = -1;
+    if (callData != NULL)
+      {
+      markupIndex = *reinterpret_cast<int *>(callData);
+      vtkMRMLMarkupsFiducialDisplayableManager2D* fiducialDisplayableManager =
+        vtkMRMLMarkupsFiducialDisplayableManager2D::SafeDownCast(this->DisplayableManager);
+      if (fiducialDisplayableManager)
+        {
+        markupIndex = fiducialDisplayableManager->GetMarkupIndexFromSeedIndex(this->Node, markupIndex);
+        }
+      }
+
     //
     // mark the Node with an attribute to indicate if it is currently being interacted with
     // so that other code can respond to changes only when it is not moving
@@ -109,8 +132,7 @@ public:
           {
           this->Node->SetAttribute("Markups.MovingInSliceView", sliceNode->GetLayoutName());
           std::ostringstream seedNumber;
-          unsigned int *n =  reinterpret_cast<unsigned int *>(callData);
-          seedNumber << *n;
+          seedNumber << markupIndex;
           this->Node->SetAttribute("Markups.MovingMarkupIndex", seedNumber.str().c_str());
           }
         else
@@ -138,7 +160,8 @@ public:
         {
         this->Node->GetScene()->SaveStateForUndo(this->Node);
         }
-      this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointEndInteractionEvent, callData);
+      this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointEndInteractionEvent,
+                              callData != NULL ? &markupIndex : NULL);
       }
     else if (event == vtkCommand::InteractionEvent)
       {
@@ -178,7 +201,7 @@ public:
 
           // propagate the changes to MRML
           //std::cout << "callback: n = " << *n << std::endl;
-          this->DisplayableManager->UpdateNthMarkupPositionFromWidget(*n, this->Node, this->Widget);
+          this->DisplayableManager->UpdateNthMarkupPositionFromWidget(markupIndex, this->Node, this->Widget);
           }
         }
       else
@@ -206,13 +229,177 @@ public:
   vtkMRMLMarkupsDisplayableManager2D * DisplayableManager;
 };
 
+//---------------------------------------------------------------------------
+// vtkInternal methods
+
+//---------------------------------------------------------------------------
+class vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal
+{
+public:
+  vtkInternal(vtkMRMLMarkupsFiducialDisplayableManager2D* external);
+  ~vtkInternal();
+
+  /// Glyph actor and labels of a list drawn as a point set, kept by the helper
+  typedef vtkMRMLMarkupsDisplayableManagerHelper::PointSetPipeline PointSetPipeline;
+
+  PointSetPipeline* GetPointSet(vtkMRMLMarkupsNode* node);
+  PointSetPipeline* AddPointSet(vtkMRMLMarkupsNode* node);
+  void RemovePointSet(vtkMRMLMarkupsNode* node);
+  void RemoveAllPointSets();
+
+  /// Observe the mouse moves and the renders while there are point sets
+  void UpdateObservers();
+  static void ProcessEvents(vtkObject* caller, unsigned long event,
+                            void* clientData, void* callData);
+
+  /// Number of pixels per millimeter in the slice view
+  double GetPixelsPerMillimeter();
+
+  vtkMRMLMarkupsFiducialDisplayableManager2D* External;
+  vtkSmartPointer<vtkCallbackCommand> Callback;
+  vtkWeakPointer<vtkRenderWindowInteractor> ObservedInteractor;
+  vtkWeakPointer<vtkRenderer> ObservedRenderer;
+};
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::vtkInternal(
+  vtkMRMLMarkupsFiducialDisplayableManager2D* external)
+{
+  this->External = external;
+  this->Callback = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->Callback->SetClientData(external);
+  this->Callback->SetCallback(vtkInternal::ProcessEvents);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::~vtkInternal()
+{
+  this->RemoveAllPointSets();
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::PointSetPipeline*
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::GetPointSet(vtkMRMLMarkupsNode* node)
+{
+  return this->External->GetHelper()->GetPointSet(node);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::PointSetPipeline*
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::AddPointSet(vtkMRMLMarkupsNode* node)
+{
+  PointSetPipeline* pipeline = this->External->GetHelper()->AddPointSet(
+    node, this->External->GetRenderer(), true);
+  this->UpdateObservers();
+  return pipeline;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::RemovePointSet(vtkMRMLMarkupsNode* node)
+{
+  this->External->GetHelper()->RemovePointSet(node);
+  this->UpdateObservers();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::RemoveAllPointSets()
+{
+  this->External->GetHelper()->RemoveAllPointSets();
+  this->UpdateObservers();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::UpdateObservers()
+{
+  vtkRenderWindowInteractor* interactor = 0;
+  vtkRenderer* renderer = 0;
+  if (!this->External->GetHelper()->PointSets.empty())
+    {
+    interactor = this->External->GetInteractor();
+    renderer = this->External->GetRenderer();
+    }
+  if (interactor != this->ObservedInteractor)
+    {
+    if (this->ObservedInteractor)
+      {
+      this->ObservedInteractor->RemoveObserver(this->Callback);
+      }
+    this->ObservedInteractor = interactor;
+    if (interactor)
+      {
+      interactor->AddObserver(vtkCommand::MouseMoveEvent, this->Callback);
+      }
+    }
+  if (renderer != this->ObservedRenderer)
+    {
+    if (this->ObservedRenderer)
+      {
+      this->ObservedRenderer->RemoveObserver(this->Callback);
+      }
+    this->ObservedRenderer = renderer;
+    if (renderer)
+      {
+      renderer->AddObserver(vtkCommand::StartEvent, this->Callback);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::ProcessEvents(
+  vtkObject* vtkNotUsed(caller), unsigned long event,
+  void* clientData, void* vtkNotUsed(callData))
+{
+  vtkMRMLMarkupsFiducialDisplayableManager2D* self =
+    reinterpret_cast<vtkMRMLMarkupsFiducialDisplayableManager2D*>(clientData);
+  if (event == vtkCommand::MouseMoveEvent)
+    {
+    self->UpdateActivePoints();
+    }
+  else if (event == vtkCommand::StartEvent)
+    {
+    self->UpdatePointSetsProjection();
+    }
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLMarkupsFiducialDisplayableManager2D::vtkInternal::GetPixelsPerMillimeter()
+{
+  vtkMRMLSliceNode* sliceNode = this->External->GetMRMLSliceNode();
+  if (!sliceNode)
+    {
+    return 1.;
+    }
+  vtkMatrix4x4* xyToRAS = sliceNode->GetXYToRAS();
+  double millimetersPerPixel = sqrt(
+    xyToRAS->GetElement(0, 0) * xyToRAS->GetElement(0, 0) +
+    xyToRAS->GetElement(1, 0) * xyToRAS->GetElement(1, 0) +
+    xyToRAS->GetElement(2, 0) * xyToRAS->GetElement(2, 0));
+  return millimetersPerPixel > 0. ? 1. / millimetersPerPixel : 1.;
+}
+
 //---------------------------------------------------------------------------
 // vtkMRMLMarkupsFiducialDisplayableManager2D methods
 
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::vtkMRMLMarkupsFiducialDisplayableManager2D()
+{
+  this->Focus = "vtkMRMLMarkupsFiducialNode";
+  this->PointSetThreshold = 500;
+  this->Internal = new vtkInternal(this);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager2D::~vtkMRMLMarkupsFiducialDisplayableManager2D()
+{
+  delete this->Internal;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialDisplayableManager2D::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "PointSetThreshold: " << this->PointSetThreshold << "\n";
+  os << indent << "Number of point sets: " << this->Helper->PointSets.size() << "\n";
   this->Helper->PrintSelf(os, indent);
 }
 
@@ -253,6 +440,9 @@ vtkAbstractWidget * vtkMRMLMarkupsFiducialDisplayableManager2D::CreateWidget(vtk
     this->Helper->SetNodeGlyphType(displayNode, vtkMRMLMarkupsDisplayNode::GlyphMin - 1, 0);
     }
 
+  // the widget is recreated when markups are removed
+  this->Internal->RemovePointSet(fiducialNode);
+
   vtkNew<vtkSeedRepresentation> rep;
 
   vtkDebugMacro("making handle for fiducialNode " << fiducialNode->GetName());
@@ -315,6 +505,14 @@ vtkAbstractWidget * vtkMRMLMarkupsFiducialDisplayableManager2D::CreateWidget(vtk
 
   seedWidget->CompleteInteraction();
 
+  // large lists are drawn as a point set, the seed widget only gets a handle
+  // for the markup under the mouse
+  if (!this->IsInLightboxMode() &&
+      fiducialNode->GetNumberOfMarkups() >= this->PointSetThreshold)
+    {
+    this->Internal->AddPointSet(fiducialNode);
+    }
+
   return seedWidget;
 
   }
@@ -370,6 +568,12 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthMarkupPositionFromWidg
     {
     return false;
     }
+  int seedIndex = this->GetSeedIndexFromMarkupIndex(pointsNode, n);
+  if (seedIndex < 0)
+    {
+    // drawn by the point set
+    return false;
+    }
 
   bool positionChanged = false;
 
@@ -384,7 +588,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthMarkupPositionFromWidg
 
   this->GetWorldToDisplayCoordinates(pointTransformed,displayCoordinates1);
 
-  seedRepresentation->GetSeedDisplayPosition(n,displayCoordinatesBuffer1);
+  seedRepresentation->GetSeedDisplayPosition(seedIndex,displayCoordinatesBuffer1);
 
   if (this->GetDisplayCoordinatesChanged(displayCoordinates1,displayCoordinatesBuffer1))
     {
@@ -420,6 +624,12 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthSeedPositionFromMRML(i
     {
     return false;
     }
+  int seedIndex = this->GetSeedIndexFromMarkupIndex(pointsNode, n);
+  if (seedIndex < 0)
+    {
+    // drawn by the point set
+    return false;
+    }
   bool positionChanged = false;
 
 //  std::cout << "UpdateNthSeedPositionFromMRML: n = " << n << std::endl;
@@ -435,7 +645,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthSeedPositionFromMRML(i
 
   this->GetWorldToDisplayCoordinates(pointTransformed,displayCoordinates1);
 
-  seedRepresentation->GetSeedDisplayPosition(n,displayCoordinatesBuffer1);
+  seedRepresentation->GetSeedDisplayPosition(seedIndex,displayCoordinatesBuffer1);
 
   if (this->GetDisplayCoordinatesChanged(displayCoordinates1,displayCoordinatesBuffer1))
     {
@@ -448,7 +658,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateNthSeedPositionFromMRML(i
     if (seedRepresentation->GetRenderer() != NULL &&
         seedRepresentation->GetRenderer()->IsActiveCameraCreated())
       {
-      seedRepresentation->SetSeedDisplayPosition(n,displayCoordinates1);
+      seedRepresentation->SetSeedDisplayPosition(seedIndex,displayCoordinates1);
       positionChanged = true;
       }
     else
@@ -488,12 +698,19 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
     return;
     }
 
+  int seedIndex = this->GetSeedIndexFromMarkupIndex(fiducialNode, n);
+  if (seedIndex < 0)
+    {
+    // drawn by the point set
+    return;
+    }
+
   int numberOfHandles = seedRepresentation->GetNumberOfSeeds();
-  vtkDebugMacro("SetNthSeed, n = " << n << ", number of handles = " << numberOfHandles);
+  vtkDebugMacro("SetNthSeed, n = " << n << ", seed index = " << seedIndex << ", number of handles = " << numberOfHandles);
 
   // does this handle need to be created?
   bool createdNewHandle = false;
-  if (n >= numberOfHandles)
+  if (seedIndex >= numberOfHandles)
     {
     // create a new handle
     vtkHandleWidget* newhandle = seedWidget->CreateNewHandle();
@@ -525,9 +742,9 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
 
   // can have a 3d or 2d handle depending on if in light box mode or not
   vtkOrientedPolygonalHandleRepresentation3D *handleRep =
-    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(n));
+    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(seedIndex));
   vtkPointHandleRepresentation2D *pointHandleRep =
-    vtkPointHandleRepresentation2D::SafeDownCast(seedRepresentation->GetHandleRepresentation(n));
+    vtkPointHandleRepresentation2D::SafeDownCast(seedRepresentation->GetHandleRepresentation(seedIndex));
 
   // update the postion
   bool positionChanged = this->UpdateNthSeedPositionFromMRML(n, seedWidget, fiducialNode);
@@ -542,7 +759,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
               << ", number of seeds = "
               <<  seedRepresentation->GetNumberOfSeeds()
               << ", handle rep = "
-              << (seedRepresentation->GetHandleRepresentation(n) ? seedRepresentation->GetHandleRepresentation(n)->GetClassName() : "null"));
+              << (seedRepresentation->GetHandleRepresentation(seedIndex) ? seedRepresentation->GetHandleRepresentation(seedIndex)->GetClassName() : "null"));
     return;
     }
 
@@ -559,7 +776,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
   if (handleRep)
     {
     // set the glyph type if a new handle was created, or the glyph type changed
-    int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, n);
+    int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, seedIndex);
     if (createdNewHandle ||
         oldGlyphType != displayNode->GetGlyphType())
       {
@@ -602,7 +819,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
         }
       // TBD: keep with the assumption of one glyph type per markups node,
       // that each seed has to have the same type, but update if necessary
-      this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), n);
+      this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), seedIndex);
       }  // end of glyph type
 
     // set the color
@@ -680,7 +897,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
         {
         handleRep->LabelVisibilityOn();
         }
-      seedWidget->GetSeed(n)->EnabledOn();
+      seedWidget->GetSeed(seedIndex)->EnabledOn();
       // if the fiducial is visible, turn off projection
       vtkSeedWidget* fiducialSeed = vtkSeedWidget::SafeDownCast(this->Helper->GetPointProjectionWidget(fiducialNode->GetNthMarkupID(n)));
       if (fiducialSeed && fiducialSeed->GetSeed(0))
@@ -701,12 +918,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
         seedRepresentation->GetHandleRepresentation()->DisablePicking();
         }
 #else
-      seedWidget->GetSeed(n)->EnabledOff();
+      seedWidget->GetSeed(seedIndex)->EnabledOff();
 #endif
 
-      // if the widget is not shown on the slice, show the intersection
+      // if the widget is not shown on the slice, show the intersection,
+      // not done for the lists drawn as point sets
       if (fiducialNode &&
-          fiducialNode->GetDisplayNode())
+          fiducialNode->GetDisplayNode() &&
+          !this->Internal->GetPointSet(fiducialNode))
         {
         double transformedP1[4];
         fiducialNode->GetNthFiducialWorldCoordinates(n, transformedP1);
@@ -870,11 +1089,11 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::SetNthSeed(int n, vtkMRMLMarkup
       }
     if (listLocked || seedLocked || persistentPlaceMode)
       {
-      seedWidget->GetSeed(n)->ProcessEventsOff();
+      seedWidget->GetSeed(seedIndex)->ProcessEventsOff();
       }
     else
       {
-      seedWidget->GetSeed(n)->ProcessEventsOn();
+      seedWidget->GetSeed(seedIndex)->ProcessEventsOn();
       }
 
     }
@@ -1038,10 +1257,27 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::PropagateMRMLToWidget(vtkMRMLMa
     }
 #endif
 
-  for (int n = 0; n < numberOfFiducials; n++)
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode);
+  if (pointSet)
     {
-    // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
-    this->SetNthSeed(n, fiducialNode, seedWidget);
+    this->UpdatePointSet(fiducialNode);
+    int activePoint = pointSet->PointSet->GetActivePoint();
+    if (activePoint >= numberOfFiducials)
+      {
+      this->SetActivePoint(fiducialNode, -1);
+      }
+    else if (activePoint >= 0)
+      {
+      this->SetNthSeed(activePoint, fiducialNode, seedWidget);
+      }
+    }
+  else
+    {
+    for (int n = 0; n < numberOfFiducials; n++)
+      {
+      // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
+      this->SetNthSeed(n, fiducialNode, seedWidget);
+      }
     }
 
 
@@ -1115,14 +1351,19 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::PropagateWidgetToMRML(vtkAbstra
   int numberOfSeeds = seedRepresentation->GetNumberOfSeeds();
 
   bool atLeastOnePositionChanged = false;
-  for (int n = 0; n < numberOfSeeds; n++)
+  for (int seedIndex = 0; seedIndex < numberOfSeeds; seedIndex++)
     {
+    int n = this->GetMarkupIndexFromSeedIndex(fiducialNode, seedIndex);
+    if (n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+      {
+      continue;
+      }
     double worldCoordinates1[4];
     bool thisPositionChanged = false;
     // 2D widget was changed
 
     double displayCoordinates1[4];
-    seedRepresentation->GetSeedDisplayPosition(n,displayCoordinates1);
+    seedRepresentation->GetSeedDisplayPosition(seedIndex,displayCoordinates1);
     vtkDebugMacro("PropagateWidgetToMRML: 2d DM: widget display coords = "
           << displayCoordinates1[0] << ", " << displayCoordinates1[1]
           << ", " << displayCoordinates1[2]);
@@ -1159,6 +1400,12 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::PropagateWidgetToMRML(vtkAbstra
       {
       vtkDebugMacro("PropagateWidgetToMRML: this position changed, setting fiducial coordinates");
       fiducialNode->SetNthFiducialWorldCoordinates(n,worldCoordinates1);
+      // the modified events are ignored while updating
+      if (vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode))
+        {
+        vtkMRMLMarkupsDisplayableManagerHelper::UpdateNthPointSetPoint(
+          pointSet->PointSet, fiducialNode, n);
+        }
       }
     }
 
@@ -1386,12 +1633,24 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdatePosition(vtkAbstractWidge
   // disable processing of modified events
   //this->Updating = 1;
   bool positionChanged = false;
-  int numberOfFiducials = pointsNode->GetNumberOfMarkups();
-  for (int n = 0; n < numberOfFiducials; n++)
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(pointsNode);
+  if (pointSet)
     {
-    if (this->UpdateNthSeedPositionFromMRML(n, seedWidget, pointsNode))
+    this->UpdatePointSet(vtkMRMLMarkupsFiducialNode::SafeDownCast(pointsNode));
+    int activePoint = pointSet->PointSet->GetActivePoint();
+    positionChanged = activePoint >= 0 &&
+      this->UpdateNthSeedPositionFromMRML(activePoint, seedWidget, pointsNode);
+    this->RequestRender();
+    }
+  else
+    {
+    int numberOfFiducials = pointsNode->GetNumberOfMarkups();
+    for (int n = 0; n < numberOfFiducials; n++)
       {
-      positionChanged = true;
+      if (this->UpdateNthSeedPositionFromMRML(n, seedWidget, pointsNode))
+        {
+        positionChanged = true;
+        }
       }
     }
   // did any of the positions change?
@@ -1415,6 +1674,52 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLSceneEndClose()
 
   // clear out the map of glyph types
   this->Helper->ClearNodeGlyphTypes();
+  this->Internal->RemoveAllPointSets();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  this->Internal->RemovePointSet(vtkMRMLMarkupsNode::SafeDownCast(node));
+  this->Superclass::OnMRMLSceneNodeRemoved(node);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLSliceNodeModifiedEvent()
+{
+  bool lightboxMode = this->IsInLightboxMode();
+  // copy the list as widgets may be recreated
+  std::vector<vtkMRMLMarkupsNode*> markupsNodes = this->Helper->MarkupsNodeList;
+  for (std::vector<vtkMRMLMarkupsNode*>::iterator it = markupsNodes.begin();
+       it != markupsNodes.end(); ++it)
+    {
+    vtkMRMLMarkupsNode* markupsNode = *it;
+    vtkAbstractWidget* widget = this->Helper->GetWidget(markupsNode);
+    vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(markupsNode);
+    bool usePointSet = !lightboxMode &&
+      markupsNode->GetNumberOfMarkups() >= this->PointSetThreshold;
+    if (widget && (pointSet != 0) != usePointSet)
+      {
+      // switched in or out of light box mode
+      this->Helper->RemoveWidgetAndNode(markupsNode);
+      this->AddWidget(markupsNode);
+      }
+    else if (pointSet)
+      {
+      // the glyphs are reprojected at the next render, only the handle
+      // needs to be updated
+      vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(widget);
+      if (seedWidget && seedWidget->GetWidgetState() != vtkSeedWidget::MovingSeed)
+        {
+        this->SetActivePoint(vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), -1);
+        }
+      this->UpdatePointSet(vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode));
+      }
+    else
+      {
+      this->PropagateMRMLToWidget(markupsNode, widget);
+      }
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -1440,7 +1745,15 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeNthMarkupModif
    vtkErrorMacro("OnMRMLMarkupsNodeNthMarkupModifiedEvent: Could not get seed widget!")
    return;
    }
-  this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), seedWidget);
+  vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(node);
+  if (vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(node))
+    {
+    vtkMRMLMarkupsDisplayableManagerHelper::UpdateNthPointSetPoint(
+      pointSet->PointSet, node, n);
+    this->RequestRender();
+    }
+  // no-op if the markup is drawn by the point set
+  this->SetNthSeed(n, fiducialNode, seedWidget);
 }
 
 //---------------------------------------------------------------------------
@@ -1467,9 +1780,24 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeMarkupAddedEve
    return;
    }
 
+  int n = markupsNode->GetNumberOfMarkups() - 1;
+  if (vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(markupsNode))
+    {
+    vtkMRMLMarkupsDisplayableManagerHelper::UpdateNthPointSetPoint(
+      pointSet->PointSet, markupsNode, n);
+    this->RequestRender();
+    return;
+    }
+  if (!this->IsInLightboxMode() && n + 1 >= this->PointSetThreshold)
+    {
+    // switch to a point set, recreate the widget
+    this->Helper->RemoveWidgetAndNode(markupsNode);
+    this->AddWidget(markupsNode);
+    return;
+    }
+
   // this call will create a new handle and set it
   // std::cout << "OnMRMLMarkupsNodeMarkupAddedEvent: adding to markups node that currently has " << markupsNode->GetNumberOfMarkups() << std::endl;
-  int n = markupsNode->GetNumberOfMarkups() - 1;
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
 
   vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
@@ -1498,3 +1826,138 @@ void vtkMRMLMarkupsFiducialDisplayableManager2D::OnMRMLMarkupsNodeMarkupRemovedE
   this->Helper->RemoveWidgetAndNode(markupsNode);
   this->AddWidget(markupsNode);
 }
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager2D::GetSeedIndexFromMarkupIndex(vtkMRMLMarkupsNode* node, int n)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(node);
+  if (!pointSet)
+    {
+    return n;
+    }
+  return (n >= 0 && n == pointSet->PointSet->GetActivePoint()) ? 0 : -1;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager2D::GetMarkupIndexFromSeedIndex(vtkMRMLMarkupsNode* node, int seedIndex)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(node);
+  if (!pointSet)
+    {
+    return seedIndex;
+    }
+  return seedIndex == 0 ? pointSet->PointSet->GetActivePoint() : -1;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdatePointSet(vtkMRMLMarkupsFiducialNode* fiducialNode)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode);
+  if (!pointSet)
+    {
+    return;
+    }
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  vtkMRMLSliceNode *sliceNode = this->GetMRMLSliceNode();
+  if (!displayNode || !sliceNode)
+    {
+    pointSet->Actor->VisibilityOff();
+    pointSet->LabelActor->VisibilityOff();
+    return;
+    }
+
+  vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetPoints(
+    pointSet->PointSet, fiducialNode, pointSet->UpdateTime);
+
+  // only the markups within half a slice of the slice plane are shown, the
+  // glyphs are sized in millimeters
+  vtkNew<vtkMatrix4x4> rasToXY;
+  vtkMatrix4x4::Invert(sliceNode->GetXYToRAS(), rasToXY.GetPointer());
+  pointSet->PointSet->SetWorldToDisplayMatrix(rasToXY.GetPointer());
+  pointSet->PointSet->SetDepthRange(-0.5, 0.5 + (sliceNode->GetDimensions()[2] - 1));
+
+  // display properties, same as the handles: the 3d glyphs are mapped to
+  // 2d glyphs
+  bool visible = displayNode->GetVisibility() &&
+    displayNode->IsDisplayableInView(sliceNode->GetID());
+  vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetDisplay(
+    pointSet, displayNode,
+    displayNode->GetGlyphScale() * this->Internal->GetPixelsPerMillimeter(), visible);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdatePointSetsProjection()
+{
+  // the display poly data is only projected when requested
+  for (vtkMRMLMarkupsDisplayableManagerHelper::PointSetsIt it = this->Helper->PointSets.begin();
+       it != this->Helper->PointSets.end(); ++it)
+    {
+    it->second.PointSet->GetDisplayPolyData();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::SetActivePoint(vtkMRMLMarkupsFiducialNode* fiducialNode, int n)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode);
+  if (!pointSet || pointSet->PointSet->GetActivePoint() == n)
+    {
+    return;
+    }
+  vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(this->Helper->GetWidget(fiducialNode));
+  if (!seedWidget)
+    {
+    return;
+    }
+  vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+  if (seedRepresentation->GetNumberOfSeeds() > 0)
+    {
+    seedWidget->DeleteSeed(0);
+    }
+  pointSet->PointSet->SetActivePoint(n);
+  if (n >= 0)
+    {
+    this->SetNthSeed(n, fiducialNode, seedWidget);
+    }
+  seedRepresentation->NeedToRenderOn();
+  seedWidget->Modified();
+  this->RequestRender();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager2D::UpdateActivePoints()
+{
+  vtkRenderWindowInteractor* interactor = this->Internal->ObservedInteractor;
+  if (!interactor)
+    {
+    return;
+    }
+  // don't move the handle while panning or zooming the slice
+  vtkInteractorStyle* interactorStyle = vtkInteractorStyle::SafeDownCast(interactor->GetInteractorStyle());
+  if (interactorStyle && interactorStyle->GetState() != VTKIS_NONE)
+    {
+    return;
+    }
+  int* position = interactor->GetEventPosition();
+  double pixelsPerMillimeter = this->Internal->GetPixelsPerMillimeter();
+
+  for (vtkMRMLMarkupsDisplayableManagerHelper::PointSetsIt it = this->Helper->PointSets.begin();
+       it != this->Helper->PointSets.end(); ++it)
+    {
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(this->Helper->GetWidget(fiducialNode));
+    if (!fiducialNode || !seedWidget ||
+        seedWidget->GetWidgetState() == vtkSeedWidget::MovingSeed)
+      {
+      continue;
+      }
+    vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+    int n = -1;
+    if (displayNode && it->second.Actor->GetVisibility())
+      {
+      double tolerance = std::max(3., displayNode->GetGlyphScale() * pixelsPerMillimeter / 2.);
+      n = it->second.PointSet->FindPointAtDisplayPosition(position[0], position[1], tolerance);
+      }
+    this->SetActivePoint(fiducialNode, n);
+    }
+}
@@ -45,10 +45,21 @@ public:
   /// Update a single markup position from the seed widget, return true if the position changed
   virtual bool UpdateNthMarkupPositionFromWidget(int n, vtkMRMLMarkupsNode* pointsNode, vtkAbstractWidget * widget);
 
+  /// Lists with at least this number of markups are drawn with a single
+  /// glyph actor instead of a handle per markup, except in light box mode.
+  /// A handle is then only created for the markup under the mouse.
+  /// 500 by default.
+  vtkSetClampMacro(PointSetThreshold, int, 1, VTK_INT_MAX);
+  vtkGetMacro(PointSetThreshold, int);
+
+  /// Return the index of the markup shown by the seed of the node widget,
+  /// -1 if none.
+  int GetMarkupIndexFromSeedIndex(vtkMRMLMarkupsNode* node, int seedIndex);
+
 protected:
 
-  vtkMRMLMarkupsFiducialDisplayableManager2D(){this->Focus="vtkMRMLMarkupsFiducialNode";}
-  virtual ~vtkMRMLMarkupsFiducialDisplayableManager2D(){}
+  vtkMRMLMarkupsFiducialDisplayableManager2D();
+  virtual ~vtkMRMLMarkupsFiducialDisplayableManager2D();
 
   /// Callback for click in RenderWindow
   virtual void OnClickInRenderWindow(double x, double y, const char *associatedNodeID);
@@ -82,12 +93,35 @@ protected:
 
   // Clean up when scene closes
   virtual void OnMRMLSceneEndClose();
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+
+  /// Only reproject the lists drawn as point sets when the slice moves
+  virtual void OnMRMLSliceNodeModifiedEvent();
+
+  /// Return the index of the seed that shows the nth markup, -1 if none.
+  int GetSeedIndexFromMarkupIndex(vtkMRMLMarkupsNode* node, int n);
+
+  /// Update the glyphs of a list drawn as a point set. The markups are only
+  /// read again if the node or its transform changed since the last update.
+  void UpdatePointSet(vtkMRMLMarkupsFiducialNode* fiducialNode);
+  /// Project the point sets on the slice
+  void UpdatePointSetsProjection();
+  /// Show a handle on the nth markup of a list drawn as a point set, -1 to
+  /// remove it.
+  void SetActivePoint(vtkMRMLMarkupsFiducialNode* fiducialNode, int n);
+  /// Show a handle on the markup under the mouse.
+  void UpdateActivePoints();
+
+  int PointSetThreshold;
 
 private:
 
   vtkMRMLMarkupsFiducialDisplayableManager2D(const vtkMRMLMarkupsFiducialDisplayableManager2D&); /// Not implemented
   void operator=(const vtkMRMLMarkupsFiducialDisplayableManager2D&); /// Not Implemented
 
+  class vtkInternal;
+  friend class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
@@ -25,6 +25,7 @@
 
 // MarkupsModule/VTKWidgets includes
 #include <vtkMarkupsGlyphSource2D.h>
+#include <vtkMarkupsPointSet.h>
 
 // MRMLDisplayableManager includes
 #include <vtkSliceViewInteractorStyle.h>
@@ -37,26 +38,36 @@
 
 // VTK includes
 #include <vtkAbstractWidget.h>
+#include <vtkActor2D.h>
+#include <vtkCallbackCommand.h>
+#include <vtkCamera.h>
 #include <vtkFollower.h>
 #include <vtkHandleRepresentation.h>
 #include <vtkInteractorStyle.h>
 #include <vtkMath.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkOrientedPolygonalHandleRepresentation3D.h>
 #if (VTK_MAJOR_VERSION >= 6)
 #include <vtkPickingManager.h>
 #endif
+#include <vtkProp.h>
 #include <vtkProperty2D.h>
 #include <vtkProperty.h>
 #include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSeedWidget.h>
 #include <vtkSmartPointer.h>
 #include <vtkSeedRepresentation.h>
 #include <vtkSphereSource.h>
+#include <vtkWeakPointer.h>
 
 // STD includes
+#include <algorithm>
+#include <cmath>
+#include <map>
 #include <sstream>
 #include <string>
 
@@ -106,7 +117,19 @@ public:
         {
         this->Node->GetScene()->SaveStateForUndo(this->Node);
         }
-      this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointEndInteractionEvent, callData);
+      // the seeds don't match the markups when the list is drawn as a point set
+      vtkMRMLMarkupsFiducialDisplayableManager3D* fiducialDisplayableManager =
+        vtkMRMLMarkupsFiducialDisplayableManager3D::SafeDownCast(this->DisplayableManager);
+      if (callData && fiducialDisplayableManager)
+        {
+        int markupIndex = fiducialDisplayableManager->GetMarkupIndexFromSeedIndex(
+          this->Node, *reinterpret_cast<int*>(callData));
+        this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointEndInteractionEvent, &markupIndex);
+        }
+      else
+        {
+        this->Node->InvokeEvent(vtkMRMLMarkupsNode::PointEndInteractionEvent, callData);
+        }
       }
     // the interaction with the widget ended, now propagate the changes to MRML
     this->DisplayableManager->PropagateWidgetToMRML(this->Widget, this->Node);
@@ -130,13 +153,199 @@ public:
   vtkMRMLMarkupsDisplayableManager3D * DisplayableManager;
 };
 
+//---------------------------------------------------------------------------
+// vtkInternal methods
+
+//---------------------------------------------------------------------------
+class vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal
+{
+public:
+  vtkInternal(vtkMRMLMarkupsFiducialDisplayableManager3D* external);
+  ~vtkInternal();
+
+  /// Glyph actor and labels of a list drawn as a point set, kept by the helper
+  typedef vtkMRMLMarkupsDisplayableManagerHelper::PointSetPipeline PointSetPipeline;
+
+  PointSetPipeline* GetPointSet(vtkMRMLMarkupsNode* node);
+  PointSetPipeline* AddPointSet(vtkMRMLMarkupsNode* node);
+  void RemovePointSet(vtkMRMLMarkupsNode* node);
+  void RemoveAllPointSets();
+
+  /// Observe the mouse moves and the renders while there are point sets
+  void UpdateObservers();
+  static void ProcessEvents(vtkObject* caller, unsigned long event,
+                            void* clientData, void* callData);
+
+  /// Homogeneous transform from world to display coordinates
+  void GetWorldToDisplayMatrix(vtkMatrix4x4* matrix);
+  /// Number of pixels per millimeter at the focal point
+  double GetPixelsPerMillimeter();
+
+  vtkMRMLMarkupsFiducialDisplayableManager3D* External;
+  vtkSmartPointer<vtkCallbackCommand> Callback;
+  vtkWeakPointer<vtkRenderWindowInteractor> ObservedInteractor;
+  vtkWeakPointer<vtkRenderer> ObservedRenderer;
+  unsigned long CameraTime;
+};
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::vtkInternal(
+  vtkMRMLMarkupsFiducialDisplayableManager3D* external)
+{
+  this->External = external;
+  this->Callback = vtkSmartPointer<vtkCallbackCommand>::New();
+  this->Callback->SetClientData(external);
+  this->Callback->SetCallback(vtkInternal::ProcessEvents);
+  this->CameraTime = 0;
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::~vtkInternal()
+{
+  this->RemoveAllPointSets();
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::PointSetPipeline*
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::GetPointSet(vtkMRMLMarkupsNode* node)
+{
+  return this->External->GetHelper()->GetPointSet(node);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::PointSetPipeline*
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::AddPointSet(vtkMRMLMarkupsNode* node)
+{
+  PointSetPipeline* pipeline = this->External->GetHelper()->AddPointSet(
+    node, this->External->GetRenderer(), false);
+  // orient the new glyph at the next render
+  this->CameraTime = 0;
+  this->UpdateObservers();
+  return pipeline;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::RemovePointSet(vtkMRMLMarkupsNode* node)
+{
+  this->External->GetHelper()->RemovePointSet(node);
+  this->UpdateObservers();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::RemoveAllPointSets()
+{
+  this->External->GetHelper()->RemoveAllPointSets();
+  this->UpdateObservers();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::UpdateObservers()
+{
+  vtkRenderWindowInteractor* interactor = 0;
+  vtkRenderer* renderer = 0;
+  if (!this->External->GetHelper()->PointSets.empty())
+    {
+    interactor = this->External->GetInteractor();
+    renderer = this->External->GetRenderer();
+    }
+  if (interactor != this->ObservedInteractor)
+    {
+    if (this->ObservedInteractor)
+      {
+      this->ObservedInteractor->RemoveObserver(this->Callback);
+      }
+    this->ObservedInteractor = interactor;
+    if (interactor)
+      {
+      interactor->AddObserver(vtkCommand::MouseMoveEvent, this->Callback);
+      }
+    }
+  if (renderer != this->ObservedRenderer)
+    {
+    if (this->ObservedRenderer)
+      {
+      this->ObservedRenderer->RemoveObserver(this->Callback);
+      }
+    this->ObservedRenderer = renderer;
+    if (renderer)
+      {
+      renderer->AddObserver(vtkCommand::StartEvent, this->Callback);
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::ProcessEvents(
+  vtkObject* vtkNotUsed(caller), unsigned long event,
+  void* clientData, void* vtkNotUsed(callData))
+{
+  vtkMRMLMarkupsFiducialDisplayableManager3D* self =
+    reinterpret_cast<vtkMRMLMarkupsFiducialDisplayableManager3D*>(clientData);
+  if (event == vtkCommand::MouseMoveEvent)
+    {
+    self->UpdateActivePoints();
+    }
+  else if (event == vtkCommand::StartEvent)
+    {
+    self->UpdatePointSetsOrientation();
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::GetWorldToDisplayMatrix(vtkMatrix4x4* matrix)
+{
+  vtkRenderer* renderer = this->External->GetRenderer();
+  vtkCamera* camera = renderer->GetActiveCamera();
+  // world to view, with the depth in [0, 1]
+  vtkMatrix4x4* worldToView = camera->GetCompositeProjectionTransformMatrix(
+    renderer->GetTiledAspectRatio(), 0., 1.);
+  // view to display, as in vtkViewport::ViewToDisplay()
+  int* size = renderer->GetRenderWindow()->GetSize();
+  double* viewport = renderer->GetViewport();
+  vtkNew<vtkMatrix4x4> viewToDisplay;
+  viewToDisplay->SetElement(0, 0, size[0] * (viewport[2] - viewport[0]) / 2.);
+  viewToDisplay->SetElement(0, 3, size[0] * (viewport[2] - viewport[0]) / 2. + size[0] * viewport[0]);
+  viewToDisplay->SetElement(1, 1, size[1] * (viewport[3] - viewport[1]) / 2.);
+  viewToDisplay->SetElement(1, 3, size[1] * (viewport[3] - viewport[1]) / 2. + size[1] * viewport[1]);
+  vtkMatrix4x4::Multiply4x4(viewToDisplay.GetPointer(), worldToView, matrix);
+}
+
+//---------------------------------------------------------------------------
+double vtkMRMLMarkupsFiducialDisplayableManager3D::vtkInternal::GetPixelsPerMillimeter()
+{
+  vtkRenderer* renderer = this->External->GetRenderer();
+  vtkCamera* camera = renderer->GetActiveCamera();
+  double height = renderer->GetRenderWindow()->GetSize()[1] *
+    (renderer->GetViewport()[3] - renderer->GetViewport()[1]);
+  double viewHeight = camera->GetParallelProjection() ?
+    2. * camera->GetParallelScale() :
+    2. * camera->GetDistance() * tan(vtkMath::RadiansFromDegrees(camera->GetViewAngle() / 2.));
+  return viewHeight > 0. ? height / viewHeight : 1.;
+}
+
 //---------------------------------------------------------------------------
 // vtkMRMLMarkupsFiducialDisplayableManager3D methods
 
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::vtkMRMLMarkupsFiducialDisplayableManager3D()
+{
+  this->Focus = "vtkMRMLMarkupsFiducialNode";
+  this->PointSetThreshold = 500;
+  this->Internal = new vtkInternal(this);
+}
+
+//---------------------------------------------------------------------------
+vtkMRMLMarkupsFiducialDisplayableManager3D::~vtkMRMLMarkupsFiducialDisplayableManager3D()
+{
+  delete this->Internal;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialDisplayableManager3D::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "PointSetThreshold: " << this->PointSetThreshold << "\n";
+  os << indent << "Number of point sets: " << this->Helper->PointSets.size() << "\n";
   this->Helper->PrintSelf(os, indent);
 }
 
@@ -165,6 +374,9 @@ vtkAbstractWidget * vtkMRMLMarkupsFiducialDisplayableManager3D::CreateWidget(vtk
     // std::cout<<"No DisplayNode!"<<std::endl;
     }
 
+  // the widget is recreated when markups are removed
+  this->Internal->RemovePointSet(fiducialNode);
+
   vtkNew<vtkSeedRepresentation> rep;
   vtkNew<vtkOrientedPolygonalHandleRepresentation3D> handle;
 
@@ -204,6 +416,13 @@ vtkAbstractWidget * vtkMRMLMarkupsFiducialDisplayableManager3D::CreateWidget(vtk
 
   seedWidget->CompleteInteraction();
 
+  // large lists are drawn as a point set, the seed widget only gets a handle
+  // for the markup under the mouse
+  if (fiducialNode->GetNumberOfMarkups() >= this->PointSetThreshold)
+    {
+    this->Internal->AddPointSet(fiducialNode);
+    }
+
   return seedWidget;
   }
 
@@ -254,6 +473,12 @@ bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthSeedPositionFromMRML(i
     {
     return false;
     }
+  int seedIndex = this->GetSeedIndexFromMarkupIndex(pointsNode, n);
+  if (seedIndex < 0)
+    {
+    // drawn by the point set
+    return false;
+    }
   bool positionChanged = false;
 
   // transform fiducial point using parent transforms
@@ -262,7 +487,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthSeedPositionFromMRML(i
 
   // for 3d managers, compare world positions
   double seedWorldCoord[4];
-  seedRepresentation->GetSeedWorldPosition(n,seedWorldCoord);
+  seedRepresentation->GetSeedWorldPosition(seedIndex,seedWorldCoord);
 
   if (this->GetWorldCoordinatesChanged(seedWorldCoord, fidWorldCoord))
     {
@@ -274,7 +499,7 @@ bool vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateNthSeedPositionFromMRML(i
                   << fidWorldCoord[0] << ", "
                   << fidWorldCoord[1] << ", "
                   << fidWorldCoord[2]);
-    seedRepresentation->GetHandleRepresentation(n)->SetWorldPosition(fidWorldCoord);
+    seedRepresentation->GetHandleRepresentation(seedIndex)->SetWorldPosition(fidWorldCoord);
     positionChanged = true;
     }
   else
@@ -303,12 +528,19 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
     return;
     }
 
+  int seedIndex = this->GetSeedIndexFromMarkupIndex(fiducialNode, n);
+  if (seedIndex < 0)
+    {
+    // drawn by the point set
+    return;
+    }
+
   int numberOfHandles = seedRepresentation->GetNumberOfSeeds();
-  vtkDebugMacro("SetNthSeed, n = " << n << ", number of handles = " << numberOfHandles);
+  vtkDebugMacro("SetNthSeed, n = " << n << ", seed index = " << seedIndex << ", number of handles = " << numberOfHandles);
 
   // does this handle need to be created?
   bool createdNewHandle = false;
-  if (n >= numberOfHandles)
+  if (seedIndex >= numberOfHandles)
     {
     // create a new handle
     vtkHandleWidget* newhandle = seedWidget->CreateNewHandle();
@@ -337,14 +569,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
     }
 
   vtkOrientedPolygonalHandleRepresentation3D *handleRep =
-    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(n));
+    vtkOrientedPolygonalHandleRepresentation3D::SafeDownCast(seedRepresentation->GetHandleRepresentation(seedIndex));
   if (!handleRep)
     {
     vtkErrorMacro("Failed to get an oriented polygonal handle rep for n = "
           << n << ", number of seeds = "
           << seedRepresentation->GetNumberOfSeeds()
           << ", handle rep = "
-          << (seedRepresentation->GetHandleRepresentation(n) ? seedRepresentation->GetHandleRepresentation(n)->GetClassName() : "null"));
+          << (seedRepresentation->GetHandleRepresentation(seedIndex) ? seedRepresentation->GetHandleRepresentation(seedIndex)->GetClassName() : "null"));
     return;
     }
 
@@ -372,14 +604,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
       {
       handleRep->LabelVisibilityOn();
       }
-    seedWidget->GetSeed(n)->EnabledOn();
+    seedWidget->GetSeed(seedIndex)->EnabledOn();
     }
   else
     {
     handleRep->VisibilityOff();
     handleRep->HandleVisibilityOff();
     handleRep->LabelVisibilityOff();
-    seedWidget->GetSeed(n)->EnabledOff();
+    seedWidget->GetSeed(seedIndex)->EnabledOff();
     }
 
   // update locked
@@ -398,15 +630,15 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
     }
   if (listLocked || seedLocked || persistentPlaceMode)
     {
-    seedWidget->GetSeed(n)->ProcessEventsOff();
+    seedWidget->GetSeed(seedIndex)->ProcessEventsOff();
     }
   else
     {
-    seedWidget->GetSeed(n)->ProcessEventsOn();
+    seedWidget->GetSeed(seedIndex)->ProcessEventsOn();
     }
 
   // set the glyph type if a new handle was created, or the glyph type changed
-  int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, n);
+  int oldGlyphType = this->Helper->GetNodeGlyphType(displayNode, seedIndex);
   if (createdNewHandle ||
       oldGlyphType != displayNode->GetGlyphType())
     {
@@ -448,7 +680,7 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::SetNthSeed(int n, vtkMRMLMarkup
       }
     // TBD: keep with the assumption of one glyph type per markups node,
     // but they may have different glyphs during update
-    this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), n);
+    this->Helper->SetNodeGlyphType(displayNode, displayNode->GetGlyphType(), seedIndex);
     }  // end of glyph type
 
   // update the text display properties if there is text
@@ -556,10 +788,27 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateMRMLToWidget(vtkMRMLMa
 
   vtkDebugMacro("Fids PropagateMRMLToWidget, node num markups = " << numberOfFiducials);
 
-  for (int n = 0; n < numberOfFiducials; n++)
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode);
+  if (pointSet)
     {
-    // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
-    this->SetNthSeed(n, fiducialNode, seedWidget);
+    this->UpdatePointSet(fiducialNode);
+    int activePoint = pointSet->PointSet->GetActivePoint();
+    if (activePoint >= numberOfFiducials)
+      {
+      this->SetActivePoint(fiducialNode, -1);
+      }
+    else if (activePoint >= 0)
+      {
+      this->SetNthSeed(activePoint, fiducialNode, seedWidget);
+      }
+    }
+  else
+    {
+    for (int n = 0; n < numberOfFiducials; n++)
+      {
+      // std::cout << "Fids PropagateMRMLToWidget: n = " << n << std::endl;
+      this->SetNthSeed(n, fiducialNode, seedWidget);
+      }
     }
 
   // update lock status
@@ -625,11 +874,16 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateWidgetToMRML(vtkAbstra
   int numberOfSeeds = seedRepresentation->GetNumberOfSeeds();
 
   bool positionChanged = false;
-  for (int n = 0; n < numberOfSeeds; n++)
+  for (int seedIndex = 0; seedIndex < numberOfSeeds; seedIndex++)
     {
+    int n = this->GetMarkupIndexFromSeedIndex(fiducialNode, seedIndex);
+    if (n < 0 || n >= fiducialNode->GetNumberOfMarkups())
+      {
+      continue;
+      }
     double worldCoordinates1[4];
-    seedRepresentation->GetSeedWorldPosition(n,worldCoordinates1);
-    vtkDebugMacro("PropagateWidgetToMRML: 3d: widget seed " << n
+    seedRepresentation->GetSeedWorldPosition(seedIndex,worldCoordinates1);
+    vtkDebugMacro("PropagateWidgetToMRML: 3d: widget seed " << seedIndex
           << " world coords = " << worldCoordinates1[0] << ", "
           << worldCoordinates1[1] << ", "<< worldCoordinates1[2]);
 
@@ -654,6 +908,12 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::PropagateWidgetToMRML(vtkAbstra
       positionChanged = true;
       vtkDebugMacro("PropagateWidgetToMRML: position changed, setting fiducial coordinates");
       fiducialNode->SetNthFiducialWorldCoordinates(n,worldCoordinates1);
+      // the modified events are ignored while updating
+      if (vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode))
+        {
+        vtkMRMLMarkupsDisplayableManagerHelper::UpdateNthPointSetPoint(
+          pointSet->PointSet, fiducialNode, n);
+        }
       }
     }
 
@@ -870,12 +1130,24 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::UpdatePosition(vtkAbstractWidge
 
   // now get the widget properties (coordinates, measurement etc.) and if the mrml node has changed, propagate the changes
   bool positionChanged = false;
-  int numberOfFiducials = pointsNode->GetNumberOfMarkups();
-  for (int n = 0; n < numberOfFiducials; n++)
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(pointsNode);
+  if (pointSet)
     {
-    if (this->UpdateNthSeedPositionFromMRML(n, seedWidget, pointsNode))
+    this->UpdatePointSet(vtkMRMLMarkupsFiducialNode::SafeDownCast(pointsNode));
+    int activePoint = pointSet->PointSet->GetActivePoint();
+    positionChanged = activePoint >= 0 &&
+      this->UpdateNthSeedPositionFromMRML(activePoint, seedWidget, pointsNode);
+    this->RequestRender();
+    }
+  else
+    {
+    int numberOfFiducials = pointsNode->GetNumberOfMarkups();
+    for (int n = 0; n < numberOfFiducials; n++)
       {
-      positionChanged = true;
+      if (this->UpdateNthSeedPositionFromMRML(n, seedWidget, pointsNode))
+        {
+        positionChanged = true;
+        }
       }
     }
   // did any of the positions change?
@@ -893,6 +1165,14 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLSceneEndClose()
 {
   // clear out the map of glyph types
   this->Helper->ClearNodeGlyphTypes();
+  this->Internal->RemoveAllPointSets();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  this->Internal->RemovePointSet(vtkMRMLMarkupsNode::SafeDownCast(node));
+  this->Superclass::OnMRMLSceneNodeRemoved(node);
 }
 
 //---------------------------------------------------------------------------
@@ -918,7 +1198,15 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeNthMarkupModif
    vtkErrorMacro("OnMRMLMarkupsNodeNthMarkupModifiedEvent: Could not get seed widget!")
    return;
    }
-  this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(node), seedWidget);
+  vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(node);
+  if (vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(node))
+    {
+    vtkMRMLMarkupsDisplayableManagerHelper::UpdateNthPointSetPoint(
+      pointSet->PointSet, node, n);
+    this->RequestRender();
+    }
+  // no-op if the markup is drawn by the point set
+  this->SetNthSeed(n, fiducialNode, seedWidget);
 }
 
 //---------------------------------------------------------------------------
@@ -945,8 +1233,23 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeMarkupAddedEve
    return;
    }
 
-  // this call will create a new handle and set it
   int n = markupsNode->GetNumberOfMarkups() - 1;
+  if (vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(markupsNode))
+    {
+    vtkMRMLMarkupsDisplayableManagerHelper::UpdateNthPointSetPoint(
+      pointSet->PointSet, markupsNode, n);
+    this->RequestRender();
+    return;
+    }
+  if (n + 1 >= this->PointSetThreshold)
+    {
+    // switch to a point set, recreate the widget
+    this->Helper->RemoveWidgetAndNode(markupsNode);
+    this->AddWidget(markupsNode);
+    return;
+    }
+
+  // this call will create a new handle and set it
   this->SetNthSeed(n, vtkMRMLMarkupsFiducialNode::SafeDownCast(markupsNode), seedWidget);
 
   vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
@@ -975,3 +1278,158 @@ void vtkMRMLMarkupsFiducialDisplayableManager3D::OnMRMLMarkupsNodeMarkupRemovedE
   this->Helper->RemoveWidgetAndNode(markupsNode);
   this->AddWidget(markupsNode);
 }
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager3D::GetSeedIndexFromMarkupIndex(vtkMRMLMarkupsNode* node, int n)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(node);
+  if (!pointSet)
+    {
+    return n;
+    }
+  return (n >= 0 && n == pointSet->PointSet->GetActivePoint()) ? 0 : -1;
+}
+
+//---------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialDisplayableManager3D::GetMarkupIndexFromSeedIndex(vtkMRMLMarkupsNode* node, int seedIndex)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(node);
+  if (!pointSet)
+    {
+    return seedIndex;
+    }
+  return seedIndex == 0 ? pointSet->PointSet->GetActivePoint() : -1;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::UpdatePointSet(vtkMRMLMarkupsFiducialNode* fiducialNode)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode);
+  if (!pointSet)
+    {
+    return;
+    }
+  vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+  if (!displayNode)
+    {
+    pointSet->Actor->VisibilityOff();
+    pointSet->LabelActor->VisibilityOff();
+    return;
+    }
+
+  vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetPoints(
+    pointSet->PointSet, fiducialNode, pointSet->UpdateTime);
+
+  vtkMRMLViewNode *viewNode = this->GetMRMLViewNode();
+  bool visible = displayNode->GetVisibility() &&
+    (!viewNode || displayNode->GetVisibility(viewNode->GetID()));
+  vtkMRMLMarkupsDisplayableManagerHelper::UpdatePointSetDisplay(
+    pointSet, displayNode, displayNode->GetGlyphScale(), visible);
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::SetActivePoint(vtkMRMLMarkupsFiducialNode* fiducialNode, int n)
+{
+  vtkInternal::PointSetPipeline* pointSet = this->Internal->GetPointSet(fiducialNode);
+  if (!pointSet || pointSet->PointSet->GetActivePoint() == n)
+    {
+    return;
+    }
+  vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(this->Helper->GetWidget(fiducialNode));
+  if (!seedWidget)
+    {
+    return;
+    }
+  vtkSeedRepresentation * seedRepresentation = vtkSeedRepresentation::SafeDownCast(seedWidget->GetRepresentation());
+  if (seedRepresentation->GetNumberOfSeeds() > 0)
+    {
+    seedWidget->DeleteSeed(0);
+    }
+  pointSet->PointSet->SetActivePoint(n);
+  if (n >= 0)
+    {
+    this->SetNthSeed(n, fiducialNode, seedWidget);
+    }
+  seedRepresentation->NeedToRenderOn();
+  seedWidget->Modified();
+  this->RequestRender();
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::UpdateActivePoints()
+{
+  vtkRenderWindowInteractor* interactor = this->Internal->ObservedInteractor;
+  if (!interactor || !this->GetRenderer() || !this->GetRenderer()->GetRenderWindow())
+    {
+    return;
+    }
+  // don't move the handle while rotating or panning the view
+  vtkInteractorStyle* interactorStyle = vtkInteractorStyle::SafeDownCast(interactor->GetInteractorStyle());
+  if (interactorStyle && interactorStyle->GetState() != VTKIS_NONE)
+    {
+    return;
+    }
+  int* position = interactor->GetEventPosition();
+  vtkNew<vtkMatrix4x4> worldToDisplay;
+  this->Internal->GetWorldToDisplayMatrix(worldToDisplay.GetPointer());
+  double pixelsPerMillimeter = this->Internal->GetPixelsPerMillimeter();
+
+  for (vtkMRMLMarkupsDisplayableManagerHelper::PointSetsIt it = this->Helper->PointSets.begin();
+       it != this->Helper->PointSets.end(); ++it)
+    {
+    vtkMRMLMarkupsFiducialNode* fiducialNode = vtkMRMLMarkupsFiducialNode::SafeDownCast(it->first);
+    vtkSeedWidget* seedWidget = vtkSeedWidget::SafeDownCast(this->Helper->GetWidget(fiducialNode));
+    if (!fiducialNode || !seedWidget ||
+        seedWidget->GetWidgetState() == vtkSeedWidget::MovingSeed)
+      {
+      continue;
+      }
+    vtkMRMLMarkupsDisplayNode *displayNode = fiducialNode->GetMarkupsDisplayNode();
+    int n = -1;
+    if (displayNode && it->second.Actor->GetVisibility())
+      {
+      vtkMarkupsPointSet* pointSet = it->second.PointSet;
+      pointSet->SetWorldToDisplayMatrix(worldToDisplay.GetPointer());
+      double tolerance = std::max(3., displayNode->GetGlyphScale() * pixelsPerMillimeter / 2.);
+      n = pointSet->FindPointAtDisplayPosition(position[0], position[1], tolerance);
+      }
+    this->SetActivePoint(fiducialNode, n);
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsFiducialDisplayableManager3D::UpdatePointSetsOrientation()
+{
+  vtkCamera* camera = this->GetRenderer() ? this->GetRenderer()->GetActiveCamera() : 0;
+  if (!camera || camera->GetMTime() <= this->Internal->CameraTime)
+    {
+    return;
+    }
+  this->Internal->CameraTime = camera->GetMTime();
+
+  // rotate the glyphs in the view plane, as vtkFollower does
+  double* viewUp = camera->GetViewUp();
+  double rz[3];
+  camera->GetDirectionOfProjection(rz);
+  rz[0] = -rz[0];
+  rz[1] = -rz[1];
+  rz[2] = -rz[2];
+  double rx[3];
+  vtkMath::Cross(viewUp, rz, rx);
+  vtkMath::Normalize(rx);
+  double ry[3];
+  vtkMath::Cross(rz, rx, ry);
+  vtkNew<vtkMatrix4x4> orientation;
+  for (int i = 0; i < 3; ++i)
+    {
+    orientation->SetElement(i, 0, rx[i]);
+    orientation->SetElement(i, 1, ry[i]);
+    orientation->SetElement(i, 2, rz[i]);
+    }
+  for (vtkMRMLMarkupsDisplayableManagerHelper::PointSetsIt it = this->Helper->PointSets.begin();
+       it != this->Helper->PointSets.end(); ++it)
+    {
+    vtkMRMLMarkupsDisplayableManagerHelper::SetPointSetGlyphOrientation(
+      &it->second, orientation.GetPointer());
+    }
+}
@@ -39,10 +39,20 @@ public:
   vtkTypeMacro(vtkMRMLMarkupsFiducialDisplayableManager3D, vtkMRMLMarkupsDisplayableManager3D);
   void PrintSelf(ostream& os, vtkIndent indent);
 
+  /// Lists with at least this number of markups are drawn with a single
+  /// glyph actor instead of a handle per markup. A handle is then only
+  /// created for the markup under the mouse. 500 by default.
+  vtkSetClampMacro(PointSetThreshold, int, 1, VTK_INT_MAX);
+  vtkGetMacro(PointSetThreshold, int);
+
+  /// Return the index of the markup shown by the seed of the node widget,
+  /// -1 if none.
+  int GetMarkupIndexFromSeedIndex(vtkMRMLMarkupsNode* node, int seedIndex);
+
 protected:
 
-  vtkMRMLMarkupsFiducialDisplayableManager3D(){this->Focus="vtkMRMLMarkupsFiducialNode";}
-  virtual ~vtkMRMLMarkupsFiducialDisplayableManager3D(){}
+  vtkMRMLMarkupsFiducialDisplayableManager3D();
+  virtual ~vtkMRMLMarkupsFiducialDisplayableManager3D();
 
   /// Callback for click in RenderWindow
   virtual void OnClickInRenderWindow(double x, double y, const char *associatedNodeID);
@@ -78,11 +88,32 @@ protected:
 
   // Clean up when scene closes
   virtual void OnMRMLSceneEndClose();
+  virtual void OnMRMLSceneNodeRemoved(vtkMRMLNode* node);
+
+  /// Return the index of the seed that shows the nth markup, -1 if none.
+  int GetSeedIndexFromMarkupIndex(vtkMRMLMarkupsNode* node, int n);
+
+  /// Update the glyphs of a list drawn as a point set. The markups are only
+  /// read again if the node or its transform changed since the last update.
+  void UpdatePointSet(vtkMRMLMarkupsFiducialNode* fiducialNode);
+  /// Show a handle on the nth markup of a list drawn as a point set, -1 to
+  /// remove it.
+  void SetActivePoint(vtkMRMLMarkupsFiducialNode* fiducialNode, int n);
+  /// Show a handle on the markup under the mouse.
+  void UpdateActivePoints();
+  /// Orient the 2D glyphs of the point sets toward the camera.
+  void UpdatePointSetsOrientation();
+
+  int PointSetThreshold;
 
 private:
 
   vtkMRMLMarkupsFiducialDisplayableManager3D(const vtkMRMLMarkupsFiducialDisplayableManager3D&); /// Not implemented
   void operator=(const vtkMRMLMarkupsFiducialDisplayableManager3D&); /// Not Implemented
+
+  class vtkInternal;
+  friend class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
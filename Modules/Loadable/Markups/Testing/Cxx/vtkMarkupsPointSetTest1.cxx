@@ -0,0 +1,168 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MarkupsModule/VTKWidgets includes
+#include "vtkMarkupsPointSet.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <sstream>
+
+// a grid of points 1mm apart, picked and moved the way the fiducial
+// displayable managers do with large lists
+int vtkMarkupsPointSetTest1(int , char * [] )
+{
+  const int side = 225;
+  const int numberOfPoints = side * side;
+
+  vtkNew<vtkMarkupsPointSet> pointSet;
+  vtkNew<vtkTimerLog> timer;
+
+  timer->StartTimer();
+  pointSet->SetNumberOfPoints(numberOfPoints);
+  for (int n = 0; n < numberOfPoints; ++n)
+    {
+    double world[3] = {static_cast<double>(n % side), static_cast<double>(n / side), 0.};
+    std::stringstream label;
+    label << "F-" << n;
+    pointSet->SetPoint(n, world, true, n % 2 == 0, label.str().c_str());
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"SetPoints\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  if (pointSet->GetNumberOfPoints() != numberOfPoints ||
+      pointSet->GetWorldPolyData()->GetNumberOfPoints() != numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of points: "
+              << pointSet->GetNumberOfPoints() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // 4 pixels per millimeter, the depth is the world z
+  vtkNew<vtkMatrix4x4> worldToDisplay;
+  worldToDisplay->SetElement(0, 0, 4.);
+  worldToDisplay->SetElement(1, 1, 4.);
+  pointSet->SetWorldToDisplayMatrix(worldToDisplay.GetPointer());
+
+  timer->StartTimer();
+  int found = pointSet->FindPointAtDisplayPosition(4. * 100 + 1., 4. * 20 - 1., 2.);
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"FirstPick\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  if (found != 20 * side + 100)
+    {
+    std::cerr << "Line " << __LINE__ << ": picked " << found
+              << " instead of " << 20 * side + 100 << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (pointSet->FindPointAtDisplayPosition(4. * 100 + 2., 4. * 20 + 2., 1.) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": picked a point between points" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the picks reuse the locator
+  timer->StartTimer();
+  for (int i = 0; i < 1000; ++i)
+    {
+    if (pointSet->FindPointAtDisplayPosition(4. * (i % side), 4. * (i / side), 1.) != i)
+      {
+      std::cerr << "Line " << __LINE__ << ": failed to pick point " << i << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"Picks\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // the active point is not drawn by the glyphs, it is picked first
+  pointSet->SetActivePoint(5);
+  vtkPolyData* displayPolyData = pointSet->GetDisplayPolyData();
+  if (displayPolyData->GetNumberOfPoints() != numberOfPoints - 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": active point is displayed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (pointSet->FindPointAtDisplayPosition(4. * 5 + 3., 0., 4.) != 5)
+    {
+    std::cerr << "Line " << __LINE__ << ": active point is not picked first" << std::endl;
+    return EXIT_FAILURE;
+    }
+  pointSet->SetActivePoint(-1);
+
+  // move a point in front of another one: the closest is picked
+  double world[3] = {101., 20., -0.1};
+  pointSet->SetPoint(7, world, true, false, "front");
+  if (pointSet->FindPointAtDisplayPosition(4. * 101, 4. * 20, 1.) != 7)
+    {
+    std::cerr << "Line " << __LINE__ << ": the closest point is not picked" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // hidden points and the points out of the depth range are neither displayed
+  // nor picked
+  world[2] = 0.;
+  pointSet->SetPoint(7, world, false, false, "hidden");
+  if (pointSet->FindPointAtDisplayPosition(4. * 101, 4. * 20, 1.) != 20 * side + 101)
+    {
+    std::cerr << "Line " << __LINE__ << ": hidden point is picked" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (pointSet->GetPointVisibility(7) ||
+      pointSet->GetDisplayPolyData()->GetNumberOfPoints() != numberOfPoints - 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": hidden point is displayed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  pointSet->SetDepthRange(0.5, 1.);
+  if (pointSet->GetDisplayPolyData()->GetNumberOfPoints() != 0 ||
+      pointSet->FindPointAtDisplayPosition(0., 0., 1.) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": points out of the depth range are displayed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  pointSet->SetDepthRange(-1., 1.);
+
+  // updating a single point while dragging it
+  timer->StartTimer();
+  for (int i = 0; i < 100; ++i)
+    {
+    world[0] = 0.5 + i * 0.01;
+    world[1] = 0.5;
+    pointSet->SetPoint(0, world, true, false, "F-0");
+    pointSet->FindPointAtDisplayPosition(4. * world[0], 4. * world[1], 1.);
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"IncrementalUpdates\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  double position[3];
+  pointSet->GetPoint(0, position);
+  if (position[0] != world[0] || position[1] != world[1])
+    {
+    std::cerr << "Line " << __LINE__ << ": point was not moved" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,192 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MarkupsModule/VTKWidgets includes
+#include "vtkMarkupsPointSet.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Point displayed within tolerance of (x, y) with the smallest depth, found
+// by projecting all the points. The display matrix is a 4x scaling.
+int findPointByProjectingAll(vtkMarkupsPointSet* pointSet, double x, double y,
+                             double tolerance)
+{
+  int index = -1;
+  double closestDepth = VTK_DOUBLE_MAX;
+  for (int n = 0; n < pointSet->GetNumberOfPoints(); ++n)
+    {
+    double world[3];
+    pointSet->GetPoint(n, world);
+    const double dx = 4. * world[0] - x;
+    const double dy = 4. * world[1] - y;
+    if (pointSet->GetPointVisibility(n) && n != pointSet->GetActivePoint() &&
+        world[2] >= -1. && world[2] < 1. &&
+        dx * dx + dy * dy <= tolerance * tolerance && world[2] < closestDepth)
+      {
+      closestDepth = world[2];
+      index = n;
+      }
+    }
+  return index;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+// Points placed one at a time with picks in between, the way the fiducial
+// displayable managers append markups to a large list
+int vtkMarkupsPointSetTest2(int , char * [] )
+{
+  const int side = 200;
+  const int numberOfPoints = side * side;
+
+  vtkNew<vtkMarkupsPointSet> pointSet;
+  vtkNew<vtkMatrix4x4> worldToDisplay;
+  worldToDisplay->SetElement(0, 0, 4.);
+  worldToDisplay->SetElement(1, 1, 4.);
+  pointSet->SetWorldToDisplayMatrix(worldToDisplay.GetPointer());
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int n = 0; n < numberOfPoints; ++n)
+    {
+    double world[3] = {static_cast<double>(n % side), static_cast<double>(n / side), 0.};
+    std::stringstream label;
+    label << "F-" << n;
+    pointSet->SetPoint(n, world, true, false, label.str().c_str());
+    if (pointSet->FindPointAtDisplayPosition(4. * world[0], 4. * world[1], 1.) != n)
+      {
+      std::cerr << "Line " << __LINE__ << ": appended point " << n
+                << " is not picked" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"AppendAndPick\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // one vertex per point, in order
+  vtkPolyData* worldPolyData = pointSet->GetWorldPolyData();
+  vtkCellArray* verts = worldPolyData->GetVerts();
+  if (worldPolyData->GetNumberOfPoints() != numberOfPoints ||
+      verts->GetNumberOfCells() != numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << ": " << verts->GetNumberOfCells()
+              << " vertices for " << worldPolyData->GetNumberOfPoints()
+              << " points" << std::endl;
+    return EXIT_FAILURE;
+    }
+  vtkIdType npts = 0;
+  vtkIdType* pts = 0;
+  verts->InitTraversal();
+  for (vtkIdType n = 0; verts->GetNextCell(npts, pts); ++n)
+    {
+    if (npts != 1 || pts[0] != n)
+      {
+      std::cerr << "Line " << __LINE__ << ": wrong vertex " << n << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  if (pointSet->GetDisplayPolyData()->GetNumberOfPoints() != numberOfPoints)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of displayed points: "
+              << pointSet->GetDisplayPolyData()->GetNumberOfPoints() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // hide, show, move in front and activate points between picks, the picks
+  // match the ones found by projecting all the points
+  timer->StartTimer();
+  for (int i = 0; i < 2000; ++i)
+    {
+    const int n = (i * 7919) % numberOfPoints;
+    double world[3];
+    pointSet->GetPoint(n, world);
+    switch (i % 4)
+      {
+      case 0:
+        pointSet->SetPoint(n, world, false, false, "hidden");
+        break;
+      case 1:
+        // in front of the next point, at a depth no other point has
+        world[0] += 1.;
+        world[2] = -0.5 + 1e-4 * i;
+        pointSet->SetPoint(n, world, true, true, "moved");
+        break;
+      case 2:
+        pointSet->SetPoint(n, world, true, false, "shown");
+        break;
+      default:
+        pointSet->SetActivePoint(n);
+        break;
+      }
+    const double x = 4. * world[0];
+    const double y = 4. * world[1];
+    int expected = findPointByProjectingAll(pointSet.GetPointer(), x, y, 1.);
+    int active = pointSet->GetActivePoint();
+    if (pointSet->GetPointVisibility(active))
+      {
+      double activeWorld[3];
+      pointSet->GetPoint(active, activeWorld);
+      if (activeWorld[0] == world[0] && activeWorld[1] == world[1])
+        {
+        expected = active;
+        }
+      }
+    int found = pointSet->FindPointAtDisplayPosition(x, y, 1.);
+    if (found != expected)
+      {
+      std::cerr << "Line " << __LINE__ << ": update " << i << " picked "
+                << found << " instead of " << expected << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"UpdateAndPick\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // removing points projects all the points again
+  pointSet->SetActivePoint(-1);
+  pointSet->SetNumberOfPoints(side);
+  int displayed = 0;
+  for (int n = 0; n < side; ++n)
+    {
+    displayed += pointSet->GetPointVisibility(n) ? 1 : 0;
+    }
+  if (pointSet->GetWorldPolyData()->GetVerts()->GetNumberOfCells() != side ||
+      pointSet->GetDisplayPolyData()->GetNumberOfPoints() != displayed ||
+      pointSet->FindPointAtDisplayPosition(4. * 100, 4. * 100, 1.) != -1)
+    {
+    std::cerr << "Line " << __LINE__ << ": removed points are displayed" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,654 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MarkupsModule/VTKWidgets includes
+#include "vtkMarkupsPointSet.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdList.h>
+#include <vtkIdTypeArray.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPointLocator.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkStringArray.h>
+#include <vtkUnsignedCharArray.h>
+
+// STD includes
+#include <vector>
+
+//----------------------------------------------------------------------------
+class vtkMarkupsPointSet::vtkInternal
+{
+public:
+  void Resize(int number);
+  /// Add the nth point to a list of modified points if it is not in it yet
+  static void AddModifiedPoint(int n, std::vector<int>& points,
+                               std::vector<bool>& isModified);
+  static void ClearModifiedPoints(std::vector<int>& points,
+                                  std::vector<bool>& isModified);
+
+  /// Index of each point in the display poly data, -1 if not displayed
+  std::vector<vtkIdType> DisplayIds;
+  /// Points to project at the next update of the display poly data
+  std::vector<int> ModifiedPoints;
+  std::vector<bool> IsModified;
+  /// Points modified since the locator was built, they are searched one by
+  /// one instead
+  std::vector<int> LocatorModifiedPoints;
+  std::vector<bool> IsLocatorModified;
+};
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::vtkInternal::Resize(int number)
+{
+  // removed points are not in the lists anymore
+  for (std::vector<int>::iterator it = this->ModifiedPoints.begin();
+       it != this->ModifiedPoints.end();)
+    {
+    it = (*it >= number) ? this->ModifiedPoints.erase(it) : it + 1;
+    }
+  for (std::vector<int>::iterator it = this->LocatorModifiedPoints.begin();
+       it != this->LocatorModifiedPoints.end();)
+    {
+    it = (*it >= number) ? this->LocatorModifiedPoints.erase(it) : it + 1;
+    }
+  this->DisplayIds.resize(number, -1);
+  this->IsModified.resize(number, false);
+  this->IsLocatorModified.resize(number, false);
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::vtkInternal::AddModifiedPoint(
+  int n, std::vector<int>& points, std::vector<bool>& isModified)
+{
+  if (!isModified[n])
+    {
+    isModified[n] = true;
+    points.push_back(n);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::vtkInternal::ClearModifiedPoints(
+  std::vector<int>& points, std::vector<bool>& isModified)
+{
+  for (std::vector<int>::const_iterator it = points.begin(); it != points.end(); ++it)
+    {
+    isModified[*it] = false;
+    }
+  points.clear();
+}
+
+vtkStandardNewMacro(vtkMarkupsPointSet);
+
+//----------------------------------------------------------------------------
+vtkMarkupsPointSet::vtkMarkupsPointSet()
+{
+  this->Internal = new vtkInternal;
+
+  this->WorldPolyData = vtkPolyData::New();
+  vtkPoints* points = vtkPoints::New();
+  points->SetDataTypeToDouble();
+  this->WorldPolyData->SetPoints(points);
+  points->Delete();
+  // one vertex per point so that the poly data can be rendered as is
+  vtkCellArray* verts = vtkCellArray::New();
+  this->WorldPolyData->SetVerts(verts);
+  verts->Delete();
+  vtkUnsignedCharArray* visibility = vtkUnsignedCharArray::New();
+  visibility->SetName("Visibility");
+  this->WorldPolyData->GetPointData()->AddArray(visibility);
+  visibility->Delete();
+  vtkUnsignedCharArray* selected = vtkUnsignedCharArray::New();
+  selected->SetName("Selected");
+  this->WorldPolyData->GetPointData()->AddArray(selected);
+  selected->Delete();
+  vtkStringArray* labels = vtkStringArray::New();
+  labels->SetName("Label");
+  this->WorldPolyData->GetPointData()->AddArray(labels);
+  labels->Delete();
+  // the actual state of the points, "Visibility" and "Label" also depend on
+  // the active point
+  vtkUnsignedCharArray* pointVisibility = vtkUnsignedCharArray::New();
+  pointVisibility->SetName("PointVisibility");
+  this->WorldPolyData->GetPointData()->AddArray(pointVisibility);
+  pointVisibility->Delete();
+  vtkStringArray* pointLabels = vtkStringArray::New();
+  pointLabels->SetName("PointLabel");
+  this->WorldPolyData->GetPointData()->AddArray(pointLabels);
+  pointLabels->Delete();
+
+  // the display poly data is updated in place, it is the input of the
+  // display pipelines
+  this->DisplayPolyData = vtkPolyData::New();
+  vtkPoints* displayPoints = vtkPoints::New();
+  displayPoints->SetDataTypeToDouble();
+  this->DisplayPolyData->SetPoints(displayPoints);
+  displayPoints->Delete();
+  vtkCellArray* displayVerts = vtkCellArray::New();
+  this->DisplayPolyData->SetVerts(displayVerts);
+  displayVerts->Delete();
+  vtkUnsignedCharArray* displaySelected = vtkUnsignedCharArray::New();
+  displaySelected->SetName("Selected");
+  this->DisplayPolyData->GetPointData()->SetScalars(displaySelected);
+  displaySelected->Delete();
+  vtkStringArray* displayLabels = vtkStringArray::New();
+  displayLabels->SetName("Label");
+  this->DisplayPolyData->GetPointData()->AddArray(displayLabels);
+  displayLabels->Delete();
+  vtkDoubleArray* depths = vtkDoubleArray::New();
+  depths->SetName("Depth");
+  this->DisplayPolyData->GetPointData()->AddArray(depths);
+  depths->Delete();
+  vtkIdTypeArray* indices = vtkIdTypeArray::New();
+  indices->SetName("Index");
+  this->DisplayPolyData->GetPointData()->AddArray(indices);
+  indices->Delete();
+
+  this->LocatorPolyData = vtkPolyData::New();
+  vtkPoints* locatorPoints = vtkPoints::New();
+  locatorPoints->SetDataTypeToDouble();
+  this->LocatorPolyData->SetPoints(locatorPoints);
+  locatorPoints->Delete();
+  vtkIdTypeArray* locatorIndices = vtkIdTypeArray::New();
+  locatorIndices->SetName("Index");
+  this->LocatorPolyData->GetPointData()->AddArray(locatorIndices);
+  locatorIndices->Delete();
+
+  this->Locator = vtkPointLocator::New();
+  this->WorldToDisplayMatrix = vtkMatrix4x4::New();
+  this->DepthRange[0] = -1.;
+  this->DepthRange[1] = 1.;
+  this->ActivePoint = -1;
+  this->ProjectionTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkMarkupsPointSet::~vtkMarkupsPointSet()
+{
+  this->WorldPolyData->Delete();
+  this->DisplayPolyData->Delete();
+  this->LocatorPolyData->Delete();
+  this->Locator->Delete();
+  this->WorldToDisplayMatrix->Delete();
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "NumberOfPoints: " << this->GetNumberOfPoints() << "\n";
+  os << indent << "ActivePoint: " << this->ActivePoint << "\n";
+  os << indent << "DepthRange: " << this->DepthRange[0] << ", "
+     << this->DepthRange[1] << "\n";
+  os << indent << "WorldToDisplayMatrix:\n";
+  this->WorldToDisplayMatrix->PrintSelf(os, indent.GetNextIndent());
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::SetNumberOfPoints(int number)
+{
+  number = number < 0 ? 0 : number;
+  int oldNumber = this->GetNumberOfPoints();
+  if (number == oldNumber)
+    {
+    return;
+    }
+  vtkPointData* pointData = this->WorldPolyData->GetPointData();
+  vtkPoints* points = this->WorldPolyData->GetPoints();
+  vtkCellArray* verts = this->WorldPolyData->GetVerts();
+  vtkUnsignedCharArray* visibility = vtkUnsignedCharArray::SafeDownCast(pointData->GetArray("Visibility"));
+  vtkUnsignedCharArray* selected = vtkUnsignedCharArray::SafeDownCast(pointData->GetArray("Selected"));
+  vtkUnsignedCharArray* pointVisibility = vtkUnsignedCharArray::SafeDownCast(pointData->GetArray("PointVisibility"));
+  vtkStringArray* labels = vtkStringArray::SafeDownCast(pointData->GetAbstractArray("Label"));
+  vtkStringArray* pointLabels = vtkStringArray::SafeDownCast(pointData->GetAbstractArray("PointLabel"));
+
+  if (number > oldNumber)
+    {
+    // the Insert methods grow the arrays geometrically, appending points one
+    // at a time is amortized O(1)
+    for (vtkIdType n = oldNumber; n < number; ++n)
+      {
+      points->InsertNextPoint(0., 0., 0.);
+      visibility->InsertNextValue(0);
+      selected->InsertNextValue(0);
+      pointVisibility->InsertNextValue(0);
+      labels->InsertNextValue("");
+      pointLabels->InsertNextValue("");
+      verts->InsertNextCell(1, &n);
+      }
+    }
+  else
+    {
+    // shrinking keeps the allocated memory
+    points->SetNumberOfPoints(number);
+    visibility->SetNumberOfTuples(number);
+    selected->SetNumberOfTuples(number);
+    pointVisibility->SetNumberOfTuples(number);
+    labels->SetNumberOfValues(number);
+    pointLabels->SetNumberOfValues(number);
+    verts->GetData()->SetNumberOfTuples(2 * number);
+    verts->SetCells(number, verts->GetData());
+    // removed points may be displayed
+    this->ProjectionTime.Modified();
+    }
+  verts->Modified();
+  this->WorldPolyData->DeleteCells();
+  this->Internal->Resize(number);
+
+  if (this->ActivePoint >= number)
+    {
+    this->ActivePoint = -1;
+    }
+  this->WorldPolyData->Modified();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkMarkupsPointSet::GetNumberOfPoints()
+{
+  return static_cast<int>(this->WorldPolyData->GetNumberOfPoints());
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::SetPoint(int n, const double world[3], bool visible,
+                                  bool selected, const char* label)
+{
+  if (n < 0)
+    {
+    vtkErrorMacro("SetPoint: invalid index " << n);
+    return;
+    }
+  if (n >= this->GetNumberOfPoints())
+    {
+    this->SetNumberOfPoints(n + 1);
+    }
+  label = label ? label : "";
+  vtkPointData* pointData = this->WorldPolyData->GetPointData();
+  vtkPoints* points = this->WorldPolyData->GetPoints();
+  vtkUnsignedCharArray* pointVisibility = vtkUnsignedCharArray::SafeDownCast(pointData->GetArray("PointVisibility"));
+  vtkUnsignedCharArray* selectedArray = vtkUnsignedCharArray::SafeDownCast(pointData->GetArray("Selected"));
+  vtkStringArray* pointLabels = vtkStringArray::SafeDownCast(pointData->GetAbstractArray("PointLabel"));
+  double oldWorld[3];
+  points->GetPoint(n, oldWorld);
+  if (oldWorld[0] == world[0] && oldWorld[1] == world[1] && oldWorld[2] == world[2] &&
+      (pointVisibility->GetValue(n) != 0) == visible &&
+      (selectedArray->GetValue(n) != 0) == selected &&
+      pointLabels->GetValue(n) == label)
+    {
+    return;
+    }
+
+  points->SetPoint(n, world);
+  points->Modified();
+  pointVisibility->SetValue(n, visible ? 1 : 0);
+  selectedArray->SetValue(n, selected ? 1 : 0);
+  pointLabels->SetValue(n, label);
+
+  bool shown = visible && n != this->ActivePoint;
+  vtkUnsignedCharArray::SafeDownCast(pointData->GetArray("Visibility"))->SetValue(n, shown ? 1 : 0);
+  vtkStringArray::SafeDownCast(pointData->GetAbstractArray("Label"))->SetValue(n, shown ? label : "");
+
+  this->PointModified(n);
+  pointData->Modified();
+  this->WorldPolyData->Modified();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::GetPoint(int n, double world[3])
+{
+  if (n < 0 || n >= this->GetNumberOfPoints())
+    {
+    vtkErrorMacro("GetPoint: index " << n << " out of range");
+    return;
+    }
+  this->WorldPolyData->GetPoints()->GetPoint(n, world);
+}
+
+//----------------------------------------------------------------------------
+bool vtkMarkupsPointSet::GetPointVisibility(int n)
+{
+  if (n < 0 || n >= this->GetNumberOfPoints())
+    {
+    return false;
+    }
+  vtkUnsignedCharArray* pointVisibility = vtkUnsignedCharArray::SafeDownCast(
+    this->WorldPolyData->GetPointData()->GetArray("PointVisibility"));
+  return pointVisibility->GetValue(n) != 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::SetActivePoint(int n)
+{
+  if (n < -1 || n >= this->GetNumberOfPoints())
+    {
+    n = -1;
+    }
+  if (n == this->ActivePoint)
+    {
+    return;
+    }
+  vtkPointData* pointData = this->WorldPolyData->GetPointData();
+  vtkUnsignedCharArray* visibility = vtkUnsignedCharArray::SafeDownCast(pointData->GetArray("Visibility"));
+  vtkStringArray* labels = vtkStringArray::SafeDownCast(pointData->GetAbstractArray("Label"));
+  vtkStringArray* pointLabels = vtkStringArray::SafeDownCast(pointData->GetAbstractArray("PointLabel"));
+  int oldActivePoint = this->ActivePoint;
+  this->ActivePoint = n;
+  if (oldActivePoint >= 0)
+    {
+    bool visible = this->GetPointVisibility(oldActivePoint);
+    visibility->SetValue(oldActivePoint, visible ? 1 : 0);
+    labels->SetValue(oldActivePoint, visible ? pointLabels->GetValue(oldActivePoint) : vtkStdString());
+    this->PointModified(oldActivePoint);
+    }
+  if (n >= 0)
+    {
+    visibility->SetValue(n, 0);
+    labels->SetValue(n, "");
+    this->PointModified(n);
+    }
+  pointData->Modified();
+  this->WorldPolyData->Modified();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkMarkupsPointSet::GetWorldPolyData()
+{
+  return this->WorldPolyData;
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::SetWorldToDisplayMatrix(vtkMatrix4x4* matrix)
+{
+  if (!matrix)
+    {
+    return;
+    }
+  for (int i = 0; i < 4; ++i)
+    {
+    for (int j = 0; j < 4; ++j)
+      {
+      if (matrix->GetElement(i, j) != this->WorldToDisplayMatrix->GetElement(i, j))
+        {
+        this->WorldToDisplayMatrix->DeepCopy(matrix);
+        this->ProjectionTime.Modified();
+        this->Modified();
+        return;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::SetDepthRange(double min, double max)
+{
+  if (min == this->DepthRange[0] && max == this->DepthRange[1])
+    {
+    return;
+    }
+  this->DepthRange[0] = min;
+  this->DepthRange[1] = max;
+  this->ProjectionTime.Modified();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMarkupsPointSet::WorldToDisplay(const double world[3], double display[3])
+{
+  double in[4] = {world[0], world[1], world[2], 1.};
+  double out[4];
+  this->WorldToDisplayMatrix->MultiplyPoint(in, out);
+  if (out[3] <= 0.)
+    {
+    return false;
+    }
+  display[0] = out[0] / out[3];
+  display[1] = out[1] / out[3];
+  display[2] = out[2] / out[3];
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::PointModified(int n)
+{
+  vtkInternal::AddModifiedPoint(n, this->Internal->ModifiedPoints,
+                                this->Internal->IsModified);
+  vtkInternal::AddModifiedPoint(n, this->Internal->LocatorModifiedPoints,
+                                this->Internal->IsLocatorModified);
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkMarkupsPointSet::GetDisplayPolyData()
+{
+  this->UpdateDisplayPolyData();
+  return this->DisplayPolyData;
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::UpdateDisplayPolyData()
+{
+  if (this->DisplayPolyDataTime < this->ProjectionTime)
+    {
+    this->ProjectAllPoints();
+    return;
+    }
+  if (this->Internal->ModifiedPoints.empty())
+    {
+    return;
+    }
+  for (std::vector<int>::const_iterator it = this->Internal->ModifiedPoints.begin();
+       it != this->Internal->ModifiedPoints.end(); ++it)
+    {
+    this->ProjectPoint(*it);
+    }
+  vtkInternal::ClearModifiedPoints(this->Internal->ModifiedPoints,
+                                   this->Internal->IsModified);
+  this->DisplayPolyData->DeleteCells();
+  this->DisplayPolyData->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::ProjectAllPoints()
+{
+  vtkPointData* displayPointData = this->DisplayPolyData->GetPointData();
+  this->DisplayPolyData->GetPoints()->Reset();
+  this->DisplayPolyData->GetVerts()->Reset();
+  displayPointData->GetArray("Selected")->Reset();
+  displayPointData->GetAbstractArray("Label")->Reset();
+  displayPointData->GetArray("Depth")->Reset();
+  displayPointData->GetArray("Index")->Reset();
+  this->Internal->DisplayIds.assign(this->Internal->DisplayIds.size(), -1);
+
+  int numberOfPoints = this->GetNumberOfPoints();
+  for (int n = 0; n < numberOfPoints; ++n)
+    {
+    this->ProjectPoint(n);
+    }
+  vtkInternal::ClearModifiedPoints(this->Internal->ModifiedPoints,
+                                   this->Internal->IsModified);
+
+  this->DisplayPolyData->GetPoints()->Modified();
+  this->DisplayPolyData->GetVerts()->Modified();
+  this->DisplayPolyData->DeleteCells();
+  this->DisplayPolyData->Modified();
+  this->DisplayPolyDataTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::ProjectPoint(int n)
+{
+  vtkPointData* worldPointData = this->WorldPolyData->GetPointData();
+  vtkUnsignedCharArray* visibility = vtkUnsignedCharArray::SafeDownCast(worldPointData->GetArray("Visibility"));
+  vtkUnsignedCharArray* selected = vtkUnsignedCharArray::SafeDownCast(worldPointData->GetArray("Selected"));
+  vtkStringArray* labels = vtkStringArray::SafeDownCast(worldPointData->GetAbstractArray("Label"));
+
+  vtkPointData* displayPointData = this->DisplayPolyData->GetPointData();
+  vtkPoints* points = this->DisplayPolyData->GetPoints();
+  vtkCellArray* verts = this->DisplayPolyData->GetVerts();
+  vtkUnsignedCharArray* displaySelected = vtkUnsignedCharArray::SafeDownCast(displayPointData->GetArray("Selected"));
+  vtkStringArray* displayLabels = vtkStringArray::SafeDownCast(displayPointData->GetAbstractArray("Label"));
+  vtkDoubleArray* depths = vtkDoubleArray::SafeDownCast(displayPointData->GetArray("Depth"));
+  vtkIdTypeArray* indices = vtkIdTypeArray::SafeDownCast(displayPointData->GetArray("Index"));
+
+  double display[3];
+  bool displayed = visibility->GetValue(n) &&
+    this->WorldToDisplay(this->WorldPolyData->GetPoints()->GetPoint(n), display) &&
+    display[2] >= this->DepthRange[0] && display[2] < this->DepthRange[1];
+  vtkIdType id = this->Internal->DisplayIds[n];
+  if (displayed && id < 0)
+    {
+    id = points->InsertNextPoint(display[0], display[1], 0.);
+    verts->InsertNextCell(1, &id);
+    displaySelected->InsertNextValue(selected->GetValue(n));
+    displayLabels->InsertNextValue(labels->GetValue(n));
+    depths->InsertNextValue(display[2]);
+    indices->InsertNextValue(n);
+    this->Internal->DisplayIds[n] = id;
+    }
+  else if (displayed)
+    {
+    points->SetPoint(id, display[0], display[1], 0.);
+    displaySelected->SetValue(id, selected->GetValue(n));
+    displayLabels->SetValue(id, labels->GetValue(n));
+    depths->SetValue(id, display[2]);
+    }
+  else if (id >= 0)
+    {
+    // move the last displayed point in place of the removed one
+    vtkIdType last = points->GetNumberOfPoints() - 1;
+    if (id != last)
+      {
+      vtkIdType moved = indices->GetValue(last);
+      points->SetPoint(id, points->GetPoint(last));
+      displaySelected->SetValue(id, displaySelected->GetValue(last));
+      displayLabels->SetValue(id, displayLabels->GetValue(last));
+      depths->SetValue(id, depths->GetValue(last));
+      indices->SetValue(id, moved);
+      this->Internal->DisplayIds[moved] = id;
+      }
+    points->SetNumberOfPoints(last);
+    displaySelected->SetNumberOfTuples(last);
+    displayLabels->SetNumberOfValues(last);
+    depths->SetNumberOfTuples(last);
+    indices->SetNumberOfTuples(last);
+    verts->GetData()->SetNumberOfTuples(2 * last);
+    verts->SetCells(last, verts->GetData());
+    this->Internal->DisplayIds[n] = -1;
+    }
+  points->Modified();
+  verts->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMarkupsPointSet::BuildLocator()
+{
+  this->LocatorPolyData->GetPoints()->DeepCopy(this->DisplayPolyData->GetPoints());
+  this->LocatorPolyData->GetPointData()->GetArray("Index")->DeepCopy(
+    this->DisplayPolyData->GetPointData()->GetArray("Index"));
+  this->LocatorPolyData->Modified();
+  this->Locator->Initialize();
+  if (this->LocatorPolyData->GetNumberOfPoints() > 0)
+    {
+    this->Locator->SetDataSet(this->LocatorPolyData);
+    this->Locator->BuildLocator();
+    }
+  vtkInternal::ClearModifiedPoints(this->Internal->LocatorModifiedPoints,
+                                   this->Internal->IsLocatorModified);
+  this->LocatorTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkMarkupsPointSet::FindPointAtDisplayPosition(double x, double y, double tolerance)
+{
+  // the active point is shown by a handle, keep it while the mouse is over it
+  if (this->ActivePoint >= 0 && this->GetPointVisibility(this->ActivePoint))
+    {
+    double display[3];
+    double world[3];
+    this->GetPoint(this->ActivePoint, world);
+    if (this->WorldToDisplay(world, display) &&
+        display[2] >= this->DepthRange[0] && display[2] < this->DepthRange[1] &&
+        (display[0] - x) * (display[0] - x) + (display[1] - y) * (display[1] - y) <= tolerance * tolerance)
+      {
+      return this->ActivePoint;
+      }
+    }
+
+  vtkPolyData* displayPolyData = this->GetDisplayPolyData();
+  // searching the modified points one by one is cheaper than rebuilding the
+  // locator as long as there are few of them
+  vtkIdType maximumNumberOfModifiedPoints = 32 + displayPolyData->GetNumberOfPoints() / 32;
+  if (this->LocatorTime < this->DisplayPolyDataTime ||
+      static_cast<vtkIdType>(this->Internal->LocatorModifiedPoints.size()) > maximumNumberOfModifiedPoints)
+    {
+    this->BuildLocator();
+    }
+
+  vtkDoubleArray* depths = vtkDoubleArray::SafeDownCast(displayPolyData->GetPointData()->GetArray("Depth"));
+  int index = -1;
+  double closestDepth = VTK_DOUBLE_MAX;
+  if (this->LocatorPolyData->GetNumberOfPoints() > 0)
+    {
+    vtkIdTypeArray* locatorIndices = vtkIdTypeArray::SafeDownCast(
+      this->LocatorPolyData->GetPointData()->GetArray("Index"));
+    double position[3] = {x, y, 0.};
+    vtkIdList* ids = vtkIdList::New();
+    this->Locator->FindPointsWithinRadius(tolerance, position, ids);
+    for (vtkIdType i = 0; i < ids->GetNumberOfIds(); ++i)
+      {
+      int n = static_cast<int>(locatorIndices->GetValue(ids->GetId(i)));
+      if (this->Internal->IsLocatorModified[n])
+        {
+        continue;
+        }
+      double depth = depths->GetValue(this->Internal->DisplayIds[n]);
+      if (depth < closestDepth)
+        {
+        closestDepth = depth;
+        index = n;
+        }
+      }
+    ids->Delete();
+    }
+  for (std::vector<int>::const_iterator it = this->Internal->LocatorModifiedPoints.begin();
+       it != this->Internal->LocatorModifiedPoints.end(); ++it)
+    {
+    vtkIdType id = this->Internal->DisplayIds[*it];
+    if (id < 0)
+      {
+      continue;
+      }
+    double display[3];
+    displayPolyData->GetPoint(id, display);
+    if ((display[0] - x) * (display[0] - x) + (display[1] - y) * (display[1] - y) <= tolerance * tolerance &&
+        depths->GetValue(id) < closestDepth)
+      {
+      closestDepth = depths->GetValue(id);
+      index = *it;
+      }
+    }
+  return index;
+}
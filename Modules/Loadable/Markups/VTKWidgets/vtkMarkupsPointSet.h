@@ -0,0 +1,138 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+///  vtkMarkupsPointSet - points of a markups list drawn as a single set of
+/// glyphs
+///
+/// vtkMarkupsPointSet keeps the world position, visibility, selection state
+/// and label of every point of a list in one poly data, so that large lists
+/// can be displayed by one glyph actor instead of one handle widget per
+/// point. Setting a point is O(1) and appending points grows the arrays
+/// geometrically, the glyphs are regenerated at the next render.
+///
+/// The points are projected in display coordinates with the
+/// WorldToDisplayMatrix. The projected points are cached, as well as a
+/// point locator built on them that is used to find the point under the
+/// mouse. All the points are projected again only when the projection
+/// changes or when points are removed, otherwise only the points set since
+/// the last projection are updated. The locator is rebuilt once enough
+/// points have been set since it was built, until then these points are
+/// searched one by one.
+///
+/// The active point is the one shown by a handle widget while the user
+/// interacts with it, it is not drawn by the glyphs.
+
+#ifndef __vtkMarkupsPointSet_h
+#define __vtkMarkupsPointSet_h
+
+#include "vtkSlicerMarkupsModuleVTKWidgetsExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+class vtkMatrix4x4;
+class vtkPointLocator;
+class vtkPolyData;
+
+class VTK_SLICER_MARKUPS_MODULE_VTKWIDGETS_EXPORT vtkMarkupsPointSet : public vtkObject
+{
+public:
+  static vtkMarkupsPointSet *New();
+  vtkTypeMacro(vtkMarkupsPointSet,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Resize the point set. New points are hidden.
+  void SetNumberOfPoints(int number);
+  int GetNumberOfPoints();
+
+  /// Set the world position, visibility, selection state and label of the
+  /// nth point. The point set is resized if n is past the end. Nothing is
+  /// modified if the point is unchanged.
+  void SetPoint(int n, const double world[3], bool visible, bool selected,
+                const char* label);
+  void GetPoint(int n, double world[3]);
+  bool GetPointVisibility(int n);
+
+  /// Point hidden from the glyphs because it is shown by a handle widget,
+  /// -1 if none.
+  void SetActivePoint(int n);
+  vtkGetMacro(ActivePoint, int);
+
+  /// Points in world coordinates. The point data has a "Visibility" array
+  /// (1 if the point is visible and is not the active point, 0 otherwise),
+  /// a "Selected" array and a "Label" array (empty for hidden points).
+  vtkPolyData* GetWorldPolyData();
+
+  /// Homogeneous transform from world to display coordinates. After
+  /// projection, the z coordinate is the depth of the point.
+  void SetWorldToDisplayMatrix(vtkMatrix4x4* matrix);
+
+  /// Only the points whose depth is within this range are displayed and
+  /// picked. [-1, 1] by default.
+  void SetDepthRange(double min, double max);
+  vtkGetVector2Macro(DepthRange, double);
+
+  /// Visible points, but the active one, that are within DepthRange, at
+  /// their display position (z = 0). The point data has "Selected", "Label",
+  /// "Depth" and "Index" (index of the point in the list) arrays.
+  vtkPolyData* GetDisplayPolyData();
+
+  /// Return the index of the point displayed within tolerance (in pixels)
+  /// of the display position (x, y), the active point first, then the one
+  /// with the smallest depth. Return -1 if there is none.
+  int FindPointAtDisplayPosition(double x, double y, double tolerance);
+
+protected:
+  vtkMarkupsPointSet();
+  ~vtkMarkupsPointSet();
+
+  /// Project the points in display coordinates if needed.
+  void UpdateDisplayPolyData();
+  /// Project all the points.
+  void ProjectAllPoints();
+  /// Add, move or remove the nth point in the display poly data.
+  void ProjectPoint(int n);
+  /// Project a world position, return false if it is behind the viewer.
+  bool WorldToDisplay(const double world[3], double display[3]);
+  /// Schedule the projection of the nth point.
+  void PointModified(int n);
+  /// Build the locator on a copy of the display points.
+  void BuildLocator();
+
+  vtkPolyData* WorldPolyData;
+  vtkPolyData* DisplayPolyData;
+  /// Display points the locator is built on.
+  vtkPolyData* LocatorPolyData;
+  vtkPointLocator* Locator;
+  vtkMatrix4x4* WorldToDisplayMatrix;
+  double DepthRange[2];
+  int ActivePoint;
+
+  /// All the points must be projected again after this time.
+  vtkTimeStamp ProjectionTime;
+  vtkTimeStamp DisplayPolyDataTime;
+  vtkTimeStamp LocatorTime;
+
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkMarkupsPointSet(const vtkMarkupsPointSet&);  /// Not implemented.
+  void operator=(const vtkMarkupsPointSet&);  /// Not implemented.
+};
+
+#endif
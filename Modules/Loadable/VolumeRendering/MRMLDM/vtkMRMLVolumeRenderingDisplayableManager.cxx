@@ -22,6 +22,7 @@
 #include "vtkImageGradientMagnitude.h"
 #include "vtkMRMLVolumeRenderingDisplayableManager.h"
 #include "vtkSlicerFixedPointVolumeRayCastMapper.h"
+#include "vtkSlicerVolumeImagePyramid.h"
 #include "vtkSlicerVolumeRenderingLogic.h"
 
 #include "vtkMRMLCPURayCastVolumeRenderingDisplayNode.h"
@@ -45,6 +46,7 @@
 // VTK includes
 #include <vtkAbstractTransform.h>
 #include <vtkCallbackCommand.h>
+#include <vtkCamera.h>
 #include "vtkFixedPointVolumeRayCastMapper.h"
 #include "vtkGPUVolumeRayCastMapper.h"
 #include "vtkImageData.h"
@@ -76,6 +78,22 @@
 //---------------------------------------------------------------------------
 vtkStandardNewMacro (vtkMRMLVolumeRenderingDisplayableManager);
 
+namespace
+{
+// Delay in ms between the renderings of 2 levels of the image pyramid
+const unsigned long RefinementDelay = 100;
+
+//---------------------------------------------------------------------------
+void GetCameraState(vtkCamera* camera, double state[11])
+{
+  camera->GetPosition(state);
+  camera->GetFocalPoint(state + 3);
+  camera->GetViewUp(state + 6);
+  state[9] = camera->GetViewAngle();
+  state[10] = camera->GetParallelScale();
+}
+}
+
 //---------------------------------------------------------------------------
 bool vtkMRMLVolumeRenderingDisplayableManager::First = true;
 int vtkMRMLVolumeRenderingDisplayableManager::DefaultGPUMemorySize = 256;
@@ -86,6 +104,10 @@ vtkMRMLVolumeRenderingDisplayableManager::vtkMRMLVolumeRenderingDisplayableManag
   this->MapperRaycast = NULL;
   this->MapperGPURaycast3 = NULL;
   this->Volume = NULL;
+  this->ImagePyramid = vtkSlicerVolumeImagePyramid::New();
+  this->RaycastLevel = 0;
+  this->RefinementTimerId = 0;
+  std::fill(this->RefinementCameraState, this->RefinementCameraState + 11, 0.);
   //this->Histograms = vtkKWHistogramSet::New();
   //this->HistogramsFg = vtkKWHistogramSet::New();
   //this->VolumePropertyGPURaycast3 = NULL;
@@ -121,11 +143,13 @@ vtkMRMLVolumeRenderingDisplayableManager::vtkMRMLVolumeRenderingDisplayableManag
   this->RemoveInteractorStyleObservableEvent(vtkCommand::LeaveEvent);
   this->AddInteractorStyleObservableEvent(vtkCommand::StartInteractionEvent);
   this->AddInteractorStyleObservableEvent(vtkCommand::EndInteractionEvent);
+  this->AddInteractorObservableEvent(vtkCommand::TimerEvent);
 }
 
 //---------------------------------------------------------------------------
 vtkMRMLVolumeRenderingDisplayableManager::~vtkMRMLVolumeRenderingDisplayableManager()
 {
+  this->StopRefinement();
   this->RemoveDisplayNodes();
 
   if (this->VolumeRenderingLogic)
@@ -142,6 +166,8 @@ vtkMRMLVolumeRenderingDisplayableManager::~vtkMRMLVolumeRenderingDisplayableMana
   vtkSetMRMLNodeMacro(this->MapperRaycast, NULL);
   vtkSetMRMLNodeMacro(this->MapperGPURaycast3, NULL);
   vtkSetMRMLNodeMacro(this->Volume, NULL);
+  this->MapperRaycastLevels.clear();
+  this->ImagePyramid->Delete();
   /**
   if(this->Histograms != NULL)
   {
@@ -207,6 +233,8 @@ void vtkMRMLVolumeRenderingDisplayableManager::Reset()
   vtkSetAndObserveMRMLNodeEventsMacro(this->MapperRaycast,
                                       newMapperRaycast.GetPointer(),
                                       mapperEventsWithProgress.GetPointer());
+  this->MapperRaycastLevels.clear();
+  this->RaycastLevel = 0;
 
   // GPU raycast 3
   vtkNew<vtkGPUVolumeRayCastMapper> newMapperGPURaycast3;
@@ -540,7 +568,15 @@ void vtkMRMLVolumeRenderingDisplayableManager
     events->InsertNextValue(vtkMRMLScalarVolumeNode::ImageDataModifiedEvent);
     vtkObserveMRMLNodeEventsMacro(volumeNode, events.GetPointer());
     }
-  this->SetupMapperFromVolumeNode(volumeNode, this->GetVolumeMapper(vspNode), 0);
+  vtkVolumeMapper* volumeMapper = this->GetVolumeMapper(vspNode);
+  this->SetupMapperFromVolumeNode(volumeNode, volumeMapper, 0);
+  this->ImagePyramid->SetInput(volumeNode ? volumeNode->GetImageData() : 0);
+  // Build the coarse levels now rather than when the view starts being
+  // interacted with, the first interaction would stall otherwise.
+  if (volumeMapper == this->MapperRaycast)
+    {
+    this->ImagePyramid->Update();
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -591,6 +627,10 @@ int vtkMRMLVolumeRenderingDisplayableManager
 
   this->Volume->SetMapper(volumeMapper);
   this->Volume->SetProperty(volumeProperty);
+  if (volumeMapper == this->MapperRaycast)
+    {
+    this->SetRaycastLevel(this->RaycastLevel);
+    }
 
   vtkNew<vtkMatrix4x4> matrix;
   this->CalculateMatrix(vspNode, matrix.GetPointer());
@@ -660,6 +700,12 @@ void vtkMRMLVolumeRenderingDisplayableManager::UpdateDesiredUpdateRate(
     this->OriginalDesiredUpdateRate = 0;
     }
   //renderWindowInteractor->SetStillUpdateRate(0.0001);
+  if (fps == 0. || !vspNode->GetVisibility())
+    {
+    // Maximum quality: the coarse levels are not rendered anymore
+    this->StopRefinement();
+    this->SetRaycastLevel(0);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -1045,8 +1091,11 @@ void vtkMRMLVolumeRenderingDisplayableManager::OnInteractorStyleEvent(int eventi
     case vtkCommand::EndInteractionEvent:
       //this->SetExpectedFPS(0.0001);
       this->SetupMapperFromParametersNode(this->DisplayedNode);
+      this->StartRefinement();
       break;
     case vtkCommand::StartInteractionEvent:
+      this->StopRefinement();
+      this->RaycastLevel = this->GetInteractiveRaycastLevel(this->DisplayedNode);
       this->SetupMapperFromParametersNode(this->DisplayedNode);
       //this->SetExpectedFPS(
       //  this->DisplayedNode ? this->DisplayedNode->GetExpectedFPS() : 15);
@@ -1057,6 +1106,145 @@ void vtkMRMLVolumeRenderingDisplayableManager::OnInteractorStyleEvent(int eventi
   this->Superclass::OnInteractorStyleEvent(eventid);
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::OnInteractorEvent(int eventid)
+{
+  if (eventid == vtkCommand::TimerEvent &&
+      this->RefinementTimerId != 0 &&
+      this->GetInteractor()->GetTimerEventId() == this->RefinementTimerId)
+    {
+    // one-shot timer, it is already destroyed
+    this->RefinementTimerId = 0;
+    this->Refine();
+    }
+  this->Superclass::OnInteractorEvent(eventid);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::SetRaycastLevel(int level)
+{
+  vtkFixedPointVolumeRayCastMapper* mapper = this->MapperRaycast;
+  if (level > 0)
+    {
+    // no-op unless the image was modified without ImageDataModifiedEvent
+    this->ImagePyramid->Update();
+    level = std::min(level, this->ImagePyramid->GetNumberOfLevels() - 1);
+    }
+  level = std::max(level, 0);
+  if (level > 0)
+    {
+    while (static_cast<int>(this->MapperRaycastLevels.size()) < level)
+      {
+      this->MapperRaycastLevels.push_back(
+        vtkSmartPointer<vtkFixedPointVolumeRayCastMapper>::New());
+      }
+    mapper = this->MapperRaycastLevels[level - 1];
+#if (VTK_MAJOR_VERSION <= 5)
+    mapper->SetInput(this->ImagePyramid->GetLevel(level));
+#else
+    mapper->SetInputData(this->ImagePyramid->GetLevel(level));
+#endif
+    // Same settings as the full resolution mapper, but the rays are
+    // sampled as coarsely as the voxels.
+    const double scale = static_cast<double>(1 << level);
+    mapper->SetBlendMode(this->MapperRaycast->GetBlendMode());
+    mapper->SetAutoAdjustSampleDistances(
+      this->MapperRaycast->GetAutoAdjustSampleDistances());
+    mapper->SetSampleDistance(this->MapperRaycast->GetSampleDistance() * scale);
+    mapper->SetInteractiveSampleDistance(
+      this->MapperRaycast->GetInteractiveSampleDistance() * scale);
+    mapper->SetImageSampleDistance(this->MapperRaycast->GetImageSampleDistance());
+    mapper->SetClippingPlanes(this->MapperRaycast->GetClippingPlanes());
+    }
+  this->RaycastLevel = level;
+
+  // Only switch mapper if the CPU ray cast mapper is rendering
+  vtkAbstractMapper* currentMapper = this->Volume->GetMapper();
+  bool raycasting = currentMapper != 0 && currentMapper == this->MapperRaycast;
+  for (size_t i = 0; !raycasting && i < this->MapperRaycastLevels.size(); ++i)
+    {
+    raycasting = currentMapper != 0 &&
+      currentMapper == this->MapperRaycastLevels[i].GetPointer();
+    }
+  if (raycasting && currentMapper != mapper)
+    {
+    this->Volume->SetMapper(mapper);
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeRenderingDisplayableManager
+::GetInteractiveRaycastLevel(vtkMRMLVolumeRenderingDisplayNode* vspNode)
+{
+  if (!vspNode || this->GetVolumeMapper(vspNode) != this->MapperRaycast)
+    {
+    return 0;
+    }
+  const double fps = this->GetFramerate(vspNode);
+  // Time of the last full resolution rendering, 0 if not rendered yet
+  const double timeToDraw = this->MapperRaycast->GetTimeToDraw();
+  if (fps <= 0. || timeToDraw <= 0.)
+    {
+    return 0;
+    }
+  // no-op unless the image was modified without ImageDataModifiedEvent
+  this->ImagePyramid->Update();
+  // Each level halves the number of samples along the rays.
+  int level = 0;
+  double expectedTime = timeToDraw;
+  while (expectedTime * fps > 1. &&
+         level + 1 < this->ImagePyramid->GetNumberOfLevels())
+    {
+    ++level;
+    expectedTime /= 2.;
+    }
+  return level;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::StartRefinement()
+{
+  this->StopRefinement();
+  vtkRenderWindowInteractor* interactor = this->GetInteractor();
+  if (this->RaycastLevel == 0 || !interactor ||
+      !this->GetRenderer() || !this->GetRenderer()->GetActiveCamera())
+    {
+    return;
+    }
+  GetCameraState(this->GetRenderer()->GetActiveCamera(),
+                 this->RefinementCameraState);
+  this->RefinementTimerId = interactor->CreateOneShotTimer(RefinementDelay);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::StopRefinement()
+{
+  if (this->RefinementTimerId != 0 && this->GetInteractor())
+    {
+    this->GetInteractor()->DestroyTimer(this->RefinementTimerId);
+    }
+  this->RefinementTimerId = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLVolumeRenderingDisplayableManager::Refine()
+{
+  double cameraState[11];
+  GetCameraState(this->GetRenderer()->GetActiveCamera(), cameraState);
+  if (std::equal(cameraState, cameraState + 11, this->RefinementCameraState))
+    {
+    this->SetRaycastLevel(this->RaycastLevel - 1);
+    }
+  else
+    {
+    // The camera moved without interaction events (e.g. animation), the
+    // finer levels would not render in time: start over.
+    this->SetRaycastLevel(this->GetInteractiveRaycastLevel(this->DisplayedNode));
+    }
+  this->RequestRender();
+  this->StartRefinement();
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLVolumeRenderingDisplayableManager::ValidateDisplayNode(vtkMRMLVolumeRenderingDisplayNode* vspNode)
 {
@@ -1308,6 +1496,12 @@ void vtkMRMLVolumeRenderingDisplayableManager
     {
     this->DisplayedNode = 0;
     this->RemoveVolumeFromView();
+    // release the coarse levels of the volume
+    this->StopRefinement();
+    this->SetRaycastLevel(0);
+    this->MapperRaycastLevels.clear();
+    this->ImagePyramid->SetInput(0);
+    this->ImagePyramid->Update();
     }
 }
 
@@ -30,6 +30,7 @@ class vtkMRMLGPURayCastVolumeRenderingDisplayNode;
 class vtkMRMLVolumeNode;
 class vtkMRMLVolumeRenderingDisplayNode;
 class vtkMRMLVolumeRenderingScenarioNode;
+class vtkSlicerVolumeImagePyramid;
 class vtkSlicerVolumeRenderingLogic;
 class vtkVolumeProperty;
 
@@ -37,6 +38,7 @@ class vtkVolumeProperty;
 #include <vtkMRMLAbstractThreeDViewDisplayableManager.h>
 
 // VTK includes
+#include <vtkSmartPointer.h>
 class vtkIntArray;
 class vtkMatrix4x4;
 class vtkPlanes;
@@ -45,6 +47,9 @@ class vtkVolume;
 class vtkVolumeMapper;
 class vtkVolumeProperty;
 
+// STD includes
+#include <vector>
+
 #define VTKIS_VOLUME_PROPS 100
 
 /// \ingroup Slicer_QtModules_VolumeRendering
@@ -153,6 +158,7 @@ protected:
                                  void * callData);
 
   virtual void OnInteractorStyleEvent(int eventId);
+  virtual void OnInteractorEvent(int eventId);
 
   //virtual void OnMRMLSceneNodeAdded(vtkMRMLNode* node);
 
@@ -172,6 +178,21 @@ protected:
   // The gpu ray cast mapper.
   vtkGPUVolumeRayCastMapper *MapperGPURaycast3;
 
+  // Description:
+  // Coarser copies of the volume rendered by the CPU ray cast mapper while
+  // the view is interacted with. Each level has its own mapper so that the
+  // mappers keep their gradients when the rendered level changes.
+  vtkSlicerVolumeImagePyramid *ImagePyramid;
+  std::vector<vtkSmartPointer<vtkFixedPointVolumeRayCastMapper> > MapperRaycastLevels;
+  // Level of ImagePyramid rendered by the CPU ray cast mapper, 0 for the
+  // full resolution volume.
+  int RaycastLevel;
+  // One-shot interactor timer that renders the next finer level, 0 if
+  // the rendering isn't being refined.
+  int RefinementTimerId;
+  // Camera when the refinement timer was started.
+  double RefinementCameraState[11];
+
   // Description:
   // Actor used for Volume Rendering
   vtkVolume *Volume;
@@ -216,6 +237,20 @@ protected:
   int ValidateDisplayNode(vtkMRMLVolumeRenderingDisplayNode* vspNode);
   double GetSampleDistance(vtkMRMLVolumeRenderingDisplayNode* vspNode);
   double GetFramerate(vtkMRMLVolumeRenderingDisplayNode* vspNode);
+
+  /// Render a level of the image pyramid with the CPU ray cast mapper.
+  /// The level is clamped to the levels of the pyramid.
+  void SetRaycastLevel(int level);
+  /// Coarsest level needed to render at the expected framerate, estimated
+  /// from the time of the last full resolution rendering. 0 if the mapper
+  /// isn't the CPU ray cast mapper or if the maximum quality is requested.
+  int GetInteractiveRaycastLevel(vtkMRMLVolumeRenderingDisplayNode* vspNode);
+  /// Render the next finer level when the view is idle, until the full
+  /// resolution volume is rendered. The refinement starts over from the
+  /// interactive level if the camera moves in the meantime.
+  void StartRefinement();
+  void StopRefinement();
+  void Refine();
   virtual int GetMaxMemory(vtkVolumeMapper* mapper, vtkMRMLVolumeRenderingDisplayNode* vspNode);
 
 };
@@ -0,0 +1,289 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VolumeRendering includes
+#include <vtkSlicerFixedPointVolumeRayCastMapper.h>
+
+// VTK includes
+#include <vtkCamera.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkFixedPointVolumeRayCastMapper.h>
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkVersion.h>
+#include <vtkVolume.h>
+#include <vtkVolumeProperty.h>
+#include <vtkWindowToImageFilter.h>
+#if (VTK_MAJOR_VERSION > 5)
+#include <vtkObjectFactory.h>
+#include <VolumeRenderingReplacementsObjectFactory.h>
+#endif
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Average time to render a full turn around the volume
+double RenderTurn(vtkRenderWindow* renderWindow, vtkRenderer* renderer)
+{
+  const int frames = 12;
+  renderer->ResetCamera();
+  // the first rendering computes the gradients and the min-max volume
+  renderWindow->Render();
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < frames; ++i)
+    {
+    renderer->GetActiveCamera()->Azimuth(360. / frames);
+    renderWindow->Render();
+    }
+  timer->StopTimer();
+  return timer->GetElapsedTime() / frames;
+}
+
+//----------------------------------------------------------------------------
+// Render the volume from a fixed point of view and copy the image
+void CaptureImage(vtkRenderWindow* renderWindow, vtkRenderer* renderer,
+                  vtkUnsignedCharArray* pixels)
+{
+  vtkCamera* camera = renderer->GetActiveCamera();
+  camera->SetFocalPoint(0., 0., 0.);
+  camera->SetPosition(1., 0.5, 2.);
+  camera->SetViewUp(0., 1., 0.);
+  renderer->ResetCamera();
+  vtkNew<vtkWindowToImageFilter> windowToImage;
+  windowToImage->SetInput(renderWindow);
+  windowToImage->Update();
+  pixels->DeepCopy(windowToImage->GetOutput()->GetPointData()->GetScalars());
+}
+
+//----------------------------------------------------------------------------
+bool SameImage(vtkUnsignedCharArray* pixels1, vtkUnsignedCharArray* pixels2)
+{
+  if (pixels1->GetNumberOfTuples() != pixels2->GetNumberOfTuples() ||
+      pixels1->GetNumberOfComponents() != pixels2->GetNumberOfComponents())
+    {
+    return false;
+    }
+  const vtkIdType size =
+    pixels1->GetNumberOfTuples() * pixels1->GetNumberOfComponents();
+  for (vtkIdType i = 0; i < size; ++i)
+    {
+    if (pixels1->GetValue(i) != pixels2->GetValue(i))
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+}
+
+//----------------------------------------------------------------------------
+// Frame times of the Slicer fixed point ray cast mapper and its helpers
+// compared with the VTK mapper, for each blending and shading mode.
+// The rays are cast one by one and in packets with each instruction set the
+// processor supports; the packets must give the same image, faster.
+int vtkSlicerFixedPointVolumeRayCastMapperTest1(int , char * [] )
+{
+#if (VTK_MAJOR_VERSION > 5)
+  // the ray cast image display helper is created by the replacements factory
+  vtkNew<VolumeRenderingReplacementsObjectFactory> factory;
+  vtkObjectFactory::RegisterFactory(factory.GetPointer());
+#endif
+
+  // 128^3 volume of concentric shells
+  const int size = 128;
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  imageData->SetScalarTypeToUnsignedShort();
+  imageData->SetNumberOfScalarComponents(1);
+  imageData->AllocateScalars();
+#else
+  imageData->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+#endif
+  unsigned short* ptr = static_cast<unsigned short*>(imageData->GetScalarPointer());
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        const double r = std::sqrt(static_cast<double>(
+          (i - size / 2) * (i - size / 2) +
+          (j - size / 2) * (j - size / 2) +
+          (k - size / 2) * (k - size / 2)));
+        *ptr++ = r < size / 2 ?
+          static_cast<unsigned short>(1000. + 1000. * std::cos(r / 4.)) : 0;
+        }
+      }
+    }
+
+  vtkNew<vtkColorTransferFunction> color;
+  color->AddRGBPoint(0., 0., 0., 0.);
+  color->AddRGBPoint(1000., 1., 0.5, 0.2);
+  color->AddRGBPoint(2000., 1., 1., 1.);
+  vtkNew<vtkPiecewiseFunction> scalarOpacity;
+  scalarOpacity->AddPoint(0., 0.);
+  scalarOpacity->AddPoint(1200., 0.02);
+  scalarOpacity->AddPoint(2000., 0.3);
+  vtkNew<vtkPiecewiseFunction> gradientOpacity;
+  gradientOpacity->AddPoint(0., 0.);
+  gradientOpacity->AddPoint(200., 1.);
+
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  renderWindow->SetSize(400, 400);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+
+  vtkNew<vtkSlicerFixedPointVolumeRayCastMapper> slicerMapper;
+  vtkNew<vtkFixedPointVolumeRayCastMapper> vtkMapper;
+  slicerMapper->SetAutoAdjustSampleDistances(0);
+  vtkMapper->SetAutoAdjustSampleDistances(0);
+#if (VTK_MAJOR_VERSION <= 5)
+  slicerMapper->SetInput(imageData.GetPointer());
+  vtkMapper->SetInput(imageData.GetPointer());
+#else
+  slicerMapper->SetInputData(imageData.GetPointer());
+  vtkMapper->SetInputData(imageData.GetPointer());
+#endif
+
+  // The first configuration casts the rays one by one, it is the reference
+  // of the ray packets.
+  struct Configuration
+  {
+    const char* Name;
+    vtkVolumeMapper* Mapper;
+    int RayPacketInstructionSet;
+  };
+  const Configuration configurations[5] = {
+    {"Slicer", slicerMapper.GetPointer(),
+     vtkSlicerFixedPointVolumeRayCastMapper::NO_RAY_PACKETS},
+    {"SlicerScalarPackets", slicerMapper.GetPointer(),
+     vtkSlicerFixedPointVolumeRayCastMapper::SCALAR_RAY_PACKETS},
+    {"SlicerSSE41Packets", slicerMapper.GetPointer(),
+     vtkSlicerFixedPointVolumeRayCastMapper::SSE41_RAY_PACKETS},
+    {"SlicerAVX2Packets", slicerMapper.GetPointer(),
+     vtkSlicerFixedPointVolumeRayCastMapper::AVX2_RAY_PACKETS},
+    {"VTK", vtkMapper.GetPointer(), -1}};
+
+  struct Mode
+  {
+    const char* Name;
+    int BlendMode;
+    bool Shade;
+    bool GradientOpacity;
+  };
+  const Mode modes[5] = {
+    {"Composite", vtkVolumeMapper::COMPOSITE_BLEND, false, false},
+    {"CompositeShade", vtkVolumeMapper::COMPOSITE_BLEND, true, false},
+    {"CompositeGO", vtkVolumeMapper::COMPOSITE_BLEND, false, true},
+    {"CompositeGOShade", vtkVolumeMapper::COMPOSITE_BLEND, true, true},
+    {"MIP", vtkVolumeMapper::MAXIMUM_INTENSITY_BLEND, false, false}};
+
+  bool success = true;
+  for (int i = 0; i < 5; ++i)
+    {
+    vtkNew<vtkVolumeProperty> property;
+    property->SetInterpolationTypeToLinear();
+    property->SetColor(color.GetPointer());
+    property->SetScalarOpacity(scalarOpacity.GetPointer());
+    if (modes[i].GradientOpacity)
+      {
+      property->SetGradientOpacity(gradientOpacity.GetPointer());
+      }
+    property->SetShade(modes[i].Shade ? 1 : 0);
+
+    double referenceFrameTime = 0.;
+    vtkNew<vtkUnsignedCharArray> referenceImage;
+    for (int m = 0; m < 5; ++m)
+      {
+      const Configuration& configuration = configurations[m];
+      const int instructionSet = configuration.RayPacketInstructionSet;
+      if (instructionSet >= 0)
+        {
+        slicerMapper->SetRayPacketInstructionSet(instructionSet);
+        if (slicerMapper->GetRayPacketInstructionSetInUse() != instructionSet)
+          {
+          std::cout << configuration.Name
+                    << " skipped: not supported by the processor" << std::endl;
+          continue;
+          }
+        }
+      configuration.Mapper->SetBlendMode(modes[i].BlendMode);
+
+      vtkNew<vtkVolume> volume;
+      volume->SetMapper(configuration.Mapper);
+      volume->SetProperty(property.GetPointer());
+      renderer->AddVolume(volume.GetPointer());
+
+      const double frameTime = RenderTurn(renderWindow.GetPointer(), renderer.GetPointer());
+      std::cout << "<DartMeasurement name=\"" << modes[i].Name << configuration.Name
+                << "\" type=\"numeric/double\">" << frameTime
+                << "</DartMeasurement>" << std::endl;
+
+      if (configuration.Mapper->GetTimeToDraw() <= 0.)
+        {
+        std::cerr << "Line " << __LINE__ << ": " << configuration.Name
+                  << " mapper did not render in " << modes[i].Name
+                  << " mode" << std::endl;
+        success = false;
+        }
+
+      if (instructionSet == vtkSlicerFixedPointVolumeRayCastMapper::NO_RAY_PACKETS)
+        {
+        referenceFrameTime = frameTime;
+        CaptureImage(renderWindow.GetPointer(), renderer.GetPointer(),
+                     referenceImage.GetPointer());
+        }
+      else if (instructionSet > 0)
+        {
+        std::cout << "<DartMeasurement name=\"" << modes[i].Name << configuration.Name
+                  << "Speedup\" type=\"numeric/double\">"
+                  << (frameTime > 0. ? referenceFrameTime / frameTime : 0.)
+                  << "</DartMeasurement>" << std::endl;
+        vtkNew<vtkUnsignedCharArray> image;
+        CaptureImage(renderWindow.GetPointer(), renderer.GetPointer(),
+                     image.GetPointer());
+        if (!SameImage(image.GetPointer(), referenceImage.GetPointer()))
+          {
+          std::cerr << "Line " << __LINE__ << ": " << configuration.Name
+                    << " image differs from the image of the rays cast one by one in "
+                    << modes[i].Name << " mode" << std::endl;
+          success = false;
+          }
+        }
+      renderer->RemoveVolume(volume.GetPointer());
+      }
+    }
+
+#if (VTK_MAJOR_VERSION > 5)
+  vtkObjectFactory::UnRegisterFactory(factory.GetPointer());
+#endif
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
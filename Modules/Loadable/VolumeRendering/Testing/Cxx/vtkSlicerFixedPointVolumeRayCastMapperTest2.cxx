@@ -0,0 +1,211 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VolumeRendering includes
+#include <vtkSlicerFixedPointVolumeRayCastMapper.h>
+
+// VTK includes
+#include <vtkCamera.h>
+#include <vtkColorTransferFunction.h>
+#include <vtkFixedPointVolumeRayCastMapper.h>
+#include <vtkImageData.h>
+#include <vtkImageDifference.h>
+#include <vtkNew.h>
+#include <vtkPiecewiseFunction.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkVersion.h>
+#include <vtkVolume.h>
+#include <vtkVolumeProperty.h>
+#include <vtkWindowToImageFilter.h>
+#if (VTK_MAJOR_VERSION > 5)
+#include <vtkObjectFactory.h>
+#include <VolumeRenderingReplacementsObjectFactory.h>
+#endif
+
+// STD includes
+#include <cmath>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void RenderScreenShot(vtkRenderWindow* renderWindow, vtkRenderer* renderer,
+                      vtkVolumeMapper* mapper, vtkVolumeProperty* property,
+                      vtkImageData* screenShot)
+{
+  vtkNew<vtkVolume> volume;
+  volume->SetMapper(mapper);
+  volume->SetProperty(property);
+  renderer->AddVolume(volume.GetPointer());
+  renderWindow->Render();
+
+  vtkNew<vtkWindowToImageFilter> windowToImageFilter;
+  windowToImageFilter->SetInput(renderWindow);
+  windowToImageFilter->Update();
+  screenShot->DeepCopy(windowToImageFilter->GetOutput());
+  renderer->RemoveVolume(volume.GetPointer());
+}
+
+}
+
+//----------------------------------------------------------------------------
+// The Slicer fixed point ray cast mapper renders the same images as the VTK
+// mapper for each blending and shading mode.
+int vtkSlicerFixedPointVolumeRayCastMapperTest2(int , char * [] )
+{
+#if (VTK_MAJOR_VERSION > 5)
+  // the ray cast image display helper is created by the replacements factory
+  vtkNew<VolumeRenderingReplacementsObjectFactory> factory;
+  vtkObjectFactory::RegisterFactory(factory.GetPointer());
+#endif
+
+  // 64^3 volume of concentric shells
+  const int size = 64;
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(size, size, size);
+#if (VTK_MAJOR_VERSION <= 5)
+  imageData->SetScalarTypeToUnsignedShort();
+  imageData->SetNumberOfScalarComponents(1);
+  imageData->AllocateScalars();
+#else
+  imageData->AllocateScalars(VTK_UNSIGNED_SHORT, 1);
+#endif
+  unsigned short* ptr = static_cast<unsigned short*>(imageData->GetScalarPointer());
+  for (int k = 0; k < size; ++k)
+    {
+    for (int j = 0; j < size; ++j)
+      {
+      for (int i = 0; i < size; ++i)
+        {
+        const double r = std::sqrt(static_cast<double>(
+          (i - size / 2) * (i - size / 2) +
+          (j - size / 2) * (j - size / 2) +
+          (k - size / 2) * (k - size / 2)));
+        *ptr++ = r < size / 2 ?
+          static_cast<unsigned short>(1000. + 1000. * std::cos(r / 3.)) : 0;
+        }
+      }
+    }
+
+  vtkNew<vtkColorTransferFunction> color;
+  color->AddRGBPoint(0., 0., 0., 0.);
+  color->AddRGBPoint(1000., 1., 0.5, 0.2);
+  color->AddRGBPoint(2000., 1., 1., 1.);
+  vtkNew<vtkPiecewiseFunction> scalarOpacity;
+  scalarOpacity->AddPoint(0., 0.);
+  scalarOpacity->AddPoint(1200., 0.05);
+  scalarOpacity->AddPoint(2000., 0.5);
+  vtkNew<vtkPiecewiseFunction> gradientOpacity;
+  gradientOpacity->AddPoint(0., 0.);
+  gradientOpacity->AddPoint(200., 1.);
+
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  renderWindow->SetSize(200, 200);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+
+  vtkNew<vtkSlicerFixedPointVolumeRayCastMapper> slicerMapper;
+  vtkNew<vtkFixedPointVolumeRayCastMapper> vtkMapper;
+#if (VTK_MAJOR_VERSION <= 5)
+  slicerMapper->SetInput(imageData.GetPointer());
+  vtkMapper->SetInput(imageData.GetPointer());
+#else
+  slicerMapper->SetInputData(imageData.GetPointer());
+  vtkMapper->SetInputData(imageData.GetPointer());
+#endif
+  slicerMapper->SetAutoAdjustSampleDistances(0);
+  vtkMapper->SetAutoAdjustSampleDistances(0);
+
+  struct Mode
+  {
+    const char* Name;
+    int BlendMode;
+    bool Shade;
+    bool GradientOpacity;
+  };
+  const Mode modes[5] = {
+    {"Composite", vtkVolumeMapper::COMPOSITE_BLEND, false, false},
+    {"CompositeShade", vtkVolumeMapper::COMPOSITE_BLEND, true, false},
+    {"CompositeGO", vtkVolumeMapper::COMPOSITE_BLEND, false, true},
+    {"CompositeGOShade", vtkVolumeMapper::COMPOSITE_BLEND, true, true},
+    {"MIP", vtkVolumeMapper::MAXIMUM_INTENSITY_BLEND, false, false}};
+
+  // Same view for all the renderings
+  {
+  vtkNew<vtkVolume> volume;
+  volume->SetMapper(vtkMapper.GetPointer());
+  renderer->AddVolume(volume.GetPointer());
+  renderer->ResetCamera();
+  renderer->GetActiveCamera()->Azimuth(30.);
+  renderer->GetActiveCamera()->Elevation(20.);
+  renderer->RemoveVolume(volume.GetPointer());
+  }
+
+  bool success = true;
+  for (int i = 0; i < 5; ++i)
+    {
+    vtkNew<vtkVolumeProperty> property;
+    property->SetInterpolationTypeToLinear();
+    property->SetColor(color.GetPointer());
+    property->SetScalarOpacity(scalarOpacity.GetPointer());
+    if (modes[i].GradientOpacity)
+      {
+      property->SetGradientOpacity(gradientOpacity.GetPointer());
+      }
+    property->SetShade(modes[i].Shade ? 1 : 0);
+    slicerMapper->SetBlendMode(modes[i].BlendMode);
+    vtkMapper->SetBlendMode(modes[i].BlendMode);
+
+    vtkNew<vtkImageData> slicerScreenShot;
+    RenderScreenShot(renderWindow.GetPointer(), renderer.GetPointer(),
+                     slicerMapper.GetPointer(), property.GetPointer(),
+                     slicerScreenShot.GetPointer());
+    vtkNew<vtkImageData> vtkScreenShot;
+    RenderScreenShot(renderWindow.GetPointer(), renderer.GetPointer(),
+                     vtkMapper.GetPointer(), property.GetPointer(),
+                     vtkScreenShot.GetPointer());
+
+    vtkNew<vtkImageDifference> diff;
+#if (VTK_MAJOR_VERSION <= 5)
+    diff->SetInput(vtkScreenShot.GetPointer());
+    diff->SetImage(slicerScreenShot.GetPointer());
+#else
+    diff->SetInputData(vtkScreenShot.GetPointer());
+    diff->SetImageData(slicerScreenShot.GetPointer());
+#endif
+    diff->AllowShiftOff();
+    diff->Update();
+    const double error = diff->GetThresholdedError();
+    std::cout << "<DartMeasurement name=\"" << modes[i].Name
+              << "ThresholdedError\" type=\"numeric/double\">" << error
+              << "</DartMeasurement>" << std::endl;
+    if (error > 0)
+      {
+      std::cerr << "Line " << __LINE__ << ": " << modes[i].Name
+                << " rendering differs from the VTK mapper. Got a thresholded"
+                << " error of " << error << std::endl;
+      success = false;
+      }
+    }
+
+#if (VTK_MAJOR_VERSION > 5)
+  vtkObjectFactory::UnRegisterFactory(factory.GetPointer());
+#endif
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
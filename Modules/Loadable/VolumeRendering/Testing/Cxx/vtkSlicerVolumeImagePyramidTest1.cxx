@@ -0,0 +1,148 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VolumeRendering includes
+#include <vtkSlicerVolumeImagePyramid.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+#include <vtkVersion.h>
+
+//----------------------------------------------------------------------------
+int vtkSlicerVolumeImagePyramidTest1(int , char * [] )
+{
+  // 256x256x15 volume, the value of a voxel is its i index
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(256, 256, 15);
+  image->SetSpacing(0.5, 0.5, 2.);
+  image->SetOrigin(10., 20., 30.);
+#if (VTK_MAJOR_VERSION <= 5)
+  image->SetScalarTypeToShort();
+  image->SetNumberOfScalarComponents(1);
+  image->AllocateScalars();
+#else
+  image->AllocateScalars(VTK_SHORT, 1);
+#endif
+  short* ptr = static_cast<short*>(image->GetScalarPointer());
+  for (int k = 0; k < 15; ++k)
+    {
+    for (int j = 0; j < 256; ++j)
+      {
+      for (int i = 0; i < 256; ++i)
+        {
+        *ptr++ = static_cast<short>(i);
+        }
+      }
+    }
+
+  vtkNew<vtkSlicerVolumeImagePyramid> pyramid;
+  pyramid->SetInput(image.GetPointer());
+  pyramid->SetMaximumNumberOfLevels(8);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  pyramid->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"Build\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  // 256, 128, 64 and 32 voxels along the largest axis
+  if (pyramid->GetNumberOfLevels() != 4 ||
+      pyramid->GetLevel(0) != image.GetPointer())
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong number of levels: "
+              << pyramid->GetNumberOfLevels() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  vtkImageData* level1 = pyramid->GetLevel(1);
+  int dimensions[3];
+  level1->GetDimensions(dimensions);
+  if (dimensions[0] != 128 || dimensions[1] != 128 || dimensions[2] != 8)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong dimensions: "
+              << dimensions[0] << " " << dimensions[1] << " " << dimensions[2]
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  double spacing[3];
+  level1->GetSpacing(spacing);
+  double origin[3];
+  level1->GetOrigin(origin);
+  if (spacing[0] != 1. || spacing[2] != 4. ||
+      origin[0] != 10.25 || origin[1] != 20.25 || origin[2] != 31.)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong geometry: spacing "
+              << spacing[0] << " " << spacing[2] << ", origin "
+              << origin[0] << " " << origin[1] << " " << origin[2] << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // voxels 2i and 2i+1 are averaged (and rounded)
+  if (level1->GetScalarComponentAsDouble(10, 5, 7, 0) != 21. ||
+      pyramid->GetLevel(3)->GetScalarComponentAsDouble(1, 0, 0, 0) != 12.)
+    {
+    std::cerr << "Line " << __LINE__ << ": wrong values: "
+              << level1->GetScalarComponentAsDouble(10, 5, 7, 0) << " "
+              << pyramid->GetLevel(3)->GetScalarComponentAsDouble(1, 0, 0, 0)
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // the levels are not rebuilt if the input is not modified
+  unsigned long level1Time = level1->GetMTime();
+  pyramid->Update();
+  if (level1->GetMTime() != level1Time)
+    {
+    std::cerr << "Line " << __LINE__ << ": levels were rebuilt" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // but they are when it is, in the same images. The last slice is
+  // averaged with itself.
+  image->SetScalarComponentFromDouble(20, 10, 14, 0, 1000.);
+  image->Modified();
+  pyramid->Update();
+  if (pyramid->GetLevel(1) != level1 ||
+      level1->GetMTime() == level1Time ||
+      level1->GetScalarComponentAsDouble(10, 5, 7, 0) != 266.)
+    {
+    std::cerr << "Line " << __LINE__ << ": levels were not rebuilt" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // small volumes have no coarse level
+  pyramid->SetMinimumDimension(512);
+  pyramid->Update();
+  if (pyramid->GetNumberOfLevels() != 1)
+    {
+    std::cerr << "Line " << __LINE__ << ": small volume has coarse levels" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  pyramid->SetInput(0);
+  pyramid->Update();
+  if (pyramid->GetNumberOfLevels() != 0)
+    {
+    std::cerr << "Line " << __LINE__ << ": levels without input" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
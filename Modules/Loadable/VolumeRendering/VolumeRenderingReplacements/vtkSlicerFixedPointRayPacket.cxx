@@ -0,0 +1,330 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Scalar version of the ray packet kernels and detection of the instruction
+// sets supported by the processor.
+
+#include "vtkSlicerFixedPointRayPacket.h"
+
+#if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+# define VTKKW_RAY_PACKET_X86
+# if defined(_MSC_VER)
+#  include <intrin.h>
+# else
+#  include <cpuid.h>
+# endif
+#endif
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void ComputeWeights(vtkSlicerFixedPointRayPacket* packet, int l)
+{
+  const unsigned int w2X = packet->Position[0][l] & VTKKW_FP_MASK;
+  const unsigned int w2Y = packet->Position[1][l] & VTKKW_FP_MASK;
+  const unsigned int w2Z = packet->Position[2][l] & VTKKW_FP_MASK;
+
+  const unsigned int w1X = (~w2X) & VTKKW_FP_MASK;
+  const unsigned int w1Y = (~w2Y) & VTKKW_FP_MASK;
+  const unsigned int w1Z = (~w2Z) & VTKKW_FP_MASK;
+
+  const unsigned int w1Xw1Y = (0x4000 + (w1X*w1Y)) >> VTKKW_FP_SHIFT;
+  const unsigned int w2Xw1Y = (0x4000 + (w2X*w1Y)) >> VTKKW_FP_SHIFT;
+  const unsigned int w1Xw2Y = (0x4000 + (w1X*w2Y)) >> VTKKW_FP_SHIFT;
+  const unsigned int w2Xw2Y = (0x4000 + (w2X*w2Y)) >> VTKKW_FP_SHIFT;
+
+  packet->Weight[0][l] = (0x4000 + (w1Xw1Y*w1Z)) >> VTKKW_FP_SHIFT;
+  packet->Weight[1][l] = (0x4000 + (w2Xw1Y*w1Z)) >> VTKKW_FP_SHIFT;
+  packet->Weight[2][l] = (0x4000 + (w1Xw2Y*w1Z)) >> VTKKW_FP_SHIFT;
+  packet->Weight[3][l] = (0x4000 + (w2Xw2Y*w1Z)) >> VTKKW_FP_SHIFT;
+  packet->Weight[4][l] = (0x4000 + (w1Xw1Y*w2Z)) >> VTKKW_FP_SHIFT;
+  packet->Weight[5][l] = (0x4000 + (w2Xw1Y*w2Z)) >> VTKKW_FP_SHIFT;
+  packet->Weight[6][l] = (0x4000 + (w1Xw2Y*w2Z)) >> VTKKW_FP_SHIFT;
+  packet->Weight[7][l] = (0x4000 + (w2Xw2Y*w2Z)) >> VTKKW_FP_SHIFT;
+}
+
+//----------------------------------------------------------------------------
+unsigned int Interpolate(const unsigned int corners[8][VTKKW_RAY_PACKET_SIZE],
+                         const vtkSlicerFixedPointRayPacket* packet, int l)
+{
+  unsigned int sum = 0x7fff;
+  for (int c = 0; c < 8; ++c)
+    {
+    sum += corners[c][l] * packet->Weight[c][l];
+    }
+  return sum >> VTKKW_FP_SHIFT;
+}
+
+//----------------------------------------------------------------------------
+// Interpolate a shading table at the normals of the corners
+unsigned int InterpolateShading(const unsigned short* table, int component,
+                                const vtkSlicerFixedPointRayPacket* packet, int l)
+{
+  unsigned int sum = 0x7fff;
+  for (int c = 0; c < 8; ++c)
+    {
+    sum += table[3*packet->Normal[c][l] + component] * packet->Weight[c][l];
+    }
+  return sum >> VTKKW_FP_SHIFT;
+}
+
+//----------------------------------------------------------------------------
+unsigned int ScalarAdvance(vtkSlicerFixedPointRayPacket* packet,
+                           unsigned int lanes)
+{
+  unsigned int moving = 0;
+  packet->MinMaxChanged = 0;
+  packet->CellChanged = 0;
+  for (int l = 0; l < VTKKW_RAY_PACKET_SIZE; ++l)
+    {
+    if (!(lanes & (1u << l)) || packet->Step[l] == packet->NumberOfSteps[l])
+      {
+      continue;
+      }
+    moving |= (1u << l);
+    for (int a = 0; a < 3; ++a)
+      {
+      if (packet->Step[l])
+        {
+        packet->Position[a][l] += packet->Increment[a][l];
+        }
+      const unsigned int minMaxPosition = packet->Position[a][l] >> VTKKW_FPMM_SHIFT;
+      if (minMaxPosition != packet->MinMaxPosition[a][l])
+        {
+        packet->MinMaxPosition[a][l] = minMaxPosition;
+        packet->MinMaxChanged |= (1u << l);
+        }
+      if ((packet->Position[a][l] >> VTKKW_FP_SHIFT) != packet->CellPosition[a][l])
+        {
+        packet->CellChanged |= (1u << l);
+        }
+      }
+    ++packet->Step[l];
+    }
+  return moving;
+}
+
+//----------------------------------------------------------------------------
+void ScalarInterpolateScalar(vtkSlicerFixedPointRayPacket* packet,
+                             unsigned int lanes)
+{
+  for (int l = 0; l < VTKKW_RAY_PACKET_SIZE; ++l)
+    {
+    if (lanes & (1u << l))
+      {
+      ComputeWeights(packet, l);
+      packet->Value[l] = Interpolate(packet->Scalar, packet, l) & 0xffff;
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+unsigned int ScalarLookupScalarOpacity(vtkSlicerFixedPointRayPacket* packet,
+                                       unsigned int lanes,
+                                       const unsigned short* scalarOpacityTable)
+{
+  unsigned int opaque = 0;
+  for (int l = 0; l < VTKKW_RAY_PACKET_SIZE; ++l)
+    {
+    if (lanes & (1u << l))
+      {
+      packet->Opacity[l] = scalarOpacityTable[packet->Value[l]];
+      if (packet->Opacity[l])
+        {
+        opaque |= (1u << l);
+        }
+      }
+    }
+  return opaque;
+}
+
+//----------------------------------------------------------------------------
+unsigned int ScalarApplyGradientOpacity(vtkSlicerFixedPointRayPacket* packet,
+                                        unsigned int lanes,
+                                        const unsigned short* gradientOpacityTable)
+{
+  unsigned int opaque = 0;
+  for (int l = 0; l < VTKKW_RAY_PACKET_SIZE; ++l)
+    {
+    if (lanes & (1u << l))
+      {
+      const unsigned int magnitude = Interpolate(packet->Magnitude, packet, l) & 0xffff;
+      packet->Opacity[l] = ((packet->Opacity[l] * gradientOpacityTable[magnitude]
+                             + 0x7fff) >> VTKKW_FP_SHIFT) & 0xffff;
+      if (packet->Opacity[l])
+        {
+        opaque |= (1u << l);
+        }
+      }
+    }
+  return opaque;
+}
+
+//----------------------------------------------------------------------------
+unsigned int ScalarComposite(vtkSlicerFixedPointRayPacket* packet,
+                             unsigned int lanes,
+                             const unsigned short* colorTable,
+                             const unsigned short* diffuseShadingTable,
+                             const unsigned short* specularShadingTable)
+{
+  unsigned int terminated = 0;
+  for (int l = 0; l < VTKKW_RAY_PACKET_SIZE; ++l)
+    {
+    if (!(lanes & (1u << l)))
+      {
+      continue;
+      }
+    const unsigned int opacity = packet->Opacity[l];
+    unsigned int color[3];
+    for (int c = 0; c < 3; ++c)
+      {
+      color[c] = ((colorTable[3*packet->Value[l] + c] * opacity + 0x7fff)
+                  >> VTKKW_FP_SHIFT) & 0xffff;
+      }
+    if (diffuseShadingTable)
+      {
+      for (int c = 0; c < 3; ++c)
+        {
+        const unsigned int diffuse = InterpolateShading(diffuseShadingTable, c, packet, l);
+        const unsigned int specular = InterpolateShading(specularShadingTable, c, packet, l);
+        color[c] = ((diffuse * color[c] + 0x7fff) >> VTKKW_FP_SHIFT) & 0xffff;
+        color[c] = (color[c] + ((specular * opacity + 0x7fff) >> VTKKW_FP_SHIFT)) & 0xffff;
+        }
+      }
+    const unsigned int remainingOpacity = packet->RemainingOpacity[l];
+    for (int c = 0; c < 3; ++c)
+      {
+      packet->Color[c][l] += (color[c] * remainingOpacity + 0x7fff) >> VTKKW_FP_SHIFT;
+      }
+    packet->RemainingOpacity[l] =
+      ((remainingOpacity * ((~opacity) & VTKKW_FP_MASK) + 0x7fff) >> VTKKW_FP_SHIFT) & 0xffff;
+    if (packet->RemainingOpacity[l] < 0xff)
+      {
+      terminated |= (1u << l);
+      }
+    }
+  return terminated;
+}
+
+//----------------------------------------------------------------------------
+void ScalarUpdateMaximum(vtkSlicerFixedPointRayPacket* packet,
+                         unsigned int lanes)
+{
+  for (int l = 0; l < VTKKW_RAY_PACKET_SIZE; ++l)
+    {
+    if ((lanes & (1u << l)) && packet->Value[l] > packet->MaxValue[l])
+      {
+      packet->MaxValue[l] = packet->Value[l];
+      }
+    }
+}
+
+#ifdef VTKKW_RAY_PACKET_X86
+//----------------------------------------------------------------------------
+void CPUID(unsigned int leaf, unsigned int registers[4])
+{
+#if defined(_MSC_VER)
+  int r[4];
+  __cpuidex(r, static_cast<int>(leaf), 0);
+  for (int i = 0; i < 4; ++i)
+    {
+    registers[i] = static_cast<unsigned int>(r[i]);
+    }
+#else
+  __cpuid_count(leaf, 0, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+//----------------------------------------------------------------------------
+// Low word of the extended control register 0: the registers whose state
+// the operating system saves on context switches.
+unsigned int XCR0()
+{
+#if defined(_MSC_VER)
+  return static_cast<unsigned int>(_xgetbv(0));
+#else
+  unsigned int eax, edx;
+  __asm__ __volatile__ ("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return eax;
+#endif
+}
+#endif
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketScalarKernels()
+{
+  static const vtkSlicerFixedPointRayPacketKernels kernels =
+    {
+    "Scalar",
+    ScalarAdvance,
+    ScalarInterpolateScalar,
+    ScalarLookupScalarOpacity,
+    ScalarApplyGradientOpacity,
+    ScalarComposite,
+    ScalarUpdateMaximum
+    };
+  return &kernels;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerFixedPointRayPacketHasSSE41()
+{
+#ifdef VTKKW_RAY_PACKET_X86
+  unsigned int registers[4];
+  CPUID(0, registers);
+  if (registers[0] < 1)
+    {
+    return false;
+    }
+  CPUID(1, registers);
+  return (registers[2] & (1u << 19)) != 0;
+#else
+  return false;
+#endif
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerFixedPointRayPacketHasAVX2()
+{
+#ifdef VTKKW_RAY_PACKET_X86
+  unsigned int registers[4];
+  CPUID(0, registers);
+  if (registers[0] < 7)
+    {
+    return false;
+    }
+  CPUID(1, registers);
+  const unsigned int osxsave = 1u << 27;
+  const unsigned int avx = 1u << 28;
+  if ((registers[2] & (osxsave | avx)) != (osxsave | avx))
+    {
+    return false;
+    }
+  // The operating system must save the SSE and AVX registers
+  if ((XCR0() & 0x6) != 0x6)
+    {
+    return false;
+    }
+  CPUID(7, registers);
+  return (registers[1] & (1u << 5)) != 0;
+#else
+  return false;
+#endif
+}
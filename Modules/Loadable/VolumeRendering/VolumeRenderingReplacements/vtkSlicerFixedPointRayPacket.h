@@ -0,0 +1,148 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+///  vtkSlicerFixedPointRayPacket - sample and composite kernels working on
+/// packets of rays
+///
+/// The one component trilinear helpers of vtkSlicerFixedPointVolumeRayCastMapper
+/// cast the rays of a scan line in packets of VTKKW_RAY_PACKET_SIZE adjacent
+/// rays. The kernels below move all the rays of the packet to their next
+/// sample and tell which rays entered another block of the min max volume or
+/// another cell; the helpers only look at these rays one by one (space
+/// leaping, cropping, loading the cell corners), and the kernels then
+/// interpolate, classify and composite the samples of the packet at once.
+/// The rays a kernel works on are given by a bit mask, bit l being lane l.
+///
+/// The kernels reproduce the fixed point arithmetic of the
+/// vtkSlicerFixedPointVolumeRayCastHelper macros bit for bit, so the image
+/// does not depend on the instruction set. They exist in a scalar, an SSE4.1
+/// and an AVX2 version; the SIMD versions are NULL when the compiler could not
+/// build them and must only be used when the processor supports them.
+///
+/// This header and the kernel sources must not include VTK or STL headers:
+/// the SIMD sources are compiled with instruction set flags, and any inline
+/// function they instantiated could be picked by the linker for the rest of
+/// the library and run on processors without these instructions.
+
+#ifndef __vtkSlicerFixedPointRayPacket_h
+#define __vtkSlicerFixedPointRayPacket_h
+
+// Same fixed point precision as vtkSlicerFixedPointVolumeRayCastMapper
+#ifndef VTKKW_FP_SHIFT
+#define VTKKW_FP_SHIFT       15
+#define VTKKW_FP_MASK        0x7fff
+#endif
+#ifndef VTKKW_FPMM_SHIFT
+#define VTKKW_FPMM_SHIFT     17
+#endif
+
+#define VTKKW_RAY_PACKET_SIZE 8
+
+/// Samples of the rays of a packet, stored lane by lane.
+/// Corners are ordered A to H as in vtkSlicerFixedPointVolumeRayCastHelper.
+struct vtkSlicerFixedPointRayPacket
+{
+  /// Fixed point position of the sample
+  unsigned int Position[3][VTKKW_RAY_PACKET_SIZE];
+  /// Added to Position between two samples, modulo 2^32
+  unsigned int Increment[3][VTKKW_RAY_PACKET_SIZE];
+  /// Number of samples taken along the ray, and to take
+  unsigned int Step[VTKKW_RAY_PACKET_SIZE];
+  unsigned int NumberOfSteps[VTKKW_RAY_PACKET_SIZE];
+  /// Block of the min max volume of the sample
+  unsigned int MinMaxPosition[3][VTKKW_RAY_PACKET_SIZE];
+  /// Cell whose corners are in Scalar, Magnitude and Normal
+  unsigned int CellPosition[3][VTKKW_RAY_PACKET_SIZE];
+  /// Lanes whose sample entered another block of the min max volume, and
+  /// lanes whose sample is not in CellPosition, set by Advance
+  unsigned int MinMaxChanged;
+  unsigned int CellChanged;
+  /// Scalar index at the corners of the cell of the sample
+  unsigned int Scalar[8][VTKKW_RAY_PACKET_SIZE];
+  /// Gradient magnitude at the corners, used by ApplyGradientOpacity
+  unsigned int Magnitude[8][VTKKW_RAY_PACKET_SIZE];
+  /// Encoded gradient direction at the corners, used by Composite to shade
+  unsigned int Normal[8][VTKKW_RAY_PACKET_SIZE];
+  /// Trilinear weights of the corners, computed by InterpolateScalar
+  unsigned int Weight[8][VTKKW_RAY_PACKET_SIZE];
+  /// Interpolated scalar index of the sample
+  unsigned int Value[VTKKW_RAY_PACKET_SIZE];
+  /// Opacity of the sample
+  unsigned int Opacity[VTKKW_RAY_PACKET_SIZE];
+  /// Color accumulated along the ray
+  unsigned int Color[3][VTKKW_RAY_PACKET_SIZE];
+  /// Opacity left along the ray, starts at 0x7fff
+  unsigned int RemainingOpacity[VTKKW_RAY_PACKET_SIZE];
+  /// Maximum interpolated scalar index along the ray, starts at 0
+  unsigned int MaxValue[VTKKW_RAY_PACKET_SIZE];
+};
+
+/// Kernels of one instruction set.
+/// The unsigned short tables are read with 32 bit loads by the AVX2 gathers:
+/// one more unsigned short must be readable after the last entry, which is
+/// the case for the tables of the first component of the mapper.
+struct vtkSlicerFixedPointRayPacketKernels
+{
+  const char* Name;
+
+  /// Move the given lanes to their next sample, Position is not incremented
+  /// for the first one. Update MinMaxPosition, MinMaxChanged and CellChanged.
+  /// Return the lanes that had a sample left.
+  unsigned int (*Advance)(vtkSlicerFixedPointRayPacket* packet,
+                          unsigned int lanes);
+
+  /// Compute Weight from Position and interpolate Value from Scalar.
+  void (*InterpolateScalar)(vtkSlicerFixedPointRayPacket* packet,
+                            unsigned int lanes);
+
+  /// Set Opacity to the scalar opacity of Value.
+  /// Return the lanes with a non zero opacity.
+  unsigned int (*LookupScalarOpacity)(vtkSlicerFixedPointRayPacket* packet,
+                                      unsigned int lanes,
+                                      const unsigned short* scalarOpacityTable);
+
+  /// Interpolate the gradient magnitude and modulate Opacity by its
+  /// gradient opacity. Return the lanes with a non zero opacity.
+  unsigned int (*ApplyGradientOpacity)(vtkSlicerFixedPointRayPacket* packet,
+                                       unsigned int lanes,
+                                       const unsigned short* gradientOpacityTable);
+
+  /// Look up the color of Value, shade it with the interpolated normal when
+  /// the shading tables are not NULL, and composite it into Color and
+  /// RemainingOpacity. Return the lanes that reached the early ray
+  /// termination threshold.
+  unsigned int (*Composite)(vtkSlicerFixedPointRayPacket* packet,
+                            unsigned int lanes,
+                            const unsigned short* colorTable,
+                            const unsigned short* diffuseShadingTable,
+                            const unsigned short* specularShadingTable);
+
+  /// Keep in MaxValue the maximum of MaxValue and Value.
+  void (*UpdateMaximum)(vtkSlicerFixedPointRayPacket* packet,
+                        unsigned int lanes);
+};
+
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketScalarKernels();
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketSSE41Kernels();
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketAVX2Kernels();
+
+/// Return true if the processor and the operating system support SSE4.1
+bool vtkSlicerFixedPointRayPacketHasSSE41();
+/// Return true if the processor and the operating system support AVX2
+bool vtkSlicerFixedPointRayPacketHasAVX2();
+
+#endif
@@ -0,0 +1,306 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// AVX2 version of the ray packet kernels: the eight lanes of a packet are
+// processed at once and the table lookups are done with gathers.
+// This file is compiled with the AVX2 flags of the compiler, see
+// CMakeLists.txt. It must not include VTK or STL headers.
+
+#include "vtkSlicerFixedPointRayPacket.h"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+inline __m256i Load(const unsigned int* values)
+{
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+}
+
+//----------------------------------------------------------------------------
+inline void Store(unsigned int* values, __m256i v)
+{
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(values), v);
+}
+
+//----------------------------------------------------------------------------
+// Store only the given lanes of v
+inline void StoreLanes(unsigned int* values, __m256i v, __m256i lanes)
+{
+  Store(values, _mm256_blendv_epi8(Load(values), v, lanes));
+}
+
+//----------------------------------------------------------------------------
+// All bits set in the lanes whose bit is set in the mask
+inline __m256i LaneMask(unsigned int lanes)
+{
+  const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  return _mm256_cmpeq_epi32(
+    _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(lanes)), bits), bits);
+}
+
+//----------------------------------------------------------------------------
+inline unsigned int BitMask(__m256i v)
+{
+  return static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(v)));
+}
+
+//----------------------------------------------------------------------------
+// (x + 0x7fff) >> VTKKW_FP_SHIFT
+inline __m256i Round(__m256i x)
+{
+  return _mm256_srli_epi32(_mm256_add_epi32(x, _mm256_set1_epi32(0x7fff)),
+                           VTKKW_FP_SHIFT);
+}
+
+//----------------------------------------------------------------------------
+inline __m256i LowShort(__m256i x)
+{
+  return _mm256_and_si256(x, _mm256_set1_epi32(0xffff));
+}
+
+//----------------------------------------------------------------------------
+// table[index] in the given lanes, 0 in the others. The 32 bit gather reads
+// the unsigned short following the entry too, it is masked out.
+inline __m256i Gather(const unsigned short* table, __m256i index, __m256i lanes)
+{
+  return LowShort(_mm256_mask_i32gather_epi32(
+    _mm256_setzero_si256(), reinterpret_cast<const int*>(table), index, lanes, 2));
+}
+
+//----------------------------------------------------------------------------
+inline __m256i Interpolate(const unsigned int corners[8][VTKKW_RAY_PACKET_SIZE],
+                           const vtkSlicerFixedPointRayPacket* packet)
+{
+  __m256i sum = _mm256_mullo_epi32(Load(corners[0]), Load(packet->Weight[0]));
+  for (int c = 1; c < 8; ++c)
+    {
+    sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(Load(corners[c]),
+                                                   Load(packet->Weight[c])));
+    }
+  return Round(sum);
+}
+
+//----------------------------------------------------------------------------
+inline __m256i InterpolateShading(const unsigned short* table, __m256i normalIndex[8],
+                                  int component, const vtkSlicerFixedPointRayPacket* packet,
+                                  __m256i lanes)
+{
+  const __m256i offset = _mm256_set1_epi32(component);
+  __m256i sum = _mm256_setzero_si256();
+  for (int c = 0; c < 8; ++c)
+    {
+    const __m256i value = Gather(table, _mm256_add_epi32(normalIndex[c], offset), lanes);
+    sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(value, Load(packet->Weight[c])));
+    }
+  return Round(sum);
+}
+
+//----------------------------------------------------------------------------
+unsigned int AVX2Advance(vtkSlicerFixedPointRayPacket* packet,
+                         unsigned int lanes)
+{
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i step = Load(packet->Step);
+  const __m256i moving = _mm256_andnot_si256(
+    _mm256_cmpeq_epi32(step, Load(packet->NumberOfSteps)), LaneMask(lanes));
+  const __m256i increment = _mm256_andnot_si256(_mm256_cmpeq_epi32(step, zero), moving);
+
+  __m256i minMaxChanged = zero;
+  __m256i cellChanged = zero;
+  for (int a = 0; a < 3; ++a)
+    {
+    const __m256i position = _mm256_add_epi32(
+      Load(packet->Position[a]), _mm256_and_si256(Load(packet->Increment[a]), increment));
+    Store(packet->Position[a], position);
+
+    const __m256i minMaxPosition = _mm256_srli_epi32(position, VTKKW_FPMM_SHIFT);
+    minMaxChanged = _mm256_or_si256(minMaxChanged, _mm256_xor_si256(
+      minMaxPosition, Load(packet->MinMaxPosition[a])));
+    StoreLanes(packet->MinMaxPosition[a], minMaxPosition, moving);
+
+    cellChanged = _mm256_or_si256(cellChanged, _mm256_xor_si256(
+      _mm256_srli_epi32(position, VTKKW_FP_SHIFT), Load(packet->CellPosition[a])));
+    }
+  // moving is -1 in the lanes that take a step
+  Store(packet->Step, _mm256_sub_epi32(step, moving));
+
+  packet->MinMaxChanged = BitMask(_mm256_andnot_si256(
+    _mm256_cmpeq_epi32(minMaxChanged, zero), moving));
+  packet->CellChanged = BitMask(_mm256_andnot_si256(
+    _mm256_cmpeq_epi32(cellChanged, zero), moving));
+  return BitMask(moving);
+}
+
+//----------------------------------------------------------------------------
+void AVX2InterpolateScalar(vtkSlicerFixedPointRayPacket* packet,
+                           unsigned int /*lanes*/)
+{
+  // The weights and values of all the lanes are computed, only the given
+  // lanes are used by the following kernels.
+  const __m256i mask = _mm256_set1_epi32(VTKKW_FP_MASK);
+  const __m256i half = _mm256_set1_epi32(0x4000);
+
+  const __m256i w2X = _mm256_and_si256(Load(packet->Position[0]), mask);
+  const __m256i w2Y = _mm256_and_si256(Load(packet->Position[1]), mask);
+  const __m256i w2Z = _mm256_and_si256(Load(packet->Position[2]), mask);
+
+  const __m256i w1X = _mm256_andnot_si256(w2X, mask);
+  const __m256i w1Y = _mm256_andnot_si256(w2Y, mask);
+  const __m256i w1Z = _mm256_andnot_si256(w2Z, mask);
+
+#define VTKKW_RAY_PACKET_PRODUCT(A, B) \
+  _mm256_srli_epi32(_mm256_add_epi32(half, _mm256_mullo_epi32(A, B)), VTKKW_FP_SHIFT)
+
+  const __m256i w1Xw1Y = VTKKW_RAY_PACKET_PRODUCT(w1X, w1Y);
+  const __m256i w2Xw1Y = VTKKW_RAY_PACKET_PRODUCT(w2X, w1Y);
+  const __m256i w1Xw2Y = VTKKW_RAY_PACKET_PRODUCT(w1X, w2Y);
+  const __m256i w2Xw2Y = VTKKW_RAY_PACKET_PRODUCT(w2X, w2Y);
+
+  Store(packet->Weight[0], VTKKW_RAY_PACKET_PRODUCT(w1Xw1Y, w1Z));
+  Store(packet->Weight[1], VTKKW_RAY_PACKET_PRODUCT(w2Xw1Y, w1Z));
+  Store(packet->Weight[2], VTKKW_RAY_PACKET_PRODUCT(w1Xw2Y, w1Z));
+  Store(packet->Weight[3], VTKKW_RAY_PACKET_PRODUCT(w2Xw2Y, w1Z));
+  Store(packet->Weight[4], VTKKW_RAY_PACKET_PRODUCT(w1Xw1Y, w2Z));
+  Store(packet->Weight[5], VTKKW_RAY_PACKET_PRODUCT(w2Xw1Y, w2Z));
+  Store(packet->Weight[6], VTKKW_RAY_PACKET_PRODUCT(w1Xw2Y, w2Z));
+  Store(packet->Weight[7], VTKKW_RAY_PACKET_PRODUCT(w2Xw2Y, w2Z));
+
+#undef VTKKW_RAY_PACKET_PRODUCT
+
+  Store(packet->Value, LowShort(Interpolate(packet->Scalar, packet)));
+}
+
+//----------------------------------------------------------------------------
+unsigned int AVX2LookupScalarOpacity(vtkSlicerFixedPointRayPacket* packet,
+                                     unsigned int lanes,
+                                     const unsigned short* scalarOpacityTable)
+{
+  const __m256i active = LaneMask(lanes);
+  const __m256i opacity = Gather(scalarOpacityTable, Load(packet->Value), active);
+  Store(packet->Opacity, opacity);
+  return lanes & ~BitMask(_mm256_cmpeq_epi32(opacity, _mm256_setzero_si256()));
+}
+
+//----------------------------------------------------------------------------
+unsigned int AVX2ApplyGradientOpacity(vtkSlicerFixedPointRayPacket* packet,
+                                      unsigned int lanes,
+                                      const unsigned short* gradientOpacityTable)
+{
+  const __m256i active = LaneMask(lanes);
+  const __m256i magnitude = LowShort(Interpolate(packet->Magnitude, packet));
+  const __m256i gradientOpacity = Gather(gradientOpacityTable, magnitude, active);
+  const __m256i opacity = LowShort(Round(
+    _mm256_mullo_epi32(Load(packet->Opacity), gradientOpacity)));
+  StoreLanes(packet->Opacity, opacity, active);
+  return lanes & ~BitMask(_mm256_cmpeq_epi32(opacity, _mm256_setzero_si256()));
+}
+
+//----------------------------------------------------------------------------
+unsigned int AVX2Composite(vtkSlicerFixedPointRayPacket* packet,
+                           unsigned int lanes,
+                           const unsigned short* colorTable,
+                           const unsigned short* diffuseShadingTable,
+                           const unsigned short* specularShadingTable)
+{
+  const __m256i active = LaneMask(lanes);
+  const __m256i opacity = Load(packet->Opacity);
+  const __m256i value = Load(packet->Value);
+  const __m256i colorIndex = _mm256_add_epi32(_mm256_add_epi32(value, value), value);
+
+  __m256i color[3];
+  for (int c = 0; c < 3; ++c)
+    {
+    const __m256i entry = Gather(
+      colorTable, _mm256_add_epi32(colorIndex, _mm256_set1_epi32(c)), active);
+    color[c] = LowShort(Round(_mm256_mullo_epi32(entry, opacity)));
+    }
+
+  if (diffuseShadingTable)
+    {
+    __m256i normalIndex[8];
+    for (int c = 0; c < 8; ++c)
+      {
+      const __m256i normal = Load(packet->Normal[c]);
+      normalIndex[c] = _mm256_add_epi32(_mm256_add_epi32(normal, normal), normal);
+      }
+    for (int c = 0; c < 3; ++c)
+      {
+      const __m256i diffuse =
+        InterpolateShading(diffuseShadingTable, normalIndex, c, packet, active);
+      const __m256i specular =
+        InterpolateShading(specularShadingTable, normalIndex, c, packet, active);
+      color[c] = LowShort(Round(_mm256_mullo_epi32(diffuse, color[c])));
+      color[c] = LowShort(_mm256_add_epi32(
+        color[c], Round(_mm256_mullo_epi32(specular, opacity))));
+      }
+    }
+
+  const __m256i remainingOpacity = Load(packet->RemainingOpacity);
+  for (int c = 0; c < 3; ++c)
+    {
+    StoreLanes(packet->Color[c], _mm256_add_epi32(
+      Load(packet->Color[c]), Round(_mm256_mullo_epi32(color[c], remainingOpacity))),
+      active);
+    }
+  const __m256i transparency = _mm256_andnot_si256(opacity, _mm256_set1_epi32(VTKKW_FP_MASK));
+  const __m256i newRemainingOpacity =
+    LowShort(Round(_mm256_mullo_epi32(remainingOpacity, transparency)));
+  StoreLanes(packet->RemainingOpacity, newRemainingOpacity, active);
+  return lanes & BitMask(
+    _mm256_cmpgt_epi32(_mm256_set1_epi32(0xff), newRemainingOpacity));
+}
+
+//----------------------------------------------------------------------------
+void AVX2UpdateMaximum(vtkSlicerFixedPointRayPacket* packet,
+                       unsigned int lanes)
+{
+  const __m256i maxValue = _mm256_max_epu32(Load(packet->MaxValue), Load(packet->Value));
+  StoreLanes(packet->MaxValue, maxValue, LaneMask(lanes));
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketAVX2Kernels()
+{
+  static const vtkSlicerFixedPointRayPacketKernels kernels =
+    {
+    "AVX2",
+    AVX2Advance,
+    AVX2InterpolateScalar,
+    AVX2LookupScalarOpacity,
+    AVX2ApplyGradientOpacity,
+    AVX2Composite,
+    AVX2UpdateMaximum
+    };
+  return &kernels;
+}
+
+#else
+
+//----------------------------------------------------------------------------
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketAVX2Kernels()
+{
+  return 0;
+}
+
+#endif
@@ -0,0 +1,415 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+///  vtkSlicerFixedPointRayPacketHelper - ray packet versions of the one
+/// component trilinear helpers
+///
+/// The functions below generate the same image as the one component
+/// trilinear functions of the composite and MIP helpers, casting the rays
+/// of a scan line VTKKW_RAY_PACKET_SIZE at a time. Each ray keeps its own
+/// steps, space leaping, cropping and cell; the samples of the rays that
+/// are not skipped are then interpolated, classified and composited by the
+/// kernels of the mapper (see vtkSlicerFixedPointRayPacket).
+
+#ifndef __vtkSlicerFixedPointRayPacketHelper_h
+#define __vtkSlicerFixedPointRayPacketHelper_h
+
+#include "vtkSlicerFixedPointRayPacket.h"
+#include "vtkSlicerFixedPointVolumeRayCastHelper.h"
+#include "vtkSlicerFixedPointVolumeRayCastMapper.h"
+#include "vtkSlicerFixedPointRayCastImage.h"
+
+// VTK includes
+#include <vtkCommand.h>
+#include <vtkImageData.h>
+#include <vtkRenderWindow.h>
+#include <vtkVolume.h>
+#include <vtkVolumeProperty.h>
+
+// STD includes
+#include <cstring>
+
+#define VTKKWRCHelper_PacketLoopStart()                                         \
+  for ( j = 0; j < imageInUseSize[1]; j++ )                                     \
+    {                                                                           \
+    VTKKWRCHelper_OuterInitialization();                                        \
+    for ( i = rowBounds[j*2]; i <= rowBounds[j*2+1]; i += VTKKW_RAY_PACKET_SIZE ) \
+      {                                                                         \
+      int rays = rowBounds[j*2+1] - i + 1;                                      \
+      if ( rays > VTKKW_RAY_PACKET_SIZE )                                       \
+        {                                                                       \
+        rays = VTKKW_RAY_PACKET_SIZE;                                           \
+        }
+
+#define VTKKWRCHelper_PacketLoopEnd()                                           \
+      imagePtr += 4*rays;                                                       \
+      }                                                                         \
+    if ( j%32 == 0 && threadID==0 )                                             \
+      {                                                                         \
+      float fargs[1];                                                           \
+      fargs[0] = static_cast<float>(j)/static_cast<float>(imageInUseSize[1]-1); \
+      mapper->InvokeEvent( vtkCommand::ProgressEvent, fargs );                  \
+      }                                                                         \
+    }
+
+// Start the ray of lane l at pixel (i+l, j). The increment of the position
+// is stored as the value added by FixedPointIncrement modulo 2^32, and the
+// first sample is set to another cell and block than its own as in the per
+// ray helpers.
+#define VTKKWRCHelper_PacketInitializeRay( l )                                  \
+  {                                                                             \
+  unsigned int dir[3];                                                          \
+  mapper->ComputeRayInfo( i+l, j, pos, dir, &packet.NumberOfSteps[l] );         \
+  for ( c = 0; c < 3; c++ )                                                     \
+    {                                                                           \
+    packet.Position[c][l]  = pos[c];                                            \
+    packet.Increment[c][l] = ( dir[c]&0x80000000 )?                             \
+      ( dir[c]&0x7fffffff ):( 0u - dir[c] );                                    \
+    }                                                                           \
+  packet.Step[l] = 0;                                                           \
+  packet.CellPosition[0][l] = (pos[0] >> VTKKW_FP_SHIFT) + 1;                   \
+  packet.CellPosition[1][l] = packet.CellPosition[2][l] = 0;                    \
+  packet.MinMaxPosition[0][l] = (pos[0] >> VTKKW_FPMM_SHIFT) + 1;               \
+  packet.MinMaxPosition[1][l] = packet.MinMaxPosition[2][l] = 0;                \
+  if ( packet.NumberOfSteps[l] )                                                \
+    {                                                                           \
+    raysLeft |= (1u << l);                                                      \
+    }                                                                           \
+  }
+
+// Remove from samples the lanes in a block of the min max volume that can be
+// skipped. FLAG is evaluated with mmpos set to the block of lane l when the
+// lane enters another block.
+#define VTKKWRCHelper_PacketSpaceLeapCheck( FLAG )                              \
+  for ( l = 0; l < rays; l++ )                                                  \
+    {                                                                           \
+    if ( packet.MinMaxChanged & (1u << l) )                                     \
+      {                                                                         \
+      mmpos[0] = packet.MinMaxPosition[0][l];                                   \
+      mmpos[1] = packet.MinMaxPosition[1][l];                                   \
+      mmpos[2] = packet.MinMaxPosition[2][l];                                   \
+      if ( FLAG )                                                               \
+        {                                                                       \
+        mmvalid |= (1u << l);                                                   \
+        }                                                                       \
+      else                                                                      \
+        {                                                                       \
+        mmvalid &= ~(1u << l);                                                  \
+        }                                                                       \
+      }                                                                         \
+    }                                                                           \
+  samples &= mmvalid;
+
+// Remove from samples the cropped lanes
+#define VTKKWRCHelper_PacketCroppingCheck()                                     \
+  if ( cropping )                                                               \
+    {                                                                           \
+    for ( l = 0; l < rays; l++ )                                                \
+      {                                                                         \
+      if ( samples & (1u << l) )                                                \
+        {                                                                       \
+        pos[0] = packet.Position[0][l];                                         \
+        pos[1] = packet.Position[1][l];                                         \
+        pos[2] = packet.Position[2][l];                                         \
+        if ( mapper->CheckIfCropped( pos ) )                                    \
+          {                                                                     \
+          samples &= ~(1u << l);                                                \
+          }                                                                     \
+        }                                                                       \
+      }                                                                         \
+    }
+
+// Set spos, CellPosition and dptr to the cell of the sample of lane l
+#define VTKKWRCHelper_PacketMoveToCell( l )                                     \
+  pos[0] = packet.Position[0][l];                                               \
+  pos[1] = packet.Position[1][l];                                               \
+  pos[2] = packet.Position[2][l];                                               \
+  mapper->ShiftVectorDown( pos, spos );                                         \
+  packet.CellPosition[0][l] = spos[0];                                          \
+  packet.CellPosition[1][l] = spos[1];                                          \
+  packet.CellPosition[2][l] = spos[2];                                          \
+  dptr = data + spos[0]*inc[0] + spos[1]*inc[1] + spos[2]*inc[2];
+
+// Load the scalar indices of the corners of the cell of lane l
+#define VTKKWRCHelper_PacketGetCellScalarValues( l )                            \
+  if ( simple )                                                                 \
+    {                                                                           \
+    packet.Scalar[0][l] = static_cast<unsigned int >(*(dptr     ));             \
+    packet.Scalar[1][l] = static_cast<unsigned int >(*(dptr+Binc));             \
+    packet.Scalar[2][l] = static_cast<unsigned int >(*(dptr+Cinc));             \
+    packet.Scalar[3][l] = static_cast<unsigned int >(*(dptr+Dinc));             \
+    packet.Scalar[4][l] = static_cast<unsigned int >(*(dptr+Einc));             \
+    packet.Scalar[5][l] = static_cast<unsigned int >(*(dptr+Finc));             \
+    packet.Scalar[6][l] = static_cast<unsigned int >(*(dptr+Ginc));             \
+    packet.Scalar[7][l] = static_cast<unsigned int >(*(dptr+Hinc));             \
+    }                                                                           \
+  else                                                                          \
+    {                                                                           \
+    packet.Scalar[0][l] = static_cast<unsigned int >(scale[0]*(*(dptr     ) + shift[0])); \
+    packet.Scalar[1][l] = static_cast<unsigned int >(scale[0]*(*(dptr+Binc) + shift[0])); \
+    packet.Scalar[2][l] = static_cast<unsigned int >(scale[0]*(*(dptr+Cinc) + shift[0])); \
+    packet.Scalar[3][l] = static_cast<unsigned int >(scale[0]*(*(dptr+Dinc) + shift[0])); \
+    packet.Scalar[4][l] = static_cast<unsigned int >(scale[0]*(*(dptr+Einc) + shift[0])); \
+    packet.Scalar[5][l] = static_cast<unsigned int >(scale[0]*(*(dptr+Finc) + shift[0])); \
+    packet.Scalar[6][l] = static_cast<unsigned int >(scale[0]*(*(dptr+Ginc) + shift[0])); \
+    packet.Scalar[7][l] = static_cast<unsigned int >(scale[0]*(*(dptr+Hinc) + shift[0])); \
+    }
+
+// Generate the image of one component data with trilinear interpolation,
+// with optional gradient opacity and shading. simple is true when the table
+// scale is 1 and the table shift 0.
+template <class T>
+void vtkSlicerFixedPointRayPacketGenerateImageCompositeOneTrilin(
+  T *data, int threadID, int threadCount,
+  vtkSlicerFixedPointVolumeRayCastMapper *mapper, vtkVolume *vol,
+  int simple, int gradientOpacity, int shade )
+{
+  VTKKWRCHelper_InitializeVariables();
+  VTKKWRCHelper_InitializeVariablesGO();
+  VTKKWRCHelper_InitializeVariablesShade();
+  VTKKWRCHelper_InitializeTrilinVariables();
+  VTKKWRCHelper_InitializeTrilinVariablesGO();
+  VTKKWRCHelper_InitializeTrilinVariablesShade();
+
+  const vtkSlicerFixedPointRayPacketKernels *kernels = mapper->GetRayPacketKernels();
+  vtkSlicerFixedPointRayPacket packet;
+  memset( &packet, 0, sizeof(packet) );
+
+  unsigned char  *magPtrABCD[VTKKW_RAY_PACKET_SIZE];
+  unsigned char  *magPtrEFGH[VTKKW_RAY_PACKET_SIZE];
+  unsigned short *dirPtrABCD[VTKKW_RAY_PACKET_SIZE];
+  unsigned short *dirPtrEFGH[VTKKW_RAY_PACKET_SIZE];
+  unsigned int    pos[3];
+  unsigned int    spos[3];
+  unsigned int    mmpos[3];
+  T              *dptr;
+  int             l;
+
+  VTKKWRCHelper_PacketLoopStart();
+
+  unsigned int raysLeft = 0;
+  unsigned int mmvalid = 0;
+  unsigned int needToSampleMagnitude = 0;
+  unsigned int needToSampleDirection = 0;
+  for ( l = 0; l < rays; l++ )
+    {
+    VTKKWRCHelper_PacketInitializeRay( l );
+    packet.Color[0][l] = packet.Color[1][l] = packet.Color[2][l] = 0;
+    packet.RemainingOpacity[l] = 0x7fff;
+    }
+
+  while ( raysLeft )
+    {
+    raysLeft = kernels->Advance( &packet, raysLeft );
+    unsigned int samples = raysLeft;
+    VTKKWRCHelper_PacketSpaceLeapCheck( mapper->CheckMinMaxVolumeFlag( mmpos, 0 ) );
+    VTKKWRCHelper_PacketCroppingCheck();
+
+    for ( l = 0; l < rays; l++ )
+      {
+      if ( samples & packet.CellChanged & (1u << l) )
+        {
+        VTKKWRCHelper_PacketMoveToCell( l );
+        VTKKWRCHelper_PacketGetCellScalarValues( l );
+
+        if ( gradientOpacity )
+          {
+          magPtrABCD[l] = gradientMag[spos[2]  ] + spos[0]*mInc[0] + spos[1]*mInc[1];
+          magPtrEFGH[l] = gradientMag[spos[2]+1] + spos[0]*mInc[0] + spos[1]*mInc[1];
+          needToSampleMagnitude |= (1u << l);
+          }
+        if ( shade )
+          {
+          dirPtrABCD[l] = gradientDir[spos[2]  ] + spos[0]*dInc[0] + spos[1]*dInc[1];
+          dirPtrEFGH[l] = gradientDir[spos[2]+1] + spos[0]*dInc[0] + spos[1]*dInc[1];
+          needToSampleDirection |= (1u << l);
+          }
+        }
+      }
+
+    if ( !samples )
+      {
+      continue;
+      }
+
+    kernels->InterpolateScalar( &packet, samples );
+    samples = kernels->LookupScalarOpacity( &packet, samples, scalarOpacityTable[0] );
+
+    if ( gradientOpacity && samples )
+      {
+      for ( l = 0; l < rays; l++ )
+        {
+        if ( samples & needToSampleMagnitude & (1u << l) )
+          {
+          packet.Magnitude[0][l] = static_cast<unsigned int >(*(magPtrABCD[l]       ));
+          packet.Magnitude[1][l] = static_cast<unsigned int >(*(magPtrABCD[l]+mBFinc));
+          packet.Magnitude[2][l] = static_cast<unsigned int >(*(magPtrABCD[l]+mCGinc));
+          packet.Magnitude[3][l] = static_cast<unsigned int >(*(magPtrABCD[l]+mDHinc));
+          packet.Magnitude[4][l] = static_cast<unsigned int >(*(magPtrEFGH[l]       ));
+          packet.Magnitude[5][l] = static_cast<unsigned int >(*(magPtrEFGH[l]+mBFinc));
+          packet.Magnitude[6][l] = static_cast<unsigned int >(*(magPtrEFGH[l]+mCGinc));
+          packet.Magnitude[7][l] = static_cast<unsigned int >(*(magPtrEFGH[l]+mDHinc));
+          }
+        }
+      needToSampleMagnitude &= ~samples;
+      samples = kernels->ApplyGradientOpacity( &packet, samples, gradientOpacityTable[0] );
+      }
+
+    if ( shade && samples )
+      {
+      for ( l = 0; l < rays; l++ )
+        {
+        if ( samples & needToSampleDirection & (1u << l) )
+          {
+          packet.Normal[0][l] = static_cast<unsigned int >(*(dirPtrABCD[l]       ));
+          packet.Normal[1][l] = static_cast<unsigned int >(*(dirPtrABCD[l]+dBFinc));
+          packet.Normal[2][l] = static_cast<unsigned int >(*(dirPtrABCD[l]+dCGinc));
+          packet.Normal[3][l] = static_cast<unsigned int >(*(dirPtrABCD[l]+dDHinc));
+          packet.Normal[4][l] = static_cast<unsigned int >(*(dirPtrEFGH[l]       ));
+          packet.Normal[5][l] = static_cast<unsigned int >(*(dirPtrEFGH[l]+dBFinc));
+          packet.Normal[6][l] = static_cast<unsigned int >(*(dirPtrEFGH[l]+dCGinc));
+          packet.Normal[7][l] = static_cast<unsigned int >(*(dirPtrEFGH[l]+dDHinc));
+          }
+        }
+      needToSampleDirection &= ~samples;
+      }
+
+    if ( samples )
+      {
+      raysLeft &= ~kernels->Composite( &packet, samples, colorTable[0],
+                                       shade ? diffuseShadingTable[0] : 0,
+                                       shade ? specularShadingTable[0] : 0 );
+      }
+    }
+
+  for ( l = 0; l < rays; l++ )
+    {
+    unsigned int color[3];
+    color[0] = packet.Color[0][l];
+    color[1] = packet.Color[1][l];
+    color[2] = packet.Color[2][l];
+    unsigned short remainingOpacity =
+      static_cast<unsigned short>(packet.RemainingOpacity[l]);
+    unsigned short *pixelPtr = imagePtr + 4*l;
+    VTKKWRCHelper_SetPixelColor( pixelPtr, color, remainingOpacity );
+    }
+
+  VTKKWRCHelper_PacketLoopEnd();
+}
+
+// Generate the maximum intensity projection of one component data with
+// trilinear interpolation. simple is true when the table scale is 1 and
+// the table shift 0: the samples of the cells whose corners are all below
+// the maximum found so far are then skipped.
+template <class T>
+void vtkSlicerFixedPointRayPacketGenerateImageMIPOneTrilin(
+  T *data, int threadID, int threadCount,
+  vtkSlicerFixedPointVolumeRayCastMapper *mapper, vtkVolume *vtkNotUsed(vol),
+  int simple )
+{
+  VTKKWRCHelper_InitializeVariables();
+  VTKKWRCHelper_InitializeTrilinVariables();
+
+  const vtkSlicerFixedPointRayPacketKernels *kernels = mapper->GetRayPacketKernels();
+  vtkSlicerFixedPointRayPacket packet;
+  memset( &packet, 0, sizeof(packet) );
+
+  unsigned short  maxScalar[VTKKW_RAY_PACKET_SIZE];
+  unsigned int    pos[3];
+  unsigned int    spos[3];
+  unsigned int    mmpos[3];
+  T              *dptr;
+  int             l;
+
+  VTKKWRCHelper_PacketLoopStart();
+
+  unsigned int raysLeft = 0;
+  unsigned int mmvalid = 0;
+  unsigned int maxValueDefined = 0;
+  for ( l = 0; l < rays; l++ )
+    {
+    VTKKWRCHelper_PacketInitializeRay( l );
+    packet.MaxValue[l] = 0;
+    maxScalar[l] = 0;
+    }
+
+  while ( raysLeft )
+    {
+    raysLeft = kernels->Advance( &packet, raysLeft );
+    unsigned int samples = raysLeft;
+    // The flag of a block depends on the maximum found when the ray enters it
+    VTKKWRCHelper_PacketSpaceLeapCheck(
+      (maxValueDefined & (1u << l))?
+      (mapper->CheckMIPMinMaxVolumeFlag( mmpos, 0,
+        static_cast<unsigned short>(packet.MaxValue[l]) )):(1) );
+    VTKKWRCHelper_PacketCroppingCheck();
+
+    for ( l = 0; l < rays; l++ )
+      {
+      if ( !(samples & (1u << l)) )
+        {
+        continue;
+        }
+      if ( packet.CellChanged & (1u << l) )
+        {
+        VTKKWRCHelper_PacketMoveToCell( l );
+        VTKKWRCHelper_PacketGetCellScalarValues( l );
+        if ( simple )
+          {
+          maxScalar[l] = (packet.Scalar[0][l]>packet.Scalar[1][l])?
+            (packet.Scalar[0][l]):(packet.Scalar[1][l]);
+          for ( c = 2; c < 8; c++ )
+            {
+            maxScalar[l] = (packet.Scalar[c][l]>maxScalar[l])?
+              (packet.Scalar[c][l]):(maxScalar[l]);
+            }
+          }
+        }
+      // Skip the cells whose corners are all below the maximum
+      if ( simple && (maxValueDefined & (1u << l)) &&
+           maxScalar[l] <= static_cast<unsigned short>(packet.MaxValue[l]) )
+        {
+        samples &= ~(1u << l);
+        }
+      }
+
+    if ( samples )
+      {
+      kernels->InterpolateScalar( &packet, samples );
+      kernels->UpdateMaximum( &packet, samples );
+      maxValueDefined |= samples;
+      }
+    }
+
+  for ( l = 0; l < rays; l++ )
+    {
+    unsigned short *pixelPtr = imagePtr + 4*l;
+    if ( maxValueDefined & (1u << l) )
+      {
+      const unsigned short maxIdx = static_cast<unsigned short>(packet.MaxValue[l]);
+      VTKKWRCHelper_LookupColorMax( colorTable[0], scalarOpacityTable[0], maxIdx, pixelPtr );
+      }
+    else
+      {
+      pixelPtr[0] = pixelPtr[1] = pixelPtr[2] = pixelPtr[3] = 0;
+      }
+    }
+
+  VTKKWRCHelper_PacketLoopEnd();
+}
+
+#endif
@@ -0,0 +1,387 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SSE4.1 version of the ray packet kernels: a packet is processed four
+// lanes at a time. SSE4.1 has no gather, the table lookups are scalar loads.
+// This file is compiled with the SSE4.1 flags of the compiler, see
+// CMakeLists.txt. It must not include VTK or STL headers.
+
+#include "vtkSlicerFixedPointRayPacket.h"
+
+#if defined(__SSE4_1__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+
+#include <smmintrin.h>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+inline __m128i Load(const unsigned int* values)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+}
+
+//----------------------------------------------------------------------------
+inline void Store(unsigned int* values, __m128i v)
+{
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(values), v);
+}
+
+//----------------------------------------------------------------------------
+// Store only the given lanes of v
+inline void StoreLanes(unsigned int* values, __m128i v, __m128i lanes)
+{
+  Store(values, _mm_blendv_epi8(Load(values), v, lanes));
+}
+
+//----------------------------------------------------------------------------
+// All bits set in the lanes of the half h of the packet whose bit is set
+// in the mask
+inline __m128i LaneMask(unsigned int lanes, int h)
+{
+  const __m128i bits = _mm_setr_epi32(1, 2, 4, 8);
+  return _mm_cmpeq_epi32(
+    _mm_and_si128(_mm_set1_epi32(static_cast<int>(lanes >> (4*h))), bits), bits);
+}
+
+//----------------------------------------------------------------------------
+// Bits of the half h of the packet
+inline unsigned int BitMask(__m128i v, int h)
+{
+  return static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(v))) << (4*h);
+}
+
+//----------------------------------------------------------------------------
+// (x + 0x7fff) >> VTKKW_FP_SHIFT
+inline __m128i Round(__m128i x)
+{
+  return _mm_srli_epi32(_mm_add_epi32(x, _mm_set1_epi32(0x7fff)), VTKKW_FP_SHIFT);
+}
+
+//----------------------------------------------------------------------------
+inline __m128i LowShort(__m128i x)
+{
+  return _mm_and_si128(x, _mm_set1_epi32(0xffff));
+}
+
+//----------------------------------------------------------------------------
+// table[index] in the lanes of the half h of the mask, 0 in the others
+inline __m128i Gather(const unsigned short* table, __m128i index,
+                      unsigned int lanes, int h)
+{
+  unsigned int indices[4];
+  Store(indices, index);
+  unsigned int values[4];
+  for (int l = 0; l < 4; ++l)
+    {
+    values[l] = (lanes & (1u << (4*h + l))) ? table[indices[l]] : 0;
+    }
+  return Load(values);
+}
+
+//----------------------------------------------------------------------------
+inline __m128i Interpolate(const unsigned int corners[8][VTKKW_RAY_PACKET_SIZE],
+                           const vtkSlicerFixedPointRayPacket* packet, int h)
+{
+  __m128i sum = _mm_mullo_epi32(Load(corners[0] + 4*h), Load(packet->Weight[0] + 4*h));
+  for (int c = 1; c < 8; ++c)
+    {
+    sum = _mm_add_epi32(sum, _mm_mullo_epi32(Load(corners[c] + 4*h),
+                                             Load(packet->Weight[c] + 4*h)));
+    }
+  return Round(sum);
+}
+
+//----------------------------------------------------------------------------
+// Interpolate the diffuse and specular shading tables at the normals of the
+// corners in the lanes of the half h. The three components of an entry are
+// loaded together.
+inline void InterpolateShading(const unsigned short* diffuseShadingTable,
+                               const unsigned short* specularShadingTable,
+                               const vtkSlicerFixedPointRayPacket* packet,
+                               unsigned int lanes, int h,
+                               __m128i diffuse[3], __m128i specular[3])
+{
+  unsigned int diffuseValues[3][8][4];
+  unsigned int specularValues[3][8][4];
+  for (int l = 0; l < 4; ++l)
+    {
+    const bool active = (lanes & (1u << (4*h + l))) != 0;
+    for (int c = 0; c < 8; ++c)
+      {
+      const unsigned int index = active ? 3*packet->Normal[c][4*h + l] : 0;
+      for (int k = 0; k < 3; ++k)
+        {
+        diffuseValues[k][c][l] = active ? diffuseShadingTable[index + k] : 0;
+        specularValues[k][c][l] = active ? specularShadingTable[index + k] : 0;
+        }
+      }
+    }
+  for (int k = 0; k < 3; ++k)
+    {
+    __m128i diffuseSum = _mm_setzero_si128();
+    __m128i specularSum = _mm_setzero_si128();
+    for (int c = 0; c < 8; ++c)
+      {
+      const __m128i weight = Load(packet->Weight[c] + 4*h);
+      diffuseSum = _mm_add_epi32(diffuseSum,
+                                 _mm_mullo_epi32(Load(diffuseValues[k][c]), weight));
+      specularSum = _mm_add_epi32(specularSum,
+                                  _mm_mullo_epi32(Load(specularValues[k][c]), weight));
+      }
+    diffuse[k] = Round(diffuseSum);
+    specular[k] = Round(specularSum);
+    }
+}
+
+//----------------------------------------------------------------------------
+unsigned int SSE41Advance(vtkSlicerFixedPointRayPacket* packet,
+                          unsigned int lanes)
+{
+  const __m128i zero = _mm_setzero_si128();
+  unsigned int moving = 0;
+  packet->MinMaxChanged = 0;
+  packet->CellChanged = 0;
+  for (int h = 0; h < 2; ++h)
+    {
+    if (!((lanes >> (4*h)) & 0xf))
+      {
+      continue;
+      }
+    const __m128i step = Load(packet->Step + 4*h);
+    const __m128i movingHalf = _mm_andnot_si128(
+      _mm_cmpeq_epi32(step, Load(packet->NumberOfSteps + 4*h)), LaneMask(lanes, h));
+    const __m128i increment = _mm_andnot_si128(_mm_cmpeq_epi32(step, zero), movingHalf);
+
+    __m128i minMaxChanged = zero;
+    __m128i cellChanged = zero;
+    for (int a = 0; a < 3; ++a)
+      {
+      const __m128i position = _mm_add_epi32(
+        Load(packet->Position[a] + 4*h),
+        _mm_and_si128(Load(packet->Increment[a] + 4*h), increment));
+      Store(packet->Position[a] + 4*h, position);
+
+      const __m128i minMaxPosition = _mm_srli_epi32(position, VTKKW_FPMM_SHIFT);
+      minMaxChanged = _mm_or_si128(minMaxChanged, _mm_xor_si128(
+        minMaxPosition, Load(packet->MinMaxPosition[a] + 4*h)));
+      StoreLanes(packet->MinMaxPosition[a] + 4*h, minMaxPosition, movingHalf);
+
+      cellChanged = _mm_or_si128(cellChanged, _mm_xor_si128(
+        _mm_srli_epi32(position, VTKKW_FP_SHIFT), Load(packet->CellPosition[a] + 4*h)));
+      }
+    // movingHalf is -1 in the lanes that take a step
+    Store(packet->Step + 4*h, _mm_sub_epi32(step, movingHalf));
+
+    moving |= BitMask(movingHalf, h);
+    packet->MinMaxChanged |= BitMask(_mm_andnot_si128(
+      _mm_cmpeq_epi32(minMaxChanged, zero), movingHalf), h);
+    packet->CellChanged |= BitMask(_mm_andnot_si128(
+      _mm_cmpeq_epi32(cellChanged, zero), movingHalf), h);
+    }
+  return moving;
+}
+
+//----------------------------------------------------------------------------
+void SSE41InterpolateScalar(vtkSlicerFixedPointRayPacket* packet,
+                            unsigned int lanes)
+{
+  const __m128i mask = _mm_set1_epi32(VTKKW_FP_MASK);
+  const __m128i half = _mm_set1_epi32(0x4000);
+
+#define VTKKW_RAY_PACKET_PRODUCT(A, B) \
+  _mm_srli_epi32(_mm_add_epi32(half, _mm_mullo_epi32(A, B)), VTKKW_FP_SHIFT)
+
+  for (int h = 0; h < 2; ++h)
+    {
+    if (!((lanes >> (4*h)) & 0xf))
+      {
+      continue;
+      }
+    const __m128i w2X = _mm_and_si128(Load(packet->Position[0] + 4*h), mask);
+    const __m128i w2Y = _mm_and_si128(Load(packet->Position[1] + 4*h), mask);
+    const __m128i w2Z = _mm_and_si128(Load(packet->Position[2] + 4*h), mask);
+
+    const __m128i w1X = _mm_andnot_si128(w2X, mask);
+    const __m128i w1Y = _mm_andnot_si128(w2Y, mask);
+    const __m128i w1Z = _mm_andnot_si128(w2Z, mask);
+
+    const __m128i w1Xw1Y = VTKKW_RAY_PACKET_PRODUCT(w1X, w1Y);
+    const __m128i w2Xw1Y = VTKKW_RAY_PACKET_PRODUCT(w2X, w1Y);
+    const __m128i w1Xw2Y = VTKKW_RAY_PACKET_PRODUCT(w1X, w2Y);
+    const __m128i w2Xw2Y = VTKKW_RAY_PACKET_PRODUCT(w2X, w2Y);
+
+    Store(packet->Weight[0] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w1Xw1Y, w1Z));
+    Store(packet->Weight[1] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w2Xw1Y, w1Z));
+    Store(packet->Weight[2] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w1Xw2Y, w1Z));
+    Store(packet->Weight[3] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w2Xw2Y, w1Z));
+    Store(packet->Weight[4] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w1Xw1Y, w2Z));
+    Store(packet->Weight[5] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w2Xw1Y, w2Z));
+    Store(packet->Weight[6] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w1Xw2Y, w2Z));
+    Store(packet->Weight[7] + 4*h, VTKKW_RAY_PACKET_PRODUCT(w2Xw2Y, w2Z));
+
+    Store(packet->Value + 4*h, LowShort(Interpolate(packet->Scalar, packet, h)));
+    }
+
+#undef VTKKW_RAY_PACKET_PRODUCT
+}
+
+//----------------------------------------------------------------------------
+unsigned int SSE41LookupScalarOpacity(vtkSlicerFixedPointRayPacket* packet,
+                                      unsigned int lanes,
+                                      const unsigned short* scalarOpacityTable)
+{
+  unsigned int transparent = 0;
+  for (int h = 0; h < 2; ++h)
+    {
+    if (!((lanes >> (4*h)) & 0xf))
+      {
+      continue;
+      }
+    const __m128i opacity =
+      Gather(scalarOpacityTable, Load(packet->Value + 4*h), lanes, h);
+    Store(packet->Opacity + 4*h, opacity);
+    transparent |= BitMask(_mm_cmpeq_epi32(opacity, _mm_setzero_si128()), h);
+    }
+  return lanes & ~transparent;
+}
+
+//----------------------------------------------------------------------------
+unsigned int SSE41ApplyGradientOpacity(vtkSlicerFixedPointRayPacket* packet,
+                                       unsigned int lanes,
+                                       const unsigned short* gradientOpacityTable)
+{
+  unsigned int transparent = 0;
+  for (int h = 0; h < 2; ++h)
+    {
+    if (!((lanes >> (4*h)) & 0xf))
+      {
+      continue;
+      }
+    const __m128i magnitude = LowShort(Interpolate(packet->Magnitude, packet, h));
+    const __m128i gradientOpacity = Gather(gradientOpacityTable, magnitude, lanes, h);
+    const __m128i opacity = LowShort(Round(
+      _mm_mullo_epi32(Load(packet->Opacity + 4*h), gradientOpacity)));
+    StoreLanes(packet->Opacity + 4*h, opacity, LaneMask(lanes, h));
+    transparent |= BitMask(_mm_cmpeq_epi32(opacity, _mm_setzero_si128()), h);
+    }
+  return lanes & ~transparent;
+}
+
+//----------------------------------------------------------------------------
+unsigned int SSE41Composite(vtkSlicerFixedPointRayPacket* packet,
+                            unsigned int lanes,
+                            const unsigned short* colorTable,
+                            const unsigned short* diffuseShadingTable,
+                            const unsigned short* specularShadingTable)
+{
+  unsigned int terminated = 0;
+  for (int h = 0; h < 2; ++h)
+    {
+    if (!((lanes >> (4*h)) & 0xf))
+      {
+      continue;
+      }
+    const __m128i active = LaneMask(lanes, h);
+    const __m128i opacity = Load(packet->Opacity + 4*h);
+
+    // The three components of a color are loaded together
+    unsigned int entries[3][4];
+    for (int l = 0; l < 4; ++l)
+      {
+      const bool activeLane = (lanes & (1u << (4*h + l))) != 0;
+      const unsigned int index = activeLane ? 3*packet->Value[4*h + l] : 0;
+      for (int c = 0; c < 3; ++c)
+        {
+        entries[c][l] = activeLane ? colorTable[index + c] : 0;
+        }
+      }
+    __m128i color[3];
+    for (int c = 0; c < 3; ++c)
+      {
+      color[c] = LowShort(Round(_mm_mullo_epi32(Load(entries[c]), opacity)));
+      }
+
+    if (diffuseShadingTable)
+      {
+      __m128i diffuse[3];
+      __m128i specular[3];
+      InterpolateShading(diffuseShadingTable, specularShadingTable, packet,
+                         lanes, h, diffuse, specular);
+      for (int c = 0; c < 3; ++c)
+        {
+        color[c] = LowShort(Round(_mm_mullo_epi32(diffuse[c], color[c])));
+        color[c] = LowShort(_mm_add_epi32(
+          color[c], Round(_mm_mullo_epi32(specular[c], opacity))));
+        }
+      }
+
+    const __m128i remainingOpacity = Load(packet->RemainingOpacity + 4*h);
+    for (int c = 0; c < 3; ++c)
+      {
+      StoreLanes(packet->Color[c] + 4*h, _mm_add_epi32(
+        Load(packet->Color[c] + 4*h), Round(_mm_mullo_epi32(color[c], remainingOpacity))),
+        active);
+      }
+    const __m128i transparency = _mm_andnot_si128(opacity, _mm_set1_epi32(VTKKW_FP_MASK));
+    const __m128i newRemainingOpacity =
+      LowShort(Round(_mm_mullo_epi32(remainingOpacity, transparency)));
+    StoreLanes(packet->RemainingOpacity + 4*h, newRemainingOpacity, active);
+    terminated |= BitMask(_mm_cmplt_epi32(newRemainingOpacity, _mm_set1_epi32(0xff)), h);
+    }
+  return lanes & terminated;
+}
+
+//----------------------------------------------------------------------------
+void SSE41UpdateMaximum(vtkSlicerFixedPointRayPacket* packet,
+                        unsigned int lanes)
+{
+  for (int h = 0; h < 2; ++h)
+    {
+    const __m128i maxValue = _mm_max_epu32(Load(packet->MaxValue + 4*h),
+                                           Load(packet->Value + 4*h));
+    StoreLanes(packet->MaxValue + 4*h, maxValue, LaneMask(lanes, h));
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketSSE41Kernels()
+{
+  static const vtkSlicerFixedPointRayPacketKernels kernels =
+    {
+    "SSE4.1",
+    SSE41Advance,
+    SSE41InterpolateScalar,
+    SSE41LookupScalarOpacity,
+    SSE41ApplyGradientOpacity,
+    SSE41Composite,
+    SSE41UpdateMaximum
+    };
+  return &kernels;
+}
+
+#else
+
+//----------------------------------------------------------------------------
+const vtkSlicerFixedPointRayPacketKernels* vtkSlicerFixedPointRayPacketSSE41Kernels()
+{
+  return 0;
+}
+
+#endif
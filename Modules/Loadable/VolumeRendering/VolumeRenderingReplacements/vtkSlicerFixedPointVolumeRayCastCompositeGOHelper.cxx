@@ -20,6 +20,7 @@
 #include "vtkImageData.h"
 #include "vtkCommand.h"
 #include "vtkSlicerFixedPointVolumeRayCastMapper.h"
+#include "vtkSlicerFixedPointRayPacketHelper.h"
 #include "vtkObjectFactory.h"
 #include "vtkRenderWindow.h"
 #include "vtkVolume.h"
@@ -839,8 +840,21 @@ void vtkSlicerFixedPointVolumeRayCastCompositeGOHelper::GenerateImage( int threa
     // One component
     if ( mapper->GetInput()->GetNumberOfScalarComponents() == 1 )
       {
+      // Rays cast in packets by the kernels of the mapper
+      if ( mapper->GetRayPacketKernels() )
+        {
+        int simple = ( mapper->GetTableScale()[0] == 1.0 &&
+                       mapper->GetTableShift()[0] == 0.0 );
+        switch ( scalarType )
+          {
+          vtkTemplateMacro(
+            vtkSlicerFixedPointRayPacketGenerateImageCompositeOneTrilin(
+              (VTK_TT *)(data),
+              threadID, threadCount, mapper, vol, simple, 1, 0) );
+          }
+        }
       // Scale == 1.0 and shift == 0.0 - simple case (faster)
-      if ( mapper->GetTableScale()[0] == 1.0 && mapper->GetTableShift()[0] == 0.0 )
+      else if ( mapper->GetTableScale()[0] == 1.0 && mapper->GetTableShift()[0] == 0.0 )
         {
         switch ( scalarType )
           {
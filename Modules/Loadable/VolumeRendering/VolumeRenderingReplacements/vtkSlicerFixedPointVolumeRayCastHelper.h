@@ -107,56 +107,65 @@
   w2Xw1Y = (0x4000+(w2X*w1Y))>>VTKKW_FP_SHIFT;                                          \
   w1Xw2Y = (0x4000+(w1X*w2Y))>>VTKKW_FP_SHIFT;                                          \
   w2Xw2Y = (0x4000+(w2X*w2Y))>>VTKKW_FP_SHIFT;                                          \
+                                                                                        \
+  wA = (0x4000+(w1Xw1Y*w1Z))>>VTKKW_FP_SHIFT;                                           \
+  wB = (0x4000+(w2Xw1Y*w1Z))>>VTKKW_FP_SHIFT;                                           \
+  wC = (0x4000+(w1Xw2Y*w1Z))>>VTKKW_FP_SHIFT;                                           \
+  wD = (0x4000+(w2Xw2Y*w1Z))>>VTKKW_FP_SHIFT;                                           \
+  wE = (0x4000+(w1Xw1Y*w2Z))>>VTKKW_FP_SHIFT;                                           \
+  wF = (0x4000+(w2Xw1Y*w2Z))>>VTKKW_FP_SHIFT;                                           \
+  wG = (0x4000+(w1Xw2Y*w2Z))>>VTKKW_FP_SHIFT;                                           \
+  wH = (0x4000+(w2Xw2Y*w2Z))>>VTKKW_FP_SHIFT;                                           \
 
 
 #define VTKKWRCHelper_InterpolateScalar( VAL )                                  \
   VAL =                                                                         \
-    (0x7fff + ((A*((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (B*((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (C*((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (D*((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (E*((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (F*((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (G*((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (H*((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;
+    (0x7fff + ((A*wA) +                                                         \
+               (B*wB) +                                                         \
+               (C*wC) +                                                         \
+               (D*wD) +                                                         \
+               (E*wE) +                                                         \
+               (F*wF) +                                                         \
+               (G*wG) +                                                         \
+               (H*wH))) >> VTKKW_FP_SHIFT;
 
 #define VTKKWRCHelper_InterpolateMagnitude( VAL )                                       \
   VAL =                                                                                 \
-    (0x7fff + ((mA*((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                           \
-               (mB*((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                           \
-               (mC*((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                           \
-               (mD*((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                           \
-               (mE*((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                           \
-               (mF*((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                           \
-               (mG*((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                           \
-               (mH*((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;
+    (0x7fff + ((mA*wA) +                                                                \
+               (mB*wB) +                                                                \
+               (mC*wC) +                                                                \
+               (mD*wD) +                                                                \
+               (mE*wE) +                                                                \
+               (mF*wF) +                                                                \
+               (mG*wG) +                                                                \
+               (mH*wH))) >> VTKKW_FP_SHIFT;
 
 #define VTKKWRCHelper_InterpolateScalarComponent( VAL, CIDX, COMPONENTS )               \
   for ( CIDX = 0; CIDX < COMPONENTS; CIDX++ )                                           \
     {                                                                                   \
     VAL[CIDX] =                                                                         \
-    (0x7fff + ((A[CIDX]*((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (B[CIDX]*((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (C[CIDX]*((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (D[CIDX]*((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (E[CIDX]*((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (F[CIDX]*((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (G[CIDX]*((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (H[CIDX]*((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;   \
+    (0x7fff + ((A[CIDX]*wA) +                                                           \
+               (B[CIDX]*wB) +                                                           \
+               (C[CIDX]*wC) +                                                           \
+               (D[CIDX]*wD) +                                                           \
+               (E[CIDX]*wE) +                                                           \
+               (F[CIDX]*wF) +                                                           \
+               (G[CIDX]*wG) +                                                           \
+               (H[CIDX]*wH))) >> VTKKW_FP_SHIFT;                                        \
     }                                                                                   \
 
 #define VTKKWRCHelper_InterpolateMagnitudeComponent( VAL, CIDX, COMPONENTS )            \
   for ( CIDX = 0; CIDX < COMPONENTS; CIDX++ )                                           \
     {                                                                                   \
     VAL[CIDX] =                                                                         \
-    (0x7fff + ((mA[CIDX]*((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                     \
-               (mB[CIDX]*((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                     \
-               (mC[CIDX]*((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                     \
-               (mD[CIDX]*((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                     \
-               (mE[CIDX]*((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                     \
-               (mF[CIDX]*((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                     \
-               (mG[CIDX]*((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                     \
-               (mH[CIDX]*((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;  \
+    (0x7fff + ((mA[CIDX]*wA) +                                                          \
+               (mB[CIDX]*wB) +                                                          \
+               (mC[CIDX]*wC) +                                                          \
+               (mD[CIDX]*wD) +                                                          \
+               (mE[CIDX]*wE) +                                                          \
+               (mF[CIDX]*wF) +                                                          \
+               (mG[CIDX]*wG) +                                                          \
+               (mH[CIDX]*wH))) >> VTKKW_FP_SHIFT;                                       \
     }
 
 #define VTKKWRCHelper_InterpolateShading( DTABLE, STABLE, COLOR )                                       \
@@ -164,64 +173,64 @@
   unsigned int _tmpSColor[3];                                                                           \
                                                                                                         \
   _tmpDColor[0] =                                                                                       \
-    (0x7fff + ((DTABLE[3*normalA] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (DTABLE[3*normalB] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (DTABLE[3*normalC] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (DTABLE[3*normalD] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (DTABLE[3*normalE] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                          \
-               (DTABLE[3*normalF] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                          \
-               (DTABLE[3*normalG] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                          \
-               (DTABLE[3*normalH] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;       \
+    (0x7fff + ((DTABLE[3*normalA] * wA) +                                                               \
+               (DTABLE[3*normalB] * wB) +                                                               \
+               (DTABLE[3*normalC] * wC) +                                                               \
+               (DTABLE[3*normalD] * wD) +                                                               \
+               (DTABLE[3*normalE] * wE) +                                                               \
+               (DTABLE[3*normalF] * wF) +                                                               \
+               (DTABLE[3*normalG] * wG) +                                                               \
+               (DTABLE[3*normalH] * wH))) >> VTKKW_FP_SHIFT;                                            \
                                                                                                         \
   _tmpDColor[1] =                                                                                       \
-    (0x7fff + ((DTABLE[3*normalA+1] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalB+1] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalC+1] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalD+1] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalE+1] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalF+1] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalG+1] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalH+1] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;     \
+    (0x7fff + ((DTABLE[3*normalA+1] * wA) +                                                             \
+               (DTABLE[3*normalB+1] * wB) +                                                             \
+               (DTABLE[3*normalC+1] * wC) +                                                             \
+               (DTABLE[3*normalD+1] * wD) +                                                             \
+               (DTABLE[3*normalE+1] * wE) +                                                             \
+               (DTABLE[3*normalF+1] * wF) +                                                             \
+               (DTABLE[3*normalG+1] * wG) +                                                             \
+               (DTABLE[3*normalH+1] * wH))) >> VTKKW_FP_SHIFT;                                          \
                                                                                                         \
   _tmpDColor[2] =                                                                                       \
-    (0x7fff + ((DTABLE[3*normalA+2] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalB+2] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalC+2] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalD+2] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalE+2] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalF+2] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalG+2] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (DTABLE[3*normalH+2] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;     \
+    (0x7fff + ((DTABLE[3*normalA+2] * wA) +                                                             \
+               (DTABLE[3*normalB+2] * wB) +                                                             \
+               (DTABLE[3*normalC+2] * wC) +                                                             \
+               (DTABLE[3*normalD+2] * wD) +                                                             \
+               (DTABLE[3*normalE+2] * wE) +                                                             \
+               (DTABLE[3*normalF+2] * wF) +                                                             \
+               (DTABLE[3*normalG+2] * wG) +                                                             \
+               (DTABLE[3*normalH+2] * wH))) >> VTKKW_FP_SHIFT;                                          \
                                                                                                         \
   _tmpSColor[0] =                                                                                       \
-    (0x7fff + ((STABLE[3*normalA] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (STABLE[3*normalB] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (STABLE[3*normalC] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (STABLE[3*normalD] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                          \
-               (STABLE[3*normalE] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                          \
-               (STABLE[3*normalF] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                          \
-               (STABLE[3*normalG] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                          \
-               (STABLE[3*normalH] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;       \
+    (0x7fff + ((STABLE[3*normalA] * wA) +                                                               \
+               (STABLE[3*normalB] * wB) +                                                               \
+               (STABLE[3*normalC] * wC) +                                                               \
+               (STABLE[3*normalD] * wD) +                                                               \
+               (STABLE[3*normalE] * wE) +                                                               \
+               (STABLE[3*normalF] * wF) +                                                               \
+               (STABLE[3*normalG] * wG) +                                                               \
+               (STABLE[3*normalH] * wH))) >> VTKKW_FP_SHIFT;                                            \
                                                                                                         \
   _tmpSColor[1] =                                                                                       \
-    (0x7fff + ((STABLE[3*normalA+1] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalB+1] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalC+1] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalD+1] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalE+1] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalF+1] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalG+1] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalH+1] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;     \
+    (0x7fff + ((STABLE[3*normalA+1] * wA) +                                                             \
+               (STABLE[3*normalB+1] * wB) +                                                             \
+               (STABLE[3*normalC+1] * wC) +                                                             \
+               (STABLE[3*normalD+1] * wD) +                                                             \
+               (STABLE[3*normalE+1] * wE) +                                                             \
+               (STABLE[3*normalF+1] * wF) +                                                             \
+               (STABLE[3*normalG+1] * wG) +                                                             \
+               (STABLE[3*normalH+1] * wH))) >> VTKKW_FP_SHIFT;                                          \
                                                                                                         \
   _tmpSColor[2] =                                                                                       \
-    (0x7fff + ((STABLE[3*normalA+2] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalB+2] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalC+2] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalD+2] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalE+2] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalF+2] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalG+2] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                        \
-               (STABLE[3*normalH+2] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;     \
+    (0x7fff + ((STABLE[3*normalA+2] * wA) +                                                             \
+               (STABLE[3*normalB+2] * wB) +                                                             \
+               (STABLE[3*normalC+2] * wC) +                                                             \
+               (STABLE[3*normalD+2] * wD) +                                                             \
+               (STABLE[3*normalE+2] * wE) +                                                             \
+               (STABLE[3*normalF+2] * wF) +                                                             \
+               (STABLE[3*normalG+2] * wG) +                                                             \
+               (STABLE[3*normalH+2] * wH))) >> VTKKW_FP_SHIFT;                                          \
                                                                                                         \
                                                                                                         \
   COLOR[0] = static_cast<unsigned short>((_tmpDColor[0]*COLOR[0]+0x7fff)>>VTKKW_FP_SHIFT);              \
@@ -237,64 +246,64 @@
   unsigned int _tmpSColor[3];                                                                                   \
                                                                                                                 \
   _tmpDColor[0] =                                                                                               \
-    (0x7fff + ((DTABLE[CIDX][3*normalA[CIDX]] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (DTABLE[CIDX][3*normalB[CIDX]] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (DTABLE[CIDX][3*normalC[CIDX]] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (DTABLE[CIDX][3*normalD[CIDX]] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (DTABLE[CIDX][3*normalE[CIDX]] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (DTABLE[CIDX][3*normalF[CIDX]] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (DTABLE[CIDX][3*normalG[CIDX]] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (DTABLE[CIDX][3*normalH[CIDX]] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;   \
+    (0x7fff + ((DTABLE[CIDX][3*normalA[CIDX]] * wA) +                                                           \
+               (DTABLE[CIDX][3*normalB[CIDX]] * wB) +                                                           \
+               (DTABLE[CIDX][3*normalC[CIDX]] * wC) +                                                           \
+               (DTABLE[CIDX][3*normalD[CIDX]] * wD) +                                                           \
+               (DTABLE[CIDX][3*normalE[CIDX]] * wE) +                                                           \
+               (DTABLE[CIDX][3*normalF[CIDX]] * wF) +                                                           \
+               (DTABLE[CIDX][3*normalG[CIDX]] * wG) +                                                           \
+               (DTABLE[CIDX][3*normalH[CIDX]] * wH))) >> VTKKW_FP_SHIFT;                                        \
                                                                                                                 \
   _tmpDColor[1] =                                                                                               \
-    (0x7fff + ((DTABLE[CIDX][3*normalA[CIDX]+1] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalB[CIDX]+1] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalC[CIDX]+1] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalD[CIDX]+1] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalE[CIDX]+1] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalF[CIDX]+1] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalG[CIDX]+1] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalH[CIDX]+1] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT; \
+    (0x7fff + ((DTABLE[CIDX][3*normalA[CIDX]+1] * wA) +                                                         \
+               (DTABLE[CIDX][3*normalB[CIDX]+1] * wB) +                                                         \
+               (DTABLE[CIDX][3*normalC[CIDX]+1] * wC) +                                                         \
+               (DTABLE[CIDX][3*normalD[CIDX]+1] * wD) +                                                         \
+               (DTABLE[CIDX][3*normalE[CIDX]+1] * wE) +                                                         \
+               (DTABLE[CIDX][3*normalF[CIDX]+1] * wF) +                                                         \
+               (DTABLE[CIDX][3*normalG[CIDX]+1] * wG) +                                                         \
+               (DTABLE[CIDX][3*normalH[CIDX]+1] * wH))) >> VTKKW_FP_SHIFT;                                      \
                                                                                                                 \
   _tmpDColor[2] =                                                                                               \
-    (0x7fff + ((DTABLE[CIDX][3*normalA[CIDX]+2] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalB[CIDX]+2] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalC[CIDX]+2] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalD[CIDX]+2] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalE[CIDX]+2] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalF[CIDX]+2] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalG[CIDX]+2] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (DTABLE[CIDX][3*normalH[CIDX]+2] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT; \
+    (0x7fff + ((DTABLE[CIDX][3*normalA[CIDX]+2] * wA) +                                                         \
+               (DTABLE[CIDX][3*normalB[CIDX]+2] * wB) +                                                         \
+               (DTABLE[CIDX][3*normalC[CIDX]+2] * wC) +                                                         \
+               (DTABLE[CIDX][3*normalD[CIDX]+2] * wD) +                                                         \
+               (DTABLE[CIDX][3*normalE[CIDX]+2] * wE) +                                                         \
+               (DTABLE[CIDX][3*normalF[CIDX]+2] * wF) +                                                         \
+               (DTABLE[CIDX][3*normalG[CIDX]+2] * wG) +                                                         \
+               (DTABLE[CIDX][3*normalH[CIDX]+2] * wH))) >> VTKKW_FP_SHIFT;                                      \
                                                                                                                 \
   _tmpSColor[0] =                                                                                               \
-    (0x7fff + ((STABLE[CIDX][3*normalA[CIDX]] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (STABLE[CIDX][3*normalB[CIDX]] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (STABLE[CIDX][3*normalC[CIDX]] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (STABLE[CIDX][3*normalD[CIDX]] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                      \
-               (STABLE[CIDX][3*normalE[CIDX]] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (STABLE[CIDX][3*normalF[CIDX]] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (STABLE[CIDX][3*normalG[CIDX]] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                      \
-               (STABLE[CIDX][3*normalH[CIDX]] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT;   \
+    (0x7fff + ((STABLE[CIDX][3*normalA[CIDX]] * wA) +                                                           \
+               (STABLE[CIDX][3*normalB[CIDX]] * wB) +                                                           \
+               (STABLE[CIDX][3*normalC[CIDX]] * wC) +                                                           \
+               (STABLE[CIDX][3*normalD[CIDX]] * wD) +                                                           \
+               (STABLE[CIDX][3*normalE[CIDX]] * wE) +                                                           \
+               (STABLE[CIDX][3*normalF[CIDX]] * wF) +                                                           \
+               (STABLE[CIDX][3*normalG[CIDX]] * wG) +                                                           \
+               (STABLE[CIDX][3*normalH[CIDX]] * wH))) >> VTKKW_FP_SHIFT;                                        \
                                                                                                                 \
   _tmpSColor[1] =                                                                                               \
-    (0x7fff + ((STABLE[CIDX][3*normalA[CIDX]+1] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalB[CIDX]+1] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalC[CIDX]+1] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalD[CIDX]+1] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalE[CIDX]+1] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalF[CIDX]+1] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalG[CIDX]+1] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalH[CIDX]+1] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT; \
+    (0x7fff + ((STABLE[CIDX][3*normalA[CIDX]+1] * wA) +                                                         \
+               (STABLE[CIDX][3*normalB[CIDX]+1] * wB) +                                                         \
+               (STABLE[CIDX][3*normalC[CIDX]+1] * wC) +                                                         \
+               (STABLE[CIDX][3*normalD[CIDX]+1] * wD) +                                                         \
+               (STABLE[CIDX][3*normalE[CIDX]+1] * wE) +                                                         \
+               (STABLE[CIDX][3*normalF[CIDX]+1] * wF) +                                                         \
+               (STABLE[CIDX][3*normalG[CIDX]+1] * wG) +                                                         \
+               (STABLE[CIDX][3*normalH[CIDX]+1] * wH))) >> VTKKW_FP_SHIFT;                                      \
                                                                                                                 \
   _tmpSColor[2] =                                                                                               \
-    (0x7fff + ((STABLE[CIDX][3*normalA[CIDX]+2] * ((0x4000 + w1Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalB[CIDX]+2] * ((0x4000 + w2Xw1Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalC[CIDX]+2] * ((0x4000 + w1Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalD[CIDX]+2] * ((0x4000 + w2Xw2Y*w1Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalE[CIDX]+2] * ((0x4000 + w1Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalF[CIDX]+2] * ((0x4000 + w2Xw1Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalG[CIDX]+2] * ((0x4000 + w1Xw2Y*w2Z)>>VTKKW_FP_SHIFT)) +                    \
-               (STABLE[CIDX][3*normalH[CIDX]+2] * ((0x4000 + w2Xw2Y*w2Z)>>VTKKW_FP_SHIFT)))) >> VTKKW_FP_SHIFT; \
+    (0x7fff + ((STABLE[CIDX][3*normalA[CIDX]+2] * wA) +                                                         \
+               (STABLE[CIDX][3*normalB[CIDX]+2] * wB) +                                                         \
+               (STABLE[CIDX][3*normalC[CIDX]+2] * wC) +                                                         \
+               (STABLE[CIDX][3*normalD[CIDX]+2] * wD) +                                                         \
+               (STABLE[CIDX][3*normalE[CIDX]+2] * wE) +                                                         \
+               (STABLE[CIDX][3*normalF[CIDX]+2] * wF) +                                                         \
+               (STABLE[CIDX][3*normalG[CIDX]+2] * wG) +                                                         \
+               (STABLE[CIDX][3*normalH[CIDX]+2] * wH))) >> VTKKW_FP_SHIFT;                                      \
                                                                                                                 \
                                                                                                                 \
   COLOR[0] = static_cast<unsigned short>((_tmpDColor[0]*COLOR[0]+0x7fff)>>VTKKW_FP_SHIFT);                      \
@@ -864,6 +873,7 @@
   unsigned int w1X, w1Y, w1Z;                           \
   unsigned int w2X, w2Y, w2Z;                           \
   unsigned int w1Xw1Y, w2Xw1Y, w1Xw2Y, w2Xw2Y;          \
+  unsigned int wA, wB, wC, wD, wE, wF, wG, wH;          \
                                                         \
   unsigned short  maxValue=0;                           \
   unsigned short  val;                                  \
@@ -879,6 +889,7 @@
   unsigned int w1X, w1Y, w1Z;                                   \
   unsigned int w2X, w2Y, w2Z;                                   \
   unsigned int w1Xw1Y, w2Xw1Y, w1Xw2Y, w2Xw2Y;                  \
+  unsigned int wA, wB, wC, wD, wE, wF, wG, wH;                  \
                                                                 \
   unsigned short  maxValue[4];                                  \
   unsigned short  val[4];                                       \
@@ -915,6 +926,7 @@
   unsigned int w1X, w1Y, w1Z;                           \
   unsigned int w2X, w2Y, w2Z;                           \
   unsigned int w1Xw1Y, w2Xw1Y, w1Xw2Y, w2Xw2Y;          \
+  unsigned int wA, wB, wC, wD, wE, wF, wG, wH;          \
                                                         \
   unsigned short  val;                                  \
   unsigned int    A=0,B=0,C=0,D=0,E=0,F=0,G=0,H=0;      \
@@ -943,6 +955,7 @@
   unsigned int w1X, w1Y, w1Z;                                   \
   unsigned int w2X, w2Y, w2Z;                                   \
   unsigned int w1Xw1Y, w2Xw1Y, w1Xw2Y, w2Xw2Y;                  \
+  unsigned int wA, wB, wC, wD, wE, wF, wG, wH;                  \
                                                                 \
   unsigned short  val[4]={0,0,0,0};                             \
   unsigned int A[4]={0,0,0,0};                                  \
@@ -17,6 +17,7 @@
 #include "vtkImageData.h"
 #include "vtkCommand.h"
 #include "vtkSlicerFixedPointVolumeRayCastMapper.h"
+#include "vtkSlicerFixedPointRayPacketHelper.h"
 #include "vtkObjectFactory.h"
 #include "vtkRenderWindow.h"
 #include "vtkVolume.h"
@@ -606,8 +607,21 @@ void vtkSlicerFixedPointVolumeRayCastMIPHelper::GenerateImage( int threadID,
     // One component
     if ( mapper->GetInput()->GetNumberOfScalarComponents() == 1 )
       {
+      // Rays cast in packets by the kernels of the mapper
+      if ( mapper->GetRayPacketKernels() )
+        {
+        int simple = ( mapper->GetTableScale()[0] == 1.0 &&
+                       mapper->GetTableShift()[0] == 0.0 );
+        switch ( scalarType )
+          {
+          vtkTemplateMacro(
+            vtkSlicerFixedPointRayPacketGenerateImageMIPOneTrilin(
+              (VTK_TT *)(dataPtr),
+              threadID, threadCount, mapper, vol, simple) );
+          }
+        }
       // Scale == 1.0 and shift == 0.0 - simple case (faster)
-      if ( mapper->GetTableScale()[0] == 1.0 && mapper->GetTableShift()[0] == 0.0 )
+      else if ( mapper->GetTableScale()[0] == 1.0 && mapper->GetTableShift()[0] == 0.0 )
         {
         switch ( scalarType )
           {
@@ -13,6 +13,7 @@ PURPOSE.  See the above copyright notice for more information.
 
 =========================================================================*/
 #include "vtkSlicerFixedPointVolumeRayCastMapper.h"
+#include "vtkSlicerFixedPointRayPacket.h"
 
 #include "vtkCamera.h"
 #include "vtkColorTransferFunction.h"
@@ -480,6 +481,9 @@ vtkSlicerFixedPointVolumeRayCastMapper::vtkSlicerFixedPointVolumeRayCastMapper()
     this->ShadingRequired              = 0;
     this->GradientOpacityRequired      = 0;
 
+    this->RayPacketInstructionSet      = AUTOMATIC_RAY_PACKETS;
+    this->RayPacketKernels             = NULL;
+
     this->CroppingRegionMask[0] = 1;
     for ( i = 1; i < 27; i++ )
     {
@@ -1229,6 +1233,47 @@ void vtkSlicerFixedPointVolumeRayCastMapper::PerVolumeInitialization( vtkRendere
     this->UpdateGradients( vol );
     this->UpdateShadingTable( ren, vol );
     this->UpdateMinMaxVolume( vol );
+
+    switch ( this->GetRayPacketInstructionSetInUse() )
+    {
+    case AVX2_RAY_PACKETS:
+        this->RayPacketKernels = vtkSlicerFixedPointRayPacketAVX2Kernels();
+        break;
+    case SSE41_RAY_PACKETS:
+        this->RayPacketKernels = vtkSlicerFixedPointRayPacketSSE41Kernels();
+        break;
+    case SCALAR_RAY_PACKETS:
+        this->RayPacketKernels = vtkSlicerFixedPointRayPacketScalarKernels();
+        break;
+    default:
+        this->RayPacketKernels = NULL;
+        break;
+    }
+}
+
+// Replace the instruction sets that are not built or not supported by the
+// processor by the fastest one that is. The scalar kernels are slower than
+// casting the rays one by one, they are only used when asked for.
+int vtkSlicerFixedPointVolumeRayCastMapper::GetRayPacketInstructionSetInUse()
+{
+    int instructionSet = this->RayPacketInstructionSet;
+    if ( instructionSet == AUTOMATIC_RAY_PACKETS )
+    {
+        instructionSet = AVX2_RAY_PACKETS;
+    }
+    if ( instructionSet == AVX2_RAY_PACKETS &&
+         ( !vtkSlicerFixedPointRayPacketAVX2Kernels() ||
+           !vtkSlicerFixedPointRayPacketHasAVX2() ) )
+    {
+        instructionSet = SSE41_RAY_PACKETS;
+    }
+    if ( instructionSet == SSE41_RAY_PACKETS &&
+         ( !vtkSlicerFixedPointRayPacketSSE41Kernels() ||
+           !vtkSlicerFixedPointRayPacketHasSSE41() ) )
+    {
+        instructionSet = NO_RAY_PACKETS;
+    }
+    return instructionSet;
 }
 
 // This is the initialization that should be done once per subvolume
@@ -3123,6 +3168,7 @@ void vtkSlicerFixedPointVolumeRayCastMapper::PrintSelf(ostream& os, vtkIndent in
     os << indent << "Intermix Intersecting Geometry: "
         << (this->IntermixIntersectingGeometry ? "On\n" : "Off\n");
 
+    os << indent << "RayPacketInstructionSet: " << this->RayPacketInstructionSet << endl;
     os << indent << "ShadingRequired: " << this->ShadingRequired << endl;
     os << indent << "GradientOpacityRequired: " << this->GradientOpacityRequired
         << endl;
@@ -80,6 +80,7 @@ class vtkSlicerFixedPointVolumeRayCastCompositeShadeHelper;
 class vtkDirectionEncoder;
 class vtkEncodedGradientShader;
 class vtkFiniteDifferenceGradientEstimator;
+struct vtkSlicerFixedPointRayPacketKernels;
 #include "vtkSlicerRayCastImageDisplayHelper.h"
 class vtkSlicerFixedPointRayCastImage;
 
@@ -158,6 +159,34 @@ public:
   void SetNumberOfThreads( int num );
   int GetNumberOfThreads();
 
+  // Description:
+  // Instruction sets of the ray packet kernels. NO_RAY_PACKETS casts the
+  // rays one by one, AUTOMATIC_RAY_PACKETS uses the fastest instruction set
+  // supported by the processor. SCALAR_RAY_PACKETS is slower than casting
+  // the rays one by one and is meant for testing.
+  enum
+  {
+    NO_RAY_PACKETS = 0,
+    SCALAR_RAY_PACKETS,
+    SSE41_RAY_PACKETS,
+    AVX2_RAY_PACKETS,
+    AUTOMATIC_RAY_PACKETS
+  };
+
+  // Description:
+  // Set/Get the instruction set used to cast the rays of one component
+  // volumes interpolated linearly in packets of adjacent rays. The image
+  // is the same whatever the instruction set. An SIMD instruction set that
+  // the processor does not support is replaced by the fastest supported
+  // one, or by NO_RAY_PACKETS.
+  // Default is AUTOMATIC_RAY_PACKETS.
+  vtkSetClampMacro( RayPacketInstructionSet, int, NO_RAY_PACKETS, AUTOMATIC_RAY_PACKETS );
+  vtkGetMacro( RayPacketInstructionSet, int );
+
+  // Description:
+  // Instruction set used for RayPacketInstructionSet on this processor.
+  int GetRayPacketInstructionSetInUse();
+
   // Description:
   // If IntermixIntersectingGeometry is turned on, the zbuffer will be
   // captured and used to limit the traversal of the rays.
@@ -232,6 +261,7 @@ public:
   unsigned char  **GetGradientMagnitude()         {return this->GradientMagnitude;}
   unsigned short  *GetDiffuseShadingTable(int c)  {return this->DiffuseShadingTable[c];}
   unsigned short  *GetSpecularShadingTable(int c) {return this->SpecularShadingTable[c];}
+  const vtkSlicerFixedPointRayPacketKernels *GetRayPacketKernels() {return this->RayPacketKernels;}
 
   void ComputeRayInfo( int x, int y,
                        unsigned int pos[3],
@@ -382,6 +412,10 @@ protected:
   int                        ShadingRequired;
   int                        GradientOpacityRequired;
 
+  int                        RayPacketInstructionSet;
+  // Kernels of RayPacketInstructionSet, NULL to cast the rays one by one
+  const vtkSlicerFixedPointRayPacketKernels *RayPacketKernels;
+
   vtkRenderWindow           *RenderWindow;
   vtkVolume                 *Volume;
 
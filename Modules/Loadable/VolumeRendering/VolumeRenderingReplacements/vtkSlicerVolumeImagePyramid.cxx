@@ -0,0 +1,233 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#include "vtkSlicerVolumeImagePyramid.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkVersion.h>
+
+// STD includes
+#include <algorithm>
+#include <limits>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerVolumeImagePyramid);
+
+//----------------------------------------------------------------------------
+template <class T>
+void vtkSlicerVolumeImagePyramidShrink(const T* inPtr, const int inDims[3],
+                                       T* outPtr, const int outDims[3],
+                                       int numberOfComponents)
+{
+  const vtkIdType inIncY = static_cast<vtkIdType>(inDims[0]) * numberOfComponents;
+  const vtkIdType inIncZ = inIncY * inDims[1];
+  // round the integer types to the nearest
+  const double rounding = std::numeric_limits<T>::is_integer ? 0.5 : 0.;
+  for (int k = 0; k < outDims[2]; ++k)
+    {
+    const vtkIdType z0 = std::min(2 * k, inDims[2] - 1) * inIncZ;
+    const vtkIdType z1 = std::min(2 * k + 1, inDims[2] - 1) * inIncZ;
+    for (int j = 0; j < outDims[1]; ++j)
+      {
+      const vtkIdType y0 = std::min(2 * j, inDims[1] - 1) * inIncY;
+      const vtkIdType y1 = std::min(2 * j + 1, inDims[1] - 1) * inIncY;
+      const T* p00 = inPtr + z0 + y0;
+      const T* p01 = inPtr + z0 + y1;
+      const T* p10 = inPtr + z1 + y0;
+      const T* p11 = inPtr + z1 + y1;
+      for (int i = 0; i < outDims[0]; ++i)
+        {
+        const vtkIdType x0 = static_cast<vtkIdType>(std::min(2 * i, inDims[0] - 1)) * numberOfComponents;
+        const vtkIdType x1 = static_cast<vtkIdType>(std::min(2 * i + 1, inDims[0] - 1)) * numberOfComponents;
+        for (int c = 0; c < numberOfComponents; ++c)
+          {
+          const double sum =
+            static_cast<double>(p00[x0 + c]) + p00[x1 + c] +
+            p01[x0 + c] + p01[x1 + c] +
+            p10[x0 + c] + p10[x1 + c] +
+            p11[x0 + c] + p11[x1 + c];
+          const double average = sum * 0.125;
+          *outPtr++ = static_cast<T>(
+            average >= 0. ? average + rounding : average - rounding);
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVolumeImagePyramid::vtkSlicerVolumeImagePyramid()
+{
+  this->Input = 0;
+  this->MinimumDimension = 32;
+  this->MaximumNumberOfLevels = 4;
+  this->NumberOfLevels = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerVolumeImagePyramid::~vtkSlicerVolumeImagePyramid()
+{
+  this->SetInput(0);
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumeImagePyramid::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Input: " << this->Input << "\n";
+  os << indent << "MinimumDimension: " << this->MinimumDimension << "\n";
+  os << indent << "MaximumNumberOfLevels: " << this->MaximumNumberOfLevels << "\n";
+  os << indent << "NumberOfLevels: " << this->NumberOfLevels << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumeImagePyramid::SetInput(vtkImageData* input)
+{
+  if (input == this->Input)
+    {
+    return;
+    }
+  if (this->Input)
+    {
+    this->Input->UnRegister(this);
+    }
+  this->Input = input;
+  if (this->Input)
+    {
+    this->Input->Register(this);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumeImagePyramid::Update()
+{
+  if (!this->Input)
+    {
+    this->Levels.clear();
+    this->NumberOfLevels = 0;
+    return;
+    }
+  if (this->NumberOfLevels > 0 &&
+      this->BuildTime > this->GetMTime() &&
+      this->BuildTime > this->Input->GetMTime())
+    {
+    return;
+    }
+
+  int level = 1;
+  vtkImageData* previous = this->Input;
+  for (; level < this->MaximumNumberOfLevels; ++level)
+    {
+    int dimensions[3];
+    previous->GetDimensions(dimensions);
+    int largestDimension = 0;
+    for (int i = 0; i < 3; ++i)
+      {
+      dimensions[i] = dimensions[i] > 1 ? (dimensions[i] + 1) / 2 : 1;
+      largestDimension = std::max(largestDimension, dimensions[i]);
+      }
+    if (largestDimension < this->MinimumDimension)
+      {
+      break;
+      }
+    if (static_cast<int>(this->Levels.size()) < level)
+      {
+      this->Levels.push_back(vtkSmartPointer<vtkImageData>::New());
+      }
+    vtkImageData* image = this->Levels[level - 1];
+    vtkSlicerVolumeImagePyramid::Shrink(previous, image);
+    previous = image;
+    }
+  this->Levels.resize(level - 1);
+  this->NumberOfLevels = level;
+  this->BuildTime.Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerVolumeImagePyramid::GetNumberOfLevels()
+{
+  return this->NumberOfLevels;
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkSlicerVolumeImagePyramid::GetLevel(int level)
+{
+  if (level == 0)
+    {
+    return this->Input;
+    }
+  if (level < 0 || level >= this->NumberOfLevels)
+    {
+    vtkErrorMacro("GetLevel: level " << level << " is not built");
+    return 0;
+    }
+  return this->Levels[level - 1];
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumeImagePyramid::Shrink(vtkImageData* input, vtkImageData* output)
+{
+  int inExtent[6];
+  input->GetExtent(inExtent);
+  int inDims[3];
+  input->GetDimensions(inDims);
+  double inSpacing[3];
+  input->GetSpacing(inSpacing);
+  double inOrigin[3];
+  input->GetOrigin(inOrigin);
+
+  int outDims[3];
+  double outSpacing[3];
+  double outOrigin[3];
+  for (int i = 0; i < 3; ++i)
+    {
+    const bool shrink = inDims[i] > 1;
+    outDims[i] = shrink ? (inDims[i] + 1) / 2 : 1;
+    outSpacing[i] = shrink ? 2. * inSpacing[i] : inSpacing[i];
+    // the output voxel is centered between the 2 input voxels it averages
+    outOrigin[i] = inOrigin[i] +
+      inSpacing[i] * (inExtent[2 * i] + (shrink ? 0.5 : 0.));
+    }
+
+  const int numberOfComponents = input->GetNumberOfScalarComponents();
+  output->SetExtent(0, outDims[0] - 1, 0, outDims[1] - 1, 0, outDims[2] - 1);
+  output->SetSpacing(outSpacing);
+  output->SetOrigin(outOrigin);
+#if (VTK_MAJOR_VERSION <= 5)
+  output->SetScalarType(input->GetScalarType());
+  output->SetNumberOfScalarComponents(numberOfComponents);
+  output->AllocateScalars();
+#else
+  output->AllocateScalars(input->GetScalarType(), numberOfComponents);
+#endif
+
+  switch (input->GetScalarType())
+    {
+    vtkTemplateMacro(vtkSlicerVolumeImagePyramidShrink(
+      static_cast<VTK_TT*>(input->GetScalarPointer()), inDims,
+      static_cast<VTK_TT*>(output->GetScalarPointer()), outDims,
+      numberOfComponents));
+    default:
+      vtkGenericWarningMacro("Shrink: unsupported scalar type "
+                             << input->GetScalarType());
+      return;
+    }
+  output->Modified();
+}
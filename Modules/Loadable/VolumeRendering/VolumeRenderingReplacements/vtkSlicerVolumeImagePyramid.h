@@ -0,0 +1,99 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+///  vtkSlicerVolumeImagePyramid - coarser copies of a volume for interactive
+/// rendering
+///
+/// Level 0 is the input image. Each following level averages 2x2x2 voxels of
+/// the previous one, its spacing is doubled and its origin is shifted so that
+/// it covers the same region in space. Axes with a single voxel are not
+/// shrunk.
+///
+/// The levels are built by Update() and rebuilt only when the input is
+/// modified. The level images are kept between updates so that the mappers
+/// rendering them can keep their own cached data (gradients, min-max
+/// volumes).
+
+#ifndef __vtkSlicerVolumeImagePyramid_h
+#define __vtkSlicerVolumeImagePyramid_h
+
+#include "VolumeRenderingReplacementsExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+class vtkImageData;
+
+/// \ingroup Slicer_QtModules_VolumeRendering
+class Q_SLICER_QTMODULES_VOLUMERENDERING_REPLACEMENTS_EXPORT vtkSlicerVolumeImagePyramid
+  : public vtkObject
+{
+public:
+  static vtkSlicerVolumeImagePyramid *New();
+  vtkTypeMacro(vtkSlicerVolumeImagePyramid,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  /// Full resolution image.
+  void SetInput(vtkImageData* input);
+  vtkGetObjectMacro(Input, vtkImageData);
+
+  /// No level is built with less voxels than MinimumDimension along its
+  /// largest axis. 32 by default.
+  vtkSetClampMacro(MinimumDimension, int, 1, VTK_INT_MAX);
+  vtkGetMacro(MinimumDimension, int);
+
+  /// Maximum number of levels, including the input. 4 by default.
+  vtkSetClampMacro(MaximumNumberOfLevels, int, 1, 16);
+  vtkGetMacro(MaximumNumberOfLevels, int);
+
+  /// Build the coarse levels if the input or the settings have been
+  /// modified since the last update.
+  void Update();
+
+  /// Number of levels built by the last Update(), including the input.
+  /// 0 if there is no input.
+  int GetNumberOfLevels();
+
+  /// Return the image of a level, the input for level 0.
+  vtkImageData* GetLevel(int level);
+
+protected:
+  vtkSlicerVolumeImagePyramid();
+  ~vtkSlicerVolumeImagePyramid();
+
+  /// Average 2x2x2 voxels of input into output.
+  static void Shrink(vtkImageData* input, vtkImageData* output);
+
+  vtkImageData* Input;
+  int MinimumDimension;
+  int MaximumNumberOfLevels;
+
+  /// Levels 1 and above.
+  std::vector<vtkSmartPointer<vtkImageData> > Levels;
+  int NumberOfLevels;
+  vtkTimeStamp BuildTime;
+
+private:
+  vtkSlicerVolumeImagePyramid(const vtkSlicerVolumeImagePyramid&);  /// Not implemented.
+  void operator=(const vtkSlicerVolumeImagePyramid&);  /// Not implemented.
+};
+
+#endif
@@ -296,47 +296,23 @@ class EditUtil(object):
 
 
 class UndoRedo(object):
-  """ Code to manage a list of undo/redo volumes
-  stored in a compressed format using the vtkImageStash
-  class to compress label maps in a thread
+  """ Code to manage a list of undo/redo checkpoints of label volumes.
+  Each label volume has a vtkImageBrickUndoStack that only stores
+  the compressed bricks of the image that changed between two checkpoints,
+  so the cost of a checkpoint doesn't depend on the volume size.
+  The stacks decide how many steps are kept (undoSize and their memory
+  budget), the lists only record in which order the volumes were edited.
   """
 
-  class checkPoint(object):
-    """Internal class to store one checkpoint
-    step consisting of the stashed data
-    and the volumeNode it corresponds to
-    """
-    def __init__(self,volumeNode):
-      self.volumeNode = volumeNode
-      self.stashImage = vtk.vtkImageData()
-      self.stash = slicer.vtkImageStash()
-      self.stashImage.DeepCopy( volumeNode.GetImageData() )
-      self.stash.SetStashImage( self.stashImage )
-      self.stash.ThreadedStash()
-
-    def restore(self):
-      """Unstash the volume but first check that the
-      stash operation is not still ongoing in the other thread.
-      TODO: the stash operation is determinisitic, so there's
-      no chance of a deadlock here, but it would still be better
-      to integrate the wait into the event queue to avoid locking
-      the interface.  In practice this would only happen if the user
-      clicks Undo while the thread is still executing, which is
-      unlikely.  And at worst this busy loop will consume two threads
-      (this one and the stashing one) for the time the stash takes to complete.
-      """
-      while self.stash.GetStashing():
-        pass
-      self.stash.Unstash()
-      self.volumeNode.GetImageData().DeepCopy( self.stashImage )
-      EditUtil().markVolumeNodeAsModified(self.volumeNode)
-
-
   def __init__(self,undoSize=100):
     self.enabled = True
     self.undoSize = undoSize
+    # volume node of each checkpoint
     self.undoList = []
     self.redoList = []
+    # undo stack of each volume node, by node ID
+    self.undoStacks = {}
+    self.sceneObserverTags = []
     self.stateChangedCallback = self.defaultStateChangedCallback
 
   def defaultStateChangedCallback(self):
@@ -353,54 +329,130 @@ class UndoRedo(object):
     """for managing undo/redo button state"""
     return self.enabled and self.redoList != []
 
-  def storeVolume(self,checkPointList,volumeNode):
+  def undoStack(self,volumeNode):
     """ Internal helper function
-    Save a stashed copy of the given volume node into
-    the passed list (could be undo or redo list)
+    Return the undo stack recording the image of the volume node.
+    The history is lost if the image data object is replaced.
     """
-    if not self.enabled or not volumeNode or not volumeNode.GetImageData():
+    stack = self.undoStacks.get(volumeNode.GetID())
+    if not stack:
+      stack = slicer.vtkImageBrickUndoStack()
+      self.undoStacks[volumeNode.GetID()] = stack
+      self.observeScene(True)
+    stack.SetMaximumNumberOfSteps(self.undoSize)
+    if stack.GetImage() is not volumeNode.GetImageData():
+      stack.SetImage(volumeNode.GetImageData())
+      self.updateLists()
+    return stack
+
+  def stepsList(self,volumeNodes,numberOfSteps):
+    """ Internal helper function
+    Keep for each volume node its most recent entries, as many as
+    numberOfSteps(stack) of its undo stack.
+    """
+    counts = {}
+    steps = []
+    for volumeNode in reversed(volumeNodes):
+      stack = self.undoStacks.get(volumeNode.GetID())
+      count = counts.get(volumeNode.GetID(), 0)
+      if stack and count < numberOfSteps(stack):
+        counts[volumeNode.GetID()] = count + 1
+        steps.append(volumeNode)
+    steps.reverse()
+    return steps
+
+  def updateLists(self):
+    """ Internal helper function
+    Drop the entries of the steps the undo stacks have discarded.
+    """
+    self.undoList = self.stepsList(self.undoList, lambda stack: stack.GetNumberOfUndoSteps())
+    self.redoList = self.stepsList(self.redoList, lambda stack: stack.GetNumberOfRedoSteps())
+
+  def observeScene(self,observe):
+    """ Internal helper function
+    The scene is observed while there are undo stacks, to forget
+    the history of the removed volume nodes.
+    """
+    if observe and not self.sceneObserverTags:
+      for event in (slicer.vtkMRMLScene.NodeRemovedEvent, slicer.vtkMRMLScene.EndCloseEvent):
+        self.sceneObserverTags.append(slicer.mrmlScene.AddObserver(event, self.onSceneNodeRemoved))
+    elif not observe:
+      for tag in self.sceneObserverTags:
+        slicer.mrmlScene.RemoveObserver(tag)
+      self.sceneObserverTags = []
+
+  def onSceneNodeRemoved(self,caller,event):
+    """Remove the undo stacks of the volume nodes that are not in the scene anymore"""
+    removedNodeIDs = [nodeID for nodeID in self.undoStacks.keys()
+                      if not slicer.mrmlScene.GetNodeByID(nodeID)]
+    if not removedNodeIDs:
       return
-    checkPointList.append( self.checkPoint(volumeNode) )
+    for nodeID in removedNodeIDs:
+      del self.undoStacks[nodeID]
+    self.updateLists()
+    if not self.undoStacks:
+      self.observeScene(False)
     self.stateChangedCallback()
-    if len(checkPointList) >= self.undoSize:
-      return( checkPointList[1:] )
-    else:
-      return( checkPointList )
 
   def saveState(self):
-    """Called by effects as they modify the label volume node
+    """Called by effects before they modify the label volume node
     """
-    # store current state onto undoList
-    self.undoList = self.storeVolume( self.undoList, EditUtil.getLabelVolume() )
+    volumeNode = EditUtil.getLabelVolume()
+    if not self.enabled or not volumeNode or not volumeNode.GetImageData():
+      return
+    self.undoStack(volumeNode).SaveState()
+    self.undoList.append(volumeNode)
     self.redoList = []
+    self.updateLists()
     self.stateChangedCallback()
 
+  def markModified(self,volumeNode,corners):
+    """Called by effects that know which voxels of the label volume
+    they modify: only the bricks within the bounding box of the IJK corners
+    are compared at the next checkpoint.
+    """
+    if not self.enabled or not volumeNode:
+      return
+    stack = self.undoStacks.get(volumeNode.GetID())
+    if not stack or stack.GetImage() is not volumeNode.GetImageData():
+      return
+    extent = []
+    for d in xrange(3):
+      extent += [min([c[d] for c in corners]), max([c[d] for c in corners])]
+    stack.AddModifiedExtent(extent)
+
+  def restore(self,volumeNode,undo):
+    """ Internal helper function
+    Undo or redo the last step of the volume node.
+    """
+    stack = self.undoStack(volumeNode)
+    if (stack.Undo() if undo else stack.Redo()):
+      EditUtil().markVolumeNodeAsModified(volumeNode)
+
   def undo(self):
     """Perform the operation when the user presses
     the undo button on the editor interface.
-    This pushes the current state onto the redoList and
-    removes a volume from the undoList.
+    This restores the volume of the last checkpoint
+    and moves the checkpoint onto the redoList.
     """
     if self.undoList == []:
       return
-    # store current state onto redoList
-    self.redoList = self.storeVolume( self.redoList, EditUtil.getLabelVolume() )
-    # get the checkPoint to restore and remove it from the list
-    self.undoList[-1].restore()
-    self.undoList = self.undoList[:-1]
+    volumeNode = self.undoList.pop()
+    self.restore(volumeNode, True)
+    self.redoList.append(volumeNode)
+    self.updateLists()
     self.stateChangedCallback()
 
   def redo(self):
     """Perform the operation when the user presses
-    the undo button on the editor interface.
-    This pushes the current state onto the undo stack
-    and restores the state from the redo stack
+    the redo button on the editor interface.
+    This restores the volume as it was before the last undo
+    and moves the checkpoint back onto the undoList.
     """
     if self.redoList == []:
       return
-    # store current state onto undoList
-    self.undoList = self.storeVolume( self.undoList, EditUtil.getLabelVolume() )
-    # get the checkPoint to restore and remove it from the list
-    self.redoList[-1].restore()
-    self.redoList = self.redoList[:-1]
+    volumeNode = self.redoList.pop()
+    self.restore(volumeNode, False)
+    self.undoList.append(volumeNode)
+    self.updateLists()
     self.stateChangedCallback()
@@ -449,6 +449,8 @@ class LabelEffectLogic(Effect.EffectLogic):
     self.painter.SetThresholdPaintRange( paintThresholdMin, paintThresholdMax )
 
     self.painter.Paint()
+    if self.undoRedo:
+      self.undoRedo.markModified(labelNode, (tl, tr, bl, br))
 
     EditUtil.markVolumeNodeAsModified(labelNode)
 
@@ -0,0 +1,648 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+#include "vtkImageBrickUndoStack.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkImageData.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+#include <vtkZLibDataCompressor.h>
+
+// STD includes
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+vtkStandardNewMacro(vtkImageBrickUndoStack);
+
+//----------------------------------------------------------------------------
+class vtkImageBrickUndoStack::vtkInternal
+{
+public:
+  /// Compressed content of a brick
+  struct BrickType
+  {
+    BrickType() : Hash(0) {}
+    vtkSmartPointer<vtkUnsignedCharArray> Data;
+    vtkTypeUInt64 Hash;
+  };
+  /// Bricks modified between two checkpoints
+  struct StepType
+  {
+    StepType() : MemorySize(0) {}
+    std::vector<vtkIdType> BrickIds;
+    std::vector<BrickType> Before;
+    std::vector<BrickType> After;
+    vtkIdType MemorySize;
+  };
+
+  vtkInternal(vtkImageBrickUndoStack* external);
+
+  /// Return true if the image still has the extent, scalar type and number
+  /// of components the bricks were computed for.
+  bool IsLayoutValid();
+  /// Split the image into bricks, compress them all and clear the steps.
+  void Reset();
+
+  void GetBrickExtent(vtkIdType brickId, int extent[6]);
+  /// Return the size in bytes of the brick and the location of its first
+  /// voxel in the image.
+  vtkIdType GetBrickLocation(vtkIdType brickId, int extent[6],
+                             unsigned char*& firstVoxel);
+  vtkTypeUInt64 HashBrick(vtkIdType brickId);
+  BrickType CompressBrick(vtkIdType brickId, vtkTypeUInt64 hash);
+  /// Return true if the brick of the image has the content of the last
+  /// checkpoint. The bytes are compared only if the hashes match, so that
+  /// a hash collision can't lose a modification.
+  bool IsBrickUnchanged(vtkIdType brickId, vtkTypeUInt64 hash);
+  void RestoreBrick(vtkIdType brickId, const BrickType& brick);
+
+  /// Compare the bricks of the image with the last checkpoint and record
+  /// the ones that changed.
+  StepType Commit();
+  /// Discard the oldest undo steps to honor MaximumNumberOfSteps and
+  /// MemoryBudget.
+  void Trim();
+  vtkIdType GetStepsMemorySize();
+
+  vtkImageBrickUndoStack* External;
+
+  int Extent[6];
+  int ScalarType;
+  int NumberOfComponents;
+  vtkIdType VoxelSize;
+  vtkIdType RowSize;
+  vtkIdType SliceSize;
+  int NumberOfBricks[3];
+
+  /// Compressed image at the last checkpoint
+  std::vector<BrickType> Bricks;
+  std::deque<StepType> UndoSteps;
+  std::deque<StepType> RedoSteps;
+  /// True after SaveState(), until the modifications are committed
+  bool CheckpointOpen;
+
+  /// Bricks to compare at the next commit if HasModifiedExtent
+  std::vector<char> ModifiedBricks;
+  bool HasModifiedExtent;
+
+  std::vector<unsigned char> Buffer;
+};
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// 64 bits FNV-1a on words, with a shift so that high bits are mixed too
+vtkTypeUInt64 HashBytes(const unsigned char* data, vtkIdType size, vtkTypeUInt64 hash)
+{
+  const vtkTypeUInt64 prime = (static_cast<vtkTypeUInt64>(1) << 40) + 0x1b3;
+  vtkIdType i = 0;
+  for (; i + 8 <= size; i += 8)
+    {
+    vtkTypeUInt64 word;
+    memcpy(&word, data + i, 8);
+    hash = (hash ^ word) * prime;
+    hash ^= hash >> 32;
+    }
+  for (; i < size; ++i)
+    {
+    hash = (hash ^ data[i]) * prime;
+    }
+  return hash;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkImageBrickUndoStack::vtkInternal::vtkInternal(vtkImageBrickUndoStack* external)
+{
+  this->External = external;
+  for (int i = 0; i < 6; ++i)
+    {
+    this->Extent[i] = 0;
+    }
+  this->ScalarType = VTK_VOID;
+  this->NumberOfComponents = 0;
+  this->VoxelSize = 0;
+  this->RowSize = 0;
+  this->SliceSize = 0;
+  this->NumberOfBricks[0] = this->NumberOfBricks[1] = this->NumberOfBricks[2] = 0;
+  this->CheckpointOpen = false;
+  this->HasModifiedExtent = false;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickUndoStack::vtkInternal::IsLayoutValid()
+{
+  vtkImageData* image = this->External->Image;
+  vtkDataArray* scalars = image ? image->GetPointData()->GetScalars() : 0;
+  if (!scalars || this->Bricks.empty())
+    {
+    return false;
+    }
+  int extent[6];
+  image->GetExtent(extent);
+  return std::equal(extent, extent + 6, this->Extent) &&
+         scalars->GetDataType() == this->ScalarType &&
+         scalars->GetNumberOfComponents() == this->NumberOfComponents &&
+         scalars->GetNumberOfTuples() == image->GetNumberOfPoints();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::vtkInternal::Reset()
+{
+  this->Bricks.clear();
+  this->UndoSteps.clear();
+  this->RedoSteps.clear();
+  this->ModifiedBricks.clear();
+  this->HasModifiedExtent = false;
+  this->CheckpointOpen = false;
+
+  vtkImageData* image = this->External->Image;
+  vtkDataArray* scalars = image ? image->GetPointData()->GetScalars() : 0;
+  if (!scalars || image->GetNumberOfPoints() == 0 ||
+      scalars->GetNumberOfTuples() != image->GetNumberOfPoints())
+    {
+    return;
+    }
+  image->GetExtent(this->Extent);
+  this->ScalarType = scalars->GetDataType();
+  this->NumberOfComponents = scalars->GetNumberOfComponents();
+  this->VoxelSize = this->NumberOfComponents * scalars->GetDataTypeSize();
+  this->RowSize = this->VoxelSize * (this->Extent[1] - this->Extent[0] + 1);
+  this->SliceSize = this->RowSize * (this->Extent[3] - this->Extent[2] + 1);
+  int brickSize = this->External->BrickSize;
+  vtkIdType numberOfBricks = 1;
+  for (int i = 0; i < 3; ++i)
+    {
+    int dimension = this->Extent[2 * i + 1] - this->Extent[2 * i] + 1;
+    this->NumberOfBricks[i] = (dimension + brickSize - 1) / brickSize;
+    numberOfBricks *= this->NumberOfBricks[i];
+    }
+  this->Buffer.resize(static_cast<size_t>(brickSize) * brickSize * brickSize * this->VoxelSize);
+  this->Bricks.resize(numberOfBricks);
+  this->ModifiedBricks.resize(numberOfBricks, 0);
+  for (vtkIdType brickId = 0; brickId < numberOfBricks; ++brickId)
+    {
+    this->Bricks[brickId] = this->CompressBrick(brickId, this->HashBrick(brickId));
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::vtkInternal::GetBrickExtent(vtkIdType brickId, int extent[6])
+{
+  int brickSize = this->External->BrickSize;
+  int index[3];
+  index[0] = static_cast<int>(brickId % this->NumberOfBricks[0]);
+  index[1] = static_cast<int>((brickId / this->NumberOfBricks[0]) % this->NumberOfBricks[1]);
+  index[2] = static_cast<int>(brickId / (this->NumberOfBricks[0] * this->NumberOfBricks[1]));
+  for (int i = 0; i < 3; ++i)
+    {
+    extent[2 * i] = this->Extent[2 * i] + index[i] * brickSize;
+    extent[2 * i + 1] = std::min(extent[2 * i] + brickSize - 1, this->Extent[2 * i + 1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageBrickUndoStack::vtkInternal::GetBrickLocation(
+  vtkIdType brickId, int extent[6], unsigned char*& firstVoxel)
+{
+  this->GetBrickExtent(brickId, extent);
+  unsigned char* origin = static_cast<unsigned char*>(
+    this->External->Image->GetPointData()->GetScalars()->GetVoidPointer(0));
+  firstVoxel = origin
+    + (extent[0] - this->Extent[0]) * this->VoxelSize
+    + (extent[2] - this->Extent[2]) * this->RowSize
+    + (extent[4] - this->Extent[4]) * this->SliceSize;
+  return this->VoxelSize * (extent[1] - extent[0] + 1)
+    * (extent[3] - extent[2] + 1) * (extent[5] - extent[4] + 1);
+}
+
+//----------------------------------------------------------------------------
+vtkTypeUInt64 vtkImageBrickUndoStack::vtkInternal::HashBrick(vtkIdType brickId)
+{
+  int extent[6];
+  unsigned char* firstVoxel = 0;
+  vtkIdType size = this->GetBrickLocation(brickId, extent, firstVoxel);
+  vtkIdType rowSize = (extent[1] - extent[0] + 1) * this->VoxelSize;
+  vtkTypeUInt64 hash = static_cast<vtkTypeUInt64>(size);
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    unsigned char* row = firstVoxel + (z - extent[4]) * this->SliceSize;
+    for (int y = extent[2]; y <= extent[3]; ++y, row += this->RowSize)
+      {
+      hash = HashBytes(row, rowSize, hash);
+      }
+    }
+  return hash;
+}
+
+//----------------------------------------------------------------------------
+vtkImageBrickUndoStack::vtkInternal::BrickType
+vtkImageBrickUndoStack::vtkInternal::CompressBrick(vtkIdType brickId, vtkTypeUInt64 hash)
+{
+  int extent[6];
+  unsigned char* firstVoxel = 0;
+  vtkIdType size = this->GetBrickLocation(brickId, extent, firstVoxel);
+  vtkIdType rowSize = (extent[1] - extent[0] + 1) * this->VoxelSize;
+  unsigned char* buffer = &this->Buffer[0];
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    unsigned char* row = firstVoxel + (z - extent[4]) * this->SliceSize;
+    for (int y = extent[2]; y <= extent[3]; ++y, row += this->RowSize)
+      {
+      memcpy(buffer, row, rowSize);
+      buffer += rowSize;
+      }
+    }
+  vtkZLibDataCompressor* compressor = this->External->Compressor;
+  compressor->SetCompressionLevel(this->External->CompressionLevel);
+  BrickType brick;
+  brick.Data.TakeReference(compressor->Compress(&this->Buffer[0], size));
+  // The compressor allocates the uncompressed size
+  brick.Data->Squeeze();
+  brick.Hash = hash;
+  return brick;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickUndoStack::vtkInternal::IsBrickUnchanged(vtkIdType brickId,
+                                                           vtkTypeUInt64 hash)
+{
+  const BrickType& brick = this->Bricks[brickId];
+  if (hash != brick.Hash)
+    {
+    return false;
+    }
+  int extent[6];
+  unsigned char* firstVoxel = 0;
+  vtkIdType size = this->GetBrickLocation(brickId, extent, firstVoxel);
+  vtkIdType rowSize = (extent[1] - extent[0] + 1) * this->VoxelSize;
+  if (this->External->Compressor->Uncompress(
+        brick.Data->GetPointer(0), brick.Data->GetNumberOfTuples(),
+        &this->Buffer[0], size) != static_cast<size_t>(size))
+    {
+    return false;
+    }
+  const unsigned char* buffer = &this->Buffer[0];
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    const unsigned char* row = firstVoxel + (z - extent[4]) * this->SliceSize;
+    for (int y = extent[2]; y <= extent[3]; ++y, row += this->RowSize)
+      {
+      if (memcmp(row, buffer, rowSize) != 0)
+        {
+        return false;
+        }
+      buffer += rowSize;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::vtkInternal::RestoreBrick(vtkIdType brickId,
+                                                       const BrickType& brick)
+{
+  int extent[6];
+  unsigned char* firstVoxel = 0;
+  vtkIdType size = this->GetBrickLocation(brickId, extent, firstVoxel);
+  vtkIdType rowSize = (extent[1] - extent[0] + 1) * this->VoxelSize;
+  this->External->Compressor->Uncompress(
+    brick.Data->GetPointer(0), brick.Data->GetNumberOfTuples(),
+    &this->Buffer[0], size);
+  const unsigned char* buffer = &this->Buffer[0];
+  for (int z = extent[4]; z <= extent[5]; ++z)
+    {
+    unsigned char* row = firstVoxel + (z - extent[4]) * this->SliceSize;
+    for (int y = extent[2]; y <= extent[3]; ++y, row += this->RowSize)
+      {
+      memcpy(row, buffer, rowSize);
+      buffer += rowSize;
+      }
+    }
+  this->Bricks[brickId] = brick;
+}
+
+//----------------------------------------------------------------------------
+vtkImageBrickUndoStack::vtkInternal::StepType
+vtkImageBrickUndoStack::vtkInternal::Commit()
+{
+  StepType step;
+  vtkIdType numberOfBricks = static_cast<vtkIdType>(this->Bricks.size());
+  for (vtkIdType brickId = 0; brickId < numberOfBricks; ++brickId)
+    {
+    if (this->HasModifiedExtent && !this->ModifiedBricks[brickId])
+      {
+      continue;
+      }
+    this->ModifiedBricks[brickId] = 0;
+    vtkTypeUInt64 hash = this->HashBrick(brickId);
+    if (this->IsBrickUnchanged(brickId, hash))
+      {
+      continue;
+      }
+    BrickType after = this->CompressBrick(brickId, hash);
+    step.BrickIds.push_back(brickId);
+    step.Before.push_back(this->Bricks[brickId]);
+    step.After.push_back(after);
+    step.MemorySize += this->Bricks[brickId].Data->GetNumberOfTuples()
+      + after.Data->GetNumberOfTuples();
+    this->Bricks[brickId] = after;
+    }
+  this->HasModifiedExtent = false;
+  return step;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageBrickUndoStack::vtkInternal::GetStepsMemorySize()
+{
+  vtkIdType size = 0;
+  std::deque<StepType>::const_iterator it;
+  for (it = this->UndoSteps.begin(); it != this->UndoSteps.end(); ++it)
+    {
+    size += it->MemorySize;
+    }
+  for (it = this->RedoSteps.begin(); it != this->RedoSteps.end(); ++it)
+    {
+    size += it->MemorySize;
+    }
+  return size;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::vtkInternal::Trim()
+{
+  while (static_cast<int>(this->UndoSteps.size()) > this->External->MaximumNumberOfSteps)
+    {
+    this->UndoSteps.pop_front();
+    }
+  if (this->External->MemoryBudget <= 0)
+    {
+    return;
+    }
+  vtkIdType size = this->GetStepsMemorySize();
+  while (size > this->External->MemoryBudget && this->UndoSteps.size() > 1)
+    {
+    size -= this->UndoSteps.front().MemorySize;
+    this->UndoSteps.pop_front();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkImageBrickUndoStack::vtkImageBrickUndoStack()
+{
+  this->Image = NULL;
+  this->Compressor = vtkZLibDataCompressor::New();
+  this->BrickSize = 32;
+  this->MaximumNumberOfSteps = 100;
+  this->MemoryBudget = 256 * 1024 * 1024;
+  this->CompressionLevel = 1; // corresponds to Z_BEST_SPEED
+  this->Internal = new vtkInternal(this);
+}
+
+//----------------------------------------------------------------------------
+vtkImageBrickUndoStack::~vtkImageBrickUndoStack()
+{
+  delete this->Internal;
+  if (this->Image)
+    {
+    this->Image->Delete();
+    }
+  if (this->Compressor)
+    {
+    this->Compressor->Delete();
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::SetImage(vtkImageData* image)
+{
+  if (image == this->Image)
+    {
+    return;
+    }
+  if (this->Image)
+    {
+    this->Image->UnRegister(this);
+    }
+  this->Image = image;
+  if (this->Image)
+    {
+    this->Image->Register(this);
+    }
+  this->Internal->Reset();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::SetBrickSize(int size)
+{
+  size = std::max(size, 1);
+  if (size == this->BrickSize)
+    {
+    return;
+    }
+  this->BrickSize = size;
+  this->Internal->Reset();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::SaveState()
+{
+  if (!this->Internal->IsLayoutValid())
+    {
+    // The image has been reallocated, its history is lost
+    this->Internal->Reset();
+    }
+  if (this->Internal->Bricks.empty())
+    {
+    return;
+    }
+  if (this->Internal->CheckpointOpen)
+    {
+    this->Internal->UndoSteps.push_back(this->Internal->Commit());
+    }
+  std::fill(this->Internal->ModifiedBricks.begin(),
+            this->Internal->ModifiedBricks.end(), 0);
+  this->Internal->HasModifiedExtent = false;
+  this->Internal->CheckpointOpen = true;
+  this->Internal->RedoSteps.clear();
+  this->Internal->Trim();
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::AddModifiedExtent(int x0, int x1, int y0, int y1, int z0, int z1)
+{
+  int extent[6] = {x0, x1, y0, y1, z0, z1};
+  this->AddModifiedExtent(extent);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::AddModifiedExtent(int extent[6])
+{
+  if (!this->Internal->IsLayoutValid())
+    {
+    return;
+    }
+  int range[6];
+  for (int i = 0; i < 3; ++i)
+    {
+    int first = std::max(std::min(extent[2 * i], extent[2 * i + 1]),
+                         this->Internal->Extent[2 * i]);
+    int last = std::min(std::max(extent[2 * i], extent[2 * i + 1]),
+                        this->Internal->Extent[2 * i + 1]);
+    if (first > last)
+      {
+      return;
+      }
+    range[2 * i] = (first - this->Internal->Extent[2 * i]) / this->BrickSize;
+    range[2 * i + 1] = (last - this->Internal->Extent[2 * i]) / this->BrickSize;
+    }
+  const int* numberOfBricks = this->Internal->NumberOfBricks;
+  for (int k = range[4]; k <= range[5]; ++k)
+    {
+    for (int j = range[2]; j <= range[3]; ++j)
+      {
+      for (int i = range[0]; i <= range[1]; ++i)
+        {
+        vtkIdType brickId = (static_cast<vtkIdType>(k) * numberOfBricks[1] + j)
+          * numberOfBricks[0] + i;
+        this->Internal->ModifiedBricks[brickId] = 1;
+        }
+      }
+    }
+  this->Internal->HasModifiedExtent = true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickUndoStack::Undo()
+{
+  if (!this->Internal->IsLayoutValid())
+    {
+    vtkErrorMacro("Undo: the image has been reallocated since the last checkpoint");
+    this->Internal->Reset();
+    return false;
+    }
+  if (this->Internal->CheckpointOpen)
+    {
+    this->Internal->UndoSteps.push_back(this->Internal->Commit());
+    this->Internal->CheckpointOpen = false;
+    }
+  if (this->Internal->UndoSteps.empty())
+    {
+    return false;
+    }
+  vtkInternal::StepType& step = this->Internal->UndoSteps.back();
+  for (size_t i = 0; i < step.BrickIds.size(); ++i)
+    {
+    this->Internal->RestoreBrick(step.BrickIds[i], step.Before[i]);
+    }
+  this->Internal->RedoSteps.push_back(step);
+  this->Internal->UndoSteps.pop_back();
+  this->Image->GetPointData()->GetScalars()->Modified();
+  this->Image->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkImageBrickUndoStack::Redo()
+{
+  if (!this->Internal->IsLayoutValid())
+    {
+    vtkErrorMacro("Redo: the image has been reallocated since the last checkpoint");
+    this->Internal->Reset();
+    return false;
+    }
+  if (this->Internal->RedoSteps.empty())
+    {
+    return false;
+    }
+  vtkInternal::StepType& step = this->Internal->RedoSteps.back();
+  for (size_t i = 0; i < step.BrickIds.size(); ++i)
+    {
+    this->Internal->RestoreBrick(step.BrickIds[i], step.After[i]);
+    }
+  this->Internal->UndoSteps.push_back(step);
+  this->Internal->RedoSteps.pop_back();
+  this->Image->GetPointData()->GetScalars()->Modified();
+  this->Image->Modified();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrickUndoStack::GetNumberOfUndoSteps()
+{
+  return static_cast<int>(this->Internal->UndoSteps.size())
+    + (this->Internal->CheckpointOpen ? 1 : 0);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageBrickUndoStack::GetNumberOfRedoSteps()
+{
+  return static_cast<int>(this->Internal->RedoSteps.size());
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::Clear()
+{
+  this->Internal->UndoSteps.clear();
+  this->Internal->RedoSteps.clear();
+  if (this->Internal->CheckpointOpen && this->Internal->IsLayoutValid())
+    {
+    // Take the modifications into account in the last checkpoint
+    this->Internal->Commit();
+    }
+  this->Internal->CheckpointOpen = false;
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageBrickUndoStack::GetStepsMemorySize()
+{
+  return this->Internal->GetStepsMemorySize();
+}
+
+//----------------------------------------------------------------------------
+vtkIdType vtkImageBrickUndoStack::GetImageMemorySize()
+{
+  vtkIdType size = 0;
+  for (size_t i = 0; i < this->Internal->Bricks.size(); ++i)
+    {
+    size += this->Internal->Bricks[i].Data->GetNumberOfTuples();
+    }
+  return size;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageBrickUndoStack::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+
+  os << indent << "Image: " << this->Image << "\n";
+  os << indent << "BrickSize: " << this->BrickSize << "\n";
+  os << indent << "MaximumNumberOfSteps: " << this->MaximumNumberOfSteps << "\n";
+  os << indent << "MemoryBudget: " << this->MemoryBudget << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "NumberOfUndoSteps: " << this->GetNumberOfUndoSteps() << "\n";
+  os << indent << "NumberOfRedoSteps: " << this->GetNumberOfRedoSteps() << "\n";
+  os << indent << "StepsMemorySize: " << this->GetStepsMemorySize() << "\n";
+  os << indent << "ImageMemorySize: " << this->GetImageMemorySize() << "\n";
+}
@@ -0,0 +1,133 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+///  vtkImageBrickUndoStack -
+///  Undo/redo history of an image that only stores the modified bricks
+///
+/// The image is split into bricks (BrickSize^3 voxels). Each checkpoint
+/// only keeps the zlib compressed bricks that changed since the previous
+/// one, so that saving, undoing and redoing an edit costs in proportion to
+/// the region it touched, not to the image size.
+///
+/// The image must be modified in place between checkpoints: call
+/// SaveState() before each modification. Effects that know the region they
+/// modify can call AddModifiedExtent() so that only its bricks are compared
+/// at the next checkpoint, otherwise all the bricks are compared.
+/// \sa vtkImageStash
+
+#ifndef __vtkImageBrickUndoStack_h
+#define __vtkImageBrickUndoStack_h
+
+#include "vtkSlicerEditorLibModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+class vtkImageData;
+class vtkZLibDataCompressor;
+
+class VTK_SLICER_EDITORLIB_MODULE_LOGIC_EXPORT vtkImageBrickUndoStack : public vtkObject
+{
+public:
+  static vtkImageBrickUndoStack *New();
+  vtkTypeMacro(vtkImageBrickUndoStack,vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent);
+
+  ///
+  /// The image whose history is recorded. Setting an image clears the
+  /// history and compresses all its bricks.
+  void SetImage(vtkImageData* image);
+  vtkGetObjectMacro(Image, vtkImageData);
+
+  ///
+  /// Number of voxels along each side of a brick.
+  /// Changing it clears the history. 32 by default.
+  void SetBrickSize(int size);
+  vtkGetMacro(BrickSize, int);
+
+  ///
+  /// Maximum number of undo steps, the oldest are discarded first.
+  /// 100 by default.
+  vtkSetClampMacro(MaximumNumberOfSteps, int, 1, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfSteps, int);
+
+  ///
+  /// Maximum memory (in bytes) used by the undo and redo steps, 0 for no
+  /// limit. The oldest undo steps are discarded first, the last one is
+  /// always kept. 256MB by default.
+  vtkSetMacro(MemoryBudget, vtkIdType);
+  vtkGetMacro(MemoryBudget, vtkIdType);
+
+  ///
+  /// Get/Set the compression level of the bricks.
+  vtkSetClampMacro(CompressionLevel, int, 0, 9);
+  vtkGetMacro(CompressionLevel, int);
+
+  ///
+  /// Record a checkpoint before the image is modified.
+  /// It clears the redo steps.
+  void SaveState();
+
+  ///
+  /// Restrict the bricks compared at the next checkpoint to the ones that
+  /// intersect \a extent (in voxels). Can be called several times.
+  void AddModifiedExtent(int extent[6]);
+  void AddModifiedExtent(int x0, int x1, int y0, int y1, int z0, int z1);
+
+  ///
+  /// Restore the image as it was at the last checkpoint.
+  /// Return false if there is nothing to undo.
+  bool Undo();
+
+  ///
+  /// Restore the image as it was before the last Undo().
+  /// Return false if there is nothing to redo.
+  bool Redo();
+
+  int GetNumberOfUndoSteps();
+  int GetNumberOfRedoSteps();
+
+  ///
+  /// Remove all the steps.
+  void Clear();
+
+  ///
+  /// Memory (in bytes) used by the undo and redo steps. Bricks shared by
+  /// two consecutive steps are counted twice.
+  vtkIdType GetStepsMemorySize();
+
+  ///
+  /// Memory (in bytes) used by the compressed copy of the current image.
+  vtkIdType GetImageMemorySize();
+
+protected:
+  vtkImageBrickUndoStack();
+  ~vtkImageBrickUndoStack();
+
+  vtkImageData *Image;
+  vtkZLibDataCompressor *Compressor;
+  int BrickSize;
+  int MaximumNumberOfSteps;
+  vtkIdType MemoryBudget;
+  int CompressionLevel;
+
+private:
+  class vtkInternal;
+  friend class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkImageBrickUndoStack(const vtkImageBrickUndoStack&);  /// Not implemented.
+  void operator=(const vtkImageBrickUndoStack&);  /// Not implemented.
+};
+
+#endif
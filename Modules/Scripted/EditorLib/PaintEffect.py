@@ -558,6 +558,8 @@ class PaintEffectTool(LabelEffect.LabelEffectTool):
     parameterNode = EditUtil.getParameterNode()
     paintLabel = int(parameterNode.GetParameter("label"))
     labelImage.SetScalarComponentFromFloat(ijk[0],ijk[1],ijk[2],0, paintLabel)
+    if self.undoRedo:
+      self.undoRedo.markModified(labelNode, (ijk,))
     EditUtil.markVolumeNodeAsModified(labelNode)
 
   def paintBrush(self, x, y):
@@ -776,6 +778,7 @@ class PaintEffectTool(LabelEffect.LabelEffectTool):
 
 
             self.painter.Paint()
+            self.markPainterModified(labelNode)
 
 
     # paint the slice: same for circular and spherical brush modes
@@ -786,6 +789,14 @@ class PaintEffectTool(LabelEffect.LabelEffectTool):
     self.painter.SetBrushCenter( brushCenter[0], brushCenter[1], brushCenter[2] )
     self.painter.SetBrushRadius( brushRadius )
     self.painter.Paint()
+    self.markPainterModified(labelNode)
+
+  def markPainterModified(self, labelNode):
+    """tell the undo stack which voxels the last Paint() call may have modified"""
+    if self.undoRedo:
+      corners = (self.painter.GetTopLeft(), self.painter.GetTopRight(),
+                 self.painter.GetBottomLeft(), self.painter.GetBottomRight())
+      self.undoRedo.markModified(labelNode, corners)
 
 
 #
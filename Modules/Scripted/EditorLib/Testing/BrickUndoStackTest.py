@@ -0,0 +1,134 @@
+import unittest
+import time
+import vtk
+import slicer
+
+class BrickUndoStack(unittest.TestCase):
+  def setUp(self):
+    pass
+
+  def runTest(self):
+    self.test_UndoRedo()
+    self.test_UndoRedoLists()
+    self.test_Performance()
+
+  def createImage(self, dimensions):
+    image = vtk.vtkImageData()
+    image.SetDimensions(dimensions)
+    if vtk.VTK_MAJOR_VERSION <= 5:
+      image.SetScalarTypeToShort()
+      image.SetNumberOfScalarComponents(1)
+      image.AllocateScalars()
+    else:
+      image.AllocateScalars(vtk.VTK_SHORT, 1)
+    image.GetPointData().GetScalars().Fill(0)
+    return image
+
+  def paint(self, image, extent, label):
+    for k in xrange(extent[4], extent[5] + 1):
+      for j in xrange(extent[2], extent[3] + 1):
+        for i in xrange(extent[0], extent[1] + 1):
+          image.SetScalarComponentFromFloat(i, j, k, 0, label)
+
+  def assertLabels(self, image, expectedLabels):
+    for ijk, label in expectedLabels:
+      self.assertEqual(image.GetScalarComponentAsDouble(ijk[0], ijk[1], ijk[2], 0), label)
+
+  def test_UndoRedo(self):
+    """Undo and redo edits that are within a brick, across bricks,
+    with and without modified extents"""
+    image = self.createImage((70, 50, 40))
+    stack = slicer.vtkImageBrickUndoStack()
+    stack.SetImage(image)
+    self.assertFalse(stack.Undo())
+
+    # precise modified extent
+    stack.SaveState()
+    box1 = (10, 40, 10, 20, 5, 8)
+    self.paint(image, box1, 1)
+    stack.AddModifiedExtent(box1)
+    # no modified extent: all the bricks are compared
+    stack.SaveState()
+    box2 = (60, 69, 40, 49, 35, 39)
+    self.paint(image, box2, 2)
+    # checkpoint without modification
+    stack.SaveState()
+    self.assertEqual(stack.GetNumberOfUndoSteps(), 3)
+
+    inBox1 = ((10, 10, 5), 1)
+    inBox2 = ((69, 49, 39), 2)
+    empty1 = ((10, 10, 5), 0)
+    empty2 = ((69, 49, 39), 0)
+
+    self.assertTrue(stack.Undo())
+    self.assertLabels(image, (inBox1, inBox2))
+    self.assertTrue(stack.Undo())
+    self.assertLabels(image, (inBox1, empty2))
+    self.assertTrue(stack.Undo())
+    self.assertLabels(image, (empty1, empty2))
+    self.assertFalse(stack.Undo())
+
+    self.assertEqual(stack.GetNumberOfRedoSteps(), 3)
+    self.assertTrue(stack.Redo())
+    self.assertTrue(stack.Redo())
+    self.assertLabels(image, (inBox1, inBox2))
+
+    # a new checkpoint clears the redo steps
+    stack.SaveState()
+    self.assertEqual(stack.GetNumberOfRedoSteps(), 0)
+    self.assertFalse(stack.Redo())
+
+    # only the modified bricks are stored
+    self.assertTrue(stack.GetStepsMemorySize() < 70 * 50 * 40 * 2 / 10)
+
+  def test_UndoRedoLists(self):
+    """The Editor checkpoints follow the steps kept by the undo stacks,
+    and are forgotten when their volume is removed"""
+    from EditorLib.EditUtil import EditUtil, UndoRedo
+    labelNode = slicer.vtkMRMLLabelMapVolumeNode()
+    labelNode.SetAndObserveImageData(self.createImage((40, 40, 40)))
+    slicer.mrmlScene.AddNode(labelNode)
+    EditUtil.getCompositeNode().SetLabelVolumeID(labelNode.GetID())
+
+    undoRedo = UndoRedo()
+    stack = undoRedo.undoStack(labelNode)
+    # only the last step fits in the memory budget
+    stack.SetMemoryBudget(1)
+    for label in xrange(1, 5):
+      undoRedo.saveState()
+      self.paint(labelNode.GetImageData(), (0, 39, 0, 39, label, label), label)
+    undoRedo.saveState()
+    self.assertTrue(stack.GetNumberOfUndoSteps() < 5)
+    self.assertEqual(len(undoRedo.undoList), stack.GetNumberOfUndoSteps())
+
+    undoRedo.undo()
+    self.assertEqual(len(undoRedo.undoList), stack.GetNumberOfUndoSteps())
+    self.assertEqual(len(undoRedo.redoList), stack.GetNumberOfRedoSteps())
+    self.assertTrue(undoRedo.redoEnabled())
+
+    slicer.mrmlScene.RemoveNode(labelNode)
+    self.assertEqual(undoRedo.undoStacks, {})
+    self.assertFalse(undoRedo.undoEnabled())
+    self.assertFalse(undoRedo.redoEnabled())
+    self.assertEqual(undoRedo.sceneObserverTags, [])
+
+  def test_Performance(self):
+    """Undo latency of a small edit must not depend on the image size"""
+    for size in (64, 256):
+      image = self.createImage((size, size, size))
+      stack = slicer.vtkImageBrickUndoStack()
+      stack.SetImage(image)
+      box = (10, 20, 10, 20, 10, 12)
+
+      start = time.time()
+      for i in xrange(10):
+        stack.SaveState()
+        self.paint(image, box, i + 1)
+        stack.AddModifiedExtent(box)
+        stack.Undo()
+        stack.Redo()
+      stack.SaveState()
+      elapsed = time.time() - start
+      print('<DartMeasurement name="SaveUndoRedo%d" type="numeric/double">%g</DartMeasurement>' % (size, elapsed))
+      self.assertEqual(image.GetScalarComponentAsDouble(10, 10, 10, 0), 10)
+      print('<DartMeasurement name="StepsMemorySize%d" type="numeric/double">%d</DartMeasurement>' % (size, stack.GetStepsMemorySize()))